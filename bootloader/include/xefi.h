@@ -35,6 +35,11 @@ void* xefi_load_file(char16_t* filename, size_t* size_out, size_t front_bytes);
 
 efi_status xefi_find_pci_mmio(efi_boot_services* bs, uint8_t cls, uint8_t sub, uint8_t ifc, uint64_t* mmio);
 
+// Wall-clock milliseconds derived from the EFI RTC, for measuring load
+// times.  Returns 0 if the RTC is unavailable; wraps at month
+// boundaries, so treat implausible deltas as unknown.
+uint64_t xefi_rtc_ms(void);
+
 // GUIDs
 extern efi_guid SimpleFileSystemProtocol;
 extern efi_guid FileInfoGUID;
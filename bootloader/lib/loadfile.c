@@ -6,6 +6,7 @@
 #include <efi/protocol/simple-file-system.h>
 
 #include <xefi.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 #ifndef VERBOSE
@@ -14,6 +15,8 @@
 #define xprintf(fmt...) printf(fmt)
 #endif
 
+#define READ_CHUNK_SIZE (1024 * 1024)
+
 efi_file_protocol* xefi_open_file(char16_t* filename) {
     efi_loaded_image_protocol* loaded;
     efi_status r;
@@ -82,19 +85,56 @@ void* xefi_read_file(efi_file_protocol* file, size_t* _sz, size_t front_bytes) {
         return NULL;
     }
 
-    sz = finfo->FileSize;
-    r = file->Read(file, &sz, data + front_bytes);
-    if (r) {
-        xprintf("LoadFile: Error reading file (%s)\n", xefi_strerror(r));
-        gBS->FreePages((efi_physical_addr)data, pages);
-        return NULL;
+    // Read large files in chunks so progress and overall throughput can
+    // be reported; a single Read call gives no feedback until it
+    // completes. Small files take the quiet single-read path.
+    uint64_t start_ms = xefi_rtc_ms();
+    size_t file_size = finfo->FileSize;
+    bool show_progress = file_size > READ_CHUNK_SIZE;
+    size_t offset = 0;
+    size_t next_pct = 10;
+    while (offset < file_size) {
+        sz = file_size - offset;
+        if (sz > READ_CHUNK_SIZE) {
+            sz = READ_CHUNK_SIZE;
+        }
+        size_t want = sz;
+        r = file->Read(file, &sz, data + front_bytes + offset);
+        if (r) {
+            xprintf("LoadFile: Error reading file (%s)\n", xefi_strerror(r));
+            gBS->FreePages((efi_physical_addr)data, pages);
+            return NULL;
+        }
+        if (sz != want) {
+            xprintf("LoadFile: Short read\n");
+            gBS->FreePages((efi_physical_addr)data, pages);
+            return NULL;
+        }
+        offset += sz;
+        if (show_progress) {
+            while ((offset * 100) / file_size >= next_pct) {
+                printf("%zu%%... ", next_pct);
+                next_pct += 10;
+            }
+        }
     }
-    if (sz != finfo->FileSize) {
-        xprintf("LoadFile: Short read\n");
-        gBS->FreePages((efi_physical_addr)data, pages);
-        return NULL;
+    if (show_progress) {
+        uint64_t elapsed_ms = xefi_rtc_ms() - start_ms;
+        if (elapsed_ms > 0 && elapsed_ms < 24ULL * 3600 * 1000) {
+            // bytes per ms == kB/s; scale by ten for one decimal place
+            uint64_t mbps_x10 = (uint64_t)file_size / (100 * elapsed_ms);
+            uint64_t secs_x10 = elapsed_ms / 100;
+            printf("%zu KB in %llu.%llus (%llu.%llu MB/s)\n",
+                   file_size / 1024,
+                   (unsigned long long)(secs_x10 / 10),
+                   (unsigned long long)(secs_x10 % 10),
+                   (unsigned long long)(mbps_x10 / 10),
+                   (unsigned long long)(mbps_x10 % 10));
+        } else {
+            printf("%zu KB\n", file_size / 1024);
+        }
     }
-    *_sz = finfo->FileSize;
+    *_sz = file_size;
 
     return data + front_bytes;
 }
@@ -181,3 +181,12 @@ size_t strlen_16(char16_t* str) {
 
     return len;
 }
+
+uint64_t xefi_rtc_ms(void) {
+    efi_time t;
+    if (gSys->RuntimeServices->GetTime(&t, NULL) != EFI_SUCCESS) {
+        return 0;
+    }
+    uint64_t s = (((uint64_t)t.Day * 24 + t.Hour) * 60 + t.Minute) * 60 + t.Second;
+    return s * 1000 + t.Nanosecond / 1000000;
+}
@@ -232,6 +232,26 @@ fail:
 
 static char cmdline[CMDLINE_MAX];
 
+int boot_kernel_check(void* image, size_t sz) {
+    if (sz < sizeof(bootdata_t)) {
+        printf("boot: kernel image too small\n");
+        return -1;
+    }
+    bootdata_t* bd = image;
+    if ((bd->type == BOOTDATA_CONTAINER) &&
+        (bd->extra == BOOTDATA_MAGIC) &&
+        (bd->flags == 0)) {
+        magenta_kernel_t* kernel = image;
+        if ((sz < sizeof(magenta_kernel_t)) ||
+            (kernel->hdr_kernel.type != BOOTDATA_KERNEL)) {
+            printf("boot: invalid magenta kernel header\n");
+            return -1;
+        }
+    }
+    // deprecated images are validated during load
+    return 0;
+}
+
 int boot_kernel(efi_handle img, efi_system_table* sys,
                 void* image, size_t sz,
                 void* ramdisk, size_t rsz) {
@@ -8,6 +8,7 @@
 #include <device_id.h>
 #include <inet6.h>
 #include <netifc.h>
+#include <xefi.h>
 
 #include <magenta/boot/netboot.h>
 #include <tftp/tftp.h>
@@ -24,6 +25,7 @@ typedef struct {
     nbfile* netboot_file_data;
     size_t file_size;
     unsigned int progress_reported;
+    uint64_t start_ms;
 } file_info_t;
 
 // TFTP transport state
@@ -185,6 +187,7 @@ static tftp_status buffer_open(const char* filename, size_t size, void* cookie)
     printf("Receiving %s [%lu bytes]... ", filename, (unsigned long)size);
     file_info->file_size = size;
     file_info->progress_reported = 0;
+    file_info->start_ms = xefi_rtc_ms();
     return TFTP_NO_ERROR;
 }
 
@@ -209,7 +212,19 @@ static tftp_status buffer_write(const void* data, size_t* len, off_t offset, voi
 static void buffer_close(void* cookie) {
     file_info_t* file_info = cookie;
     file_info->netboot_file_data = NULL;
-    printf("Done\n");
+    uint64_t elapsed_ms = xefi_rtc_ms() - file_info->start_ms;
+    if (elapsed_ms > 0 && elapsed_ms < 24ULL * 3600 * 1000) {
+        // bytes per ms == kB/s; scale by ten for one decimal place
+        uint64_t mbps_x10 = (uint64_t)file_info->file_size / (100 * elapsed_ms);
+        uint64_t secs_x10 = elapsed_ms / 100;
+        printf("Done (%llu.%llus, %llu.%llu MB/s)\n",
+               (unsigned long long)(secs_x10 / 10),
+               (unsigned long long)(secs_x10 % 10),
+               (unsigned long long)(mbps_x10 / 10),
+               (unsigned long long)(mbps_x10 % 10));
+    } else {
+        printf("Done\n");
+    }
 }
 
 static int udp_send(void* data, size_t len, void* cookie) {
@@ -441,6 +441,11 @@ EFIAPI efi_status efi_main(efi_handle img, efi_system_table* sys) {
             do_netboot();
             break;
         case 'm': {
+            // Reject a bad kernel image before spending time loading
+            // the much larger ramdisk.
+            if (boot_kernel_check(kernel, ksz)) {
+                break;
+            }
             size_t rsz = 0;
             void* ramdisk = NULL;
             efi_file_protocol* ramdisk_file = xefi_open_file(L"bootdata.bin");
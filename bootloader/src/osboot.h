@@ -26,6 +26,11 @@ int boot_kernel(efi_handle img, efi_system_table* sys,
                 void* image, size_t sz,
                 void* ramdisk, size_t rsz);
 
+// Sanity-check a kernel image's headers without booting it, so a bad
+// image can be rejected before time is spent loading the (much larger)
+// ramdisk.
+int boot_kernel_check(void* image, size_t sz);
+
 uint64_t find_acpi_root(efi_handle img, efi_system_table* sys);
 
 uint32_t get_mx_pixel_format(efi_graphics_output_protocol* gop);
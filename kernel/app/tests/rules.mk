@@ -22,6 +22,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/thread_tests.c \
     $(LOCAL_DIR)/alloc_checker_tests.cpp \
     $(LOCAL_DIR)/timer_tests.c \
+    $(LOCAL_DIR)/usercopy_bench.cpp \
 
 
 MODULE_DEPS += \
@@ -36,6 +36,43 @@ static void counter_task(void *raw_context) {
     atomic_add(counter, 1);
 }
 
+static void vec_test(uint num_cpus) {
+    /* one entry targeting the even cpus, one targeting all of them,
+     * executed in a single IPI round */
+    int even_counter = 0;
+    int all_counter = 0;
+
+    mp_cpu_mask_t all_mask = (mp_cpu_mask_t)((1U << num_cpus) - 1);
+    mp_cpu_mask_t even_mask = all_mask & 0x55555555U;
+
+    mp_sync_vec_t vec[] = {
+        { .target = even_mask, .task = counter_task, .context = &even_counter },
+        { .target = all_mask, .task = counter_task, .context = &all_counter },
+    };
+    mp_sync_exec_vec(vec, countof(vec));
+
+    ASSERT((uint)all_counter == num_cpus);
+    ASSERT((uint)even_counter == (num_cpus + 1) / 2);
+}
+
+static void async_completion_task(void *raw_context) {
+    event_t *done = raw_context;
+    event_signal(done, false);
+}
+
+static void async_test(uint num_cpus) {
+    int counter = 0;
+    event_t done = EVENT_INITIAL_VALUE(done, false, 0);
+
+    status_t status = mp_async_exec(MP_CPU_ALL, counter_task, &counter,
+                                    async_completion_task, &done);
+    ASSERT(status == MX_OK);
+
+    event_wait(&done);
+    ASSERT((uint)counter == num_cpus);
+    event_destroy(&done);
+}
+
 static int deadlock_test_thread(void *arg) {
     event_t *gate = arg;
     event_wait(gate);
@@ -113,6 +150,18 @@ int sync_ipi_tests(int argc, const cmd_args *argv)
         ASSERT((uint)counter == num_cpus - 1);
     }
 
+    /* Test that a vector of targeted tasks runs each entry on its cpus */
+    for (uint i = 0; i < runs; ++i) {
+        LTRACEF("Vector test\n");
+        vec_test(num_cpus);
+    }
+
+    /* Test the async variant and its completion callback */
+    for (uint i = 0; i < runs; ++i) {
+        LTRACEF("Async test\n");
+        async_test(num_cpus);
+    }
+
     for (uint i = 0; i < runs; ++i) {
         LTRACEF("Deadlock test\n");
         deadlock_test();
@@ -347,6 +347,7 @@ extern "C" void arm64_secondary_entry(void)
     spin_unlock(&arm_boot_cpu_lock);
 
     uint cpu = arch_curr_cpu_num();
+    arm64_fpu_cpu_init();
     thread_secondary_cpu_init_early(&_init_thread[cpu - 1]);
     /* run early secondary cpu init routines up to the threading level */
     lk_init_level(LK_INIT_FLAG_SECONDARY_CPUS, LK_INIT_LEVEL_EARLIEST, LK_INIT_LEVEL_THREADING - 1);
@@ -21,11 +21,23 @@
  */
 #define FPU_ENABLE_MASK (3<<20)
 
+/* thread whose state is live in each cpu's fpu registers; only compared
+ * against, never dereferenced, since the thread may have exited while still
+ * owning the registers */
+static struct thread *fpu_owner[SMP_MAX_CPUS];
+
 static inline bool is_fpu_enabled(uint32_t cpacr)
 {
     return !!(BITS(cpacr, 21, 20) != 0);
 }
 
+/* called as each cpu is (re)started; the registers were reset, so drop any
+ * claim a thread had on them */
+void arm64_fpu_cpu_init(void)
+{
+    fpu_owner[arch_curr_cpu_num()] = NULL;
+}
+
 static void arm64_fpu_load_state(struct thread *t)
 {
     struct fpstate *fpstate = &t->arch.fpstate;
@@ -122,8 +134,15 @@ void arm64_fpu_exception(struct arm64_iframe_long *iframe, uint exception_flags)
     cpacr |= FPU_ENABLE_MASK;
     ARM64_WRITE_SYSREG(cpacr_el1, cpacr);
 
-    /* load the state from the current cpu */
+    /* load the state on the current cpu, unless the registers already hold
+     * this thread's state from the last time it used the fpu here */
     thread_t *t = get_current_thread();
-    if (likely(t))
-        arm64_fpu_load_state(t);
+    if (likely(t)) {
+        uint cpu = arch_curr_cpu_num();
+        if (fpu_owner[cpu] != t || t->arch.fpstate.current_cpu != cpu) {
+            arm64_fpu_load_state(t);
+            fpu_owner[cpu] = t;
+            t->arch.fpstate.current_cpu = cpu;
+        }
+    }
 }
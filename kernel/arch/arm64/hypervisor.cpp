@@ -16,6 +16,10 @@ status_t arch_guest_set_trap(Guest* guest, mx_trap_address_space_t aspace, mx_va
     return MX_ERR_NOT_SUPPORTED;
 }
 
+status_t arch_guest_commit(Guest* guest, mx_vaddr_t addr, size_t len) {
+    return MX_ERR_NOT_SUPPORTED;
+}
+
 status_t arch_vcpu_resume(Vcpu* vcpu, mx_guest_packet_t* packet) {
     return MX_ERR_NOT_SUPPORTED;
 }
@@ -20,6 +20,10 @@ __BEGIN_CDECLS
 struct fpstate {
     uint32_t    fpcr;
     uint32_t    fpsr;
+    /* cpu whose registers last held this state, or UINT_MAX; used to skip
+     * the reload on a fpu trap when the thread resumes on the cpu it last
+     * used the fpu on */
+    uint        current_cpu;
     uint64_t    regs[64];
 };
 
@@ -102,6 +102,7 @@ enum handler_return platform_fiq(iframe* frame);
 /* fpu routines */
 void arm64_fpu_exception(struct arm64_iframe_long *iframe, uint exception_flags);
 void arm64_fpu_context_switch(struct thread *oldthread, struct thread *newthread);
+void arm64_fpu_cpu_init(void);
 
 /* overridable syscall handler */
 void arm64_syscall(struct arm64_iframe_long *iframe, bool is_64bit, uint64_t pc);
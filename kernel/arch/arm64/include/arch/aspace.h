@@ -9,6 +9,7 @@
 
 #include <arch/arm64/mmu.h>
 #include <kernel/vm/arch_vm_aspace.h>
+#include <list.h>
 #include <magenta/compiler.h>
 #include <mxtl/canary.h>
 
@@ -50,7 +51,8 @@ private:
 
     status_t AllocPageTable(paddr_t* paddrp, uint page_size_shift);
 
-    void FreePageTable(void* vaddr, paddr_t paddr, uint page_size_shift);
+    void FreePageTable(void* vaddr, paddr_t paddr, uint page_size_shift,
+                       list_node* freed_pts);
 
     ssize_t MapPageTable(vaddr_t vaddr_in, vaddr_t vaddr_rel_in,
                          paddr_t paddr_in, size_t size_in, pte_t attrs,
@@ -59,7 +61,8 @@ private:
 
     ssize_t UnmapPageTable(vaddr_t vaddr, vaddr_t vaddr_rel, size_t size,
                            uint index_shift, uint page_size_shift,
-                           volatile pte_t* page_table, uint asid);
+                           volatile pte_t* page_table, uint asid,
+                           list_node* freed_pts);
 
     int ProtectPageTable(vaddr_t vaddr_in, vaddr_t vaddr_rel_in, size_t size_in,
                          pte_t attrs, uint index_shift, uint page_size_shift,
@@ -30,6 +30,9 @@ status_t arch_guest_create(mxtl::RefPtr<VmObject> physmem, mxtl::unique_ptr<Gues
 status_t arch_guest_set_trap(Guest* guest, mx_trap_address_space_t aspace, mx_vaddr_t addr,
                              size_t len, mxtl::RefPtr<FifoDispatcher> fifo);
 
+/* Commit and map a range of guest physical memory. */
+status_t arch_guest_commit(Guest* guest, mx_vaddr_t addr, size_t len);
+
 /* Resume execution of a VCPU. */
 status_t arch_vcpu_resume(Vcpu* vcpu, mx_guest_packet_t* packet);
 
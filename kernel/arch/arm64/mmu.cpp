@@ -267,7 +267,8 @@ status_t ArmArchVmAspace::AllocPageTable(paddr_t* paddrp, uint page_size_shift)
     return 0;
 }
 
-void ArmArchVmAspace::FreePageTable(void* vaddr, paddr_t paddr, uint page_size_shift) {
+void ArmArchVmAspace::FreePageTable(void* vaddr, paddr_t paddr, uint page_size_shift,
+                                    list_node* freed_pts) {
     DEBUG_ASSERT(page_size_shift <= MMU_MAX_PAGE_SIZE_SHIFT);
 
     LTRACEF("vaddr %p paddr 0x%lx page_size_shift %u\n", vaddr, paddr, page_size_shift);
@@ -279,7 +280,9 @@ void ArmArchVmAspace::FreePageTable(void* vaddr, paddr_t paddr, uint page_size_s
         page = paddr_to_vm_page(paddr);
         if (!page)
             panic("bad page table paddr 0x%lx\n", paddr);
-        pmm_free_page(page);
+        // accumulate whole pages so the caller can return them to the PMM
+        // in one batch at the end of the unmap
+        list_add_tail(freed_pts, &page->free.node);
     } else {
         free(vaddr);
     }
@@ -350,7 +353,8 @@ static bool page_table_is_clear(volatile pte_t* page_table, uint page_size_shift
 ssize_t ArmArchVmAspace::UnmapPageTable(vaddr_t vaddr, vaddr_t vaddr_rel,
                                         size_t size, uint index_shift,
                                         uint page_size_shift,
-                                        volatile pte_t* page_table, uint asid) {
+                                        volatile pte_t* page_table, uint asid,
+                                        list_node* freed_pts) {
     volatile pte_t* next_page_table;
     vaddr_t index;
     size_t chunk_size;
@@ -380,7 +384,7 @@ ssize_t ArmArchVmAspace::UnmapPageTable(vaddr_t vaddr, vaddr_t vaddr_rel,
             next_page_table = static_cast<volatile pte_t*>(paddr_to_kvaddr(page_table_paddr));
             UnmapPageTable(vaddr, vaddr_rem, chunk_size,
                            index_shift - (page_size_shift - 3),
-                           page_size_shift, next_page_table, asid);
+                           page_size_shift, next_page_table, asid, freed_pts);
             if (chunk_size == block_size ||
                 page_table_is_clear(next_page_table, page_size_shift)) {
                 LTRACEF("pte %p[0x%lx] = 0 (was page table)\n", page_table, index);
@@ -388,7 +392,7 @@ ssize_t ArmArchVmAspace::UnmapPageTable(vaddr_t vaddr, vaddr_t vaddr_rel,
                 __asm__ volatile("dmb ishst" ::
                                      : "memory");
                 FreePageTable(const_cast<pte_t*>(next_page_table), page_table_paddr,
-                              page_size_shift);
+                              page_size_shift, freed_pts);
             }
         } else if (pte) {
             LTRACEF("pte %p[0x%lx] = 0\n", page_table, index);
@@ -488,9 +492,14 @@ ssize_t ArmArchVmAspace::MapPageTable(vaddr_t vaddr_in, vaddr_t vaddr_rel_in,
     return mapped_size;
 
 err:
-    UnmapPageTable(vaddr_in, vaddr_rel_in, size_in - size, index_shift,
-                   page_size_shift, page_table, asid);
-    DSB;
+    {
+        list_node freed_pts = LIST_INITIAL_VALUE(freed_pts);
+        UnmapPageTable(vaddr_in, vaddr_rel_in, size_in - size, index_shift,
+                       page_size_shift, page_table, asid, &freed_pts);
+        DSB;
+        if (!list_is_empty(&freed_pts))
+            pmm_free(&freed_pts);
+    }
     return MX_ERR_INTERNAL;
 }
 
@@ -625,9 +634,16 @@ ssize_t ArmArchVmAspace::UnmapPages(vaddr_t vaddr, size_t size,
         return MX_ERR_INVALID_ARGS;
     }
 
+    list_node freed_pts = LIST_INITIAL_VALUE(freed_pts);
     ssize_t ret = UnmapPageTable(vaddr, vaddr_rel, size, top_index_shift,
-                                 page_size_shift, top_page_table, asid);
+                                 page_size_shift, top_page_table, asid, &freed_pts);
     DSB;
+
+    // Free emptied page tables in one batch, after the barrier so no
+    // walk can still reference them.
+    if (!list_is_empty(&freed_pts))
+        pmm_free(&freed_pts);
+
     return ret;
 }
 
@@ -12,6 +12,7 @@
 #include <err.h>
 #include <dev/interrupt.h>
 #include <arch/ops.h>
+#include <kernel/mp.h>
 
 #define LOCAL_TRACE 0
 
@@ -48,6 +49,15 @@ void arch_init_cpu_map(uint cluster_count, const uint* cluster_cpus) {
             // set the per cpu structure's cpu id
             arm64_percpu_array[cpu_id].cpu_num = cpu_id;
 
+            // feed the scheduler's topology map; a cluster shares a cache
+            // the way an x86 package does, and there's no smt
+            mp_cpu_topology_t topo = {
+                .package_id = cluster,
+                .core_id = cpu,
+                .smt_id = 0,
+            };
+            mp_set_cpu_topology(cpu_id, &topo);
+
             cpu_id++;
         }
     }
@@ -6,6 +6,7 @@
 // https://opensource.org/licenses/MIT
 
 #include <sys/types.h>
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 #include <debug.h>
@@ -43,6 +44,7 @@ void arch_thread_initialize(thread_t *t, vaddr_t entry_point)
 {
     // zero out the entire arch state
     t->arch = {};
+    t->arch.fpstate.current_cpu = UINT_MAX;
 
     // create a default stack frame on the stack
     vaddr_t stack_top = (vaddr_t)t->stack + t->stack_size;
@@ -13,6 +13,7 @@
 #include <arch/x86/feature.h>
 #include <arch/x86/interrupts.h>
 #include <arch/x86/descriptor.h>
+#include <arch/x86/registers.h>
 #include <kernel/thread.h>
 #include <kernel/stats.h>
 #include <kernel/vm.h>
@@ -365,7 +366,10 @@ void x86_exception_handler(x86_iframe_t *frame)
 
         case X86_INT_DEVICE_NA:
             CPU_STATS_INC(exceptions);
-            exception_die(frame, "device na fault\n");
+            /* lazy extended register restore; fatal if the kernel itself
+             * touched the fpu */
+            if (unlikely(!from_user) || !x86_extended_register_dev_na_handler())
+                exception_die(frame, "device na fault\n");
             break;
 
         case X86_INT_DOUBLE_FAULT:
@@ -113,3 +113,7 @@ status_t arch_guest_set_trap(Guest* guest, mx_trap_address_space_t aspace, mx_va
                              size_t len, mxtl::RefPtr<FifoDispatcher> fifo) {
     return guest->SetTrap(aspace, addr, len, fifo);
 }
+
+status_t arch_guest_commit(Guest* guest, mx_vaddr_t addr, size_t len) {
+    return guest->AddressSpace()->CommitRange(addr, len);
+}
@@ -43,6 +43,11 @@ struct arch_thread {
     vaddr_t *extended_register_state;
     uint8_t extended_register_buffer[X86_MAX_EXTENDED_REGISTER_SIZE + 64];
 
+    /* cpu whose registers last held this thread's extended register state,
+     * or UINT32_MAX; used to skip the lazy restore when a thread resumes on
+     * the cpu it last ran on */
+    uint32_t extended_register_cpu;
+
     /* if non-NULL, address to return to on page fault */
     void *page_fault_resume;
 };
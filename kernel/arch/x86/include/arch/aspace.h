@@ -11,6 +11,7 @@
 #include <arch/x86/mmu.h>
 #include <kernel/atomic.h>
 #include <kernel/vm/arch_vm_aspace.h>
+#include <list.h>
 #include <magenta/compiler.h>
 #include <mxtl/canary.h>
 
@@ -50,10 +51,22 @@ public:
 
     int active_cpus() { return atomic_load(&active_cpus_); }
 
+    uint16_t pcid() const { return pcid_; }
+
+    int tlb_cpus() { return atomic_load(&tlb_cpus_); }
+
     IoBitmap& io_bitmap() { return io_bitmap_; }
 
     static void ContextSwitch(X86ArchVmAspace* from, X86ArchVmAspace* to);
 
+    // TLB invalidation batching: while a batch is open, page invalidations
+    // accumulate in pending_tlb_ and are issued as a single cross-cpu
+    // shootdown when the batch is flushed. Callers hold the owning
+    // VmAspace's lock, which also guards the page tables themselves.
+    void BeginTlbBatchLocked();
+    void FlushTlbBatchLocked();
+    bool QueueTlbInvalidationLocked(vaddr_t vaddr, bool global_page, bool top_level);
+
 private:
     // Test the vaddr against the address space's range.
     bool IsValidVaddr(vaddr_t vaddr) {
@@ -90,7 +103,8 @@ private:
     template <typename PageTable>
     bool RemoveMapping(volatile pt_entry_t* table,
                        const MappingCursor& start_cursor,
-                       MappingCursor* new_cursor);
+                       MappingCursor* new_cursor,
+                       list_node* freed_pts);
 
     template <typename PageTable>
     bool RemoveMappingL0(volatile pt_entry_t* table,
@@ -143,6 +157,23 @@ private:
     // CPUs that are currently executing in this aspace.
     // Actually an mp_cpu_mask_t, but header dependencies.
     volatile int active_cpus_ = 0;
+
+    // pcid tagging this aspace's TLB entries, 0 if pcid is disabled or
+    // allocation failed
+    uint16_t pcid_ = 0;
+
+    // cpus that may still hold TLB entries tagged with pcid_
+    volatile int tlb_cpus_ = 0;
+
+    // accumulated TLB invalidations for the current unmap/protect operation
+    struct PendingTlbInvalidation {
+        static const uint kMaxPages = 32;
+        bool batching = false;
+        bool full = false;
+        bool contains_global = false;
+        uint count = 0;
+        vaddr_t vaddr[kMaxPages];
+    } pending_tlb_;
 };
 
 using ArchVmAspace = X86ArchVmAspace;
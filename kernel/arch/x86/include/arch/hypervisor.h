@@ -127,6 +127,9 @@ status_t arch_guest_create(mxtl::RefPtr<VmObject> physmem, mxtl::unique_ptr<Gues
 status_t arch_guest_set_trap(Guest* guest, mx_trap_address_space_t aspace, mx_vaddr_t addr,
                              size_t len, mxtl::RefPtr<FifoDispatcher> fifo);
 
+/* Commit and map a range of guest physical memory. */
+status_t arch_guest_commit(Guest* guest, mx_vaddr_t addr, size_t len);
+
 /* Create a VCPU. */
 status_t x86_vcpu_create(mx_vaddr_t ip, mx_vaddr_t cr3, mxtl::RefPtr<VmObject> apic_vmo,
                          paddr_t apic_access_address, paddr_t msr_bitmaps_address,
@@ -70,6 +70,11 @@ struct x86_percpu {
 
     /* Reserved space for interrupt stacks */
     uint8_t interrupt_stacks[NUM_ASSIGNED_IST_ENTRIES][PAGE_SIZE] __ALIGNED(16);
+
+    /* thread whose extended register state is live in this cpu's registers;
+     * only compared against, never dereferenced, since the thread may have
+     * exited while still owning the registers */
+    struct thread *fpu_owner;
 } __CPU_MAX_ALIGN;
 
 static_assert(__offsetof(struct x86_percpu, direct) == PERCPU_DIRECT_OFFSET, "");
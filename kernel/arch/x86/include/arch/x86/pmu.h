@@ -0,0 +1,17 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <magenta/compiler.h>
+
+__BEGIN_CDECLS
+
+// Detect architectural performance monitoring support.
+// The generic control interface is in kernel/pmu.h.
+void x86_pmu_init(void);
+
+__END_CDECLS
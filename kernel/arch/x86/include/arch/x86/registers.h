@@ -22,6 +22,7 @@
 #define X86_CR4_OSXMMEXPT               0x00000400 /* os supports xmm exception */
 #define X86_CR4_VMXE                    0x00002000 /* enable vmx */
 #define X86_CR4_FSGSBASE                0x00010000 /* enable {rd,wr}{fs,gs}base */
+#define X86_CR4_PCIDE                   0x00020000 /* PCID enable */
 #define X86_CR4_OSXSAVE                 0x00040000 /* os supports xsave */
 #define X86_CR4_SMEP                    0x00100000 /* SMEP protection enabling */
 #define X86_CR4_SMAP                    0x00200000 /* SMAP protection enabling */
@@ -154,6 +155,11 @@ typedef struct thread thread_t;
 void x86_extended_register_context_switch(
         thread_t *old_thread, thread_t *new_thread);
 
+/* Handle a device-not-available fault by lazily restoring the current
+ * thread's extended register state.  Returns false if the fault did not come
+ * from a thread with extended register state. */
+bool x86_extended_register_dev_na_handler(void);
+
 void x86_set_extended_register_pt_state(bool threads);
 
 uint64_t x86_xgetbv(uint32_t reg);
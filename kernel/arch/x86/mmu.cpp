@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <err.h>
+#include <rand.h>
 #include <string.h>
 #include <trace.h>
 
@@ -17,6 +18,7 @@
 #include <arch/x86/mmu.h>
 #include <arch/x86/mmu_mem_types.h>
 #include <kernel/mp.h>
+#include <kernel/mutex.h>
 #include <kernel/vm.h>
 #include <kernel/vm/arch_vm_aspace.h>
 #include <kernel/vm/pmm.h>
@@ -31,6 +33,73 @@ uint8_t g_paddr_width = 32;
 /* True if the system supports 1GB pages */
 static bool supports_huge_pages = false;
 
+/* True if EPT supports 2MB and 1GB mappings, from IA32_VMX_EPT_VPID_CAP.
+ * Only meaningful when VMX is present. */
+static bool supports_ept_2mb_pages = false;
+static bool supports_ept_1gb_pages = false;
+
+/* True if TLB entries are tagged with a pcid and CR3 loads don't flush.
+ * Requires INVPCID as well, so we can invalidate entries of aspaces that
+ * aren't loaded on the invalidating cpu. */
+static bool g_pcid_enabled = false;
+
+#define X86_MMU_PCID_BITS (12)
+#define X86_CR3_PCID_NOFLUSH (1ul << 63)
+
+/* invpcid invalidation types */
+#define X86_INVPCID_INDIV_ADDR (0ul)
+#define X86_INVPCID_SINGLE_CONTEXT (1ul)
+
+static uint64_t pcid_pool[(1 << X86_MMU_PCID_BITS) / 64];
+static mutex_t pcid_lock = MUTEX_INITIAL_VALUE(pcid_lock);
+
+static status_t x86_mmu_alloc_pcid(uint16_t* pcid) {
+    uint16_t new_pcid;
+    uint32_t retry = 1 << X86_MMU_PCID_BITS;
+
+    mutex_acquire(&pcid_lock);
+    do {
+        new_pcid = static_cast<uint16_t>(rand()) & ~(-(1 << X86_MMU_PCID_BITS));
+        retry--;
+        if (retry == 0) {
+            mutex_release(&pcid_lock);
+            return MX_ERR_NO_MEMORY;
+        }
+    } while ((pcid_pool[new_pcid >> 6] & (1ul << (new_pcid % 64))) || (new_pcid == 0));
+
+    pcid_pool[new_pcid >> 6] = pcid_pool[new_pcid >> 6] | (1ul << (new_pcid % 64));
+
+    mutex_release(&pcid_lock);
+
+    *pcid = new_pcid;
+
+    return MX_OK;
+}
+
+static status_t x86_mmu_free_pcid(uint16_t pcid) {
+    mutex_acquire(&pcid_lock);
+
+    pcid_pool[pcid >> 6] = pcid_pool[pcid >> 6] & ~(1ul << (pcid % 64));
+
+    mutex_release(&pcid_lock);
+
+    return MX_OK;
+}
+
+static void x86_invpcid(ulong type, uint16_t pcid, vaddr_t vaddr) {
+    struct {
+        uint64_t pcid;
+        uint64_t addr;
+    } desc = {pcid, vaddr};
+    __asm__ volatile("invpcid %1, %0" ::"r"(type), "m"(desc) : "memory");
+}
+
+/* task used to flush one pcid everywhere before it can be reused */
+static void pcid_flush_task(void* raw_pcid) {
+    DEBUG_ASSERT(arch_ints_disabled());
+    x86_invpcid(X86_INVPCID_SINGLE_CONTEXT, (uint16_t)(uintptr_t)raw_pcid, 0);
+}
+
 /* top level kernel page tables, initialized in start.S */
 volatile pt_entry_t pml4[NO_OF_PT_ENTRIES] __ALIGNED(PAGE_SIZE);
 volatile pt_entry_t pdp[NO_OF_PT_ENTRIES] __ALIGNED(PAGE_SIZE); /* temporary */
@@ -117,19 +186,125 @@ static void x86_tlb_global_invalidate() {
     }
 }
 
+/* Task used for invalidating a batch of TLB entries on each CPU; the
+ * originating cpu waits in mp_sync_exec so the pointers stay live */
+struct tlb_invalidate_range_context {
+    ulong target_cr3;
+    uint16_t pcid;
+    bool full;
+    bool contains_global;
+    uint count;
+    const vaddr_t* vaddrs;
+};
+static void tlb_invalidate_range_task(void* raw_context) {
+    DEBUG_ASSERT(arch_ints_disabled());
+    tlb_invalidate_range_context* context = (tlb_invalidate_range_context*)raw_context;
+
+    if (g_pcid_enabled && context->pcid != 0 && !context->contains_global) {
+        if (context->full) {
+            x86_invpcid(X86_INVPCID_SINGLE_CONTEXT, context->pcid, 0);
+        } else {
+            for (uint i = 0; i < context->count; i++)
+                x86_invpcid(X86_INVPCID_INDIV_ADDR, context->pcid, context->vaddrs[i]);
+        }
+        return;
+    }
+
+    ulong cr3 = x86_get_cr3();
+    if (context->target_cr3 != (cr3 & ~(ulong)(PAGE_SIZE - 1)) && !context->contains_global) {
+        /* This invalidation doesn't apply to this CPU, ignore it */
+        return;
+    }
+
+    if (context->full) {
+        x86_tlb_global_invalidate();
+        return;
+    }
+
+    for (uint i = 0; i < context->count; i++)
+        __asm__ volatile("invlpg %0" ::"m"(*(uint8_t*)context->vaddrs[i]));
+}
+
+void X86ArchVmAspace::BeginTlbBatchLocked() {
+    DEBUG_ASSERT(!pending_tlb_.batching);
+    pending_tlb_.batching = true;
+    pending_tlb_.full = false;
+    pending_tlb_.contains_global = false;
+    pending_tlb_.count = 0;
+}
+
+bool X86ArchVmAspace::QueueTlbInvalidationLocked(vaddr_t vaddr, bool global_page, bool top_level) {
+    if (!pending_tlb_.batching)
+        return false;
+
+    if (global_page)
+        pending_tlb_.contains_global = true;
+
+    if (top_level || pending_tlb_.count == PendingTlbInvalidation::kMaxPages) {
+        /* too much to track page by page, flush the whole context instead */
+        pending_tlb_.full = true;
+        return true;
+    }
+
+    pending_tlb_.vaddr[pending_tlb_.count++] = vaddr;
+    return true;
+}
+
+void X86ArchVmAspace::FlushTlbBatchLocked() {
+    DEBUG_ASSERT(pending_tlb_.batching);
+    pending_tlb_.batching = false;
+
+    if (pending_tlb_.count == 0 && !pending_tlb_.full)
+        return;
+
+    tlb_invalidate_range_context context = {
+        .target_cr3 = pt_phys_, .pcid = pcid_, .full = pending_tlb_.full,
+        .contains_global = pending_tlb_.contains_global,
+        .count = pending_tlb_.count, .vaddrs = pending_tlb_.vaddr,
+    };
+
+    mp_cpu_mask_t targets;
+    if (context.contains_global) {
+        targets = MP_CPU_ALL;
+    } else if (g_pcid_enabled && pcid_ != 0) {
+        targets = tlb_cpus();
+    } else {
+        targets = active_cpus();
+    }
+
+    mp_sync_exec(targets, tlb_invalidate_range_task, &context);
+}
+
 /* Task used for invalidating a TLB entry on each CPU */
 struct tlb_invalidate_page_context {
     ulong target_cr3;
     vaddr_t vaddr;
     enum page_table_levels level;
     bool global_page;
+    uint16_t pcid;
 };
 static void tlb_invalidate_page_task(void* raw_context) {
     DEBUG_ASSERT(arch_ints_disabled());
     tlb_invalidate_page_context* context = (tlb_invalidate_page_context*)raw_context;
 
+    /* with pcid tagging we can invalidate another aspace's entries directly,
+     * whether or not that aspace is the one loaded on this cpu */
+    if (g_pcid_enabled && !context->global_page && context->pcid != 0) {
+        switch (context->level) {
+        case PML4_L:
+            x86_invpcid(X86_INVPCID_SINGLE_CONTEXT, context->pcid, 0);
+            break;
+        case PDP_L:
+        case PD_L:
+        case PT_L:
+            x86_invpcid(X86_INVPCID_INDIV_ADDR, context->pcid, context->vaddr);
+            break;
+        }
+        return;
+    }
+
     ulong cr3 = x86_get_cr3();
-    if (context->target_cr3 != cr3 && !context->global_page) {
+    if (context->target_cr3 != (cr3 & ~(ulong)(PAGE_SIZE - 1)) && !context->global_page) {
         /* This invalidation doesn't apply to this CPU, ignore it */
         return;
     }
@@ -161,9 +336,14 @@ static void tlb_invalidate_page_task(void* raw_context) {
  */
 static void x86_tlb_invalidate_page(X86ArchVmAspace* aspace, vaddr_t vaddr,
                                     enum page_table_levels level, bool global_page) {
+    /* if the aspace has an invalidation batch open, just queue the page */
+    if (aspace && aspace->QueueTlbInvalidationLocked(vaddr, global_page, level == PML4_L))
+        return;
+
     ulong cr3 = aspace ? aspace->pt_phys() : x86_get_cr3();
     struct tlb_invalidate_page_context task_context = {
         .target_cr3 = cr3, .vaddr = vaddr, .level = level, .global_page = global_page,
+        .pcid = (aspace && !global_page) ? aspace->pcid() : (uint16_t)0,
     };
 
     /* Target only CPUs this aspace is active on.  It may be the case that some
@@ -174,6 +354,10 @@ static void x86_tlb_invalidate_page(X86ArchVmAspace* aspace, vaddr_t vaddr,
     mp_cpu_mask_t targets;
     if (global_page || aspace == nullptr) {
         targets = MP_CPU_ALL;
+    } else if (g_pcid_enabled && aspace->pcid() != 0) {
+        /* tagged entries can linger on any cpu that has loaded this pcid,
+         * not just the ones currently running in the aspace */
+        targets = aspace->tlb_cpus();
     } else {
         targets = aspace->active_cpus();
     }
@@ -378,6 +562,26 @@ struct ExtendedPageTable : PageTableBase<Level> {
     using LowerTable = ExtendedPageTable<Level - 1>;
     using TopTable = ExtendedPageTable<MAX_PAGING_LEVEL>;
 
+    /**
+     * @brief Whether EPT supports the page size of this level
+     *
+     * Hides the PageTableBase version, which reports the ordinary paging
+     * capabilities; EPT has its own large page bits in IA32_VMX_EPT_VPID_CAP.
+     */
+    static bool supports_page_size() {
+        DEBUG_ASSERT(Level != PT_L);
+        switch (Level) {
+        case PD_L:
+            return supports_ept_2mb_pages;
+        case PDP_L:
+            return supports_ept_1gb_pages;
+        case PML4_L:
+            return false;
+        default:
+            panic("Unreachable case in supports_page_size\n");
+        }
+    }
+
     /**
      * @brief Return EPT arch flags for intermediate tables
      */
@@ -690,13 +894,17 @@ status_t X86ArchVmAspace::GetMappingL0(volatile pt_entry_t* table, vaddr_t vaddr
  * unmap within table
  * @param new_cursor A returned cursor describing how much work was not
  * completed.  Must be non-null.
+ * @param freed_pts A list that emptied page tables are appended to instead
+ * of being returned to the PMM one at a time.  The caller frees the whole
+ * list with a single pmm_free() once the walk is done.
  *
  * @return true if at least one page was unmapped at this level
  */
 template <typename PageTable>
 bool X86ArchVmAspace::RemoveMapping(volatile pt_entry_t* table,
                                     const MappingCursor& start_cursor,
-                                    MappingCursor* new_cursor) {
+                                    MappingCursor* new_cursor,
+                                    list_node* freed_pts) {
     DEBUG_ASSERT(table);
     LTRACEF("L: %d, %016" PRIxPTR " %016zx\n", PageTable::level, start_cursor.vaddr,
             start_cursor.size);
@@ -747,7 +955,7 @@ bool X86ArchVmAspace::RemoveMapping(volatile pt_entry_t* table,
         MappingCursor cursor;
         volatile pt_entry_t* next_table = get_next_table_from_entry(pt_val);
         bool lower_unmapped = RemoveMapping<typename PageTable::LowerTable>(
-            next_table, *new_cursor, &cursor);
+            next_table, *new_cursor, &cursor, freed_pts);
 
         // If we were requesting to unmap everything in the lower page table,
         // we know we can unmap the lower level page table.  Otherwise, if
@@ -768,7 +976,8 @@ bool X86ArchVmAspace::RemoveMapping(volatile pt_entry_t* table,
         }
         if (unmap_page_table) {
             UnmapEntry<PageTable>(this, new_cursor->vaddr, e);
-            pmm_free_page(paddr_to_vm_page(X86_VIRT_TO_PHYS(next_table)));
+            list_add_tail(freed_pts,
+                          &paddr_to_vm_page(X86_VIRT_TO_PHYS(next_table))->free.node);
             pt_pages_--;
             unmapped = true;
         }
@@ -784,14 +993,16 @@ bool X86ArchVmAspace::RemoveMapping(volatile pt_entry_t* table,
 template <>
 bool X86ArchVmAspace::RemoveMapping<PageTable<PT_L>>(volatile pt_entry_t* table,
                                                      const MappingCursor& start_cursor,
-                                                     MappingCursor* new_cursor) {
+                                                     MappingCursor* new_cursor,
+                                                     list_node* freed_pts) {
     return RemoveMappingL0<PageTable<PT_L>>(table, start_cursor, new_cursor);
 }
 
 template <>
 bool X86ArchVmAspace::RemoveMapping<ExtendedPageTable<PT_L>>(volatile pt_entry_t* table,
                                                              const MappingCursor& start_cursor,
-                                                             MappingCursor* new_cursor) {
+                                                             MappingCursor* new_cursor,
+                                                             list_node* freed_pts) {
     return RemoveMappingL0<ExtendedPageTable<PT_L>>(table, start_cursor, new_cursor);
 }
 
@@ -912,8 +1123,11 @@ err:
         // new_cursor->size should be how much is left to be mapped still
         cursor.size -= new_cursor->size;
         if (cursor.size > 0) {
-            RemoveMapping<typename PageTable::TopTable>(table, cursor, &result);
+            list_node freed_pts = LIST_INITIAL_VALUE(freed_pts);
+            RemoveMapping<typename PageTable::TopTable>(table, cursor, &result, &freed_pts);
             DEBUG_ASSERT(result.size == 0);
+            if (!list_is_empty(&freed_pts))
+                pmm_free(&freed_pts);
         }
     }
     return ret;
@@ -1027,7 +1241,10 @@ status_t X86ArchVmAspace::UpdateMapping(volatile pt_entry_t* table,
                 cursor.size = ps;
 
                 MappingCursor tmp_cursor;
-                RemoveMapping<PageTable>(table, cursor, &tmp_cursor);
+                list_node freed_pts = LIST_INITIAL_VALUE(freed_pts);
+                RemoveMapping<PageTable>(table, cursor, &tmp_cursor, &freed_pts);
+                if (!list_is_empty(&freed_pts))
+                    pmm_free(&freed_pts);
 
                 new_cursor->SkipEntry<PageTable>();
             }
@@ -1124,9 +1341,17 @@ status_t X86ArchVmAspace::UnmapPages(vaddr_t vaddr, const size_t count,
     };
 
     MappingCursor result;
-    RemoveMapping<PageTable<MAX_PAGING_LEVEL>>(pt_virt_, start, &result);
+    list_node freed_pts = LIST_INITIAL_VALUE(freed_pts);
+    BeginTlbBatchLocked();
+    RemoveMapping<PageTable<MAX_PAGING_LEVEL>>(pt_virt_, start, &result, &freed_pts);
+    FlushTlbBatchLocked();
     DEBUG_ASSERT(result.size == 0);
 
+    // Return any emptied page tables to the PMM in one batch, after the
+    // TLB flush so no translation can still be walking through them.
+    if (!list_is_empty(&freed_pts))
+        pmm_free(&freed_pts);
+
     if (unmapped)
         *unmapped = count;
 
@@ -1214,8 +1439,10 @@ status_t X86ArchVmAspace::ProtectPages(vaddr_t vaddr, size_t count, uint mmu_fla
         .paddr = 0, .vaddr = vaddr, .size = count * PAGE_SIZE,
     };
     MappingCursor result;
+    BeginTlbBatchLocked();
     status_t status = UpdateMapping<PageTable<MAX_PAGING_LEVEL>>(
         pt_virt_, mmu_flags, start, &result);
+    FlushTlbBatchLocked();
     if (status != MX_OK) {
         return status;
     }
@@ -1246,6 +1473,16 @@ void x86_mmu_early_init() {
 
     supports_huge_pages = x86_feature_test(X86_FEATURE_HUGE_PAGE);
 
+    if (x86_feature_test(X86_FEATURE_VMX)) {
+        /* Bits 16 and 17 of IA32_VMX_EPT_VPID_CAP advertise 2MB and 1GB EPT
+         * mappings; see Volume 3, Appendix A.10. The MSR is canonically
+         * decoded by EptInfo in arch/x86/hypervisor, but the large page
+         * bits are needed here before any guest is created. */
+        uint64_t ept_info = read_msr(0x048c /* IA32_VMX_EPT_VPID_CAP */);
+        supports_ept_2mb_pages = !!(ept_info & (1ULL << 16));
+        supports_ept_1gb_pages = !!(ept_info & (1ULL << 17));
+    }
+
     /* if we got something meaningful, override the defaults.
      * some combinations of cpu on certain emulators seems to return
      * nonsense paddr widths (1), so trim it. */
@@ -1299,6 +1536,11 @@ status_t X86ArchVmAspace::Init(vaddr_t base, size_t size, uint mmu_flags) {
 
         p->state = VM_PAGE_STATE_MMU;
 
+        /* tag this aspace's TLB entries; if the pool is exhausted we just
+         * fall back to full flushes on context switch */
+        if (g_pcid_enabled)
+            x86_mmu_alloc_pcid(&pcid_);
+
         // Zero out the user space half of it.
         memset(pt_virt_, 0, sizeof(pt_entry_t) * NO_OF_PT_ENTRIES / 2);
 
@@ -1347,8 +1589,17 @@ status_t X86ArchVmAspace::DestroyAspace() {
 status_t X86ArchVmAspace::Destroy() {
     if (flags_ & ARCH_ASPACE_FLAG_GUEST_PASPACE)
         return DestroyAspace<ExtendedPageTable>();
-    else
-        return DestroyAspace<PageTable>();
+
+    if (pcid_ != 0) {
+        /* toss any entries still tagged with this pcid before it can be
+         * handed out again */
+        if (tlb_cpus_ != 0)
+            mp_sync_exec(tlb_cpus(), pcid_flush_task, (void*)(uintptr_t)pcid_);
+        x86_mmu_free_pcid(pcid_);
+        pcid_ = 0;
+    }
+
+    return DestroyAspace<PageTable>();
 }
 
 void X86ArchVmAspace::ContextSwitch(X86ArchVmAspace* old_aspace, X86ArchVmAspace* aspace) {
@@ -1356,7 +1607,13 @@ void X86ArchVmAspace::ContextSwitch(X86ArchVmAspace* old_aspace, X86ArchVmAspace
     if (aspace != nullptr) {
         aspace->canary_.Assert();
         LTRACEF_LEVEL(3, "switching to aspace %p, pt %#" PRIXPTR "\n", aspace, aspace->pt_phys_);
-        x86_set_cr3(aspace->pt_phys_);
+        if (g_pcid_enabled && aspace->pcid_ != 0) {
+            /* this cpu may cache tagged entries for the aspace from now on */
+            atomic_or(&aspace->tlb_cpus_, cpu_bit);
+            x86_set_cr3(aspace->pt_phys_ | aspace->pcid_ | X86_CR3_PCID_NOFLUSH);
+        } else {
+            x86_set_cr3(aspace->pt_phys_);
+        }
 
         if (old_aspace != nullptr) {
             atomic_and(&old_aspace->active_cpus_, ~cpu_bit);
@@ -1456,6 +1713,11 @@ void x86_mmu_percpu_init(void) {
         cr4 |= X86_CR4_SMEP;
     if (x86_feature_test(X86_FEATURE_SMAP))
         cr4 |= X86_CR4_SMAP;
+    /* enable pcid tagging if we can also invalidate non-loaded contexts */
+    if (x86_feature_test(X86_FEATURE_PCID) && x86_feature_test(X86_FEATURE_INVPCID)) {
+        cr4 |= X86_CR4_PCIDE;
+        g_pcid_enabled = true;
+    }
     x86_set_cr4(cr4);
 
     // Set NXE bit in X86_MSR_IA32_EFER.
@@ -95,6 +95,11 @@ void x86_init_percpu(uint cpu_num)
     x86_feature_init();
 
     x86_cpu_topology_init();
+
+    /* the registers were reset if this cpu was offline; drop any claim a
+     * thread had on them */
+    percpu->fpu_owner = NULL;
+
     x86_extended_register_init();
     x86_extended_register_enable_feature(X86_EXTENDED_REGISTER_SSE);
     x86_extended_register_enable_feature(X86_EXTENDED_REGISTER_AVX);
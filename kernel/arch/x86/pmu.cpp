@@ -0,0 +1,182 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// x86 backend for hardware performance counter sampling.
+//
+// Uses the architectural performance monitoring facility (Intel Vol. 3
+// chapter 18): the fixed counters give instructions retired and
+// unhalted core cycles, and two programmable counters are pointed at
+// the architectural LLC-miss and branch-miss events. Counters run in
+// both ring 0 and ring 3 and are read from the context switch path,
+// which emits per-thread deltas into the ktrace stream; no PMI handler
+// is involved.
+
+#include <arch/arch_ops.h>
+#include <arch/x86.h>
+#include <arch/x86/feature.h>
+#include <arch/x86/pmu.h>
+#include <err.h>
+#include <kernel/atomic.h>
+#include <kernel/mp.h>
+#include <kernel/mutex.h>
+#include <kernel/pmu.h>
+#include <lib/ktrace.h>
+#include <magenta/ktrace.h>
+#include <string.h>
+#include <trace.h>
+
+#define LOCAL_TRACE 0
+
+// Architectural performance monitoring MSRs.
+#define IA32_PMC0 0xc1
+#define IA32_PMC1 0xc2
+#define IA32_PERFEVTSEL0 0x186
+#define IA32_PERFEVTSEL1 0x187
+#define IA32_FIXED_CTR0 0x309 // instructions retired
+#define IA32_FIXED_CTR1 0x30a // unhalted core cycles
+#define IA32_FIXED_CTR_CTRL 0x38d
+#define IA32_PERF_GLOBAL_CTRL 0x38f
+
+// PERFEVTSEL fields: event select in [7:0], umask in [15:8].
+#define PERFEVTSEL_EVENT(event, umask) ((uint64_t)(event) | ((uint64_t)(umask) << 8))
+#define PERFEVTSEL_USR (1ull << 16)
+#define PERFEVTSEL_OS (1ull << 17)
+#define PERFEVTSEL_EN (1ull << 22)
+
+// Architectural events (Intel Vol. 3 table 18-1).
+#define EVENT_LLC_MISSES PERFEVTSEL_EVENT(0x2e, 0x41)
+#define EVENT_BRANCH_MISSES PERFEVTSEL_EVENT(0xc5, 0x00)
+
+// Enable fixed counters 0 and 1 in ring 0 and ring 3.
+#define FIXED_CTR_CTRL_EN ((3ull << 0) | (3ull << 4))
+
+// Global enables for pmc0, pmc1 and the two fixed counters.
+#define GLOBAL_CTRL_EN ((1ull << 0) | (1ull << 1) | (1ull << 32) | (1ull << 33))
+
+struct pmu_counts {
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t llc_misses;
+    uint64_t branch_misses;
+};
+
+static mutex_t pmu_lock = MUTEX_INITIAL_VALUE(pmu_lock);
+static bool pmu_supported;
+
+// read with atomics from the context switch path; written under pmu_lock
+static volatile int pmu_active;
+
+// counter values as of each cpu's last sample
+static struct pmu_counts pmu_last[SMP_MAX_CPUS];
+
+void x86_pmu_init(void)
+{
+    const struct cpuid_leaf* leaf =
+        x86_get_cpuid_leaf(X86_CPUID_PERFORMANCE_MONITORING);
+    if (!leaf)
+        return;
+
+    uint32_t version = leaf->a & 0xff;
+    uint32_t num_programmable = (leaf->a >> 8) & 0xff;
+    uint32_t num_fixed = leaf->d & 0x1f;
+
+    // We need version 2 for the global control MSR, two programmable
+    // counters and both fixed counters.
+    if (version < 2 || num_programmable < 2 || num_fixed < 2)
+        return;
+
+    pmu_supported = true;
+}
+
+static void pmu_start_task(void* arg)
+{
+    // disable everything while reprogramming
+    write_msr(IA32_PERF_GLOBAL_CTRL, 0);
+
+    write_msr(IA32_PERFEVTSEL0,
+              EVENT_LLC_MISSES | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_EN);
+    write_msr(IA32_PERFEVTSEL1,
+              EVENT_BRANCH_MISSES | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_EN);
+    write_msr(IA32_PMC0, 0);
+    write_msr(IA32_PMC1, 0);
+    write_msr(IA32_FIXED_CTR0, 0);
+    write_msr(IA32_FIXED_CTR1, 0);
+    write_msr(IA32_FIXED_CTR_CTRL, FIXED_CTR_CTRL_EN);
+
+    memset(&pmu_last[arch_curr_cpu_num()], 0, sizeof(pmu_last[0]));
+
+    write_msr(IA32_PERF_GLOBAL_CTRL, GLOBAL_CTRL_EN);
+}
+
+static void pmu_stop_task(void* arg)
+{
+    write_msr(IA32_PERF_GLOBAL_CTRL, 0);
+    write_msr(IA32_FIXED_CTR_CTRL, 0);
+    write_msr(IA32_PERFEVTSEL0, 0);
+    write_msr(IA32_PERFEVTSEL1, 0);
+}
+
+status_t pmu_start(uint32_t options)
+{
+    if (options != 0)
+        return MX_ERR_INVALID_ARGS;
+    if (!pmu_supported)
+        return MX_ERR_NOT_SUPPORTED;
+
+    mutex_acquire(&pmu_lock);
+    if (atomic_load(&pmu_active)) {
+        mutex_release(&pmu_lock);
+        return MX_ERR_BAD_STATE;
+    }
+
+    mp_sync_exec(MP_CPU_ALL, pmu_start_task, NULL);
+    atomic_store(&pmu_active, true);
+    mutex_release(&pmu_lock);
+    return MX_OK;
+}
+
+status_t pmu_stop(void)
+{
+    if (!pmu_supported)
+        return MX_ERR_NOT_SUPPORTED;
+
+    mutex_acquire(&pmu_lock);
+    if (!atomic_load(&pmu_active)) {
+        mutex_release(&pmu_lock);
+        return MX_ERR_BAD_STATE;
+    }
+
+    atomic_store(&pmu_active, false);
+    mp_sync_exec(MP_CPU_ALL, pmu_stop_task, NULL);
+    mutex_release(&pmu_lock);
+    return MX_OK;
+}
+
+void pmu_context_switch(void)
+{
+    if (likely(!atomic_load(&pmu_active)))
+        return;
+
+    struct pmu_counts* last = &pmu_last[arch_curr_cpu_num()];
+
+    uint64_t instructions = read_msr(IA32_FIXED_CTR0);
+    uint64_t cycles = read_msr(IA32_FIXED_CTR1);
+    uint64_t llc_misses = read_msr(IA32_PMC0);
+    uint64_t branch_misses = read_msr(IA32_PMC1);
+
+    // The deltas are bounded by one time slice, so 32 bits is plenty;
+    // the record's common header supplies the outgoing thread's tid.
+    ktrace(TAG_PMU_SAMPLE,
+           (uint32_t)(instructions - last->instructions),
+           (uint32_t)(cycles - last->cycles),
+           (uint32_t)(llc_misses - last->llc_misses),
+           (uint32_t)(branch_misses - last->branch_misses));
+
+    last->instructions = instructions;
+    last->cycles = cycles;
+    last->llc_misses = llc_misses;
+    last->branch_misses = branch_misses;
+}
@@ -331,13 +331,59 @@ void x86_extended_register_restore_state(void *register_state)
     }
 }
 
+/* Lazily switch extended register state.  Rather than eagerly restoring the
+ * incoming thread's state, leave CR0.TS set so that its first FPU/SIMD
+ * instruction takes a device-not-available fault and the restore happens
+ * there.  Threads that never touch the vector registers pay nothing on a
+ * context switch.  The outgoing thread's state is written back at switch-out
+ * time if it owns the live registers, so a thread's save buffer is always
+ * current while it is not running and migration needs no cross-cpu work. */
 void x86_extended_register_context_switch(
         thread_t *old_thread, thread_t *new_thread)
 {
-    if (likely(old_thread)) {
+    struct x86_percpu *percpu = x86_get_percpu();
+    ulong cr0 = x86_get_cr0();
+
+    if (likely(old_thread) && percpu->fpu_owner == old_thread) {
+        DEBUG_ASSERT(!(cr0 & X86_CR0_TS));
         x86_extended_register_save_state(old_thread->arch.extended_register_state);
     }
-    x86_extended_register_restore_state(new_thread->arch.extended_register_state);
+
+    if (percpu->fpu_owner == new_thread &&
+        new_thread->arch.extended_register_cpu == percpu->cpu_num) {
+        /* the registers still hold the incoming thread's state; let it use
+         * them without faulting */
+        if (cr0 & X86_CR0_TS) {
+            x86_set_cr0(cr0 & ~X86_CR0_TS);
+        }
+    } else if (!(cr0 & X86_CR0_TS)) {
+        x86_set_cr0(cr0 | X86_CR0_TS);
+    }
+}
+
+/* Device-not-available fault: a thread touched the FPU/SIMD registers for the
+ * first time since it was switched in.  Claim the registers and restore its
+ * state.  Returns false if the faulting thread has no extended register state
+ * (the fault then came from kernel code, which must not use the FPU). */
+bool x86_extended_register_dev_na_handler(void)
+{
+    DEBUG_ASSERT(arch_ints_disabled());
+
+    thread_t *t = get_current_thread();
+    struct x86_percpu *percpu = x86_get_percpu();
+
+    if (unlikely(!t->arch.extended_register_state)) {
+        return false;
+    }
+
+    x86_clts();
+
+    /* no need to write back the previous owner's state here; it was saved
+     * when that thread switched out */
+    x86_extended_register_restore_state(t->arch.extended_register_state);
+    percpu->fpu_owner = t;
+    t->arch.extended_register_cpu = percpu->cpu_num;
+    return true;
 }
 
 static void read_xsave_state_info(void)
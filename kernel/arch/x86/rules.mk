@@ -72,6 +72,7 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/mmu_mem_types.cpp \
 	$(LOCAL_DIR)/mmu_tests.cpp \
 	$(LOCAL_DIR)/mp.cpp \
+	$(LOCAL_DIR)/pmu.cpp \
 	$(LOCAL_DIR)/proc_trace.cpp \
 	$(LOCAL_DIR)/registers.cpp \
 	$(LOCAL_DIR)/thread.cpp \
@@ -45,6 +45,19 @@ uint64_t x86_lookup_core_crystal_freq() {
         return tsc_leaf->c;
     }
 
+    // Some parts enumerate the TSC/crystal ratio in leaf 0x15 but leave the
+    // crystal frequency itself at zero.  If leaf 0x16 is there, its processor
+    // base frequency is the nominal TSC frequency (18.18.3 again), so the
+    // crystal can be recovered through the ratio.
+    if (tsc_leaf && tsc_leaf->a != 0 && tsc_leaf->b != 0) {
+        const struct cpuid_leaf *freq_leaf =
+                x86_get_cpuid_leaf(X86_CPUID_PROCESSOR_FREQUENCY);
+        if (freq_leaf && (freq_leaf->a & 0xffff) != 0) {
+            const uint64_t base_freq = (uint64_t)(freq_leaf->a & 0xffff) * 1000 * 1000;
+            return (base_freq * tsc_leaf->a) / tsc_leaf->b;
+        }
+    }
+
     switch (x86_microarch) {
         case X86_MICROARCH_INTEL_SKYLAKE:
         case X86_MICROARCH_INTEL_KABYLAKE:
@@ -75,13 +88,23 @@ uint64_t x86_lookup_core_crystal_freq() {
 
 uint64_t x86_lookup_tsc_freq() {
     if (x86_vendor == X86_VENDOR_INTEL) {
-        const uint64_t core_crystal_clock_freq = x86_lookup_core_crystal_freq();
-
         // If this leaf is present, then 18.18.3 (Determining the Processor Base
         // Frequency) documents this as the nominal TSC frequency.
         const struct cpuid_leaf *tsc_leaf = x86_get_cpuid_leaf(X86_CPUID_TSC);
-        if (tsc_leaf) {
-            return (core_crystal_clock_freq * tsc_leaf->b) / tsc_leaf->a;
+        if (tsc_leaf && tsc_leaf->a != 0 && tsc_leaf->b != 0) {
+            const uint64_t core_crystal_clock_freq = x86_lookup_core_crystal_freq();
+            if (core_crystal_clock_freq != 0) {
+                return (core_crystal_clock_freq * tsc_leaf->b) / tsc_leaf->a;
+            }
+        }
+
+        // Without a usable ratio, leaf 0x16's processor base frequency is
+        // still the nominal TSC frequency, just enumerated in coarser MHz
+        // units.
+        const struct cpuid_leaf *freq_leaf =
+                x86_get_cpuid_leaf(X86_CPUID_PROCESSOR_FREQUENCY);
+        if (freq_leaf && (freq_leaf->a & 0xffff) != 0) {
+            return (uint64_t)(freq_leaf->a & 0xffff) * 1000 * 1000;
         }
     } else if (x86_vendor == X86_VENDOR_AMD) {
         uint32_t p0_state_msr = 0xc0010064; // base P-state MSR
@@ -17,6 +17,7 @@
 #include <reg.h>
 #include <kernel/thread.h>
 #include <kernel/stats.h>
+#include <kernel/tripwire.h>
 #include <lk/init.h>
 #include <dev/interrupt.h>
 #include <arch/ops.h>
@@ -252,12 +253,21 @@ static enum handler_return gic_handle_irq(struct iframe *frame)
     // deliver the interrupt
     enum handler_return ret;
 
+    lk_time_t irq_start = unlikely(tripwire_irq_ns) ? current_time() : 0;
+
     ret = INT_NO_RESCHEDULE;
     struct int_handler_struct* handler = pdev_get_int_handler(vector);
     if (handler->handler) {
         ret = handler->handler(handler->arg);
     }
 
+    if (unlikely(tripwire_irq_ns)) {
+        lk_time_t took = current_time() - irq_start;
+        if (took > tripwire_irq_ns) {
+            ktrace_probe2("tripwire_irq", vector, (uint32_t)(took / 1000u));
+        }
+    }
+
     GICREG(0, GICC_EOIR) = iar;
 
     LTRACEF_LEVEL(2, "cpu %u exit %u\n", cpu, ret);
@@ -12,6 +12,7 @@
 #include <dev/interrupt/arm_gic.h>
 #include <kernel/thread.h>
 #include <kernel/stats.h>
+#include <kernel/tripwire.h>
 #include <kernel/vm.h>
 #include <lk/init.h>
 #include <dev/interrupt.h>
@@ -276,11 +277,21 @@ static enum handler_return gic_handle_irq(iframe* frame) {
 
     // deliver the interrupt
     enum handler_return ret = INT_NO_RESCHEDULE;
+
+    lk_time_t irq_start = unlikely(tripwire_irq_ns) ? current_time() : 0;
+
     struct int_handler_struct* handler = pdev_get_int_handler(vector);
     if (handler->handler) {
         ret = handler->handler(handler->arg);
     }
 
+    if (unlikely(tripwire_irq_ns)) {
+        lk_time_t took = current_time() - irq_start;
+        if (took > tripwire_irq_ns) {
+            ktrace_probe2("tripwire_irq", vector, (uint32_t)(took / 1000u));
+        }
+    }
+
     gic_write_eoir(vector);
 
     LTRACEF_LEVEL(2, "cpu %u exit %u\n", cpu, ret);
@@ -57,6 +57,17 @@ constexpr uint8_t PCIE_CAP_ID_ENHANCED_ALLOCATION      = 0x14;
 
 #define PCIE_CAP_MSI_CTRL_SET_MME(val, ctrl)    (uint16_t)((ctrl & ~0x0070) | ((val & 0x7) << 4))
 #define PCIE_CAP_MSI_CTRL_SET_ENB(val, ctrl)    (uint16_t)((ctrl & ~0x0001) | (!!val))
+
+/**
+ * Structure definitions for capability PCIE_CAP_ID_MSIX
+ *
+ * @see The PCI Local Bus specification v3.0 Section 6.8.2
+ */
+#define PCIE_CAP_MSIX_CTRL_TABLE_SIZE(ctrl)      ((uint16_t)((ctrl & 0x07FF) + 1))
+#define PCIE_CAP_MSIX_CTRL_FMASK_ENABLED(ctrl)   ((ctrl & 0x4000) != 0)
+#define PCIE_CAP_MSIX_CTRL_GET_ENB(ctrl)         ((ctrl & 0x8000) != 0)
+#define PCIE_CAP_MSIX_CTRL_SET_FMASK(val, ctrl)  (uint16_t)((ctrl & ~0x4000) | ((!!val) << 14))
+#define PCIE_CAP_MSIX_CTRL_SET_ENB(val, ctrl)    (uint16_t)((ctrl & ~0x8000) | ((!!val) << 15))
 #define PCS_CAPS_V1_ENDPOINT_SIZE        ((uint)offsetof(pcie_capabilities_t, link))
 #define PCS_CAPS_V1_UPSTREAM_PORT_SIZE   ((uint)offsetof(pcie_capabilities_t, slot))
 #define PCS_CAPS_V1_DOWNSTREAM_PORT_SIZE ((uint)offsetof(pcie_capabilities_t, root))
@@ -255,6 +266,59 @@ private:
     PciReg32 pending_bits_;
 };
 
+/* MSI-X Interrupts.
+ * @see PCI Local Bus Spec v3.0 section 6.8.2
+ */
+class PciCapMsix : public PciStdCapability {
+public:
+    static constexpr uint16_t kControlOffset = 0x02;
+    static constexpr uint16_t kTableOffset   = 0x04;
+    static constexpr uint16_t kPbaOffset     = 0x08;
+    static constexpr uint16_t kMsixSize      = static_cast<uint16_t>(kPbaOffset + 4u);
+
+    /* Layout of a single entry in the BAR resident vector table.
+     * @see PCI Local Bus Spec v3.0 section 6.8.2.4 */
+    struct TableEntry {
+        uint32_t addr;
+        uint32_t addr_upper;
+        uint32_t data;
+        uint32_t vector_ctrl;
+    };
+    static constexpr uint32_t kVectorCtrlMaskBit = 0x00000001;
+
+    PciCapMsix(const PcieDevice& dev, uint16_t base, uint8_t id);
+    ~PciCapMsix();
+
+    // Accessors
+    unsigned int max_irqs() const { return max_irqs_; }
+    uint table_bar() const { return table_bar_; }
+    uint32_t table_offset() const { return table_offset_; }
+    uint pba_bar() const { return pba_bar_; }
+    uint32_t pba_offset() const { return pba_offset_; }
+    PciReg16 ctrl_reg() const { return ctrl_; }
+
+private:
+    // TODO(cja): Dragons here as well.  Just like PciCapMsi, the irq_block_
+    // (and the vector table mapping) are managed by PcieDevice rather than by
+    // the capability itself.  This should be refactored along with MSI.
+    friend class PcieDevice;
+    unsigned int max_irqs_ = 0;
+    uint     table_bar_ = 0;
+    uint32_t table_offset_ = 0;
+    uint     pba_bar_ = 0;
+    uint32_t pba_offset_ = 0;
+    pcie_msi_block_t irq_block_;
+
+    /* Kernel mapping of the pages which back the vector table, and the
+     * (sub-page adjusted) pointer to the table itself.  Established by
+     * PcieDevice when entering MSI-X mode. */
+    void* table_mapping_ = nullptr;
+    volatile TableEntry* table_ = nullptr;
+
+    // Cached registers
+    PciReg16 ctrl_;
+};
+
 /* PCI Express Capability classes */
 
 class PciCapPcie : public PciStdCapability {
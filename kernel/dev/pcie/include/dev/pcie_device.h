@@ -280,6 +280,30 @@ public:
      */
     status_t MaskUnmaskIrq(uint irq_id, bool mask);
 
+    /**
+     * Direct delivery of the specified IRQ at a particular CPU.
+     *
+     * Only supported while operating in MSI-X mode; each entry in the vector
+     * table carries its own target address, so vectors may be spread across
+     * CPUs (for example, one completion queue per core).  MSI and legacy
+     * vectors share a single target and cannot be re-directed individually.
+     *
+     * @param irq_id The ID of the IRQ to re-target.
+     * @param cpu_num The kernel CPU number the IRQ should be delivered to.
+     *
+     * @return A status_t indicating the success or failure of the operation.
+     * Status codes may include (but are not limited to)...
+     *
+     * ++ MX_ERR_BAD_STATE
+     *    The device is in DISABLED IRQ mode.
+     * ++ MX_ERR_INVALID_ARGS
+     *    The irq_id or cpu_num parameter is out of range.
+     * ++ MX_ERR_NOT_SUPPORTED
+     *    The device is not operating in MSI-X mode, or the platform cannot
+     *    compute per-CPU message targets.
+     */
+    status_t SetIrqAffinity(uint irq_id, uint cpu_num);
+
     void SetQuirksDone() { quirks_done_ = true; }
 
     /**
@@ -419,6 +443,29 @@ private:
     enum handler_return        MsiIrqHandler(pcie_irq_handler_state_t& hstate);
     static enum handler_return MsiIrqHandlerThunk(void *arg);
 
+    // Internal MSI-X IRQ support.
+    void SetMsixCtrl(bool enb, bool function_mask) {
+        DEBUG_ASSERT(irq_.msix);
+        DEBUG_ASSERT(irq_.msix->is_valid());
+        uint16_t ctrl = cfg_->Read(irq_.msix->ctrl_reg());
+        ctrl = PCIE_CAP_MSIX_CTRL_SET_ENB(enb, ctrl);
+        ctrl = PCIE_CAP_MSIX_CTRL_SET_FMASK(function_mask, ctrl);
+        cfg_->Write(irq_.msix->ctrl_reg(), ctrl);
+    }
+
+    bool     MaskUnmaskMsixIrqLocked(uint irq_id, bool mask);
+    status_t MaskUnmaskMsixIrq(uint irq_id, bool mask);
+    void     MaskAllMsixVectors();
+    status_t MapMsixTableLocked();
+    void     UnmapMsixTableLocked();
+    void     FreeMsixBlock();
+    void     LeaveMsixIrqMode();
+    status_t EnterMsixIrqMode(uint requested_irqs);
+    status_t SetIrqAffinityLocked(uint irq_id, uint cpu_num);
+
+    enum handler_return        MsixIrqHandler(pcie_irq_handler_state_t& hstate);
+    static enum handler_return MsixIrqHandlerThunk(void *arg);
+
     // Common Internal IRQ support.
     void     ResetCommonIrqBookkeeping();
     status_t AllocIrqHandlers(uint requested_irqs, bool is_masked);
@@ -453,7 +500,6 @@ private:
         } legacy;
 
         PciCapMsi* msi = nullptr;
-        /* TODO(johngro) : Add MSI-X state */
-        struct { } msi_x;
+        PciCapMsix* msix = nullptr;
     } irq_;
 };
@@ -129,6 +129,22 @@ public:
         DEBUG_ASSERT(false);
     }
 
+    /**
+     * Method used to compute the MSI target address which will deliver
+     * messages to a specific CPU.  Used by the bus driver to spread MSI-X
+     * vectors across CPUs; each entry in an MSI-X vector table carries its own
+     * target address, so individual vectors may be pinned to individual CPUs.
+     *
+     * @param cpu_num The kernel CPU number the messages should be delivered to.
+     * @param out_tgt_addr A pointer which, upon success, will hold the target
+     *        write transaction physical address for the requested CPU.
+     *
+     * @return A status code indicating the success or failure of the operation.
+     */
+    virtual status_t MsiTargetForCpu(uint cpu_num, uint64_t* out_tgt_addr) {
+        return MX_ERR_NOT_SUPPORTED;
+    }
+
     /**
      * Method used for masking/unmaskingof MSI handlers at the platform level.
      *
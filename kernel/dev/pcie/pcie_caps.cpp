@@ -12,6 +12,7 @@
 #include <trace.h>
 #include <dev/pci_config.h>
 #include <dev/pcie_device.h>
+#include <kernel/vm/vm_aspace.h>
 
 #include <mxalloc/new.h>
 
@@ -255,6 +256,66 @@ PciCapMsi::PciCapMsi(const PcieDevice& dev, uint16_t base, uint8_t id)
     is_valid_ = true;
 }
 
+/*
+ * @see PCI Local Bus Specification 3.0 Section 6.8.2
+ */
+PciCapMsix::PciCapMsix(const PcieDevice& dev, uint16_t base, uint8_t id)
+    : PciStdCapability(dev, base, id) {
+    DEBUG_ASSERT(id == PCIE_CAP_ID_MSIX);
+    auto cfg = dev.config();
+
+    ctrl_ = PciReg16(static_cast<uint16_t>(base_ + kControlOffset));
+
+    uint16_t msix_end = static_cast<uint16_t>(base_ + kMsixSize);
+    if (msix_end >= PCIE_BASE_CONFIG_SIZE) {
+        TRACEF("Device %02x:%02x.%01x (%04hx:%04hx) has illegally positioned MSI-X "
+               "capability structure.  Structure ends at %u, past the end of "
+               "standard config space\n",
+               dev.bus_id(), dev.dev_id(), dev.func_id(),
+               dev.vendor_id(), dev.device_id(), msix_end);
+        return;
+    }
+
+    uint16_t ctrl = cfg->Read(ctrl_reg());
+    max_irqs_     = PCIE_CAP_MSIX_CTRL_TABLE_SIZE(ctrl);
+    DEBUG_ASSERT(max_irqs_ <= PCIE_MAX_MSIX_IRQS);
+
+    /* The vector table and pending bit array each live at an offset within one
+     * of the device's BARs.  The BAR index lives in the low 3 bits of each
+     * register, the (8 byte aligned) offset in the rest. */
+    uint32_t table_val = cfg->Read(PciReg32(static_cast<uint16_t>(base_ + kTableOffset)));
+    uint32_t pba_val   = cfg->Read(PciReg32(static_cast<uint16_t>(base_ + kPbaOffset)));
+    table_bar_    = table_val & 0x7;
+    table_offset_ = table_val & ~0x7u;
+    pba_bar_      = pba_val & 0x7;
+    pba_offset_   = pba_val & ~0x7u;
+
+    if ((table_bar_ >= PCIE_MAX_BAR_REGS) || (pba_bar_ >= PCIE_MAX_BAR_REGS)) {
+        TRACEF("Device %02x:%02x.%01x (%04hx:%04hx) has invalid MSI-X BAR "
+               "indicators (table %u, PBA %u)\n",
+               dev.bus_id(), dev.dev_id(), dev.func_id(),
+               dev.vendor_id(), dev.device_id(), table_bar_, pba_bar_);
+        return;
+    }
+
+    memset(&irq_block_, 0, sizeof(irq_block_));
+
+    /* Success!  Make sure that MSI-X starts out disabled with the entire
+     * function masked, then record our capabilities in the device's
+     * bookkeeping and we are done. */
+    cfg->Write(ctrl_reg(), PCIE_CAP_MSIX_CTRL_SET_FMASK(1,
+                           PCIE_CAP_MSIX_CTRL_SET_ENB(0, ctrl)));
+    is_valid_ = true;
+}
+
+PciCapMsix::~PciCapMsix() {
+    /* The vector table mapping should have been torn down when the device left
+     * MSI-X mode, but make certain we do not leak it if the device goes away
+     * while the mode is still active. */
+    if (table_mapping_ != nullptr)
+        VmAspace::kernel_aspace()->FreeRegion(reinterpret_cast<vaddr_t>(table_mapping_));
+}
+
 /* Catch quirks and invalid capability offsets we may see */
 inline status_t validate_capability_offset(uint8_t offset) {
     if (offset == 0xFF
@@ -315,6 +376,8 @@ status_t PcieDevice::ParseStdCapabilitiesLocked() {
         switch(id) {
             case PCIE_CAP_ID_MSI:
                 cap = irq_.msi = new (&ac) PciCapMsi(*this, cap_offset, id); break;
+            case PCIE_CAP_ID_MSIX:
+                cap = irq_.msix = new (&ac) PciCapMsix(*this, cap_offset, id); break;
             case PCIE_CAP_ID_PCI_EXPRESS:
                 cap = pcie_ = new (&ac) PciCapPcie(*this, cap_offset, id); break;
             case PCIE_CAP_ID_ADVANCED_FEATURES:
@@ -15,8 +15,10 @@
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/vm.h>
+#include <kernel/vm/vm_aspace.h>
 #include <list.h>
 #include <pow2.h>
+#include <stdlib.h>
 #include <string.h>
 #include <trace.h>
 
@@ -530,6 +532,318 @@ enum handler_return PcieDevice::MsiIrqHandlerThunk(void *arg) {
     return hstate.dev->MsiIrqHandler(hstate);
 }
 
+/******************************************************************************
+ *
+ * MSI-X IRQ mode routines.
+ *
+ ******************************************************************************/
+bool PcieDevice::MaskUnmaskMsixIrqLocked(uint irq_id, bool mask) {
+    DEBUG_ASSERT(irq_.mode == PCIE_IRQ_MODE_MSI_X);
+    DEBUG_ASSERT(irq_id < irq_.handler_count);
+    DEBUG_ASSERT(irq_.handlers);
+    DEBUG_ASSERT(irq_.msix && irq_.msix->table_);
+
+    pcie_irq_handler_state_t& hstate = irq_.handlers[irq_id];
+    DEBUG_ASSERT(hstate.lock.IsHeld());
+
+    /* MSI-X always supports masking at the PCI device level via the vector
+     * control word of the table entry. */
+    volatile PciCapMsix::TableEntry* entry = irq_.msix->table_ + irq_id;
+    uint32_t ctrl = entry->vector_ctrl;
+    if (mask) ctrl |=  PciCapMsix::kVectorCtrlMaskBit;
+    else      ctrl &= ~PciCapMsix::kVectorCtrlMaskBit;
+    entry->vector_ctrl = ctrl;
+
+    /* Read the control word back to make certain the write has posted before
+     * we consider the vector to be masked. */
+    entry->vector_ctrl;
+
+    /* If we can mask at the platform interrupt controller level as well, do so. */
+    DEBUG_ASSERT(irq_.msix->irq_block_.allocated);
+    DEBUG_ASSERT(irq_id < irq_.msix->irq_block_.num_irq);
+    if (bus_drv_.platform().supports_msi_masking())
+        bus_drv_.platform().MaskUnmaskMsi(&irq_.msix->irq_block_, irq_id, mask);
+
+    bool ret = hstate.masked;
+    hstate.masked = mask;
+    return ret;
+}
+
+status_t PcieDevice::MaskUnmaskMsixIrq(uint irq_id, bool mask) {
+    if (irq_id >= irq_.handler_count)
+        return MX_ERR_INVALID_ARGS;
+
+    DEBUG_ASSERT(irq_.handlers);
+
+    {
+        AutoSpinLockIrqSave handler_lock(&irq_.handlers[irq_id].lock);
+        MaskUnmaskMsixIrqLocked(irq_id, mask);
+    }
+
+    return MX_OK;
+}
+
+void PcieDevice::MaskAllMsixVectors() {
+    DEBUG_ASSERT(irq_.msix);
+    DEBUG_ASSERT(irq_.msix->is_valid());
+    DEBUG_ASSERT(irq_.msix->table_);
+
+    /* Mask every entry in the table, not just the ones we have handlers
+     * allocated for. */
+    for (uint i = 0; i < irq_.msix->max_irqs(); i++)
+        irq_.msix->table_[i].vector_ctrl |= PciCapMsix::kVectorCtrlMaskBit;
+}
+
+status_t PcieDevice::MapMsixTableLocked() {
+    DEBUG_ASSERT(irq_.msix);
+    DEBUG_ASSERT(irq_.msix->is_valid());
+
+    if (irq_.msix->table_ != nullptr)
+        return MX_OK;
+
+    /* The vector table lives at an offset within one of our MMIO BARs.  We
+     * cannot map it until the BAR has been allocated a bus address. */
+    const pcie_bar_info_t* info = GetBarInfo(irq_.msix->table_bar());
+    if ((info == nullptr) || !info->is_mmio)
+        return MX_ERR_BAD_STATE;
+
+    size_t table_size = irq_.msix->max_irqs() * sizeof(PciCapMsix::TableEntry);
+    if ((irq_.msix->table_offset() + table_size) > info->size)
+        return MX_ERR_BAD_STATE;
+
+    /* Map the pages which back the table, then adjust for the sub-page offset
+     * of the table within its first page.  Note: BAR bus addresses are system
+     * physical addresses on all platforms we currently support. */
+    paddr_t table_phys = static_cast<paddr_t>(info->bus_addr) + irq_.msix->table_offset();
+    paddr_t map_phys   = ROUNDDOWN(table_phys, PAGE_SIZE);
+    size_t  map_size   = ROUNDUP((table_phys - map_phys) + table_size, PAGE_SIZE);
+
+    char name_buf[32];
+    snprintf(name_buf, sizeof(name_buf), "msix_%02x_%02x_%01x", bus_id_, dev_id_, func_id_);
+
+    void* vaddr;
+    status_t res = VmAspace::kernel_aspace()->AllocPhysical(
+            name_buf,
+            map_size,
+            &vaddr,
+            PAGE_SIZE_SHIFT,
+            map_phys,
+            0 /* vmm flags */,
+            ARCH_MMU_FLAG_UNCACHED_DEVICE |
+            ARCH_MMU_FLAG_PERM_READ |
+            ARCH_MMU_FLAG_PERM_WRITE);
+    if (res != MX_OK) {
+        TRACEF("Failed to map MSI-X table for device %02x:%02x.%01x (res %d)\n",
+               bus_id_, dev_id_, func_id_, res);
+        return res;
+    }
+
+    irq_.msix->table_mapping_ = vaddr;
+    irq_.msix->table_ = reinterpret_cast<volatile PciCapMsix::TableEntry*>(
+            static_cast<uint8_t*>(vaddr) + (table_phys - map_phys));
+    return MX_OK;
+}
+
+void PcieDevice::UnmapMsixTableLocked() {
+    if (irq_.msix->table_mapping_ == nullptr)
+        return;
+
+    VmAspace::kernel_aspace()->FreeRegion(
+            reinterpret_cast<vaddr_t>(irq_.msix->table_mapping_));
+    irq_.msix->table_mapping_ = nullptr;
+    irq_.msix->table_ = nullptr;
+}
+
+void PcieDevice::FreeMsixBlock() {
+    /* If no block has been allocated, there is nothing to do */
+    if (!irq_.msix->irq_block_.allocated)
+        return;
+
+    DEBUG_ASSERT(bus_drv_.platform().supports_msi());
+
+    /* Mask the IRQ at the platform interrupt controller level if we can, and
+     * unregister any registered handler. */
+    const pcie_msi_block_t* b = &irq_.msix->irq_block_;
+    for (uint i = 0; i < b->num_irq; i++) {
+        if (bus_drv_.platform().supports_msi_masking()) {
+            bus_drv_.platform().MaskUnmaskMsi(b, i, true);
+        }
+        bus_drv_.platform().RegisterMsiHandler(b, i, nullptr, nullptr);
+    }
+
+    /* Give the block of IRQs back to the platform */
+    bus_drv_.platform().FreeMsiBlock(&irq_.msix->irq_block_);
+    DEBUG_ASSERT(!irq_.msix->irq_block_.allocated);
+}
+
+void PcieDevice::LeaveMsixIrqMode() {
+    /* Disable MSI-X at the top level and mask everything at the function
+     * level while we tear things down. */
+    SetMsixCtrl(false, true);
+    if (irq_.msix->table_)
+        MaskAllMsixVectors();
+
+    /* Return any allocated irq block to the platform, unregistering with
+     * the interrupt controller and synchronizing with the dispatchers in
+     * the process, then release our mapping of the vector table. */
+    FreeMsixBlock();
+    UnmapMsixTableLocked();
+
+    /* Reset our common state, free any allocated handlers */
+    ResetCommonIrqBookkeeping();
+}
+
+status_t PcieDevice::EnterMsixIrqMode(uint requested_irqs) {
+    DEBUG_ASSERT(requested_irqs);
+
+    status_t res = MX_OK;
+
+    // We cannot go into MSI-X mode if we don't support MSI-X at all, or we
+    // don't support the number of IRQs requested.  Note that the platform
+    // hands out contiguous blocks of vectors, which limits us to a smaller
+    // allocation than the 2048 vectors the table could describe.
+    if (!irq_.msix                            ||
+        !irq_.msix->is_valid()                ||
+        !bus_drv_.platform().supports_msi()   ||
+        (requested_irqs > irq_.msix->max_irqs()) ||
+        (requested_irqs > PCIE_MAX_MSI_IRQS))
+        return MX_ERR_NOT_SUPPORTED;
+
+    /* Map the vector table into the kernel's address space, then make certain
+     * that every vector is masked before we start to configure anything. */
+    res = MapMsixTableLocked();
+    if (res != MX_OK)
+        return res;
+
+    SetMsixCtrl(false, true);
+    MaskAllMsixVectors();
+
+    /* Ask the platform for a chunk of MSI compatible IRQs */
+    DEBUG_ASSERT(!irq_.msix->irq_block_.allocated);
+    res = bus_drv_.platform().AllocMsiBlock(requested_irqs,
+                                            true,   /* can_target_64bit */
+                                            true,   /* is_msix */
+                                            &irq_.msix->irq_block_);
+    if (res != MX_OK) {
+        LTRACEF("Failed to allocate a block of %u MSI-X IRQs for device "
+                "%02x:%02x.%01x (res %d)\n",
+                requested_irqs, bus_id_, dev_id_, func_id_, res);
+        goto bailout;
+    }
+
+    /* Allocate our handler table.  MSI-X vectors are always maskable via
+     * their vector control word, so they all start out masked. */
+    res = AllocIrqHandlers(requested_irqs, true);
+    if (res != MX_OK)
+        goto bailout;
+
+    /* Record our new IRQ mode */
+    irq_.mode = PCIE_IRQ_MODE_MSI_X;
+
+    /* Program the target write transaction into each entry of the vector
+     * table.  Unlike MSI, each vector carries its own address/data pair; the
+     * platform block hands out consecutive data values starting at tgt_data.
+     * Every entry remains masked until a handler is registered and the vector
+     * is explicitly unmasked. */
+    DEBUG_ASSERT(irq_.handler_count <= irq_.msix->irq_block_.num_irq);
+    for (uint i = 0; i < irq_.handler_count; ++i) {
+        volatile PciCapMsix::TableEntry* entry = irq_.msix->table_ + i;
+        entry->addr       = static_cast<uint32_t>(irq_.msix->irq_block_.tgt_addr & 0xFFFFFFFF);
+        entry->addr_upper = static_cast<uint32_t>(irq_.msix->irq_block_.tgt_addr >> 32);
+        entry->data       = irq_.msix->irq_block_.tgt_data + i;
+    }
+
+    /* Register each IRQ with the dispatcher */
+    for (uint i = 0; i < irq_.handler_count; ++i) {
+        bus_drv_.platform().RegisterMsiHandler(&irq_.msix->irq_block_,
+                                               i,
+                                               PcieDevice::MsixIrqHandlerThunk,
+                                               irq_.handlers + i);
+    }
+
+    /* Enable MSI-X at the top level and clear the function mask.  Individual
+     * vectors are still masked at this point. */
+    SetMsixCtrl(true, false);
+
+bailout:
+    if (res != MX_OK)
+        LeaveMsixIrqMode();
+
+    return res;
+}
+
+status_t PcieDevice::SetIrqAffinityLocked(uint irq_id, uint cpu_num) {
+    DEBUG_ASSERT(plugged_in_);
+    DEBUG_ASSERT(dev_lock_.IsHeld());
+
+    if (irq_.mode == PCIE_IRQ_MODE_DISABLED)
+        return MX_ERR_BAD_STATE;
+
+    /* Only MSI-X vectors carry individual target addresses.  Legacy and MSI
+     * vectors share a single target and cannot be re-directed one at a time. */
+    if (irq_.mode != PCIE_IRQ_MODE_MSI_X)
+        return MX_ERR_NOT_SUPPORTED;
+
+    if (irq_id >= irq_.handler_count)
+        return MX_ERR_INVALID_ARGS;
+
+    uint64_t tgt_addr;
+    status_t res = bus_drv_.platform().MsiTargetForCpu(cpu_num, &tgt_addr);
+    if (res != MX_OK)
+        return res;
+
+    DEBUG_ASSERT(irq_.msix && irq_.msix->table_);
+    pcie_irq_handler_state_t& hstate = irq_.handlers[irq_id];
+
+    {
+        /* Mask the vector while we swap the address out from under it, then
+         * restore its previous mask state.  The data (vector number) does not
+         * change; only the destination does. */
+        AutoSpinLockIrqSave handler_lock(&hstate.lock);
+        bool was_masked = MaskUnmaskMsixIrqLocked(irq_id, true);
+
+        volatile PciCapMsix::TableEntry* entry = irq_.msix->table_ + irq_id;
+        entry->addr       = static_cast<uint32_t>(tgt_addr & 0xFFFFFFFF);
+        entry->addr_upper = static_cast<uint32_t>(tgt_addr >> 32);
+
+        if (!was_masked)
+            MaskUnmaskMsixIrqLocked(irq_id, false);
+    }
+
+    return MX_OK;
+}
+
+enum handler_return PcieDevice::MsixIrqHandler(pcie_irq_handler_state_t& hstate) {
+    DEBUG_ASSERT(irq_.msix);
+    /* No need to save IRQ state; we are in an IRQ handler at the moment. */
+    AutoSpinLock handler_lock(&hstate.lock);
+
+    /* Mask our IRQ.  MSI-X vectors are always maskable. */
+    bool was_masked = MaskUnmaskMsixIrqLocked(hstate.pci_irq_id, true);
+
+    /* If the IRQ was masked or the handler removed by the time we got here,
+     * leave the IRQ masked, unlock and get out. */
+    if (was_masked || !hstate.handler)
+        return INT_NO_RESCHEDULE;
+
+    /* Dispatch */
+    pcie_irq_handler_retval_t irq_ret = hstate.handler(*this, hstate.pci_irq_id, hstate.ctx);
+
+    /* Re-enable the IRQ if asked to do so */
+    if (!(irq_ret & PCIE_IRQRET_MASK))
+        MaskUnmaskMsixIrqLocked(hstate.pci_irq_id, false);
+
+    /* Request a reschedule if asked to do so */
+    return (irq_ret & PCIE_IRQRET_RESCHED) ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
+}
+
+enum handler_return PcieDevice::MsixIrqHandlerThunk(void *arg) {
+    DEBUG_ASSERT(arg);
+    auto& hstate = *(reinterpret_cast<pcie_irq_handler_state_t*>(arg));
+    DEBUG_ASSERT(hstate.dev);
+    return hstate.dev->MsixIrqHandler(hstate);
+}
+
 /******************************************************************************
  *
  * Internal implementation of the Kernel facing API.
@@ -578,13 +892,22 @@ status_t PcieDevice::QueryIrqModeCapabilitiesLocked(pcie_irq_mode_t mode,
         break;
 
     case PCIE_IRQ_MODE_MSI_X:
-        /* If the platform does not support MSI, then we don't support MSI,
+        /* If the platform does not support MSI, then we don't support MSI-X,
          * even if the device does. */
         if (!bus_drv_.platform().supports_msi())
             return MX_ERR_NOT_SUPPORTED;
 
-        /* TODO(johngro) : finish MSI-X implementation. */
-        return MX_ERR_NOT_SUPPORTED;
+        /* If the device supports MSI-X, it will have a pointer to the control
+         * structure in config. */
+        if (!irq_.msix || !irq_.msix->is_valid())
+            return MX_ERR_NOT_SUPPORTED;
+
+        /* MSI-X vectors are always maskable via their per-vector control
+         * word.  The platform hands out contiguous blocks of vectors, which
+         * caps the usable count below what the table could describe. */
+        out_caps->max_irqs = mxtl::min<uint>(irq_.msix->max_irqs(), PCIE_MAX_MSI_IRQS);
+        out_caps->per_vector_masking_supported = true;
+        break;
 
     default:
         return MX_ERR_INVALID_ARGS;
@@ -640,10 +963,15 @@ status_t PcieDevice::SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_irqs)
             DEBUG_ASSERT(!irq_.registered_handler_count);
             return MX_OK;
 
-        /* Right now, there should be no way to get into MSI-X mode */
         case PCIE_IRQ_MODE_MSI_X:
-            DEBUG_ASSERT(false);
-            return MX_ERR_NOT_SUPPORTED;
+            DEBUG_ASSERT(irq_.msix);
+            DEBUG_ASSERT(irq_.msix->is_valid());
+            DEBUG_ASSERT(irq_.msix->irq_block_.allocated);
+
+            LeaveMsixIrqMode();
+
+            DEBUG_ASSERT(!irq_.registered_handler_count);
+            return MX_OK;
 
         default:
             /* mode is not one of the valid enum values, this should be impossible */
@@ -664,7 +992,7 @@ status_t PcieDevice::SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_irqs)
     switch (mode) {
     case PCIE_IRQ_MODE_LEGACY: return EnterLegacyIrqMode(requested_irqs);
     case PCIE_IRQ_MODE_MSI:    return EnterMsiIrqMode   (requested_irqs);
-    case PCIE_IRQ_MODE_MSI_X:  return MX_ERR_NOT_SUPPORTED;
+    case PCIE_IRQ_MODE_MSI_X:  return EnterMsixIrqMode  (requested_irqs);
     default:                   return MX_ERR_INVALID_ARGS;
     }
 }
@@ -735,7 +1063,7 @@ status_t PcieDevice::MaskUnmaskIrqLocked(uint irq_id, bool mask) {
     switch (irq_.mode) {
     case PCIE_IRQ_MODE_LEGACY: return MaskUnmaskLegacyIrq(mask);
     case PCIE_IRQ_MODE_MSI:    return MaskUnmaskMsiIrq(irq_id, mask);
-    case PCIE_IRQ_MODE_MSI_X:  return MX_ERR_NOT_SUPPORTED;
+    case PCIE_IRQ_MODE_MSI_X:  return MaskUnmaskMsixIrq(irq_id, mask);
     default:
         DEBUG_ASSERT(false); /* This should be un-possible! */
         return MX_ERR_INTERNAL;
@@ -796,6 +1124,14 @@ status_t PcieDevice::MaskUnmaskIrq(uint irq_id, bool mask) {
         : MX_ERR_BAD_STATE;
 }
 
+status_t PcieDevice::SetIrqAffinity(uint irq_id, uint cpu_num) {
+    AutoLock dev_lock(&dev_lock_);
+
+    return (plugged_in_ && !disabled_)
+        ? SetIrqAffinityLocked(irq_id, cpu_num)
+        : MX_ERR_BAD_STATE;
+}
+
 
 // Map from a device's interrupt pin ID to the proper system IRQ ID.  Follow the
 // PCIe graph up to the root, swizzling as we traverse PCIe switches,
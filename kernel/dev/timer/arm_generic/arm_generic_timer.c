@@ -46,6 +46,10 @@
 #define TIMER_REG_CNTV_TVAL cntv_tval_el0
 #define TIMER_REG_CNTVCT    cntvct_el0
 
+/* CNTKCTL_EL1 bits controlling EL0 counter access */
+#define CNTKCTL_EL0PCTEN    (1 << 0)
+#define CNTKCTL_EL0VCTEN    (1 << 1)
+
 static int timer_irq;
 
 struct fp_32_64 cntpct_per_ns;
@@ -243,6 +247,30 @@ uint64_t ticks_per_second(void)
     return u64_mul_u32_fp32_64(1000 * 1000 * 1000, cntpct_per_ns);
 }
 
+mono_ticks_source_t platform_usermode_ticks_source(struct fp_32_64 *ns_per_tick)
+{
+    /* no conversion factor to export if the timer never initialized */
+    if ((ns_per_cntpct.l0 | ns_per_cntpct.l32 | ns_per_cntpct.l64) == 0)
+        return MONO_TICKS_SYSCALL;
+
+    *ns_per_tick = ns_per_cntpct;
+    return (reg_procs->read_ct == read_cntvct) ? MONO_TICKS_CNTVCT
+                                               : MONO_TICKS_CNTPCT;
+}
+
+/* let EL0 read the counter that current_time() is based on, so the vDSO
+ * can compute the monotonic clock without a syscall; must run on every
+ * cpu since CNTKCTL_EL1 is per-cpu state */
+static void enable_usermode_counter_access(void)
+{
+    uint64_t cntkctl = ARM64_READ_SYSREG(cntkctl_el1);
+    if (reg_procs->read_ct == read_cntvct)
+        cntkctl |= CNTKCTL_EL0VCTEN;
+    else
+        cntkctl |= CNTKCTL_EL0PCTEN;
+    ARM64_WRITE_SYSREG(cntkctl_el1, cntkctl);
+}
+
 static uint32_t abs_int32(int32_t a)
 {
     return (a > 0) ? a : -a;
@@ -345,6 +373,8 @@ void arm_generic_timer_init(int irq, uint32_t freq_override)
     register_int_handler(irq, &platform_tick, NULL);
     unmask_interrupt(irq);
 
+    enable_usermode_counter_access();
+
     timer_irq = irq;
 }
 
@@ -352,6 +382,8 @@ static void arm_generic_timer_init_secondary_cpu(uint level)
 {
     LTRACEF("unmask irq %d on cpu %u\n", timer_irq, arch_curr_cpu_num());
     unmask_interrupt(timer_irq);
+
+    enable_usermode_counter_access();
 }
 
 /* secondary cpu initialize the timer just before the kernel starts with interrupts enabled */
@@ -364,6 +396,8 @@ static void arm_generic_timer_resume_cpu(uint level)
     /* Always trigger a timer interrupt on each cpu for now */
     write_tval(0);
     write_ctl(1);
+
+    enable_usermode_counter_access();
 }
 
 LK_INIT_HOOK_FLAGS(arm_generic_timer_resume_cpu, arm_generic_timer_resume_cpu,
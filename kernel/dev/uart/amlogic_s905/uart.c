@@ -67,6 +67,7 @@
 #define UARTREG(base, reg)  (*(volatile uint32_t*)((base)  + (reg)))
 
 #define RXBUF_SIZE 128
+#define TXBUF_SIZE 256
 #define NUM_UART 5
 
 #define S905_UART0_OFFSET          (0x011084c0)
@@ -77,12 +78,34 @@
 
 
 
-static cbuf_t uart_rx_buf;
+// Receive is a single-producer (rx irq), single-consumer (console
+// reader) stream, so it rides the lock-free ring.
+static cbuf_spsc_t uart_rx_buf;
 static bool initialized = false;
 static uintptr_t s905_uart_base = 0;
 static uint32_t s905_uart_irq = 0;
 
+// Transmit is interrupt driven: putc queues into uart_tx_buf and the
+// tx fifo-level irq moves the data into the hardware fifo, so callers
+// never spin on fifo space with interrupts disabled.
+static cbuf_t uart_tx_buf;
+static spin_lock_t uart_tx_lock = SPIN_LOCK_INITIAL_VALUE;
 
+/* move buffered tx data into the hardware fifo; runs with uart_tx_lock held */
+static void s905_uart_tx_drain(void)
+{
+    char c;
+    while ((UARTREG(s905_uart_base, S905_UART_STATUS) & S905_UART_STATUS_TXFULL) == 0) {
+        if (cbuf_read_char(&uart_tx_buf, &c, false) != 1) {
+            /* nothing left to send; mask the tx irq */
+            UARTREG(s905_uart_base, S905_UART_CONTROL) &= ~S905_UART_CONTROL_TXINTEN;
+            return;
+        }
+        UARTREG(s905_uart_base, S905_UART_WFIFO) = c;
+    }
+    /* fifo filled to depth; let the tx irq drain the rest */
+    UARTREG(s905_uart_base, S905_UART_CONTROL) |= S905_UART_CONTROL_TXINTEN;
+}
 
 static enum handler_return uart_irq(void *arg)
 {
@@ -91,13 +114,17 @@ static enum handler_return uart_irq(void *arg)
     /* read interrupt status and mask */
 
     while ( (UARTREG(base, S905_UART_STATUS) & S905_UART_STATUS_RXCOUNT_MASK) > 0 ) {
-        if (cbuf_space_avail(&uart_rx_buf) == 0) {
+        if (cbuf_spsc_space_avail(&uart_rx_buf) == 0) {
                 break;
         }
         char c = UARTREG(base, S905_UART_RFIFO);
-        cbuf_write_char(&uart_rx_buf, c, false);
+        cbuf_spsc_write_char(&uart_rx_buf, c, false);
     }
 
+    spin_lock(&uart_tx_lock);
+    s905_uart_tx_drain();
+    spin_unlock(&uart_tx_lock);
+
     return true;
 }
 
@@ -106,8 +133,9 @@ static void s905_uart_init(mdi_node_ref_t* node, uint level)
         assert(s905_uart_base);
         assert(s905_uart_irq);
 
-        // create circular buffer to hold received data
-        cbuf_initialize(&uart_rx_buf, RXBUF_SIZE);
+        // create circular buffers to hold received and pending transmit data
+        cbuf_spsc_initialize(&uart_rx_buf, RXBUF_SIZE);
+        cbuf_initialize(&uart_tx_buf, TXBUF_SIZE);
 
         //reset the port
         UARTREG(s905_uart_base,S905_UART_CONTROL) |=  S905_UART_CONTROL_RSTRX |
@@ -124,7 +152,9 @@ static void s905_uart_init(mdi_node_ref_t* node, uint level)
                                                      S905_UART_CONTROL_RXINTEN |
                                                      S905_UART_CONTROL_TWOWIRE;
 
-        // Set to interrupt every 1 rx byte
+        // Set to interrupt every 1 rx byte, and when the tx fifo
+        // drains to 1 byte (the tx interrupt stays masked until
+        // buffered transmit data is pending)
         uint32_t temp2 = UARTREG(s905_uart_base,S905_UART_IRQ_CONTROL);
         temp2 &= 0xffff0000;
         temp2 |= (1 << 8) | ( 1 );
@@ -170,10 +200,26 @@ static int s905_uart_putc(char c)
     if (!s905_uart_base)
         return 0;
 
-    /* spin while fifo is full */
-    while (UARTREG(s905_uart_base, S905_UART_STATUS) & S905_UART_STATUS_TXFULL)
-        ;
-    UARTREG(s905_uart_base, S905_UART_WFIFO) = c;
+    if (!initialized) {
+        //Interupts not online yet, use the panic calls for now.
+        return s905_uart_pputc(c);
+    }
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&uart_tx_lock, state);
+
+    /* if the buffer is full, drain it into the fifo here rather than
+     * waiting on a tx irq that may be masked on this cpu */
+    while (cbuf_space_avail(&uart_tx_buf) == 0) {
+        while (UARTREG(s905_uart_base, S905_UART_STATUS) & S905_UART_STATUS_TXFULL)
+            ;
+        s905_uart_tx_drain();
+    }
+
+    cbuf_write_char(&uart_tx_buf, c, false);
+    s905_uart_tx_drain();
+
+    spin_unlock_irqrestore(&uart_tx_lock, state);
 
     return 1;
 }
@@ -186,7 +232,7 @@ static int s905_uart_getc(bool wait)
     if (initialized) {
         // do cbuf stuff here
         char c;
-        if (cbuf_read_char(&uart_rx_buf, &c, false) == 1)
+        if (cbuf_spsc_read_char(&uart_rx_buf, &c, false) == 1)
             return c;
         return -1;
 
@@ -21,8 +21,17 @@
 #include <pdev/uart.h>
 
 #define RXBUF_SIZE 16
+#define TXBUF_SIZE 256
 
-static cbuf_t uart_rx_buf;
+// Receive is a single-producer (rx irq), single-consumer (console
+// reader) stream, so it rides the lock-free ring.
+static cbuf_spsc_t uart_rx_buf;
+
+// Transmit is interrupt driven: putc queues into uart_tx_buf and the
+// tx-empty irq moves the data into the hardware fifo, so callers never
+// spin on fifo space with interrupts disabled.
+static cbuf_t uart_tx_buf;
+static spin_lock_t uart_tx_lock = SPIN_LOCK_INITIAL_VALUE;
 
 struct bcm283x_mu_regs {
     uint32_t io;
@@ -50,10 +59,31 @@ struct bcm283x_aux_regs {
 #define MU_IIR_CLR_XMIT_FIFO (1 << 2) // For writing.
 #define MU_IIR_CLR_RECV_FIFO (1 << 1)
 
-#define MU_IIR_EN_RX_IRQ (1 << 0) // Enable the recv interrupt.
+#define MU_IIR_TX_EMPTY (1 << 1)      // For reading.
+
+#define MU_IER_EN_RX_IRQ (1 << 0) // Enable the recv interrupt.
+#define MU_IER_EN_TX_IRQ (1 << 1) // Enable the xmit interrupt.
 
 #define MU_LSR_TX_EMPTY (1 << 5)
 
+/* move buffered tx data into the hardware fifo; runs with uart_tx_lock held */
+static void bcm28xx_tx_drain(void) {
+    volatile struct bcm283x_mu_regs* regs =
+        (struct bcm283x_mu_regs*)MINIUART_BASE;
+
+    char c;
+    while (readl(&regs->lsr) & MU_LSR_TX_EMPTY) {
+        if (cbuf_read_char(&uart_tx_buf, &c, false) != 1) {
+            // Nothing left to send; mask the xmit interrupt.
+            writel(readl(&regs->ier) & ~MU_IER_EN_TX_IRQ, &regs->ier);
+            return;
+        }
+        writel(c, &regs->io);
+    }
+    // Fifo filled to depth; let the xmit interrupt drain the rest.
+    writel(readl(&regs->ier) | MU_IER_EN_TX_IRQ, &regs->ier);
+}
+
 static enum handler_return aux_irq(void* arg) {
     volatile struct bcm283x_mu_regs* mu_regs =
         (struct bcm283x_mu_regs*)MINIUART_BASE;
@@ -68,14 +98,17 @@ static enum handler_return aux_irq(void* arg) {
 
     bool resched = false;
 
-    while (true) {
-        uint32_t iir = readl(&mu_regs->iir);
-        if ((iir & MU_IIR_BYTE_AVAIL) == 0)
-            break;
-
+    uint32_t iir;
+    while (((iir = readl(&mu_regs->iir)) & MU_IIR_BYTE_AVAIL) != 0) {
         resched = true;
         char ch = readl(&mu_regs->io);
-        cbuf_write_char(&uart_rx_buf, ch, false);
+        cbuf_spsc_write_char(&uart_rx_buf, ch, false);
+    }
+
+    if (iir & MU_IIR_TX_EMPTY) {
+        spin_lock(&uart_tx_lock);
+        bcm28xx_tx_drain();
+        spin_unlock(&uart_tx_lock);
     }
 
     return resched ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
@@ -84,12 +117,29 @@ static enum handler_return aux_irq(void* arg) {
 static int bcm28xx_putc(char c) {
     struct bcm283x_mu_regs* regs = (struct bcm283x_mu_regs*)MINIUART_BASE;
 
-    /* Wait until there is space in the FIFO */
-    while (!(readl(&regs->lsr) & MU_LSR_TX_EMPTY))
-        ;
+    /* Tx buffer not set up yet (early boot): poll the FIFO directly */
+    if (uart_tx_buf.buf == NULL) {
+        while (!(readl(&regs->lsr) & MU_LSR_TX_EMPTY))
+            ;
+        writel(c, &regs->io);
+        return 1;
+    }
 
-    /* Send the character */
-    writel(c, &regs->io);
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&uart_tx_lock, state);
+
+    /* If the buffer is full, drain it into the FIFO here rather than
+     * waiting on a xmit interrupt that may be masked on this cpu */
+    while (cbuf_space_avail(&uart_tx_buf) == 0) {
+        while (!(readl(&regs->lsr) & MU_LSR_TX_EMPTY))
+            ;
+        bcm28xx_tx_drain();
+    }
+
+    cbuf_write_char(&uart_tx_buf, c, false);
+    bcm28xx_tx_drain();
+
+    spin_unlock_irqrestore(&uart_tx_lock, state);
 
     return 1;
 }
@@ -100,8 +150,9 @@ static void bcm28xx_uart_init(mdi_node_ref_t* node, uint level) {
     volatile struct bcm283x_aux_regs* aux_regs =
         (struct bcm283x_aux_regs*)AUX_BASE;
 
-    // Create circular buffer to hold received data.
-    cbuf_initialize(&uart_rx_buf, RXBUF_SIZE);
+    // Create circular buffers to hold received and pending transmit data.
+    cbuf_spsc_initialize(&uart_rx_buf, RXBUF_SIZE);
+    cbuf_initialize(&uart_tx_buf, TXBUF_SIZE);
 
     // AUX Interrupt handler handles interrupts for SPI1, SPI2, and miniuart
     // Interrupt handler must decode IRQ.
@@ -117,15 +168,16 @@ static void bcm28xx_uart_init(mdi_node_ref_t* node, uint level) {
     // peripheral for us, but we hit the enable bit just to be sure.
     writel(AUX_ENB_MINIUART, &aux_regs->auxenb);
 
-    // Enable the receive interrupt on the UART peripheral.
-    writel(MU_IIR_EN_RX_IRQ, &mu_regs->ier);
+    // Enable the receive interrupt on the UART peripheral. The xmit
+    // interrupt is enabled only while buffered transmit data is pending.
+    writel(MU_IER_EN_RX_IRQ, &mu_regs->ier);
 }
 
 static int bcm28xx_getc(bool wait) {
-    cbuf_t* rxbuf = &uart_rx_buf;
+    cbuf_spsc_t* rxbuf = &uart_rx_buf;
 
     char c;
-    if (cbuf_read_char(rxbuf, &c, wait) == 1)
+    if (cbuf_spsc_read_char(rxbuf, &c, wait) == 1)
         return c;
 
     return -1;
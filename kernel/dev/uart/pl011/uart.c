@@ -37,12 +37,37 @@
 #define UARTREG(base, reg)  (*REG32((base)  + (reg)))
 
 #define RXBUF_SIZE 16
+#define TXBUF_SIZE 256
 
 // values read from MDI
 static uint64_t uart_base = 0;
 static uint32_t uart_irq = 0;
 
-static cbuf_t uart_rx_buf;
+// Receive is a single-producer (rx irq), single-consumer (console
+// reader) stream, so it rides the lock-free ring.
+static cbuf_spsc_t uart_rx_buf;
+
+// Transmit is interrupt driven: putc queues into uart_tx_buf and the
+// tx fifo-level irq (txim) moves the data into the hardware fifo, so
+// callers never spin on fifo space with interrupts disabled.
+static cbuf_t uart_tx_buf;
+static spin_lock_t uart_tx_lock = SPIN_LOCK_INITIAL_VALUE;
+
+/* move buffered tx data into the hardware fifo; runs with uart_tx_lock held */
+static void pl011_uart_tx_drain(void)
+{
+    char c;
+    while ((UARTREG(uart_base, UART_TFR) & (1<<5)) == 0) {
+        if (cbuf_read_char(&uart_tx_buf, &c, false) != 1) {
+            /* nothing left to send; mask the tx irq */
+            UARTREG(uart_base, UART_IMSC) &= ~(1<<5); // !txim
+            return;
+        }
+        UARTREG(uart_base, UART_DR) = c;
+    }
+    /* fifo filled to depth; let the tx irq drain the rest */
+    UARTREG(uart_base, UART_IMSC) |= (1<<5); // txim
+}
 
 static enum handler_return pl011_uart_irq(void *arg)
 {
@@ -55,25 +80,32 @@ static enum handler_return pl011_uart_irq(void *arg)
         /* while fifo is not empty, read chars out of it */
         while ((UARTREG(uart_base, UART_TFR) & (1<<4)) == 0) {
             /* if we're out of rx buffer, mask the irq instead of handling it */
-            if (cbuf_space_avail(&uart_rx_buf) == 0) {
+            if (cbuf_spsc_space_avail(&uart_rx_buf) == 0) {
                 UARTREG(uart_base, UART_IMSC) &= ~((1<<4)|(1<<6)); // !rxim
                 break;
             }
 
             char c = UARTREG(uart_base, UART_DR);
-            cbuf_write_char(&uart_rx_buf, c, false);
+            cbuf_spsc_write_char(&uart_rx_buf, c, false);
 
             resched = true;
         }
     }
 
+    if (isr & (1<<5)) { // txmis
+        spin_lock(&uart_tx_lock);
+        pl011_uart_tx_drain();
+        spin_unlock(&uart_tx_lock);
+    }
+
     return resched ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
 }
 
 static void pl011_uart_init(mdi_node_ref_t* node, uint level)
 {
-    // create circular buffer to hold received data
-    cbuf_initialize(&uart_rx_buf, RXBUF_SIZE);
+    // create circular buffers to hold received and pending transmit data
+    cbuf_spsc_initialize(&uart_rx_buf, RXBUF_SIZE);
+    cbuf_initialize(&uart_tx_buf, TXBUF_SIZE);
 
     // assumes interrupts are contiguous
     register_int_handler(uart_irq, &pl011_uart_irq, NULL);
@@ -97,10 +129,29 @@ static void pl011_uart_init(mdi_node_ref_t* node, uint level)
 
 static int pl011_uart_putc(char c)
 {
-    /* spin while fifo is full */
-    while (UARTREG(uart_base, UART_TFR) & (1<<5))
-        ;
-    UARTREG(uart_base, UART_DR) = c;
+    /* tx buffer not set up yet (early boot): poll the fifo directly */
+    if (uart_tx_buf.buf == NULL) {
+        while (UARTREG(uart_base, UART_TFR) & (1<<5))
+            ;
+        UARTREG(uart_base, UART_DR) = c;
+        return 1;
+    }
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&uart_tx_lock, state);
+
+    /* if the buffer is full, drain it into the fifo here rather than
+     * waiting on a tx irq that may be masked on this cpu */
+    while (cbuf_space_avail(&uart_tx_buf) == 0) {
+        while (UARTREG(uart_base, UART_TFR) & (1<<5))
+            ;
+        pl011_uart_tx_drain();
+    }
+
+    cbuf_write_char(&uart_tx_buf, c, false);
+    pl011_uart_tx_drain();
+
+    spin_unlock_irqrestore(&uart_tx_lock, state);
 
     return 1;
 }
@@ -108,7 +159,7 @@ static int pl011_uart_putc(char c)
 static int pl011_uart_getc(bool wait)
 {
     char c;
-    if (cbuf_read_char(&uart_rx_buf, &c, wait) == 1) {
+    if (cbuf_spsc_read_char(&uart_rx_buf, &c, wait) == 1) {
         UARTREG(uart_base, UART_IMSC) = ((1<<4)|(1<<6)); // rxim
         return c;
     }
@@ -90,11 +90,26 @@ static inline int atomic_add_release(volatile int *ptr, int val)
     return __atomic_fetch_add(ptr, val, __ATOMIC_RELEASE);
 }
 
+static inline int atomic_load_acquire(volatile int *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_release(volatile int *ptr, int newval)
+{
+    __atomic_store_n(ptr, newval, __ATOMIC_RELEASE);
+}
+
 static inline void atomic_fence_acquire(void)
 {
     __atomic_thread_fence(__ATOMIC_ACQUIRE);
 }
 
+static inline void atomic_fence_release(void)
+{
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
 // 64-bit versions. Assumes the compiler/platform is LLP so int is 32 bits.
 static inline int64_t atomic_swap_64(volatile int64_t *ptr, int64_t val)
 {
@@ -170,9 +185,24 @@ static inline uint64_t atomic_load_u64_relaxed(volatile uint64_t *ptr)
     return __atomic_load_n(ptr, __ATOMIC_RELAXED);
 }
 
+static inline uint64_t atomic_load_u64_acquire(volatile uint64_t *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
 static inline void atomic_store_u64(volatile uint64_t *ptr, uint64_t newval)
 {
     __atomic_store_n(ptr, newval, __ATOMIC_SEQ_CST);
 }
 
+static inline void atomic_store_u64_relaxed(volatile uint64_t *ptr, uint64_t newval)
+{
+    __atomic_store_n(ptr, newval, __ATOMIC_RELAXED);
+}
+
+static inline void atomic_store_u64_release(volatile uint64_t *ptr, uint64_t newval)
+{
+    __atomic_store_n(ptr, newval, __ATOMIC_RELEASE);
+}
+
 __END_CDECLS
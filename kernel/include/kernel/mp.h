@@ -20,6 +20,13 @@ typedef uint32_t mp_cpu_mask_t;
 typedef void (*mp_ipi_task_func_t)(void *context);
 typedef void (*mp_sync_task_t)(void *context);
 
+/* one entry of a vectored cross-call: run |task| on the cpus in |target| */
+typedef struct mp_sync_vec {
+    mp_cpu_mask_t target;
+    mp_sync_task_t task;
+    void *context;
+} mp_sync_vec_t;
+
 #define MP_CPU_ALL_BUT_LOCAL (UINT32_MAX)
 #define MP_CPU_ALL (1U<<31)
 static_assert(SMP_MAX_CPUS <= 31, "");
@@ -41,12 +48,42 @@ void mp_init(void);
 
 void mp_reschedule(mp_cpu_mask_t target, uint flags);
 void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context);
+
+/* run a vector of (cpu mask, task) pairs in a single IPI round and block
+ * until every targeted cpu has finished every entry that targets it;
+ * targets must be explicit cpu masks */
+void mp_sync_exec_vec(const mp_sync_vec_t *vec, size_t count);
+
+/* run a task on the targeted cpus without blocking; |completion| (if any)
+ * runs once all targets have finished, on the last cpu to acknowledge and
+ * possibly in interrupt context */
+status_t mp_async_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context,
+                       mp_sync_task_t completion, void *completion_context);
 void mp_set_curr_cpu_online(bool online);
 void mp_set_curr_cpu_active(bool active);
 
 status_t mp_hotplug_cpu(uint cpu_id);
 status_t mp_unplug_cpu(uint cpu_id);
 
+/* per cpu topology, registered by arch/platform code during boot. cpus
+ * without registered topology default to a unique core in package 0, so
+ * the scheduler degrades to treating every cpu as its own physical core. */
+typedef struct mp_cpu_topology {
+    uint32_t package_id;
+    uint32_t core_id;
+    uint32_t smt_id;
+} mp_cpu_topology_t;
+
+void mp_set_cpu_topology(uint cpu_id, const mp_cpu_topology_t *topo);
+void mp_get_cpu_topology(uint cpu_id, mp_cpu_topology_t *topo);
+
+/* cpus sharing a physical core with |cpu_id|, including itself */
+mp_cpu_mask_t mp_get_smt_sibling_mask(uint cpu_id);
+
+/* cpus sharing a package (and so a last level cache) with |cpu_id|,
+ * including itself */
+mp_cpu_mask_t mp_get_package_mask(uint cpu_id);
+
 /* called from arch code during reschedule irq */
 enum handler_return mp_mbx_reschedule_irq(void);
 /* called from arch code during generic task irq */
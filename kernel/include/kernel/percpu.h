@@ -15,18 +15,44 @@
 
 __BEGIN_CDECLS
 
+/* Each functional group below starts on its own cache line so that traffic
+ * against one group (stats updates from interrupt context, cross-cpu timer
+ * sets, remote wakeups touching the run queues) does not drag the lines
+ * holding the others around between cpus.  The layout can be inspected at
+ * runtime with the 'percpu' console command. */
 struct percpu {
-    /* per cpu timer queue */
-    struct list_node timer_queue;
+    /* bitmap to indicate which run queues are non empty, followed by the
+     * queue heads it indexes; checked on every reschedule, so it leads the
+     * scheduler-hot group */
+    uint32_t run_queue_bitmap;
+
+    /* per cpu run queue, indexed by priority */
+    struct list_node run_queue[NUM_PRIORITIES] __CPU_MAX_ALIGN;
+
+    /* earliest-deadline-first queue of runnable deadline class threads,
+     * plus a parking lot for the ones that have burned their budget for
+     * the current period */
+    struct list_node deadline_queue;
+    struct list_node deadline_throttled;
 
     /* per cpu preemption timer */
-    timer_t preempt_timer;
+    timer_t preempt_timer __CPU_MAX_ALIGN;
+
+    /* per cpu timer wheel; written cross-cpu when timers are set against
+     * this cpu */
+    struct timer_wheel timer_wheel __CPU_MAX_ALIGN;
+
+    /* bounded cache of dead threads' kernel stacks, reused by thread_create;
+     * only touched locally with interrupts disabled */
+    struct list_node stack_cache __CPU_MAX_ALIGN;
+    uint32_t stack_cache_count;
 
-    /* thread/cpu level statistics */
-    struct cpu_stats stats;
+    /* thread/cpu level statistics; updated locally from interrupt context,
+     * read cross-cpu only by diagnostics, so kept off the scheduler lines */
+    struct cpu_stats stats __CPU_MAX_ALIGN;
 
     /* per cpu idle thread */
-    thread_t idle_thread;
+    thread_t idle_thread __CPU_MAX_ALIGN;
 } __CPU_MAX_ALIGN;
 
 /* the kernel per-cpu structure */
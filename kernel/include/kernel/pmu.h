@@ -0,0 +1,49 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <err.h>
+#include <magenta/compiler.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS
+
+/* Hardware performance counter sampling.
+ *
+ * While sampling is active each cpu counts instructions retired,
+ * unhalted core cycles, LLC misses and branch misses. The context
+ * switch path reads the counters and emits the deltas accumulated by
+ * the outgoing thread as a PMU_SAMPLE ktrace record; the record's
+ * common header supplies the timestamp and tid, so every sample is
+ * attributed to the thread that ran. Records are only written while
+ * ktrace is collecting with KTRACE_GRP_ARCH enabled.
+ *
+ * Only x86 has a backend at present; elsewhere these are no-ops.
+ */
+
+#ifdef __x86_64__
+
+/* start counting on every cpu; options must be 0 */
+status_t pmu_start(uint32_t options);
+
+/* stop counting on every cpu */
+status_t pmu_stop(void);
+
+/* charge the outgoing thread with the deltas since the last sample;
+ * cheap no-op unless sampling is active */
+void pmu_context_switch(void);
+
+#else
+
+static inline status_t pmu_start(uint32_t options) { return MX_ERR_NOT_SUPPORTED; }
+static inline status_t pmu_stop(void) { return MX_ERR_NOT_SUPPORTED; }
+static inline void pmu_context_switch(void) {}
+
+#endif
+
+__END_CDECLS
@@ -0,0 +1,29 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS
+
+/* Sampling cpu profiler.
+ *
+ * Each cpu re-arms a private oneshot timer at the sampling period; the
+ * timer callback walks the kernel frame pointer chain and emits a
+ * PROF_SAMPLE record into the ktrace stream. Records are only written
+ * while ktrace is collecting with KTRACE_GRP_PROFILE enabled.
+ */
+
+/* start sampling on every cpu; period_us == 0 selects the default period */
+status_t profile_start(uint32_t period_us);
+
+/* stop sampling on every cpu */
+status_t profile_stop(void);
+
+__END_CDECLS
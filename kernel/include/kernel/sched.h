@@ -21,6 +21,23 @@ void sched_yield(void);
 void sched_preempt(void);
 void sched_reschedule(void);
 
+/* place |t| in the deadline class: |capacity_ns| of cpu time out of every
+ * |period_ns|, finished within |deadline_ns| of each period start.
+ * Requires capacity <= deadline <= period. A zero period returns the
+ * thread to the fair class. Deadline threads run ahead of every fair and
+ * realtime priority, earliest absolute deadline first, and are throttled
+ * for the rest of their period once the capacity is consumed. */
+status_t sched_set_deadline(thread_t *t, uint64_t capacity_ns,
+                            uint64_t deadline_ns, uint64_t period_ns);
+
+/* set |t|'s cpu affinity. |hard_mask| strictly limits which cpus the
+ * thread may run on; |soft_mask| only expresses a placement preference
+ * that keeps the thread cache local when one of its cpus is available.
+ * A zero mask clears the respective constraint. A hard mask naming only
+ * offline cpus is ignored until one comes back rather than stranding
+ * the thread. */
+status_t sched_set_affinity(thread_t *t, uint32_t hard_mask, uint32_t soft_mask);
+
 /* the low level reschedule routine, called from the scheduler */
 void _thread_resched_internal(void);
 
@@ -16,6 +16,7 @@
 #include <arch/thread.h>
 #include <kernel/wait.h>
 #include <kernel/spinlock.h>
+#include <kernel/timer.h>
 #include <debug.h>
 
 __BEGIN_CDECLS
@@ -55,6 +56,7 @@ typedef void (*thread_user_callback_t)(enum thread_user_state_change new_state,
 #define THREAD_FLAG_REAL_TIME                 (1<<3)
 #define THREAD_FLAG_IDLE                      (1<<4)
 #define THREAD_FLAG_DEBUG_STACK_BOUNDS_CHECK  (1<<5)
+#define THREAD_FLAG_IRQ_THREAD                (1<<6)
 
 #define THREAD_SIGNAL_KILL                    (1<<0)
 #define THREAD_SIGNAL_SUSPEND                 (1<<1)
@@ -76,18 +78,50 @@ typedef struct thread {
 
     /* active bits */
     struct list_node queue_node;
+    /* links the sorted list of per-priority bucket heads when this thread
+     * heads its bucket in a wait queue; clear otherwise */
+    struct list_node wait_queue_heads_node;
     enum thread_state state;
     lk_time_t last_started_running;
     lk_time_t remaining_time_slice;
+    /* when the thread last entered a run queue; only maintained while
+     * the run queue latency tripwire is armed, 0 otherwise */
+    lk_time_t last_queued;
     unsigned int flags;
     unsigned int signals;
 
     int base_priority;
     int priority_boost;
+    int effec_priority; /* cached base_priority + priority_boost */
+    /* base priority to restore when the IRQ thread band is revoked */
+    int saved_base_priority;
 
     uint last_cpu; /* last/current cpu the thread is running on */
     int pinned_cpu; /* only run on pinned_cpu if >= 0 */
 
+    /* cpu affinity masks (mp_cpu_mask_t); zero means unconstrained.
+     * hard_affinity strictly limits where the thread may run,
+     * soft_affinity is only a placement preference for cache locality.
+     * see sched_set_affinity() */
+    uint32_t hard_affinity;
+    uint32_t soft_affinity;
+
+    /* deadline class parameters; dl_period_ns != 0 marks the thread as
+     * deadline scheduled, see sched_set_deadline() */
+    uint64_t dl_capacity_ns;
+    uint64_t dl_deadline_ns;
+    uint64_t dl_period_ns;
+
+    /* bookkeeping for the current period */
+    lk_time_t dl_period_start;
+    lk_time_t dl_abs_deadline;
+    lk_time_t dl_budget_ns;
+
+    /* set while the thread is parked for burning its whole budget before
+     * its period was up; dl_timer fires at the next period boundary */
+    bool dl_throttled;
+    timer_t dl_timer;
+
     /* pointer to the kernel address space this thread is associated with */
     struct vmm_aspace *aspace;
 
@@ -148,6 +182,8 @@ typedef struct thread {
 #define thread_pinned_cpu(t) ((t)->pinned_cpu)
 #define thread_set_last_cpu(t,c) ((t)->last_cpu = (c))
 #define thread_set_pinned_cpu(t, c) ((t)->pinned_cpu = (c))
+#define thread_hard_affinity(t) ((t)->hard_affinity)
+#define thread_soft_affinity(t) ((t)->soft_affinity)
 
 /* thread priority */
 #define NUM_PRIORITIES (32)
@@ -158,6 +194,9 @@ typedef struct thread {
 #define LOW_PRIORITY (NUM_PRIORITIES / 4)
 #define DEFAULT_PRIORITY (NUM_PRIORITIES / 2)
 #define HIGH_PRIORITY ((NUM_PRIORITIES / 4) * 3)
+/* band for threads servicing device interrupts: above every fair priority,
+ * below DPCs and hard real time work */
+#define IRQ_THREAD_PRIORITY (NUM_PRIORITIES - 3)
 
 /* stack size */
 #ifdef CUSTOM_DEFAULT_STACK_SIZE
@@ -176,6 +215,7 @@ void thread_construct_first(thread_t *t, const char *name);
 thread_t *thread_create_idle_thread(uint cpu_num);
 void thread_set_name(const char *name);
 void thread_set_priority(int priority);
+void thread_set_irq_thread(bool active);
 void thread_set_user_callback(thread_t *t, thread_user_callback_t cb);
 thread_t *thread_create(const char *name, thread_start_routine entry, void *arg, int priority, size_t stack_size);
 thread_t *thread_create_etc(thread_t *t, const char *name, thread_start_routine entry, void *arg, int priority, void *stack, void *unsafe_stack, size_t stack_size, thread_trampoline_routine alt_trampoline);
@@ -260,6 +300,16 @@ static inline bool thread_is_real_time_or_idle(thread_t *t)
     return !!(t->flags & (THREAD_FLAG_REAL_TIME | THREAD_FLAG_IDLE));
 }
 
+static inline bool thread_is_irq_thread(const thread_t *t)
+{
+    return !!(t->flags & THREAD_FLAG_IRQ_THREAD);
+}
+
+static inline bool thread_is_deadline(const thread_t *t)
+{
+    return t->dl_period_ns != 0;
+}
+
 /* the current thread */
 #include <arch/current_thread.h>
 thread_t *get_current_thread(void);
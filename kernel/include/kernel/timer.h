@@ -22,6 +22,27 @@ typedef enum handler_return (*timer_callback)(struct timer *, lk_time_t now, voi
 
 #define TIMER_MAGIC (0x74696D72)  //'timr'
 
+/* Hierarchical timer wheel: pending timers are hashed by expiry tick into
+ * power-of-two slots per cpu so that setting and canceling are O(1). */
+#define TIMER_WHEEL_SHIFT       20  /* one wheel tick is 2^20 ns, ~1.05ms */
+#define TIMER_WHEEL_LEVEL_BITS  6
+#define TIMER_WHEEL_SLOTS       (1u << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_SLOT_MASK   (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS      4
+
+struct timer_wheel {
+    /* the next tick to be processed by timer_tick() */
+    uint64_t cur_tick;
+
+    /* number of timers currently in the wheel */
+    size_t count;
+
+    /* deadline the platform oneshot timer is armed for, or UINT64_MAX */
+    lk_time_t armed_deadline;
+
+    struct list_node slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
 typedef struct timer {
     int magic;
     struct list_node node;
@@ -33,6 +54,8 @@ typedef struct timer {
 
     volatile int active_cpu; // <0 if inactive
     volatile bool cancel;    // true if cancel is pending
+
+    int wheel_cpu;           // cpu whose timer wheel holds this timer, <0 if none
 } timer_t;
 
 #define TIMER_INITIAL_VALUE(t) \
@@ -44,6 +67,7 @@ typedef struct timer {
     .arg = NULL, \
     .active_cpu = -1, \
     .cancel = false, \
+    .wheel_cpu = -1, \
 }
 
 /* Rules for Timers:
@@ -54,6 +78,12 @@ typedef struct timer {
  * - timer_cancel() may spin waiting for a pending timer to complete on another cpu
 */
 void timer_init(timer_t *);
+
+/* Program a timer to fire once, no earlier than |deadline| and no later than
+ * |deadline| + |slack|. The slack window lets the queue coalesce the timer
+ * with expiry points that are already armed so that nearby timers share a
+ * single interrupt. Pass a slack of 0 for an exact deadline. */
+void timer_set(timer_t *, lk_time_t deadline, lk_time_t slack, timer_callback, void *arg);
 void timer_set_oneshot(timer_t *, lk_time_t deadline, timer_callback, void *arg);
 bool timer_cancel(timer_t *);
 
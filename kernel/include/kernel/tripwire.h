@@ -0,0 +1,40 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS
+
+/* Soft-latency tripwires.
+ *
+ * The watchdog only catches hard hangs. These record a ktrace probe
+ * whenever a bounded kernel path overruns its configured budget, so
+ * tail latencies (audio underruns, missed frames) can be localized to
+ * the responsible path without a debugger attached.
+ *
+ * Budgets come from the kernel command line, in microseconds; a budget
+ * of 0 (the default) disables that tripwire and keeps its checks off
+ * the hot paths:
+ *
+ *  kernel.tripwire.irq.us    duration of a single IRQ handler
+ *  kernel.tripwire.timer.us  duration of a single timer callback
+ *  kernel.tripwire.queue.us  run queue wait of a thread at or above
+ *                            kernel.tripwire.queue.pri (default
+ *                            HIGH_PRIORITY)
+ *
+ * The thresholds are stored in nanoseconds so the comparisons on the
+ * instrumented paths need no division.
+ */
+extern uint32_t tripwire_irq_ns;
+extern uint32_t tripwire_timer_ns;
+extern uint32_t tripwire_queue_ns;
+extern int tripwire_queue_pri;
+
+__END_CDECLS
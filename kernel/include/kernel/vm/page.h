@@ -39,6 +39,9 @@ typedef struct vm_page {
             // If true, one pin slot is used by the VmObject to keep a run
             // contiguous.
             bool contiguous_pin : 1;
+            // If true, userspace has hinted (MX_VMO_OP_DONT_NEED) that this
+            // page may be reclaimed when the system is low on memory.
+            bool dontneed : 1;
         } object;
 
         uint8_t pad[24]; // pad out to 32 bytes
@@ -28,8 +28,9 @@ typedef struct pmm_arena_info {
 status_t pmm_add_arena(const pmm_arena_info_t* arena) __NONNULL((1));
 
 // flags for allocation routines below
-#define PMM_ALLOC_FLAG_ANY (0x0)  // no restrictions on which arena to allocate from
-#define PMM_ALLOC_FLAG_KMAP (0x1) // allocate only from arenas marked KMAP
+#define PMM_ALLOC_FLAG_ANY (0x0)    // no restrictions on which arena to allocate from
+#define PMM_ALLOC_FLAG_KMAP (0x1)   // allocate only from arenas marked KMAP
+#define PMM_ALLOC_FLAG_ZEROED (0x2) // return an already zeroed page (single page allocs only)
 
 // Allocate count pages of physical memory, adding to the tail of the passed list.
 // The list must be initialized.
@@ -67,6 +68,63 @@ size_t pmm_count_total_bytes(void);
 // |state_count|. Does not zero out the entries first.
 void pmm_count_total_states(size_t state_count[_VM_PAGE_STATE_COUNT]);
 
+// NUMA topology. Every arena and cpu starts out on node 0; platform code
+// retags them once the firmware topology tables have been parsed (the ACPI
+// SRAT on x86). On non-NUMA systems nothing is ever retagged and the
+// allocator behaves exactly as before.
+#define PMM_MAX_NUMA_NODES 16
+
+// Tag every arena that intersects [base, base + size) with |node|.
+void pmm_numa_set_arena_node(paddr_t base, size_t size, uint32_t node);
+
+// Record the node the given cpu's memory controller is attached to.
+void pmm_numa_set_cpu_node(uint cpu_num, uint32_t node);
+
+// Node the given cpu is attached to; 0 on non-NUMA systems.
+uint32_t pmm_numa_cpu_node(uint cpu_num);
+
+// Number of nodes in the system (1 on non-NUMA systems).
+uint32_t pmm_numa_node_count(void);
+
+// Per-node summary, filled out by pmm_numa_get_node_info below.
+typedef struct pmm_numa_node_info {
+    uint32_t num_cpus;
+    uint64_t mem_bytes;
+    uint64_t free_bytes;
+} pmm_numa_node_info_t;
+
+// Fill |info| with the cpu count and memory totals for |node|.
+void pmm_numa_get_node_info(uint32_t node, pmm_numa_node_info_t* info) __NONNULL((2));
+
+// Per-arena statistics, filled out by pmm_arena_get_stats below.
+typedef struct pmm_arena_stats {
+    char name[16];
+    uint32_t numa_node;
+    paddr_t base;
+    size_t size;
+
+    // Unallocated memory in the arena.
+    size_t free_bytes;
+
+    // Number of maximal runs of contiguous free pages; free_bytes /
+    // free_runs is the average free run size. Maintained incrementally,
+    // so reading it is cheap.
+    size_t free_runs;
+
+    // Longest run of contiguous free pages, in bytes; an upper bound on
+    // what pmm_alloc_contiguous can currently satisfy from this arena.
+    // Computed by sweeping the arena's page array, so it costs the same
+    // order as pmm_count_total_states.
+    size_t largest_free_run_bytes;
+} pmm_arena_stats_t;
+
+// Number of registered arenas.
+uint32_t pmm_arena_count(void);
+
+// Fill |stats| for the index'th arena, in registration order. Returns
+// MX_ERR_OUT_OF_RANGE if index is past the last arena.
+status_t pmm_arena_get_stats(uint32_t index, pmm_arena_stats_t* stats) __NONNULL((2));
+
 // Allocate a run of pages out of the kernel area and return the pointer in kernel space.
 // If the optional list is passed, append the allocate page structures to the tail of the list.
 // If the optional physical address pointer is passed, return the address.
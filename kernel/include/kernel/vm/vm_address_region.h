@@ -194,8 +194,43 @@ protected:
         }
     };
 
+    // utility so the parent's gap index can find the intrusive node
+    struct GapTreeTraits {
+        static mxtl::WAVLTreeNodeState<VmAddressRegionOrMapping*, bool>& node_state(VmAddressRegionOrMapping& obj) {
+            return obj.gap_tree_node_;
+        }
+    };
+
+    // Key for the parent's gap index: gaps ordered by length, with the
+    // owning child's base as a tiebreak so keys stay unique.
+    struct GapKey {
+        size_t len;
+        vaddr_t base;
+    };
+    struct GapKeyTraits {
+        static GapKey GetKey(const VmAddressRegionOrMapping& obj) {
+            return GapKey{obj.gap_to_next_, obj.base()};
+        }
+        static bool LessThan(const GapKey& a, const GapKey& b) {
+            return a.len < b.len || (a.len == b.len && a.base < b.base);
+        }
+        static bool EqualTo(const GapKey& a, const GapKey& b) {
+            return a.len == b.len && a.base == b.base;
+        }
+    };
+
     // node for element in list of parent's children.
     mxtl::WAVLTreeNodeState<mxtl::RefPtr<VmAddressRegionOrMapping>, bool> subregion_list_node_;
+
+    // Length of the unallocated gap between the end of this region and the
+    // base of the next sibling (or the end of the parent).  Maintained by
+    // the parent's gap index (see VmAddressRegion::gap_tree_); only
+    // meaningful while in a parent's child list.
+    size_t gap_to_next_ = 0;
+
+    // node for element in the parent's gap index; only in a container
+    // while gap_to_next_ is non-zero.
+    mxtl::WAVLTreeNodeState<VmAddressRegionOrMapping*, bool> gap_tree_node_;
 };
 
 // A representation of a contiguous range of virtual address space
@@ -250,8 +285,13 @@ protected:
     virtual bool EnumerateChildrenLocked(VmEnumerator* ve, uint depth);
 
     friend class VmMapping;
-    // Remove *region* from the subregion list
+    // Insert *child* into the subregion list, keeping the gap index in sync
+    void AddSubregion(VmAddressRegionOrMapping* child);
+    // Remove *region* from the subregion list, keeping the gap index in sync
     void RemoveSubregion(VmAddressRegionOrMapping* region);
+    // Recompute *child*'s entry in the gap index after its size changed in
+    // place (an unmap that trimmed it)
+    void GapUpdateLocked(VmAddressRegionOrMapping* child);
 
     friend mxtl::RefPtr<VmAddressRegion>;
 
@@ -328,6 +368,15 @@ private:
     // list of subregions, indexed by base address
     ChildList subregions_;
 
+    using GapTree = mxtl::WAVLTree<GapKey, VmAddressRegionOrMapping*, GapKeyTraits,
+                                   GapTreeTraits>;
+
+    // Index of the children by the length of the gap that trails each of
+    // them, so the allocator can find a large enough gap in one descent
+    // instead of walking every child.  The gap between base_ and the first
+    // child has no child to hang off of and is handled separately.
+    GapTree gap_tree_;
+
     const char name_[32] = {};
 };
 
@@ -476,6 +525,10 @@ private:
     // in Clang around capability aliasing, we need to relax the analysis.
     void ActivateLocked();
 
+    // Fault in and map pages following |va| when access looks sequential.
+    // Called from PageFault() with the aspace and object locks held.
+    void FaultAroundLocked(vaddr_t va, uint pf_flags);
+
     // pointer and region of the object we are mapping
     mxtl::RefPtr<VmObject> object_;
     uint64_t object_offset_ = 0;
@@ -485,4 +538,8 @@ private:
 
     // used to detect recursions through the vmo fault path
     bool currently_faulting_ = false;
+
+    // vmo offset of the last page fault, used to detect sequential access
+    // for the fault-around policy
+    uint64_t last_fault_offset_ = UINT64_MAX;
 };
@@ -22,6 +22,7 @@
 #include <mxtl/ref_ptr.h>
 
 class VmObject;
+struct dpc;
 
 class VmAspace : public mxtl::DoublyLinkedListable<VmAspace*>, public mxtl::RefCounted<VmAspace> {
 public:
@@ -58,6 +59,12 @@ public:
     // destroy but not free the address space
     status_t Destroy();
 
+    // Queue the address space for teardown on the low-priority dpc worker
+    // instead of destroying it on the calling thread. Used by process exit,
+    // where synchronously unmapping a large address space would stall the
+    // exiting thread's cpu. Takes ownership of one reference to the aspace.
+    static void DeferredDestroy(mxtl::RefPtr<VmAspace> aspace);
+
     // Returns true if the address space has been destroyed.
     bool is_destroyed() const;
 
@@ -176,6 +183,24 @@ private:
 
     void InitializeAslr();
 
+    // The base node state is used by the global aspace list, so deferred
+    // destruction gets its own node state and list type.
+    using DeferredNodeState = mxtl::DoublyLinkedListNodeState<VmAspace*>;
+    DeferredNodeState deferred_list_state_;
+
+    struct DeferredListTraits {
+        static DeferredNodeState& node_state(VmAspace& aspace) {
+            return aspace.deferred_list_state_;
+        }
+    };
+    using DeferredList = mxtl::DoublyLinkedList<VmAspace*, DeferredListTraits>;
+
+    // aspaces waiting for deferred teardown, drained by DeferredDestroyRoutine
+    static mutex_t deferred_destroy_lock_;
+    static DeferredList deferred_destroy_list_ TA_GUARDED(deferred_destroy_lock_);
+    static struct dpc deferred_destroy_dpc_;
+    static void DeferredDestroyRoutine(struct dpc* dpc);
+
     // magic
     mxtl::Canary<mxtl::magic("VMAS")> canary_;
 
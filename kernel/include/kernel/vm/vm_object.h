@@ -27,6 +27,22 @@ class VmMapping;
 
 typedef status_t (*vmo_lookup_fn_t)(void* context, size_t offset, size_t index, paddr_t pa);
 
+// Interface for billing committed pages to a higher layer, e.g. the job
+// that created the VMO. The VM layer adjusts the counter as pages are
+// committed and released; the counter may outlive both the VMO and
+// whatever owns it on the other side.
+//
+// Adjust() is called with VMO locks held, so implementations must not
+// block or take locks; an atomic counter is the expected shape.
+class VmPageCounter : public mxtl::RefCounted<VmPageCounter> {
+public:
+    virtual ~VmPageCounter() {}
+
+    // |delta_pages| is positive when pages are committed to the object
+    // and negative when they are released.
+    virtual void Adjust(int64_t delta_pages) = 0;
+};
+
 // The base vm object that holds a range of bytes of data
 //
 // Can be created without mapping and used as a container of data, or mappable
@@ -70,6 +86,30 @@ public:
         return MX_ERR_NOT_SUPPORTED;
     }
 
+    // hint that a range of the vmo is not needed right now and may be
+    // reclaimed if the system runs low on memory; reclaimed pages read
+    // back as zeros
+    virtual status_t DontNeedRange(uint64_t offset, uint64_t len) {
+        return MX_ERR_NOT_SUPPORTED;
+    }
+
+    // hint that a range of the vmo is about to be used; commits the range
+    // and clears any earlier don't-need hint on it
+    virtual status_t WillNeedRange(uint64_t offset, uint64_t len) {
+        return MX_ERR_NOT_SUPPORTED;
+    }
+
+    // free up to |max_pages| pages that have been hinted don't-need,
+    // returning the number freed
+    virtual size_t EvictDontNeedPages(size_t max_pages) {
+        return 0;
+    }
+
+    // Frees up to |max_pages| don't-need pages across every VMO in the
+    // system, oldest VMO first. Called from the OOM machinery; returns the
+    // number of pages freed.
+    static size_t ReclaimDontNeedPages(size_t max_pages);
+
     // Pin the given range of the vmo.  If any pages are not committed, this
     // returns a MX_ERR_NO_MEMORY.
     virtual status_t Pin(uint64_t offset, uint64_t len) {
@@ -131,6 +171,12 @@ public:
     // Sets the value returned by |user_id()|. May only be called once.
     void set_user_id(uint64_t user_id);
 
+    // Attaches a counter that is adjusted as pages are committed to and
+    // released from this object. May only be called once; pages already
+    // committed are credited to the counter. A no-op for objects that do
+    // not commit pmm pages.
+    virtual void set_page_counter(mxtl::RefPtr<VmPageCounter> counter) {}
+
     virtual void Dump(uint depth, bool verbose) = 0;
 
     // cache maintainence operations.
@@ -167,6 +213,14 @@ public:
     // returns an enum rather than adding a new method for each clone type.
     bool is_cow_clone() const;
 
+    // Returns the number of COW-clone ancestors between this VMO and the
+    // root of its clone tree; zero if this VMO is not a clone.
+    uint32_t clone_chain_depth() const;
+
+    // Called by the dispatcher layer when the last user handle to this VMO
+    // is closed. Gives the object a chance to compact its clone chain.
+    virtual void OnZeroHandles() {}
+
     // get a pointer to the page structure and/or physical address at the specified offset.
     // valid flags are VMM_PF_FLAG_*
     virtual status_t GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
@@ -40,11 +40,17 @@ public:
 
     size_t AllocatedPagesInRange(uint64_t offset, uint64_t len) const override;
 
+    void set_page_counter(mxtl::RefPtr<VmPageCounter> counter) override;
+
     status_t CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) override;
     status_t CommitRangeContiguous(uint64_t offset, uint64_t len, uint64_t* committed,
                                    uint8_t alignment_log2) override;
     status_t DecommitRange(uint64_t offset, uint64_t len, uint64_t* decommitted) override;
 
+    status_t DontNeedRange(uint64_t offset, uint64_t len) override;
+    status_t WillNeedRange(uint64_t offset, uint64_t len) override;
+    size_t EvictDontNeedPages(size_t max_pages) override;
+
     status_t Pin(uint64_t offset, uint64_t len) override;
     void Unpin(uint64_t offset, uint64_t len) override;
 
@@ -78,6 +84,8 @@ public:
         // Calls a Locked method of the child, which confuses analysis.
         TA_NO_THREAD_SAFETY_ANALYSIS;
 
+    void OnZeroHandles() override;
+
     void RangeChangeUpdateFromParentLocked(uint64_t offset, uint64_t len) override
         // Called under the parent's lock, which confuses analysis.
         TA_NO_THREAD_SAFETY_ANALYSIS;
@@ -120,6 +128,18 @@ private:
     // set our offset within our parent
     status_t SetParentOffsetLocked(uint64_t o) TA_REQ(lock_);
 
+    // If this VMO has become an unreferenced intermediate link in a clone
+    // chain, fold its pages into its only clone and splice the clone up to
+    // our own parent, appending any shadowed pages to |freed_list|.
+    // Returns true if the chain was flattened.
+    bool MergeIntoChildLocked(list_node* freed_list)
+        // Operates on the clone under our shared lock, which confuses
+        // analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // update the running committed page count, and the attached counter if any
+    void AdjustCommittedLocked(int64_t delta_pages) TA_REQ(lock_);
+
     // maximum size of a VMO is one page less than the full 64bit range
     static const uint64_t MAX_SIZE = ROUNDDOWN(UINT64_MAX, PAGE_SIZE);
 
@@ -128,6 +148,13 @@ private:
     uint64_t parent_offset_ TA_GUARDED(lock_) = 0;
     uint32_t pmm_alloc_flags_ TA_GUARDED(lock_) = PMM_ALLOC_FLAG_ANY;
 
+    // running count of pages in page_list_, so whole-object queries don't
+    // need to walk the list
+    size_t committed_pages_ TA_GUARDED(lock_) = 0;
+
+    // optional counter billed for our committed pages
+    mxtl::RefPtr<VmPageCounter> page_counter_ TA_GUARDED(lock_);
+
     // a tree of pages
     VmPageList page_list_ TA_GUARDED(lock_);
 };
@@ -189,8 +189,25 @@ public:
     status_t AddPage(vm_page*, uint64_t offset);
     vm_page* GetPage(uint64_t offset);
     status_t FreePage(uint64_t offset);
+    // Frees every page with start_offset <= offset < end_offset, returning
+    // them to the pmm in a single batch. Returns the number of pages freed.
+    size_t FreePagesInRange(uint64_t start_offset, uint64_t end_offset);
     size_t FreeAllPages();
+    // Removes any tree nodes whose page slots are all empty. Callers that
+    // null out page slots directly (rather than going through FreePage)
+    // should call this when they're done.
+    void PruneEmptyNodes();
 
 private:
+    // Look up the node covering |node_offset|, checking the single entry
+    // lookup cache before descending the tree. Sequential fault, commit and
+    // read/write paths hit the same node kPageFanOut times in a row, so the
+    // cache turns most of those tree walks into a compare.
+    VmPageListNode* LookupNodeLocked(uint64_t node_offset);
+
     mxtl::WAVLTree<uint64_t, mxtl::unique_ptr<VmPageListNode>> list_;
+
+    // last node returned by LookupNodeLocked, cleared whenever a node is
+    // erased from the tree
+    VmPageListNode* cached_node_ = nullptr;
 };
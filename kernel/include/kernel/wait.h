@@ -20,16 +20,22 @@ __BEGIN_CDECLS;
 /* wait queue stuff */
 #define WAIT_QUEUE_MAGIC (0x77616974) // 'wait'
 
+/* Waiters are kept in priority buckets: |heads| is a list of distinct-
+ * priority bucket heads sorted from highest to lowest effective priority,
+ * and each head chains the FIFO sublist of threads at its priority through
+ * its queue_node.  Waking always takes the head of the first bucket, so
+ * wake-one is O(1) no matter how many threads are blocked.
+ */
 typedef struct wait_queue {
     int magic;
-    struct list_node list;
+    struct list_node heads;
     int count;
 } wait_queue_t;
 
 #define WAIT_QUEUE_INITIAL_VALUE(q) \
 { \
     .magic = WAIT_QUEUE_MAGIC, \
-    .list = LIST_INITIAL_VALUE((q).list), \
+    .heads = LIST_INITIAL_VALUE((q).heads), \
     .count = 0 \
 }
 
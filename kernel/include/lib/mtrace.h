@@ -23,3 +23,9 @@ status_t mtrace_control(uint32_t kind, uint32_t action, uint32_t options,
 status_t mtrace_ipt_control(uint32_t action, uint32_t options,
                             void* arg, uint32_t size);
 #endif
+
+status_t mtrace_profile_control(uint32_t action, uint32_t options,
+                                void* arg, uint32_t size);
+
+status_t mtrace_pmu_control(uint32_t action, uint32_t options,
+                            void* arg, uint32_t size);
@@ -42,6 +42,15 @@ enum lk_init_flags {
     LK_INIT_FLAG_ALL_CPUS        = LK_INIT_FLAG_PRIMARY_CPU | LK_INIT_FLAG_SECONDARY_CPUS,
     LK_INIT_FLAG_CPU_SUSPEND     = 0x4,
     LK_INIT_FLAG_CPU_RESUME      = 0x8,
+
+    /* The hook has no ordering dependency on other hooks at its own level and
+     * may be run on a worker thread, concurrently with other parallel hooks at
+     * the same level.  The level boundary is the dependency edge: all hooks at
+     * a level (parallel or not) complete before any hook at a higher level
+     * runs.  Only honored for primary cpu hooks at LK_INIT_LEVEL_THREADING or
+     * later; elsewhere the flag is ignored and the hook runs in place.
+     */
+    LK_INIT_FLAG_PARALLEL        = 0x10,
 };
 
 void lk_init_level(enum lk_init_flags flags, uint start_level, uint stop_level);
@@ -75,4 +84,7 @@ struct lk_init_struct {
 #define LK_INIT_HOOK(_name, _hook, _level) \
     LK_INIT_HOOK_FLAGS(_name, _hook, _level, LK_INIT_FLAG_PRIMARY_CPU)
 
+#define LK_INIT_HOOK_PARALLEL(_name, _hook, _level) \
+    LK_INIT_HOOK_FLAGS(_name, _hook, _level, LK_INIT_FLAG_PRIMARY_CPU | LK_INIT_FLAG_PARALLEL)
+
 __END_CDECLS
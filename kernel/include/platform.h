@@ -39,6 +39,24 @@ lk_time_t current_time(void);
 /* high-precision timer ticks per second */
 uint64_t ticks_per_second(void);
 
+/* identity of the raw counter backing current_time(), as far as user mode
+ * is concerned; used by the vDSO to read the monotonic clock without a
+ * syscall */
+typedef enum {
+    MONO_TICKS_SYSCALL = 0, /* user mode cannot read the counter */
+    MONO_TICKS_TSC,
+    MONO_TICKS_CNTVCT,
+    MONO_TICKS_CNTPCT,
+} mono_ticks_source_t;
+
+struct fp_32_64;
+
+/* If the counter backing current_time() can be read from user mode, report
+ * which counter it is and fill in the exact ticks->nanoseconds conversion
+ * factor current_time() applies to it.  Returns MONO_TICKS_SYSCALL when
+ * user mode has to enter the kernel for the monotonic clock. */
+mono_ticks_source_t platform_usermode_ticks_source(struct fp_32_64 *ns_per_tick);
+
 /* super early platform initialization, before almost everything */
 void platform_early_init(void);
 
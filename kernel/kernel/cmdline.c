@@ -4,7 +4,9 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <kernel/cmdline.h>
@@ -13,6 +15,57 @@ char __kernel_cmdline[CMDLINE_MAX];
 unsigned __kernel_cmdline_size;
 unsigned __kernel_cmdline_count;
 
+// Hash index over the parsed options, rebuilt by cmdline_append(), so
+// that the cmdline_get calls scattered over the boot critical path do
+// not rescan the whole line.  Each slot holds offset+1 of an option's
+// first character in __kernel_cmdline, or 0 if the slot is empty.
+// Every option occupies at least "x=\0" (three bytes), so there can be
+// at most CMDLINE_MAX/3 options and the table can never fill.
+#define CMDLINE_INDEX_SLOTS 2048
+static_assert(CMDLINE_INDEX_SLOTS > CMDLINE_MAX / 3, "");
+static_assert((CMDLINE_INDEX_SLOTS & (CMDLINE_INDEX_SLOTS - 1)) == 0, "");
+static uint16_t cmdline_index[CMDLINE_INDEX_SLOTS];
+
+// FNV-1a over the key portion of an option (everything before '=')
+static uint32_t cmdline_hash(const char* key, unsigned len) {
+    uint32_t hash = 2166136261u;
+    for (unsigned i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static unsigned cmdline_key_len(const char* key) {
+    unsigned len = 0;
+    while (key[len] && (key[len] != '=')) {
+        len++;
+    }
+    return len;
+}
+
+static void cmdline_index_rebuild(void) {
+    memset(cmdline_index, 0, sizeof(cmdline_index));
+
+    for (const char* opt = __kernel_cmdline; *opt != 0; opt = strchr(opt, 0) + 1) {
+        unsigned len = cmdline_key_len(opt);
+        uint32_t slot = cmdline_hash(opt, len) & (CMDLINE_INDEX_SLOTS - 1);
+        for (;;) {
+            uint16_t off = cmdline_index[slot];
+            if (off == 0) {
+                cmdline_index[slot] = (uint16_t)(opt - __kernel_cmdline) + 1;
+                break;
+            }
+            const char* other = __kernel_cmdline + (off - 1);
+            if (!strncmp(other, opt, len) && (other[len] == '=')) {
+                // the earlier occurrence wins, as it did for the
+                // linear scan
+                break;
+            }
+            slot = (slot + 1) & (CMDLINE_INDEX_SLOTS - 1);
+        }
+    }
+}
+
 // import into kernel commandline, converting invalid
 // characters to '.', combining multiple spaces, and
 // converting into a \0 separated, \0\0 terminated
@@ -64,26 +117,25 @@ void cmdline_append(const char* data) {
     __kernel_cmdline[i++] = 0;
     __kernel_cmdline[i] = 0;
     __kernel_cmdline_size = i;
+
+    cmdline_index_rebuild();
 }
 
 const char* cmdline_get(const char* key) {
     if (!key) return __kernel_cmdline;
-    unsigned sz = strlen(key);
-    const char* ptr = __kernel_cmdline;
+    unsigned sz = cmdline_key_len(key);
+    uint32_t slot = cmdline_hash(key, sz) & (CMDLINE_INDEX_SLOTS - 1);
     for (;;) {
-        if (!strncmp(ptr, key, sz)) {
-            break;
-        }
-        ptr = strchr(ptr, 0) + 1;
-        if (*ptr == 0) {
+        uint16_t off = cmdline_index[slot];
+        if (off == 0) {
             return NULL;
         }
+        const char* opt = __kernel_cmdline + (off - 1);
+        if (!strncmp(opt, key, sz) && (opt[sz] == '=')) {
+            return opt + sz + 1;
+        }
+        slot = (slot + 1) & (CMDLINE_INDEX_SLOTS - 1);
     }
-    ptr += sz;
-    if (*ptr == '=') {
-        ptr++;
-    }
-    return ptr;
 }
 
 bool cmdline_get_bool(const char* key, bool _default) {
@@ -18,6 +18,7 @@
 
 #include <debug.h>
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <kernel/percpu.h>
@@ -33,6 +34,7 @@
 static int cmd_thread(int argc, const cmd_args *argv, uint32_t flags);
 static int cmd_threadstats(int argc, const cmd_args *argv, uint32_t flags);
 static int cmd_threadload(int argc, const cmd_args *argv, uint32_t flags);
+static int cmd_percpu(int argc, const cmd_args *argv, uint32_t flags);
 static int cmd_kill(int argc, const cmd_args *argv, uint32_t flags);
 
 STATIC_COMMAND_START
@@ -41,6 +43,7 @@ STATIC_COMMAND_MASKED("thread", "list kernel threads with options", &cmd_thread,
 #endif
 STATIC_COMMAND("threadstats", "thread level statistics", &cmd_threadstats)
 STATIC_COMMAND("threadload", "toggle thread load display", &cmd_threadload)
+STATIC_COMMAND("percpu", "dump the per-cpu structure layout", &cmd_percpu)
 STATIC_COMMAND("kill", "kill a thread", &cmd_kill)
 STATIC_COMMAND_END(kernel);
 
@@ -101,6 +104,30 @@ static int cmd_threadstats(int argc, const cmd_args *argv, uint32_t flags)
     return 0;
 }
 
+static int cmd_percpu(int argc, const cmd_args *argv, uint32_t flags)
+{
+    printf("struct percpu: %zu bytes per cpu, %u cpus, %zu bytes total, %u byte cache lines\n",
+           sizeof(struct percpu), SMP_MAX_CPUS, sizeof(percpu), MAX_CACHE_LINE);
+    printf("%-20s %8s %8s %s\n", "field", "offset", "size", "lines");
+
+#define PERCPU_FIELD(name) \
+    printf("%-20s %8zu %8zu %zu-%zu\n", #name, \
+           offsetof(struct percpu, name), sizeof(percpu[0].name), \
+           offsetof(struct percpu, name) / MAX_CACHE_LINE, \
+           (offsetof(struct percpu, name) + sizeof(percpu[0].name) - 1) / MAX_CACHE_LINE)
+
+    PERCPU_FIELD(run_queue_bitmap);
+    PERCPU_FIELD(run_queue);
+    PERCPU_FIELD(preempt_timer);
+    PERCPU_FIELD(timer_wheel);
+    PERCPU_FIELD(stats);
+    PERCPU_FIELD(idle_thread);
+
+#undef PERCPU_FIELD
+
+    return 0;
+}
+
 static enum handler_return threadload(struct timer *t, lk_time_t now, void *arg)
 {
     static struct cpu_stats old_stats[SMP_MAX_CPUS];
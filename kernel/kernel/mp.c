@@ -31,8 +31,19 @@ struct mp_state mp __CPU_ALIGN = {
 };
 
 /* Helpers used for implementing mp_sync */
-struct mp_sync_context;
-static void mp_sync_task(void *context);
+struct mp_sync_vec_context;
+static void mp_sync_vec_task(void *context);
+
+/* per cpu topology and the sibling/package masks derived from it. Written
+ * during single threaded boot as each cpu's topology is registered, read
+ * racily by the scheduler afterwards, which is safe since a mask is a
+ * single word. cpus with no registered topology keep zeroed masks and the
+ * accessors hand back degenerate defaults for them, so registration order
+ * against the rest of boot doesn't matter. */
+static mp_cpu_topology_t cpu_topology[SMP_MAX_CPUS];
+static bool cpu_topology_valid[SMP_MAX_CPUS];
+static mp_cpu_mask_t cpu_smt_sibling_mask[SMP_MAX_CPUS];
+static mp_cpu_mask_t cpu_package_mask[SMP_MAX_CPUS];
 
 void mp_init(void)
 {
@@ -42,6 +53,67 @@ void mp_init(void)
     }
 }
 
+void mp_set_cpu_topology(uint cpu_id, const mp_cpu_topology_t *topo)
+{
+    DEBUG_ASSERT(cpu_id < SMP_MAX_CPUS);
+    DEBUG_ASSERT(topo);
+
+    cpu_topology[cpu_id] = *topo;
+    cpu_topology_valid[cpu_id] = true;
+
+    /* recompute the derived masks from scratch; this runs once per cpu at
+     * boot so the n^2 walk doesn't matter */
+    for (uint i = 0; i < SMP_MAX_CPUS; ++i) {
+        if (!cpu_topology_valid[i])
+            continue;
+
+        mp_cpu_mask_t siblings = 0;
+        mp_cpu_mask_t package = 0;
+        for (uint j = 0; j < SMP_MAX_CPUS; ++j) {
+            if (!cpu_topology_valid[j])
+                continue;
+            if (cpu_topology[j].package_id != cpu_topology[i].package_id)
+                continue;
+            package |= 1u << j;
+            if (cpu_topology[j].core_id == cpu_topology[i].core_id)
+                siblings |= 1u << j;
+        }
+        cpu_smt_sibling_mask[i] = siblings;
+        cpu_package_mask[i] = package;
+    }
+}
+
+void mp_get_cpu_topology(uint cpu_id, mp_cpu_topology_t *topo)
+{
+    DEBUG_ASSERT(cpu_id < SMP_MAX_CPUS);
+    DEBUG_ASSERT(topo);
+
+    if (cpu_topology_valid[cpu_id]) {
+        *topo = cpu_topology[cpu_id];
+    } else {
+        /* treat an unregistered cpu as its own physical core */
+        topo->package_id = 0;
+        topo->core_id = cpu_id;
+        topo->smt_id = 0;
+    }
+}
+
+mp_cpu_mask_t mp_get_smt_sibling_mask(uint cpu_id)
+{
+    DEBUG_ASSERT(cpu_id < SMP_MAX_CPUS);
+
+    mp_cpu_mask_t mask = cpu_smt_sibling_mask[cpu_id];
+    return mask ? mask : (1u << cpu_id);
+}
+
+mp_cpu_mask_t mp_get_package_mask(uint cpu_id)
+{
+    DEBUG_ASSERT(cpu_id < SMP_MAX_CPUS);
+
+    mp_cpu_mask_t mask = cpu_package_mask[cpu_id];
+    return mask ? mask : (mp_cpu_mask_t)~0u;
+}
+
 void mp_reschedule(mp_cpu_mask_t target, uint flags)
 {
     if (target == 0)
@@ -69,20 +141,28 @@ void mp_reschedule(mp_cpu_mask_t target, uint flags)
     arch_mp_send_ipi(target, MP_IPI_RESCHEDULE);
 }
 
-struct mp_sync_context {
-    mp_sync_task_t task;
-    void *task_context;
-    /* Mask of which CPUs need to finish the task */
+struct mp_sync_vec_context {
+    const mp_sync_vec_t *vec;
+    size_t count;
+    /* Mask of which CPUs need to finish their tasks */
     volatile mp_cpu_mask_t outstanding_cpus;
 };
 
-static void mp_sync_task(void *raw_context)
+static void mp_sync_vec_task(void *raw_context)
 {
-    struct mp_sync_context *context = raw_context;
-    context->task(context->task_context);
+    struct mp_sync_vec_context *context = raw_context;
+    mp_cpu_mask_t cpu_bit = 1U << arch_curr_cpu_num();
+
+    /* run every vector entry that targets this cpu */
+    for (size_t i = 0; i < context->count; ++i) {
+        if (context->vec[i].target & cpu_bit) {
+            context->vec[i].task(context->vec[i].context);
+        }
+    }
+
     /* use seq-cst atomic to ensure this update is not seen before the
-     * side-effects of context->task */
-    atomic_and((int *)&context->outstanding_cpus, ~(1U << arch_curr_cpu_num()));
+     * side-effects of the tasks */
+    atomic_and((int *)&context->outstanding_cpus, ~cpu_bit);
     arch_spinloop_signal();
 }
 
@@ -96,8 +176,6 @@ static void mp_sync_task(void *raw_context)
  */
 void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
 {
-    uint num_cpus = arch_max_num_cpus();
-
     if (target == MP_CPU_ALL) {
         target = mp_get_online_mask();
     } else if (target == MP_CPU_ALL_BUT_LOCAL) {
@@ -107,6 +185,37 @@ void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
         target = mp_get_online_mask() & ~(1U << arch_curr_cpu_num());
     }
 
+    mp_sync_vec_t vec = {
+        .target = target,
+        .task = task,
+        .context = context,
+    };
+    mp_sync_exec_vec(&vec, 1);
+}
+
+/* @brief Execute a vector of (cpu mask, task) pairs in one IPI round, and
+ *        block on the calling CPU until every targeted CPU has finished
+ *        every entry that targets it.
+ *
+ * Each target must be an explicit cpu mask; resolve MP_CPU_ALL and
+ * MP_CPU_ALL_BUT_LOCAL before building the vector.  A single generic IPI
+ * is sent to the union of the targets and each CPU acknowledges once,
+ * after running all of its entries, so batching N operations here costs
+ * one cross-call instead of N.
+ */
+void mp_sync_exec_vec(const mp_sync_vec_t *vec, size_t count)
+{
+    uint num_cpus = arch_max_num_cpus();
+
+    DEBUG_ASSERT(vec != NULL);
+    DEBUG_ASSERT(count > 0);
+
+    mp_cpu_mask_t target = 0;
+    for (size_t i = 0; i < count; ++i) {
+        DEBUG_ASSERT(vec[i].target < (1U << SMP_MAX_CPUS));
+        target |= vec[i].target;
+    }
+
     /* Mask any offline CPUs from target list */
     target &= mp_get_online_mask();
 
@@ -123,15 +232,15 @@ void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
 
     /* create tasks to enqueue (we need one per target due to each containing
      * a linked list node */
-    struct mp_sync_context sync_context = {
-        .task = task,
-        .task_context = context,
+    struct mp_sync_vec_context sync_context = {
+        .vec = vec,
+        .count = count,
         .outstanding_cpus = target,
     };
 
     struct mp_ipi_task sync_tasks[SMP_MAX_CPUS] = {};
     for (uint i = 0; i < num_cpus; ++i) {
-        sync_tasks[i].func = mp_sync_task;
+        sync_tasks[i].func = mp_sync_vec_task;
         sync_tasks[i].context = &sync_context;
     }
 
@@ -153,7 +262,7 @@ void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
     DEBUG_ASSERT(status == MX_OK);
 
     if (targetting_self) {
-        mp_sync_task(&sync_context);
+        mp_sync_vec_task(&sync_context);
     }
     smp_mb();
 
@@ -199,6 +308,120 @@ void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
     spin_unlock_irqrestore(&mp.ipi_task_lock, irqstate);
 }
 
+/* State for an in-flight asynchronous cross-call, freed by whichever CPU
+ * acknowledges last */
+struct mp_async_context {
+    mp_sync_task_t task;
+    void *task_context;
+    mp_sync_task_t completion;
+    void *completion_context;
+    /* CPUs that still need to run the task */
+    volatile int outstanding;
+    struct mp_ipi_task ipi_tasks[SMP_MAX_CPUS];
+};
+
+static void mp_async_task(void *raw_context)
+{
+    struct mp_async_context *context = raw_context;
+
+    context->task(context->task_context);
+
+    /* use seq-cst atomic to ensure the task's side-effects are visible
+     * before the count drops; the last CPU to finish runs the completion */
+    if (atomic_add(&context->outstanding, -1) == 1) {
+        if (context->completion) {
+            context->completion(context->completion_context);
+        }
+        free(context);
+    }
+}
+
+/* @brief Execute a task on the specified CPUs without blocking the caller.
+ *
+ * Returns as soon as the IPI has been sent; |completion| (if non-NULL) is
+ * invoked once every targeted CPU has run |task|, on whichever CPU
+ * acknowledges last and possibly in interrupt context, so it must not
+ * block.  MP_CPU_ALL and MP_CPU_ALL_BUT_LOCAL are resolved as in
+ * mp_sync_exec().  Targeted CPUs must not go offline while the call is in
+ * flight (callers ordinarily hold off hotplug or target only themselves
+ * and their peers' online mask).
+ */
+status_t mp_async_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context,
+                       mp_sync_task_t completion, void *completion_context)
+{
+    uint num_cpus = arch_max_num_cpus();
+
+    if (target == MP_CPU_ALL) {
+        target = mp_get_online_mask();
+    } else if (target == MP_CPU_ALL_BUT_LOCAL) {
+        DEBUG_ASSERT(arch_ints_disabled());
+        target = mp_get_online_mask() & ~(1U << arch_curr_cpu_num());
+    }
+
+    /* Mask any offline CPUs from target list */
+    target &= mp_get_online_mask();
+
+    if (target == 0) {
+        /* nothing to run; complete immediately */
+        if (completion) {
+            completion(completion_context);
+        }
+        return MX_OK;
+    }
+
+    struct mp_async_context *async_context = calloc(1, sizeof(*async_context));
+    if (!async_context) {
+        return MX_ERR_NO_MEMORY;
+    }
+
+    async_context->task = task;
+    async_context->task_context = context;
+    async_context->completion = completion;
+    async_context->completion_context = completion_context;
+    async_context->outstanding = __builtin_popcount(target);
+    for (uint i = 0; i < num_cpus; ++i) {
+        async_context->ipi_tasks[i].func = mp_async_task;
+        async_context->ipi_tasks[i].context = async_context;
+    }
+
+    /* disable interrupts so our current CPU doesn't change */
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    smp_mb();
+
+    uint local_cpu = arch_curr_cpu_num();
+    bool targetting_self = !!(target & (1U << local_cpu));
+    mp_cpu_mask_t remote = target & ~(1U << local_cpu);
+
+    /* enqueue tasks */
+    spin_lock(&mp.ipi_task_lock);
+    mp_cpu_mask_t remaining = remote;
+    uint cpu_id = 0;
+    while (remaining && cpu_id < num_cpus) {
+        if (remaining & 1) {
+            list_add_tail(&mp.ipi_task_list[cpu_id], &async_context->ipi_tasks[cpu_id].node);
+        }
+        remaining >>= 1;
+        cpu_id++;
+    }
+    spin_unlock(&mp.ipi_task_lock);
+
+    /* let CPUs know to begin executing */
+    if (remote) {
+        __UNUSED status_t status = arch_mp_send_ipi(remote, MP_IPI_GENERIC);
+        DEBUG_ASSERT(status == MX_OK);
+    }
+
+    if (targetting_self) {
+        /* may run the completion and free the context if we're last */
+        mp_async_task(async_context);
+    }
+
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    return MX_OK;
+}
+
 static void mp_unplug_trampoline(void) __NO_RETURN;
 static void mp_unplug_trampoline(void) {
     /* release the thread lock that was implicitly held across the reschedule */
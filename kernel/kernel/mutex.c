@@ -27,6 +27,45 @@
 
 #define LOCAL_TRACE 0
 
+/* maximum number of iterations to spin waiting for a running holder to
+ * release the mutex before falling back to blocking on the wait queue */
+#define MUTEX_SPIN_MAX_ITERATIONS 100u
+
+/* Adaptively spin on a contended mutex while its holder is actively running
+ * on another cpu, in the hope that it releases the mutex long before a block
+ * and reschedule round trip would have completed.  Returns true if the mutex
+ * was acquired.
+ *
+ * Spinning is abandoned as soon as another waiter has queued itself
+ * (MUTEX_FLAG_QUEUED) so that spinners cannot starve blocked threads, or if
+ * the holder stops running (it may have blocked or been preempted, in which
+ * case it will not release the mutex any time soon).
+ */
+static bool mutex_spin(mutex_t *m, thread_t *ct)
+{
+    for (uint spins = 0; spins < MUTEX_SPIN_MAX_ITERATIONS; spins++) {
+        uintptr_t val = mutex_val(m);
+        if (val == 0) {
+            uintptr_t oldval = 0;
+            if (atomic_cmpxchg_u64(&m->val, &oldval, (uintptr_t)ct))
+                return true;
+            continue;
+        }
+
+        if (val & MUTEX_FLAG_QUEUED)
+            break;
+
+        /* racy reads of the holder's scheduling state, but this is purely a
+         * heuristic; the queued/blocking path below remains the fallback */
+        thread_t *holder = (thread_t *)(val & ~MUTEX_FLAG_QUEUED);
+        if (holder->state != THREAD_RUNNING || holder->last_cpu == arch_curr_cpu_num())
+            break;
+
+        arch_spinloop_pause();
+    }
+    return false;
+}
+
 /**
  * @brief  Initialize a mutex_t
  */
@@ -87,7 +126,12 @@ retry:
               ct, ct->name, m);
 #endif
 
-    // we contended with someone else, will probably need to block
+    // we contended with someone else; spin a little while the holder is
+    // running elsewhere before committing to blocking
+    if (mutex_spin(m, ct))
+        return;
+
+    // will probably need to block
     THREAD_LOCK(state);
 
     // save the current state and check to see if it wasn't released in the interim
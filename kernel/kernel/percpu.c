@@ -7,6 +7,16 @@
 #include <kernel/percpu.h>
 
 #include <arch/ops.h>
+#include <stddef.h>
 
 struct percpu percpu[SMP_MAX_CPUS];
 
+/* each group of fields must start on its own cache line; see the layout
+ * notes in percpu.h */
+static_assert(offsetof(struct percpu, run_queue) % MAX_CACHE_LINE == 0, "");
+static_assert(offsetof(struct percpu, preempt_timer) % MAX_CACHE_LINE == 0, "");
+static_assert(offsetof(struct percpu, timer_wheel) % MAX_CACHE_LINE == 0, "");
+static_assert(offsetof(struct percpu, stats) % MAX_CACHE_LINE == 0, "");
+static_assert(offsetof(struct percpu, idle_thread) % MAX_CACHE_LINE == 0, "");
+static_assert(sizeof(struct percpu) % MAX_CACHE_LINE == 0, "");
+
@@ -0,0 +1,147 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+/**
+ * @file
+ * @brief  Sampling cpu profiler
+ *
+ * Each cpu re-arms a private oneshot timer at the sampling period. The
+ * timer callback walks the frame pointer chain leading out of the timer
+ * interrupt and logs the interrupted pc and its caller as a PROF_SAMPLE
+ * ktrace record; the record's common header supplies the timestamp and
+ * the tid of the interrupted thread. ktrace's group mask gates recording,
+ * so samples are cheap no-ops unless tracing is on with KTRACE_GRP_PROFILE.
+ *
+ * Only kernel addresses are walked; samples taken while user code was
+ * running attribute the time to the interrupted thread via the tid.
+ */
+
+#include <kernel/profile.h>
+
+#include <arch/ops.h>
+#include <err.h>
+#include <kernel/atomic.h>
+#include <kernel/mp.h>
+#include <kernel/mutex.h>
+#include <kernel/timer.h>
+#include <kernel/vm.h>
+#include <lib/ktrace.h>
+#include <magenta/compiler.h>
+#include <platform.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* how many frames to walk: the profiler's own frames plus the two we log */
+#define PROFILE_SKIP_FRAMES 2
+#define PROFILE_MAX_FRAMES (PROFILE_SKIP_FRAMES + 2)
+
+#define PROFILE_DEFAULT_PERIOD_US 1000u
+#define PROFILE_MIN_PERIOD_US 100u
+
+static mutex_t profile_lock = MUTEX_INITIAL_VALUE(profile_lock);
+static bool profile_timers_initialized;
+static timer_t profile_timer[SMP_MAX_CPUS];
+
+/* read with atomics from timer callbacks; written under profile_lock */
+static volatile int profile_active;
+static lk_time_t profile_period_ns;
+
+/* Walk the frame pointer chain, refusing to follow anything that does
+ * not look like a kernel stack frame. Best effort: leaf functions and
+ * code compiled without frame pointers truncate the walk early. */
+static size_t profile_backtrace(vaddr_t *pcs, size_t max)
+{
+    void **fp = __GET_FRAME();
+    size_t n = 0;
+
+    while (n < max) {
+        if (!is_kernel_address((vaddr_t)fp) || !IS_ALIGNED(fp, sizeof(void *)))
+            break;
+        vaddr_t pc = (vaddr_t)fp[1];
+        if (!is_kernel_address(pc))
+            break;
+        pcs[n++] = pc;
+        void **next = (void **)fp[0];
+        if (next <= fp) /* stacks grow down; refuse to walk in circles */
+            break;
+        fp = next;
+    }
+    return n;
+}
+
+static enum handler_return profile_tick(timer_t *t, lk_time_t now, void *arg)
+{
+    if (!atomic_load(&profile_active))
+        return INT_NO_RESCHEDULE;
+
+    vaddr_t pcs[PROFILE_MAX_FRAMES];
+    memset(pcs, 0, sizeof(pcs));
+    size_t n = profile_backtrace(pcs, countof(pcs));
+
+    /* skip our own frames; pcs[SKIP] is the interrupted code (or as close
+     * as the interrupt glue lets us get) and pcs[SKIP+1] its caller */
+    if (n > PROFILE_SKIP_FRAMES) {
+        uint64_t pc = pcs[PROFILE_SKIP_FRAMES];
+        uint64_t caller = pcs[PROFILE_SKIP_FRAMES + 1];
+        ktrace(TAG_PROF_SAMPLE,
+               (uint32_t)pc, (uint32_t)(pc >> 32),
+               (uint32_t)caller, (uint32_t)(caller >> 32));
+    }
+
+    timer_set_oneshot(t, now + profile_period_ns, profile_tick, NULL);
+    return INT_NO_RESCHEDULE;
+}
+
+static void profile_start_task(void *arg)
+{
+    timer_t *t = &profile_timer[arch_curr_cpu_num()];
+    timer_set_oneshot(t, current_time() + profile_period_ns, profile_tick, NULL);
+}
+
+status_t profile_start(uint32_t period_us)
+{
+    if (period_us == 0)
+        period_us = PROFILE_DEFAULT_PERIOD_US;
+    if (period_us < PROFILE_MIN_PERIOD_US)
+        return MX_ERR_INVALID_ARGS;
+
+    mutex_acquire(&profile_lock);
+    if (atomic_load(&profile_active)) {
+        mutex_release(&profile_lock);
+        return MX_ERR_BAD_STATE;
+    }
+
+    if (!profile_timers_initialized) {
+        for (uint i = 0; i < SMP_MAX_CPUS; i++)
+            timer_init(&profile_timer[i]);
+        profile_timers_initialized = true;
+    }
+
+    profile_period_ns = (lk_time_t)period_us * 1000u;
+    atomic_store(&profile_active, 1);
+    mp_sync_exec(MP_CPU_ALL, profile_start_task, NULL);
+    mutex_release(&profile_lock);
+
+    return MX_OK;
+}
+
+status_t profile_stop(void)
+{
+    mutex_acquire(&profile_lock);
+    if (!atomic_load(&profile_active)) {
+        mutex_release(&profile_lock);
+        return MX_ERR_BAD_STATE;
+    }
+
+    /* once clear, a callback that already fired declines to re-arm;
+     * timer_cancel mops up the rest and waits out in-flight callbacks */
+    atomic_store(&profile_active, 0);
+    for (uint i = 0; i < SMP_MAX_CPUS; i++)
+        timer_cancel(&profile_timer[i]);
+    mutex_release(&profile_lock);
+
+    return MX_OK;
+}
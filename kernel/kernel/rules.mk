@@ -23,9 +23,11 @@ MODULE_SRCS := \
 	$(LOCAL_DIR)/init.c \
 	$(LOCAL_DIR)/mutex.c \
 	$(LOCAL_DIR)/percpu.c \
+	$(LOCAL_DIR)/profile.c \
 	$(LOCAL_DIR)/sched.c \
 	$(LOCAL_DIR)/thread.c \
 	$(LOCAL_DIR)/timer.c \
+	$(LOCAL_DIR)/tripwire.c \
 	$(LOCAL_DIR)/mp.c \
 	$(LOCAL_DIR)/cmdline.c \
 
@@ -17,9 +17,9 @@
 #include <kernel/mp.h>
 #include <kernel/percpu.h>
 #include <kernel/thread.h>
-
-/* legacy implementation that just broadcast ipis for every reschedule */
-#define BROADCAST_RESCHEDULE 0
+#include <kernel/timer.h>
+#include <kernel/tripwire.h>
+#include <platform.h>
 
 /* disable priority boosting */
 #define NO_BOOST 0
@@ -37,19 +37,23 @@
 #define LOCAL_KTRACE2(probe, x, y)
 #endif
 
-/* the run queue */
-static struct list_node run_queue[NUM_PRIORITIES];
-static uint32_t run_queue_bitmap;
+/* the run queues live in the percpu structure, one set per cpu.
+ * all of them are still protected by the global thread lock, but keeping
+ * them per cpu means the local scheduling path never walks another cpu's
+ * queues and idle cpus can pull work over via the steal path below.
+ */
 
 /* make sure the bitmap is large enough to cover our number of priorities */
-static_assert(NUM_PRIORITIES <= sizeof(run_queue_bitmap) * CHAR_BIT, "");
+static_assert(NUM_PRIORITIES <= sizeof(((struct percpu *)0)->run_queue_bitmap) * CHAR_BIT, "");
 
-/* compute the effective priority of a thread */
+/* the effective priority of a thread is cached in the thread structure and
+ * kept up to date by the boost/deboost routines, so the insert paths don't
+ * recompute it on every run queue operation */
 static int effec_priority(const thread_t *t)
 {
-    int ep = t->base_priority + t->priority_boost;
-    DEBUG_ASSERT(ep >= LOWEST_PRIORITY && ep <= HIGHEST_PRIORITY);
-    return ep;
+    DEBUG_ASSERT(t->effec_priority == t->base_priority + t->priority_boost);
+    DEBUG_ASSERT(t->effec_priority >= LOWEST_PRIORITY && t->effec_priority <= HIGHEST_PRIORITY);
+    return t->effec_priority;
 }
 
 /* boost the priority of the thread by +1 */
@@ -61,9 +65,19 @@ static void boost_thread(thread_t *t)
     if (unlikely(thread_is_real_time_or_idle(t)))
         return;
 
+    /* deadline threads are ordered by deadline, not priority */
+    if (unlikely(thread_is_deadline(t)))
+        return;
+
+    /* IRQ threads already sit in their designated band; boosting them
+     * further would bleed into the DPC/real time range */
+    if (unlikely(thread_is_irq_thread(t)))
+        return;
+
     if (t->priority_boost < MAX_PRIORITY_ADJ &&
         likely((t->base_priority + t->priority_boost) < HIGHEST_PRIORITY)) {
         t->priority_boost++;
+        t->effec_priority = t->base_priority + t->priority_boost;
     }
 }
 
@@ -79,6 +93,15 @@ static void deboost_thread(thread_t *t, bool quantum_expiration)
     if (unlikely(thread_is_real_time_or_idle(t)))
         return;
 
+    /* deadline threads are ordered by deadline, not priority */
+    if (unlikely(thread_is_deadline(t)))
+        return;
+
+    /* IRQ threads keep their fixed band until it is explicitly revoked;
+     * quantum expiration round-robins them within the band instead */
+    if (unlikely(thread_is_irq_thread(t)))
+        return;
+
     int boost_floor;
     if (quantum_expiration) {
         /* deboost into negative boost */
@@ -99,21 +122,19 @@ static void deboost_thread(thread_t *t, bool quantum_expiration)
 
     /* drop a level */
     t->priority_boost--;
+    t->effec_priority = t->base_priority + t->priority_boost;
 }
 
-/* pick a 'random' cpu */
-static mp_cpu_mask_t rand_cpu(const mp_cpu_mask_t mask)
+/* pick a 'random' cpu out of the passed in mask of cpus */
+static uint rand_cpu(mp_cpu_mask_t mask)
 {
+    /* only consider online cpus */
+    mask &= mp_get_online_mask();
     if (unlikely(mask == 0))
-        return 0;
-
-    /* check that the mask passed in has at least one bit set in the online mask */
-    mp_cpu_mask_t online = mp_get_online_mask();
-    if (unlikely((mask & online) == 0))
-        return 0;
+        return arch_curr_cpu_num();
 
-    /* compute the highest online cpu */
-    uint highest_cpu = (sizeof(mp_cpu_mask_t) * CHAR_BIT - 1) - __builtin_clz(online);
+    /* compute the highest cpu in the mask */
+    uint highest_cpu = (sizeof(mp_cpu_mask_t) * CHAR_BIT - 1) - __builtin_clz(mask);
 
     /* not very random, round robins a bit through the mask until it gets a hit */
     for (;;) {
@@ -124,96 +145,354 @@ static mp_cpu_mask_t rand_cpu(const mp_cpu_mask_t mask)
             rot = 0;
 
         if ((1u << rot) & mask)
-            return (1u << rot);
+            return rot;
     }
 }
 
-/* find a cpu to wake up */
-static mp_cpu_mask_t find_cpu(thread_t *t)
+/* true if |t| may be placed on |cpu| under its pin and hard affinity */
+static bool cpu_allowed(const thread_t *t, uint cpu)
+{
+    if (unlikely(t->pinned_cpu >= 0))
+        return cpu == (uint)t->pinned_cpu;
+
+    /* a hard mask naming no online cpu is ignored rather than
+     * stranding the thread */
+    if (likely(t->hard_affinity == 0) ||
+        (t->hard_affinity & mp_get_online_mask()) == 0)
+        return true;
+
+    return (t->hard_affinity & (1u << cpu)) != 0;
+}
+
+/* find a cpu to place a newly runnable thread on */
+static uint find_cpu(thread_t *t)
 {
-    if (BROADCAST_RESCHEDULE)
-        return MP_CPU_ALL_BUT_LOCAL;
+    uint curr_cpu = arch_curr_cpu_num();
+
+    /* pinned threads can only go on their cpu */
+    if (unlikely(t->pinned_cpu >= 0))
+        return (uint)t->pinned_cpu;
+
+    /* hard affinity is a strict constraint; a mask that names no online
+     * cpu is ignored rather than stranding the thread */
+    mp_cpu_mask_t allowed = mp_get_online_mask();
+    if (unlikely(t->hard_affinity != 0) && (t->hard_affinity & allowed))
+        allowed &= t->hard_affinity;
 
-    /* get the last cpu the thread ran on */
-    mp_cpu_mask_t last_ran_cpu_mask = (1u << thread_last_cpu(t));
+    /* soft affinity narrows placement further for cache locality, but
+     * yields when none of its cpus are usable */
+    mp_cpu_mask_t preferred = allowed;
+    if (unlikely(t->soft_affinity != 0) && (t->soft_affinity & allowed))
+        preferred &= t->soft_affinity;
 
-    /* the current cpu */
-    mp_cpu_mask_t curr_cpu_mask = (1u << arch_curr_cpu_num());
+    /* the last cpu the thread ran on */
+    uint last_ran_cpu = thread_last_cpu(t);
 
-    /* get a list of idle cpus */
-    mp_cpu_mask_t idle_cpu_mask = mp_get_idle_mask();
+    /* get a list of idle cpus the thread may use */
+    mp_cpu_mask_t idle_cpu_mask = mp_get_idle_mask() & allowed;
     if (idle_cpu_mask != 0) {
-        if (idle_cpu_mask & curr_cpu_mask) {
+        /* an idle cpu inside the soft mask beats any idle cpu outside it */
+        if (idle_cpu_mask & preferred)
+            idle_cpu_mask &= preferred;
+
+        if (idle_cpu_mask & (1u << curr_cpu)) {
             /* the current cpu is idle, so run it here */
-            return 0;
+            return curr_cpu;
+        }
+
+        /* prefer cpus whose smt siblings are all idle, so two hot threads
+         * don't end up sharing a physical core while whole cores sit idle */
+        mp_cpu_mask_t idle_core_mask = 0;
+        mp_cpu_mask_t remaining = idle_cpu_mask;
+        while (remaining) {
+            uint cpu = __builtin_ctz(remaining);
+            remaining &= ~(1u << cpu);
+
+            mp_cpu_mask_t siblings = mp_get_smt_sibling_mask(cpu) & mp_get_online_mask();
+            if ((siblings & idle_cpu_mask) == siblings)
+                idle_core_mask |= (1u << cpu);
         }
 
-        if (last_ran_cpu_mask & idle_cpu_mask) {
-            /* the last core it ran on is idle and isn't the current cpu */
-            return last_ran_cpu_mask;
+        mp_cpu_mask_t candidates = idle_core_mask ? idle_core_mask : idle_cpu_mask;
+
+        if (candidates & (1u << last_ran_cpu)) {
+            /* the last cpu it ran on is a candidate and isn't the current cpu */
+            return last_ran_cpu;
         }
 
-        /* pick an idle_cpu */
-        return rand_cpu(idle_cpu_mask);
+        /* stay cache local: prefer candidates sharing a package with the
+         * last cpu the thread ran on */
+        mp_cpu_mask_t local_mask = candidates & mp_get_package_mask(last_ran_cpu);
+        if (local_mask)
+            return rand_cpu(local_mask);
+
+        /* pick an idle cpu */
+        return rand_cpu(candidates);
     }
 
-    /* no idle cpus */
-    if (last_ran_cpu_mask == curr_cpu_mask) {
-        /* the last cpu it ran on is us */
-        /* pick a random cpu that isn't the current one */
-        return rand_cpu(mp_get_online_mask() & ~(curr_cpu_mask));
+    /* no usable idle cpus */
+    if (!((1u << last_ran_cpu) & preferred)) {
+        /* migrate toward the preferred set */
+        return rand_cpu(preferred);
+    }
+    if (last_ran_cpu == curr_cpu) {
+        /* the last cpu it ran on is us, try to spread to another cpu */
+        return rand_cpu(preferred & ~(1u << curr_cpu));
     } else {
         /* pick the last cpu it ran on */
-        return last_ran_cpu_mask;
+        return last_ran_cpu;
+    }
+}
+
+/* where to requeue the current thread when its cpu reschedules; only
+ * differs from the local cpu when affinity changed out from under a
+ * running thread */
+static uint local_or_allowed_cpu(thread_t *t)
+{
+    uint curr_cpu = arch_curr_cpu_num();
+    if (likely(cpu_allowed(t, curr_cpu)))
+        return curr_cpu;
+    return find_cpu(t);
+}
+
+/* deadline class: threads with a (capacity, deadline, period) reservation
+ * run ahead of every fair and realtime priority, earliest absolute
+ * deadline first. A thread that burns its whole capacity before its
+ * period is up gets parked until the next period boundary, so a runaway
+ * deadline thread cannot starve the rest of the system. */
+
+/* roll the thread forward into the current period, refilling its budget */
+static void deadline_refresh(thread_t *t, lk_time_t now)
+{
+    if (now < t->dl_period_start + t->dl_period_ns)
+        return;
+
+    /* advance by whole periods so the activation pattern doesn't drift */
+    uint64_t elapsed = now - t->dl_period_start;
+    t->dl_period_start += (elapsed / t->dl_period_ns) * t->dl_period_ns;
+    t->dl_budget_ns = t->dl_capacity_ns;
+    t->dl_abs_deadline = t->dl_period_start + t->dl_deadline_ns;
+}
+
+static void insert_in_deadline_queue(uint cpu, thread_t *t)
+{
+    DEBUG_ASSERT(!list_in_list(&t->queue_node));
+
+    deadline_refresh(t, current_time());
+
+    /* sorted insert, earliest absolute deadline first */
+    thread_t *other;
+    list_for_every_entry(&percpu[cpu].deadline_queue, other, thread_t, queue_node) {
+        if (t->dl_abs_deadline < other->dl_abs_deadline) {
+            list_add_before(&other->queue_node, &t->queue_node);
+            return;
+        }
+    }
+    list_add_tail(&percpu[cpu].deadline_queue, &t->queue_node);
+}
+
+/* a throttled thread's period has rolled over; put it back in the race */
+static enum handler_return deadline_replenish_timer(timer_t *timer, lk_time_t now, void *arg)
+{
+    thread_t *t = (thread_t *)arg;
+
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    /* spin trylocking on the thread lock since sched_set_deadline may be
+     * trying to simultaneously cancel this timer while holding it */
+    if (timer_trylock_or_cancel(timer, &thread_lock))
+        return INT_NO_RESCHEDULE;
+
+    enum handler_return ret = INT_NO_RESCHEDULE;
+    if (t->dl_throttled) {
+        t->dl_throttled = false;
+        list_delete(&t->queue_node);
+        insert_in_deadline_queue(arch_curr_cpu_num(), t);
+        ret = INT_RESCHEDULE;
+    }
+
+    spin_unlock(&thread_lock);
+    return ret;
+}
+
+/* run queue latency tripwire: timestamp qualifying threads on insert,
+ * emit a ktrace probe if they waited past their budget when popped.
+ * both helpers collapse to a single predictable branch while the
+ * tripwire is disabled */
+static void queue_tripwire_arm(thread_t *t)
+{
+    if (unlikely(tripwire_queue_ns) && effec_priority(t) >= tripwire_queue_pri)
+        t->last_queued = current_time();
+    else
+        t->last_queued = 0;
+}
+
+static void queue_tripwire_check(thread_t *t)
+{
+    if (unlikely(tripwire_queue_ns) && t->last_queued != 0) {
+        lk_time_t waited = current_time() - t->last_queued;
+        t->last_queued = 0;
+        if (waited > tripwire_queue_ns) {
+            ktrace_probe2("tripwire_queue", (uint32_t)effec_priority(t),
+                          (uint32_t)(waited / 1000u));
+        }
     }
 }
 
 /* run queue manipulation */
-static void insert_in_run_queue_head(thread_t *t)
+static void insert_in_run_queue_head(uint cpu, thread_t *t)
 {
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
 
+    queue_tripwire_arm(t);
+
+    if (unlikely(thread_is_deadline(t))) {
+        insert_in_deadline_queue(cpu, t);
+        return;
+    }
+
     int ep = effec_priority(t);
 
-    list_add_head(&run_queue[ep], &t->queue_node);
-    run_queue_bitmap |= (1u << ep);
+    list_add_head(&percpu[cpu].run_queue[ep], &t->queue_node);
+    percpu[cpu].run_queue_bitmap |= (1u << ep);
 }
 
-static void insert_in_run_queue_tail(thread_t *t)
+static void insert_in_run_queue_tail(uint cpu, thread_t *t)
 {
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
 
+    queue_tripwire_arm(t);
+
+    if (unlikely(thread_is_deadline(t))) {
+        insert_in_deadline_queue(cpu, t);
+        return;
+    }
+
     int ep = effec_priority(t);
 
-    list_add_tail(&run_queue[ep], &t->queue_node);
-    run_queue_bitmap |= (1u << ep);
+    list_add_tail(&percpu[cpu].run_queue[ep], &t->queue_node);
+    percpu[cpu].run_queue_bitmap |= (1u << ep);
 }
 
-thread_t *sched_get_top_thread(uint cpu)
+/* remove a thread from the passed cpu's run queue, clearing the occupancy
+ * bit if its queue went empty */
+static void remove_from_run_queue(uint cpu, thread_t *t, uint queue)
+{
+    list_delete(&t->queue_node);
+
+    if (list_is_empty(&percpu[cpu].run_queue[queue]))
+        percpu[cpu].run_queue_bitmap &= ~(1u << queue);
+}
+
+/* the local run queue is empty, try to pull an unpinned thread over from
+ * the busiest priority level of another online cpu, searching cache local
+ * cpus first since crossing a package boundary drags the stolen thread's
+ * working set across the llc */
+static thread_t *steal_thread(uint local_cpu)
 {
-    thread_t *newthread;
-    uint32_t local_run_queue_bitmap = run_queue_bitmap;
+    mp_cpu_mask_t online = mp_get_online_mask() & ~(1u << local_cpu);
+    mp_cpu_mask_t package = mp_get_package_mask(local_cpu);
+
+    thread_t *best = NULL;
+    int best_queue = -1;
+    uint best_cpu = 0;
+
+    for (uint pass = 0; pass < 2 && !best; pass++) {
+        mp_cpu_mask_t remaining = (pass == 0) ? (online & package) : (online & ~package);
+
+        while (remaining) {
+            uint cpu = __builtin_ctz(remaining);
+            remaining &= ~(1u << cpu);
+
+            uint32_t bitmap = percpu[cpu].run_queue_bitmap;
+            while (bitmap) {
+                uint queue = HIGHEST_PRIORITY - __builtin_clz(bitmap)
+                             - (sizeof(bitmap) * CHAR_BIT - NUM_PRIORITIES);
+
+                /* queues at or below our best candidate can't do better */
+                if ((int)queue <= best_queue)
+                    break;
+
+                /* find the first thread in the queue allowed to run here,
+                 * skipping pinned and hard-affine threads */
+                thread_t *t;
+                list_for_every_entry(&percpu[cpu].run_queue[queue], t, thread_t, queue_node) {
+                    if (cpu_allowed(t, local_cpu)) {
+                        best = t;
+                        best_queue = (int)queue;
+                        best_cpu = cpu;
+                        break;
+                    }
+                }
+
+                bitmap &= ~(1u << queue);
+            }
+        }
+    }
 
-    while (local_run_queue_bitmap) {
-        /* find the first (remaining) queue with a thread in it */
-        uint next_queue = HIGHEST_PRIORITY - __builtin_clz(local_run_queue_bitmap)
-                          - (sizeof(run_queue_bitmap) * CHAR_BIT - NUM_PRIORITIES);
+    if (best) {
+        remove_from_run_queue(best_cpu, best, (uint)best_queue);
+        LOCAL_KTRACE2("sched_steal", best_cpu, best_queue);
+    }
 
-        list_for_every_entry(&run_queue[next_queue], newthread, thread_t, queue_node) {
-            if (likely(newthread->pinned_cpu < 0) || (uint)newthread->pinned_cpu == cpu) {
-                list_delete(&newthread->queue_node);
+    return best;
+}
 
-                if (list_is_empty(&run_queue[next_queue]))
-                    run_queue_bitmap &= ~(1<<next_queue);
+thread_t *sched_get_top_thread(uint cpu)
+{
+    /* deadline threads run ahead of every priority level, earliest
+     * absolute deadline first */
+    thread_t *dl;
+    while ((dl = list_peek_head_type(&percpu[cpu].deadline_queue, thread_t, queue_node)) != NULL) {
+        /* a thread that left the class while queued just runs once more */
+        if (unlikely(!thread_is_deadline(dl))) {
+            list_delete(&dl->queue_node);
+            queue_tripwire_check(dl);
+            return dl;
+        }
 
-                LOCAL_KTRACE2("sched_get_top", newthread->priority_boost, newthread->base_priority);
+        deadline_refresh(dl, current_time());
 
-                return newthread;
-            }
+        if (likely(dl->dl_budget_ns > 0)) {
+            list_delete(&dl->queue_node);
+            queue_tripwire_check(dl);
+            return dl;
         }
 
-        local_run_queue_bitmap &= ~(1<<next_queue);
+        /* burned its whole budget before the period was up; park it until
+         * the next period boundary */
+        list_delete(&dl->queue_node);
+        dl->dl_throttled = true;
+        list_add_tail(&percpu[cpu].deadline_throttled, &dl->queue_node);
+        timer_set_oneshot(&dl->dl_timer, dl->dl_period_start + dl->dl_period_ns,
+                          deadline_replenish_timer, dl);
     }
+
+    /* pop the highest priority thread from the local run queue */
+    uint32_t bitmap = percpu[cpu].run_queue_bitmap;
+    if (likely(bitmap)) {
+        uint queue = HIGHEST_PRIORITY - __builtin_clz(bitmap)
+                     - (sizeof(bitmap) * CHAR_BIT - NUM_PRIORITIES);
+
+        thread_t *newthread = list_peek_head_type(&percpu[cpu].run_queue[queue], thread_t, queue_node);
+        DEBUG_ASSERT(newthread);
+
+        remove_from_run_queue(cpu, newthread, queue);
+
+        queue_tripwire_check(newthread);
+
+        LOCAL_KTRACE2("sched_get_top", newthread->priority_boost, newthread->base_priority);
+
+        return newthread;
+    }
+
+    /* nothing local to run, try to steal work from another cpu */
+    thread_t *newthread = steal_thread(cpu);
+    if (newthread) {
+        queue_tripwire_check(newthread);
+        return newthread;
+    }
+
     /* no threads to run, select the idle thread for this cpu */
     return &percpu[cpu].idle_thread;
 }
@@ -244,11 +523,13 @@ void sched_unblock(thread_t *t)
     /* thread is being woken up, boost its priority */
     boost_thread(t);
 
-    /* stuff the new thread in the run queue */
+    /* stuff the new thread in the run queue of the cpu it should run on */
     t->state = THREAD_READY;
-    insert_in_run_queue_head(t);
+    uint cpu = find_cpu(t);
+    insert_in_run_queue_head(cpu, t);
 
-    mp_reschedule(find_cpu(t), 0);
+    if (cpu != arch_curr_cpu_num())
+        mp_reschedule(1u << cpu, 0);
 }
 
 void sched_unblock_list(struct list_node *list)
@@ -258,7 +539,10 @@ void sched_unblock_list(struct list_node *list)
 
     LOCAL_KTRACE0("sched_unblock_list");
 
-    /* pop the list of threads and shove into the scheduler */
+    /* pop the list of threads and shove into the scheduler, accumulating
+     * the set of cpus that picked up work so we can poke them all with a
+     * single reschedule IPI instead of one per thread */
+    mp_cpu_mask_t accum_cpu_mask = 0;
     thread_t *t;
     while ((t = list_remove_tail_type(list, thread_t, queue_node))) {
         DEBUG_ASSERT(t->magic == THREAD_MAGIC);
@@ -267,12 +551,18 @@ void sched_unblock_list(struct list_node *list)
         /* thread is being woken up, boost its priority */
         boost_thread(t);
 
-        /* stuff the new thread in the run queue */
+        /* stuff the new thread in the run queue of the cpu it should run on */
         t->state = THREAD_READY;
-        insert_in_run_queue_head(t);
+        uint cpu = find_cpu(t);
+        insert_in_run_queue_head(cpu, t);
 
-        mp_reschedule(find_cpu(t), 0);
+        accum_cpu_mask |= (1u << cpu);
     }
+
+    /* local placements are picked up on the way out of the thread lock */
+    accum_cpu_mask &= ~(1u << arch_curr_cpu_num());
+    if (accum_cpu_mask)
+        mp_reschedule(accum_cpu_mask, 0);
 }
 
 void sched_yield(void)
@@ -289,7 +579,10 @@ void sched_yield(void)
     /* consume the rest of the time slice, deboost ourself, and go to the end of the queue */
     current_thread->remaining_time_slice = 0;
     deboost_thread(current_thread, false);
-    insert_in_run_queue_tail(current_thread);
+    uint cpu = local_or_allowed_cpu(current_thread);
+    insert_in_run_queue_tail(cpu, current_thread);
+    if (unlikely(cpu != arch_curr_cpu_num()))
+        mp_reschedule(1u << cpu, 0);
 
     _thread_resched_internal();
 }
@@ -307,13 +600,16 @@ void sched_preempt(void)
 
     /* idle thread doesn't go in the run queue */
     if (likely(!thread_is_idle(current_thread))) {
+        uint cpu = local_or_allowed_cpu(current_thread);
         if (current_thread->remaining_time_slice > 0) {
-            insert_in_run_queue_head(current_thread);
+            insert_in_run_queue_head(cpu, current_thread);
         } else {
             /* if we're out of quantum, deboost the thread and put it at the tail of the queue */
             deboost_thread(current_thread, true);
-            insert_in_run_queue_tail(current_thread);
+            insert_in_run_queue_tail(cpu, current_thread);
         }
+        if (unlikely(cpu != arch_curr_cpu_num()))
+            mp_reschedule(1u << cpu, 0);
     }
 
     _thread_resched_internal();
@@ -336,20 +632,111 @@ void sched_reschedule(void)
         /* deboost the current thread */
         deboost_thread(current_thread, false);
 
+        uint cpu = local_or_allowed_cpu(current_thread);
         if (current_thread->remaining_time_slice > 0) {
-            insert_in_run_queue_head(current_thread);
+            insert_in_run_queue_head(cpu, current_thread);
         } else {
-            insert_in_run_queue_tail(current_thread);
+            insert_in_run_queue_tail(cpu, current_thread);
         }
+        if (unlikely(cpu != arch_curr_cpu_num()))
+            mp_reschedule(1u << cpu, 0);
     }
 
     _thread_resched_internal();
 }
 
+status_t sched_set_deadline(thread_t *t, uint64_t capacity_ns,
+                            uint64_t deadline_ns, uint64_t period_ns)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    if (period_ns != 0 &&
+        (capacity_ns == 0 || capacity_ns > deadline_ns || deadline_ns > period_ns))
+        return MX_ERR_INVALID_ARGS;
+
+    if (thread_is_idle(t))
+        return MX_ERR_BAD_STATE;
+
+    THREAD_LOCK(state);
+
+    if (period_ns == 0) {
+        /* leaving the class */
+        if (thread_is_deadline(t)) {
+            timer_cancel(&t->dl_timer);
+            if (t->dl_throttled) {
+                /* pull it off the parking lot and back into the fair
+                 * run queue of the cpu it was throttled on */
+                t->dl_throttled = false;
+                list_delete(&t->queue_node);
+                t->dl_period_ns = 0;
+                insert_in_run_queue_tail(thread_last_cpu(t), t);
+            }
+            t->dl_capacity_ns = 0;
+            t->dl_deadline_ns = 0;
+            t->dl_period_ns = 0;
+            /* a thread still sitting in a deadline queue runs once more
+             * from there and re-enters the fair queues afterwards */
+        }
+    } else {
+        lk_time_t now = current_time();
+
+        t->dl_capacity_ns = capacity_ns;
+        t->dl_deadline_ns = deadline_ns;
+        t->dl_period_ns = period_ns;
+        t->dl_period_start = now;
+        t->dl_budget_ns = capacity_ns;
+        t->dl_abs_deadline = now + deadline_ns;
+
+        /* boosts don't apply to the deadline class */
+        t->priority_boost = 0;
+        t->effec_priority = t->base_priority;
+
+        /* a thread already sitting in a fair run queue migrates into the
+         * deadline queue at its next enqueue; poke a remotely running one
+         * so it starts being accounted under deadline rules */
+        if (t->state == THREAD_RUNNING && t != get_current_thread())
+            mp_reschedule(1u << thread_last_cpu(t), 0);
+    }
+
+    THREAD_UNLOCK(state);
+    return MX_OK;
+}
+
+status_t sched_set_affinity(thread_t *t, uint32_t hard_mask, uint32_t soft_mask)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    if (thread_is_idle(t))
+        return MX_ERR_BAD_STATE;
+
+    /* a hard mask that names no active cpu could never run the thread */
+    if (hard_mask != 0 && (hard_mask & mp_get_active_mask()) == 0)
+        return MX_ERR_INVALID_ARGS;
+
+    THREAD_LOCK(state);
+
+    t->hard_affinity = hard_mask;
+    t->soft_affinity = soft_mask;
+
+    /* a thread already sitting in a run queue migrates at its next
+     * enqueue; poke the cpu of a remotely running thread that is no
+     * longer allowed there so it gets requeued somewhere legal */
+    if (t->state == THREAD_RUNNING && t != get_current_thread() &&
+        !cpu_allowed(t, thread_last_cpu(t)))
+        mp_reschedule(1u << thread_last_cpu(t), 0);
+
+    THREAD_UNLOCK(state);
+    return MX_OK;
+}
+
 void sched_init_early(void)
 {
     /* initialize the run queues */
-    for (unsigned int i=0; i < NUM_PRIORITIES; i++)
-        list_initialize(&run_queue[i]);
+    for (unsigned int cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        for (unsigned int i = 0; i < NUM_PRIORITIES; i++)
+            list_initialize(&percpu[cpu].run_queue[i]);
+        list_initialize(&percpu[cpu].deadline_queue);
+        list_initialize(&percpu[cpu].deadline_throttled);
+    }
 }
 
@@ -24,6 +24,7 @@
 #include <printf.h>
 #include <err.h>
 #include <kernel/percpu.h>
+#include <kernel/pmu.h>
 #include <kernel/sched.h>
 #include <kernel/stats.h>
 #include <kernel/thread.h>
@@ -52,6 +53,87 @@
 #define THREAD_INITIAL_TIME_SLICE LK_MSEC(50)
 #define THREAD_TICK_RATE          LK_MSEC(10)
 
+/* Per-cpu cache of dead threads' kernel stacks.  A recycled stack is still
+ * mapped and its lines are usually still cache resident, so thread-churn-heavy
+ * loads skip the heap on both creation and teardown.  The free-list node lives
+ * in the stack memory itself, overlapping the overrun padding, which is
+ * repainted on reuse.  With safe-stack enabled the paired unsafe stack travels
+ * with its stack so the pairing from allocation is preserved.  Only
+ * default-size, kernel-allocated stacks are cached.
+ */
+#define STACK_CACHE_MAX_DEPTH 4
+
+#if THREAD_STACK_BOUNDS_CHECK
+#define STACK_CACHE_STACK_SIZE (DEFAULT_STACK_SIZE + THREAD_STACK_PADDING_SIZE)
+#else
+#define STACK_CACHE_STACK_SIZE DEFAULT_STACK_SIZE
+#endif
+
+struct stack_cache_entry {
+    struct list_node node;
+    size_t stack_size;
+#if __has_feature(safe_stack)
+    void *unsafe_stack;
+#endif
+};
+
+static void *stack_cache_pop(size_t stack_size, void **unsafe_stack)
+{
+    void *stack = NULL;
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    struct percpu *pcpu = get_local_percpu();
+    struct stack_cache_entry *entry =
+        list_peek_head_type(&pcpu->stack_cache, struct stack_cache_entry, node);
+    if (entry && entry->stack_size == stack_size) {
+        list_delete(&entry->node);
+        pcpu->stack_cache_count--;
+        stack = (void *)entry;
+#if __has_feature(safe_stack)
+        *unsafe_stack = entry->unsafe_stack;
+#endif
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return stack;
+}
+
+static bool stack_cache_push(thread_t *t)
+{
+    if (t->stack_size != STACK_CACHE_STACK_SIZE)
+        return false;
+#if __has_feature(safe_stack)
+    if (!t->unsafe_stack)
+        return false;
+#endif
+
+    /* the stack is dead either way, so the entry can be written before we
+     * know whether there's room for it */
+    struct stack_cache_entry *entry = (struct stack_cache_entry *)t->stack;
+    entry->stack_size = t->stack_size;
+#if __has_feature(safe_stack)
+    entry->unsafe_stack = t->unsafe_stack;
+#endif
+
+    bool cached = false;
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    struct percpu *pcpu = get_local_percpu();
+    if (pcpu->stack_cache_count < STACK_CACHE_MAX_DEPTH) {
+        /* LIFO so the warmest stack goes out first */
+        list_add_head(&pcpu->stack_cache, &entry->node);
+        pcpu->stack_cache_count++;
+        cached = true;
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return cached;
+}
+
 /* global thread list */
 static struct list_node thread_list = LIST_INITIAL_VALUE(thread_list);
 
@@ -71,6 +153,7 @@ static void init_thread_struct(thread_t *t, const char *name)
     thread_set_pinned_cpu(t, -1);
     strlcpy(t->name, name, sizeof(t->name));
     wait_queue_init(&t->retcode_wait_queue);
+    timer_init(&t->dl_timer);
 }
 
 static void initial_thread_func(void) __NO_RETURN;
@@ -140,6 +223,7 @@ thread_t *thread_create_etc(
     t->arg = arg;
     t->base_priority = priority;
     t->priority_boost = 0;
+    t->effec_priority = priority;
     t->state = THREAD_INITIAL;
     t->signals = 0;
     t->blocking_wait_queue = NULL;
@@ -151,12 +235,17 @@ thread_t *thread_create_etc(
     wait_queue_init(&t->retcode_wait_queue);
 
     /* create the stack */
+    void *cached_unsafe_stack = NULL;
     if (!stack) {
 #if THREAD_STACK_BOUNDS_CHECK
         stack_size += THREAD_STACK_PADDING_SIZE;
         flags |= THREAD_FLAG_DEBUG_STACK_BOUNDS_CHECK;
 #endif
-        t->stack = malloc(stack_size);
+        /* a dead thread's stack (and its paired unsafe stack) may be
+         * waiting in the local cache */
+        t->stack = stack_cache_pop(stack_size, &cached_unsafe_stack);
+        if (!t->stack)
+            t->stack = malloc(stack_size);
         if (!t->stack) {
             if (flags & THREAD_FLAG_FREE_STRUCT)
                 free(t);
@@ -174,7 +263,7 @@ thread_t *thread_create_etc(
     if (!unsafe_stack) {
         DEBUG_ASSERT(!stack);
         DEBUG_ASSERT(flags & THREAD_FLAG_FREE_STACK);
-        t->unsafe_stack = malloc(stack_size);
+        t->unsafe_stack = cached_unsafe_stack ? cached_unsafe_stack : malloc(stack_size);
         if (!t->unsafe_stack) {
             free(t->stack);
             if (flags & THREAD_FLAG_FREE_STRUCT)
@@ -220,14 +309,15 @@ thread_t *thread_create(const char *name, thread_start_routine entry, void *arg,
 
 static void free_thread_resources(thread_t *t)
 {
-    /* free its stack and the thread structure itself */
+    /* recycle or free its stack and the thread structure itself */
     if (t->flags & THREAD_FLAG_FREE_STACK) {
-        if (t->stack)
+        if (t->stack && !stack_cache_push(t)) {
             free(t->stack);
 #if __has_feature(safe_stack)
-        if (t->unsafe_stack)
-            free(t->unsafe_stack);
+            if (t->unsafe_stack)
+                free(t->unsafe_stack);
 #endif
+        }
     }
 
     t->magic = 0;
@@ -487,6 +577,7 @@ __NO_RETURN static void thread_exit_locked(thread_t *current_thread, int retcode
          */
         if ((current_thread->flags & THREAD_FLAG_FREE_STACK && current_thread->stack) ||
             current_thread->flags & THREAD_FLAG_FREE_STRUCT) {
+            free_dpc = (dpc_t)DPC_INITIAL_VALUE;
             free_dpc.func = thread_free_dpc;
             free_dpc.arg = (void *)current_thread;
             dpc_queue_thread_locked(&free_dpc);
@@ -756,6 +847,17 @@ void _thread_resched_internal(void)
 
     CPU_STATS_INC(reschedules);
 
+    /* charge the outgoing deadline thread's budget up front, since it may
+     * already be back in the deadline queue where the pick below will
+     * consider it */
+    if (unlikely(thread_is_deadline(current_thread))) {
+        lk_time_t now = current_time();
+        lk_time_t ran = now - current_thread->last_started_running;
+        current_thread->dl_budget_ns -= MIN(ran, current_thread->dl_budget_ns);
+        current_thread->runtime_ns += ran;
+        current_thread->last_started_running = now;
+    }
+
     /* pick a new thread to run */
     thread_t *newthread = sched_get_top_thread(cpu);
 
@@ -800,20 +902,30 @@ void _thread_resched_internal(void)
         percpu[cpu].stats.idle_time += now - oldthread->last_started_running;
     }
 
+    /* charge the outgoing thread with its hardware counter deltas */
+    pmu_context_switch();
+
     ktrace(TAG_CONTEXT_SWITCH, (uint32_t)newthread->user_tid, cpu | (oldthread->state << 16),
            (uint32_t)(uintptr_t)oldthread, (uint32_t)(uintptr_t)newthread);
 
-    if (thread_is_real_time_or_idle(newthread)) {
-        if (!thread_is_real_time_or_idle(oldthread)) {
+    if (unlikely(thread_is_deadline(newthread))) {
+        /* preempt a deadline thread exactly when its remaining budget
+         * runs out */
+        TRACE_CONTEXT_SWITCH("deadline preempt, cpu %u, old %p (%s), new %p (%s)\n",
+                cpu, oldthread, oldthread->name, newthread, newthread->name);
+        timer_set_oneshot(&percpu[cpu].preempt_timer, now + newthread->dl_budget_ns,
+                          thread_timer_tick, NULL);
+    } else if (thread_is_real_time_or_idle(newthread)) {
+        if (!thread_is_real_time_or_idle(oldthread) || thread_is_deadline(oldthread)) {
             /* if we're switching from a non real time to a real time, cancel
              * the preemption timer. */
             TRACE_CONTEXT_SWITCH("stop preempt, cpu %u, old %p (%s), new %p (%s)\n",
                     cpu, oldthread, oldthread->name, newthread, newthread->name);
             timer_cancel(&percpu[cpu].preempt_timer);
         }
-    } else if (thread_is_real_time_or_idle(oldthread)) {
-        /* if we're switching from a real time (or idle thread) to a regular one,
-         * set up a periodic timer to run our preemption tick. */
+    } else if (thread_is_real_time_or_idle(oldthread) || thread_is_deadline(oldthread)) {
+        /* if we're switching from a real time, deadline or idle thread to a
+         * regular one, set up a periodic timer to run our preemption tick. */
         TRACE_CONTEXT_SWITCH("start preempt, cpu %u, old %p (%s), new %p (%s)\n",
                 cpu, oldthread, oldthread->name, newthread, newthread->name);
         timer_set_oneshot(&percpu[cpu].preempt_timer, now + THREAD_TICK_RATE, thread_timer_tick, NULL);
@@ -942,6 +1054,12 @@ static enum handler_return thread_timer_tick(struct timer *t, lk_time_t now, voi
 
     thread_t *current_thread = get_current_thread();
 
+    if (thread_is_deadline(current_thread)) {
+        /* the one shot was programmed to fire when the budget runs out;
+         * bounce through the scheduler to charge and throttle the thread */
+        return INT_RESCHEDULE;
+    }
+
     if (thread_is_real_time_or_idle(current_thread))
         return INT_NO_RESCHEDULE;
 
@@ -1090,6 +1208,7 @@ void thread_construct_first(thread_t *t, const char *name)
     init_thread_struct(t, name);
     t->base_priority = HIGHEST_PRIORITY;
     t->priority_boost = 0;
+    t->effec_priority = HIGHEST_PRIORITY;
     t->state = THREAD_RUNNING;
     t->flags = THREAD_FLAG_DETACHED;
     t->signals = 0;
@@ -1117,6 +1236,9 @@ void thread_init_early(void)
     thread_t *t = &percpu[0].idle_thread;
     thread_construct_first(t, "bootstrap");
 
+    for (uint i = 0; i < SMP_MAX_CPUS; i++)
+        list_initialize(&percpu[i].stack_cache);
+
     sched_init_early();
 }
 
@@ -1168,12 +1290,49 @@ void thread_set_priority(int priority)
         priority = HIGHEST_PRIORITY;
     current_thread->base_priority = priority;
     current_thread->priority_boost = 0;
+    current_thread->effec_priority = priority;
 
     sched_reschedule();
 
     THREAD_UNLOCK(state);
 }
 
+/**
+ * @brief Grant or revoke the IRQ thread band on the current thread
+ *
+ * IRQ threads run at a fixed priority above every fair thread but below DPCs
+ * and hard real time work, and are exempt from the scheduler's wakeup boost
+ * and quantum deboost machinery.  Interrupt dispatcher code grants the band
+ * to a driver thread before it blocks waiting for its interrupt, so that the
+ * wakeup and the driver's bottom half are not delayed behind CPU-bound fair
+ * threads, and revokes it again once the interrupt has been serviced.  The
+ * thread's previous base priority is restored on revocation.
+ */
+void thread_set_irq_thread(bool active)
+{
+    thread_t *current_thread = get_current_thread();
+
+    THREAD_LOCK(state);
+
+    if (active && !thread_is_irq_thread(current_thread)) {
+        current_thread->flags |= THREAD_FLAG_IRQ_THREAD;
+        current_thread->saved_base_priority = current_thread->base_priority;
+        current_thread->base_priority = IRQ_THREAD_PRIORITY;
+        current_thread->priority_boost = 0;
+        current_thread->effec_priority = IRQ_THREAD_PRIORITY;
+    } else if (!active && thread_is_irq_thread(current_thread)) {
+        current_thread->flags &= ~THREAD_FLAG_IRQ_THREAD;
+        current_thread->base_priority = current_thread->saved_base_priority;
+        current_thread->priority_boost = 0;
+        current_thread->effec_priority = current_thread->base_priority;
+
+        /* dropping out of the band may mean another thread should run now */
+        sched_reschedule();
+    }
+
+    THREAD_UNLOCK(state);
+}
+
 /**
  * @brief  Become an idle thread
  *
@@ -1194,6 +1353,7 @@ void thread_become_idle(void)
     /* mark ourself as idle */
     t->base_priority = IDLE_PRIORITY;
     t->priority_boost = 0;
+    t->effec_priority = IDLE_PRIORITY;
     t->flags |= THREAD_FLAG_IDLE;
     thread_set_pinned_cpu(t, arch_curr_cpu_num());
 
@@ -1318,6 +1478,9 @@ void dump_thread(thread_t *t, bool full_dump)
                 "remaining time slice %" PRIu64 "\n",
                 thread_state_to_str(t->state), t->last_cpu, t->pinned_cpu, t->base_priority,
                 t->priority_boost, t->remaining_time_slice);
+        if (t->hard_affinity || t->soft_affinity)
+            dprintf(INFO, "\thard_affinity %#x, soft_affinity %#x\n",
+                    t->hard_affinity, t->soft_affinity);
         dprintf(INFO, "\truntime_ns %" PRIu64 ", runtime_s %" PRIu64 "\n",
                 runtime, runtime / 1000000000);
         dprintf(INFO, "\tstack %p, stack_size %zu\n", t->stack, t->stack_size);
@@ -1390,6 +1553,75 @@ void wait_queue_init(wait_queue_t *wait)
     *wait = (wait_queue_t)WAIT_QUEUE_INITIAL_VALUE(*wait);
 }
 
+/* Add a thread to the proper priority bucket of a wait queue.
+ *
+ * The bucket heads are kept sorted from highest to lowest effective
+ * priority, so this walks at most one head per distinct priority
+ * (bounded by NUM_PRIORITIES) rather than one node per waiter.
+ */
+static void wait_queue_insert(wait_queue_t *wait, thread_t *t)
+{
+    if (list_is_empty(&wait->heads)) {
+        list_initialize(&t->queue_node);
+        list_add_head(&wait->heads, &t->wait_queue_heads_node);
+        return;
+    }
+
+    thread_t *temp;
+    list_for_every_entry(&wait->heads, temp, thread_t, wait_queue_heads_node) {
+        if (t->effec_priority > temp->effec_priority) {
+            /* insert ourself as the head of a new, higher priority bucket */
+            list_initialize(&t->queue_node);
+            list_add_before(&temp->wait_queue_heads_node, &t->wait_queue_heads_node);
+            return;
+        }
+        if (t->effec_priority == temp->effec_priority) {
+            /* same priority, queue FIFO behind the existing head */
+            list_add_tail(&temp->queue_node, &t->queue_node);
+            list_clear_node(&t->wait_queue_heads_node);
+            return;
+        }
+    }
+
+    /* lower priority than every existing bucket, new head at the tail */
+    list_initialize(&t->queue_node);
+    list_add_tail(&wait->heads, &t->wait_queue_heads_node);
+}
+
+/* Remove a bucket head, promoting the next thread at its priority (if any). */
+static void wait_queue_remove_head(thread_t *t)
+{
+    if (list_is_empty(&t->queue_node)) {
+        list_clear_node(&t->queue_node);
+        list_delete(&t->wait_queue_heads_node);
+    } else {
+        thread_t *newhead = list_peek_head_type(&t->queue_node, thread_t, queue_node);
+
+        /* deleting the old head's sentinel leaves the rest of the sublist
+         * circularly linked through the new head's queue_node */
+        list_delete(&t->queue_node);
+        list_replace_node(&t->wait_queue_heads_node, &newhead->wait_queue_heads_node);
+    }
+}
+
+static void wait_queue_remove_thread(thread_t *t)
+{
+    if (list_in_list(&t->wait_queue_heads_node)) {
+        wait_queue_remove_head(t);
+    } else {
+        list_delete(&t->queue_node);
+    }
+}
+
+/* Detach the highest priority waiter, or NULL if the queue is empty. */
+static thread_t *wait_queue_pop_head(wait_queue_t *wait)
+{
+    thread_t *t = list_peek_head_type(&wait->heads, thread_t, wait_queue_heads_node);
+    if (t)
+        wait_queue_remove_head(t);
+    return t;
+}
+
 static enum handler_return wait_queue_timeout_handler(timer_t *timer, lk_time_t now, void *arg)
 {
     thread_t *thread = (thread_t *)arg;
@@ -1453,7 +1685,7 @@ status_t wait_queue_block(wait_queue_t *wait, lk_time_t deadline)
         }
     }
 
-    list_add_tail(&wait->list, &current_thread->queue_node);
+    wait_queue_insert(wait, current_thread);
     wait->count++;
     current_thread->state = THREAD_BLOCKED;
     current_thread->blocking_wait_queue = wait;
@@ -1498,7 +1730,7 @@ int wait_queue_wake_one(wait_queue_t *wait, bool reschedule, status_t wait_queue
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(spin_lock_held(&thread_lock));
 
-    t = list_remove_head_type(&wait->list, thread_t, queue_node);
+    t = wait_queue_pop_head(wait);
     if (t) {
         wait->count--;
         DEBUG_ASSERT(t->state == THREAD_BLOCKED);
@@ -1523,7 +1755,7 @@ thread_t *wait_queue_dequeue_one(wait_queue_t *wait, status_t wait_queue_error)
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(spin_lock_held(&thread_lock));
 
-    t = list_remove_head_type(&wait->list, thread_t, queue_node);
+    t = wait_queue_pop_head(wait);
     if (t) {
         wait->count--;
         DEBUG_ASSERT(t->state == THREAD_BLOCKED);
@@ -1562,8 +1794,9 @@ int wait_queue_wake_all(wait_queue_t *wait, bool reschedule, status_t wait_queue
 
     struct list_node list = LIST_INITIAL_VALUE(list);
 
-    /* pop all the threads off the wait queue into the run queue */
-    while ((t = list_remove_head_type(&wait->list, thread_t, queue_node))) {
+    /* pop all the threads off the wait queue into the run queue,
+     * highest priority first */
+    while ((t = wait_queue_pop_head(wait))) {
         wait->count--;
 
         DEBUG_ASSERT(t->state == THREAD_BLOCKED);
@@ -1591,7 +1824,7 @@ bool wait_queue_is_empty(wait_queue_t *wait)
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(spin_lock_held(&thread_lock));
 
-    return list_is_empty(&wait->list);
+    return list_is_empty(&wait->heads);
 }
 
 /**
@@ -1609,7 +1842,7 @@ void wait_queue_destroy(wait_queue_t *wait)
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(spin_lock_held(&thread_lock));
 
-    if (!list_is_empty(&wait->list)) {
+    if (!list_is_empty(&wait->heads)) {
         panic("wait_queue_destroy() called on non-empty wait_queue_t\n");
     }
 
@@ -1641,7 +1874,7 @@ status_t thread_unblock_from_wait_queue(thread_t *t, status_t wait_queue_error)
     DEBUG_ASSERT(t->blocking_wait_queue->magic == WAIT_QUEUE_MAGIC);
     DEBUG_ASSERT(list_in_list(&t->queue_node));
 
-    list_delete(&t->queue_node);
+    wait_queue_remove_thread(t);
     t->blocking_wait_queue->count--;
     t->blocking_wait_queue = NULL;
     t->blocked_status = wait_queue_error;
@@ -29,6 +29,8 @@
 #include <kernel/stats.h>
 #include <kernel/thread.h>
 #include <kernel/timer.h>
+#include <kernel/tripwire.h>
+#include <lib/ktrace.h>
 #include <list.h>
 #include <malloc.h>
 #include <platform.h>
@@ -39,6 +41,8 @@
 
 static spin_lock_t timer_lock;
 
+#define TIMER_WHEEL_TICK (1ULL << TIMER_WHEEL_SHIFT)
+
 /**
  * @brief  Initialize a timer object
  */
@@ -47,28 +51,122 @@ void timer_init(timer_t *timer)
     *timer = (timer_t)TIMER_INITIAL_VALUE(*timer);
 }
 
-static void insert_timer_in_queue(uint cpu, timer_t *timer)
+/* convert a deadline in ns to the wheel tick in which it may fire, rounding
+ * up so that a timer never fires before its deadline */
+static uint64_t time_to_wheel_tick(lk_time_t t)
+{
+    /* saturate instead of overflowing for deadlines near the end of time */
+    if (unlikely(t >= UINT64_MAX - TIMER_WHEEL_TICK))
+        return UINT64_MAX >> TIMER_WHEEL_SHIFT;
+    return (t + TIMER_WHEEL_TICK - 1) >> TIMER_WHEEL_SHIFT;
+}
+
+/* span, in ticks, covered by wheel levels 0 through level inclusive */
+static uint64_t wheel_level_span(uint level)
 {
-    timer_t *entry;
+    return 1ULL << ((level + 1) * TIMER_WHEEL_LEVEL_BITS);
+}
 
+/* Place a timer in the wheel. Returns the tick at which the wheel will next
+ * visit it: its firing tick if it lands in level 0, otherwise the tick at
+ * which its slot cascades down a level. */
+static uint64_t wheel_insert(struct timer_wheel *w, timer_t *timer)
+{
     DEBUG_ASSERT(arch_ints_disabled());
 
-    LTRACEF("timer %p, cpu %u, scheduled %" PRIu64 "\n", timer, cpu, timer->scheduled_time);
+    uint64_t tick = time_to_wheel_tick(timer->scheduled_time);
+    if (tick < w->cur_tick)
+        tick = w->cur_tick;
+    uint64_t delta = tick - w->cur_tick;
+
+    uint level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= wheel_level_span(level))
+        level++;
+
+    /* past the top level's horizon; park it as far out as the wheel reaches,
+     * cascading will reposition it as time advances */
+    if (delta >= wheel_level_span(TIMER_WHEEL_LEVELS - 1))
+        tick = w->cur_tick + wheel_level_span(TIMER_WHEEL_LEVELS - 1) - 1;
+
+    uint slot = (tick >> (level * TIMER_WHEEL_LEVEL_BITS)) & TIMER_WHEEL_SLOT_MASK;
+    list_add_tail(&w->slots[level][slot], &timer->node);
+
+    LTRACEF("timer %p, scheduled %" PRIu64 ", level %u slot %u\n",
+            timer, timer->scheduled_time, level, slot);
+
+    /* level 0 slots are visited at their own tick, higher level slots when
+     * the wheel reaches the start of the slot's window */
+    return (level == 0) ? tick : (tick & ~(wheel_level_span(level - 1) - 1));
+}
+
+/* find the next tick at which the wheel has work to do, or UINT64_MAX */
+static uint64_t wheel_next_event(struct timer_wheel *w)
+{
+    if (w->count == 0)
+        return UINT64_MAX;
+
+    uint64_t next = UINT64_MAX;
 
-    list_for_every_entry(&percpu[cpu].timer_queue, entry, timer_t, node) {
-        if (TIME_GT(entry->scheduled_time, timer->scheduled_time)) {
-            list_add_before(&entry->node, &timer->node);
-            return;
+    for (uint slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+        if (list_is_empty(&w->slots[0][slot]))
+            continue;
+        uint64_t tick = w->cur_tick + ((slot - w->cur_tick) & TIMER_WHEEL_SLOT_MASK);
+        if (tick < next)
+            next = tick;
+    }
+
+    for (uint level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        for (uint slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            if (list_is_empty(&w->slots[level][slot]))
+                continue;
+            /* the tick at which this slot cascades */
+            uint64_t tick = (w->cur_tick & ~(wheel_level_span(level) - 1)) +
+                            ((uint64_t)slot << (level * TIMER_WHEEL_LEVEL_BITS));
+            if (tick < w->cur_tick)
+                tick += wheel_level_span(level);
+            if (tick < next)
+                next = tick;
         }
     }
 
-    /* walked off the end of the list */
-    list_add_tail(&percpu[cpu].timer_queue, &timer->node);
+    return next;
+}
+
+/* rearm the platform oneshot timer for the next wheel event, if any */
+static void wheel_arm(struct timer_wheel *w)
+{
+    uint64_t tick = wheel_next_event(w);
+    if (tick == UINT64_MAX) {
+        w->armed_deadline = UINT64_MAX;
+        return;
+    }
+
+    w->armed_deadline = tick << TIMER_WHEEL_SHIFT;
+    LTRACEF("setting new timer for %" PRIu64 " nsecs\n", w->armed_deadline);
+    platform_set_oneshot_timer(w->armed_deadline);
 }
 
-static void timer_set(timer_t *timer, lk_time_t deadline, timer_callback callback, void *arg)
+/**
+ * @brief  Set up a timer that executes once, with slack
+ *
+ * The timer fires no earlier than @a deadline and no later than
+ * @a deadline + @a slack.  Within that window the queue prefers expiry
+ * points it is already committed to: the deadline the hardware timer is
+ * armed for, or a wheel tick boundary shared with other slack-tolerant
+ * timers.  Uncorrelated housekeeping timers with overlapping windows
+ * therefore collapse onto a single interrupt instead of each waking the
+ * cpu at their own time.
+ *
+ * @param  timer The timer to use
+ * @param  deadline The earliest time, in ns, at which the timer may fire
+ * @param  slack How far past @a deadline, in ns, the timer may be deferred
+ * @param  callback  The function to call when the timer expires
+ * @param  arg  The argument to pass to the callback
+ */
+void timer_set(timer_t *timer, lk_time_t deadline, lk_time_t slack, timer_callback callback, void *arg)
 {
-    LTRACEF("timer %p, deadline %" PRIu64 ", callback %p, arg %p\n", timer, deadline, callback, arg);
+    LTRACEF("timer %p, deadline %" PRIu64 ", slack %" PRIu64 ", callback %p, arg %p\n",
+            timer, deadline, slack, callback, arg);
 
     DEBUG_ASSERT(timer->magic == TIMER_MAGIC);
 
@@ -80,6 +178,7 @@ static void timer_set(timer_t *timer, lk_time_t deadline, timer_callback callbac
     spin_lock_irqsave(&timer_lock, state);
 
     uint cpu = arch_curr_cpu_num();
+    struct timer_wheel *w = &percpu[cpu].timer_wheel;
 
     bool currently_active = (timer->active_cpu == (int)cpu);
     if (unlikely(currently_active)) {
@@ -90,6 +189,22 @@ static void timer_set(timer_t *timer, lk_time_t deadline, timer_callback callbac
         panic("timer %p currently active on a different cpu %d\n", timer, timer->active_cpu);
     }
 
+    /* coalesce: move the deadline within [deadline, deadline + slack] onto an
+     * expiry point that will be visited anyway */
+    if (slack > 0) {
+        lk_time_t latest = (deadline > UINT64_MAX - slack) ? UINT64_MAX : deadline + slack;
+        if (w->armed_deadline >= deadline && w->armed_deadline <= latest) {
+            /* ride the interrupt the hardware timer is already armed for */
+            deadline = w->armed_deadline;
+        } else if (latest - deadline >= TIMER_WHEEL_TICK) {
+            /* land on the last wheel tick boundary inside the window, so
+             * timers whose windows overlap pick the same tick */
+            lk_time_t aligned = latest & ~(TIMER_WHEEL_TICK - 1);
+            if (aligned >= deadline)
+                deadline = aligned;
+        }
+    }
+
     /* set up the structure */
     timer->scheduled_time = deadline;
     timer->callback = callback;
@@ -102,12 +217,24 @@ static void timer_set(timer_t *timer, lk_time_t deadline, timer_callback callbac
 
     LTRACEF("scheduled time %" PRIu64 "\n", timer->scheduled_time);
 
-    insert_timer_in_queue(cpu, timer);
+    /* an idle wheel may be arbitrarily far in the past; catch it up before
+     * inserting so the catch-up loop in timer_tick stays short */
+    if (w->count == 0) {
+        uint64_t now_tick = current_time() >> TIMER_WHEEL_SHIFT;
+        if (now_tick > w->cur_tick)
+            w->cur_tick = now_tick;
+    }
 
-    if (list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node) == timer) {
-        /* we just modified the head of the timer queue */
-        LTRACEF("setting new timer for %" PRIu64 " nsecs\n", deadline);
-        platform_set_oneshot_timer(deadline);
+    uint64_t event_tick = wheel_insert(w, timer);
+    w->count++;
+    timer->wheel_cpu = (int)cpu;
+
+    lk_time_t event = event_tick << TIMER_WHEEL_SHIFT;
+    if (event < w->armed_deadline) {
+        /* this timer's slot is visited before anything currently armed */
+        LTRACEF("setting new timer for %" PRIu64 " nsecs\n", event);
+        w->armed_deadline = event;
+        platform_set_oneshot_timer(event);
     }
 
 out:
@@ -115,7 +242,7 @@ out:
 }
 
 /**
- * @brief  Set up a timer that executes once
+ * @brief  Set up a timer that executes once, exactly at its deadline
  *
  * This function specifies a callback function to be run after a specified
  * deadline passes.  The function will be called one time.
@@ -130,7 +257,7 @@ out:
  */
 void timer_set_oneshot(timer_t *timer, lk_time_t deadline, timer_callback callback, void *arg)
 {
-    timer_set(timer, deadline, callback, arg);
+    timer_set(timer, deadline, 0u, callback, arg);
 }
 
 /**
@@ -170,28 +297,18 @@ bool timer_cancel(timer_t *timer)
 
     bool callback_not_running;
 
-    /* if the timer is in a queue, remove it and adjust hardware timers if needed */
+    /* if the timer is in a wheel, removal is a straight list delete */
     if (list_in_list(&timer->node)) {
         callback_not_running = true;
 
-        /* save a copy of the old head of the queue */
-        timer_t *oldhead = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
-
-        /* remove our timer from the queue */
         list_delete(&timer->node);
 
-        /* see if we've just modified the head of this cpu's timer queue */
-        /* if we modified another cpu's queue, we'll just let it fire and sort itself out */
-        if (unlikely(oldhead == timer)) {
-            timer_t *newhead = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
-            if (newhead) {
-                LTRACEF("setting new timer to %" PRIu64 "\n", newhead->scheduled_time);
-                platform_set_oneshot_timer(newhead->scheduled_time);
-            } else {
-                LTRACEF("clearing old hw timer, nothing in the queue\n");
-                platform_stop_timer();
-            }
-        }
+        DEBUG_ASSERT(timer->wheel_cpu >= 0);
+        percpu[timer->wheel_cpu].timer_wheel.count--;
+        timer->wheel_cpu = -1;
+
+        /* the hardware timer may still be armed for this timer's slot; let
+         * it fire, timer_tick will find nothing to do and rearm */
     } else {
         callback_not_running = false;
     }
@@ -226,61 +343,87 @@ enum handler_return timer_tick(lk_time_t now)
 
     spin_lock(&timer_lock);
 
-    for (;;) {
-        /* see if there's an event to process */
-        timer = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
-        if (likely(timer == 0))
-            break;
-        LTRACEF("next item on timer queue %p at %" PRIu64 " now %" PRIu64 " (%p, arg %p)\n", timer, timer->scheduled_time, now, timer->callback, timer->arg);
-        if (likely(TIME_LT(now, timer->scheduled_time)))
-            break;
-
-        /* process it */
-        LTRACEF("timer %p\n", timer);
-        DEBUG_ASSERT_MSG(timer && timer->magic == TIMER_MAGIC,
-                "ASSERT: timer failed magic check: timer %p, magic 0x%x\n",
-                timer, (uint)timer->magic);
-        list_delete(&timer->node);
-
-        /* mark the timer busy */
-        timer->active_cpu = cpu;
-        /* spinlock below acts as a memory barrier */
+    struct timer_wheel *w = &percpu[cpu].timer_wheel;
+    uint64_t now_tick = now >> TIMER_WHEEL_SHIFT;
 
-        /* we pulled it off the list, release the list lock to handle it */
-        spin_unlock(&timer_lock);
+    while (w->cur_tick <= now_tick) {
+        if (w->count == 0) {
+            /* nothing pending, no need to walk the empty ticks */
+            w->cur_tick = now_tick + 1;
+            break;
+        }
 
-        LTRACEF("dequeued timer %p, scheduled %" PRIu64 "\n", timer, timer->scheduled_time);
+        uint64_t tick = w->cur_tick;
+
+        /* cascade any higher level slots whose window opens at this tick */
+        for (uint level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if (tick & (wheel_level_span(level - 1) - 1))
+                break;
+            uint slot = (tick >> (level * TIMER_WHEEL_LEVEL_BITS)) & TIMER_WHEEL_SLOT_MASK;
+            timer_t *entry = NULL, *tmp_entry = NULL;
+            list_for_every_entry_safe(&w->slots[level][slot], entry, tmp_entry, timer_t, node) {
+                list_delete(&entry->node);
+                wheel_insert(w, entry);
+            }
+        }
 
-        CPU_STATS_INC(timers);
+        /* fire everything scheduled for this tick */
+        struct list_node *slot = &w->slots[0][tick & TIMER_WHEEL_SLOT_MASK];
+        while ((timer = list_peek_head_type(slot, timer_t, node)) != 0) {
+            /* process it */
+            LTRACEF("timer %p\n", timer);
+            DEBUG_ASSERT_MSG(timer && timer->magic == TIMER_MAGIC,
+                    "ASSERT: timer failed magic check: timer %p, magic 0x%x\n",
+                    timer, (uint)timer->magic);
+            list_delete(&timer->node);
+            timer->wheel_cpu = -1;
+            w->count--;
+
+            /* mark the timer busy */
+            timer->active_cpu = cpu;
+            /* spinlock below acts as a memory barrier */
+
+            /* we pulled it off the wheel, release the lock to handle it */
+            spin_unlock(&timer_lock);
+
+            LTRACEF("dequeued timer %p, scheduled %" PRIu64 "\n", timer, timer->scheduled_time);
+
+            CPU_STATS_INC(timers);
+
+            LTRACEF("timer %p firing callback %p, arg %p\n", timer, timer->callback, timer->arg);
+            lk_time_t cb_start = unlikely(tripwire_timer_ns) ? current_time() : 0;
+            timer_callback cb = timer->callback;
+            if (cb(timer, now, timer->arg) == INT_RESCHEDULE)
+                ret = INT_RESCHEDULE;
+            if (unlikely(tripwire_timer_ns)) {
+                /* the callback may have freed or requeued the timer, so
+                 * identify it by the callback's address */
+                lk_time_t took = current_time() - cb_start;
+                if (took > tripwire_timer_ns) {
+                    ktrace_probe2("tripwire_timer", (uint32_t)(uintptr_t)cb,
+                                  (uint32_t)(took / 1000u));
+                }
+            }
 
-        LTRACEF("timer %p firing callback %p, arg %p\n", timer, timer->callback, timer->arg);
-        if (timer->callback(timer, now, timer->arg) == INT_RESCHEDULE)
-            ret = INT_RESCHEDULE;
+            DEBUG_ASSERT(arch_ints_disabled());
+            /* it may have been requeued, grab the lock so we can safely inspect it */
+            spin_lock(&timer_lock);
 
-        DEBUG_ASSERT(arch_ints_disabled());
-        /* it may have been requeued, grab the lock so we can safely inspect it */
-        spin_lock(&timer_lock);
+            /* mark it not busy */
+            timer->active_cpu = -1;
+            smp_mb();
 
-        /* mark it not busy */
-        timer->active_cpu = -1;
-        smp_mb();
+            /* make sure any spinners wake up */
+            arch_spinloop_signal();
+        }
 
-        /* make sure any spinners wake up */
-        arch_spinloop_signal();
+        w->cur_tick = tick + 1;
     }
 
-    /* reset the timer to the next event */
-    timer = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
-    if (timer) {
-        /* has to be the case or it would have fired already */
-        DEBUG_ASSERT(TIME_GT(timer->scheduled_time, now));
+    /* reset the hardware timer to the next wheel event */
+    wheel_arm(w);
 
-        LTRACEF("setting new timer for %" PRIu64 " nsecs for event %p\n", timer->scheduled_time,
-                timer);
-        platform_set_oneshot_timer(timer->scheduled_time);
-    }
-
-    /* we're done manipulating the timer queue */
+    /* we're done manipulating the timer wheel */
     spin_unlock(&timer_lock);
 
     return ret;
@@ -310,21 +453,25 @@ void timer_transition_off_cpu(uint old_cpu)
     spin_lock_irqsave(&timer_lock, state);
     uint cpu = arch_curr_cpu_num();
 
-    timer_t *old_head = list_peek_head_type(&percpu[old_cpu].timer_queue, timer_t, node);
+    struct timer_wheel *old_wheel = &percpu[old_cpu].timer_wheel;
+    struct timer_wheel *w = &percpu[cpu].timer_wheel;
 
-    timer_t *entry = NULL, *tmp_entry = NULL;
     /* Move all timers from old_cpu to this cpu */
-    list_for_every_entry_safe(&percpu[old_cpu].timer_queue, entry, tmp_entry, timer_t, node) {
-        list_delete(&entry->node);
-        insert_timer_in_queue(cpu, entry);
+    for (uint level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (uint slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            timer_t *entry = NULL, *tmp_entry = NULL;
+            list_for_every_entry_safe(&old_wheel->slots[level][slot], entry, tmp_entry, timer_t, node) {
+                list_delete(&entry->node);
+                old_wheel->count--;
+                wheel_insert(w, entry);
+                w->count++;
+                entry->wheel_cpu = (int)cpu;
+            }
+        }
     }
+    old_wheel->armed_deadline = UINT64_MAX;
 
-    timer_t *new_head = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
-    if (new_head != NULL && new_head != old_head) {
-        /* we just modified the head of the timer queue */
-        LTRACEF("setting new timer for %" PRIu64 " nsecs\n", new_head->scheduled_time);
-        platform_set_oneshot_timer(new_head->scheduled_time);
-    }
+    wheel_arm(w);
 
     spin_unlock_irqrestore(&timer_lock, state);
 }
@@ -338,11 +485,7 @@ void timer_thaw_percpu(void)
 
     uint cpu = arch_curr_cpu_num();
 
-    timer_t *t = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
-    if (t) {
-        LTRACEF("rescheduling timer for %" PRIu64 " nsecs\n", t->scheduled_time);
-        platform_set_oneshot_timer(t->scheduled_time);
-    }
+    wheel_arm(&percpu[cpu].timer_wheel);
 
     spin_unlock(&timer_lock);
 }
@@ -351,7 +494,14 @@ void timer_queue_init(void)
 {
     timer_lock = SPIN_LOCK_INITIAL_VALUE;
     for (uint i = 0; i < SMP_MAX_CPUS; i++) {
-        list_initialize(&percpu[i].timer_queue);
+        struct timer_wheel *w = &percpu[i].timer_wheel;
+        w->cur_tick = 0;
+        w->count = 0;
+        w->armed_deadline = UINT64_MAX;
+        for (uint level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+            for (uint slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+                list_initialize(&w->slots[level][slot]);
+        }
     }
 }
 
@@ -366,17 +516,21 @@ static void dump_timer_queues(char *buf, size_t len)
 
     for (uint i = 0; i < SMP_MAX_CPUS; i++) {
         if (mp_is_cpu_online(i)) {
-            ptr += snprintf(buf + ptr, len - ptr, "cpu %u:\n", i);
-
-            timer_t *t;
-            lk_time_t last = now;
-            list_for_every_entry(&percpu[i].timer_queue, t, timer_t, node) {
-                lk_time_t delta_now = (t->scheduled_time > now) ? (t->scheduled_time - now) : 0;
-                lk_time_t delta_last = (t->scheduled_time > last) ? (t->scheduled_time - last) : 0;
-                ptr += snprintf(buf + ptr, len - ptr,
-                        "\ttime %" PRIu64 " delta_now %" PRIu64 " delta_last %" PRIu64 " func %p arg %p\n",
-                        t->scheduled_time, delta_now, delta_last, t->callback, t->arg);
-                last = t->scheduled_time;
+            struct timer_wheel *w = &percpu[i].timer_wheel;
+            ptr += snprintf(buf + ptr, len - ptr,
+                    "cpu %u: %zu timers, tick %" PRIu64 ", armed for %" PRIu64 "\n",
+                    i, w->count, w->cur_tick, w->armed_deadline);
+
+            for (uint level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+                for (uint slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+                    timer_t *t;
+                    list_for_every_entry(&w->slots[level][slot], t, timer_t, node) {
+                        lk_time_t delta_now = (t->scheduled_time > now) ? (t->scheduled_time - now) : 0;
+                        ptr += snprintf(buf + ptr, len - ptr,
+                                "\tL%u/%u time %" PRIu64 " delta_now %" PRIu64 " func %p arg %p\n",
+                                level, slot, t->scheduled_time, delta_now, t->callback, t->arg);
+                    }
+                }
             }
         }
     }
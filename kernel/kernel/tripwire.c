@@ -0,0 +1,43 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+/**
+ * @file
+ * @brief  Soft-latency tripwire configuration
+ *
+ * The tripwires themselves live on the instrumented paths (IRQ
+ * dispatch, timer callbacks, the scheduler's run queue pop); this file
+ * only turns the command line budgets into the globals those paths
+ * check. See kernel/tripwire.h for the option names.
+ */
+
+#include <kernel/tripwire.h>
+
+#include <kernel/cmdline.h>
+#include <kernel/thread.h>
+#include <lk/init.h>
+
+uint32_t tripwire_irq_ns;
+uint32_t tripwire_timer_ns;
+uint32_t tripwire_queue_ns;
+int tripwire_queue_pri = HIGH_PRIORITY;
+
+static void tripwire_init(uint level)
+{
+    tripwire_irq_ns = cmdline_get_uint32("kernel.tripwire.irq.us", 0) * 1000u;
+    tripwire_timer_ns = cmdline_get_uint32("kernel.tripwire.timer.us", 0) * 1000u;
+    tripwire_queue_ns = cmdline_get_uint32("kernel.tripwire.queue.us", 0) * 1000u;
+    tripwire_queue_pri = (int)cmdline_get_uint32("kernel.tripwire.queue.pri",
+                                                 HIGH_PRIORITY);
+    if (tripwire_queue_pri < LOWEST_PRIORITY)
+        tripwire_queue_pri = LOWEST_PRIORITY;
+    if (tripwire_queue_pri > HIGHEST_PRIORITY)
+        tripwire_queue_pri = HIGHEST_PRIORITY;
+}
+
+/* the command line is complete well before threading comes up, and the
+ * tripwires stay disabled until then */
+LK_INIT_HOOK(tripwire, tripwire_init, LK_INIT_LEVEL_THREADING);
@@ -11,8 +11,11 @@
 #include <err.h>
 #include <inttypes.h>
 #include <kernel/auto_lock.h>
+#include <kernel/event.h>
 #include <kernel/mp.h>
 #include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <kernel/timer.h>
 #include <kernel/vm.h>
 #include <lib/console.h>
@@ -38,6 +41,51 @@ static Mutex arena_lock;
 static mxtl::DoublyLinkedList<PmmArena*> arena_list TA_GUARDED(arena_lock);
 static size_t arena_cumulative_size TA_GUARDED(arena_lock);
 
+// NUMA topology. cpu_numa_node is written only during single threaded boot
+// (SRAT parsing on x86) and read racily afterwards, which is fine since each
+// entry is a single word. Everything sits on node 0 until the platform
+// retags it.
+static uint32_t cpu_numa_node[SMP_MAX_CPUS];
+static uint32_t numa_node_count TA_GUARDED(arena_lock) = 1;
+
+// Per cpu magazine of free pages. The common single page alloc/free path
+// goes through these first, refilling and draining in batches under the
+// arena lock, so page fault heavy workloads stop serializing on it. Only
+// pages from KMAP arenas are cached so a cached page can satisfy a single
+// page allocation regardless of flags.
+#define PAGE_CACHE_TARGET (32u)
+#define PAGE_CACHE_MAX (PAGE_CACHE_TARGET * 2)
+
+namespace {
+struct PageCache {
+    list_node pages;
+    size_t count;
+} __CPU_MAX_ALIGN;
+} // namespace
+
+static PageCache page_cache[SMP_MAX_CPUS];
+static bool page_cache_ready;
+
+// Pool of pre-zeroed pages, kept topped up by a low priority background
+// thread so PMM_ALLOC_FLAG_ZEROED allocations can skip the memset on the
+// page fault path.
+#define ZERO_PAGE_POOL_TARGET (512u)
+#define ZERO_PAGE_POOL_LOW (ZERO_PAGE_POOL_TARGET / 4)
+#define ZERO_PAGE_BATCH (64u)
+
+static SpinLock zero_page_lock;
+static list_node zero_page_list = LIST_INITIAL_VALUE(zero_page_list);
+static size_t zero_page_count TA_GUARDED(zero_page_lock);
+static event_t zero_page_low_event =
+    EVENT_INITIAL_VALUE(zero_page_low_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+
+static void pmm_page_cache_init(uint level) {
+    for (auto& c : page_cache)
+        list_initialize(&c.pages);
+    page_cache_ready = true;
+}
+LK_INIT_HOOK(pmm_page_cache, &pmm_page_cache_init, LK_INIT_LEVEL_VM);
+
 #if PMM_ENABLE_FREE_FILL
 static void pmm_enforce_fill(uint level) {
     for (auto& a : arena_list) {
@@ -108,21 +156,249 @@ done_add:
     return MX_OK;
 }
 
+// We don't need to hold the arena lock here; arena membership and flags are
+// set once during system initialization.
+static bool page_is_from_kmap_arena(const vm_page_t* page) TA_NO_THREAD_SAFETY_ANALYSIS {
+    for (const auto& a : arena_list) {
+        if (a.page_belongs_to_arena(page))
+            return (a.flags() & PMM_ARENA_FLAG_KMAP) != 0;
+    }
+    return false;
+}
+
+// Pop a page off the local cpu's cache. Interrupts are disabled to keep us
+// pinned to the cpu and to guard against allocations from irq context.
+static vm_page_t* page_cache_pop(paddr_t* pa) {
+    if (unlikely(!page_cache_ready))
+        return nullptr;
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    PageCache* c = &page_cache[arch_curr_cpu_num()];
+    vm_page_t* page = list_remove_head_type(&c->pages, vm_page_t, free.node);
+    if (page) {
+        DEBUG_ASSERT(c->count > 0);
+        c->count--;
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (page && pa)
+        *pa = vm_page_to_paddr(page);
+
+    return page;
+}
+
+// Try to stash a freed page in the local cpu's cache. Returns false if the
+// cache is full or the page isn't eligible for caching.
+static bool page_cache_push(vm_page_t* page) {
+    if (unlikely(!page_cache_ready))
+        return false;
+
+    if (!page_is_from_kmap_arena(page))
+        return false;
+
+    DEBUG_ASSERT(page->state != VM_PAGE_STATE_OBJECT || page->object.pin_count == 0);
+
+    bool cached = false;
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    PageCache* c = &page_cache[arch_curr_cpu_num()];
+    if (likely(c->count < PAGE_CACHE_MAX)) {
+        /* cached pages sit in the ALLOC state; they stay accounted as
+         * allocated until they drain back into an arena */
+        page->state = VM_PAGE_STATE_ALLOC;
+        list_add_head(&c->pages, &page->free.node);
+        c->count++;
+        cached = true;
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    return cached;
+}
+
+// The local cache is empty; pull a batch of pages from the KMAP arenas,
+// return one and stash the rest in the local cache.
+static vm_page_t* page_cache_refill(paddr_t* pa) {
+    if (unlikely(!page_cache_ready))
+        return nullptr;
+
+    struct list_node pages = LIST_INITIAL_VALUE(pages);
+    size_t count = 0;
+    {
+        AutoLock al(&arena_lock);
+
+        /* prefer arenas on the local numa node so the cache hands out local
+         * pages; a batch only mixes nodes once the local node runs dry */
+        const uint32_t local_node = cpu_numa_node[arch_curr_cpu_num()];
+        for (int pass = 0; pass < 2 && count < PAGE_CACHE_TARGET; pass++) {
+            for (auto& a : arena_list) {
+                if ((a.numa_node() == local_node) != (pass == 0))
+                    continue;
+
+                if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                    continue;
+
+                count += a.AllocPages(PAGE_CACHE_TARGET - count, &pages);
+                if (count == PAGE_CACHE_TARGET)
+                    break;
+            }
+        }
+    }
+
+    vm_page_t* page = list_remove_head_type(&pages, vm_page_t, free.node);
+    if (!page)
+        return nullptr;
+
+    if (pa)
+        *pa = vm_page_to_paddr(page);
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    PageCache* c = &page_cache[arch_curr_cpu_num()];
+    vm_page_t* p;
+    while (c->count < PAGE_CACHE_MAX &&
+           (p = list_remove_head_type(&pages, vm_page_t, free.node)) != nullptr) {
+        list_add_head(&c->pages, &p->free.node);
+        c->count++;
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    /* if we migrated onto a cpu with a full cache, give the rest back */
+    if (unlikely(!list_is_empty(&pages)))
+        pmm_free(&pages);
+
+    return page;
+}
+
+// Pop a page from the pre-zeroed pool, poking the zeroing thread if the
+// pool is running low.
+static vm_page_t* zero_page_pool_pop(paddr_t* pa) {
+    vm_page_t* page;
+    bool low;
+    {
+        AutoSpinLock al(&zero_page_lock);
+        page = list_remove_head_type(&zero_page_list, vm_page_t, free.node);
+        if (page) {
+            DEBUG_ASSERT(zero_page_count > 0);
+            zero_page_count--;
+        }
+        low = (zero_page_count < ZERO_PAGE_POOL_LOW);
+    }
+
+    if (low)
+        event_signal(&zero_page_low_event, false);
+
+    if (page && pa)
+        *pa = vm_page_to_paddr(page);
+
+    return page;
+}
+
+// The background thread that keeps the zero page pool topped up. Runs just
+// above idle priority so it only burns cycles the cpus had to spare anyway.
+static int zero_page_thread(void* arg) {
+    for (;;) {
+        event_wait(&zero_page_low_event);
+
+        for (;;) {
+            {
+                AutoSpinLock al(&zero_page_lock);
+                if (zero_page_count >= ZERO_PAGE_POOL_TARGET)
+                    break;
+            }
+
+            /* pull a batch of pages, zero them outside any lock */
+            struct list_node pages = LIST_INITIAL_VALUE(pages);
+            size_t count = pmm_alloc_pages(ZERO_PAGE_BATCH, PMM_ALLOC_FLAG_KMAP, &pages);
+            if (count == 0)
+                break;
+
+            vm_page_t* p;
+            list_for_every_entry (&pages, p, vm_page_t, free.node) {
+                void* ptr = paddr_to_kvaddr(vm_page_to_paddr(p));
+                DEBUG_ASSERT(ptr);
+                arch_zero_page(ptr);
+            }
+
+            AutoSpinLock al(&zero_page_lock);
+            while ((p = list_remove_head_type(&pages, vm_page_t, free.node)) != nullptr) {
+                list_add_head(&zero_page_list, &p->free.node);
+                zero_page_count++;
+            }
+        }
+    }
+    return 0;
+}
+
+static void pmm_zero_thread_init(uint level) {
+    thread_t* t = thread_create("pmm-zero", &zero_page_thread, nullptr,
+                                LOWEST_PRIORITY + 1, DEFAULT_STACK_SIZE);
+    DEBUG_ASSERT(t);
+    thread_detach_and_resume(t);
+
+    /* prime the pool */
+    event_signal(&zero_page_low_event, false);
+}
+LK_INIT_HOOK(pmm_zero_thread, &pmm_zero_thread_init, LK_INIT_LEVEL_THREADING);
+
 vm_page_t* pmm_alloc_page(uint alloc_flags, paddr_t* pa) {
+    if (alloc_flags & PMM_ALLOC_FLAG_ZEROED) {
+        /* serve from the pre-zeroed pool if it has anything in it */
+        vm_page_t* page = zero_page_pool_pop(pa);
+        if (likely(page))
+            return page;
+
+        /* pool is dry, fall through and zero whatever we get */
+        paddr_t tmp_pa;
+        page = pmm_alloc_page(alloc_flags & ~PMM_ALLOC_FLAG_ZEROED, &tmp_pa);
+        if (page) {
+            void* ptr = paddr_to_kvaddr(tmp_pa);
+            DEBUG_ASSERT(ptr);
+            arch_zero_page(ptr);
+            if (pa)
+                *pa = tmp_pa;
+        }
+        return page;
+    }
+
+    /* fast path: grab a page from the local cpu's cache */
+    vm_page_t* page = page_cache_pop(pa);
+    if (likely(page))
+        return page;
+
+    /* refill the cache in a batch from the KMAP arenas */
+    page = page_cache_refill(pa);
+    if (likely(page))
+        return page;
+
     AutoLock al(&arena_lock);
 
-    /* walk the arenas in order until we find one with a free page */
-    for (auto& a : arena_list) {
-        /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
-        if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
-            if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+    /* walk the arenas in order until we find one with a free page, trying
+     * those on the current cpu's numa node first and falling back to remote
+     * nodes only once local memory is exhausted */
+    const uint32_t local_node = cpu_numa_node[arch_curr_cpu_num()];
+    for (int pass = 0; pass < 2; pass++) {
+        for (auto& a : arena_list) {
+            if ((a.numa_node() == local_node) != (pass == 0))
                 continue;
-        }
 
-        // try to allocate the page out of the arena
-        vm_page_t* page = a.AllocPage(pa);
-        if (page)
-            return page;
+            /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
+            if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
+                if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                    continue;
+            }
+
+            // try to allocate the page out of the arena
+            vm_page_t* page = a.AllocPage(pa);
+            if (page)
+                return page;
+        }
     }
 
     LTRACEF("failed to allocate page\n");
@@ -140,22 +416,29 @@ size_t pmm_alloc_pages(size_t count, uint alloc_flags, struct list_node* list) {
 
     AutoLock al(&arena_lock);
 
-    /* walk the arenas in order, allocating as many pages as we can from each */
+    /* walk the arenas in order, allocating as many pages as we can from each,
+     * draining the current cpu's numa node before touching remote ones */
     size_t allocated = 0;
-    for (auto& a : arena_list) {
-        DEBUG_ASSERT(count > allocated);
+    const uint32_t local_node = cpu_numa_node[arch_curr_cpu_num()];
+    for (int pass = 0; pass < 2 && allocated < count; pass++) {
+        for (auto& a : arena_list) {
+            DEBUG_ASSERT(count > allocated);
 
-        /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
-        if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
-            if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+            if ((a.numa_node() == local_node) != (pass == 0))
                 continue;
-        }
 
-        // ask the arena to allocate some pages
-        allocated += a.AllocPages(count - allocated, list);
-        DEBUG_ASSERT(allocated <= count);
-        if (allocated == count)
-            break;
+            /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
+            if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
+                if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                    continue;
+            }
+
+            // ask the arena to allocate some pages
+            allocated += a.AllocPages(count - allocated, list);
+            DEBUG_ASSERT(allocated <= count);
+            if (allocated == count)
+                break;
+        }
     }
 
     return allocated;
@@ -204,17 +487,25 @@ size_t pmm_alloc_contiguous(size_t count, uint alloc_flags, uint8_t alignment_lo
 
     AutoLock al(&arena_lock);
 
-    for (auto& a : arena_list) {
-        /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
-        if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
-            if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+    /* local numa node first; contiguous runs are mostly dma buffers and the
+     * device is usually attached to the cpu asking for them */
+    const uint32_t local_node = cpu_numa_node[arch_curr_cpu_num()];
+    for (int pass = 0; pass < 2; pass++) {
+        for (auto& a : arena_list) {
+            if ((a.numa_node() == local_node) != (pass == 0))
                 continue;
-        }
 
-        size_t allocated = a.AllocContiguous(count, alignment_log2, pa, list);
-        if (allocated > 0) {
-            DEBUG_ASSERT(allocated == count);
-            return allocated;
+            /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
+            if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
+                if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                    continue;
+            }
+
+            size_t allocated = a.AllocContiguous(count, alignment_log2, pa, list);
+            if (allocated > 0) {
+                DEBUG_ASSERT(allocated == count);
+                return allocated;
+            }
         }
     }
 
@@ -296,9 +587,25 @@ size_t pmm_free(struct list_node* list) {
 
     DEBUG_ASSERT(list);
 
+    uint count = 0;
+
+    /* stash what we can in the local cpu's page cache without the arena lock */
+    vm_page_t* cpage;
+    while ((cpage = list_remove_head_type(list, vm_page_t, free.node)) != nullptr) {
+        DEBUG_ASSERT(!page_is_free(cpage));
+
+        if (!page_cache_push(cpage)) {
+            list_add_head(list, &cpage->free.node);
+            break;
+        }
+        count++;
+    }
+
+    if (list_is_empty(list))
+        return count;
+
     AutoLock al(&arena_lock);
 
-    uint count = 0;
     while (!list_is_empty(list)) {
         vm_page_t* page = list_remove_head_type(list, vm_page_t, free.node);
 
@@ -363,6 +670,99 @@ void pmm_count_total_states(size_t state_count[_VM_PAGE_STATE_COUNT]) {
     }
 }
 
+void pmm_numa_set_arena_node(paddr_t base, size_t size, uint32_t node) {
+    if (node >= PMM_MAX_NUMA_NODES) {
+        TRACEF("ignoring out of range numa node %u for [%#" PRIxPTR ", %#" PRIxPTR ")\n",
+               node, base, base + size);
+        return;
+    }
+
+    AutoLock al(&arena_lock);
+
+    for (auto& a : arena_list) {
+        /* tag the arena if any part of it falls inside the range */
+        if (a.base() + a.size() <= base || a.base() >= base + size)
+            continue;
+        a.set_numa_node(node);
+    }
+
+    if (node + 1 > numa_node_count)
+        numa_node_count = node + 1;
+}
+
+void pmm_numa_set_cpu_node(uint cpu_num, uint32_t node) {
+    if (cpu_num >= SMP_MAX_CPUS || node >= PMM_MAX_NUMA_NODES) {
+        TRACEF("ignoring out of range cpu %u / numa node %u\n", cpu_num, node);
+        return;
+    }
+
+    cpu_numa_node[cpu_num] = node;
+
+    AutoLock al(&arena_lock);
+    if (node + 1 > numa_node_count)
+        numa_node_count = node + 1;
+}
+
+uint32_t pmm_numa_cpu_node(uint cpu_num) {
+    DEBUG_ASSERT(cpu_num < SMP_MAX_CPUS);
+    return cpu_numa_node[cpu_num];
+}
+
+uint32_t pmm_numa_node_count() {
+    AutoLock al(&arena_lock);
+    return numa_node_count;
+}
+
+void pmm_numa_get_node_info(uint32_t node, pmm_numa_node_info_t* info) {
+    *info = {};
+
+    uint num_cpus = arch_max_num_cpus();
+    for (uint i = 0; i < num_cpus; i++) {
+        if (cpu_numa_node[i] == node)
+            info->num_cpus++;
+    }
+
+    AutoLock al(&arena_lock);
+    for (const auto& a : arena_list) {
+        if (a.numa_node() != node)
+            continue;
+        info->mem_bytes += a.size();
+        info->free_bytes += a.free_count() * PAGE_SIZE;
+    }
+}
+
+uint32_t pmm_arena_count() {
+    AutoLock al(&arena_lock);
+    uint32_t count = 0;
+    for (const auto& a : arena_list) {
+        (void)a;
+        count++;
+    }
+    return count;
+}
+
+status_t pmm_arena_get_stats(uint32_t index, pmm_arena_stats_t* stats) {
+    AutoLock al(&arena_lock);
+
+    uint32_t i = 0;
+    for (const auto& a : arena_list) {
+        if (i++ != index)
+            continue;
+
+        memset(stats, 0, sizeof(*stats));
+        memcpy(stats->name, a.name(), sizeof(stats->name));
+        stats->name[sizeof(stats->name) - 1] = 0;
+        stats->numa_node = a.numa_node();
+        stats->base = a.base();
+        stats->size = a.size();
+        stats->free_bytes = a.free_count() * PAGE_SIZE;
+        stats->free_runs = a.free_runs();
+        stats->largest_free_run_bytes = a.LargestFreeRun() * PAGE_SIZE;
+        return MX_OK;
+    }
+    return MX_ERR_OUT_OF_RANGE;
+}
+
 extern "C" enum handler_return pmm_dump_timer(struct timer* t, lk_time_t now, void*) TA_REQ(arena_lock) {
     timer_set_oneshot(t, now + LK_SEC(1), &pmm_dump_timer, nullptr);
     pmm_dump_free();
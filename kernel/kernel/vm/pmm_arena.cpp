@@ -68,6 +68,42 @@ void PmmArena::BootAllocArray() {
     }
 
     free_count_ += page_count;
+    if (page_count > 0)
+        free_runs_++;
+}
+
+void PmmArena::RunsOnAlloc(size_t index, size_t count) {
+    DEBUG_ASSERT(free_runs_ > 0);
+    bool left = index_is_free(index - 1);
+    bool right = index_is_free(index + count);
+    if (left && right)
+        free_runs_++; /* carved out of the middle of a run, splitting it */
+    else if (!left && !right)
+        free_runs_--; /* took out a whole run */
+}
+
+void PmmArena::RunsOnFree(size_t index) {
+    bool left = index_is_free(index - 1);
+    bool right = index_is_free(index + 1);
+    if (left && right)
+        free_runs_--; /* bridged two runs together */
+    else if (!left && !right)
+        free_runs_++; /* started a new run */
+}
+
+size_t PmmArena::LargestFreeRun() const {
+    size_t largest = 0;
+    size_t run = 0;
+    for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
+        if (page_is_free(&page_array_[i])) {
+            run++;
+            if (run > largest)
+                largest = run;
+        } else {
+            run = 0;
+        }
+    }
+    return largest;
 }
 
 vm_page_t* PmmArena::AllocPage(paddr_t* pa) {
@@ -82,6 +118,7 @@ vm_page_t* PmmArena::AllocPage(paddr_t* pa) {
     DEBUG_ASSERT(page_is_free(page));
 
     page->state = VM_PAGE_STATE_ALLOC;
+    RunsOnAlloc((size_t)(page - page_array_), 1);
 #if PMM_ENABLE_FREE_FILL
     CheckFreeFill(page);
 #endif
@@ -114,6 +151,7 @@ vm_page_t* PmmArena::AllocSpecific(paddr_t pa) {
     list_delete(&page->free.node);
 
     page->state = VM_PAGE_STATE_ALLOC;
+    RunsOnAlloc(index, 1);
 
     DEBUG_ASSERT(free_count_ > 0);
 
@@ -142,6 +180,7 @@ size_t PmmArena::AllocPages(size_t count, list_node* list) {
 #endif
 
         page->state = VM_PAGE_STATE_ALLOC;
+        RunsOnAlloc((size_t)(page - page_array_), 1);
         list_add_tail(list, &page->free.node);
 
         allocated++;
@@ -206,6 +245,8 @@ retry:
                 list_add_tail(list, &p->free.node);
         }
 
+        RunsOnAlloc(start, count);
+
         if (pa)
             *pa = base() + start * PAGE_SIZE;
 
@@ -227,6 +268,7 @@ status_t PmmArena::FreePage(vm_page_t* page) {
 #endif
 
     page->state = VM_PAGE_STATE_FREE;
+    RunsOnFree((size_t)(page - page_array_));
 
     list_add_head(&free_list_, &page->free.node);
     free_count_++;
@@ -241,9 +283,10 @@ void PmmArena::CountStates(size_t state_count[_VM_PAGE_STATE_COUNT]) const {
 
 void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) {
     char pbuf[16];
-    printf("arena %p: name '%s' base %#" PRIxPTR " size %s (0x%zx) priority %u flags 0x%x\n", this, name(), base(),
-           format_size(pbuf, sizeof(pbuf), size()), size(), priority(), flags());
-    printf("\tpage_array %p, free_count %zu\n", page_array_, free_count_);
+    printf("arena %p: name '%s' base %#" PRIxPTR " size %s (0x%zx) priority %u flags 0x%x numa node %u\n",
+           this, name(), base(), format_size(pbuf, sizeof(pbuf), size()), size(), priority(), flags(),
+           numa_node());
+    printf("\tpage_array %p, free_count %zu, free_runs %zu\n", page_array_, free_count_, free_runs_);
 
     /* dump all of the pages */
     if (dump_pages) {
@@ -39,6 +39,21 @@ public:
     unsigned int priority() const { return info_.priority; }
     size_t free_count() const { return free_count_; };
 
+    // Number of maximal runs of contiguous free pages. Maintained
+    // incrementally by the allocation routines, so reading it is free.
+    size_t free_runs() const { return free_runs_; }
+
+    // Longest run of contiguous free pages. Found by sweeping the page
+    // array, so it costs the same order as CountStates; fine for an
+    // occasional stats query, not for allocation paths.
+    size_t LargestFreeRun() const;
+
+    // NUMA node the arena's memory is attached to. Arenas are registered
+    // before the platform topology is known, so this is retagged after the
+    // fact via pmm_numa_set_arena_node().
+    uint32_t numa_node() const { return numa_node_; }
+    void set_numa_node(uint32_t node) { numa_node_ = node; }
+
     // Counts the number of pages in every state. For each page in the arena,
     // increments the corresponding VM_PAGE_STATE_*-indexed entry of
     // |state_count|. Does not zero out the entries first.
@@ -79,10 +94,22 @@ private:
     void CheckFreeFill(vm_page_t* page);
 #endif
 
+    // Incremental free-run bookkeeping. Called after the pages in
+    // [index, index + count) have changed state; only the state of the
+    // range's physical neighbors decides how the run count moves.
+    void RunsOnAlloc(size_t index, size_t count);
+    void RunsOnFree(size_t index);
+
+    bool index_is_free(size_t index) const {
+        return index < size() / PAGE_SIZE && page_is_free(&page_array_[index]);
+    }
+
     const pmm_arena_info_t info_;
+    uint32_t numa_node_ = 0;
     vm_page_t* page_array_ = nullptr;
 
     size_t free_count_ = 0;
+    size_t free_runs_ = 0;
     list_node free_list_ = LIST_INITIAL_VALUE(free_list_);
 
 #if PMM_ENABLE_FREE_FILL
@@ -337,8 +337,42 @@ status_t VmAddressRegion::DestroyLocked() {
     return MX_OK;
 }
 
+void VmAddressRegion::GapUpdateLocked(VmAddressRegionOrMapping* child) {
+    auto next = subregions_.make_iterator(*child);
+    ++next;
+    const vaddr_t gap_end = next.IsValid() ? next->base() : base_ + size_;
+    const size_t gap = gap_end - (child->base() + child->size());
+
+    if (child->gap_tree_node_.InContainer())
+        gap_tree_.erase(*child);
+    child->gap_to_next_ = gap;
+    if (gap > 0)
+        gap_tree_.insert(child);
+}
+
+void VmAddressRegion::AddSubregion(VmAddressRegionOrMapping* child) {
+    subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(child));
+    GapUpdateLocked(child);
+
+    // the new child also truncates (or splits) the gap of the child before it
+    auto prev = subregions_.make_iterator(*child);
+    --prev;
+    if (prev.IsValid())
+        GapUpdateLocked(&*prev);
+}
+
 void VmAddressRegion::RemoveSubregion(VmAddressRegionOrMapping* region) {
+    auto prev = subregions_.make_iterator(*region);
+    --prev;
+
+    if (region->gap_tree_node_.InContainer())
+        gap_tree_.erase(*region);
+    region->gap_to_next_ = 0;
     subregions_.erase(*region);
+
+    // the gap trailing the previous child has absorbed the removed range
+    if (prev.IsValid())
+        GapUpdateLocked(&*prev);
 }
 
 mxtl::RefPtr<VmAddressRegionOrMapping> VmAddressRegion::FindRegion(vaddr_t addr) {
@@ -569,7 +603,7 @@ void VmAddressRegion::Activate() {
     DEBUG_ASSERT(is_mutex_held(aspace_->lock()));
 
     state_ = LifeCycleState::ALIVE;
-    parent_->subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    parent_->AddSubregion(this);
 }
 
 status_t VmAddressRegion::Unmap(vaddr_t base, size_t size) {
@@ -762,6 +796,36 @@ status_t VmAddressRegion::LinearRegionAllocatorLocked(size_t size, uint8_t align
         align_pow2 = PAGE_SIZE_SHIFT;
     const vaddr_t align = 1UL << align_pow2;
 
+    // Try the gap before the first child, then consult the gap index for the
+    // smallest gap able to hold the region, rather than walking every child.
+    // Gaps begin on page boundaries, so over-asking by (align - PAGE_SIZE)
+    // guarantees an aligned run fits; the rare allocation this conservative
+    // bound misses (or that the arch PickSpot hook refuses) falls back to
+    // the full scan below.
+    {
+        auto before_iter = subregions_.end();
+        auto after_iter = subregions_.begin();
+        if (CheckGapLocked(before_iter, after_iter, spot, base, align, size, 0, arch_mmu_flags) &&
+            *spot != static_cast<vaddr_t>(-1)) {
+            return MX_OK;
+        }
+
+        const size_t slop = align - PAGE_SIZE;
+        if (size + slop >= size) {
+            auto gap_iter = gap_tree_.lower_bound(GapKey{size + slop, 0});
+            if (gap_iter.IsValid()) {
+                before_iter = subregions_.make_iterator(*gap_iter);
+                after_iter = before_iter;
+                ++after_iter;
+                if (CheckGapLocked(before_iter, after_iter, spot, base, align, size, 0,
+                                   arch_mmu_flags) &&
+                    *spot != static_cast<vaddr_t>(-1)) {
+                    return MX_OK;
+                }
+            }
+        }
+    }
+
     // Find the first gap in the address space which can contain a region of the
     // requested size.
     auto before_iter = subregions_.end();
@@ -46,6 +46,7 @@ VmAddressRegionOrMapping::~VmAddressRegionOrMapping() {
     }
 
     DEBUG_ASSERT(!subregion_list_node_.InContainer());
+    DEBUG_ASSERT(!gap_tree_node_.InContainer());
 }
 
 bool VmAddressRegionOrMapping::IsAliveLocked() const {
@@ -20,6 +20,7 @@
 #include <kernel/vm/vm_object_physical.h>
 #include <lib/crypto/global_prng.h>
 #include <lib/crypto/prng.h>
+#include <lib/dpc.h>
 #include <mxtl/auto_call.h>
 #include <mxtl/intrusive_double_list.h>
 #include <mxtl/type_support.h>
@@ -45,6 +46,18 @@ static VmAddressRegion* dummy_root_vmar = nullptr;
 static mutex_t aspace_list_lock = MUTEX_INITIAL_VALUE(aspace_list_lock);
 static mxtl::DoublyLinkedList<VmAspace*> aspaces;
 
+// state for deferred aspace teardown
+mutex_t VmAspace::deferred_destroy_lock_ =
+    MUTEX_INITIAL_VALUE(VmAspace::deferred_destroy_lock_);
+VmAspace::DeferredList VmAspace::deferred_destroy_list_;
+dpc_t VmAspace::deferred_destroy_dpc_ = {
+    .node = LIST_INITIAL_CLEARED_VALUE,
+    .func = VmAspace::DeferredDestroyRoutine,
+    .arg = nullptr,
+    // bulk teardown; keep it off the completion-critical dpc lane
+    .flags = DPC_FLAG_LOW_PRIORITY,
+};
+
 // called once at boot to initialize the singleton kernel address space
 void VmAspace::KernelAspaceInitPreHeap() {
     // the singleton kernel address space
@@ -263,6 +276,41 @@ bool VmAspace::is_destroyed() const {
     return aspace_destroyed_;
 }
 
+void VmAspace::DeferredDestroy(mxtl::RefPtr<VmAspace> aspace) {
+    DEBUG_ASSERT(aspace);
+
+    // Hold a reference across the queue; DeferredDestroyRoutine drops it.
+    VmAspace* raw = aspace.leak_ref();
+    {
+        AutoLock a(&deferred_destroy_lock_);
+        deferred_destroy_list_.push_back(raw);
+    }
+    dpc_queue(&deferred_destroy_dpc_, false);
+}
+
+// Tears down one aspace per invocation, re-queueing itself while a backlog
+// remains, so other bulk cleanup gets to interleave on the dpc worker.
+void VmAspace::DeferredDestroyRoutine(dpc_t* dpc) {
+    VmAspace* aspace;
+    bool backlog;
+    {
+        AutoLock a(&deferred_destroy_lock_);
+        aspace = deferred_destroy_list_.pop_front();
+        backlog = !deferred_destroy_list_.is_empty();
+    }
+    if (aspace == nullptr)
+        return;
+    if (backlog)
+        dpc_queue(dpc, false);
+
+    LTRACEF("%p '%s'\n", aspace, aspace->name_);
+    aspace->Destroy();
+
+    // Drop the reference taken in DeferredDestroy(). This is usually the
+    // last one, freeing the aspace and its top-level page table.
+    __UNUSED auto ref = mxtl::internal::MakeRefPtrNoAdopt(aspace);
+}
+
 status_t VmAspace::MapObjectInternal(mxtl::RefPtr<VmObject> vmo, const char* name, uint64_t offset,
                                      size_t size, void** ptr, uint8_t align_pow2, uint vmm_flags,
                                      uint arch_mmu_flags) {
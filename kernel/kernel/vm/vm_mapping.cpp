@@ -264,12 +264,18 @@ status_t VmMapping::UnmapLocked(vaddr_t base, size_t size) {
         if (base_ == base && size_ != size) {
             // We need to remove ourselves from tree before updating base_,
             // since base_ is the tree key.
-            mxtl::RefPtr<VmAddressRegionOrMapping> ref(parent_->subregions_.erase(*this));
+            mxtl::RefPtr<VmAddressRegionOrMapping> ref(this);
+            parent_->RemoveSubregion(this);
             base_ += size;
             object_offset_ += size;
-            parent_->subregions_.insert(mxtl::move(ref));
+            size_ -= size;
+            parent_->AddSubregion(this);
+        } else {
+            size_ -= size;
+            // Trimmed in place; the gap trailing us grew.
+            if (size_ > 0)
+                parent_->GapUpdateLocked(this);
         }
-        size_ -= size;
 
         return MX_OK;
     }
@@ -403,10 +409,11 @@ status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
     currently_faulting_ = true;
     auto ac = mxtl::MakeAutoCall([&]() { currently_faulting_ = false; });
 
-    // iterate through the range, grabbing a page from the underlying object and
-    // mapping it in
-    size_t o;
-    for (o = offset; o < offset + len; o += PAGE_SIZE) {
+    // iterate through the range, grabbing pages from the underlying object
+    // and handing physically contiguous runs to the arch mmu in one call, so
+    // it can use large pages when the alignment works out
+    size_t o = offset;
+    while (o < offset + len) {
         uint64_t vmo_offset = object_offset_ + o;
 
         status_t status;
@@ -419,20 +426,37 @@ status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
                 return status;
             } else {
                 // skip ahead
+                o += PAGE_SIZE;
                 continue;
             }
         }
 
+        // extend the run while the following pages are physically contiguous
         vaddr_t va = base_ + o;
-        LTRACEF_LEVEL(2, "mapping pa %#" PRIxPTR " to va %#" PRIxPTR "\n", pa, va);
+        paddr_t run_start = pa;
+        size_t run_pages = 1;
+        while (o + run_pages * PAGE_SIZE < offset + len) {
+            paddr_t next_pa;
+            status = object_->GetPageLocked(vmo_offset + run_pages * PAGE_SIZE, pf_flags,
+                                            nullptr, nullptr, &next_pa);
+            if (status < 0 || next_pa != run_start + run_pages * PAGE_SIZE)
+                break;
+            run_pages++;
+        }
+
+        LTRACEF_LEVEL(2, "mapping pa %#" PRIxPTR " to va %#" PRIxPTR ", %zu pages\n",
+                      run_start, va, run_pages);
 
         size_t mapped;
-        auto ret = aspace_->arch_aspace().Map(va, pa, 1, arch_mmu_flags_, &mapped);
+        auto ret = aspace_->arch_aspace().Map(va, run_start, run_pages, arch_mmu_flags_, &mapped);
         if (ret < 0) {
-            TRACEF("error %d mapping page at va %#" PRIxPTR " pa %#" PRIxPTR "\n", ret, va, pa);
+            TRACEF("error %d mapping %zu pages at va %#" PRIxPTR " pa %#" PRIxPTR "\n",
+                   ret, run_pages, va, run_start);
+        } else {
+            DEBUG_ASSERT(mapped == run_pages);
         }
 
-        DEBUG_ASSERT(mapped == 1);
+        o += run_pages * PAGE_SIZE;
     }
 
     return MX_OK;
@@ -506,6 +530,58 @@ status_t VmMapping::DestroyLocked() {
     return MX_OK;
 }
 
+// how many extra pages PageFault will try to bring in once a mapping is
+// being touched sequentially
+#define FAULT_AROUND_PAGES (16u)
+
+void VmMapping::FaultAroundLocked(vaddr_t va, uint pf_flags) {
+    DEBUG_ASSERT(is_mutex_held(aspace_->lock()));
+
+    // executable mappings need cache maintenance on some architectures, keep
+    // them on the precise one-page-at-a-time path
+    if (arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_EXECUTE)
+        return;
+
+    uint64_t fault_offset = va - base_ + object_offset_;
+
+    // only cluster when the previous fault was on the preceding page
+    bool sequential = (last_fault_offset_ != UINT64_MAX) &&
+                      (fault_offset == last_fault_offset_ + PAGE_SIZE);
+    last_fault_offset_ = fault_offset;
+    if (!sequential)
+        return;
+
+    // map the following pages read only; a later write fault will upgrade the
+    // permissions and handle any copy on write work
+    uint mmu_flags = arch_mmu_flags_ & ~ARCH_MMU_FLAG_PERM_WRITE;
+    uint ro_pf_flags = pf_flags & ~VMM_PF_FLAG_WRITE;
+
+    for (uint64_t i = 1; i <= FAULT_AROUND_PAGES; i++) {
+        vaddr_t next_va = va + i * PAGE_SIZE;
+        if (next_va > base_ + size_ - PAGE_SIZE)
+            break;
+
+        // stop at the first address that already has something mapped
+        paddr_t pa;
+        uint flags;
+        if (aspace_->arch_aspace().Query(next_va, &pa, &flags) >= 0)
+            break;
+
+        vm_page_t* page;
+        paddr_t new_pa;
+        uint64_t offset = next_va - base_ + object_offset_;
+        if (object_->GetPageLocked(offset, ro_pf_flags, nullptr, &page, &new_pa) < 0)
+            break;
+
+        DEBUG_ASSERT((new_pa != vm_get_zero_page_paddr()) ||
+                     !(mmu_flags & ARCH_MMU_FLAG_PERM_WRITE));
+
+        size_t mapped;
+        if (aspace_->arch_aspace().Map(next_va, new_pa, 1, mmu_flags, &mapped) < 0)
+            break;
+    }
+}
+
 status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
     canary_.Assert();
     DEBUG_ASSERT(is_mutex_held(aspace_->lock()));
@@ -634,6 +710,9 @@ status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
         DEBUG_ASSERT(mapped == 1);
     }
 
+    // opportunistically pull in more pages if this looks like a sequential scan
+    FaultAroundLocked(va, pf_flags);
+
 // TODO: figure out what to do with this
 #if ARCH_ARM64
     if (arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_EXECUTE)
@@ -658,7 +737,7 @@ void VmMapping::ActivateLocked() TA_NO_THREAD_SAFETY_ANALYSIS {
 
     state_ = LifeCycleState::ALIVE;
     object_->AddMappingLocked(this);
-    parent_->subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    parent_->AddSubregion(this);
 }
 
 void VmMapping::Activate() {
@@ -112,6 +112,31 @@ bool VmObject::is_cow_clone() const {
     return parent_ != nullptr;
 }
 
+uint32_t VmObject::clone_chain_depth() const
+    // Every VMO in a clone tree shares the root's lock, so the whole parent
+    // chain can be walked under it, which confuses analysis.
+    TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    AutoLock a(&lock_);
+    uint32_t depth = 0;
+    for (const VmObject* p = parent_.get(); p != nullptr; p = p->parent_.get()) {
+        depth++;
+    }
+    return depth;
+}
+
+size_t VmObject::ReclaimDontNeedPages(size_t max_pages) {
+    size_t total = 0;
+
+    AutoLock a(&all_vmos_lock_);
+    for (auto& vmo : all_vmos_) {
+        if (total >= max_pages)
+            break;
+        total += vmo.EvictDontNeedPages(max_pages - total);
+    }
+    return total;
+}
+
 void VmObject::AddMappingLocked(VmMapping* r) {
     canary_.Assert();
     DEBUG_ASSERT(lock_.IsHeld());
@@ -45,6 +45,7 @@ void InitializeVmPage(vm_page_t* p) {
     p->state = VM_PAGE_STATE_OBJECT;
     p->object.pin_count = 0;
     p->object.contiguous_pin = 0;
+    p->object.dontneed = 0;
 }
 
 } // namespace
@@ -68,6 +69,11 @@ VmObjectPaged::~VmObjectPaged() {
                 return MX_ERR_NEXT;
             });
 
+    // give back any pages still billed to our counter
+    if (page_counter_ && committed_pages_ > 0) {
+        page_counter_->Adjust(-static_cast<int64_t>(committed_pages_));
+    }
+
     // free all of the pages attached to us
     page_list_.FreeAllPages();
 }
@@ -124,6 +130,102 @@ status_t VmObjectPaged::CloneCOW(uint64_t offset, uint64_t size, bool copy_name,
     return MX_OK;
 }
 
+void VmObjectPaged::OnZeroHandles() {
+    canary_.Assert();
+
+    list_node freed_list = LIST_INITIAL_VALUE(freed_list);
+    {
+        AutoLock a(&lock_);
+        MergeIntoChildLocked(&freed_list);
+    }
+    if (!list_is_empty(&freed_list))
+        pmm_free(&freed_list);
+}
+
+// Flatten one link of a clone chain: once userspace can no longer reach an
+// intermediate clone parent, hand every page its only clone hasn't shadowed
+// down to the clone and splice the clone up to our own parent. This keeps
+// the fault-time parent walk short no matter how many intermediate clones
+// have come and gone.
+bool VmObjectPaged::MergeIntoChildLocked(list_node* freed_list) {
+    // Only an unmapped VMO with exactly one clone can be folded away;
+    // mappings (and the handle that just closed) are the other ways our
+    // pages can still be reached.
+    if (mapping_list_len_ != 0 || children_list_len_ != 1)
+        return false;
+
+    auto& childv = children_list_.front();
+    if (!childv.is_paged())
+        return false;
+    auto child = static_cast<VmObjectPaged*>(&childv);
+
+    // The clone's window must lie entirely within us; flattening a clone
+    // that extends past our size would let it read our parent's pages
+    // where it used to see zeros.
+    safeint::CheckedNumeric<uint64_t> child_end = child->parent_offset_;
+    child_end += child->size_;
+    if (!child_end.IsValid() || child_end.ValueOrDie() > size_)
+        return false;
+
+    // Compute the clone's new offset into our parent up front so we don't
+    // mutate anything if it would overflow.
+    safeint::CheckedNumeric<uint64_t> new_parent_offset = parent_offset_;
+    new_parent_offset += child->parent_offset_;
+    if (parent_ && !new_parent_offset.IsValid())
+        return false;
+
+    // Pinned or wired pages can be neither handed over nor freed.
+    bool immovable = false;
+    page_list_.ForEveryPage([&immovable](const auto p, uint64_t off) {
+        if (p->state != VM_PAGE_STATE_OBJECT || p->object.pin_count > 0) {
+            immovable = true;
+            return MX_ERR_STOP;
+        }
+        return MX_ERR_NEXT;
+    });
+    if (immovable)
+        return false;
+
+    const uint64_t child_offset = child->parent_offset_;
+    const uint64_t child_size = child->size_;
+    int64_t released = 0;
+    page_list_.ForEveryPage(
+        [&](vm_page_t*& p, uint64_t off) TA_NO_THREAD_SAFETY_ANALYSIS {
+            vm_page_t* page = p;
+            // pull the page out of our list either way
+            p = nullptr;
+            released++;
+            if (off >= child_offset && off - child_offset < child_size &&
+                child->page_list_.GetPage(off - child_offset) == nullptr) {
+                // hand the page down to the clone; it keeps its contents
+                // and its physical address, so existing mappings of it
+                // stay coherent
+                __UNUSED status_t status =
+                    child->AddPageLocked(page, off - child_offset);
+                DEBUG_ASSERT(status == MX_OK);
+            } else {
+                // the clone has shadowed this page, or can't see it
+                list_add_tail(freed_list, &page->free.node);
+            }
+            return MX_ERR_NEXT;
+        });
+    page_list_.PruneEmptyNodes();
+    if (released > 0)
+        AdjustCommittedLocked(-released);
+
+    // splice the clone up to our own parent
+    RemoveChildLocked(child);
+    child->parent_offset_ = parent_ ? new_parent_offset.ValueOrDie() : 0;
+    if (parent_) {
+        parent_->AddChildLocked(child);
+        parent_->RemoveChildLocked(this);
+    }
+    child->parent_ = mxtl::move(parent_);
+
+    LTRACEF("vmo %p flattened into clone %p\n", this, child);
+    return true;
+}
+
 void VmObjectPaged::Dump(uint depth, bool verbose) {
     canary_.Assert();
 
@@ -164,6 +266,11 @@ size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const
     if (!TrimRange(offset, len, size_, &new_len)) {
         return 0;
     }
+    // covering the whole object is the common case, and we keep a running
+    // count for it
+    if (offset == 0 && new_len == size_) {
+        return committed_pages_;
+    }
     size_t count = 0;
     // TODO: Figure out what to do with our parent's pages. If we're a clone,
     // page_list_ only contains pages that we've made copies of.
@@ -177,6 +284,26 @@ size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const
     return count;
 }
 
+void VmObjectPaged::set_page_counter(mxtl::RefPtr<VmPageCounter> counter) {
+    canary_.Assert();
+
+    AutoLock a(&lock_);
+    DEBUG_ASSERT(!page_counter_);
+    if (counter && committed_pages_ > 0) {
+        counter->Adjust(static_cast<int64_t>(committed_pages_));
+    }
+    page_counter_ = mxtl::move(counter);
+}
+
+void VmObjectPaged::AdjustCommittedLocked(int64_t delta_pages) {
+    DEBUG_ASSERT(delta_pages >= 0 ||
+                 committed_pages_ >= static_cast<size_t>(-delta_pages));
+    committed_pages_ += delta_pages;
+    if (page_counter_) {
+        page_counter_->Adjust(delta_pages);
+    }
+}
+
 status_t VmObjectPaged::AddPage(vm_page_t* p, uint64_t offset) {
     AutoLock a(&lock_);
 
@@ -198,6 +325,8 @@ status_t VmObjectPaged::AddPageLocked(vm_page_t* p, uint64_t offset) {
     if (err != MX_OK)
         return err;
 
+    AdjustCommittedLocked(1);
+
     // other mappings may have covered this offset into the vmo, so unmap those ranges
     RangeChangeUpdateLocked(offset, PAGE_SIZE);
 
@@ -280,6 +409,11 @@ status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_node*
     // see if we already have a page at that offset
     p = page_list_.GetPage(offset);
     if (p) {
+        // an actual use of the page cancels any don't-need hint on it
+        if ((pf_flags & VMM_PF_FLAG_FAULT_MASK) &&
+            p->state == VM_PAGE_STATE_OBJECT) {
+            p->object.dontneed = 0;
+        }
         if (page_out)
             *page_out = p;
         if (pa_out)
@@ -381,7 +515,9 @@ status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_node*
         }
     }
     if (!p) {
-        p = pmm_alloc_page(pmm_alloc_flags_, &pa);
+        /* ask the pmm for a page off the pre-zeroed pool to keep the memset
+         * off the fault path */
+        p = pmm_alloc_page(pmm_alloc_flags_ | PMM_ALLOC_FLAG_ZEROED, &pa);
     }
     if (!p) {
         return MX_ERR_NO_MEMORY;
@@ -389,9 +525,6 @@ status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_node*
 
     InitializeVmPage(p);
 
-    // TODO: remove once pmm returns zeroed pages
-    ZeroPage(pa);
-
     status_t status = AddPageLocked(p, offset);
     DEBUG_ASSERT(status == MX_OK);
 
@@ -560,6 +693,8 @@ status_t VmObjectPaged::CommitRangeContiguous(uint64_t offset, uint64_t len, uin
         auto status = page_list_.AddPage(p, o);
         DEBUG_ASSERT(status == MX_OK);
 
+        AdjustCommittedLocked(1);
+
         // Mark the pages as pinned, so they can't be physically rearranged
         // underneath us.
         p->object.pin_count++;
@@ -613,18 +748,128 @@ status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t* d
     // unmap all of the pages in this range on all the mapping regions
     RangeChangeUpdateLocked(start, page_aligned_len);
 
-    // iterate through the pages, freeing them
-    while (start < end) {
-        auto status = page_list_.FreePage(start);
-        if (status == MX_OK && decommitted) {
-            *decommitted += PAGE_SIZE;
+    // free the pages, returning them to the pmm in one batch
+    size_t freed = page_list_.FreePagesInRange(start, end);
+    if (freed > 0) {
+        AdjustCommittedLocked(-static_cast<int64_t>(freed));
+        if (decommitted) {
+            *decommitted = freed * PAGE_SIZE;
         }
-        start += PAGE_SIZE;
     }
 
     return MX_OK;
 }
 
+status_t VmObjectPaged::DontNeedRange(uint64_t offset, uint64_t len) {
+    canary_.Assert();
+
+    AutoLock a(&lock_);
+
+    uint64_t new_len;
+    if (!TrimRange(offset, len, size_, &new_len))
+        return MX_ERR_OUT_OF_RANGE;
+
+    if (new_len == 0)
+        return MX_OK;
+
+    // only whole pages inside the range can be reclaimed
+    uint64_t start = ROUNDUP_PAGE_SIZE(offset);
+    uint64_t end = ROUNDDOWN(offset + new_len, PAGE_SIZE);
+    if (start >= end)
+        return MX_OK;
+
+    page_list_.ForEveryPageInRange(
+        [](const auto p, uint64_t off) {
+            // skip pages we could never evict; see EvictDontNeedPages
+            if (p->state == VM_PAGE_STATE_OBJECT && p->object.pin_count == 0) {
+                p->object.dontneed = 1;
+            }
+            return MX_ERR_NEXT;
+        },
+        start, end);
+
+    // unmap the range so that any later touch refaults, which cancels the
+    // hint on that page
+    RangeChangeUpdateLocked(start, end - start);
+
+    return MX_OK;
+}
+
+status_t VmObjectPaged::WillNeedRange(uint64_t offset, uint64_t len) {
+    canary_.Assert();
+
+    {
+        AutoLock a(&lock_);
+
+        uint64_t new_len;
+        if (!TrimRange(offset, len, size_, &new_len))
+            return MX_ERR_OUT_OF_RANGE;
+
+        if (new_len == 0)
+            return MX_OK;
+
+        uint64_t start = ROUNDDOWN(offset, PAGE_SIZE);
+        uint64_t end = ROUNDUP_PAGE_SIZE(offset + new_len);
+
+        page_list_.ForEveryPageInRange(
+            [](const auto p, uint64_t off) {
+                if (p->state == VM_PAGE_STATE_OBJECT) {
+                    p->object.dontneed = 0;
+                }
+                return MX_ERR_NEXT;
+            },
+            start, end);
+    }
+
+    // bring in anything not already committed
+    return CommitRange(offset, len, nullptr);
+}
+
+size_t VmObjectPaged::EvictDontNeedPages(size_t max_pages) {
+    canary_.Assert();
+
+    list_node freed_list;
+    list_initialize(&freed_list);
+
+    size_t count = 0;
+    {
+        AutoLock a(&lock_);
+
+        page_list_.ForEveryPage(
+            [&](vm_page_t*& p, uint64_t off) TA_NO_THREAD_SAFETY_ANALYSIS {
+                if (count >= max_pages)
+                    return MX_ERR_STOP;
+                // the dontneed bit is only meaningful on object pages;
+                // wired pages (e.g. CreateFromROData) never have it set
+                if (p->state != VM_PAGE_STATE_OBJECT ||
+                    !p->object.dontneed || p->object.pin_count > 0) {
+                    return MX_ERR_NEXT;
+                }
+
+                // unmap everywhere before the page goes away
+                RangeChangeUpdateLocked(off, PAGE_SIZE);
+
+                list_add_tail(&freed_list, &p->free.node);
+                p = nullptr;
+                count++;
+                return MX_ERR_NEXT;
+            });
+
+        if (count > 0) {
+            page_list_.PruneEmptyNodes();
+            AdjustCommittedLocked(-static_cast<int64_t>(count));
+        }
+    }
+
+    if (count > 0) {
+        __UNUSED auto freed = pmm_free(&freed_list);
+        DEBUG_ASSERT(freed == count);
+        LTRACEF("%p evicted %zu don't-need pages\n", this, count);
+    }
+
+    return count;
+}
+
 status_t VmObjectPaged::Pin(uint64_t offset, uint64_t len) {
     canary_.Assert();
 
@@ -758,10 +1003,10 @@ status_t VmObjectPaged::ResizeLocked(uint64_t s) {
             // unmap all of the pages in this range on all the mapping regions
             RangeChangeUpdateLocked(start, page_aligned_len);
 
-            // iterate through the pages, freeing them
-            while (start < end) {
-                page_list_.FreePage(start);
-                start += PAGE_SIZE;
+            // free the pages, returning them to the pmm in one batch
+            size_t freed = page_list_.FreePagesInRange(start, end);
+            if (freed > 0) {
+                AdjustCommittedLocked(-static_cast<int64_t>(freed));
             }
         }
     } else if (s > size_) {
@@ -1047,6 +1292,32 @@ status_t VmObjectPaged::CacheOp(const uint64_t start_offset, const uint64_t len,
     const size_t end_offset = static_cast<size_t>(start_offset + len);
     size_t op_start_offset = static_cast<size_t>(start_offset);
 
+    // Committed pages that are physically contiguous are also virtually
+    // contiguous in the kernel physmap, so batch runs of them into a single
+    // arch call below. The arch routines only issue their completion
+    // barriers once per call, which matters for multi-megabyte DMA buffers
+    // that would otherwise eat a barrier per page.
+    addr_t run_addr = 0;
+    size_t run_len = 0;
+
+    // Perform a single arch cache op against [addr, addr + op_len).
+    auto cache_op = [type](addr_t addr, size_t op_len) {
+        switch (type) {
+        case CacheOpType::Invalidate:
+            arch_invalidate_cache_range(addr, op_len);
+            break;
+        case CacheOpType::Clean:
+            arch_clean_cache_range(addr, op_len);
+            break;
+        case CacheOpType::CleanInvalidate:
+            arch_clean_invalidate_cache_range(addr, op_len);
+            break;
+        case CacheOpType::Sync:
+            arch_sync_cache_range(addr, op_len);
+            break;
+        }
+    };
+
     while (op_start_offset != end_offset) {
         // Offset at the end of the current page.
         const size_t page_end_offset = ROUNDUP(op_start_offset + 1, PAGE_SIZE);
@@ -1068,26 +1339,28 @@ status_t VmObjectPaged::CacheOp(const uint64_t start_offset, const uint64_t len,
             const void* ptr = paddr_to_kvaddr(pa);
             const addr_t cache_op_addr = reinterpret_cast<addr_t>(ptr) + page_offset;
 
-            // Perform the necessary cache op against this page.
-            switch (type) {
-            case CacheOpType::Invalidate:
-                arch_invalidate_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::Clean:
-                arch_clean_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::CleanInvalidate:
-                arch_clean_invalidate_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::Sync:
-                arch_sync_cache_range(cache_op_addr, cache_op_len);
-                break;
+            // Extend the current run if this page is virtually adjacent to
+            // it; otherwise flush the run and start a new one here.
+            if (run_len > 0 && run_addr + run_len == cache_op_addr) {
+                run_len += cache_op_len;
+            } else {
+                if (run_len > 0)
+                    cache_op(run_addr, run_len);
+                run_addr = cache_op_addr;
+                run_len = cache_op_len;
             }
+        } else if (run_len > 0) {
+            // An uncommitted page breaks the run.
+            cache_op(run_addr, run_len);
+            run_len = 0;
         }
 
         op_start_offset += cache_op_len;
     }
 
+    if (run_len > 0)
+        cache_op(run_addr, run_len);
+
     return MX_OK;
 }
 
@@ -68,6 +68,18 @@ VmPageList::~VmPageList() {
     DEBUG_ASSERT(list_.is_empty());
 }
 
+VmPageListNode* VmPageList::LookupNodeLocked(uint64_t node_offset) {
+    if (cached_node_ && cached_node_->offset() == node_offset)
+        return cached_node_;
+
+    auto pln = list_.find(node_offset);
+    if (!pln.IsValid())
+        return nullptr;
+
+    cached_node_ = &*pln;
+    return cached_node_;
+}
+
 status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
@@ -76,8 +88,8 @@ status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
                   node_offset, index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    auto pln = LookupNodeLocked(node_offset);
+    if (!pln) {
         AllocChecker ac;
         mxtl::unique_ptr<VmPageListNode> pl =
             mxtl::unique_ptr<VmPageListNode>(new (&ac) VmPageListNode(node_offset));
@@ -88,6 +100,7 @@ status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
         __UNUSED auto status = pl->AddPage(p, index);
         DEBUG_ASSERT(status == MX_OK);
 
+        cached_node_ = pl.get();
         list_.insert(mxtl::move(pl));
     } else {
         pln->AddPage(p, index);
@@ -104,8 +117,8 @@ vm_page* VmPageList::GetPage(uint64_t offset) {
                   index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    auto pln = LookupNodeLocked(node_offset);
+    if (!pln) {
         return nullptr;
     }
 
@@ -120,8 +133,8 @@ status_t VmPageList::FreePage(uint64_t offset) {
                   index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    auto pln = LookupNodeLocked(node_offset);
+    if (!pln) {
         return MX_ERR_NOT_FOUND;
     }
 
@@ -131,6 +144,7 @@ status_t VmPageList::FreePage(uint64_t offset) {
         // if it was the last page in the node, remove the node from the tree
         if (pln->IsEmpty()) {
             LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
+            cached_node_ = nullptr;
             list_.erase(*pln);
         }
 
@@ -140,6 +154,49 @@ status_t VmPageList::FreePage(uint64_t offset) {
     return MX_OK;
 }
 
+size_t VmPageList::FreePagesInRange(uint64_t start_offset, uint64_t end_offset) {
+    LTRACEF("%p start %#" PRIx64 " end %#" PRIx64 "\n", this, start_offset, end_offset);
+
+    list_node list;
+    list_initialize(&list);
+
+    size_t count = 0;
+
+    // pull every page in the range out of its node
+    ForEveryPageInRange(
+        [&](vm_page*& p, uint64_t offset) {
+            list_add_tail(&list, &p->free.node);
+            p = nullptr;
+            count++;
+            return MX_ERR_NEXT;
+        },
+        start_offset, end_offset);
+
+    if (count == 0)
+        return 0;
+
+    PruneEmptyNodes();
+
+    // return all the pages to the pmm at once
+    __UNUSED auto freed = pmm_free(&list);
+    DEBUG_ASSERT(freed == count);
+
+    return count;
+}
+
+void VmPageList::PruneEmptyNodes() {
+    auto iter = list_.begin();
+    while (iter != list_.end()) {
+        auto& node = *iter;
+        ++iter;
+        if (node.IsEmpty()) {
+            if (cached_node_ == &node)
+                cached_node_ = nullptr;
+            list_.erase(node);
+        }
+    }
+}
+
 size_t VmPageList::FreeAllPages() {
     LTRACEF("%p\n", this);
 
@@ -165,6 +222,7 @@ size_t VmPageList::FreeAllPages() {
     DEBUG_ASSERT(freed == count);
 
     // empty the tree
+    cached_node_ = nullptr;
     list_.clear();
 
     return count;
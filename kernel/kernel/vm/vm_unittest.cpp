@@ -4,9 +4,11 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <arch/ops.h>
 #include <assert.h>
 #include <err.h>
 #include <kernel/vm.h>
+#include <kernel/vm/pmm.h>
 #include <kernel/vm/vm_address_region.h>
 #include <kernel/vm/vm_aspace.h>
 #include <kernel/vm/vm_object.h>
@@ -71,6 +73,22 @@ static bool pmm_oversized_alloc_test(void* context) {
     END_TEST;
 }
 
+// Checks the numa topology accessors are self consistent.
+static bool pmm_numa_test(void* context) {
+    BEGIN_TEST;
+    uint32_t nodes = pmm_numa_node_count();
+    EXPECT_TRUE(nodes >= 1, "at least one numa node");
+
+    uint32_t local_node = pmm_numa_cpu_node(arch_curr_cpu_num());
+    EXPECT_TRUE(local_node < nodes, "local node within node count");
+
+    pmm_numa_node_info_t info;
+    pmm_numa_get_node_info(local_node, &info);
+    EXPECT_TRUE(info.num_cpus >= 1, "local node has at least this cpu");
+    EXPECT_NEQ(0u, info.mem_bytes, "local node has memory");
+    END_TEST;
+}
+
 static uint32_t test_rand(uint32_t seed) {
     return (seed = seed * 1664525 + 1013904223);
 }
@@ -304,6 +322,37 @@ static bool vmaspace_alloc_smoke_test(void* context) {
     END_TEST;
 }
 
+// Allocates several regions, frees one out of the middle, and checks that
+// the freed hole is found again; exercises the allocator's gap index
+// across insert, remove, and re-insert of subregions.
+static bool vmaspace_gap_reuse_test(void* context) {
+    BEGIN_TEST;
+    static const size_t alloc_size = 16 * 1024;
+
+    mxtl::RefPtr<VmAspace> aspace = VmAspace::Create(0, "test aspace gaps");
+    EXPECT_NEQ(nullptr, aspace, "VmAspace::Create pointer");
+
+    void* ptr[4];
+    for (unsigned i = 0; i < countof(ptr); i++) {
+        auto err = aspace->Alloc("test", alloc_size, &ptr[i], 0, 0, kArchRwFlags);
+        EXPECT_EQ(MX_OK, err, "VmAspace::Alloc region of memory");
+        EXPECT_NEQ(nullptr, ptr[i], "VmAspace::Alloc region of memory");
+    }
+
+    // punch a hole in the middle of the run, then allocate again
+    auto err = aspace->FreeRegion(reinterpret_cast<vaddr_t>(ptr[1]));
+    EXPECT_EQ(MX_OK, err, "VmAspace::FreeRegion");
+
+    void* ptr2;
+    err = aspace->Alloc("test", alloc_size, &ptr2, 0, 0, kArchRwFlags);
+    EXPECT_EQ(MX_OK, err, "VmAspace::Alloc reuses freed gap");
+    EXPECT_NEQ(nullptr, ptr2, "VmAspace::Alloc reuses freed gap");
+
+    err = aspace->Destroy();
+    EXPECT_EQ(MX_OK, err, "VmAspace::Destroy");
+    END_TEST;
+}
+
 // Doesn't do anything, just prints all aspaces.
 // Should be run after all other tests so that people can manually comb
 // through the output for leaked test aspaces.
@@ -472,6 +521,109 @@ static bool vmo_odd_size_commit_test(void* context) {
     END_TEST;
 }
 
+// Creates a vm object, hints pages don't-need, and evicts them.
+static bool vmo_dontneed_test(void* context) {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 16;
+    mxtl::RefPtr<VmObject> vmo;
+    mx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, alloc_size, &vmo);
+    REQUIRE_EQ(status, MX_OK, "vmobject creation\n");
+    REQUIRE_TRUE(vmo, "vmobject creation\n");
+
+    uint64_t committed;
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    EXPECT_EQ(MX_OK, status, "committing vm object\n");
+
+    // nothing hinted yet, so nothing to evict
+    EXPECT_EQ(0u, vmo->EvictDontNeedPages(SIZE_MAX), "evicting with no hints\n");
+
+    status = vmo->DontNeedRange(alloc_size + PAGE_SIZE, PAGE_SIZE);
+    EXPECT_EQ(MX_ERR_OUT_OF_RANGE, status, "hinting out of range\n");
+
+    status = vmo->DontNeedRange(0, 4 * PAGE_SIZE);
+    EXPECT_EQ(MX_OK, status, "hinting don't-need\n");
+
+    // a will-need hint cancels the don't-need hint
+    status = vmo->WillNeedRange(0, PAGE_SIZE);
+    EXPECT_EQ(MX_OK, status, "hinting will-need\n");
+
+    EXPECT_EQ(1u, vmo->EvictDontNeedPages(1), "evicting with a cap\n");
+    EXPECT_EQ(2u, vmo->EvictDontNeedPages(SIZE_MAX), "evicting the rest\n");
+    EXPECT_EQ(alloc_size / PAGE_SIZE - 3, vmo->AllocatedPages(),
+              "pages after eviction\n");
+
+    // pinned pages must survive a don't-need hint
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    EXPECT_EQ(MX_OK, status, "recommitting vm object\n");
+    status = vmo->Pin(0, PAGE_SIZE);
+    EXPECT_EQ(MX_OK, status, "pinning first page\n");
+    status = vmo->DontNeedRange(0, 2 * PAGE_SIZE);
+    EXPECT_EQ(MX_OK, status, "hinting pinned range\n");
+    EXPECT_EQ(1u, vmo->EvictDontNeedPages(SIZE_MAX), "evicting around pin\n");
+    vmo->Unpin(0, PAGE_SIZE);
+
+    END_TEST;
+}
+
+// Creates a COW clone chain and verifies an unreachable intermediate
+// parent is flattened into its only clone.
+static bool vmo_clone_flatten_test(void* context) {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 4;
+    mxtl::RefPtr<VmObject> vmo;
+    mx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, alloc_size, &vmo);
+    REQUIRE_EQ(status, MX_OK, "vmobject creation\n");
+    REQUIRE_TRUE(vmo, "vmobject creation\n");
+
+    // fill each page of the root with its index
+    for (size_t i = 0; i < alloc_size / PAGE_SIZE; i++) {
+        uint8_t val = static_cast<uint8_t>(i);
+        size_t written;
+        status = vmo->Write(&val, i * PAGE_SIZE, 1, &written);
+        REQUIRE_EQ(MX_OK, status, "writing to root vmo\n");
+    }
+
+    mxtl::RefPtr<VmObject> clone;
+    status = vmo->CloneCOW(0, alloc_size, false, &clone);
+    REQUIRE_EQ(MX_OK, status, "creating clone\n");
+    EXPECT_EQ(1u, clone->clone_chain_depth(), "clone depth\n");
+
+    // shadow page 0 in the clone
+    uint8_t val = 0xff;
+    size_t written;
+    status = clone->Write(&val, 0, 1, &written);
+    EXPECT_EQ(MX_OK, status, "writing to clone\n");
+
+    // as long as the root is still reachable nothing is flattened
+    mxtl::RefPtr<VmObject> extra_clone;
+    status = vmo->CloneCOW(0, alloc_size, false, &extra_clone);
+    REQUIRE_EQ(MX_OK, status, "creating second clone\n");
+    vmo->OnZeroHandles();
+    EXPECT_EQ(1u, clone->clone_chain_depth(), "depth with two clones\n");
+    extra_clone.reset();
+
+    // with a single clone left, dropping the root's handles folds its
+    // unshadowed pages into the clone
+    vmo->OnZeroHandles();
+    EXPECT_EQ(0u, clone->clone_chain_depth(), "depth after flattening\n");
+    EXPECT_FALSE(clone->is_cow_clone(), "clone reparented to root\n");
+    EXPECT_EQ(0u, vmo->AllocatedPages(), "parent pages after flattening\n");
+    EXPECT_EQ(alloc_size / PAGE_SIZE, clone->AllocatedPages(),
+              "clone pages after flattening\n");
+
+    // the clone sees its own page 0 and the root's other pages
+    for (size_t i = 0; i < alloc_size / PAGE_SIZE; i++) {
+        uint8_t expected = (i == 0) ? 0xff : static_cast<uint8_t>(i);
+        uint8_t actual;
+        size_t read;
+        status = clone->Read(&actual, i * PAGE_SIZE, 1, &read);
+        REQUIRE_EQ(MX_OK, status, "reading from clone\n");
+        EXPECT_EQ(expected, actual, "clone page contents\n");
+    }
+
+    END_TEST;
+}
+
 // Creates a vm object, commits contiguous memory.
 static bool vmo_contiguous_commit_test(void* context) {
     BEGIN_TEST;
@@ -892,6 +1044,7 @@ UNITTEST_START_TESTCASE(vm_tests)
 VM_UNITTEST(pmm_smoke_test)
 VM_UNITTEST(pmm_large_alloc_test)
 VM_UNITTEST(pmm_oversized_alloc_test)
+VM_UNITTEST(pmm_numa_test)
 VM_UNITTEST(vmm_alloc_smoke_test)
 VM_UNITTEST(vmm_alloc_contiguous_smoke_test)
 VM_UNITTEST(multiple_regions_test)
@@ -901,11 +1054,14 @@ VM_UNITTEST(vmm_alloc_contiguous_missing_flag_commit_fails)
 VM_UNITTEST(vmm_alloc_contiguous_zero_size_fails)
 VM_UNITTEST(vmaspace_create_smoke_test)
 VM_UNITTEST(vmaspace_alloc_smoke_test)
+VM_UNITTEST(vmaspace_gap_reuse_test)
 VM_UNITTEST(vmo_create_test)
 VM_UNITTEST(vmo_pin_test)
 VM_UNITTEST(vmo_multiple_pin_test)
 VM_UNITTEST(vmo_commit_test)
 VM_UNITTEST(vmo_odd_size_commit_test)
+VM_UNITTEST(vmo_dontneed_test)
+VM_UNITTEST(vmo_clone_flatten_test)
 VM_UNITTEST(vmo_contiguous_commit_test)
 VM_UNITTEST(vmo_precommitted_map_test)
 VM_UNITTEST(vmo_demand_paged_map_test)
@@ -12,6 +12,7 @@
 #include <string.h>
 #include <assert.h>
 #include <lib/cbuf.h>
+#include <kernel/atomic.h>
 #include <kernel/event.h>
 #include <kernel/spinlock.h>
 
@@ -269,3 +270,102 @@ retry:
     return ret;
 }
 
+void cbuf_spsc_initialize(cbuf_spsc_t *spsc, size_t len)
+{
+    DEBUG_ASSERT(spsc);
+    DEBUG_ASSERT(len > 0);
+    DEBUG_ASSERT(ispow2(len));
+
+    spsc->head = 0;
+    spsc->tail = 0;
+    spsc->len_pow2 = log2_uint_floor(len);
+    spsc->buf = malloc(len);
+    event_init(&spsc->event, false, 0);
+
+    LTRACEF("len %zu, len_pow2 %u\n", len, spsc->len_pow2);
+}
+
+size_t cbuf_spsc_space_avail(cbuf_spsc_t *spsc)
+{
+    uint head = (uint)atomic_load_relaxed(&spsc->head);
+    uint tail = (uint)atomic_load_relaxed(&spsc->tail);
+    uint consumed = modpow2(head - tail, spsc->len_pow2);
+    return valpow2(spsc->len_pow2) - consumed - 1;
+}
+
+size_t cbuf_spsc_write_char(cbuf_spsc_t *spsc, char c, bool canreschedule)
+{
+    DEBUG_ASSERT(spsc);
+
+    uint head = (uint)atomic_load_relaxed(&spsc->head); // producer owned
+    uint tail = (uint)atomic_load_acquire(&spsc->tail);
+
+    if (modpow2(head - tail, spsc->len_pow2) == valpow2(spsc->len_pow2) - 1)
+        return 0; // full
+
+    spsc->buf[head] = c;
+    // publish the byte before the index
+    atomic_store_release(&spsc->head, (int)modpow2(head + 1, spsc->len_pow2));
+
+    // Only the empty to non-empty edge needs a wakeup; while the ring
+    // stays non-empty the consumer is either running or already signaled.
+    int signaled = 0;
+    if (head == tail)
+        signaled = event_signal(&spsc->event, false);
+
+    if (canreschedule && signaled > 0)
+        thread_reschedule();
+
+    return 1;
+}
+
+size_t cbuf_spsc_read(cbuf_spsc_t *spsc, void *_buf, size_t buflen, bool block)
+{
+    char *buf = (char *)_buf;
+
+    DEBUG_ASSERT(spsc);
+
+retry:
+    if (block)
+        event_wait(&spsc->event);
+
+    uint tail = (uint)atomic_load_relaxed(&spsc->tail); // consumer owned
+    uint head = (uint)atomic_load_acquire(&spsc->head);
+
+    size_t pos = 0;
+
+    // at most two passes to deal with wraparound
+    while (pos < buflen && tail != head) {
+        size_t read_len;
+        if (head > tail) {
+            read_len = MIN(head - tail, buflen - pos);
+        } else {
+            read_len = MIN(valpow2(spsc->len_pow2) - tail, buflen - pos);
+        }
+
+        if (NULL != buf) {
+            memcpy(buf + pos, spsc->buf + tail, read_len);
+        }
+
+        tail = modpow2(tail + (uint)read_len, spsc->len_pow2);
+        pos += read_len;
+    }
+
+    // retire the bytes before the producer can check for the empty edge
+    atomic_store_release(&spsc->tail, (int)tail);
+
+    if (tail == head) {
+        event_unsignal(&spsc->event);
+        // The producer only signals on the empty to non-empty edge; it may
+        // have appended between our head load and the unsignal, so recheck
+        // before anyone goes back to sleep on the event.
+        if ((uint)atomic_load_acquire(&spsc->head) != tail)
+            event_signal(&spsc->event, false);
+    }
+
+    if (block && pos == 0)
+        goto retry;
+
+    return pos;
+}
+
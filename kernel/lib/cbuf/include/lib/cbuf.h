@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <arch/defines.h>
 #include <magenta/compiler.h>
 #include <sys/types.h>
 #include <kernel/event.h>
@@ -203,5 +204,70 @@ static inline void cbuf_reset(cbuf_t *cbuf)
 size_t cbuf_read_char(cbuf_t *cbuf, char *c, bool block);
 size_t cbuf_write_char(cbuf_t *cbuf, char c, bool canreschedule);
 
+/**
+ * cbuf_spsc_t
+ *
+ * Single-producer/single-consumer byte ring for interrupt-to-thread
+ * streams such as uart rx.  Each side owns exactly one index, so neither
+ * read nor write ever takes a lock, and the indices sit on separate
+ * cache lines so the producer's stores do not bounce the consumer's
+ * line.  The event is only signaled on the empty to non-empty edge.
+ *
+ * Exactly one producer context and one consumer context may use a given
+ * ring at a time; use cbuf_t when either side is shared.
+ */
+typedef struct cbuf_spsc {
+    volatile int head __ALIGNED(CACHE_LINE); // written only by the producer
+    volatile int tail __ALIGNED(CACHE_LINE); // written only by the consumer
+    uint len_pow2;
+    char *buf;
+    event_t event;
+} cbuf_spsc_t;
+
+/**
+ * cbuf_spsc_initialize
+ *
+ * Initialize an spsc ring, mallocing the underlying data buffer.  len must
+ * be a power of two.
+ */
+void cbuf_spsc_initialize(cbuf_spsc_t *spsc, size_t len);
+
+/**
+ * cbuf_spsc_write_char
+ *
+ * Producer side: append one byte without taking any lock, safe to call
+ * from interrupt context.  Returns the number of bytes written (0 when
+ * the ring is full).
+ */
+size_t cbuf_spsc_write_char(cbuf_spsc_t *spsc, char c, bool canreschedule);
+
+/**
+ * cbuf_spsc_read
+ *
+ * Consumer side: read up to buflen bytes, optionally blocking until at
+ * least one byte is available.  As with cbuf_read, a NULL buf skips the
+ * bytes instead of copying them.
+ */
+size_t cbuf_spsc_read(cbuf_spsc_t *spsc, void *buf, size_t buflen, bool block);
+
+/**
+ * cbuf_spsc_read_char
+ *
+ * @see cbuf_spsc_read
+ *
+ * Alias which reads a single byte.
+ */
+static inline size_t cbuf_spsc_read_char(cbuf_spsc_t *spsc, char *c, bool block) {
+    return cbuf_spsc_read(spsc, c, 1, block);
+}
+
+/**
+ * cbuf_spsc_space_avail
+ *
+ * @return The number of bytes which can currently be written.  Only
+ * stable when called from the producer context.
+ */
+size_t cbuf_spsc_space_avail(cbuf_spsc_t *spsc);
+
 __END_CDECLS
 
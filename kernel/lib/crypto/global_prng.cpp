@@ -6,17 +6,22 @@
 
 #include <lib/crypto/global_prng.h>
 
+#include <arch/ops.h>
 #include <assert.h>
 #include <ctype.h>
 #include <dev/hw_rng.h>
 #include <err.h>
 #include <kernel/auto_lock.h>
 #include <kernel/cmdline.h>
+#include <kernel/mp.h>
 #include <kernel/mutex.h>
+#include <kernel/spinlock.h>
 #include <lib/crypto/cryptolib.h>
 #include <lib/crypto/prng.h>
+#include <magenta/compiler.h>
 #include <mxcpp/new.h>
 #include <mxtl/algorithm.h>
+#include <mxtl/atomic.h>
 #include <lk/init.h>
 #include <string.h>
 
@@ -36,6 +41,85 @@ PRNG* GetInstance() {
     return kGlobalPrng;
 }
 
+// Per-cpu generators, seeded from the root pool once threading is up.
+// Each one runs in the PRNG's non-thread-safe mode and is only ever
+// touched by its own cpu with interrupts disabled, so draws through it
+// never take a lock and never contend with other cpus.
+namespace {
+
+struct PerCpuPrng {
+    PRNG* prng;
+    // The value of entropy_generation the last reseed observed.
+    uint64_t generation;
+    // Draws remaining before a routine reseed from the root pool.
+    size_t draws_left;
+} __CPU_MAX_ALIGN;
+
+PerCpuPrng per_cpu_prng[SMP_MAX_CPUS];
+
+// Set (with release semantics) once every per-cpu generator exists.
+mxtl::atomic<bool> per_cpu_ready;
+
+// Bumped by AddEntropy() whenever new entropy reaches the root pool so
+// that every per-cpu generator reseeds before its next draw.
+mxtl::atomic<uint64_t> entropy_generation;
+
+// How many draws a per-cpu generator may serve between reseeds.  This
+// only bounds how long a compromised per-cpu state could keep producing
+// predictable output; the states are never exposed, so the value mostly
+// trades root-lock traffic against paranoia.
+constexpr size_t kDrawsPerReseed = 4096;
+
+} // namespace
+
+void Draw(void* out, size_t size) {
+    // Early boot runs single-threaded, so just use the root generator
+    // until the per-cpu ones have been constructed.
+    if (unlikely(!per_cpu_ready.load(mxtl::memory_order_acquire))) {
+        GetInstance()->Draw(out, size);
+        return;
+    }
+
+    // Seed material for a reseed must be drawn from the root pool with
+    // interrupts enabled (it takes the root lock), but we only know
+    // whether this cpu's generator needs one once migration is off.  So
+    // optimistically draw without seed material, and if a reseed turns
+    // out to be due, fetch some and retry on whatever cpu we land on.
+    uint8_t seed[PRNG::kMinEntropy];
+    bool have_seed = false;
+    for (;;) {
+        spin_lock_saved_state_t state;
+        arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+        PerCpuPrng* pp = &per_cpu_prng[arch_curr_cpu_num()];
+        const uint64_t gen = entropy_generation.load();
+        if (pp->generation != gen || pp->draws_left == 0) {
+            if (!have_seed) {
+                arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+                GetInstance()->Draw(seed, sizeof(seed));
+                have_seed = true;
+                continue;
+            }
+            pp->prng->AddEntropy(seed, sizeof(seed));
+            pp->generation = gen;
+            pp->draws_left = kDrawsPerReseed;
+        }
+        pp->prng->Draw(out, size);
+        pp->draws_left--;
+
+        arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+        break;
+    }
+    if (have_seed) {
+        memset(seed, 0, sizeof(seed));
+    }
+}
+
+void AddEntropy(const void* data, size_t size) {
+    GetInstance()->AddEntropy(data, size);
+    entropy_generation.fetch_add(1);
+}
+
 // TODO(security): Remove this in favor of virtio-rng once it is available and
 // we decide we don't need it for getting entropy from elsewhere.
 static size_t IntegrateCmdlineEntropy() {
@@ -206,9 +290,25 @@ static void EarlyBootSeed(uint level) {
     }
 }
 
-// Migrate the global PRNG to enter thread-safe mode.
+// Migrate the global PRNG to enter thread-safe mode and bring up the
+// per-cpu generators, each seeded from the root pool.
 static void BecomeThreadSafe(uint level) {
     GetInstance()->BecomeThreadSafe();
+
+    // Statically allocated for the same reason as the root PRNG above.
+    alignas(alignof(PRNG)) static uint8_t space[SMP_MAX_CPUS][sizeof(PRNG)];
+    uint8_t seed[PRNG::kMinEntropy];
+    const uint64_t gen = entropy_generation.load();
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        GetInstance()->Draw(seed, sizeof(seed));
+        per_cpu_prng[i].prng =
+            new (&space[i]) PRNG(seed, sizeof(seed), PRNG::NonThreadSafeTag());
+        per_cpu_prng[i].generation = gen;
+        per_cpu_prng[i].draws_left = kDrawsPerReseed;
+    }
+    memset(seed, 0, sizeof(seed));
+
+    per_cpu_ready.store(true, mxtl::memory_order_release);
 }
 
 } //namespace GlobalPRNG
@@ -21,6 +21,16 @@ namespace GlobalPRNG {
 // guaranteed to be non-null.
 PRNG* GetInstance();
 
+// Draws |size| bytes of pseudorandom data into |out|.  Once threading is
+// up this uses a per-cpu generator and takes no lock; before that it
+// falls back to the root generator returned by GetInstance().  |size|
+// MUST NOT be greater than PRNG::kMaxDrawLen.
+void Draw(void* out, size_t size);
+
+// Mixes |size| bytes of entropy into the root pool and arranges for
+// every per-cpu generator to reseed from it before its next draw.
+void AddEntropy(const void* data, size_t size);
+
 #if ENABLE_ENTROPY_COLLECTOR_TEST
 namespace internal {
 
@@ -8,13 +8,18 @@
 
 #include <err.h>
 #include <dev/udisplay.h>
+#include <kernel/atomic.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/vm.h>
 #include <lib/user_copy.h>
 #include <lib/io.h>
 #include <lib/version.h>
 #include <lk/init.h>
 #include <platform.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #define DLOG_SIZE (128u * 1024u)
@@ -46,13 +51,21 @@ static dlog_t DLOG = {
 // or body may wrap but the initial header word never does).
 //
 // The ring buffer position is maintained by continuously incrementing
-// head and tail pointers (type size_t, so uint64_t on 64bit systems),
+// head and tail pointers (type uint64_t).
 //
 // This allows readers to trivial compute if their local tail
 // pointer has "fallen out" of the fifo (an entire fifo's worth
 // of messages were written since they last tried to read) and then
 // they can snap their tail to the global tail and restart
 //
+// Only writers take the spinlock, to serialize against each other.
+// Readers run lockless, seqlock style: a writer advances the global
+// tail (with a release barrier) before overwriting reclaimed space,
+// and publishes the new head (with a release store) after the record
+// is fully written.  A reader copies a record out and then re-checks
+// the global tail; if its position was reclaimed mid-copy the data may
+// be torn and it retries from the new tail.  Logging cost is therefore
+// constant no matter how aggressively readers poll.
 //
 // Tail indicates the oldest message in the debug log to read
 // from, Head indicates the next space in the debug log to write
@@ -66,7 +79,7 @@ static dlog_t DLOG = {
 
 #define ALIGN4(n) (((n) + 3) & (~3))
 
-status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
+static status_t dlog_write_internal(uint32_t flags, const void* ptr, size_t len) {
     dlog_t* log = &DLOG;
 
     if (len > DLOG_MAX_DATA) {
@@ -100,14 +113,24 @@ status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&log->lock, state);
 
+    uint64_t head = log->head;
+
     // Discard records at tail until there is enough
     // space for the new record.
-    while ((log->head - log->tail) > (DLOG_SIZE - wiresize)) {
-        uint32_t header = *((uint32_t*) (log->data + (log->tail & DLOG_MASK)));
-        log->tail += DLOG_HDR_GET_FIFOLEN(header);
+    uint64_t tail = log->tail;
+    while ((head - tail) > (DLOG_SIZE - wiresize)) {
+        uint32_t header = *((uint32_t*) (log->data + (tail & DLOG_MASK)));
+        tail += DLOG_HDR_GET_FIFOLEN(header);
+    }
+    if (tail != log->tail) {
+        // Publish the advanced tail before overwriting the reclaimed
+        // space, so a reader racing with us is guaranteed to fail its
+        // post-copy tail check and retry rather than see torn data.
+        atomic_store_u64_relaxed(&log->tail, tail);
+        atomic_fence_release();
     }
 
-    size_t offset = (log->head & DLOG_MASK);
+    size_t offset = (head & DLOG_MASK);
 
     size_t fifospace = DLOG_SIZE - offset;
 
@@ -128,7 +151,9 @@ status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
         memcpy(log->data + offset, ptr, fifospace);
         memcpy(log->data, ptr + fifospace, len - fifospace);
     }
-    log->head += wiresize;
+
+    // make the fully-written record visible before moving head past it
+    atomic_store_u64_release(&log->head, head + wiresize);
 
     // if we happen to be called from within the global thread lock, use a
     // special version of event signal
@@ -143,6 +168,249 @@ status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
     return MX_OK;
 }
 
+status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
+    // deferred records carry kernel pointers, so only the kernel-side
+    // dlog_write_deferred() may mark them
+    return dlog_write_internal(flags & ~DLOG_FLAG_DEFERRED, ptr, len);
+}
+
+// Deferred format records defer all conversion work to read time; the
+// in-path cost is a scan of the format string and a store per argument.
+// Arguments are captured raw in uint64_t slots, so only conversions
+// whose argument fits one integer register can be deferred.
+
+typedef enum {
+    ARG_NONE, // no argument consumed (%%)
+    ARG_INT,  // char and short promote to int
+    ARG_LONG,
+    ARG_LONGLONG,
+    ARG_SIZET,
+    ARG_PTRDIFF,
+    ARG_PTR,
+    ARG_STR,
+    ARG_BAD, // a conversion we cannot defer
+} dlog_argtype_t;
+
+// Parse the conversion spec starting at the '%' at *_fmt, advancing
+// past it. If |spec| is not NULL the complete spec (including the '%')
+// is copied out NUL-terminated for read-time rendering.
+static dlog_argtype_t dlog_conversion(const char** _fmt, char* spec, size_t specmax) {
+    const char* start = *_fmt;
+    const char* p = start + 1;
+    dlog_argtype_t type = ARG_BAD;
+    dlog_argtype_t mod = ARG_NONE;
+    int lcount = 0;
+
+    for (;;) {
+        char c = *p;
+        if (c == 0) {
+            break;
+        }
+        p++;
+        if (((c >= '0') && (c <= '9')) || (c == '.') || (c == '-') ||
+            (c == '+') || (c == ' ') || (c == '#')) {
+            continue;
+        }
+        if (c == 'l') {
+            lcount++;
+            continue;
+        }
+        if (c == 'h') {
+            continue; // promotes to int anyway
+        }
+        if (c == 'z') {
+            mod = ARG_SIZET;
+            continue;
+        }
+        if (c == 'j') {
+            mod = ARG_LONGLONG;
+            continue;
+        }
+        if (c == 't') {
+            mod = ARG_PTRDIFF;
+            continue;
+        }
+        switch (c) {
+        case '%':
+            type = ARG_NONE;
+            break;
+        case 'c':
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (mod != ARG_NONE) {
+                type = mod;
+            } else {
+                type = (lcount >= 2) ? ARG_LONGLONG : (lcount == 1) ? ARG_LONG : ARG_INT;
+            }
+            break;
+        case 'p':
+            type = ARG_PTR;
+            break;
+        case 's':
+            type = ARG_STR;
+            break;
+        default:
+            // %f and friends, %n, %*d, anything unknown
+            type = ARG_BAD;
+            break;
+        }
+        break;
+    }
+
+    if (spec != NULL) {
+        size_t len = p - start;
+        if (len < specmax) {
+            memcpy(spec, start, len);
+            spec[len] = 0;
+        } else {
+            type = ARG_BAD;
+        }
+    }
+    *_fmt = p;
+    return type;
+}
+
+status_t dlog_write_deferred(uint32_t flags, const char* fmt, ...) {
+    dlog_deferred_t rec;
+    size_t nargs = 0;
+    bool ok = true;
+    va_list ap;
+
+    rec.fmt = fmt;
+    va_start(ap, fmt);
+    for (const char* p = fmt; (p = strchr(p, '%')) != NULL;) {
+        dlog_argtype_t type = dlog_conversion(&p, NULL, 0);
+        if (type == ARG_NONE) {
+            continue;
+        }
+        if ((type == ARG_BAD) || (nargs == DLOG_DEFERRED_MAX_ARGS)) {
+            ok = false;
+            break;
+        }
+        switch (type) {
+        case ARG_INT:
+            rec.args[nargs++] = (uint64_t)(int64_t)va_arg(ap, int);
+            break;
+        case ARG_LONG:
+            rec.args[nargs++] = (uint64_t)(int64_t)va_arg(ap, long);
+            break;
+        case ARG_LONGLONG:
+            rec.args[nargs++] = (uint64_t)va_arg(ap, long long);
+            break;
+        case ARG_SIZET:
+            rec.args[nargs++] = (uint64_t)va_arg(ap, size_t);
+            break;
+        case ARG_PTRDIFF:
+            rec.args[nargs++] = (uint64_t)va_arg(ap, ptrdiff_t);
+            break;
+        default: // ARG_PTR, ARG_STR
+            rec.args[nargs++] = (uint64_t)(uintptr_t)va_arg(ap, void*);
+            break;
+        }
+    }
+    va_end(ap);
+
+    if (!ok) {
+        // a format we cannot capture; pay for formatting now instead
+        char tmp[DLOG_MAX_DATA];
+        va_start(ap, fmt);
+        int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        if ((size_t)n >= sizeof(tmp)) {
+            n = sizeof(tmp) - 1;
+        }
+        return dlog_write_internal(flags & ~DLOG_FLAG_DEFERRED, tmp, n);
+    }
+
+    return dlog_write_internal(flags | DLOG_FLAG_DEFERRED, &rec,
+                               sizeof(rec.fmt) + nargs * sizeof(uint64_t));
+}
+
+// Render a deferred record's payload into text, in place. The caller's
+// buffer always has room for a maximal record, so expanding up to
+// DLOG_MAX_DATA is safe.
+static void dlog_render_deferred(dlog_header_t* hdr, char* data) {
+    dlog_deferred_t d;
+    memset(&d, 0, sizeof(d));
+    memcpy(&d, data, (hdr->datalen < sizeof(d)) ? hdr->datalen : sizeof(d));
+
+    char out[DLOG_MAX_DATA + 1];
+    size_t pos = 0;
+    size_t arg = 0;
+    const char* p = d.fmt;
+
+    // a record torn by a racing writer has already been rejected, but
+    // be paranoid about what we dereference anyway
+    if (!is_kernel_address((vaddr_t)p)) {
+        p = "<bad deferred format>";
+    }
+
+    while (*p && (pos < DLOG_MAX_DATA)) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        char spec[24];
+        dlog_argtype_t type = dlog_conversion(&p, spec, sizeof(spec));
+        if (type == ARG_NONE) {
+            out[pos++] = '%';
+            continue;
+        }
+        if (type == ARG_BAD) {
+            break;
+        }
+        uint64_t a = (arg < DLOG_DEFERRED_MAX_ARGS) ? d.args[arg] : 0;
+        arg++;
+        size_t space = DLOG_MAX_DATA + 1 - pos;
+        int n;
+        switch (type) {
+        case ARG_INT:
+            n = snprintf(out + pos, space, spec, (int)a);
+            break;
+        case ARG_LONG:
+            n = snprintf(out + pos, space, spec, (long)a);
+            break;
+        case ARG_LONGLONG:
+            n = snprintf(out + pos, space, spec, (long long)a);
+            break;
+        case ARG_SIZET:
+            n = snprintf(out + pos, space, spec, (size_t)a);
+            break;
+        case ARG_PTRDIFF:
+            n = snprintf(out + pos, space, spec, (ptrdiff_t)a);
+            break;
+        case ARG_PTR:
+            n = snprintf(out + pos, space, spec, (void*)(uintptr_t)a);
+            break;
+        default: { // ARG_STR
+            const char* s = (const char*)(uintptr_t)a;
+            if ((s == NULL) || !is_kernel_address((vaddr_t)s)) {
+                s = "<bad string>";
+            }
+            n = snprintf(out + pos, space, spec, s);
+            break;
+        }
+        }
+        if (n < 0) {
+            break;
+        }
+        pos += ((size_t)n < space) ? (size_t)n : (space - 1);
+    }
+
+    memcpy(data, out, pos);
+    hdr->datalen = pos;
+    hdr->flags &= ~DLOG_FLAG_DEFERRED;
+    hdr->header = DLOG_HDR_SET(DLOG_HDR_GET_FIFOLEN(hdr->header),
+                               DLOG_MIN_RECORD + pos);
+}
+
 // TODO: support reading multiple messages at a time
 // TODO: filter with flags
 status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, size_t* _actual) {
@@ -152,26 +420,41 @@ status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, si
     }
 
     dlog_t* log = rdr->log;
-    status_t status = MX_ERR_SHOULD_WAIT;
 
-    spin_lock_saved_state_t state;
-    spin_lock_irqsave(&log->lock, state);
-
-    size_t rtail = rdr->tail;
+    for (;;) {
+        uint64_t head = atomic_load_u64_acquire(&log->head);
+        uint64_t tail = atomic_load_u64_relaxed(&log->tail);
+        uint64_t rtail = rdr->tail;
+
+        // If the read-tail is not within the range of log-tail..log-head
+        // this reader has been lapped by a writer and we reset our read-tail
+        // to the current log-tail.
+        //
+        if ((head - tail) < (head - rtail)) {
+            rtail = tail;
+        }
 
-    // If the read-tail is not within the range of log-tail..log-head
-    // this reader has been lapped by a writer and we reset our read-tail
-    // to the current log-tail.
-    //
-    if ((log->head - log->tail) < (log->head - rtail)) {
-        rtail = log->tail;
-    }
+        if (rtail == head) {
+            rdr->tail = rtail;
+            return MX_ERR_SHOULD_WAIT;
+        }
 
-    if (rtail != log->head) {
         size_t offset = (rtail & DLOG_MASK);
-        uint32_t header = *((uint32_t*) (log->data + offset));
+        uint32_t header = *((volatile uint32_t*) (log->data + offset));
 
         size_t actual = DLOG_HDR_GET_READLEN(header);
+        size_t fifolen = DLOG_HDR_GET_FIFOLEN(header);
+
+        // A racing writer may have overwritten the record under us.
+        // Bound a possibly-torn header before copying so it cannot walk
+        // us past the caller's buffer; the tail check below catches the
+        // race itself and restarts from the new tail.
+        if ((fifolen < DLOG_MIN_RECORD) || (fifolen > DLOG_MAX_RECORD) ||
+            (actual < DLOG_MIN_RECORD) || (actual > fifolen)) {
+            rdr->tail = atomic_load_u64_relaxed(&log->tail);
+            continue;
+        }
+
         size_t fifospace = DLOG_SIZE - offset;
 
         if (fifospace >= actual) {
@@ -181,17 +464,27 @@ status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, si
             memcpy(ptr + fifospace, log->data, actual - fifospace);
         }
 
-        *_actual = actual;
-        status = MX_OK;
-
-        rtail += DLOG_HDR_GET_FIFOLEN(header);
-    }
-
-    rdr->tail = rtail;
+        // Validate after copying: if the record's start has been
+        // reclaimed by a writer the copy may be torn, so retry.
+        atomic_fence_acquire();
+        tail = atomic_load_u64_relaxed(&log->tail);
+        if ((head - tail) < (head - rtail)) {
+            rdr->tail = tail;
+            continue;
+        }
 
-    spin_unlock_irqrestore(&log->lock, state);
+        // Now that the copy is known good, a deferred record can be
+        // rendered from our private buffer into text.
+        dlog_header_t* hdr = ptr;
+        if (hdr->flags & DLOG_FLAG_DEFERRED) {
+            dlog_render_deferred(hdr, (char*)ptr + sizeof(dlog_header_t));
+            actual = DLOG_MIN_RECORD + hdr->datalen;
+        }
 
-    return status;
+        *_actual = actual;
+        rdr->tail = rtail + fifolen;
+        return MX_OK;
+    }
 }
 
 void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie) {
@@ -204,13 +497,8 @@ void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie) {
     mutex_acquire(&log->readers_lock);
     list_add_tail(&log->readers, &rdr->node);
 
-    bool do_notify = false;
-
-    spin_lock_saved_state_t state;
-    spin_lock_irqsave(&log->lock, state);
-    rdr->tail = log->tail;
-    do_notify = (log->tail != log->head);
-    spin_unlock_irqrestore(&log->lock, state);
+    rdr->tail = atomic_load_u64(&log->tail);
+    bool do_notify = (rdr->tail != atomic_load_u64(&log->head));
 
     // simulate notify callback for events that arrived
     // before we were initialized
@@ -28,6 +28,12 @@ __BEGIN_CDECLS
 #define DLOG_FLAG_DEVICE    0x0800
 #define DLOG_FLAG_MASK      0x0F00
 
+// kernel-internal: the record payload is a format string pointer plus
+// raw arguments (dlog_deferred_t) rather than text; dlog_read renders
+// it before returning. dlog_write() strips this flag from its callers
+// so userspace can never mark its own records deferred.
+#define DLOG_FLAG_DEFERRED  0x1000
+
 // clang-format on
 
 typedef struct dlog dlog_t;
@@ -36,10 +42,13 @@ typedef struct dlog_record dlog_record_t;
 typedef struct dlog_reader dlog_reader_t;
 
 struct dlog {
+    // serializes writers only; readers validate against |tail| and
+    // retry instead of taking this lock
     spin_lock_t lock;
 
-    size_t head;
-    size_t tail;
+    // free-running ring positions, read by readers with atomics
+    uint64_t head;
+    uint64_t tail;
 
     void* data;
 
@@ -55,7 +64,7 @@ struct dlog_reader {
     struct list_node node;
 
     dlog_t* log;
-    size_t tail;
+    uint64_t tail;
 
     void (*notify)(void* cookie);
     void *cookie;
@@ -88,11 +97,28 @@ struct dlog_record {
 static_assert(sizeof(dlog_header_t) == DLOG_MIN_RECORD, "");
 static_assert(sizeof(dlog_record_t) == DLOG_MAX_RECORD, "");
 
+// payload of a DLOG_FLAG_DEFERRED record; datalen encodes how many
+// of the argument slots are present
+#define DLOG_DEFERRED_MAX_ARGS 6u
+
+typedef struct dlog_deferred {
+    const char* fmt;
+    uint64_t args[DLOG_DEFERRED_MAX_ARGS];
+} dlog_deferred_t;
+
 void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie);
 void dlog_reader_destroy(dlog_reader_t* rdr);
 status_t dlog_write(uint32_t flags, const void* ptr, size_t len);
 status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, size_t* actual);
 
+// Log without formatting: the format string pointer and raw arguments
+// are stored in the ring and rendered at read time, so the in-path cost
+// is a format scan and a few stores. The format string and any %s
+// arguments must be permanent (string literals and other kernel rodata;
+// never stack or heap strings). Floating point and %n are not
+// supported; a format that cannot be deferred is formatted immediately.
+status_t dlog_write_deferred(uint32_t flags, const char* fmt, ...) __PRINTFLIKE(2, 3);
+
 // bluescreen_init should be called at the "start" of a fatal fault or
 // panic to ensure that the fault output (via kernel printf/dprintf)
 // is captured or displayed to the user
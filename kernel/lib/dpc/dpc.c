@@ -9,15 +9,61 @@
 #include <assert.h>
 #include <err.h>
 #include <list.h>
+#include <stdio.h>
 #include <trace.h>
 
+#include <arch/ops.h>
 #include <kernel/event.h>
+#include <kernel/mp.h>
 #include <kernel/spinlock.h>
 #include <lk/init.h>
 
+// Deferred procedure calls run on a small per-cpu worker pool with two
+// lanes per cpu: a high priority lane for completion-critical work
+// (driver irq completions and the like) and a low priority lane for bulk
+// cleanup such as the handle reaper.  Each lane has a dedicated pinned
+// worker thread, so a slow low-lane dpc never delays high-lane work, and
+// workers steal from other cpus' lanes so a backlog behind a slow dpc on
+// one cpu drains through the rest of the pool.
+
+#define DPC_LANE_HIGH 0
+#define DPC_LANE_LOW 1
+#define DPC_NUM_LANES 2
+
+struct dpc_lane {
+    struct list_node list;
+    event_t event;
+};
+
+/* aligned so that one cpu's lanes do not share cache lines with its
+ * neighbor's */
+struct dpc_percpu {
+    struct dpc_lane lane[DPC_NUM_LANES];
+} __CPU_MAX_ALIGN;
+
 static spin_lock_t dpc_lock = SPIN_LOCK_INITIAL_VALUE;
-static struct list_node dpc_list = LIST_INITIAL_VALUE(dpc_list);
-static event_t dpc_event = EVENT_INITIAL_VALUE(dpc_event, false, 0);
+static struct dpc_percpu dpc_percpu[SMP_MAX_CPUS];
+
+static inline uint dpc_lane_num(const dpc_t *dpc)
+{
+    return (dpc->flags & DPC_FLAG_LOW_PRIORITY) ? DPC_LANE_LOW : DPC_LANE_HIGH;
+}
+
+// with dpc_lock held, pick a lane of another cpu to help drain a backlog
+static struct dpc_lane *dpc_helper_lane(uint lane_num, uint cpu)
+{
+    mp_cpu_mask_t online = mp_get_online_mask() & ~(1u << cpu);
+    if (online == 0)
+        return NULL;
+
+    // wake the next online cpu's worker, round robin from ours
+    for (uint i = 1; i < SMP_MAX_CPUS; i++) {
+        uint target = (cpu + i) % SMP_MAX_CPUS;
+        if (online & (1u << target))
+            return &dpc_percpu[target].lane[lane_num];
+    }
+    return NULL;
+}
 
 status_t dpc_queue(dpc_t *dpc, bool reschedule)
 {
@@ -30,9 +76,20 @@ status_t dpc_queue(dpc_t *dpc, bool reschedule)
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&dpc_lock, state);
 
-    // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&dpc_list, &dpc->node);
-    event_signal(&dpc_event, false);
+    uint cpu = arch_curr_cpu_num();
+    uint lane_num = dpc_lane_num(dpc);
+    struct dpc_lane *lane = &dpc_percpu[cpu].lane[lane_num];
+
+    // put the dpc at the tail of our lane and signal the worker;
+    // if there's already a backlog, wake another cpu's worker to steal
+    bool backlog = !list_is_empty(&lane->list);
+    list_add_tail(&lane->list, &dpc->node);
+    event_signal(&lane->event, false);
+    if (backlog) {
+        struct dpc_lane *helper = dpc_helper_lane(lane_num, cpu);
+        if (helper)
+            event_signal(&helper->event, false);
+    }
 
     spin_unlock_irqrestore(&dpc_lock, state);
 
@@ -54,9 +111,18 @@ status_t dpc_queue_thread_locked(dpc_t *dpc)
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&dpc_lock, state);
 
-    // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&dpc_list, &dpc->node);
-    event_signal_thread_locked(&dpc_event);
+    uint cpu = arch_curr_cpu_num();
+    uint lane_num = dpc_lane_num(dpc);
+    struct dpc_lane *lane = &dpc_percpu[cpu].lane[lane_num];
+
+    bool backlog = !list_is_empty(&lane->list);
+    list_add_tail(&lane->list, &dpc->node);
+    event_signal_thread_locked(&lane->event);
+    if (backlog) {
+        struct dpc_lane *helper = dpc_helper_lane(lane_num, cpu);
+        if (helper)
+            event_signal_thread_locked(&helper->event);
+    }
 
     spin_unlock_irqrestore(&dpc_lock, state);
 
@@ -81,22 +147,43 @@ bool dpc_cancel(dpc_t *dpc)
     return callback_not_running;
 }
 
+// with dpc_lock held, steal the oldest dpc from another cpu's lane
+static dpc_t *dpc_steal(uint lane_num, uint cpu)
+{
+    for (uint i = 1; i < SMP_MAX_CPUS; i++) {
+        uint target = (cpu + i) % SMP_MAX_CPUS;
+        dpc_t *dpc = list_remove_head_type(&dpc_percpu[target].lane[lane_num].list,
+                                           dpc_t, node);
+        if (dpc)
+            return dpc;
+    }
+    return NULL;
+}
+
 static int dpc_thread(void *arg)
 {
+    uint num = (uint)(uintptr_t)arg;
+    uint cpu = num / DPC_NUM_LANES;
+    uint lane_num = num % DPC_NUM_LANES;
+    struct dpc_lane *lane = &dpc_percpu[cpu].lane[lane_num];
+
     for (;;) {
         // wait for a dpc to fire
-        __UNUSED status_t err = event_wait(&dpc_event);
+        __UNUSED status_t err = event_wait(&lane->event);
         DEBUG_ASSERT(err == MX_OK);
 
         spin_lock_saved_state_t state;
         spin_lock_irqsave(&dpc_lock, state);
 
-        // pop a dpc off the list
-        dpc_t *dpc = list_remove_head_type(&dpc_list, dpc_t, node);
+        // pop a dpc off our lane, or steal from another cpu's
+        dpc_t *dpc = list_remove_head_type(&lane->list, dpc_t, node);
+        if (!dpc)
+            dpc = dpc_steal(lane_num, cpu);
 
-        // if the list is now empty, unsignal the event so we block until it is
+        // if there is nothing to run anywhere, unsignal the event so we
+        // block until more work is queued
         if (!dpc)
-            event_unsignal(&dpc_event);
+            event_unsignal(&lane->event);
 
         spin_unlock_irqrestore(&dpc_lock, state);
 
@@ -105,14 +192,29 @@ static int dpc_thread(void *arg)
             dpc->func(dpc);
     }
 
-
     return 0;
 }
 
 static void dpc_init(unsigned int level)
 {
-    thread_t *t = thread_create("dpc", &dpc_thread, NULL, DPC_THREAD_PRIORITY, DEFAULT_STACK_SIZE);
-    thread_detach_and_resume(t);
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        for (uint lane_num = 0; lane_num < DPC_NUM_LANES; lane_num++) {
+            struct dpc_lane *lane = &dpc_percpu[cpu].lane[lane_num];
+            list_initialize(&lane->list);
+            event_init(&lane->event, false, 0);
+
+            char name[16];
+            snprintf(name, sizeof(name), "%s:%u",
+                     (lane_num == DPC_LANE_LOW) ? "dpc-low" : "dpc", cpu);
+            int priority = (lane_num == DPC_LANE_LOW) ? DPC_LOW_THREAD_PRIORITY
+                                                      : DPC_THREAD_PRIORITY;
+            thread_t *t = thread_create(name, &dpc_thread,
+                                        (void *)(uintptr_t)(cpu * DPC_NUM_LANES + lane_num),
+                                        priority, DEFAULT_STACK_SIZE);
+            thread_set_pinned_cpu(t, (int)cpu);
+            thread_detach_and_resume(t);
+        }
+    }
 }
 
 LK_INIT_HOOK(dpc, dpc_init, LK_INIT_LEVEL_THREADING);
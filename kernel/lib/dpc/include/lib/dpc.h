@@ -12,6 +12,11 @@
 __BEGIN_CDECLS
 
 #define DPC_THREAD_PRIORITY HIGH_PRIORITY
+#define DPC_LOW_THREAD_PRIORITY DEFAULT_PRIORITY
+
+/* run on the low priority lane; for bulk work (e.g. reaping, freeing)
+ * that must never delay completion-critical dpcs */
+#define DPC_FLAG_LOW_PRIORITY (1u)
 
 struct dpc;
 typedef void (*dpc_func_t)(struct dpc *);
@@ -21,6 +26,7 @@ typedef struct dpc {
 
     dpc_func_t func;
     void *arg;
+    uint32_t flags;
 } dpc_t;
 
 #define DPC_INITIAL_VALUE \
@@ -28,10 +34,12 @@ typedef struct dpc {
     .node = LIST_INITIAL_CLEARED_VALUE, \
     .func = 0, \
     .arg = 0, \
+    .flags = 0, \
 }
 
 /* queue an already filled out dpc, optionally reschedule immediately to run the dpc thread */
-/* the deferred procedure runs in a dedicated thread that runs at DPC_THREAD_PRIORITY */
+/* the deferred procedure runs on a per-cpu worker at DPC_THREAD_PRIORITY, or at */
+/* DPC_LOW_THREAD_PRIORITY if the dpc has DPC_FLAG_LOW_PRIORITY set */
 status_t dpc_queue(dpc_t *dpc, bool reschedule);
 
 /* queue a dpc, but must be holding the thread lock */
@@ -130,7 +130,9 @@ static bool gfxconsole_putc(char c)
         // clear the bottom line
         gfx_fillrect(gfxconsole.surface, 0, gfxconsole.surface->height - FONT_Y - gfxconsole.extray,
                      gfxconsole.surface->width, FONT_Y, gfxconsole.back_color);
-        gfx_flush(gfxconsole.surface);
+        if (gfxconsole.surface == gfxconsole.hw_surface) {
+            gfx_flush_dirty(gfxconsole.surface);
+        }
         inval = 1;
     }
     return inval;
@@ -138,27 +140,26 @@ static bool gfxconsole_putc(char c)
 
 static void gfxconsole_print_callback(print_callback_t *cb, const char *str, size_t len)
 {
-    int refresh_full_screen = 0;
     for (size_t i = 0; i < len; i++) {
         if (str[i] == '\n')
             gfxconsole_putc('\r');
-        refresh_full_screen |= gfxconsole_putc(str[i]);
+        gfxconsole_putc(str[i]);
     }
 
     // blit from the software surface to the hardware
     if (gfxconsole.surface != gfxconsole.hw_surface) {
-        if (refresh_full_screen) {
-            gfx_surface_blend(gfxconsole.hw_surface, gfxconsole.surface, 0, 0);
-        } else {
-            // Only re-blit the active console line.
+        uint y0, y1;
+        if (gfx_get_dirty_rows(gfxconsole.surface, &y0, &y1)) {
+            // Only re-blit the rows drawn since the last blit.
             // Since blend only works in whole surfaces, configure a sub-surface
-            // to use as the blend source.
+            // covering the dirty rows to use as the blend source.
             gfxconsole.line.ptr = ((uint8_t*) gfxconsole.surface->ptr) +
-                (gfxconsole.y * gfxconsole.linestride);
-            gfx_surface_blend(gfxconsole.hw_surface, &gfxconsole.line,
-                0, gfxconsole.y * FONT_Y);
+                (y0 * gfxconsole.linestride);
+            gfxconsole.line.height = y1 - y0 + 1;
+            gfx_surface_blend(gfxconsole.hw_surface, &gfxconsole.line, 0, y0);
+            gfx_clear_dirty(gfxconsole.surface);
+            gfx_flush_dirty(gfxconsole.hw_surface);
         }
-        gfx_flush(gfxconsole.hw_surface);
     }
 }
 
@@ -174,10 +175,9 @@ static void gfxconsole_setup(gfx_surface *surface, gfx_surface *hw_surface)
     gfxconsole.surface = surface;
     gfxconsole.hw_surface = hw_surface;
 
-    // set up line-height sub-surface, for line-only invalidation
+    // set up a sub-surface used to blit only the dirty rows
     memcpy(&gfxconsole.line, surface, sizeof(*surface));
-    gfxconsole.line.height = FONT_Y;
-    gfxconsole.linestride = surface->stride * surface->pixelsize * FONT_Y;
+    gfxconsole.linestride = surface->stride * surface->pixelsize;
 
     // calculate how many rows/columns we have
     gfxconsole.rows = surface->height / FONT_Y;
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <err.h>
+#include <arch/ops.h>
 #include <kernel/thread.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
@@ -43,10 +44,18 @@
 
 static_assert(IS_PAGE_ALIGNED(HEAP_GROW_SIZE), "");
 
-// Individual allocations above 4Mbytes are just fetched directly from the
-// block allocator.
+// Buckets are sized for allocations up to 4Mbytes; this also caps how much
+// the heap grows by in one step.
 #define HEAP_ALLOC_VIRTUAL_BITS 22
 
+// Individual allocations above this size get their own page-rounded OS
+// allocation instead of being carved from the shared heap areas. The whole
+// span goes straight back to the PMM when such an allocation is freed, so
+// large short-lived buffers do not inflate the heap's footprint.
+#define HEAP_LARGE_ALLOC_SIZE (64u * 1024)
+
+static_assert(HEAP_LARGE_ALLOC_SIZE <= (1u << HEAP_ALLOC_VIRTUAL_BITS), "");
+
 // When we grow the heap we have to have somewhere in the freelist to put the
 // resulting freelist entry, so the freelist has to have a certain number of
 // buckets.
@@ -86,7 +95,85 @@ struct heap {
 // Heap static vars.
 static struct heap theheap;
 
+// Per-CPU front end cache.  Freed small blocks are parked in per-cpu,
+// per-bucket lists (chained through the first payload word, with the
+// allocation header left intact) and handed back by the next allocation
+// from the same bucket on that cpu, without taking the heap lock.  Only
+// blocks whose size exactly matches their bucket's rounded-up size are
+// cached, so a cache hit always fits the request precisely.
+
+// Buckets 0..39 cover net sizes up to CACHE_MAX_SIZE (checked in
+// cmpct_init).
+#define NUMBER_OF_CACHE_BUCKETS 40
+
+// Largest net allocation size served from the cache.
+#define CACHE_MAX_SIZE 1024u
+
+// Per-bucket depth; keep fewer of the larger blocks around.
+#define CACHE_DEPTH_SMALL 16
+#define CACHE_DEPTH_LARGE 4
+
+struct heap_cache {
+    void *heads[NUMBER_OF_CACHE_BUCKETS];
+    uint8_t counts[NUMBER_OF_CACHE_BUCKETS];
+} __CPU_MAX_ALIGN;
+
+static struct heap_cache heap_cache[SMP_MAX_CPUS];
+
 static ssize_t heap_grow(size_t len, free_t **bucket);
+static void cmpct_free_to_heap(void *payload);
+
+static inline int cache_depth(int bucket)
+{
+    return (bucket < 16) ? CACHE_DEPTH_SMALL : CACHE_DEPTH_LARGE;
+}
+
+// Try to satisfy an allocation from this cpu's cache.  Interrupts are
+// disabled around the list operation so the cpu cannot change under us.
+static void *heap_cache_alloc(int bucket)
+{
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    struct heap_cache *cache = &heap_cache[arch_curr_cpu_num()];
+    void *payload = cache->heads[bucket];
+    if (payload != NULL) {
+        cache->heads[bucket] = *(void **)payload;
+        cache->counts[bucket]--;
+    }
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return payload;
+}
+
+// Try to park a freed block in this cpu's cache; returns false if the
+// bucket is already at depth and the block should go back to the heap.
+static bool heap_cache_free(int bucket, void *payload)
+{
+    bool cached = false;
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    struct heap_cache *cache = &heap_cache[arch_curr_cpu_num()];
+    if (cache->counts[bucket] < cache_depth(bucket)) {
+        *(void **)payload = cache->heads[bucket];
+        cache->heads[bucket] = payload;
+        cache->counts[bucket]++;
+        cached = true;
+    }
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return cached;
+}
+
+// Return everything in this cpu's cache to the heap so that trimming can
+// coalesce the blocks and release pages.
+static void heap_cache_drain_local(void)
+{
+    for (int bucket = 0; bucket < NUMBER_OF_CACHE_BUCKETS; bucket++) {
+        for (;;) {
+            void *payload = heap_cache_alloc(bucket);
+            if (payload == NULL) break;
+            cmpct_free_to_heap(payload);
+        }
+    }
+}
 
 static void lock(void) TA_ACQ(theheap.lock)
 {
@@ -677,6 +764,10 @@ static void *large_alloc(size_t size)
 
 void cmpct_trim(void)
 {
+    // Give the blocks parked in this cpu's cache back first, so their pages
+    // are candidates for trimming too.
+    heap_cache_drain_local();
+
     // Look at free list entries that are at least as large as one page plus a
     // header. They might be at the start or the end of a block, so we can trim
     // them and free the page(s).
@@ -751,11 +842,24 @@ void *cmpct_alloc(size_t size)
 {
     if (size == 0u) return NULL;
 
-    if (size + sizeof(header_t) > (1u << HEAP_ALLOC_VIRTUAL_BITS)) return large_alloc(size);
+    if (size + sizeof(header_t) > HEAP_LARGE_ALLOC_SIZE) return large_alloc(size);
 
     size_t rounded_up;
     int start_bucket = size_to_index_allocating(size, &rounded_up);
 
+    // Fast path: reuse a block parked in this cpu's cache.  All requests in
+    // a bucket round up to the same size, so the block fits exactly.
+    if (start_bucket < NUMBER_OF_CACHE_BUCKETS) {
+        void *result = heap_cache_alloc(start_bucket);
+        if (result != NULL) {
+#ifdef CMPCT_DEBUG
+            memset(result, ALLOC_FILL, size);
+            memset((char *)result + size, PADDING_FILL, rounded_up - size);
+#endif
+            return result;
+        }
+    }
+
     rounded_up += sizeof(header_t);
 
     lock();
@@ -836,6 +940,29 @@ void cmpct_free(void *payload)
     if (payload == NULL) return;
     header_t *header = (header_t *)payload - 1;
     DEBUG_ASSERT(!is_tagged_as_free(header));  // Double free!
+
+    // Park exactly-sized small blocks in this cpu's cache.  Blocks that
+    // kept extra slop when they were carved (rounded_up mismatch) go back
+    // to the heap so cache hits never return an oversized block.
+    size_t net_size = header->size - sizeof(header_t);
+    if (net_size <= CACHE_MAX_SIZE) {
+        size_t rounded_up;
+        int bucket = size_to_index_allocating(net_size, &rounded_up);
+        DEBUG_ASSERT(bucket < NUMBER_OF_CACHE_BUCKETS);
+        if (rounded_up == net_size && heap_cache_free(bucket, payload)) {
+#ifdef CMPCT_DEBUG
+            memset((void **)payload + 1, FREE_FILL, net_size - sizeof(void *));
+#endif
+            return;
+        }
+    }
+
+    cmpct_free_to_heap(payload);
+}
+
+static void cmpct_free_to_heap(void *payload)
+{
+    header_t *header = (header_t *)payload - 1;
     size_t size = header->size;
     lock();
     header_t *left = header->left;
@@ -930,6 +1057,12 @@ void cmpct_init(void)
         theheap.free_list_bits[i] = 0;
     }
 
+    // The per-cpu caches start empty.
+    memset(heap_cache, 0, sizeof(heap_cache));
+    size_t cache_max_rounded;
+    ASSERT(size_to_index_allocating(CACHE_MAX_SIZE, &cache_max_rounded) ==
+           NUMBER_OF_CACHE_BUCKETS - 1);
+
     size_t initial_alloc = HEAP_GROW_SIZE - 2 * sizeof(header_t);
 
     theheap.remaining = 0;
@@ -114,6 +114,37 @@ status_t GuestPhysicalAddressSpace::UnmapRange(vaddr_t guest_paddr, size_t size)
     return paspace_->RootVmar()->Unmap(guest_paddr, size);
 }
 
+status_t GuestPhysicalAddressSpace::CommitRange(vaddr_t guest_paddr, size_t size) {
+    if (!IS_PAGE_ALIGNED(guest_paddr) || !IS_PAGE_ALIGNED(size) || size == 0)
+        return MX_ERR_INVALID_ARGS;
+    if (guest_paddr + size < guest_paddr || guest_paddr + size > guest_phys_mem_->size())
+        return MX_ERR_OUT_OF_RANGE;
+
+    // The range may span multiple mappings if pages have been carved out of
+    // the guest physical space (e.g. for the IO APIC), so walk it mapping by
+    // mapping. VmMapping::MapRange commits the backing pages and hands
+    // physically contiguous runs to the arch mmu in single calls, which is
+    // what allows 2MB EPT entries when the alignment works out.
+    vaddr_t addr = guest_paddr;
+    while (addr < guest_paddr + size) {
+        mxtl::RefPtr<VmAddressRegionOrMapping> region = paspace_->RootVmar()->FindRegion(addr);
+        if (!region)
+            return MX_ERR_NOT_FOUND;
+        mxtl::RefPtr<VmMapping> mapping = region->as_vm_mapping();
+        if (!mapping)
+            return MX_ERR_NOT_FOUND;
+
+        size_t chunk = mapping->base() + mapping->size() - addr;
+        if (chunk > guest_paddr + size - addr)
+            chunk = guest_paddr + size - addr;
+        status_t result = mapping->MapRange(addr - mapping->base(), chunk, true);
+        if (result != MX_OK)
+            return result;
+        addr += chunk;
+    }
+    return MX_OK;
+}
+
 status_t GuestPhysicalAddressSpace::GetPage(vaddr_t guest_paddr, paddr_t* host_paddr) {
     // Locate the VMO for the guest physical address (if present).
     AspaceVmoLocator vmo_locator(guest_paddr);
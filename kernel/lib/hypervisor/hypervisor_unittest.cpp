@@ -188,6 +188,38 @@ static bool guest_physical_address_space_get_page_complex(void* context) {
     END_TEST;
 }
 
+static bool guest_physical_address_space_commit_range(void* context) {
+    BEGIN_TEST;
+
+    // Setup. Note setup_vmo() commits the VMO itself; CommitRange() must
+    // additionally install the translations, making GetPage() succeed
+    // without ever taking a page fault.
+    mxtl::RefPtr<VmObject> vmo;
+    status_t status = setup_vmo(4 * PAGE_SIZE, &vmo);
+    EXPECT_EQ(MX_OK, status, "Failed to setup vmo.\n");
+    mxtl::unique_ptr<GuestPhysicalAddressSpace> gpas;
+    status = GuestPhysicalAddressSpace::Create(vmo, &gpas);
+    EXPECT_EQ(MX_OK, status, "Failed to create GuestPhysicalAddressSpace.\n");
+
+    // Commit and map the whole range up front.
+    status = gpas->CommitRange(0, 4 * PAGE_SIZE);
+    EXPECT_EQ(MX_OK, status, "Failed to commit GuestPhysicalAddressSpace range.\n");
+
+    paddr_t gpas_paddr = 0;
+    status = gpas->GetPage(3 * PAGE_SIZE, &gpas_paddr);
+    EXPECT_EQ(MX_OK, status, "Failed to read page from GuestPhysicalAddressSpace.\n");
+    EXPECT_NEQ(0u, gpas_paddr, "Failed to read page from GuestPhysicalAddressSpace.\n");
+
+    // Ranges outside the guest physical memory are rejected.
+    status = gpas->CommitRange(4 * PAGE_SIZE, PAGE_SIZE);
+    EXPECT_EQ(
+        MX_ERR_OUT_OF_RANGE,
+        status,
+        "CommitRange returning unexpected value for out of range address.\n");
+
+    END_TEST;
+}
+
 #if ARCH_X86_64
 static bool guest_physical_address_space_map_apic_page(void* context) {
     BEGIN_TEST;
@@ -227,6 +259,7 @@ HYPERVISOR_UNITTEST(guest_physical_address_space_unmap_range)
 HYPERVISOR_UNITTEST(guest_physical_address_space_get_page)
 HYPERVISOR_UNITTEST(guest_physical_address_space_get_page_complex)
 HYPERVISOR_UNITTEST(guest_physical_address_space_get_page_not_present)
+HYPERVISOR_UNITTEST(guest_physical_address_space_commit_range)
 #if ARCH_X86_64
 HYPERVISOR_UNITTEST(guest_physical_address_space_map_apic_page)
 #endif // ARCH_X86_64
@@ -27,6 +27,11 @@ public:
     status_t UnmapRange(vaddr_t guest_paddr, size_t size);
     status_t GetPage(vaddr_t guest_paddr, paddr_t* host_paddr);
 
+    // Commits and maps the given range of guest physical memory up front,
+    // rather than letting it fault in page by page. Whole runs are handed to
+    // the arch mmu, so suitably aligned chunks are installed as large pages.
+    status_t CommitRange(vaddr_t guest_paddr, size_t size);
+
 private:
     mxtl::RefPtr<VmAspace> paspace_;
     mxtl::RefPtr<VmObject> guest_phys_mem_;
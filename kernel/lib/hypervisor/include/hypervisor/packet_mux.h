@@ -9,6 +9,8 @@
 #include <mxtl/intrusive_wavl_tree.h>
 #include <mxtl/ref_ptr.h>
 
+#include <magenta/syscalls/hypervisor.h>
+
 #if WITH_LIB_MAGENTA
 #include <magenta/fifo_dispatcher.h>
 #else
@@ -19,8 +21,6 @@
 class FifoDispatcher : public mxtl::RefCounted<FifoDispatcher> {};
 #endif // WITH_LIB_MAGENTA
 
-typedef struct mx_guest_packet mx_guest_packet_t;
-
 /* Reloads the hypervisor state. */
 struct StateReloader {
     virtual void Reload() = 0;
@@ -42,15 +42,22 @@ private:
         bool InRange(mx_vaddr_t val) const { return val >= addr_ && val < addr_ + len_; }
         mxtl::RefPtr<FifoDispatcher> fifo() const { return fifo_; }
 
+        // Doorbell coalescing, guarded by the mux mutex. A packet identical
+        // to the last one queued, while that one is still unread, carries no
+        // new information and may be dropped.
+        bool Coalesces(const mx_guest_packet_t& packet) const;
+        void SetLastPacket(const mx_guest_packet_t& packet) const;
+
     private:
         mx_vaddr_t addr_;
         size_t len_;
         mxtl::RefPtr<FifoDispatcher> fifo_;
+
+        mutable bool last_packet_valid_ = false;
+        mutable mx_guest_packet_t last_packet_ = {};
     };
     using FifoTree = mxtl::WAVLTree<mx_vaddr_t, mxtl::unique_ptr<FifoRegion>>;
 
     mutable mxtl::Mutex mutex;
     FifoTree fifos TA_GUARDED(mutex);
-
-    status_t FindFifo(mx_vaddr_t addr, mxtl::RefPtr<FifoDispatcher>* fifo) const;
 };
@@ -26,6 +26,8 @@ public:
         return status;
     }
 
+    mx_signals_t watched_signals() const override { return watched_signals_; }
+
 private:
     mx_signals_t watched_signals_;
     event_t event_;
@@ -73,27 +75,42 @@ status_t PacketMux::AddFifo(mx_vaddr_t addr, size_t len, mxtl::RefPtr<FifoDispat
 #endif // WITH_LIB_MAGENTA
 }
 
-status_t PacketMux::FindFifo(mx_vaddr_t addr, mxtl::RefPtr<FifoDispatcher>* fifo) const {
-    FifoTree::const_iterator iter;
-    {
-        AutoLock lock(&mutex);
-        iter = fifos.upper_bound(addr);
-    }
-    --iter;
-    if (!iter.IsValid() || !iter->InRange(addr))
-        return MX_ERR_NOT_FOUND;
-    *fifo = iter->fifo();
-    return MX_OK;
+bool PacketMux::FifoRegion::Coalesces(const mx_guest_packet_t& packet) const {
+#if WITH_LIB_MAGENTA
+    // Packets are zero-initialized before being filled in, so comparing the
+    // raw bytes is exact. If the previous identical packet has not been read
+    // yet, the VMM will observe everything this doorbell advertises when it
+    // handles that one; a duplicate would only burn a ring slot and a wakeup.
+    return last_packet_valid_ &&
+           memcmp(&last_packet_, &packet, sizeof(packet)) == 0 &&
+           fifo_->OutstandingWrites() != 0u;
+#else
+    return false;
+#endif // WITH_LIB_MAGENTA
+}
+
+void PacketMux::FifoRegion::SetLastPacket(const mx_guest_packet_t& packet) const {
+    last_packet_ = packet;
+    last_packet_valid_ = true;
 }
 
 status_t PacketMux::Write(mx_vaddr_t addr, const mx_guest_packet_t& packet,
                           StateReloader* reloader) const {
 #if WITH_LIB_MAGENTA
     mxtl::RefPtr<FifoDispatcher> fifo;
-    status_t status = FindFifo(addr, &fifo);
-    if (status != MX_OK)
-        return status;
-    status = packet_wait(fifo->get_state_tracker(), MX_FIFO_WRITABLE, reloader);
+    const FifoRegion* region;
+    {
+        AutoLock lock(&mutex);
+        FifoTree::const_iterator iter = fifos.upper_bound(addr);
+        --iter;
+        if (!iter.IsValid() || !iter->InRange(addr))
+            return MX_ERR_NOT_FOUND;
+        region = &*iter;
+        if (region->Coalesces(packet))
+            return MX_OK;
+        fifo = region->fifo();
+    }
+    status_t status = packet_wait(fifo->get_state_tracker(), MX_FIFO_WRITABLE, reloader);
     if (status != MX_OK)
         return status;
     const uint8_t* data = reinterpret_cast<const uint8_t*>(&packet);
@@ -101,7 +118,15 @@ status_t PacketMux::Write(mx_vaddr_t addr, const mx_guest_packet_t& packet,
     status = fifo->Write(data, sizeof(mx_guest_packet_t), &actual);
     if (status != MX_OK)
         return status;
-    return actual != 1 ? MX_ERR_IO_DATA_INTEGRITY : MX_OK;
+    if (actual != 1)
+        return MX_ERR_IO_DATA_INTEGRITY;
+    {
+        // Regions are never removed from the tree, so the pointer remains
+        // valid across the unlocked fifo write.
+        AutoLock lock(&mutex);
+        region->SetLastPacket(packet);
+    }
+    return MX_OK;
 #else
     return MX_ERR_NOT_FOUND;
 #endif // WITH_LIB_MAGENTA
@@ -82,59 +82,98 @@ static void ktrace_report_probes(void) {
     mutex_release(&probe_list_lock);
 }
 
-typedef struct ktrace_state {
-    // where the next record will be written
+// Each cpu reserves space in its own shard of the trace buffer, so the
+// hot reservation cursor never bounces between cores.
+typedef struct ktrace_shard {
+    // where the next record will be written, relative to buffer
     int offset;
 
-    // mask of groups we allow, 0 == tracing disabled
-    int grpmask;
-
-    // total size of the trace buffer
-    uint32_t bufsize;
-
     // offset where tracing was stopped, 0 if tracing active
     uint32_t marker;
 
-    // raw trace buffer
+    // usable size of this shard's slice
+    uint32_t bufsize;
+
+    // this shard's slice of the raw trace buffer
     uint8_t* buffer;
+} __CPU_MAX_ALIGN ktrace_shard_t;
+
+typedef struct ktrace_state {
+    // mask of groups we allow, 0 == tracing disabled
+    int grpmask;
+
+    // per-cpu buffer shards
+    ktrace_shard_t shards[SMP_MAX_CPUS];
 } ktrace_state_t;
 
 static ktrace_state_t KTRACE_STATE;
 
+// Reserve len bytes in the calling cpu's shard, or return nullptr and
+// stop tracing if the shard is full.  The add is atomic, so a thread
+// migrating between reading its cpu number and reserving merely touches
+// another cpu's cursor once; the record is still written safely.
+static void* ktrace_reserve(uint32_t len) {
+    ktrace_state_t* ks = &KTRACE_STATE;
+    ktrace_shard_t* shard = &ks->shards[arch_curr_cpu_num()];
+    int off;
+    if ((off = atomic_add(&shard->offset, len)) >= (int)shard->bufsize) {
+        // if we arrive at the end, stop
+        atomic_store(&ks->grpmask, 0);
+        return nullptr;
+    }
+    return shard->buffer + off;
+}
+
+// bytes of shard that hold valid records
+static uint32_t ktrace_shard_used(const ktrace_shard_t* shard) {
+    // Size is limited by the marker if set, otherwise limited by offset
+    // (last written point).  Offset can end up pointing past the end, so
+    // clip it to the actual buffer size to be safe.
+    if (shard->marker) {
+        return shard->marker;
+    }
+    uint32_t max = shard->offset;
+    if (max > shard->bufsize) {
+        max = shard->bufsize;
+    }
+    return max;
+}
+
 int ktrace_read_user(void* ptr, uint32_t off, uint32_t len) {
     ktrace_state_t* ks = &KTRACE_STATE;
 
-    // Buffer size is limited by the marker if set,
-    // otherwise limited by offset (last written point).
-    // Offset can end up pointing past the end, so clip
-    // it to the actual buffer size to be safe.
-    uint32_t max;
-    if (ks->marker) {
-        max = ks->marker;
-    } else {
-        max = ks->offset;
-        if (max > ks->bufsize) {
-            max = ks->bufsize;
-        }
+    // The shards are presented to the reader as one concatenated stream,
+    // in cpu order.  Records carry timestamps, so consumers can interleave
+    // the per-cpu sections.
+    uint32_t total = 0;
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        total += ktrace_shard_used(&ks->shards[i]);
     }
 
     // null read is a query for trace buffer size
     if (ptr == nullptr) {
-        return max;
+        return total;
     }
 
-    // constrain read to available buffer
-    if (off >= max) {
-        return 0;
-    }
-    if (len > (max - off)) {
-        len = max - off;
-    }
-
-    if (arch_copy_to_user(ptr, ks->buffer + off, len) != MX_OK) {
-        return MX_ERR_INVALID_ARGS;
+    uint32_t done = 0;
+    for (uint i = 0; (i < SMP_MAX_CPUS) && (len > 0); i++) {
+        uint32_t used = ktrace_shard_used(&ks->shards[i]);
+        if (off >= used) {
+            off -= used;
+            continue;
+        }
+        uint32_t chunk = used - off;
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (arch_copy_to_user((char*)ptr + done, ks->shards[i].buffer + off, chunk) != MX_OK) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        done += chunk;
+        len -= chunk;
+        off = 0;
     }
-    return len;
+    return done;
 }
 
 status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
@@ -142,24 +181,32 @@ status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
     switch (action) {
     case KTRACE_ACTION_START:
         options = KTRACE_GRP_TO_MASK(options);
-        ks->marker = 0;
+        for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+            ks->shards[i].marker = 0;
+        }
         atomic_store(&ks->grpmask, options ? options : KTRACE_GRP_TO_MASK(KTRACE_GRP_ALL));
         ktrace_report_live_processes();
         ktrace_report_live_threads();
         break;
     case KTRACE_ACTION_STOP: {
         atomic_store(&ks->grpmask, 0);
-        uint32_t n = ks->offset;
-        if (n > ks->bufsize) {
-            ks->marker = ks->bufsize;
-        } else {
-            ks->marker = n;
+        for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+            ktrace_shard_t* shard = &ks->shards[i];
+            uint32_t n = shard->offset;
+            if (n > shard->bufsize) {
+                shard->marker = shard->bufsize;
+            } else {
+                shard->marker = n;
+            }
         }
         break;
     }
     case KTRACE_ACTION_REWIND:
-        // roll back to just after the metadata
-        atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+        // roll back to just after the metadata in cpu 0's shard
+        atomic_store(&ks->shards[0].offset, KTRACE_RECSIZE * 2);
+        for (uint i = 1; i < SMP_MAX_CPUS; i++) {
+            atomic_store(&ks->shards[i].offset, 0);
+        }
         ktrace_report_syscalls(kt_syscall_info);
         ktrace_report_probes();
         break;
@@ -203,18 +250,24 @@ void ktrace_init(unsigned level) {
     mb *= (1024*1024);
 
     status_t status;
+    uint8_t* buffer;
     VmAspace* aspace = VmAspace::kernel_aspace();
-    if ((status = aspace->Alloc("ktrace", mb, (void**)&ks->buffer, 0, VmAspace::VMM_FLAG_COMMIT,
+    if ((status = aspace->Alloc("ktrace", mb, (void**)&buffer, 0, VmAspace::VMM_FLAG_COMMIT,
                                 ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE)) < 0) {
         dprintf(INFO, "ktrace: cannot alloc buffer %d\n", status);
         return;
     }
 
-    // The last packet written can overhang the end of the buffer,
-    // so we reduce the reported size by the max size of a record
-    ks->bufsize = mb - 256;
+    // carve the buffer into one slice per cpu
+    uint32_t slice = (mb / SMP_MAX_CPUS) & ~7u;
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        ks->shards[i].buffer = buffer + (i * slice);
+        // The last packet written can overhang the end of the slice,
+        // so we reduce the usable size by the max size of a record
+        ks->shards[i].bufsize = slice - 256;
+    }
 
-    dprintf(INFO, "ktrace: buffer at %p (%u bytes)\n", ks->buffer, mb);
+    dprintf(INFO, "ktrace: buffer at %p (%u bytes, %u per cpu)\n", buffer, mb, slice);
 
     // register all static probes
     ktrace_probe_info_t *probe;
@@ -224,9 +277,9 @@ void ktrace_init(unsigned level) {
     }
     mutex_release(&probe_list_lock);
 
-    // write metadata to the first two event slots
+    // write metadata to the first two event slots of cpu 0's shard
     uint64_t n = ktrace_ticks_per_ms();
-    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->buffer;
+    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->shards[0].buffer;
     rec[0].tag = TAG_VERSION;
     rec[0].a = KTRACE_VERSION;
     rec[1].tag = TAG_TICKS_PER_MS;
@@ -234,7 +287,7 @@ void ktrace_init(unsigned level) {
     rec[1].b = (uint32_t)(n >> 32);
 
     // enable tracing
-    atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+    atomic_store(&ks->shards[0].offset, KTRACE_RECSIZE * 2);
     ktrace_report_syscalls(kt_syscall_info);
     ktrace_report_probes();
     atomic_store(&ks->grpmask, KTRACE_GRP_TO_MASK(grpmask));
@@ -247,12 +300,8 @@ void ktrace_tiny(uint32_t tag, uint32_t arg) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (tag & atomic_load(&ks->grpmask)) {
         tag = (tag & 0xFFFFFFF0) | 2;
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_HDRSIZE)) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
+        ktrace_header_t* hdr = (ktrace_header_t*) ktrace_reserve(KTRACE_HDRSIZE);
+        if (hdr != nullptr) {
             hdr->ts = ktrace_timestamp();
             hdr->tag = tag;
             hdr->tid = arg;
@@ -266,14 +315,11 @@ void* ktrace_open(uint32_t tag) {
         return nullptr;
     }
 
-    int off;
-    if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-        // if we arrive at the end, stop
-        atomic_store(&ks->grpmask, 0);
+    ktrace_header_t* hdr = (ktrace_header_t*) ktrace_reserve(KTRACE_LEN(tag));
+    if (hdr == nullptr) {
         return nullptr;
     }
 
-    ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
     hdr->ts = ktrace_timestamp();
     hdr->tag = tag;
     hdr->tid = (uint32_t)get_current_thread()->user_tid;
@@ -288,12 +334,8 @@ static void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char*
         // set size to: sizeof(hdr) + len + 1, round up to multiple of 8
         tag = (tag & 0xFFFFFFF0) | ((KTRACE_NAMESIZE + len + 1 + 7) >> 3);
 
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_rec_name_t* rec = (ktrace_rec_name_t*) (ks->buffer + off);
+        ktrace_rec_name_t* rec = (ktrace_rec_name_t*) ktrace_reserve(KTRACE_LEN(tag));
+        if (rec != nullptr) {
             rec->tag = tag;
             rec->id = id;
             rec->arg = arg;
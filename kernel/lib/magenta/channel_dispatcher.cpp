@@ -76,7 +76,7 @@ mx_status_t ChannelDispatcher::add_observer(StateObserver* observer) {
 
     AutoLock lock(&lock_);
     StateObserver::CountInfo cinfo =
-        {{{messages_.size_slow(), MX_CHANNEL_READABLE}, {0u, 0u}}};
+        {{{message_count_, MX_CHANNEL_READABLE}, {0u, 0u}}};
     state_tracker_.AddObserver(observer, &cinfo);
     return MX_OK;
 }
@@ -153,6 +153,7 @@ status_t ChannelDispatcher::Read(uint32_t* msg_size,
     }
 
     *msg = messages_.pop_front();
+    message_count_--;
 
     if (messages_.is_empty())
         state_tracker_.UpdateState(MX_CHANNEL_READABLE, 0u);
@@ -276,9 +277,15 @@ int ChannelDispatcher::WriteSelf(mxtl::unique_ptr<MessagePacket> msg) {
             }
         }
     }
+    bool was_empty = messages_.is_empty();
     messages_.push_back(mxtl::move(msg));
+    message_count_++;
 
-    state_tracker_.UpdateState(0u, MX_CHANNEL_READABLE);
+    // Only poke the state tracker on the empty to non-empty transition;
+    // READABLE is already up on a non-empty queue, so signaling again would
+    // just take the tracker lock and walk the observer list for nothing.
+    if (was_empty)
+        state_tracker_.UpdateState(0u, MX_CHANNEL_READABLE);
     return 0;
 }
 
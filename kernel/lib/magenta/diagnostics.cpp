@@ -13,6 +13,7 @@
 #include <kernel/auto_lock.h>
 #include <lib/console.h>
 #include <lib/ktrace.h>
+#include <lib/user_copy/user_batcher.h>
 #include <pretty/sizes.h>
 
 #include <magenta/job_dispatcher.h>
@@ -457,22 +458,22 @@ class VmMapBuilder final : public VmEnumerator {
 public:
     // NOTE: Code outside of the syscall layer should not typically know about
     // user_ptrs; do not use this pattern as an example.
-    VmMapBuilder(user_ptr<mx_info_maps_t> maps, size_t max)
-        : maps_(maps), max_(max) {}
+    // The caller stages an entry for the root VmAspace before enumerating.
+    VmMapBuilder(user_record_batcher<mx_info_maps_t>* batcher)
+        : batcher_(batcher) {}
 
     bool OnVmAddressRegion(const VmAddressRegion* vmar, uint depth) override {
         available_++;
-        if (nelem_ < max_) {
+        if (batcher_->has_room()) {
             mx_info_maps_t entry = {};
             strlcpy(entry.name, vmar->name(), sizeof(entry.name));
             entry.base = vmar->base();
             entry.size = vmar->size();
             entry.depth = depth + 1; // The root aspace is depth 0.
             entry.type = MX_INFO_MAPS_TYPE_VMAR;
-            if (maps_.copy_array_to_user(&entry, 1, nelem_) != MX_OK) {
+            if (!batcher_->Append(entry)) {
                 return false;
             }
-            nelem_++;
         }
         return true;
     }
@@ -480,7 +481,7 @@ public:
     bool OnVmMapping(const VmMapping* map, const VmAddressRegion* vmar,
                      uint depth) override {
         available_++;
-        if (nelem_ < max_) {
+        if (batcher_->has_room()) {
             mx_info_maps_t entry = {};
             auto vmo = map->vmo();
             vmo->get_name(entry.name, sizeof(entry.name));
@@ -494,23 +495,19 @@ public:
             u->vmo_koid = vmo->user_id();
             u->committed_pages = vmo->AllocatedPagesInRange(
                 map->object_offset(), map->size());
-            if (maps_.copy_array_to_user(&entry, 1, nelem_) != MX_OK) {
+            if (!batcher_->Append(entry)) {
                 return false;
             }
-            nelem_++;
         }
         return true;
     }
 
-    size_t nelem() const { return nelem_; }
     size_t available() const { return available_; }
 
 private:
-    // The caller must write an entry for the root VmAspace at index 0.
-    size_t nelem_ = 1;
+    // The root VmAspace entry is counted here but staged by the caller.
     size_t available_ = 1;
-    user_ptr<mx_info_maps_t> maps_;
-    size_t max_;
+    user_record_batcher<mx_info_maps_t>* batcher_;
 };
 } // namespace
 
@@ -525,6 +522,7 @@ status_t GetVmAspaceMaps(mxtl::RefPtr<VmAspace> aspace,
     if (aspace->is_destroyed()) {
         return MX_ERR_BAD_STATE;
     }
+    user_record_batcher<mx_info_maps_t> batcher(maps, max);
     if (max > 0) {
         mx_info_maps_t entry = {};
         strlcpy(entry.name, aspace->name(), sizeof(entry.name));
@@ -532,18 +530,18 @@ status_t GetVmAspaceMaps(mxtl::RefPtr<VmAspace> aspace,
         entry.size = aspace->size();
         entry.depth = 0;
         entry.type = MX_INFO_MAPS_TYPE_ASPACE;
-        if (maps.copy_array_to_user(&entry, 1, 0) != MX_OK) {
+        if (!batcher.Append(entry)) {
             return MX_ERR_INVALID_ARGS;
         }
     }
 
-    VmMapBuilder b(maps, max);
-    if (!aspace->EnumerateChildren(&b)) {
+    VmMapBuilder b(&batcher);
+    if (!aspace->EnumerateChildren(&b) || !batcher.Flush()) {
         // VmMapBuilder only returns false
         // when it can't copy to the user pointer.
         return MX_ERR_INVALID_ARGS;
     }
-    *actual = max > 0 ? b.nelem() : 0;
+    *actual = batcher.written();
     *available = b.available();
     return MX_OK;
 }
@@ -556,6 +554,7 @@ mx_info_vmo_t VmoToInfoEntry(const VmObject* vmo,
     vmo->get_name(entry.name, sizeof(entry.name));
     entry.size_bytes = vmo->size();
     entry.parent_koid = vmo->parent_user_id();
+    entry.clone_chain_depth = vmo->clone_chain_depth();
     entry.num_children = vmo->num_children();
     entry.num_mappings = vmo->num_mappings();
     entry.share_count = vmo->share_count();
@@ -577,35 +576,31 @@ class AspaceVmoEnumerator final : public VmEnumerator {
 public:
     // NOTE: Code outside of the syscall layer should not typically know about
     // user_ptrs; do not use this pattern as an example.
-    AspaceVmoEnumerator(user_ptr<mx_info_vmo_t> vmos, size_t max)
-        : vmos_(vmos), max_(max) {}
+    AspaceVmoEnumerator(user_record_batcher<mx_info_vmo_t>* batcher)
+        : batcher_(batcher) {}
 
     bool OnVmMapping(const VmMapping* map, const VmAddressRegion* vmar,
                      uint depth) override {
         available_++;
-        if (nelem_ < max_) {
+        if (batcher_->has_room()) {
             // We're likely to see the same VMO a couple times in a given
             // address space (e.g., somelib.so mapped as r--, r-x), but leave it
             // to userspace to do deduping.
             mx_info_vmo_t entry = VmoToInfoEntry(map->vmo().get(),
                                                  /*is_handle=*/false,
                                                  /*handle_rights=*/0);
-            if (vmos_.copy_array_to_user(&entry, 1, nelem_) != MX_OK) {
+            if (!batcher_->Append(entry)) {
                 return false;
             }
-            nelem_++;
         }
         return true;
     }
 
-    size_t nelem() const { return nelem_; }
     size_t available() const { return available_; }
 
 private:
-    const user_ptr<mx_info_vmo_t> vmos_;
-    const size_t max_;
+    user_record_batcher<mx_info_vmo_t>* batcher_;
 
-    size_t nelem_ = 0;
     size_t available_ = 0;
 };
 } // namespace
@@ -624,13 +619,14 @@ status_t GetVmAspaceVmos(mxtl::RefPtr<VmAspace> aspace,
         return MX_ERR_BAD_STATE;
     }
 
-    AspaceVmoEnumerator ave(vmos, max);
-    if (!aspace->EnumerateChildren(&ave)) {
+    user_record_batcher<mx_info_vmo_t> batcher(vmos, max);
+    AspaceVmoEnumerator ave(&batcher);
+    if (!aspace->EnumerateChildren(&ave) || !batcher.Flush()) {
         // AspaceVmoEnumerator only returns false
         // when it can't copy to the user pointer.
         return MX_ERR_INVALID_ARGS;
     }
-    *actual = ave.nelem();
+    *actual = batcher.written();
     *available = ave.available();
     return MX_OK;
 }
@@ -643,8 +639,8 @@ status_t GetProcessVmosViaHandles(ProcessDispatcher* process,
     DEBUG_ASSERT(process != nullptr);
     DEBUG_ASSERT(actual_out != nullptr);
     DEBUG_ASSERT(available_out != nullptr);
-    size_t actual = 0;
     size_t available = 0;
+    user_record_batcher<mx_info_vmo_t> batcher(vmos, max);
     // We may see multiple handles to the same VMO, but leave it to userspace to
     // do deduping.
     mx_status_t s = process->ForEachHandle([&](mx_handle_t handle,
@@ -656,21 +652,23 @@ status_t GetProcessVmosViaHandles(ProcessDispatcher* process,
             return MX_OK;
         }
         available++;
-        if (actual < max) {
+        if (batcher.has_room()) {
             mx_info_vmo_t entry = VmoToInfoEntry(vmod->vmo().get(),
                                                  /*is_handle=*/true,
                                                  rights);
-            if (vmos.copy_array_to_user(&entry, 1, actual) != MX_OK) {
+            if (!batcher.Append(entry)) {
                 return MX_ERR_INVALID_ARGS;
             }
-            actual++;
         }
         return MX_OK;
     });
     if (s != MX_OK) {
         return s;
     }
-    *actual_out = actual;
+    if (!batcher.Flush()) {
+        return MX_ERR_INVALID_ARGS;
+    }
+    *actual_out = batcher.written();
     *available_out = available;
     return MX_OK;
 }
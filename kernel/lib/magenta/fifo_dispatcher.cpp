@@ -26,6 +26,8 @@ status_t FifoDispatcher::Create(uint32_t count, uint32_t elemsize, uint32_t opti
         ((count * elemsize) > kMaxSizeBytes)) {
         return MX_ERR_OUT_OF_RANGE;
     }
+    if (options & ~MX_FIFO_SPSC)
+        return MX_ERR_INVALID_ARGS;
     AllocChecker ac;
     auto fifo0 = mxtl::AdoptRef(new (&ac) FifoDispatcher(count, elemsize, options));
     if (!ac.check())
@@ -47,8 +49,9 @@ status_t FifoDispatcher::Create(uint32_t count, uint32_t elemsize, uint32_t opti
     return MX_OK;
 }
 
-FifoDispatcher::FifoDispatcher(uint32_t count, uint32_t elem_size, uint32_t /*options*/)
+FifoDispatcher::FifoDispatcher(uint32_t count, uint32_t elem_size, uint32_t options)
     : elem_count_(count), elem_size_(elem_size), mask_(count - 1),
+      spsc_(options & MX_FIFO_SPSC),
       peer_koid_(0u), state_tracker_(MX_FIFO_WRITABLE),
       head_(0u), tail_(0u) {
 }
@@ -131,6 +134,22 @@ mx_status_t FifoDispatcher::Read(uint8_t* dst, size_t len, uint32_t* actual) {
     return Read(dst, len, actual, copy_to_fn);
 }
 
+uint32_t FifoDispatcher::OutstandingWrites() {
+    canary_.Assert();
+
+    mxtl::RefPtr<FifoDispatcher> other;
+    {
+        AutoLock lock(&lock_);
+        if (!other_)
+            return 0u;
+        other = other_;
+    }
+    // Our writes land in the peer's ring; relaxed loads suffice for an
+    // advisory count.
+    return other->head_.load(mxtl::memory_order_relaxed) -
+           other->tail_.load(mxtl::memory_order_relaxed);
+}
+
 mx_status_t FifoDispatcher::WriteFromUser(const uint8_t* src, size_t len, uint32_t* actual) {
     auto copy_from_fn = [](const uint8_t* src, uint8_t* data, size_t len) -> mx_status_t {
         return make_user_ptr(src).copy_array_from_user(data, len);
@@ -160,6 +179,52 @@ mx_status_t FifoDispatcher::Write(const uint8_t* ptr, size_t len, uint32_t* actu
     return other->WriteSelf(ptr, len, actual, copy_from_fn);
 }
 
+mx_status_t FifoDispatcher::CopyElementsIn(const uint8_t* ptr, size_t count, uint32_t head,
+                                           fifo_copy_from_fn_t copy_from_fn) {
+    while (count > 0) {
+        uint32_t offset = (head & mask_);
+
+        // number of slots from target to end, inclusive
+        uint32_t n = elem_count_ - offset;
+
+        // number of slots we can actually copy
+        size_t to_copy = (count > n) ? n : count;
+
+        mx_status_t status = copy_from_fn(ptr, data_ + offset * elem_size_, to_copy * elem_size_);
+        if (status != MX_OK)
+            return MX_ERR_INVALID_ARGS;
+
+        // due to size limitations on fifo, to_copy will always fit in a u32
+        head += static_cast<uint32_t>(to_copy);
+        count -= to_copy;
+        ptr += to_copy * elem_size_;
+    }
+    return MX_OK;
+}
+
+mx_status_t FifoDispatcher::CopyElementsOut(uint8_t* ptr, size_t count, uint32_t tail,
+                                            fifo_copy_to_fn_t copy_to_fn) {
+    while (count > 0) {
+        uint32_t offset = (tail & mask_);
+
+        // number of slots from target to end, inclusive
+        uint32_t n = elem_count_ - offset;
+
+        // number of slots we can actually copy
+        size_t to_copy = (count > n) ? n : count;
+
+        mx_status_t status = copy_to_fn(ptr, data_ + offset * elem_size_, to_copy * elem_size_);
+        if (status != MX_OK)
+            return MX_ERR_INVALID_ARGS;
+
+        // due to size limitations on fifo, to_copy will always fit in a u32
+        tail += static_cast<uint32_t>(to_copy);
+        count -= to_copy;
+        ptr += to_copy * elem_size_;
+    }
+    return MX_OK;
+}
+
 mx_status_t FifoDispatcher::WriteSelf(const uint8_t* ptr, size_t bytelen, uint32_t* actual,
                                       fifo_copy_from_fn_t copy_from_fn) {
     canary_.Assert();
@@ -168,12 +233,16 @@ mx_status_t FifoDispatcher::WriteSelf(const uint8_t* ptr, size_t bytelen, uint32
     if (count == 0)
         return MX_ERR_OUT_OF_RANGE;
 
+    if (spsc_)
+        return WriteSelfSpsc(ptr, count, actual, copy_from_fn);
+
     AutoLock lock(&lock_);
 
-    uint32_t old_head = head_;
+    uint32_t head = head_.load(mxtl::memory_order_relaxed);
+    uint32_t tail = tail_.load(mxtl::memory_order_relaxed);
 
     // total number of available empty slots in the fifo
-    size_t avail = elem_count_ - (head_ - tail_);
+    size_t avail = elem_count_ - (head - tail);
 
     if (avail == 0)
         return MX_ERR_SHOULD_WAIT;
@@ -183,38 +252,67 @@ mx_status_t FifoDispatcher::WriteSelf(const uint8_t* ptr, size_t bytelen, uint32
     if (count > avail)
         count = avail;
 
-    while (count > 0) {
-        uint32_t offset = (head_ & mask_);
+    mx_status_t status = CopyElementsIn(ptr, count, head, copy_from_fn);
+    if (status != MX_OK)
+        return status;
 
-        // number of slots from target to end, inclusive
-        uint32_t n = elem_count_ - offset;
+    head += static_cast<uint32_t>(count);
+    head_.store(head, mxtl::memory_order_relaxed);
 
-        // number of slots we can actually copy
-        size_t to_copy = (count > n) ? n : count;
+    // if was empty, we've become readable
+    if (was_empty)
+        state_tracker_.UpdateState(0u, MX_FIFO_READABLE);
 
-        mx_status_t status = copy_from_fn(ptr, data_ + offset * elem_size_, to_copy * elem_size_);
-        if (status != MX_OK) {
-            // roll back, in case this is the second copy
-            head_ = old_head;
-            return MX_ERR_INVALID_ARGS;
-        }
+    // if now full, we're no longer writable
+    if (elem_count_ == (head - tail))
+        other_->state_tracker_.UpdateState(MX_FIFO_WRITABLE, 0u);
 
-        // adjust head and count
-        // due to size limitations on fifo, to_copy will always fit in a u32
-        head_ += static_cast<uint32_t>(to_copy);
-        count -= to_copy;
-        ptr += to_copy * elem_size_;
-    }
+    *actual = static_cast<uint32_t>(count);
+    return MX_OK;
+}
+
+mx_status_t FifoDispatcher::WriteSelfSpsc(const uint8_t* ptr, size_t count, uint32_t* actual,
+                                          fifo_copy_from_fn_t copy_from_fn) {
+    canary_.Assert();
+
+    // Only the peer's writer advances |head_|, so a relaxed load sees our
+    // own last store. The acquire on |tail_| pairs with the reader's
+    // release and makes the slots it drained safe to overwrite.
+    uint32_t head = head_.load(mxtl::memory_order_relaxed);
+    uint32_t tail = tail_.load(mxtl::memory_order_acquire);
+
+    size_t avail = elem_count_ - (head - tail);
+
+    if (avail == 0)
+        return MX_ERR_SHOULD_WAIT;
+
+    bool was_empty = (avail == elem_count_);
+
+    if (count > avail)
+        count = avail;
+
+    // No rollback is needed on failure: the new elements only become
+    // visible to the reader once the head is published below.
+    mx_status_t status = CopyElementsIn(ptr, count, head, copy_from_fn);
+    if (status != MX_OK)
+        return status;
+
+    head += static_cast<uint32_t>(count);
+    head_.store(head, mxtl::memory_order_release);
 
     // if was empty, we've become readable
     if (was_empty)
         state_tracker_.UpdateState(0u, MX_FIFO_READABLE);
 
-    // if now full, we're no longer writable
-    if (elem_count_ == (head_ - tail_))
-        other_->state_tracker_.UpdateState(MX_FIFO_WRITABLE, 0u);
+    // if now full, we're no longer writable. This edge is rare, so take
+    // the lock to reach the peer's state tracker safely.
+    if (elem_count_ == (head - tail)) {
+        AutoLock lock(&lock_);
+        if (other_)
+            other_->state_tracker_.UpdateState(MX_FIFO_WRITABLE, 0u);
+    }
 
-    *actual = (head_ - old_head);
+    *actual = static_cast<uint32_t>(count);
     return MX_OK;
 }
 
@@ -226,12 +324,16 @@ mx_status_t FifoDispatcher::Read(uint8_t* ptr, size_t bytelen, uint32_t* actual,
     if (count == 0)
         return MX_ERR_OUT_OF_RANGE;
 
+    if (spsc_)
+        return ReadSpsc(ptr, count, actual, copy_to_fn);
+
     AutoLock lock(&lock_);
 
-    uint32_t old_tail = tail_;
+    uint32_t head = head_.load(mxtl::memory_order_relaxed);
+    uint32_t tail = tail_.load(mxtl::memory_order_relaxed);
 
     // total number of available entries to read from the fifo
-    size_t avail = (head_ - tail_);
+    size_t avail = (head - tail);
 
     if (avail == 0)
         return MX_ERR_SHOULD_WAIT;
@@ -241,38 +343,67 @@ mx_status_t FifoDispatcher::Read(uint8_t* ptr, size_t bytelen, uint32_t* actual,
     if (count > avail)
         count = avail;
 
-    while (count > 0) {
-        uint32_t offset = (tail_ & mask_);
+    mx_status_t status = CopyElementsOut(ptr, count, tail, copy_to_fn);
+    if (status != MX_OK)
+        return status;
 
-        // number of slots from target to end, inclusive
-        uint32_t n = elem_count_ - offset;
+    tail += static_cast<uint32_t>(count);
+    tail_.store(tail, mxtl::memory_order_relaxed);
 
-        // number of slots we can actually copy
-        size_t to_copy = (count > n) ? n : count;
+    // if we were full, we have become writable
+    if (was_full && other_)
+        other_->state_tracker_.UpdateState(0u, MX_FIFO_WRITABLE);
 
-        mx_status_t status = copy_to_fn(ptr, data_ + offset * elem_size_, to_copy * elem_size_);
-        if (status != MX_OK) {
-            // roll back, in case this is the second copy
-            tail_ = old_tail;
-            return MX_ERR_INVALID_ARGS;
-        }
+    // if we've become empty, we're no longer readable
+    if ((head - tail) == 0)
+        state_tracker_.UpdateState(MX_FIFO_READABLE, 0u);
 
-        // adjust tail and count
-        // due to size limitations on fifo, to_copy will always fit in a u32
-        tail_ += static_cast<uint32_t>(to_copy);
-        count -= to_copy;
-        ptr += to_copy * elem_size_;
+    *actual = static_cast<uint32_t>(count);
+    return MX_OK;
+}
 
-    }
+mx_status_t FifoDispatcher::ReadSpsc(uint8_t* ptr, size_t count, uint32_t* actual,
+                                     fifo_copy_to_fn_t copy_to_fn) {
+    canary_.Assert();
 
-    // if we were full, we have become writable
-    if (was_full && other_)
-        other_->state_tracker_.UpdateState(0u, MX_FIFO_WRITABLE);
+    // Only we advance |tail_|, so a relaxed load sees our own last store.
+    // The acquire on |head_| pairs with the writer's release and makes
+    // the elements it published safe to read.
+    uint32_t head = head_.load(mxtl::memory_order_acquire);
+    uint32_t tail = tail_.load(mxtl::memory_order_relaxed);
+
+    // total number of available entries to read from the fifo
+    size_t avail = (head - tail);
+
+    if (avail == 0)
+        return MX_ERR_SHOULD_WAIT;
+
+    bool was_full = (avail == elem_count_);
+
+    if (count > avail)
+        count = avail;
+
+    // No rollback is needed on failure: the slots are only handed back
+    // to the writer once the tail is published below.
+    mx_status_t status = CopyElementsOut(ptr, count, tail, copy_to_fn);
+    if (status != MX_OK)
+        return status;
+
+    tail += static_cast<uint32_t>(count);
+    tail_.store(tail, mxtl::memory_order_release);
+
+    // if we were full, we have become writable. This edge is rare, so
+    // take the lock to reach the peer's state tracker safely.
+    if (was_full) {
+        AutoLock lock(&lock_);
+        if (other_)
+            other_->state_tracker_.UpdateState(0u, MX_FIFO_WRITABLE);
+    }
 
     // if we've become empty, we're no longer readable
-    if ((head_ - tail_) == 0)
+    if ((head - tail) == 0)
         state_tracker_.UpdateState(MX_FIFO_READABLE, 0u);
 
-    *actual = (tail_ - old_tail);
+    *actual = static_cast<uint32_t>(count);
     return MX_OK;
 }
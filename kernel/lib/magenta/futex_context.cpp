@@ -24,7 +24,9 @@ FutexContext::~FutexContext() {
 
     // All of the threads should have removed themselves from wait queues
     // by the time the process has exited.
-    DEBUG_ASSERT(futex_table_.is_empty());
+    for (size_t ix = 0; ix != kNumBuckets; ++ix) {
+        DEBUG_ASSERT(buckets_[ix].futex_table.is_empty());
+    }
 }
 
 status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_time_t deadline) {
@@ -42,16 +44,17 @@ status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_
     // If a FutexWake() operation could occur between them, a userland mutex
     // operation built on top of futexes would have a race condition that
     // could miss wakeups.
-    lock_.Acquire();
+    Bucket& bucket = GetBucket(futex_key);
+    bucket.lock.Acquire();
 
     int value;
     status_t result = value_ptr.copy_from_user(&value);
     if (result != MX_OK) {
-        lock_.Release();
+        bucket.lock.Release();
         return result;
     }
     if (value != current_value) {
-        lock_.Release();
+        bucket.lock.Release();
         return MX_ERR_BAD_STATE;
     }
 
@@ -60,10 +63,11 @@ status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_
     node->set_hash_key(futex_key);
     node->SetAsSingletonList();
 
-    QueueNodesLocked(node);
+    QueueNodesLocked(&bucket, node);
 
-    // Block current thread.  This releases lock_ and does not reacquire it.
-    result = node->BlockThread(&lock_, deadline);
+    // Block current thread.  This releases the bucket lock and does not
+    // reacquire it.
+    result = node->BlockThread(&bucket.lock, deadline);
     if (result == MX_OK) {
         DEBUG_ASSERT(!node->IsInQueue());
         // All the work necessary for removing us from the hash table was done by FutexWake()
@@ -75,10 +79,22 @@ status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_
     // (MX_ERR_INTERNAL_INTR_RETRY).
     //
     // We need to ensure that the thread's node is removed from the wait
-    // queue, because FutexWake() probably didn't do that.
-    AutoLock lock(&lock_);
-    if (UnqueueNodeLocked(node)) {
-        return result;
+    // queue, because FutexWake() probably didn't do that.  The node's key
+    // (and therefore its bucket) may have changed under us if the thread
+    // was requeued by FutexRequeue(), so re-read the key and revalidate it
+    // once the bucket lock is held.
+    for (;;) {
+        uintptr_t unqueue_key = node->GetKey();
+        Bucket& unqueue_bucket = GetBucket(unqueue_key);
+        AutoLock lock(&unqueue_bucket.lock);
+        if (node->GetKey() != unqueue_key) {
+            // Requeued to a different futex while we were acquiring the lock.
+            continue;
+        }
+        if (UnqueueNodeLocked(&unqueue_bucket, node)) {
+            return result;
+        }
+        break;
     }
     // The current thread was not found on the wait queue.  This means
     // that, although we hit the deadline (or were suspended/killed), we
@@ -112,9 +128,10 @@ status_t FutexContext::FutexWake(user_ptr<const int> value_ptr,
     if (futex_key % sizeof(int))
         return MX_ERR_INVALID_ARGS;
 
-    AutoLock lock(&lock_);
+    Bucket& bucket = GetBucket(futex_key);
+    AutoLock lock(&bucket.lock);
 
-    FutexNode* node = futex_table_.erase(futex_key);
+    FutexNode* node = bucket.futex_table.erase(futex_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
         return MX_OK;
@@ -127,7 +144,7 @@ status_t FutexContext::FutexWake(user_ptr<const int> value_ptr,
 
     if (remaining_waiters) {
         DEBUG_ASSERT(remaining_waiters->GetKey() == futex_key);
-        futex_table_.insert(remaining_waiters);
+        bucket.futex_table.insert(remaining_waiters);
     }
 
     if (any_woken) {
@@ -145,8 +162,46 @@ status_t FutexContext::FutexRequeue(user_ptr<int> wake_ptr, uint32_t wake_count,
     if ((requeue_ptr.get() == nullptr) && requeue_count)
         return MX_ERR_INVALID_ARGS;
 
-    AutoLock lock(&lock_);
+    uintptr_t wake_key = reinterpret_cast<uintptr_t>(wake_ptr.get());
+    uintptr_t requeue_key = reinterpret_cast<uintptr_t>(requeue_ptr.get());
+    if (wake_key == requeue_key) return MX_ERR_INVALID_ARGS;
+    if (wake_key % sizeof(int) || requeue_key % sizeof(int))
+        return MX_ERR_INVALID_ARGS;
+
+    Bucket* wake_bucket = &GetBucket(wake_key);
+    Bucket* requeue_bucket = &GetBucket(requeue_key);
 
+    // Acquire both bucket locks, lowest bucket first, so that two requeue
+    // operations over the same pair of buckets cannot deadlock.  The two
+    // keys may well land in the same bucket, in which case there is only
+    // one lock to take.
+    Bucket* first = (wake_bucket < requeue_bucket) ? wake_bucket : requeue_bucket;
+    Bucket* second = (wake_bucket < requeue_bucket) ? requeue_bucket : wake_bucket;
+    first->lock.Acquire();
+    if (second != first)
+        second->lock.Acquire();
+
+    bool any_woken = false;
+    status_t result = FutexRequeueLocked(wake_ptr, wake_count, current_value,
+                                         requeue_ptr, requeue_count,
+                                         wake_bucket, requeue_bucket, &any_woken);
+
+    if (second != first)
+        second->lock.Release();
+    first->lock.Release();
+
+    if (any_woken) {
+        thread_reschedule();
+    }
+
+    return result;
+}
+
+status_t FutexContext::FutexRequeueLocked(user_ptr<int> wake_ptr, uint32_t wake_count,
+                                          int current_value,
+                                          user_ptr<int> requeue_ptr, uint32_t requeue_count,
+                                          Bucket* wake_bucket, Bucket* requeue_bucket,
+                                          bool* out_any_woken) {
     int value;
     status_t result = wake_ptr.copy_from_user(&value);
     if (result != MX_OK) return result;
@@ -154,22 +209,18 @@ status_t FutexContext::FutexRequeue(user_ptr<int> wake_ptr, uint32_t wake_count,
 
     uintptr_t wake_key = reinterpret_cast<uintptr_t>(wake_ptr.get());
     uintptr_t requeue_key = reinterpret_cast<uintptr_t>(requeue_ptr.get());
-    if (wake_key == requeue_key) return MX_ERR_INVALID_ARGS;
-    if (wake_key % sizeof(int) || requeue_key % sizeof(int))
-        return MX_ERR_INVALID_ARGS;
 
     // This must happen before RemoveFromHead() calls set_hash_key() on
-    // nodes below, because operations on futex_table_ look at the GetKey
+    // nodes below, because operations on the futex tables look at the GetKey
     // field of the list head nodes for wake_key and requeue_key.
-    FutexNode* node = futex_table_.erase(wake_key);
+    FutexNode* node = wake_bucket->futex_table.erase(wake_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
         return MX_OK;
     }
 
-    bool any_woken = false;
     if (wake_count > 0) {
-        node = FutexNode::WakeThreads(node, wake_count, wake_key, &any_woken);
+        node = FutexNode::WakeThreads(node, wake_count, wake_key, out_any_woken);
     }
 
     // node is now the head of wake_ptr futex after possibly removing some threads to wake
@@ -182,26 +233,21 @@ status_t FutexContext::FutexRequeue(user_ptr<int> wake_ptr, uint32_t wake_count,
 
             // now requeue our nodes to requeue_ptr mutex
             DEBUG_ASSERT(requeue_head->GetKey() == requeue_key);
-            QueueNodesLocked(requeue_head);
+            QueueNodesLocked(requeue_bucket, requeue_head);
         }
     }
 
     // add any remaining nodes back to wake_key futex
     if (node != nullptr) {
         DEBUG_ASSERT(node->GetKey() == wake_key);
-        futex_table_.insert(node);
-    }
-
-    if (any_woken) {
-        lock.release();
-        thread_reschedule();
+        wake_bucket->futex_table.insert(node);
     }
 
     return MX_OK;
 }
 
-void FutexContext::QueueNodesLocked(FutexNode* head) {
-    DEBUG_ASSERT(lock_.IsHeld());
+void FutexContext::QueueNodesLocked(Bucket* bucket, FutexNode* head) {
+    DEBUG_ASSERT(bucket->lock.IsHeld());
 
     FutexNode::HashTable::iterator iter;
 
@@ -209,15 +255,15 @@ void FutexContext::QueueNodesLocked(FutexNode* head) {
     // succeeds, then the current thread is first to block on this futex and we
     // are finished.  If the insert fails, then there is already a thread
     // waiting on this futex.  Add ourselves to that thread's list.
-    if (!futex_table_.insert_or_find(head, &iter))
+    if (!bucket->futex_table.insert_or_find(head, &iter))
         iter->AppendList(head);
 }
 
 // This attempts to unqueue a thread (which may or may not be waiting on a
 // futex), given its FutexNode.  This returns whether the FutexNode was
 // found and removed from a futex wait queue.
-bool FutexContext::UnqueueNodeLocked(FutexNode* node) {
-    DEBUG_ASSERT(lock_.IsHeld());
+bool FutexContext::UnqueueNodeLocked(Bucket* bucket, FutexNode* node) {
+    DEBUG_ASSERT(bucket->lock.IsHeld());
 
     if (!node->IsInQueue())
         return false;
@@ -225,13 +271,15 @@ bool FutexContext::UnqueueNodeLocked(FutexNode* node) {
     // Note: When UnqueueNode() is called from FutexWait(), it might be
     // tempting to reuse the futex key that was passed to FutexWait().
     // However, that could be out of date if the thread was requeued by
-    // FutexRequeue(), so we need to re-get the hash table key here.
+    // FutexRequeue(), so we need to re-get the hash table key here.  The
+    // caller holds the lock for the bucket this key hashes to.
     uintptr_t futex_key = node->GetKey();
+    DEBUG_ASSERT(&GetBucket(futex_key) == bucket);
 
-    FutexNode* old_head = futex_table_.erase(futex_key);
+    FutexNode* old_head = bucket->futex_table.erase(futex_key);
     DEBUG_ASSERT(old_head);
     FutexNode* new_head = FutexNode::RemoveNodeFromList(old_head, node);
     if (new_head)
-        futex_table_.insert(new_head);
+        bucket->futex_table.insert(new_head);
     return true;
 }
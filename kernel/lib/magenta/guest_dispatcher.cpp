@@ -41,3 +41,9 @@ mx_status_t GuestDispatcher::SetTrap(mx_trap_address_space_t aspace, mx_vaddr_t
 
     return arch_guest_set_trap(guest_.get(), aspace, addr, len, fifo);
 }
+
+mx_status_t GuestDispatcher::Commit(mx_vaddr_t addr, size_t len) {
+    canary_.Assert();
+
+    return arch_guest_commit(guest_.get(), addr, len);
+}
@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <lib/dpc.h>
+#include <magenta/compiler.h>
 #include <kernel/mutex.h>
 #include <magenta/dispatcher.h>
 #include <magenta/handle_reaper.h>
@@ -23,6 +24,8 @@ static dpc_t reaper_dpc = {
     .node = LIST_INITIAL_CLEARED_VALUE,
     .func = ReaperRoutine,
     .arg = nullptr,
+    // bulk cleanup; keep it off the completion-critical dpc lane
+    .flags = DPC_FLAG_LOW_PRIORITY,
 };
 
 void ReapHandles(mxtl::DoublyLinkedList<Handle*>* handles) {
@@ -40,20 +43,50 @@ void ReapHandles(Handle** handles, uint32_t num_handles) {
     ReapHandles(&list);
 }
 
+// Each invocation reaps at most this many handles, re-queueing itself
+// while a backlog remains, so the exit of a process with tens of
+// thousands of handles shares the dpc worker with other queued work
+// instead of monopolizing it.
+static constexpr uint32_t kReapBatchSize = 128;
+
 static void ReaperRoutine(dpc_t* dpc) {
     LTRACE_ENTRY;
-    mxtl::DoublyLinkedList<Handle*> list;
+    mxtl::DoublyLinkedList<Handle*> batch;
+    bool backlog;
     {
         AutoLock lock(&reaper_mutex);
-        list.swap(reaper_handles);
+        for (uint32_t i = 0; i < kReapBatchSize; i++) {
+            Handle* handle = reaper_handles.pop_front();
+            if (handle == nullptr)
+                break;
+            batch.push_back(handle);
+        }
+        backlog = !reaper_handles.is_empty();
     }
+
+    // Put the rest of the backlog at the tail of the dpc lane before
+    // working on this batch, so other bulk cleanup gets to interleave.
+    if (backlog)
+        dpc_queue(dpc, false);
+
+    // Group the batch by dispatcher type so the deletions run the same
+    // teardown path (and hit the same allocator caches) back to back.
+    mxtl::DoublyLinkedList<Handle*> buckets[MX_OBJ_TYPE_LAST];
     Handle* handle;
-    while ((handle = list.pop_front()) != nullptr) {
-        LTRACEF("Reaping handle of koid %" PRIu64 " of pid %" PRIu64 "\n",
-                handle->dispatcher()->get_koid(), handle->process_id());
-        DEBUG_ASSERT(handle->process_id() == 0u);
-        DeleteHandle(handle);
+    while ((handle = batch.pop_front()) != nullptr) {
+        uint32_t type = static_cast<uint32_t>(handle->dispatcher()->get_type());
+        if (type >= countof(buckets))
+            type = MX_OBJ_TYPE_NONE;
+        buckets[type].push_back(handle);
+    }
+
+    for (auto& bucket : buckets) {
+        while ((handle = bucket.pop_front()) != nullptr) {
+            LTRACEF("Reaping handle of koid %" PRIu64 " of pid %" PRIu64 "\n",
+                    handle->dispatcher()->get_koid(), handle->process_id());
+            DEBUG_ASSERT(handle->process_id() == 0u);
+            DeleteHandle(handle);
+        }
     }
     LTRACE_EXIT;
-;
 }
@@ -108,6 +108,7 @@ private:
 
     Mutex lock_;
     MessageList messages_ TA_GUARDED(lock_);
+    uint64_t message_count_ TA_GUARDED(lock_) = 0;
     WaiterList waiters_ TA_GUARDED(lock_);
     StateTracker state_tracker_;
     mxtl::RefPtr<ChannelDispatcher> other_ TA_GUARDED(lock_);
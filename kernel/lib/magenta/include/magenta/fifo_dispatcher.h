@@ -14,6 +14,7 @@
 #include <magenta/state_tracker.h>
 #include <magenta/types.h>
 
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
 #include <mxtl/ref_counted.h>
 
@@ -38,6 +39,10 @@ public:
     mx_status_t Write(const uint8_t* src, size_t len, uint32_t* actual);
     mx_status_t Read(uint8_t* dst, size_t len, uint32_t* actual);
 
+    // Returns how many elements this endpoint has written that the peer has
+    // not yet read. Advisory only: the peer may be draining concurrently.
+    uint32_t OutstandingWrites();
+
     mx_status_t WriteFromUser(const uint8_t* src, size_t len, uint32_t* actual);
     mx_status_t ReadToUser(uint8_t* dst, size_t len, uint32_t* actual);
 
@@ -48,8 +53,18 @@ private:
                       fifo_copy_from_fn_t copy_from_fn);
     mx_status_t WriteSelf(const uint8_t* ptr, size_t len, uint32_t* actual,
                           fifo_copy_from_fn_t copy_from_fn);
+    mx_status_t WriteSelfSpsc(const uint8_t* ptr, size_t count, uint32_t* actual,
+                              fifo_copy_from_fn_t copy_from_fn);
     mx_status_t Read(uint8_t* ptr, size_t len, uint32_t* actual,
                      fifo_copy_to_fn_t copy_to_fn);
+    mx_status_t ReadSpsc(uint8_t* ptr, size_t count, uint32_t* actual,
+                         fifo_copy_to_fn_t copy_to_fn);
+    // Copies whole elements in/out of the ring without moving the indices;
+    // |count| must already be clamped to the space/data available.
+    mx_status_t CopyElementsIn(const uint8_t* ptr, size_t count, uint32_t head,
+                               fifo_copy_from_fn_t copy_from_fn);
+    mx_status_t CopyElementsOut(uint8_t* ptr, size_t count, uint32_t tail,
+                                fifo_copy_to_fn_t copy_to_fn);
     mx_status_t UserSignalSelf(uint32_t clear_mask, uint32_t set_mask);
 
     void OnPeerZeroHandles();
@@ -58,14 +73,19 @@ private:
     const uint32_t elem_count_;
     const uint32_t elem_size_;
     const uint32_t mask_;
+    // In MX_FIFO_SPSC mode reads and writes skip |lock_|: the peer's
+    // writer alone advances |head_| and the local reader alone advances
+    // |tail_|, paired with release/acquire ordering.
+    const bool spsc_;
     mx_koid_t peer_koid_;
     StateTracker state_tracker_;
 
     Mutex lock_;
     mxtl::RefPtr<FifoDispatcher> other_ TA_GUARDED(lock_);
-    uint32_t head_ TA_GUARDED(lock_);
-    uint32_t tail_ TA_GUARDED(lock_);
-    uint8_t* data_ TA_GUARDED(lock_);
+    mxtl::atomic<uint32_t> head_;
+    mxtl::atomic<uint32_t> tail_;
+    // Set once during Init() and immutable afterwards.
+    uint8_t* data_;
 
     static constexpr uint32_t kMaxSizeBytes = PAGE_SIZE;
 };
@@ -51,14 +51,33 @@ private:
     FutexContext(const FutexContext&) = delete;
     FutexContext& operator=(const FutexContext&) = delete;
 
-    void QueueNodesLocked(FutexNode* head) TA_REQ(lock_);
+    // The futex table is sharded into independently locked buckets keyed on
+    // the futex address so that unrelated futexes in the same process do not
+    // contend on a single lock.
+    static constexpr size_t kNumBuckets = 16u;
 
-    bool UnqueueNodeLocked(FutexNode* node) TA_REQ(lock_);
+    struct Bucket {
+        // protects futex_table
+        Mutex lock;
 
-    // protects futex_table_
-    Mutex lock_;
+        // Hash table for the futexes which hash to this bucket.
+        // Key is futex address, value is the FutexNode for the head of
+        // futex's blocked thread list.
+        FutexNode::HashTable futex_table TA_GUARDED(lock);
+    };
 
-    // Hash table for futexes in this context.
-    // Key is futex address, value is the FutexNode for the head of futex's blocked thread list.
-    FutexNode::HashTable futex_table_ TA_GUARDED(lock_);
+    Bucket& GetBucket(uintptr_t futex_key) {
+        return buckets_[FutexNode::GetHash(futex_key) % kNumBuckets];
+    }
+
+    void QueueNodesLocked(Bucket* bucket, FutexNode* head) TA_REQ(bucket->lock);
+
+    bool UnqueueNodeLocked(Bucket* bucket, FutexNode* node) TA_REQ(bucket->lock);
+
+    status_t FutexRequeueLocked(user_ptr<int> wake_ptr, uint32_t wake_count, int current_value,
+                                user_ptr<int> requeue_ptr, uint32_t requeue_count,
+                                Bucket* wake_bucket, Bucket* requeue_bucket,
+                                bool* out_any_woken) TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    Bucket buckets_[kNumBuckets];
 };
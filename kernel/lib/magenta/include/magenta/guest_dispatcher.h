@@ -24,6 +24,7 @@ public:
 
     mx_status_t SetTrap(mx_trap_address_space_t aspace, mx_vaddr_t addr, size_t len,
                         mxtl::RefPtr<FifoDispatcher> fifo);
+    mx_status_t Commit(mx_vaddr_t addr, size_t len);
 
 private:
     mxtl::Canary<mxtl::magic("GSTD")> canary_;
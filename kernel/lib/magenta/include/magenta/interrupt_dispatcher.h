@@ -34,8 +34,20 @@ public:
     // Signal the IRQ from non-IRQ state in response to a user-land request.
     virtual status_t UserSignal() = 0;
 
+    // Direct delivery of this interrupt at a specific CPU.  Optional; modes
+    // which cannot re-target an individual vector (such as legacy and plain
+    // MSI) report MX_ERR_NOT_SUPPORTED.
+    virtual status_t SetAffinity(uint32_t cpu_num) { return MX_ERR_NOT_SUPPORTED; }
+
     status_t WaitForInterrupt() {
-        return event_wait_deadline(&event_, INFINITE_TIME, true);
+        // Wait (and wake) in the IRQ thread band so that neither the wakeup
+        // nor the driver's bottom half are delayed behind CPU-bound fair
+        // threads.  The band is held until InterruptComplete() revokes it.
+        thread_set_irq_thread(true);
+        status_t status = event_wait_deadline(&event_, INFINITE_TIME, true);
+        if (status != MX_OK)
+            thread_set_irq_thread(false);
+        return status;
     }
 
     virtual void on_zero_handles() final {
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include <kernel/mutex.h>
+#include <kernel/vm/vm_object.h>
 
 #include <magenta/dispatcher.h>
 #include <magenta/policy_manager.h>
@@ -17,6 +18,7 @@
 #include <magenta/types.h>
 
 #include <mxtl/array.h>
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
 #include <mxtl/intrusive_double_list.h>
 #include <mxtl/name.h>
@@ -24,6 +26,21 @@
 
 class JobNode;
 
+// Counts pages committed to VMOs created by processes in a job. Shared with
+// the VM layer, which adjusts it as pages come and go. Kept separate from
+// JobDispatcher so that VMOs which outlive their creating job still hold a
+// valid counter.
+class JobPageCounter final : public VmPageCounter {
+public:
+    JobPageCounter() : pages_(0) {}
+
+    void Adjust(int64_t delta_pages) final { pages_.fetch_add(delta_pages); }
+    size_t pages() const { return pages_.load(); }
+
+private:
+    mxtl::atomic<int64_t> pages_;
+};
+
 // Interface for walking a job/process tree.
 class JobEnumerator {
 public:
@@ -100,6 +117,10 @@ public:
     status_t SetPolicy(uint32_t mode, const mx_policy_basic* in_policy, size_t policy_count);
     pol_cookie_t GetPolicy();
 
+    // Default slack, in ns, for timers started with a slack of zero by
+    // processes in this job. Set via MX_POL_TIMER_SLACK.
+    mx_duration_t GetTimerSlack();
+
     // Updates a partial ordering between jobs so that this job will be killed
     // after |other| in low-resource situations. If |other| is null, then this
     // job becomes the least-important job in the system.
@@ -123,11 +144,26 @@ public:
     // Walks the job/process tree and invokes |je| methods on each node. If
     // |recurse| is false, only visits direct children of this job. Returns
     // false if any methods of |je| return false; returns true otherwise.
+    //
+    // The walk is made over a generation-counted snapshot of each job's
+    // children, taken under a brief hold of |lock_|, so the callbacks and
+    // the recursion never block process/job creation; children that come or
+    // go while the walk is in progress may or may not be visited.
     bool EnumerateChildren(JobEnumerator* je, bool recurse);
 
     mxtl::RefPtr<ProcessDispatcher> LookupProcessById(mx_koid_t koid);
     mxtl::RefPtr<JobDispatcher> LookupJobById(mx_koid_t koid);
 
+    // The counter billed for pages committed to VMOs created by this job's
+    // processes. Descendant jobs bill their own counters.
+    mxtl::RefPtr<VmPageCounter> page_counter() const { return page_counter_; }
+
+    // Pages currently committed to VMOs created by this job's processes.
+    // Maintained incrementally by the VM layer, so this is cheap to read.
+    size_t ResidentPages() const { return page_counter_->pages(); }
+
+    status_t GetStats(mx_info_job_stats_t* stats) const;
+
 private:
     enum class State {
         READY,
@@ -143,6 +179,8 @@ private:
     bool AddChildJob(JobDispatcher* job);
     void RemoveChildJob(JobDispatcher* job);
 
+    bool EnumerateChildrenLocked(JobEnumerator* je, bool recurse);
+
     void UpdateSignalsIncrementLocked() TA_REQ(lock_);
     void UpdateSignalsDecrementLocked() TA_REQ(lock_);
 
@@ -163,9 +201,15 @@ private:
     State state_ TA_GUARDED(lock_);
     uint32_t process_count_ TA_GUARDED(lock_);
     uint32_t job_count_ TA_GUARDED(lock_);
+    // Bumped on every child add/remove; lets enumeration size its snapshot
+    // outside the lock and detect that the sizing went stale.
+    uint32_t children_gen_ TA_GUARDED(lock_);
     mx_job_importance_t importance_ TA_GUARDED(lock_);
     StateTracker state_tracker_;
 
+    // Set once by the factories before the job becomes visible.
+    mxtl::RefPtr<JobPageCounter> page_counter_;
+
     using RawJobList =
         mxtl::DoublyLinkedList<JobDispatcher*, ListTraitsRaw>;
     using RawProcessList =
@@ -180,6 +224,7 @@ private:
     RawProcessList procs_ TA_GUARDED(lock_);
 
     pol_cookie_t policy_ TA_GUARDED(lock_);
+    mx_duration_t timer_slack_ TA_GUARDED(lock_);
 
     // Global list of JobDispatchers, ordered by relative importance. Used to
     // find victims in low-resource situations.
@@ -36,6 +36,14 @@ void DeleteHandle(Handle* handle);
 // Maps an integer obtained by Handle->base_value() back to a Handle.
 Handle* MapU32ToHandle(uint32_t value);
 
+// Attempts a lock-free lookup of the handle |value| belonging to the process
+// with koid |koid|. On success fills in the handle's dispatcher and rights
+// and returns true. Returns false whenever the handle cannot be safely
+// resolved this way (including the plain bad-handle case); callers must then
+// fall back to the handle-table-locked path for the authoritative answer.
+bool LookupHandleNoLock(uint32_t value, mx_koid_t koid,
+                        mxtl::RefPtr<Dispatcher>* dispatcher, mx_rights_t* rights);
+
 // Set/get the system exception port.
 mx_status_t SetSystemExceptionPort(mxtl::RefPtr<ExceptionPort> eport);
 // Returns true if a port had been set.
@@ -44,6 +52,10 @@ mxtl::RefPtr<ExceptionPort> GetSystemExceptionPort();
 
 mxtl::RefPtr<JobDispatcher> GetRootJobDispatcher();
 
+// Returns the event signaled by the OOM thread when free memory crosses the
+// pressure watermarks, or null if the event could not be created at boot.
+mxtl::RefPtr<Dispatcher> GetMemoryPressureEventDispatcher();
+
 PolicyManager* GetSystemPolicyManager();
 
 bool magenta_rights_check(const Handle* handle, mx_rights_t desired);
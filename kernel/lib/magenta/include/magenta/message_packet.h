@@ -34,6 +34,13 @@ public:
                               uint32_t num_handles,
                               mxtl::unique_ptr<MessagePacket>* msg);
 
+    // As Create(), but the data is gathered from |iov_count| user segments
+    // directly into the packet, so vectored senders do not pay an extra
+    // linearizing copy. |iov_count| may not exceed MX_IOVEC_MAX.
+    static mx_status_t CreateGather(user_ptr<const mx_iovec_t> iov, uint32_t iov_count,
+                                    uint32_t num_handles,
+                                    mxtl::unique_ptr<MessagePacket>* msg);
+
     uint32_t data_size() const { return data_size_; }
 
     // Copies the packet's |data_size()| bytes to |buf|.
@@ -67,10 +74,9 @@ private:
     static mx_status_t NewPacket(uint32_t data_size, uint32_t num_handles,
                                  mxtl::unique_ptr<MessagePacket>* msg);
 
-    // Create() uses malloc(), so we must delete using free().
-    static void operator delete(void* ptr) {
-        free(ptr);
-    }
+    // Packet memory comes from a size-class slab allocator or the heap;
+    // operator delete returns it to wherever NewPacket got it from.
+    static void operator delete(void* ptr);
     friend class mxtl::unique_ptr<MessagePacket>;
 
     // Handles and data are stored in the same buffer: num_handles_ Handle*
@@ -25,6 +25,7 @@ public:
     ~PciInterruptDispatcher() final;
     status_t InterruptComplete() final;
     status_t UserSignal() final;
+    status_t SetAffinity(uint32_t cpu_num) final;
 
 private:
     static pcie_irq_handler_retval_t IrqThunk(const PcieDevice& dev,
@@ -0,0 +1,25 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <arch/ops.h>
+#include <stddef.h>
+
+// Slab allocator cache policy for allocators on syscall fast paths: one cache
+// per cpu, so concurrent allocations on different cpus almost never contend
+// on the core allocator's lock. The cpu number is only a contention-avoidance
+// hint; a thread migrating between CurrentCache() and the cache operation is
+// harmless.
+//
+// Note that each cache may park up to (2 * BATCH_SIZE - 1) objects, so
+// allocators using this policy should budget roughly an extra
+// 2 * BATCH_SIZE * SMP_MAX_CPUS objects into their slab quotas.
+struct PerCpuSlabCacheTraits {
+    static constexpr size_t NUM_CACHES = SMP_MAX_CPUS;
+    static constexpr size_t BATCH_SIZE = 8;
+    static size_t CurrentCache() { return arch_curr_cpu_num(); }
+};
@@ -17,6 +17,7 @@
 
 #include <mxtl/canary.h>
 #include <mxtl/intrusive_double_list.h>
+#include <mxtl/slab_allocator.h>
 #include <mxtl/unique_ptr.h>
 
 #include <sys/types.h>
@@ -82,14 +83,26 @@ class PortObserver;
 #define PKT_FLAG_EPHEMERAL  0x10000000u
 #define PKT_FLAG_MASK       0x0FFFFFFFu
 
-struct PortPacket final : public mxtl::DoublyLinkedListable<PortPacket*> {
+struct PortPacket;
+using PortPacketTraits = mxtl::ManualDeleteSlabAllocatorTraits<PortPacket*>;
+using PortPacketAllocator = mxtl::SlabAllocator<PortPacketTraits>;
+
+struct PortPacket final : public mxtl::DoublyLinkedListable<PortPacket*>,
+                          public mxtl::SlabAllocated<PortPacketTraits> {
     mx_port_packet_t packet;
     PortObserver* observer;
+    // True if this packet came from the owning port's packet pool rather
+    // than the heap; only meaningful for ephemeral packets.
+    const bool pooled;
 
-    PortPacket();
+    explicit PortPacket(bool pooled);
     PortPacket(const PortPacket&) = delete;
     void operator=(PortPacket) = delete;
 
+    // Ephemeral packets which could not be pooled come from the heap;
+    // this undoes the SlabAllocated<> hiding of operator delete for them.
+    static void operator delete(void* ptr);
+
     uint32_t type() const { return packet.type; }
 };
 
@@ -117,6 +130,9 @@ private:
     Flags OnCancel(Handle* handle) final;
     Flags OnCancelByKey(Handle* handle, const void* port, uint64_t key) final;
     void OnRemoved() final;
+    // State transitions that neither assert nor touch the trigger signals
+    // are no-ops for MaybeQueue(), so the state tracker may skip us for them.
+    mx_signals_t watched_signals() const final { return trigger_; }
 
     // The following method can only be called from
     // OnInitialize(), OnStateChange() and OnCancel().
@@ -146,6 +162,17 @@ public:
     mx_status_t QueueUser(const mx_port_packet_t& packet);
     mx_status_t DeQueue(mx_time_t deadline, mx_port_packet_t* packet);
 
+    // Dequeues up to |count| packets, blocking until at least one is
+    // available or the deadline passes. |packets| may be null, in which
+    // case the dequeued packets are simply dropped. |count| must be
+    // between 1 and kMaxPacketsPerWait.
+    mx_status_t DeQueue(mx_time_t deadline, mx_port_packet_t* packets,
+                        uint32_t count, uint32_t* actual);
+
+    // Maximum number of packets DeQueue() can return in one call; matches
+    // the limit exposed to user space for mx_port_wait_multiple().
+    static constexpr uint32_t kMaxPacketsPerWait = 16u;
+
     // Decides who is going to destroy the observer. If it returns |true| it
     // is the duty of the caller. If it is false it is the duty of the port.
     bool CanReap(PortObserver* observer, PortPacket* port_packet);
@@ -164,6 +191,10 @@ private:
     PortDispatcher(uint32_t options);
     PortObserver* CopyLocked(PortPacket* port_packet, mx_port_packet_t* packet) TA_REQ(lock_);
 
+    // Returns an ephemeral packet to the packet pool or the heap,
+    // whichever it came from.
+    void FreePacket(PortPacket* port_packet);
+
     // Adopts a RefPtr to |eport|, and adds it to |eports_|.
     // Called by ExceptionPort.
     void LinkExceptionPort(ExceptionPort* eport);
@@ -179,4 +210,8 @@ private:
     bool zero_handles_ TA_GUARDED(lock_);
     mxtl::DoublyLinkedList<PortPacket*> packets_ TA_GUARDED(lock_);
     mxtl::DoublyLinkedList<mxtl::RefPtr<ExceptionPort>> eports_ TA_GUARDED(lock_);
+
+    // Pool for ephemeral (user-queued) packets; QueueUser() falls back to
+    // the heap when the pool is exhausted.
+    PortPacketAllocator packet_allocator_;
 };
@@ -245,7 +245,19 @@ public:
     //         return res;
     //     }
     //     // Ok to create a channel.
-    mx_status_t QueryPolicy(uint32_t condition) const;
+    //
+    // The job policy is compiled into flat per-condition masks at process
+    // creation, so this check is a load and test rather than a
+    // PolicyManager decode on every object-creation syscall.
+    mx_status_t QueryPolicy(uint32_t condition) const {
+        DEBUG_ASSERT(condition < MX_POL_MAX);
+        const uint32_t bit = 1u << condition;
+        if (unlikely(policy_exception_mask_ & bit))
+            thread_signal_policy_exception();
+        // TODO(cpu): check for the MX_POL_KILL bit and return an error code
+        // that sysgen understands as termination.
+        return (policy_deny_mask_ & bit) ? MX_ERR_ACCESS_DENIED : MX_OK;
+    }
 
     // return a cached copy of the vdso code address or compute a new one
     uintptr_t vdso_code_address() {
@@ -295,6 +307,11 @@ private:
     // Policy set by the Job during Create().
     const pol_cookie_t policy_;
 
+    // |policy_| compiled into per-condition masks (bit n covers MX_POL
+    // condition n); see QueryPolicy().
+    uint32_t policy_deny_mask_ = 0;
+    uint32_t policy_exception_mask_ = 0;
+
     // The process can belong to either of these lists independently.
     mxtl::DoublyLinkedListNodeState<ProcessDispatcher*> dll_job_raw_;
     mxtl::SinglyLinkedListNodeState<mxtl::RefPtr<ProcessDispatcher>> dll_job_;
@@ -48,12 +48,35 @@ public:
     // Socket methods.
     mx_status_t Write(user_ptr<const void> src, size_t len, size_t* written);
 
+    // As Write(), but gathers the data from |iov_count| user segments in a
+    // single pass; a datagram socket queues the segments as one packet.
+    // |iov_count| may not exceed MX_IOVEC_MAX. Not supported on
+    // MX_SOCKET_SHARED sockets, which do not copy through the kernel.
+    mx_status_t WriteGather(user_ptr<const mx_iovec_t> iov, uint32_t iov_count,
+                            size_t* written);
+
     status_t HalfClose();
 
     mx_status_t Read(user_ptr<void> dst, size_t len, size_t* nread);
 
+    // Drains as many complete datagrams as fit into |dst|, each preceded
+    // by a uint32_t payload length. Only valid on MX_SOCKET_DATAGRAM
+    // sockets.
+    mx_status_t ReadBatch(user_ptr<void> dst, size_t len, size_t* nread);
+
     void OnPeerZeroHandles();
 
+    // True for MX_SOCKET_SHARED sockets, whose data region is a shared
+    // VMO ring rather than kernel mbufs. In that mode Write()/Read() only
+    // advance the kernel-managed producer/consumer indices (and report
+    // space/bytes available for len == 0); the bytes themselves move
+    // through the endpoints' mappings of the ring VMO.
+    bool is_shared() const { return flags_ == MX_SOCKET_SHARED; }
+
+    // Returns the shared ring VMO and the offset of this endpoint's
+    // transmit ring within it. The receive ring is the other half.
+    mx_status_t GetSharedRing(mxtl::RefPtr<VmObject>* vmo, uint64_t* tx_offset);
+
 private:
     // An MBuf is a small fixed-size chainable memory buffer.
     struct MBuf : public mxtl::SinglyLinkedListable<MBuf*> {
@@ -75,12 +98,18 @@ private:
 
     SocketDispatcher(uint32_t flags);
     mx_status_t Init(mxtl::RefPtr<SocketDispatcher> other);
-    mx_status_t WriteSelf(user_ptr<const void> src, size_t len, size_t* nwritten);
+    // The write paths share one mbuf-filling implementation that gathers
+    // from an array of user segments; single-buffer writes pass a
+    // one-entry array.
+    mx_status_t WriteSelf(const mx_iovec_t* vec, uint32_t vec_count, size_t len,
+                          size_t* nwritten);
     status_t UserSignalSelf(uint32_t clear_mask, uint32_t set_mask);
     status_t HalfCloseOther();
 
-    mx_status_t WriteStreamMBufsLocked(user_ptr<const void> src, size_t len, size_t* written) TA_REQ(lock_);
-    mx_status_t WriteDgramMBufsLocked(user_ptr<const void> src, size_t len, size_t* written) TA_REQ(lock_);
+    mx_status_t WriteStreamMBufsLocked(const mx_iovec_t* vec, uint32_t vec_count,
+                                       size_t len, size_t* written) TA_REQ(lock_);
+    mx_status_t WriteDgramMBufsLocked(const mx_iovec_t* vec, uint32_t vec_count,
+                                      size_t len, size_t* written) TA_REQ(lock_);
     size_t ReadMBufsLocked(user_ptr<void> dst, size_t len) TA_REQ(lock_);
     MBuf* AllocMBuf() TA_REQ(lock_);
     void FreeMBuf(MBuf* buf) TA_REQ(lock_);
@@ -102,4 +131,13 @@ private:
     mxtl::RefPtr<SocketDispatcher> other_ TA_GUARDED(lock_);
     // half_closed_[0] is this end and [1] is the other end.
     bool half_closed_[2] TA_GUARDED(lock_);
+
+    // Shared-ring mode state. The VMO and receive ring offset are set once
+    // during Create() and immutable afterwards. The indices are
+    // free-running byte counters for this endpoint's receive ring: the
+    // head is advanced by the peer's Write(), the tail by our Read().
+    mxtl::RefPtr<VmObject> ring_vmo_;
+    uint64_t ring_rx_offset_ = 0u;
+    uint64_t ring_head_ TA_GUARDED(lock_) = 0u;
+    uint64_t ring_tail_ TA_GUARDED(lock_) = 0u;
 };
@@ -69,6 +69,13 @@ public:
     // is safe to delete the observer.
     virtual void OnRemoved() {}
 
+    // Returns the signals whose transitions this observer needs to see; the state tracker
+    // uses it to sort observers into buckets and skip the ones a given transition cannot
+    // concern. Observers that cannot enumerate their interest keep the default of all
+    // signals and are visited on every transition. The returned mask must not change while
+    // the observer is registered with a state tracker.
+    virtual mx_signals_t watched_signals() const { return ~0u; }
+
 protected:
     ~StateObserver() {}
 
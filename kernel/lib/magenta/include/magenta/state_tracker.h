@@ -12,6 +12,7 @@
 #include <kernel/spinlock.h>
 #include <magenta/state_observer.h>
 #include <magenta/types.h>
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
 #include <mxtl/intrusive_double_list.h>
 
@@ -57,7 +58,7 @@ public:
     // value is allowed to mutate by other threads while this call is executing.
     void UpdateLastHandleSignal(uint32_t* count);
 
-    mx_signals_t GetSignalsState() { return signals_; }
+    mx_signals_t GetSignalsState() { return signals_.load(); }
 
     using ObserverList = mxtl::DoublyLinkedList<StateObserver*, StateObserverListTraits>;
 
@@ -70,14 +71,50 @@ public:
     mx_status_t InvalidateCookie(CookieJar *cookiejar);
 
 private:
+    // Observers are sharded by their watched signals so a state transition only
+    // visits the buckets whose members may care about it. Each bucket tracks the
+    // union of its members' watched signals; the union only grows while a bucket
+    // is occupied and is reset when the bucket empties, so it may overestimate
+    // (costing an extra visit) but never underestimates.
+    struct ObserverBucket {
+        ObserverList list;
+        mx_signals_t interest = 0u;
+    };
+    static constexpr uint32_t kNumObserverBuckets = 4u;
+
+    static uint32_t BucketFor(mx_signals_t watched);
+
     // Returns flag kHandled if one of the observers have been signaled.
-    StateObserver::Flags UpdateInternalLocked(ObserverList* obs_to_remove, mx_signals_t signals) TA_REQ(lock_);
+    // |signals| is the state to report; |changed| is the set of signals this
+    // transition touched. Observers are skipped when their watched signals
+    // intersect neither.
+    StateObserver::Flags UpdateInternalLocked(ObserverList* obs_to_remove, mx_signals_t signals,
+                                              mx_signals_t changed) TA_REQ(lock_);
+
+    // Shared walk for Cancel() and CancelByKey(); calls |f| on every observer
+    // and removes the ones that ask for it. Only instantiated in the
+    // implementation file.
+    template <typename Func>
+    StateObserver::Flags CancelWithFunc(Func f);
+
+    // Recompute |observed_interest_| from the bucket interests; called after
+    // removals so the unlocked fast path in UpdateState stops overestimating.
+    void RebuildObservedInterestLocked() TA_REQ(lock_);
 
     mxtl::Canary<mxtl::magic("STRK")> canary_;
 
-    mx_signals_t signals_;
+    // The signal state is updated atomically so that signalers whose
+    // transition no registered observer is watching never take |lock_|; see
+    // UpdateState for the ordering protocol that keeps wakes from being lost.
+    mxtl::atomic<mx_signals_t> signals_;
+
+    // Union of every registered observer's watched signals.  May briefly
+    // overestimate (costing a needless lock acquisition) but, outside of
+    // |lock_|, never underestimates.
+    mxtl::atomic<mx_signals_t> observed_interest_{0u};
+
     Mutex lock_;
 
-    // Active observers are elements in |observers_|.
-    ObserverList observers_ TA_GUARDED(lock_);
+    // Active observers are elements of one of the |buckets_| lists.
+    ObserverBucket buckets_[kNumObserverBuckets] TA_GUARDED(lock_);
 };
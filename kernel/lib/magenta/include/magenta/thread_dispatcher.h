@@ -108,6 +108,15 @@ public:
     status_t Suspend();
     status_t Resume();
 
+    // Places the thread in (or removes it from, for a zero |period_ns|) the
+    // deadline scheduling class. See sched_set_deadline().
+    status_t SetDeadline(uint64_t capacity_ns, uint64_t deadline_ns, uint64_t period_ns);
+
+    // Restricts the thread to the cpus in |hard_mask| and prefers those in
+    // |soft_mask|; a zero mask clears the respective constraint. See
+    // sched_set_affinity().
+    status_t SetAffinity(uint32_t hard_mask, uint32_t soft_mask);
+
     // accessors
     ProcessDispatcher* process() { return process_.get(); }
 
@@ -28,8 +28,9 @@ public:
     StateTracker* get_state_tracker() final { return &state_tracker_; }
     void on_zero_handles() final;
 
-    // Timer specific ops.
-    mx_status_t Set(mx_time_t deadline, mx_duration_t period);
+    // Timer specific ops. |slack| is how far past |deadline| each firing
+    // may be deferred so the kernel can coalesce it with nearby timers.
+    mx_status_t Set(mx_time_t deadline, mx_duration_t period, mx_duration_t slack);
     mx_status_t Cancel();
 
     // Timer callback.
@@ -44,6 +45,7 @@ private:
     Mutex lock_;
     mx_time_t deadline_ TA_GUARDED(lock_);
     mx_duration_t period_ TA_GUARDED(lock_);
+    mx_duration_t slack_ TA_GUARDED(lock_);
     timer_t timer_ TA_GUARDED(lock_);
     StateTracker state_tracker_;
 };
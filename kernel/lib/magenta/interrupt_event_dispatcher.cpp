@@ -77,6 +77,10 @@ InterruptEventDispatcher::~InterruptEventDispatcher() {
 status_t InterruptEventDispatcher::InterruptComplete() {
     canary_.Assert();
 
+    // The bottom half is done; drop the IRQ thread band granted when the
+    // caller entered WaitForInterrupt().
+    thread_set_irq_thread(false);
+
     unsignal();
     unmask_interrupt(vector_);
     return MX_OK;
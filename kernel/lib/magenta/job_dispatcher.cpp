@@ -14,6 +14,7 @@
 #include <magenta/rights.h>
 #include <magenta/syscalls/policy.h>
 #include <mxalloc/new.h>
+#include <mxtl/array.h>
 
 // The starting max_height value of the root job.
 static constexpr uint32_t kRootJobMaxHeight = 32;
@@ -22,9 +23,13 @@ static constexpr char kRootJobName[] = "<superroot>";
 
 mxtl::RefPtr<JobDispatcher> JobDispatcher::CreateRootJob() {
     AllocChecker ac;
+    auto counter = mxtl::AdoptRef(new (&ac) JobPageCounter());
+    if (!ac.check())
+        return nullptr;
     auto job = mxtl::AdoptRef(new (&ac) JobDispatcher(0u, nullptr, kPolicyEmpty));
     if (!ac.check())
         return nullptr;
+    job->page_counter_ = mxtl::move(counter);
     job->set_name(kRootJobName, sizeof(kRootJobName));
     return job;
 }
@@ -39,9 +44,14 @@ status_t JobDispatcher::Create(uint32_t flags,
     }
 
     AllocChecker ac;
+    auto counter = mxtl::AdoptRef(new (&ac) JobPageCounter());
+    if (!ac.check())
+        return MX_ERR_NO_MEMORY;
+
     auto job = new (&ac) JobDispatcher(flags, parent, parent->GetPolicy());
     if (!ac.check())
         return MX_ERR_NO_MEMORY;
+    job->page_counter_ = mxtl::move(counter);
 
     if (!parent->AddChildJob(job)) {
         delete job;
@@ -61,11 +71,13 @@ JobDispatcher::JobDispatcher(uint32_t /*flags*/,
       state_(State::READY),
       process_count_(0u),
       job_count_(0u),
+      children_gen_(0u),
       importance_(parent != nullptr
                       ? MX_JOB_IMPORTANCE_INHERITED
                       : MX_JOB_IMPORTANCE_MAX),
       state_tracker_(MX_JOB_NO_PROCESSES | MX_JOB_NO_JOBS),
-      policy_(policy) {
+      policy_(policy),
+      timer_slack_(parent_ ? parent_->GetTimerSlack() : 0u) {
 
     // Set the initial relative importance.
     // Tries to make older jobs closer to the root more important.
@@ -129,6 +141,7 @@ bool JobDispatcher::AddChildProcess(ProcessDispatcher* process) {
         return false;
     procs_.push_back(process);
     ++process_count_;
+    ++children_gen_;
     UpdateSignalsIncrementLocked();
     return true;
 }
@@ -142,6 +155,7 @@ bool JobDispatcher::AddChildJob(JobDispatcher* job) {
 
     jobs_.push_back(job);
     ++job_count_;
+    ++children_gen_;
     UpdateSignalsIncrementLocked();
     return true;
 }
@@ -155,6 +169,7 @@ void JobDispatcher::RemoveChildProcess(ProcessDispatcher* process) {
         return;
     procs_.erase(*process);
     --process_count_;
+    ++children_gen_;
     UpdateSignalsDecrementLocked();
 }
 
@@ -166,6 +181,7 @@ void JobDispatcher::RemoveChildJob(JobDispatcher* job) {
         return;
     jobs_.erase(*job);
     --job_count_;
+    ++children_gen_;
     UpdateSignalsDecrementLocked();
 }
 
@@ -216,6 +232,19 @@ pol_cookie_t JobDispatcher::GetPolicy() {
     return policy_;
 }
 
+mx_duration_t JobDispatcher::GetTimerSlack() {
+    AutoLock lock(&lock_);
+    return timer_slack_;
+}
+
+status_t JobDispatcher::GetStats(mx_info_job_stats_t* stats) const {
+    canary_.Assert();
+
+    *stats = {};
+    stats->mem_committed_bytes = ResidentPages() * PAGE_SIZE;
+    return MX_OK;
+}
+
 void JobDispatcher::Kill() {
     canary_.Assert();
 
@@ -264,20 +293,45 @@ status_t JobDispatcher::SetPolicy(
     if (!procs_.is_empty() || !jobs_.is_empty())
         return MX_ERR_BAD_STATE;
 
+    if (policy_count > MX_POL_MAX)
+        return MX_ERR_OUT_OF_RANGE;
+
+    // MX_POL_TIMER_SLACK carries a value rather than an action, so it is
+    // applied here; the remaining entries are packed into the cookie by
+    // the policy manager.
+    mx_policy_basic actions[MX_POL_MAX];
+    size_t action_count = 0u;
+    mx_duration_t new_slack = timer_slack_;
+
+    for (size_t ix = 0; ix != policy_count; ++ix) {
+        if (in_policy[ix].condition == MX_POL_TIMER_SLACK) {
+            // A job may only defer its timers further than its parent does,
+            // never tighten the slack it inherited.
+            if (in_policy[ix].policy >= timer_slack_) {
+                new_slack = in_policy[ix].policy;
+            } else if (mode == MX_JOB_POL_ABSOLUTE) {
+                return MX_ERR_ALREADY_EXISTS;
+            }
+        } else {
+            actions[action_count++] = in_policy[ix];
+        }
+    }
+
     pol_cookie_t new_policy;
     auto status = GetSystemPolicyManager()->AddPolicy(
-        mode, policy_, in_policy, policy_count, &new_policy);
+        mode, policy_, actions, action_count, &new_policy);
 
     if (status < 0)
         return status;
 
     policy_ = new_policy;
+    timer_slack_ = new_slack;
     return MX_OK;
 }
 
-bool JobDispatcher::EnumerateChildren(JobEnumerator* je, bool recurse) {
-    canary_.Assert();
-
+// Fallback for when a snapshot cannot be allocated: the original
+// walk-the-live-lists-under-the-lock enumeration.
+bool JobDispatcher::EnumerateChildrenLocked(JobEnumerator* je, bool recurse) {
     AutoLock lock(&lock_);
 
     for (auto& proc : procs_) {
@@ -300,6 +354,76 @@ bool JobDispatcher::EnumerateChildren(JobEnumerator* je, bool recurse) {
     return true;
 }
 
+bool JobDispatcher::EnumerateChildren(JobEnumerator* je, bool recurse) {
+    canary_.Assert();
+
+    // Visit a snapshot of the children rather than the live lists, so that
+    // |lock_| is not held across the |je| callbacks or the recursion and
+    // process/job creation never blocks behind a slow enumerator.  The
+    // snapshot arrays are sized and allocated outside the lock; the
+    // generation count detects when the children changed in between and the
+    // sizing has to be redone.
+    mxtl::Array<mxtl::RefPtr<ProcessDispatcher>> procs_snapshot;
+    mxtl::Array<mxtl::RefPtr<JobDispatcher>> jobs_snapshot;
+
+    for (;;) {
+        uint32_t gen;
+        size_t num_procs, num_jobs;
+        {
+            AutoLock lock(&lock_);
+            gen = children_gen_;
+            num_procs = process_count_;
+            num_jobs = job_count_;
+        }
+
+        AllocChecker ac;
+        procs_snapshot.reset(new (&ac) mxtl::RefPtr<ProcessDispatcher>[num_procs],
+                             num_procs);
+        if (!ac.check())
+            return EnumerateChildrenLocked(je, recurse);
+        jobs_snapshot.reset(new (&ac) mxtl::RefPtr<JobDispatcher>[num_jobs],
+                            num_jobs);
+        if (!ac.check())
+            return EnumerateChildrenLocked(je, recurse);
+
+        AutoLock lock(&lock_);
+        if (children_gen_ != gen)
+            continue;
+
+        size_t i = 0;
+        for (auto& proc : procs_) {
+            procs_snapshot[i++] = mxtl::RefPtr<ProcessDispatcher>(&proc);
+        }
+        DEBUG_ASSERT(i == num_procs);
+
+        i = 0;
+        for (auto& job : jobs_) {
+            jobs_snapshot[i++] = mxtl::RefPtr<JobDispatcher>(&job);
+        }
+        DEBUG_ASSERT(i == num_jobs);
+        break;
+    }
+
+    for (const auto& proc : procs_snapshot) {
+        if (!je->OnProcess(proc.get())) {
+            return false;
+        }
+    }
+
+    for (const auto& job : jobs_snapshot) {
+        if (!je->OnJob(job.get())) {
+            return false;
+        }
+        if (recurse) {
+            // TODO(kulakowski): This recursive call can overflow the stack.
+            if (!job->EnumerateChildren(je, /* recurse */ true)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 mxtl::RefPtr<ProcessDispatcher> JobDispatcher::LookupProcessById(mx_koid_t koid) {
     canary_.Assert();
 
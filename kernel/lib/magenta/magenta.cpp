@@ -9,9 +9,13 @@
 #include <pow2.h>
 #include <trace.h>
 
+#include <arch/ops.h>
+
 #include <kernel/auto_lock.h>
 #include <kernel/cmdline.h>
 #include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <kernel/vm/vm_object.h>
 
 #include <lk/init.h>
 
@@ -20,6 +24,7 @@
 
 #include <magenta/diagnostics.h>
 #include <magenta/dispatcher.h>
+#include <magenta/event_dispatcher.h>
 #include <magenta/excp_port.h>
 #include <magenta/handle.h>
 #include <magenta/job_dispatcher.h>
@@ -36,6 +41,7 @@
 #include <mxtl/type_support.h>
 
 #include <platform.h>
+#include <pretty/sizes.h>
 
 #define LOCAL_TRACE 0
 
@@ -51,6 +57,16 @@ static Mutex handle_mutex;
 static mxtl::Arena TA_GUARDED(handle_mutex) handle_arena;
 static size_t outstanding_handles TA_GUARDED(handle_mutex) = 0u;
 
+// Per-cpu hazard pointers protecting lock-free handle lookups. A cpu
+// publishes the Handle slot it is inspecting (with interrupts disabled)
+// before validating it; TearDownHandle() spins until no cpu has the dying
+// handle published before destroying the slot. Since lookups run with
+// interrupts off, the wait is short and bounded.
+struct HandleHazard {
+    Handle* volatile handle;
+} __CPU_MAX_ALIGN;
+static HandleHazard handle_hazards[SMP_MAX_CPUS];
+
 size_t internal::OutstandingHandles() {
     AutoLock lock(&handle_mutex);
     return outstanding_handles;
@@ -63,6 +79,10 @@ static mxtl::RefPtr<ExceptionPort> system_exception_port TA_GUARDED(system_excep
 // All jobs and processes are rooted at the |root_job|.
 static mxtl::RefPtr<JobDispatcher> root_job;
 
+// Event signaled by the OOM thread when free memory crosses the pressure
+// watermarks. Handed out by sys_system_get_memory_pressure_event().
+static mxtl::RefPtr<Dispatcher> mem_pressure_event;
+
 // The singleton policy manager, for jobs and processes. This is
 // a magenta internal class (not a dispatcher-derived).
 static PolicyManager* policy_manager;
@@ -122,6 +142,18 @@ static uint32_t GetNewHandleBaseValue(void* addr) TA_REQ(handle_mutex) {
 void internal::TearDownHandle(Handle* handle) TA_EXCL(handle_mutex) {
     uint32_t base_value = handle->base_value();
 
+    // By this point the handle is no longer owned by any process (its
+    // process_id is zero), so no new lock-free lookup can validate it.
+    // Wait for any lookup already inspecting this slot to finish before
+    // destroying it. The barrier pairs with the one in
+    // LookupHandleNoLock(): either the lookup observes the cleared
+    // process_id, or we observe its hazard and wait.
+    smp_mb();
+    for (uint ix = 0; ix != SMP_MAX_CPUS; ++ix) {
+        while (handle_hazards[ix].handle == handle)
+            arch_spinloop_pause();
+    }
+
     // Calling the handle dtor can cause many things to happen, so it is
     // important to call it outside the lock.
     handle->~Handle();
@@ -288,6 +320,42 @@ Handle* MapU32ToHandle(uint32_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
     return handle->base_value() == value ? handle : nullptr;
 }
 
+bool LookupHandleNoLock(uint32_t value, mx_koid_t koid,
+                        mxtl::RefPtr<Dispatcher>* dispatcher,
+                        mx_rights_t* rights) TA_NO_THREAD_SAFETY_ANALYSIS {
+    auto index = value & kHandleIndexMask;
+    auto handle = &reinterpret_cast<Handle*>(handle_arena.start())[index];
+
+    // Racy read of the arena's allocated range: the range only grows, so
+    // the worst case is a false negative that sends the caller down the
+    // locked path.
+    if (!handle_arena.in_range(handle))
+        return false;
+
+    bool ok = false;
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    // Publish the slot we are about to inspect, then validate it. The
+    // barrier pairs with the one in TearDownHandle(): either we observe
+    // the slot already invalidated and fail, or the teardown observes our
+    // hazard and waits, which keeps the slot's dispatcher alive while we
+    // copy it. Slots are never reclaimed or reused while published here.
+    HandleHazard* hazard = &handle_hazards[arch_curr_cpu_num()];
+    hazard->handle = handle;
+    smp_mb();
+
+    if (handle->base_value() == value && handle->process_id() == koid) {
+        *dispatcher = handle->dispatcher();
+        *rights = handle->rights();
+        ok = true;
+    }
+
+    hazard->handle = nullptr;
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return ok;
+}
+
 void internal::DumpHandleTableInfo() {
     AutoLock lock(&handle_mutex);
     handle_arena.Dump();
@@ -323,6 +391,10 @@ mxtl::RefPtr<JobDispatcher> GetRootJobDispatcher() {
     return root_job;
 }
 
+mxtl::RefPtr<Dispatcher> GetMemoryPressureEventDispatcher() {
+    return mem_pressure_event;
+}
+
 PolicyManager* GetSystemPolicyManager() {
     return policy_manager;
 }
@@ -449,6 +521,18 @@ private:
 // Called from a dedicated kernel thread when the system is low on memory.
 static void oom_lowmem(size_t shortfall_bytes) {
     printf("OOM: oom_lowmem(shortfall_bytes=%zu) called\n", shortfall_bytes);
+
+    // First reclaim pages that userspace has marked MX_VMO_OP_DONT_NEED;
+    // only start killing jobs if that doesn't cover the shortfall.
+    const size_t need_pages = shortfall_bytes / PAGE_SIZE + 1;
+    const size_t reclaimed = VmObject::ReclaimDontNeedPages(need_pages);
+    if (reclaimed > 0) {
+        printf("OOM: reclaimed %zu don't-need pages\n", reclaimed);
+        if (reclaimed >= need_pages) {
+            return;
+        }
+    }
+
     printf("OOM: Process mapped committed bytes:\n");
     DumpProcessMemoryUsage("OOM:   ", /*min_pages=*/8 * MB / PAGE_SIZE);
     printf("OOM: Finding a job to kill...\n");
@@ -481,7 +565,11 @@ static void oom_lowmem(size_t shortfall_bytes) {
         }
         char name[MX_MAX_NAME_LEN];
         job->get_name(name);
-        printf("OOM:   %s job %6" PRIu64 " '%s'\n", tag, job->get_koid(), name);
+        char size_buf[MAX_FORMAT_SIZE_LEN];
+        format_size(size_buf, sizeof(size_buf),
+                    job->ResidentPages() * PAGE_SIZE);
+        printf("OOM:   %s job %6" PRIu64 " '%s' (%s committed)\n",
+               tag, job->get_koid(), name, size_buf);
         if (kill) {
             // Print the descendants of the job we're about to kill.
             job_printer.reset_counts();
@@ -505,15 +593,62 @@ static void oom_lowmem(size_t shortfall_bytes) {
     });
 }
 
+// Called from the OOM thread when free memory crosses a pressure watermark.
+static void oom_pressure_changed(oom_pressure_level_t level) {
+    if (!mem_pressure_event)
+        return;
+    uint32_t set = 0u;
+    switch (level) {
+    case OOM_PRESSURE_CRITICAL:
+        // LOW stays asserted so that "any pressure" waiters need only
+        // watch one signal.
+        set = MX_MEMORY_PRESSURE_LOW | MX_MEMORY_PRESSURE_CRITICAL;
+        break;
+    case OOM_PRESSURE_LOW:
+        set = MX_MEMORY_PRESSURE_LOW;
+        break;
+    case OOM_PRESSURE_NORMAL:
+        break;
+    }
+    uint32_t clear =
+        (MX_MEMORY_PRESSURE_LOW | MX_MEMORY_PRESSURE_CRITICAL) & ~set;
+    mem_pressure_event->user_signal(clear, set, false);
+}
+
 void magenta_init(uint level) TA_NO_THREAD_SAFETY_ANALYSIS {
     handle_arena.Init("handles", sizeof(Handle), kMaxHandleCount);
     root_job = JobDispatcher::CreateRootJob();
     policy_manager = PolicyManager::Create();
+
+    mxtl::RefPtr<Dispatcher> event;
+    mx_rights_t rights;
+    if (EventDispatcher::Create(0u, &event, &rights) == MX_OK) {
+        mem_pressure_event = mxtl::move(event);
+    } else {
+        printf("OOM: failed to create memory pressure event\n");
+    }
+
     // Be sure to update kernel_cmdline.md if any of these defaults change.
+    const uint64_t redline_mb = cmdline_get_uint64("kernel.oom.redline-mb", 50);
     oom_init(cmdline_get_bool("kernel.oom.enable", true),
              LK_SEC(cmdline_get_uint64("kernel.oom.sleep-sec", 1)),
-             cmdline_get_uint64("kernel.oom.redline-mb", 50) * MB,
+             redline_mb * MB,
              oom_lowmem);
+
+    // Default watermarks leave room between "userspace should shed memory"
+    // and "the kernel starts killing jobs".
+    const uint64_t low_mb =
+        cmdline_get_uint64("kernel.oom.low-mb", 4 * redline_mb);
+    const uint64_t critical_mb =
+        cmdline_get_uint64("kernel.oom.critical-mb", 2 * redline_mb);
+    if (low_mb > critical_mb && critical_mb > 0) {
+        oom_pressure_init(low_mb * MB, critical_mb * MB,
+                          oom_pressure_changed);
+    } else {
+        printf("OOM: bad pressure watermarks (low %" PRIu64 "MB, critical %"
+               PRIu64 "MB); pressure reporting disabled\n",
+               low_mb, critical_mb);
+    }
 }
 
 LK_INIT_HOOK(magenta, magenta_init, LK_INIT_LEVEL_THREADING);
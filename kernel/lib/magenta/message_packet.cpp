@@ -12,7 +12,58 @@
 
 #include <magenta/handle_reaper.h>
 #include <magenta/magenta.h>
+#include <magenta/percpu_slab_cache.h>
 #include <mxcpp/new.h>
+#include <mxtl/slab_allocator.h>
+
+namespace {
+
+// Small messages dominate channel traffic, and under channel-heavy load the
+// heap allocation is a large fraction of the per-message cost. Packet memory
+// for the common sizes is carved from slab allocators instead; anything
+// larger falls back to the heap. Every allocation is prefixed with a header
+// recording where it came from so operator delete can return it.
+enum class AllocClass : uint32_t {
+    kSlabSmall,
+    kSlabMedium,
+    kHeap,
+};
+
+struct MessageMemPrefix {
+    void* base;
+    AllocClass alloc_class;
+};
+static_assert(sizeof(MessageMemPrefix) % 8u == 0u, "");
+
+// Size classes cover the prefix, the MessagePacket, its handle array, and
+// the message data.
+constexpr size_t kSmallAllocSize = 256u;
+constexpr size_t kMediumAllocSize = 2048u;
+
+// Each class is capped at 64 slabs of 16KB (1MB); allocations beyond the
+// cap fall back to the heap rather than failing.
+constexpr size_t kMaxSlabsPerClass = 64u;
+
+struct SmallMessageMem;
+using SmallMemTraits = mxtl::ManualDeleteSlabAllocatorTraits<
+    SmallMessageMem*, mxtl::DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE, mxtl::Mutex,
+    PerCpuSlabCacheTraits>;
+struct SmallMessageMem : public mxtl::SlabAllocated<SmallMemTraits> {
+    alignas(16) char mem[kSmallAllocSize];
+};
+
+struct MediumMessageMem;
+using MediumMemTraits = mxtl::ManualDeleteSlabAllocatorTraits<
+    MediumMessageMem*, mxtl::DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE, mxtl::Mutex,
+    PerCpuSlabCacheTraits>;
+struct MediumMessageMem : public mxtl::SlabAllocated<MediumMemTraits> {
+    alignas(16) char mem[kMediumAllocSize];
+};
+
+mxtl::SlabAllocator<SmallMemTraits> small_mem_allocator(kMaxSlabsPerClass);
+mxtl::SlabAllocator<MediumMemTraits> medium_mem_allocator(kMaxSlabsPerClass);
+
+} // namespace
 
 // static
 mx_status_t MessagePacket::NewPacket(uint32_t data_size, uint32_t num_handles,
@@ -24,17 +75,43 @@ mx_status_t MessagePacket::NewPacket(uint32_t data_size, uint32_t num_handles,
         return MX_ERR_OUT_OF_RANGE;
     }
 
-    // Allocate space for the MessagePacket object followed by num_handles
-    // Handle*s followed by data_size bytes.
-    // TODO(dbort): Use mbuf-style memory for data_size, ideally allocating from
-    // somewhere other than the heap. Lets us better track and isolate channel
-    // memory usage.
-    char* ptr = static_cast<char*>(malloc(sizeof(MessagePacket) +
-                                          num_handles * sizeof(Handle*) +
-                                          data_size));
-    if (ptr == nullptr) {
-        return MX_ERR_NO_MEMORY;
+    // Allocate space for the prefix followed by the MessagePacket object
+    // followed by num_handles Handle*s followed by data_size bytes, from the
+    // smallest size class that fits.
+    const size_t total = sizeof(MessageMemPrefix) + sizeof(MessagePacket) +
+                         num_handles * sizeof(Handle*) + data_size;
+
+    char* start = nullptr;
+    void* base = nullptr;
+    AllocClass alloc_class = AllocClass::kHeap;
+    if (total <= kSmallAllocSize) {
+        SmallMessageMem* mem = small_mem_allocator.New();
+        if (mem != nullptr) {
+            start = mem->mem;
+            base = mem;
+            alloc_class = AllocClass::kSlabSmall;
+        }
+    } else if (total <= kMediumAllocSize) {
+        MediumMessageMem* mem = medium_mem_allocator.New();
+        if (mem != nullptr) {
+            start = mem->mem;
+            base = mem;
+            alloc_class = AllocClass::kSlabMedium;
+        }
     }
+    if (start == nullptr) {
+        start = static_cast<char*>(malloc(total));
+        if (start == nullptr) {
+            return MX_ERR_NO_MEMORY;
+        }
+        base = start;
+        alloc_class = AllocClass::kHeap;
+    }
+
+    auto prefix = reinterpret_cast<MessageMemPrefix*>(start);
+    prefix->base = base;
+    prefix->alloc_class = alloc_class;
+    char* ptr = start + sizeof(MessageMemPrefix);
 
     // The storage space for the Handle*s is not initialized because the only
     // creators of MessagePackets (sys_channel_write and _call) fill that array
@@ -45,6 +122,23 @@ mx_status_t MessagePacket::NewPacket(uint32_t data_size, uint32_t num_handles,
     return MX_OK;
 }
 
+// static
+void MessagePacket::operator delete(void* ptr) {
+    auto prefix = reinterpret_cast<MessageMemPrefix*>(
+        static_cast<char*>(ptr) - sizeof(MessageMemPrefix));
+    switch (prefix->alloc_class) {
+    case AllocClass::kSlabSmall:
+        small_mem_allocator.Delete(static_cast<SmallMessageMem*>(prefix->base));
+        break;
+    case AllocClass::kSlabMedium:
+        medium_mem_allocator.Delete(static_cast<MediumMessageMem*>(prefix->base));
+        break;
+    case AllocClass::kHeap:
+        free(prefix->base);
+        break;
+    }
+}
+
 // static
 mx_status_t MessagePacket::Create(user_ptr<const void> data, uint32_t data_size,
                                   uint32_t num_handles,
@@ -62,6 +156,51 @@ mx_status_t MessagePacket::Create(user_ptr<const void> data, uint32_t data_size,
     return MX_OK;
 }
 
+// static
+mx_status_t MessagePacket::CreateGather(user_ptr<const mx_iovec_t> iov, uint32_t iov_count,
+                                        uint32_t num_handles,
+                                        mxtl::unique_ptr<MessagePacket>* msg) {
+    if (iov_count == 0u || iov_count > MX_IOVEC_MAX) {
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    mx_iovec_t vec[MX_IOVEC_MAX];
+    if (iov.copy_array_from_user(vec, iov_count) != MX_OK) {
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    size_t data_size = 0u;
+    for (uint32_t ix = 0u; ix != iov_count; ++ix) {
+        // Checking each segment first keeps the running sum from wrapping.
+        if (vec[ix].capacity > kMaxMessageSize) {
+            return MX_ERR_OUT_OF_RANGE;
+        }
+        data_size += vec[ix].capacity;
+        if (data_size > kMaxMessageSize) {
+            return MX_ERR_OUT_OF_RANGE;
+        }
+    }
+
+    mx_status_t status = NewPacket(static_cast<uint32_t>(data_size), num_handles, msg);
+    if (status != MX_OK) {
+        return status;
+    }
+
+    char* dst = static_cast<char*>((*msg)->data());
+    for (uint32_t ix = 0u; ix != iov_count; ++ix) {
+        if (vec[ix].capacity == 0u) {
+            continue;
+        }
+        auto src = make_user_ptr(static_cast<const void*>(vec[ix].buffer));
+        if (src.copy_array_from_user(dst, vec[ix].capacity) != MX_OK) {
+            msg->reset();
+            return MX_ERR_INVALID_ARGS;
+        }
+        dst += vec[ix].capacity;
+    }
+    return MX_OK;
+}
+
 // static
 mx_status_t MessagePacket::Create(const void* data, uint32_t data_size,
                                   uint32_t num_handles,
@@ -82,6 +82,11 @@ status_t PciInterruptDispatcher::Create(
 
 status_t PciInterruptDispatcher::InterruptComplete() {
     DEBUG_ASSERT(device_ != nullptr);
+
+    // The bottom half is done; drop the IRQ thread band granted when the
+    // caller entered WaitForInterrupt().
+    thread_set_irq_thread(false);
+
     unsignal();
 
     if (maskable_)
@@ -90,6 +95,11 @@ status_t PciInterruptDispatcher::InterruptComplete() {
     return MX_OK;
 }
 
+status_t PciInterruptDispatcher::SetAffinity(uint32_t cpu_num) {
+    DEBUG_ASSERT(device_ != nullptr);
+    return device_->SetIrqAffinity(irq_id_, cpu_num);
+}
+
 status_t PciInterruptDispatcher::UserSignal() {
     DEBUG_ASSERT(device_ != nullptr);
 
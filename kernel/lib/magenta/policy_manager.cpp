@@ -43,7 +43,9 @@ union Encoding {
         uint64_t new_socket      :  4;
         uint64_t new_fifo        :  4;
         uint64_t new_guest       :  4;
-        uint64_t unused_bits     : 19;
+        uint64_t deadline_sched  :  4;
+        uint64_t cpu_affinity    :  4;
+        uint64_t unused_bits     : 11;
         uint64_t cookie_mode     :  1;  // see kPolicyInCookie.
     };
 
@@ -61,8 +63,10 @@ constexpr uint32_t kPolicyActionValidBits =
 // space of a single uint64_t so the 'union' trick works.
 static_assert(sizeof(Encoding) == sizeof(pol_cookie_t), "bitfield issue");
 
-// Make sure that adding new policies forces updating this file.
-static_assert(MX_POL_MAX == 12u, "please update PolicyManager AddPolicy and QueryBasicPolicy");
+// Make sure that adding new policies forces updating this file. Note that
+// MX_POL_TIMER_SLACK is value-based and applied by JobDispatcher::SetPolicy
+// directly; it is never encoded in the cookie.
+static_assert(MX_POL_MAX == 15u, "please update PolicyManager AddPolicy and QueryBasicPolicy");
 
 PolicyManager* PolicyManager::Create(uint32_t default_action) {
     AllocChecker ac;
@@ -152,6 +156,8 @@ uint32_t PolicyManager::QueryBasicPolicy(pol_cookie_t policy, uint32_t condition
     case MX_POL_NEW_FIFO: return GetEffectiveAction(existing.new_fifo);
     case MX_POL_NEW_GUEST: return GetEffectiveAction(existing.new_guest);
     case MX_POL_VMAR_WX: return GetEffectiveAction(existing.vmar_wx);
+    case MX_POL_DEADLINE_SCHED: return GetEffectiveAction(existing.deadline_sched);
+    case MX_POL_CPU_AFFINITY: return GetEffectiveAction(existing.cpu_affinity);
     default: return MX_POL_ACTION_DENY;
     }
 }
@@ -219,6 +225,12 @@ mx_status_t PolicyManager::AddPartial(uint32_t mode, pol_cookie_t existing_polic
     case MX_POL_NEW_GUEST:
         POLMAN_SET_ENTRY(mode, existing.new_guest, policy, result.new_guest);
         break;
+    case MX_POL_DEADLINE_SCHED:
+        POLMAN_SET_ENTRY(mode, existing.deadline_sched, policy, result.deadline_sched);
+        break;
+    case MX_POL_CPU_AFFINITY:
+        POLMAN_SET_ENTRY(mode, existing.cpu_affinity, policy, result.cpu_affinity);
+        break;
     default:
         return MX_ERR_NOT_SUPPORTED;
     }
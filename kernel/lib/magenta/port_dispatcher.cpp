@@ -21,17 +21,30 @@
 
 #include <kernel/auto_lock.h>
 
-PortPacket::PortPacket() : packet{}, observer(nullptr) {
+static_assert(PortDispatcher::kMaxPacketsPerWait == MX_PORT_MAX_WAIT_PACKETS,
+              "kernel and public batched wait limits must agree");
+
+// Each port gets at most this many slabs worth of pooled ephemeral
+// packets; QueueUser() falls back to the heap beyond that.
+constexpr size_t kPacketPoolMaxSlabs = 4u;
+
+PortPacket::PortPacket(bool pooled) : packet{}, observer(nullptr), pooled(pooled) {
     // Note that packet is initialized to zeros.
 }
 
+// static
+void PortPacket::operator delete(void* ptr) {
+    free(ptr);
+}
+
 PortObserver::PortObserver(uint32_t type, Handle* handle, mxtl::RefPtr<PortDispatcher> port,
                            uint64_t key, mx_signals_t signals)
     : type_(type),
       key_(key),
       trigger_(signals),
       handle_(handle),
-      port_(mxtl::move(port)) {
+      port_(mxtl::move(port)),
+      packet_(false) {
 
     auto& packet = packet_.packet;
     packet.status = MX_OK;
@@ -108,7 +121,8 @@ mx_status_t PortDispatcher::Create(uint32_t options,
 }
 
 PortDispatcher::PortDispatcher(uint32_t /*options*/)
-    : zero_handles_(false) {
+    : zero_handles_(false),
+      packet_allocator_(kPacketPoolMaxSlabs) {
 }
 
 PortDispatcher::~PortDispatcher() {
@@ -138,20 +152,34 @@ void PortDispatcher::on_zero_handles() {
 mx_status_t PortDispatcher::QueueUser(const mx_port_packet_t& packet) {
     canary_.Assert();
 
-    AllocChecker ac;
-    auto port_packet = new (&ac) PortPacket();
-    if (!ac.check())
-        return MX_ERR_NO_MEMORY;
+    // Carve the packet from the per-port pool; fall back to the heap when
+    // the pool is exhausted.
+    PortPacket* port_packet = packet_allocator_.New(true);
+    if (port_packet == nullptr) {
+        AllocChecker ac;
+        port_packet = new (&ac) PortPacket(false);
+        if (!ac.check())
+            return MX_ERR_NO_MEMORY;
+    }
 
     port_packet->packet = packet;
     port_packet->packet.type = MX_PKT_TYPE_USER | PKT_FLAG_EPHEMERAL;
 
     auto status = Queue(port_packet, 0u, 0u);
     if (status < 0)
-        delete port_packet;
+        FreePacket(port_packet);
     return status;
 }
 
+void PortDispatcher::FreePacket(PortPacket* port_packet) {
+    DEBUG_ASSERT(port_packet->type() & PKT_FLAG_EPHEMERAL);
+    if (port_packet->pooled) {
+        packet_allocator_.Delete(port_packet);
+    } else {
+        delete port_packet;
+    }
+}
+
 mx_status_t PortDispatcher::Queue(PortPacket* port_packet,
                                     mx_signals_t observed,
                                     uint64_t count) {
@@ -164,8 +192,14 @@ mx_status_t PortDispatcher::Queue(PortPacket* port_packet,
             return MX_ERR_BAD_STATE;
 
         if (observed) {
-            if (port_packet->InContainer())
+            if (port_packet->InContainer()) {
+                // A repeating packet is already queued; fold the new
+                // observation into it rather than dropping it so that no
+                // signal edges are lost between dequeues.
+                port_packet->packet.signal.observed |= observed;
+                port_packet->packet.signal.count += count;
                 return MX_OK;
+            }
             port_packet->packet.signal.observed = observed;
             port_packet->packet.signal.count = count;
         }
@@ -181,28 +215,49 @@ mx_status_t PortDispatcher::Queue(PortPacket* port_packet,
 }
 
 mx_status_t PortDispatcher::DeQueue(mx_time_t deadline, mx_port_packet_t* packet) {
+    uint32_t actual;
+    return DeQueue(deadline, packet, 1u, &actual);
+}
+
+mx_status_t PortDispatcher::DeQueue(mx_time_t deadline, mx_port_packet_t* packets,
+                                    uint32_t count, uint32_t* actual) {
     canary_.Assert();
+    DEBUG_ASSERT(count >= 1u && count <= kMaxPacketsPerWait);
 
-    PortPacket* port_packet = nullptr;
-    PortObserver* observer = nullptr;
+    PortObserver* observers[kMaxPacketsPerWait];
+    PortPacket* ephemerals[kMaxPacketsPerWait];
 
     while (true) {
+        uint32_t num_observers = 0u;
+        uint32_t num_ephemerals = 0u;
+        uint32_t num_packets = 0u;
         {
             AutoLock al(&lock_);
-            if (packets_.is_empty())
-                goto wait;
-
-            port_packet = packets_.pop_front();
-            observer = CopyLocked(port_packet, packet);
+            while (num_packets < count && !packets_.is_empty()) {
+                PortPacket* port_packet = packets_.pop_front();
+                PortObserver* observer = CopyLocked(
+                    port_packet, packets ? &packets[num_packets] : nullptr);
+                if (observer)
+                    observers[num_observers++] = observer;
+                else if (port_packet->type() & PKT_FLAG_EPHEMERAL)
+                    ephemerals[num_ephemerals++] = port_packet;
+                ++num_packets;
+            }
         }
 
-        if (observer)
-            delete observer;
-        else if (packet && (packet->type & PKT_FLAG_EPHEMERAL))
-            delete port_packet;
-        return MX_OK;
+        if (num_packets > 0u) {
+            // Destroy observers and return ephemeral packets outside the lock.
+            for (uint32_t ix = 0; ix != num_observers; ++ix)
+                delete observers[ix];
+            for (uint32_t ix = 0; ix != num_ephemerals; ++ix)
+                FreePacket(ephemerals[ix]);
+            *actual = num_packets;
+            return MX_OK;
+        }
 
-wait:
+        // The semaphore is posted once per queued packet, so a batched
+        // dequeue can leave it over-counted; treat an immediate wakeup with
+        // an empty queue as spurious and wait again.
         status_t st = sema_.Wait(deadline);
         if (st != MX_OK)
             return st;
@@ -234,6 +289,9 @@ mx_status_t PortDispatcher::MakeObservers(uint32_t options, Handle* handle,
 
     // Called under the handle table lock.
 
+    if ((options != MX_WAIT_ASYNC_ONCE) && (options != MX_WAIT_ASYNC_REPEATING))
+        return MX_ERR_INVALID_ARGS;
+
     auto dispatcher = handle->dispatcher();
     if (!dispatcher->get_state_tracker())
         return MX_ERR_NOT_SUPPORTED;
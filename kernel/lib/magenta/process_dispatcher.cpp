@@ -51,9 +51,12 @@ static mx_handle_t map_handle_to_value(const Handle* handle, mx_handle_t mixer)
     return mixer ^ handle_id;
 }
 
+static uint32_t map_value_to_id(mx_handle_t value, mx_handle_t mixer) {
+    return (value ^ mixer) >> 1;
+}
+
 static Handle* map_value_to_handle(mx_handle_t value, mx_handle_t mixer) {
-    auto handle_id = (value ^ mixer) >> 1;
-    return MapU32ToHandle(handle_id);
+    return MapU32ToHandle(map_value_to_id(value, mixer));
 }
 
 mx_status_t ProcessDispatcher::Create(
@@ -105,6 +108,18 @@ ProcessDispatcher::ProcessDispatcher(mxtl::RefPtr<JobDispatcher> job,
 
     // Handle values cannot be negative values, so we mask the high bit.
     handle_rand_ = (secret << 2) & INT_MAX;
+
+    // Compile the job policy into flat per-condition masks so QueryPolicy
+    // does not consult the PolicyManager on object-creation paths.
+    static_assert(MX_POL_MAX <= 32u, "policy conditions no longer fit the masks");
+    auto pm = GetSystemPolicyManager();
+    for (uint32_t cond = 0u; cond < MX_POL_MAX; ++cond) {
+        uint32_t action = pm->QueryBasicPolicy(policy_, cond);
+        if (action & MX_POL_ACTION_DENY)
+            policy_deny_mask_ |= 1u << cond;
+        if (action & MX_POL_ACTION_EXCEPTION)
+            policy_exception_mask_ |= 1u << cond;
+    }
 }
 
 ProcessDispatcher::~ProcessDispatcher() {
@@ -332,8 +347,10 @@ void ProcessDispatcher::SetStateLocked(State s) {
         }
         LTRACEF_LEVEL(2, "done cleaning up handle table on proc %p\n", this);
 
-        // tear down the address space
-        aspace_->Destroy();
+        // Tear down the address space off this (exiting) thread. A large
+        // process can have a lot of mappings and page tables, and unmapping
+        // them synchronously here shows up as a scheduler latency spike.
+        VmAspace::DeferredDestroy(aspace_);
 
         // Send out exception reports before signalling MX_TASK_TERMINATED,
         // the theory being that marking the process as terminated is the
@@ -450,6 +467,17 @@ mx_koid_t ProcessDispatcher::GetKoidForHandle(mx_handle_t handle_value) {
 mx_status_t ProcessDispatcher::GetDispatcherInternal(mx_handle_t handle_value,
                                                      mxtl::RefPtr<Dispatcher>* dispatcher,
                                                      mx_rights_t* rights) {
+    // Fast path: see GetDispatcherWithRightsInternal().
+    mxtl::RefPtr<Dispatcher> fast_dispatcher;
+    mx_rights_t fast_rights;
+    if (LookupHandleNoLock(map_value_to_id(handle_value, handle_rand_), get_koid(),
+                           &fast_dispatcher, &fast_rights)) {
+        *dispatcher = mxtl::move(fast_dispatcher);
+        if (rights)
+            *rights = fast_rights;
+        return MX_OK;
+    }
+
     AutoLock lock(&handle_table_lock_);
     Handle* handle = GetHandleLocked(handle_value);
     if (!handle)
@@ -465,6 +493,22 @@ mx_status_t ProcessDispatcher::GetDispatcherWithRightsInternal(mx_handle_t handl
                                                                mx_rights_t desired_rights,
                                                                mxtl::RefPtr<Dispatcher>* dispatcher_out,
                                                                mx_rights_t* out_rights) {
+    // Fast path: resolve the handle without taking the handle table lock.
+    // Any failure (including a plain bad handle) falls through to the
+    // locked path, which gives the authoritative answer and applies the
+    // bad-handle policy.
+    mxtl::RefPtr<Dispatcher> fast_dispatcher;
+    mx_rights_t fast_rights;
+    if (LookupHandleNoLock(map_value_to_id(handle_value, handle_rand_), get_koid(),
+                           &fast_dispatcher, &fast_rights)) {
+        if ((fast_rights & desired_rights) != desired_rights)
+            return MX_ERR_ACCESS_DENIED;
+        *dispatcher_out = mxtl::move(fast_dispatcher);
+        if (out_rights)
+            *out_rights = fast_rights;
+        return MX_OK;
+    }
+
     AutoLock lock(&handle_table_lock_);
     Handle* handle = GetHandleLocked(handle_value);
     if (!handle)
@@ -727,16 +771,6 @@ mx_status_t ProcessDispatcher::set_debug_addr(uintptr_t addr) {
     return MX_OK;
 }
 
-mx_status_t ProcessDispatcher::QueryPolicy(uint32_t condition) const {
-    auto action = GetSystemPolicyManager()->QueryBasicPolicy(policy_, condition);
-    if (action & MX_POL_ACTION_EXCEPTION) {
-        thread_signal_policy_exception();
-    }
-    // TODO(cpu): check for the MX_POL_KILL bit and return an error code
-    // that sysgen understands as termination.
-    return (action & MX_POL_ACTION_DENY) ? MX_ERR_ACCESS_DENIED : MX_OK;
-}
-
 uintptr_t ProcessDispatcher::cache_vdso_code_address() {
     AutoLock a(&state_lock_);
     vdso_code_address_ = aspace_->vdso_code_address();
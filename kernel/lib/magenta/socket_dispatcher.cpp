@@ -26,6 +26,40 @@
 
 #define LOCAL_TRACE 0
 
+namespace {
+
+// Tracks progress through a gather write's user segments across mbuf
+// fills. The caller never asks for more bytes than the segments hold.
+struct GatherCursor {
+    const mx_iovec_t* vec;
+    uint32_t vec_count;
+    uint32_t seg = 0u;
+    size_t seg_off = 0u;
+
+    // Copies |len| user bytes to |dst|, advancing the cursor.
+    mx_status_t Copy(void* dst, size_t len) {
+        char* out = static_cast<char*>(dst);
+        while (len > 0u) {
+            DEBUG_ASSERT(seg < vec_count);
+            if (seg_off == vec[seg].capacity) {
+                seg++;
+                seg_off = 0u;
+                continue;
+            }
+            size_t copy_len = MIN(len, vec[seg].capacity - seg_off);
+            auto src = make_user_ptr(static_cast<const void*>(vec[seg].buffer));
+            if (src.byte_offset(seg_off).copy_array_from_user(out, copy_len) != MX_OK)
+                return MX_ERR_INVALID_ARGS;
+            seg_off += copy_len;
+            out += copy_len;
+            len -= copy_len;
+        }
+        return MX_OK;
+    }
+};
+
+} // namespace
+
 size_t SocketDispatcher::MBuf::rem() const {
     return kMBufDataSize - (off_ + len_);
 }
@@ -60,6 +94,20 @@ status_t SocketDispatcher::Create(uint32_t flags,
     if ((status = socket1->Init(socket0)) != MX_OK)
         return status;
 
+    if (flags == MX_SOCKET_SHARED) {
+        // One VMO holds both directions' rings: socket0 receives in the
+        // first half, socket1 in the second.
+        mxtl::RefPtr<VmObject> vmo;
+        status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY,
+                                       2u * MX_SOCKET_SHARED_RING_SIZE, &vmo);
+        if (status != MX_OK)
+            return status;
+        socket0->ring_vmo_ = vmo;
+        socket0->ring_rx_offset_ = 0u;
+        socket1->ring_vmo_ = mxtl::move(vmo);
+        socket1->ring_rx_offset_ = MX_SOCKET_SHARED_RING_SIZE;
+    }
+
     *rights = MX_DEFAULT_SOCKET_RIGHTS;
     *dispatcher0 = mxtl::RefPtr<Dispatcher>(socket0.get());
     *dispatcher1 = mxtl::RefPtr<Dispatcher>(socket1.get());
@@ -87,12 +135,25 @@ SocketDispatcher::~SocketDispatcher() {
 mx_status_t SocketDispatcher::Init(mxtl::RefPtr<SocketDispatcher> other) TA_NO_THREAD_SAFETY_ANALYSIS {
     other_ = mxtl::move(other);
     peer_koid_ = other_->get_koid();
-    if (flags_ != MX_SOCKET_STREAM && flags_ != MX_SOCKET_DATAGRAM) {
+    if (flags_ != MX_SOCKET_STREAM && flags_ != MX_SOCKET_DATAGRAM &&
+        flags_ != MX_SOCKET_SHARED) {
         return MX_ERR_INVALID_ARGS;
     }
     return MX_OK;
 }
 
+mx_status_t SocketDispatcher::GetSharedRing(mxtl::RefPtr<VmObject>* vmo, uint64_t* tx_offset) {
+    canary_.Assert();
+
+    if (!is_shared())
+        return MX_ERR_NOT_SUPPORTED;
+
+    *vmo = ring_vmo_;
+    // Our transmit ring is the peer's receive ring.
+    *tx_offset = (ring_rx_offset_ == 0u) ? MX_SOCKET_SHARED_RING_SIZE : 0u;
+    return MX_OK;
+}
+
 void SocketDispatcher::on_zero_handles() {
     canary_.Assert();
 
@@ -183,22 +244,90 @@ mx_status_t SocketDispatcher::Write(user_ptr<const void> src, size_t len,
         other = other_;
     }
 
-    if (len == 0) {
+    if (len == 0 && !is_shared()) {
         *nwritten = 0;
         return MX_OK;
     }
     if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
         return MX_ERR_INVALID_ARGS;
 
-    return other->WriteSelf(src, len, nwritten);
+    const mx_iovec_t vec = { const_cast<void*>(src.get()), len };
+    return other->WriteSelf(&vec, 1u, len, nwritten);
 }
 
-mx_status_t SocketDispatcher::WriteSelf(user_ptr<const void> src, size_t len,
-                                        size_t* written) {
+mx_status_t SocketDispatcher::WriteGather(user_ptr<const mx_iovec_t> iov,
+                                          uint32_t iov_count, size_t* nwritten) {
+    canary_.Assert();
+
+    if (iov_count == 0u || iov_count > MX_IOVEC_MAX)
+        return MX_ERR_INVALID_ARGS;
+    if (is_shared())
+        return MX_ERR_NOT_SUPPORTED;
+
+    mx_iovec_t vec[MX_IOVEC_MAX];
+    if (iov.copy_array_from_user(vec, iov_count) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    size_t len = 0u;
+    for (uint32_t ix = 0u; ix != iov_count; ++ix) {
+        // Checking each segment first keeps the running sum from wrapping.
+        if (vec[ix].capacity != static_cast<size_t>(static_cast<uint32_t>(vec[ix].capacity)))
+            return MX_ERR_INVALID_ARGS;
+        len += vec[ix].capacity;
+        if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
+            return MX_ERR_INVALID_ARGS;
+    }
+
+    mxtl::RefPtr<SocketDispatcher> other;
+    {
+        AutoLock lock(&lock_);
+        if (!other_)
+            return MX_ERR_PEER_CLOSED;
+        if (half_closed_[0])
+            return MX_ERR_BAD_STATE;
+        other = other_;
+    }
+
+    if (len == 0u) {
+        *nwritten = 0;
+        return MX_OK;
+    }
+
+    return other->WriteSelf(vec, iov_count, len, nwritten);
+}
+
+mx_status_t SocketDispatcher::WriteSelf(const mx_iovec_t* vec, uint32_t vec_count,
+                                        size_t len, size_t* written) {
     canary_.Assert();
 
     AutoLock lock(&lock_);
 
+    if (is_shared()) {
+        // The producer has already placed the bytes in its transmit ring
+        // through its mapping; just advance the producer index for our
+        // receive ring. A len of zero queries the space left.
+        const size_t space =
+            MX_SOCKET_SHARED_RING_SIZE - static_cast<size_t>(ring_head_ - ring_tail_);
+        if (len == 0u) {
+            *written = space;
+            return MX_OK;
+        }
+        if (space == 0u)
+            return MX_ERR_SHOULD_WAIT;
+
+        bool was_empty = (ring_head_ == ring_tail_);
+        size_t st = MIN(len, space);
+        ring_head_ += st;
+
+        if (was_empty)
+            state_tracker_.UpdateState(0u, MX_SOCKET_READABLE);
+        if (ring_head_ - ring_tail_ == MX_SOCKET_SHARED_RING_SIZE)
+            other_->state_tracker_.UpdateState(MX_SOCKET_WRITABLE, 0u);
+
+        *written = st;
+        return MX_OK;
+    }
+
     if (is_full())
         return MX_ERR_SHOULD_WAIT;
 
@@ -207,9 +336,9 @@ mx_status_t SocketDispatcher::WriteSelf(user_ptr<const void> src, size_t len,
     size_t st = 0u;
     mx_status_t status;
     if (flags_ == MX_SOCKET_DATAGRAM) {
-        status = WriteDgramMBufsLocked(src, len, &st);
+        status = WriteDgramMBufsLocked(vec, vec_count, len, &st);
     } else {
-        status = WriteStreamMBufsLocked(src, len, &st);
+        status = WriteStreamMBufsLocked(vec, vec_count, len, &st);
     }
     if (status)
         return status;
@@ -226,7 +355,8 @@ mx_status_t SocketDispatcher::WriteSelf(user_ptr<const void> src, size_t len,
     return status;
 }
 
-mx_status_t SocketDispatcher::WriteDgramMBufsLocked(user_ptr<const void> src,
+mx_status_t SocketDispatcher::WriteDgramMBufsLocked(const mx_iovec_t* vec,
+                                                    uint32_t vec_count,
                                                     size_t len, size_t* written) {
     if (len + size_ > kSocketSizeMax)
         return MX_ERR_SHOULD_WAIT;
@@ -242,10 +372,11 @@ mx_status_t SocketDispatcher::WriteDgramMBufsLocked(user_ptr<const void> src,
         bufs.push_front(buf);
     }
 
+    GatherCursor cursor = { vec, vec_count };
     size_t pos = 0;
     for (auto& buf : bufs) {
         size_t copy_len = MIN(kMBufDataSize, len - pos);
-        if (src.byte_offset(pos).copy_array_from_user(buf.data_, copy_len) != MX_OK) {
+        if (cursor.Copy(buf.data_, copy_len) != MX_OK) {
             while (!bufs.is_empty())
                 FreeMBuf(bufs.pop_front());
             return MX_ERR_INVALID_ARGS; // Bad user buffer.
@@ -272,7 +403,8 @@ mx_status_t SocketDispatcher::WriteDgramMBufsLocked(user_ptr<const void> src,
     return MX_OK;
 }
 
-mx_status_t SocketDispatcher::WriteStreamMBufsLocked(user_ptr<const void> src,
+mx_status_t SocketDispatcher::WriteStreamMBufsLocked(const mx_iovec_t* vec,
+                                                     uint32_t vec_count,
                                                      size_t len, size_t* written) {
     if (head_ == nullptr) {
         head_ = AllocMBuf();
@@ -281,6 +413,7 @@ mx_status_t SocketDispatcher::WriteStreamMBufsLocked(user_ptr<const void> src,
         tail_.push_front(head_);
     }
 
+    GatherCursor cursor = { vec, vec_count };
     size_t pos = 0;
     while (pos < len) {
         if (head_->rem() == 0) {
@@ -297,7 +430,7 @@ mx_status_t SocketDispatcher::WriteStreamMBufsLocked(user_ptr<const void> src,
             if (copy_len == 0)
                 break;
         }
-        if (src.byte_offset(pos).copy_array_from_user(dst, copy_len) != MX_OK)
+        if (cursor.Copy(dst, copy_len) != MX_OK)
             break;
         pos += copy_len;
         head_->len_ += static_cast<uint32_t>(copy_len);
@@ -317,17 +450,42 @@ mx_status_t SocketDispatcher::Read(user_ptr<void> dst, size_t len,
 
     AutoLock lock(&lock_);
 
+    if (len != (size_t)((uint32_t)len))
+        return MX_ERR_INVALID_ARGS;
+
+    bool closed = half_closed_[1] || !other_;
+
+    if (is_shared()) {
+        // The consumer pulls the bytes out of our receive ring through its
+        // mapping; just advance the consumer index. A null |dst| with a
+        // len of zero queries the bytes outstanding.
+        const size_t avail = static_cast<size_t>(ring_head_ - ring_tail_);
+        if (!dst && len == 0) {
+            *nread = avail;
+            return MX_OK;
+        }
+        if (avail == 0u)
+            return closed ? MX_ERR_PEER_CLOSED : MX_ERR_SHOULD_WAIT;
+
+        bool was_full = (avail == MX_SOCKET_SHARED_RING_SIZE);
+        size_t st = MIN(len, avail);
+        ring_tail_ += st;
+
+        if (ring_head_ == ring_tail_)
+            state_tracker_.UpdateState(MX_SOCKET_READABLE, 0u);
+        if (!closed && was_full)
+            other_->state_tracker_.UpdateState(0u, MX_SOCKET_WRITABLE);
+
+        *nread = st;
+        return MX_OK;
+    }
+
     // Just query for bytes outstanding.
     if (!dst && len == 0) {
         *nread = size_;
         return MX_OK;
     }
 
-    if (len != (size_t)((uint32_t)len))
-        return MX_ERR_INVALID_ARGS;
-
-    bool closed = half_closed_[1] || !other_;
-
     if (is_empty())
         return closed ? MX_ERR_PEER_CLOSED : MX_ERR_SHOULD_WAIT;
 
@@ -348,6 +506,65 @@ mx_status_t SocketDispatcher::Read(user_ptr<void> dst, size_t len,
     return MX_OK;
 }
 
+mx_status_t SocketDispatcher::ReadBatch(user_ptr<void> dst, size_t len,
+                                        size_t* nread) {
+    canary_.Assert();
+
+    if (flags_ != MX_SOCKET_DATAGRAM)
+        return MX_ERR_NOT_SUPPORTED;
+
+    AutoLock lock(&lock_);
+
+    if (len != (size_t)((uint32_t)len))
+        return MX_ERR_INVALID_ARGS;
+
+    bool closed = half_closed_[1] || !other_;
+
+    if (is_empty())
+        return closed ? MX_ERR_PEER_CLOSED : MX_ERR_SHOULD_WAIT;
+
+    // Unlike the plain read, a batch read never truncates: a packet is
+    // copied out whole, with its length header, or left queued. Reject
+    // outright if not even the front packet fits, so the caller can tell
+    // an undersized buffer from an empty socket.
+    if (len < sizeof(uint32_t) + tail_.front().pkt_len_)
+        return MX_ERR_BUFFER_TOO_SMALL;
+
+    bool was_full = is_full();
+
+    size_t pos = 0;
+    while (!is_empty()) {
+        const uint32_t pkt_len = tail_.front().pkt_len_;
+        if (pos + sizeof(uint32_t) + pkt_len > len)
+            break;
+        if (dst.byte_offset(pos).reinterpret<uint32_t>().copy_to_user(pkt_len) != MX_OK) {
+            if (pos == 0)
+                return MX_ERR_INVALID_ARGS;
+            break;
+        }
+        auto copied = ReadMBufsLocked(dst.byte_offset(pos + sizeof(uint32_t)), pkt_len);
+        if (copied < pkt_len) {
+            // The user buffer faulted partway through the payload; patch
+            // the header to match what actually landed so the records
+            // already written stay parseable.
+            dst.byte_offset(pos).reinterpret<uint32_t>().copy_to_user(
+                static_cast<uint32_t>(copied));
+            pos += sizeof(uint32_t) + copied;
+            break;
+        }
+        pos += sizeof(uint32_t) + pkt_len;
+    }
+
+    if (is_empty())
+        state_tracker_.UpdateState(MX_SOCKET_READABLE, 0u);
+
+    if (!closed && was_full && (pos > 0))
+        other_->state_tracker_.UpdateState(0u, MX_SOCKET_WRITABLE);
+
+    *nread = pos;
+    return MX_OK;
+}
+
 size_t SocketDispatcher::ReadMBufsLocked(user_ptr<void> dst, size_t len) {
     size_t pos = 0;
     while (pos < len && !tail_.is_empty()) {
@@ -9,27 +9,40 @@
 #include <kernel/auto_lock.h>
 #include <magenta/wait_event.h>
 
-namespace {
+uint32_t StateTracker::BucketFor(mx_signals_t watched) {
+    // Group observers by the lowest signal they watch so that the common
+    // fanout case (many observers watching the same signal on one object)
+    // lands them in the same bucket and keeps the other buckets' interest
+    // unions narrow.
+    if (watched == 0u)
+        return 0u;
+    return static_cast<uint32_t>(__builtin_ctz(watched)) % kNumObserverBuckets;
+}
 
 template <typename Func>
-StateObserver::Flags CancelWithFunc(StateTracker::ObserverList* observers, Mutex* observer_lock, Func f) {
+StateObserver::Flags StateTracker::CancelWithFunc(Func f) {
     StateObserver::Flags flags = 0;
 
-    StateTracker::ObserverList obs_to_remove;
+    ObserverList obs_to_remove;
 
     {
-        AutoLock lock(observer_lock);
-        for (auto it = observers->begin(); it != observers->end();) {
-            StateObserver::Flags it_flags = f(it.CopyPointer());
-            flags |= it_flags;
-            if (it_flags & StateObserver::kNeedRemoval) {
-                auto to_remove = it;
-                ++it;
-                obs_to_remove.push_back(observers->erase(to_remove));
-            } else {
-                ++it;
+        AutoLock lock(&lock_);
+        for (auto& bucket : buckets_) {
+            for (auto it = bucket.list.begin(); it != bucket.list.end();) {
+                StateObserver::Flags it_flags = f(it.CopyPointer());
+                flags |= it_flags;
+                if (it_flags & StateObserver::kNeedRemoval) {
+                    auto to_remove = it;
+                    ++it;
+                    obs_to_remove.push_back(bucket.list.erase(to_remove));
+                } else {
+                    ++it;
+                }
             }
+            if (bucket.list.is_empty())
+                bucket.interest = 0u;
         }
+        RebuildObservedInterestLocked();
     }
 
     while (!obs_to_remove.is_empty()) {
@@ -40,8 +53,6 @@ StateObserver::Flags CancelWithFunc(StateTracker::ObserverList* observers, Mutex
     return flags & (~StateObserver::kNeedRemoval);
 }
 
-}  // namespace
-
 void StateTracker::AddObserver(StateObserver* observer, const StateObserver::CountInfo* cinfo) {
     canary_.Assert();
     DEBUG_ASSERT(observer != nullptr);
@@ -50,9 +61,23 @@ void StateTracker::AddObserver(StateObserver* observer, const StateObserver::Cou
     {
         AutoLock lock(&lock_);
 
-        flags = observer->OnInitialize(signals_, cinfo);
-        if (!(flags & StateObserver::kNeedRemoval))
-            observers_.push_front(observer);
+        // Publish the observer's interest before reading the signal state.
+        // UpdateState does the converse (state first, interest second), so
+        // whatever the interleaving, either the signaler sees the interest
+        // and takes the locked path or we see its signals here; a wake is
+        // never lost.
+        const mx_signals_t watched = observer->watched_signals();
+        observed_interest_.fetch_or(watched);
+
+        flags = observer->OnInitialize(signals_.load(), cinfo);
+        if (!(flags & StateObserver::kNeedRemoval)) {
+            auto& bucket = buckets_[BucketFor(watched)];
+            bucket.interest |= watched;
+            bucket.list.push_front(observer);
+        } else {
+            // The observer was never inserted; drop its interest again.
+            RebuildObservedInterestLocked();
+        }
     }
     if (flags & StateObserver::kNeedRemoval)
         observer->OnRemoved();
@@ -65,13 +90,24 @@ void StateTracker::RemoveObserver(StateObserver* observer) {
 
     AutoLock lock(&lock_);
     DEBUG_ASSERT(observer != nullptr);
-    observers_.erase(*observer);
+    auto& bucket = buckets_[BucketFor(observer->watched_signals())];
+    bucket.list.erase(*observer);
+    if (bucket.list.is_empty())
+        bucket.interest = 0u;
+    RebuildObservedInterestLocked();
+}
+
+void StateTracker::RebuildObservedInterestLocked() {
+    mx_signals_t interest = 0u;
+    for (const auto& bucket : buckets_)
+        interest |= bucket.interest;
+    observed_interest_.store(interest);
 }
 
 bool StateTracker::Cancel(Handle* handle) {
     canary_.Assert();
 
-    StateObserver::Flags flags = CancelWithFunc(&observers_, &lock_, [handle](StateObserver* obs) {
+    StateObserver::Flags flags = CancelWithFunc([handle](StateObserver* obs) {
         return obs->OnCancel(handle);
     });
 
@@ -84,7 +120,7 @@ bool StateTracker::Cancel(Handle* handle) {
 bool StateTracker::CancelByKey(Handle* handle, const void* port, uint64_t key) {
     canary_.Assert();
 
-    StateObserver::Flags flags = CancelWithFunc(&observers_, &lock_, [handle, port, key](StateObserver* obs) {
+    StateObserver::Flags flags = CancelWithFunc([handle, port, key](StateObserver* obs) {
         return obs->OnCancelByKey(handle, port, key);
     });
 
@@ -98,19 +134,38 @@ void StateTracker::UpdateState(mx_signals_t clear_mask,
                                mx_signals_t set_mask) {
     canary_.Assert();
 
+    // Apply the transition atomically first, then decide whether anyone
+    // needs to hear about it.  AddObserver publishes the observer's interest
+    // before it reads the signal state, so either the interest is visible
+    // below and we take the locked path, or the observer already saw the new
+    // state in OnInitialize.  This lets doorbell-style signalers (eventpairs
+    // with no waiter registered yet, or a signal that is already asserted)
+    // skip the observer lock entirely.
+    mx_signals_t previous_signals = signals_.load();
+    mx_signals_t updated_signals;
+    do {
+        updated_signals = (previous_signals & ~clear_mask) | set_mask;
+        if (updated_signals == previous_signals)
+            return;
+    } while (!signals_.compare_exchange_weak(&previous_signals, updated_signals,
+                                             mxtl::memory_order_seq_cst,
+                                             mxtl::memory_order_seq_cst));
+
+    const mx_signals_t changed = previous_signals ^ updated_signals;
+    if ((observed_interest_.load() & (updated_signals | changed)) == 0u)
+        return;
+
     StateObserver::Flags flags;
     ObserverList obs_to_remove;
 
     {
         AutoLock lock(&lock_);
-        auto previous_signals = signals_;
-        signals_ &= ~clear_mask;
-        signals_ |= set_mask;
-
-        if (previous_signals == signals_)
-            return;
-
-        flags = UpdateInternalLocked(&obs_to_remove, signals_);
+        // Notify with this transition's own result, not a fresh read of the
+        // signal word: a concurrent transition may have already changed it
+        // again, and its notification pass is responsible for that state.
+        // Re-reading here could make both passes observe only the later
+        // word and lose the wake for a signal this transition asserted.
+        flags = UpdateInternalLocked(&obs_to_remove, updated_signals, changed);
     }
 
     while (!obs_to_remove.is_empty()) {
@@ -130,8 +185,8 @@ void StateTracker::StrobeState(mx_signals_t notify_mask) {
     {
         AutoLock lock(&lock_);
         // include currently active signals as well
-        notify_mask |= signals_;
-        flags = UpdateInternalLocked(&obs_to_remove, notify_mask);
+        notify_mask |= signals_.load();
+        flags = UpdateInternalLocked(&obs_to_remove, notify_mask, notify_mask);
     }
 
     while (!obs_to_remove.is_empty()) {
@@ -148,23 +203,31 @@ void StateTracker::UpdateLastHandleSignal(uint32_t* count) {
     if (count == nullptr)
         return;
 
+    // We assume here that the value pointed by |count| can mutate by
+    // other threads.  Same protocol as UpdateState: transition first,
+    // interest check second.
+    const bool last_handle = (*count == 1u);
+    mx_signals_t previous_signals = last_handle ?
+        signals_.fetch_or(MX_SIGNAL_LAST_HANDLE) :
+        signals_.fetch_and(~MX_SIGNAL_LAST_HANDLE);
+    mx_signals_t updated_signals = last_handle ?
+        previous_signals | MX_SIGNAL_LAST_HANDLE :
+        previous_signals & ~MX_SIGNAL_LAST_HANDLE;
+
+    if (previous_signals == updated_signals)
+        return;
+
+    const mx_signals_t changed = previous_signals ^ updated_signals;
+    if ((observed_interest_.load() & (updated_signals | changed)) == 0u)
+        return;
+
     StateObserver::Flags flags = 0;
     ObserverList obs_to_remove;
 
     {
         AutoLock lock(&lock_);
-
-        auto previous_signals = signals_;
-
-        // We assume here that the value pointed by |count| can mutate by
-        // other threads.
-        signals_ = (*count == 1u) ?
-            signals_ | MX_SIGNAL_LAST_HANDLE : signals_ & ~MX_SIGNAL_LAST_HANDLE;
-
-        if (previous_signals == signals_)
-            return;
-
-        flags = UpdateInternalLocked(&obs_to_remove, signals_);
+        // As in UpdateState, deliver this transition's own snapshot.
+        flags = UpdateInternalLocked(&obs_to_remove, updated_signals, changed);
     }
 
     while (!obs_to_remove.is_empty()) {
@@ -219,19 +282,35 @@ mx_status_t StateTracker::InvalidateCookie(CookieJar* cookiejar) {
     return MX_OK;
 }
 
-StateObserver::Flags StateTracker::UpdateInternalLocked(ObserverList* obs_to_remove, mx_signals_t signals) {
+StateObserver::Flags StateTracker::UpdateInternalLocked(ObserverList* obs_to_remove, mx_signals_t signals,
+                                                        mx_signals_t changed) {
     StateObserver::Flags flags = 0;
 
-    for (auto it = observers_.begin(); it != observers_.end();) {
-        StateObserver::Flags it_flags = it->OnStateChange(signals);
-        flags |= it_flags;
-        if (it_flags & StateObserver::kNeedRemoval) {
-            auto to_remove = it;
-            ++it;
-            obs_to_remove->push_back(observers_.erase(to_remove));
-        } else {
-            ++it;
+    // An observer only needs to see this transition if one of its watched
+    // signals is asserted in |signals| or just toggled; for every current
+    // observer type a call outside that set is a no-op.
+    const mx_signals_t relevant = signals | changed;
+
+    for (auto& bucket : buckets_) {
+        if ((bucket.interest & relevant) == 0u)
+            continue;
+        for (auto it = bucket.list.begin(); it != bucket.list.end();) {
+            if ((it->watched_signals() & relevant) == 0u) {
+                ++it;
+                continue;
+            }
+            StateObserver::Flags it_flags = it->OnStateChange(signals);
+            flags |= it_flags;
+            if (it_flags & StateObserver::kNeedRemoval) {
+                auto to_remove = it;
+                ++it;
+                obs_to_remove->push_back(bucket.list.erase(to_remove));
+            } else {
+                ++it;
+            }
         }
+        if (bucket.list.is_empty())
+            bucket.interest = 0u;
     }
 
     // Filter out NeedRemoval flag because we processed that here
@@ -18,6 +18,7 @@
 #include <lib/dpc.h>
 
 #include <kernel/auto_lock.h>
+#include <kernel/sched.h>
 #include <kernel/thread.h>
 #include <kernel/vm.h>
 #include <kernel/vm/vm_aspace.h>
@@ -390,6 +391,37 @@ status_t ThreadDispatcher::Resume() {
     return thread_resume(&thread_);
 }
 
+status_t ThreadDispatcher::SetDeadline(uint64_t capacity_ns, uint64_t deadline_ns,
+                                       uint64_t period_ns) {
+    canary_.Assert();
+
+    LTRACE_ENTRY_OBJ;
+
+    AutoLock lock(&state_lock_);
+
+    LTRACEF("%p: state %s\n", this, StateToString(state_));
+
+    if (state_ != State::RUNNING && state_ != State::SUSPENDED)
+        return MX_ERR_BAD_STATE;
+
+    return sched_set_deadline(&thread_, capacity_ns, deadline_ns, period_ns);
+}
+
+status_t ThreadDispatcher::SetAffinity(uint32_t hard_mask, uint32_t soft_mask) {
+    canary_.Assert();
+
+    LTRACE_ENTRY_OBJ;
+
+    AutoLock lock(&state_lock_);
+
+    LTRACEF("%p: state %s\n", this, StateToString(state_));
+
+    if (state_ != State::RUNNING && state_ != State::SUSPENDED)
+        return MX_ERR_BAD_STATE;
+
+    return sched_set_affinity(&thread_, hard_mask, soft_mask);
+}
+
 static void ThreadCleanupDpc(dpc_t *d) {
     LTRACEF("dpc %p\n", d);
 
@@ -43,6 +43,14 @@ VmObjectDispatcher::~VmObjectDispatcher() {
     // recycled, and it could be a useful breadcrumb.
 }
 
+void VmObjectDispatcher::on_zero_handles() {
+    canary_.Assert();
+
+    // Userspace can no longer reach the VMO through this dispatcher; give
+    // it a chance to flatten itself out of a clone chain.
+    vmo_->OnZeroHandles();
+}
+
 void VmObjectDispatcher::get_name(char out_name[MX_MAX_NAME_LEN]) const {
     canary_.Assert();
     vmo_->get_name(out_name, MX_MAX_NAME_LEN);
@@ -104,6 +112,10 @@ mx_status_t VmObjectDispatcher::RangeOp(uint32_t op, uint64_t offset, uint64_t s
             auto status = vmo_->DecommitRange(offset, size, nullptr);
             return status;
         }
+        case MX_VMO_OP_WILL_NEED:
+            return vmo_->WillNeedRange(offset, size);
+        case MX_VMO_OP_DONT_NEED:
+            return vmo_->DontNeedRange(offset, size);
         case MX_VMO_OP_LOCK:
         case MX_VMO_OP_UNLOCK:
             // TODO: handle
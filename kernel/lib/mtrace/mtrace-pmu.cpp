@@ -0,0 +1,32 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// Control interface for hardware performance counter sampling.
+// The counter deltas flow through the ktrace stream as PMU_SAMPLE
+// records emitted at context switch; this just programs and releases
+// the counters.
+
+#include "lib/mtrace.h"
+
+#include <kernel/pmu.h>
+
+#include <magenta/mtrace.h>
+
+status_t mtrace_pmu_control(uint32_t action, uint32_t options,
+                            void* arg, uint32_t size) {
+    switch (action) {
+    case MTRACE_PMU_START:
+        if (arg != nullptr || size != 0)
+            return MX_ERR_INVALID_ARGS;
+        return pmu_start(options);
+    case MTRACE_PMU_STOP:
+        if (options != 0 || arg != nullptr || size != 0)
+            return MX_ERR_INVALID_ARGS;
+        return pmu_stop();
+    default:
+        return MX_ERR_INVALID_ARGS;
+    }
+}
@@ -0,0 +1,31 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// Control interface for the sampling profiler.
+// The samples themselves flow through the ktrace stream; this just
+// starts and stops the per-cpu sampling timers.
+
+#include "lib/mtrace.h"
+
+#include <kernel/profile.h>
+
+#include <magenta/mtrace.h>
+
+status_t mtrace_profile_control(uint32_t action, uint32_t options,
+                                void* arg, uint32_t size) {
+    switch (action) {
+    case MTRACE_PROFILE_START:
+        if (arg != nullptr || size != 0)
+            return MX_ERR_INVALID_ARGS;
+        return profile_start(options);
+    case MTRACE_PROFILE_STOP:
+        if (options != 0 || arg != nullptr || size != 0)
+            return MX_ERR_INVALID_ARGS;
+        return profile_stop();
+    default:
+        return MX_ERR_INVALID_ARGS;
+    }
+}
@@ -12,6 +12,17 @@
 // redline.
 typedef void(oom_lowmem_callback_t)(size_t shortfall_bytes);
 
+// Memory pressure levels, in increasing order of severity.
+typedef enum oom_pressure_level {
+    OOM_PRESSURE_NORMAL = 0,
+    OOM_PRESSURE_LOW,
+    OOM_PRESSURE_CRITICAL,
+} oom_pressure_level_t;
+
+// Called (from the memory-watcher thread) whenever the amount of free
+// memory crosses a pressure watermark.
+typedef void(oom_pressure_callback_t)(oom_pressure_level_t level);
+
 // Initializes the out-of-memory system. If |enable| is true, starts the
 // memory-watcher thread, which calls |lowmem_callback| when the PMM has less
 // than |redline_bytes| free memory, sleeping for |sleep_duration_ns| between
@@ -21,3 +32,13 @@ typedef void(oom_lowmem_callback_t)(size_t shortfall_bytes);
 // TODO(dbort): Add a programmatic way to start/stop the thread.
 void oom_init(bool enable, uint64_t sleep_duration_ns, size_t redline_bytes,
               oom_lowmem_callback_t* lowmem_callback);
+
+// Enables memory pressure reporting: |pressure_callback| is called whenever
+// the PMM's free memory crosses |low_bytes| (OOM_PRESSURE_LOW) or
+// |critical_bytes| (OOM_PRESSURE_CRITICAL). |low_bytes| must be greater than
+// |critical_bytes|, which should in turn be greater than the redline so that
+// userspace gets a chance to shed memory before the kernel starts killing
+// jobs. Checks happen on the same cadence as the redline check, so this is
+// only useful if the memory-watcher thread is running.
+void oom_pressure_init(size_t low_bytes, size_t critical_bytes,
+                       oom_pressure_callback_t* pressure_callback);
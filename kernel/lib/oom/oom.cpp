@@ -9,6 +9,7 @@
 #include <kernel/thread.h>
 #include <kernel/vm/pmm.h>
 #include <lib/console.h>
+#include <lib/heap.h>
 #include <magenta/errors.h>
 #include <mxtl/auto_lock.h>
 #include <mxtl/mutex.h>
@@ -37,12 +38,35 @@ static uint64_t oom_sleep_duration_ns TA_GUARDED(oom_mutex);
 // If the PMM has fewer than this many bytes free, start killing processes.
 static uint64_t oom_redline_bytes TA_GUARDED(oom_mutex);
 
+// Function to call when free memory crosses a pressure watermark, or
+// nullptr if pressure reporting is disabled.
+static oom_pressure_callback_t* oom_pressure_callback TA_GUARDED(oom_mutex);
+
+// Pressure watermarks; free memory below these means LOW/CRITICAL pressure.
+static uint64_t oom_low_bytes TA_GUARDED(oom_mutex);
+static uint64_t oom_critical_bytes TA_GUARDED(oom_mutex);
+
+// The pressure level reported by the last check.
+static oom_pressure_level_t oom_pressure_level TA_GUARDED(oom_mutex);
+
 // True if the thread should print the current free value when it runs.
 static bool oom_printing TA_GUARDED(oom_mutex);
 
 // True if the thread should simulate a low-memory condition on its next loop.
 static bool oom_simulate_lowmem TA_GUARDED(oom_mutex);
 
+static const char* pressure_level_name(oom_pressure_level_t level) {
+    switch (level) {
+    case OOM_PRESSURE_NORMAL:
+        return "normal";
+    case OOM_PRESSURE_LOW:
+        return "low";
+    case OOM_PRESSURE_CRITICAL:
+        return "critical";
+    }
+    return "unknown";
+}
+
 static int oom_loop(void* arg) {
     const size_t total_bytes = pmm_count_total_bytes();
     char total_buf[MAX_FORMAT_SIZE_LEN];
@@ -56,6 +80,8 @@ static int oom_loop(void* arg) {
         bool printing = false;
         size_t shortfall_bytes = 0;
         oom_lowmem_callback_t* lowmem_callback = nullptr;
+        oom_pressure_callback_t* pressure_callback = nullptr;
+        oom_pressure_level_t pressure_level = OOM_PRESSURE_NORMAL;
         uint64_t sleep_duration_ns = 0;
         {
             AutoLock lock(&oom_mutex);
@@ -74,6 +100,19 @@ static int oom_loop(void* arg) {
             }
             oom_simulate_lowmem = false;
 
+            if (oom_pressure_callback != nullptr) {
+                if (free_bytes < oom_critical_bytes) {
+                    pressure_level = OOM_PRESSURE_CRITICAL;
+                } else if (free_bytes < oom_low_bytes) {
+                    pressure_level = OOM_PRESSURE_LOW;
+                }
+                // Only report transitions.
+                if (pressure_level != oom_pressure_level) {
+                    pressure_callback = oom_pressure_callback;
+                    oom_pressure_level = pressure_level;
+                }
+            }
+
             printing =
                 lowmem || (oom_printing && free_bytes != last_free_bytes);
             lowmem_callback = oom_lowmem_callback;
@@ -102,6 +141,19 @@ static int oom_loop(void* arg) {
         }
         last_free_bytes = free_bytes;
 
+        if (lowmem || pressure_level != OOM_PRESSURE_NORMAL) {
+            // The kernel heap is the kernel's own sheddable memory; give
+            // its fully-free spans back to the PMM before asking anyone
+            // else to let go of theirs.
+            heap_trim();
+        }
+
+        if (pressure_callback != nullptr) {
+            printf("OOM: memory pressure is now %s\n",
+                   pressure_level_name(pressure_level));
+            pressure_callback(pressure_level);
+        }
+
         if (lowmem) {
             lowmem_callback(shortfall_bytes);
         }
@@ -147,6 +199,20 @@ void oom_init(bool enable, uint64_t sleep_duration_ns, size_t redline_bytes,
     }
 }
 
+void oom_pressure_init(size_t low_bytes, size_t critical_bytes,
+                       oom_pressure_callback_t* pressure_callback) {
+    DEBUG_ASSERT(low_bytes > critical_bytes);
+    DEBUG_ASSERT(critical_bytes > 0);
+    DEBUG_ASSERT(pressure_callback != nullptr);
+
+    AutoLock lock(&oom_mutex);
+    DEBUG_ASSERT(oom_pressure_callback == nullptr);
+    oom_pressure_callback = pressure_callback;
+    oom_low_bytes = low_bytes;
+    oom_critical_bytes = critical_bytes;
+    oom_pressure_level = OOM_PRESSURE_NORMAL;
+}
+
 static int cmd_oom(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
         printf("Not enough arguments:\n");
@@ -199,6 +265,19 @@ static int cmd_oom(int argc, const cmd_args* argv, uint32_t flags) {
         char buf[MAX_FORMAT_SIZE_LEN];
         format_size_fixed(buf, sizeof(buf), oom_redline_bytes, 'M');
         printf("  redline: %s (%" PRIu64 " bytes)\n", buf, oom_redline_bytes);
+
+        if (oom_pressure_callback != nullptr) {
+            format_size_fixed(buf, sizeof(buf), oom_low_bytes, 'M');
+            printf("  low watermark: %s (%" PRIu64 " bytes)\n",
+                   buf, oom_low_bytes);
+            format_size_fixed(buf, sizeof(buf), oom_critical_bytes, 'M');
+            printf("  critical watermark: %s (%" PRIu64 " bytes)\n",
+                   buf, oom_critical_bytes);
+            printf("  pressure: %s\n",
+                   pressure_level_name(oom_pressure_level));
+        } else {
+            printf("  pressure: not reported\n");
+        }
     } else if (strcmp(argv[1].str, "print") == 0) {
         oom_printing = !oom_printing;
         printf("OOM print is now %s\n", oom_printing ? "on" : "off");
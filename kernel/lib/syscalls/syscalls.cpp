@@ -73,7 +73,7 @@ extern "C" void arm64_syscall(struct arm64_iframe_long* frame, bool is_64bit, ui
        above CPU_STATS_INC call as it also calls arch_curr_cpu_num. */
     arch_enable_ints();
 
-    LTRACEF_LEVEL(2, "num %" PRIu64 "\n", syscall_num);
+    LTRACEF_LEVEL(2, "num %" PRIu64 " (%s)\n", syscall_num, syscall_name(syscall_num));
 
     /* call the routine */
     uint64_t ret = invoke_syscall(
@@ -114,8 +114,8 @@ inline x86_64_syscall_result do_syscall(uint64_t syscall_num, uint64_t ip,
        above CPU_STATS_INC call as it also calls arch_curr_cpu_num. */
     arch_enable_ints();
 
-    LTRACEF_LEVEL(2, "t %p syscall num %" PRIu64 " ip %#" PRIx64 "\n",
-                  get_current_thread(), syscall_num, ip);
+    LTRACEF_LEVEL(2, "t %p syscall num %" PRIu64 " (%s) ip %#" PRIx64 "\n",
+                  get_current_thread(), syscall_num, syscall_name(syscall_num), ip);
 
     const uintptr_t vdso_code_address =
         ProcessDispatcher::GetCurrent()->vdso_code_address();
@@ -139,6 +139,36 @@ inline x86_64_syscall_result do_syscall(uint64_t syscall_num, uint64_t ip,
     return {ret, thread_is_signaled(get_current_thread())};
 }
 
+// Entry/exit path for syscalls marked 'fastcall' in syscalls.sysgen: tiny
+// hot calls whose fixed cost is dominated by the ktrace records above, so
+// those are skipped (fast calls do not appear in ktrace's syscall stream).
+// The vDSO PC check and the pending-signal check are not optional and stay.
+template <typename T>
+inline x86_64_syscall_result do_fast_syscall(uint64_t syscall_num, uint64_t ip,
+                                             bool (*valid_pc)(uintptr_t), T make_call) {
+    // Needs interrupts disabled for the same arch_curr_cpu_num reason as above.
+    CPU_STATS_INC(syscalls);
+
+    /* re-enable interrupts to maintain kernel preemptiveness */
+    arch_enable_ints();
+
+    const uintptr_t vdso_code_address =
+        ProcessDispatcher::GetCurrent()->vdso_code_address();
+
+    uint64_t ret;
+    if (unlikely(!valid_pc(ip - vdso_code_address))) {
+        ret = sys_invalid_syscall(syscall_num, ip, vdso_code_address);
+    } else {
+        ret = make_call();
+    }
+
+    /* re-disable interrupts on the way out */
+    arch_disable_ints();
+
+    // The assembler caller will re-disable interrupts at the appropriate time.
+    return {ret, thread_is_signaled(get_current_thread())};
+}
+
 x86_64_syscall_result unknown_syscall(uint64_t syscall_num, uint64_t ip) {
     return do_syscall(syscall_num, ip,
                       [](uintptr_t) { return false; },
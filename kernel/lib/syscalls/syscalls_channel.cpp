@@ -22,6 +22,7 @@
 #include <magenta/user_copy.h>
 
 #include <mxtl/algorithm.h>
+#include <mxtl/borrowed.h>
 #include <mxtl/ref_ptr.h>
 
 #include "syscalls_priv.h"
@@ -151,7 +152,7 @@ mx_status_t sys_channel_read(mx_handle_t handle_value, uint32_t options,
 
 static mx_status_t msg_put_handles(ProcessDispatcher* up, MessagePacket* msg, mx_handle_t* handles,
                                    user_ptr<const mx_handle_t> _handles, uint32_t num_handles,
-                                   Dispatcher* channel) {
+                                   mxtl::Borrowed<Dispatcher> channel) {
 
     if (_handles.copy_array_from_user(handles, num_handles) != MX_OK)
         return MX_ERR_INVALID_ARGS;
@@ -166,7 +167,7 @@ static mx_status_t msg_put_handles(ProcessDispatcher* up, MessagePacket* msg, mx
             if (!handle)
                 return MX_ERR_BAD_HANDLE;
 
-            if (handle->dispatcher().get() == channel) {
+            if (handle->dispatcher().get() == channel.get()) {
                 // You may not write a channel endpoint handle
                 // into that channel endpoint
                 return MX_ERR_NOT_SUPPORTED;
@@ -198,36 +199,30 @@ static mx_status_t msg_put_handles(ProcessDispatcher* up, MessagePacket* msg, mx
     return MX_OK;
 }
 
-mx_status_t sys_channel_write(mx_handle_t handle_value, uint32_t options,
-                              user_ptr<const void> _bytes, uint32_t num_bytes,
-                              user_ptr<const mx_handle_t> _handles, uint32_t num_handles) {
-    LTRACEF("handle %x bytes %p num_bytes %u handles %p num_handles %u options 0x%x\n",
-            handle_value, _bytes.get(), num_bytes, _handles.get(), num_handles, options);
-
-    if (options)
-        return MX_ERR_INVALID_ARGS;
-
-    auto up = ProcessDispatcher::GetCurrent();
-
-    mxtl::RefPtr<ChannelDispatcher> channel;
-    mx_status_t result = up->GetDispatcherWithRights(handle_value, MX_RIGHT_WRITE, &channel);
-    if (result != MX_OK)
-        return result;
-
-
+// Sends a single message down |channel|, transferring ownership of the named
+// handles out of this process on success. If |gather| is set, |_bytes| is an
+// array of |num_bytes| mx_iovec_t entries to gather the message from.
+static mx_status_t channel_send_one(ProcessDispatcher* up, mxtl::Borrowed<ChannelDispatcher> channel,
+                                    user_ptr<const void> _bytes, uint32_t num_bytes,
+                                    user_ptr<const mx_handle_t> _handles, uint32_t num_handles,
+                                    bool gather) {
     mxtl::unique_ptr<MessagePacket> msg;
-    result = MessagePacket::Create(_bytes, num_bytes, num_handles, &msg);
+    mx_status_t result = gather
+        ? MessagePacket::CreateGather(_bytes.reinterpret<const mx_iovec_t>(),
+                                      num_bytes, num_handles, &msg)
+        : MessagePacket::Create(_bytes, num_bytes, num_handles, &msg);
     if (result != MX_OK)
         return result;
 
     mx_handle_t handles[kMaxMessageHandles];
     if (num_handles > 0u) {
         result = msg_put_handles(up, msg.get(), handles, _handles, num_handles,
-                                 static_cast<Dispatcher*>(channel.get()));
+                                 channel);
         if (result)
             return result;
     }
 
+    const uint32_t data_size = msg->data_size();
     result = channel->Write(mxtl::move(msg));
     if (result != MX_OK) {
         // Write failed, put back the handles into this process.
@@ -238,10 +233,73 @@ mx_status_t sys_channel_write(mx_handle_t handle_value, uint32_t options,
         return result;
     }
 
-    ktrace(TAG_CHANNEL_WRITE, (uint32_t)channel->get_koid(), num_bytes, num_handles, 0);
+    ktrace(TAG_CHANNEL_WRITE, (uint32_t)channel->get_koid(), data_size, num_handles, 0);
     return MX_OK;
 }
 
+mx_status_t sys_channel_write(mx_handle_t handle_value, uint32_t options,
+                              user_ptr<const void> _bytes, uint32_t num_bytes,
+                              user_ptr<const mx_handle_t> _handles, uint32_t num_handles) {
+    LTRACEF("handle %x bytes %p num_bytes %u handles %p num_handles %u options 0x%x\n",
+            handle_value, _bytes.get(), num_bytes, _handles.get(), num_handles, options);
+
+    if (options & ~MX_CHANNEL_WRITE_GATHER)
+        return MX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ChannelDispatcher> channel;
+    mx_status_t result = up->GetDispatcherWithRights(handle_value, MX_RIGHT_WRITE, &channel);
+    if (result != MX_OK)
+        return result;
+
+    return channel_send_one(up, channel, _bytes, num_bytes, _handles, num_handles,
+                            options & MX_CHANNEL_WRITE_GATHER);
+}
+
+mx_status_t sys_channel_write_multiple(mx_handle_t handle_value, uint32_t options,
+                                       user_ptr<const mx_channel_write_entry_t> _entries,
+                                       uint32_t num_entries,
+                                       user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("handle %x entries %p num_entries %u options 0x%x\n",
+            handle_value, _entries.get(), num_entries, options);
+
+    if (options)
+        return MX_ERR_INVALID_ARGS;
+
+    if (num_entries == 0u || num_entries > MX_CHANNEL_MAX_WRITE_MULTIPLE)
+        return MX_ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ChannelDispatcher> channel;
+    mx_status_t result = up->GetDispatcherWithRights(handle_value, MX_RIGHT_WRITE, &channel);
+    if (result != MX_OK)
+        return result;
+
+    mx_channel_write_entry_t entries[MX_CHANNEL_MAX_WRITE_MULTIPLE];
+    if (_entries.copy_array_from_user(entries, num_entries) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    // Messages are sent in order until the first failure; the entries already
+    // written stay written, so report how far we got alongside the status.
+    uint32_t written = 0;
+    for (; written < num_entries; ++written) {
+        const auto& entry = entries[written];
+        result = channel_send_one(up, channel,
+                                  make_user_ptr(entry.bytes), entry.num_bytes,
+                                  make_user_ptr(entry.handles), entry.num_handles,
+                                  false);
+        if (result != MX_OK)
+            break;
+    }
+
+    if (_actual_entries.copy_to_user(written) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    return (written == num_entries) ? MX_OK : result;
+}
+
 mx_status_t sys_channel_call_noretry(mx_handle_t handle_value, uint32_t options,
                                      mx_time_t deadline,
                                      user_ptr<const mx_channel_call_args_t> _args,
@@ -277,7 +335,7 @@ mx_status_t sys_channel_call_noretry(mx_handle_t handle_value, uint32_t options,
     if (num_handles > 0u) {
         result = msg_put_handles(up, msg.get(), handles,
                                  make_user_ptr<const mx_handle_t>(args.wr_handles), num_handles,
-                                 static_cast<Dispatcher*>(channel.get()));
+                                 channel);
         if (result)
             return result;
     }
@@ -105,6 +105,18 @@ mx_status_t sys_interrupt_signal(mx_handle_t handle_value) {
     return interrupt->UserSignal();
 }
 
+mx_status_t sys_interrupt_set_affinity(mx_handle_t handle_value, uint32_t cpu) {
+    LTRACEF("handle %x cpu %u\n", handle_value, cpu);
+
+    auto up = ProcessDispatcher::GetCurrent();
+    mxtl::RefPtr<InterruptDispatcher> interrupt;
+    mx_status_t status = up->GetDispatcher(handle_value, &interrupt);
+    if (status != MX_OK)
+        return status;
+
+    return interrupt->SetAffinity(cpu);
+}
+
 mx_status_t sys_vmo_create_contiguous(mx_handle_t hrsrc, size_t size,
                                       uint32_t alignment_log2,
                                       user_ptr<mx_handle_t> _out) {
@@ -66,6 +66,17 @@ static mx_status_t guest_set_trap(mx_handle_t guest_handle, mx_trap_address_spac
     return guest->SetTrap(aspace, addr, len, fifo);
 }
 
+static mx_status_t guest_commit(mx_handle_t guest_handle, mx_vaddr_t addr, size_t len) {
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<GuestDispatcher> guest;
+    mx_status_t status = up->GetDispatcherWithRights(guest_handle, MX_RIGHT_WRITE, &guest);
+    if (status != MX_OK)
+        return status;
+
+    return guest->Commit(addr, len);
+}
+
 static mx_status_t vcpu_create(uint32_t options, mx_handle_t guest_handle,
                                const mx_vcpu_create_args_t* args, mx_handle_t* out) {
     auto up = ProcessDispatcher::GetCurrent();
@@ -179,6 +190,17 @@ static mx_status_t vcpu_write_state(mx_handle_t vcpu_handle, const mx_vcpu_state
         return guest_set_trap(handle, trap_args.aspace, trap_args.addr, trap_args.len,
                               trap_args.fifo);
     }
+    case MX_HYPERVISOR_OP_GUEST_COMMIT: {
+        struct {
+            mx_vaddr_t addr;
+            size_t len;
+        } commit_args;
+        if (args_len != sizeof(commit_args))
+            return MX_ERR_INVALID_ARGS;
+        if (args.copy_array_from_user(&commit_args, sizeof(commit_args)) != MX_OK)
+            return MX_ERR_INVALID_ARGS;
+        return guest_commit(handle, commit_args.addr, commit_args.len);
+    }
     case MX_HYPERVISOR_OP_VCPU_CREATE: {
         struct {
             uint32_t options;
@@ -0,0 +1,66 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <magenta/compiler.h>
+#include <magenta/mx-syscall-numbers.h>
+
+#include "syscalls_priv.h"
+
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+#endif
+
+namespace {
+
+// Generated at compile time from syscalls.sysgen: one entry per live
+// syscall number with the name, argument count, and a bitmask of the
+// argument registers that carry handle values (output handles and
+// handle arrays arrive through pointers and are not in the mask).
+struct SyscallDescriptor {
+    const char* name;
+    uint8_t num_args;
+    uint8_t handle_args;
+};
+
+constexpr SyscallDescriptor kSyscallDescriptors[] = {
+#include <magenta/syscall-descriptors.inc>
+};
+
+static_assert(countof(kSyscallDescriptors) == MX_SYS_COUNT,
+              "syscall-descriptors.inc is out of sync with mx-syscall-numbers.h");
+
+} // namespace
+
+const char* syscall_name(uint64_t syscall_num) {
+    if (syscall_num >= countof(kSyscallDescriptors))
+        return "<invalid>";
+    return kSyscallDescriptors[syscall_num].name;
+}
+
+#if WITH_LIB_CONSOLE
+
+static int cmd_syscalls(int argc, const cmd_args* argv, uint32_t flags) {
+    printf("%4s %-32s %4s %s\n", "num", "name", "args", "handle args");
+    for (size_t i = 0; i < countof(kSyscallDescriptors); i++) {
+        const SyscallDescriptor& desc = kSyscallDescriptors[i];
+        printf("%4zu %-32s %4u ", i, desc.name, desc.num_args);
+        for (uint32_t arg = 0; arg < desc.num_args; arg++) {
+            if (desc.handle_args & (1u << arg))
+                printf("%u ", arg);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("syscalls", "dump the syscall descriptor table", &cmd_syscalls)
+STATIC_COMMAND_END(syscalls_info);
+
+#endif // WITH_LIB_CONSOLE
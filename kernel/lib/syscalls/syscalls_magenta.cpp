@@ -246,9 +246,8 @@ mx_status_t sys_cprng_draw(user_ptr<void> _buffer, size_t len, user_ptr<size_t>
     // returns.
     explicit_memory::ZeroDtor<uint8_t> zero_guard(kernel_buf, sizeof(kernel_buf));
 
-    auto prng = crypto::GlobalPRNG::GetInstance();
-    ASSERT(prng->is_thread_safe());
-    prng->Draw(kernel_buf, static_cast<int>(len));
+    // Draws from a per-cpu generator, so concurrent calls don't contend.
+    crypto::GlobalPRNG::Draw(kernel_buf, len);
 
     if (_buffer.copy_array_to_user(kernel_buf, len) != MX_OK)
         return MX_ERR_INVALID_ARGS;
@@ -270,9 +269,7 @@ mx_status_t sys_cprng_add_entropy(user_ptr<const void> _buffer, size_t len) {
     if (_buffer.copy_array_from_user(kernel_buf, len) != MX_OK)
         return MX_ERR_INVALID_ARGS;
 
-    auto prng = crypto::GlobalPRNG::GetInstance();
-    ASSERT(prng->is_thread_safe());
-    prng->AddEntropy(kernel_buf, static_cast<int>(len));
+    crypto::GlobalPRNG::AddEntropy(kernel_buf, len);
 
     return MX_OK;
 }
@@ -6,12 +6,14 @@
 
 #include <err.h>
 #include <inttypes.h>
+#include <string.h>
 #include <trace.h>
 
 #include <kernel/mp.h>
 #include <kernel/stats.h>
 #include <kernel/vm/pmm.h>
 #include <lib/heap.h>
+#include <lib/user_copy/user_batcher.h>
 #include <platform.h>
 
 #include <magenta/diagnostics.h>
@@ -37,10 +39,14 @@ public:
     // If |job| is true, only records job koids; otherwise, only
     // records process koids.
     SimpleJobEnumerator(user_ptr<mx_koid_t> ptr, size_t max, bool jobs)
-        : jobs_(jobs), ptr_(ptr), max_(max) {}
+        : jobs_(jobs), batcher_(ptr, max) {}
+
+    // Push any staged koids out to the caller's buffer; must be called
+    // after the enumeration, before reading get_count().
+    bool Flush() { return batcher_.Flush(); }
 
     size_t get_avail() const { return avail_; }
-    size_t get_count() const { return count_; }
+    size_t get_count() const { return batcher_.written(); }
 
 private:
     bool OnJob(JobDispatcher* job) override {
@@ -59,21 +65,90 @@ private:
 
     bool RecordKoid(mx_koid_t koid) {
         avail_++;
-        if (count_ < max_) {
-            // TODO: accumulate batches and do fewer user copies
-            if (ptr_.copy_array_to_user(&koid, 1, count_) != MX_OK) {
-                return false;
-            }
-            count_++;
+        if (batcher_.has_room() && !batcher_.Append(koid)) {
+            return false;
         }
         return true;
     }
 
     const bool jobs_;
-    const user_ptr<mx_koid_t> ptr_;
-    const size_t max_;
+    user_record_batcher<mx_koid_t> batcher_;
+
+    size_t avail_ = 0;
+};
+
+// Writes one mx_info_task_tree_entry_t per task in a job subtree,
+// including the threads of every process, for MX_INFO_TASK_TREE.
+class TaskTreeEnumerator final : public JobEnumerator {
+public:
+    TaskTreeEnumerator(user_ptr<mx_info_task_tree_entry_t> ptr, size_t max)
+        : batcher_(ptr, max) {}
+
+    // Push any staged entries out to the caller's buffer; must be
+    // called after the enumeration, before reading get_count().
+    bool Flush() { return batcher_.Flush(); }
+
+    size_t get_avail() const { return avail_; }
+    size_t get_count() const { return batcher_.written(); }
+
+    bool OnJob(JobDispatcher* job) override {
+        mx_info_task_tree_entry_t entry = {};
+        entry.koid = job->get_koid();
+        entry.parent_koid = job->get_related_koid();
+        entry.type = MX_OBJ_TYPE_JOB;
+        job->get_name(entry.name);
+        return RecordEntry(&entry);
+    }
+
+    bool OnProcess(ProcessDispatcher* proc) override {
+        mx_info_task_tree_entry_t entry = {};
+        entry.koid = proc->get_koid();
+        entry.parent_koid = proc->get_related_koid();
+        entry.type = MX_OBJ_TYPE_PROCESS;
+        proc->get_name(entry.name);
+        if (!RecordEntry(&entry))
+            return false;
+
+        // Emit the process's threads directly behind it, so that the
+        // whole snapshot keeps pre-order and a single walk of the
+        // records is enough to rebuild the tree. The thread list is as
+        // racy as the rest of the walk; threads that come or go while
+        // we look may be missed.
+        mxtl::Array<mx_koid_t> threads;
+        if (proc->GetThreads(&threads) != MX_OK)
+            return true;
+        for (size_t i = 0; i < threads.size(); i++) {
+            auto thread = proc->LookupThreadById(threads[i]);
+            if (!thread)
+                continue;
+            mx_info_task_tree_entry_t te = {};
+            te.koid = thread->get_koid();
+            te.parent_koid = proc->get_koid();
+            te.type = MX_OBJ_TYPE_THREAD;
+            thread->get_name(te.name);
+            te.runtime = thread->runtime_ns();
+            mx_info_thread_t info = {};
+            if (thread->GetInfoForUserspace(&info) == MX_OK) {
+                te.state = info.state;
+                te.wait_exception_port_type = info.wait_exception_port_type;
+            }
+            if (!RecordEntry(&te))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    bool RecordEntry(const mx_info_task_tree_entry_t* entry) {
+        avail_++;
+        if (batcher_.has_room() && !batcher_.Append(*entry)) {
+            return false;
+        }
+        return true;
+    }
+
+    user_record_batcher<mx_info_task_tree_entry_t> batcher_;
 
-    size_t count_ = 0;
     size_t avail_ = 0;
 };
 
@@ -208,7 +283,8 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
             SimpleJobEnumerator sje(koids, max, topic == MX_INFO_JOB_CHILDREN);
 
             // Don't recurse; we only want the job's direct children.
-            if (!job->EnumerateChildren(&sje, /* recurse */ false)) {
+            if (!job->EnumerateChildren(&sje, /* recurse */ false) ||
+                !sje.Flush()) {
                 // SimpleJobEnumerator only returns false when it can't
                 // write to the user pointer.
                 return MX_ERR_INVALID_ARGS;
@@ -301,6 +377,49 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
             return single_record_result(
                 _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
         }
+        case MX_INFO_JOB_STATS: {
+            // Grab a reference to the dispatcher.
+            mxtl::RefPtr<JobDispatcher> job;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_READ,
+                                                     &job);
+            if (error < 0)
+                return error;
+
+            // Build the info structure.
+            mx_info_job_stats_t info = {};
+
+            auto err = job->GetStats(&info);
+            if (err != MX_OK)
+                return err;
+
+            return single_record_result(
+                _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+        }
+        case MX_INFO_TASK_TREE: {
+            mxtl::RefPtr<JobDispatcher> job;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_ENUMERATE, &job);
+            if (error < 0)
+                return error;
+
+            size_t max = buffer_size / sizeof(mx_info_task_tree_entry_t);
+            auto entries = _buffer.reinterpret<mx_info_task_tree_entry_t>();
+            TaskTreeEnumerator tte(entries, max);
+
+            // The snapshot starts with the job the query was made on, so
+            // a monitor needs no other calls to describe the root.
+            if (!tte.OnJob(job.get()) ||
+                !job->EnumerateChildren(&tte, /* recurse */ true) ||
+                !tte.Flush()) {
+                // TaskTreeEnumerator only returns false when it can't
+                // write to the user pointer.
+                return MX_ERR_INVALID_ARGS;
+            }
+            if (_actual && (_actual.copy_to_user(tte.get_count()) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(tte.get_avail()) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            return MX_OK;
+        }
         case MX_INFO_PROCESS_MAPS: {
             mxtl::RefPtr<ProcessDispatcher> process;
             mx_status_t status =
@@ -482,6 +601,124 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
             return single_record_result(
                 _buffer, buffer_size, _actual, _avail, &stats, sizeof(stats));
         }
+        case MX_INFO_KMEM_ARENAS: {
+            // grab a reference to the dispatcher
+            mxtl::RefPtr<ResourceDispatcher> resource;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_NONE, &resource);
+            if (error < 0)
+                return error;
+
+            // TODO: check that this is the root resource
+
+            size_t num_arenas = pmm_arena_count();
+            size_t num_space_for = buffer_size / sizeof(mx_info_kmem_arena_t);
+            size_t num_to_copy = MIN(num_arenas, num_space_for);
+
+            // build an alias to the output buffer that is in units of the arena info structure
+            user_ptr<mx_info_kmem_arena_t> arena_buf(
+                static_cast<mx_info_kmem_arena_t *>(_buffer.get()));
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(num_to_copy); i++) {
+                pmm_arena_stats_t stats;
+                if (pmm_arena_get_stats(i, &stats) != MX_OK)
+                    break;
+
+                mx_info_kmem_arena_t entry = {};
+                static_assert(sizeof(entry.name) >= sizeof(stats.name), "");
+                memcpy(entry.name, stats.name, sizeof(stats.name));
+                entry.numa_node = stats.numa_node;
+                entry.base = stats.base;
+                entry.size_bytes = stats.size;
+                entry.free_bytes = stats.free_bytes;
+                entry.free_runs = stats.free_runs;
+                entry.largest_free_run_bytes = stats.largest_free_run_bytes;
+
+                // copy out one at a time
+                if (arena_buf.copy_array_to_user(&entry, 1, i) != MX_OK)
+                    return MX_ERR_INVALID_ARGS;
+            }
+
+            if (_actual && (_actual.copy_to_user(num_to_copy) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(num_arenas) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            return MX_OK;
+        }
+        case MX_INFO_NUMA_NODES: {
+            // grab a reference to the dispatcher
+            mxtl::RefPtr<ResourceDispatcher> resource;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_NONE, &resource);
+            if (error < 0)
+                return error;
+
+            // TODO: check that this is the root resource
+
+            size_t num_nodes = pmm_numa_node_count();
+            size_t num_space_for = buffer_size / sizeof(mx_info_numa_node_t);
+            size_t num_to_copy = MIN(num_nodes, num_space_for);
+
+            // build an alias to the output buffer that is in units of the node info structure
+            user_ptr<mx_info_numa_node_t> node_buf(static_cast<mx_info_numa_node_t *>(_buffer.get()));
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(num_to_copy); i++) {
+                pmm_numa_node_info_t node_info;
+                pmm_numa_get_node_info(i, &node_info);
+
+                mx_info_numa_node_t entry = {};
+                entry.node_id = i;
+                entry.num_cpus = node_info.num_cpus;
+                entry.mem_bytes = node_info.mem_bytes;
+                entry.free_bytes = node_info.free_bytes;
+
+                // copy out one at a time
+                if (node_buf.copy_array_to_user(&entry, 1, i) != MX_OK)
+                    return MX_ERR_INVALID_ARGS;
+            }
+
+            if (_actual && (_actual.copy_to_user(num_to_copy) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(num_nodes) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            return MX_OK;
+        }
+        case MX_INFO_CPU_TOPOLOGY: {
+            // grab a reference to the dispatcher
+            mxtl::RefPtr<ResourceDispatcher> resource;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_NONE, &resource);
+            if (error < 0)
+                return error;
+
+            // TODO: check that this is the root resource
+
+            size_t num_cpus = arch_max_num_cpus();
+            size_t num_space_for = buffer_size / sizeof(mx_info_cpu_topology_t);
+            size_t num_to_copy = MIN(num_cpus, num_space_for);
+
+            // build an alias to the output buffer that is in units of the topology structure
+            user_ptr<mx_info_cpu_topology_t> topo_buf(
+                static_cast<mx_info_cpu_topology_t *>(_buffer.get()));
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(num_to_copy); i++) {
+                mp_cpu_topology_t topo;
+                mp_get_cpu_topology(i, &topo);
+
+                mx_info_cpu_topology_t entry = {};
+                entry.cpu_number = i;
+                entry.package_id = topo.package_id;
+                entry.core_id = topo.core_id;
+                entry.smt_id = topo.smt_id;
+
+                // copy out one at a time
+                if (topo_buf.copy_array_to_user(&entry, 1, i) != MX_OK)
+                    return MX_ERR_INVALID_ARGS;
+            }
+
+            if (_actual && (_actual.copy_to_user(num_to_copy) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(num_cpus) != MX_OK))
+                return MX_ERR_INVALID_ARGS;
+            return MX_OK;
+        }
         case MX_INFO_RESOURCE: {
             // grab a reference to the dispatcher
             mxtl::RefPtr<ResourceDispatcher> resource;
@@ -113,6 +113,44 @@ mx_status_t sys_port_wait(mx_handle_t handle, mx_time_t deadline,
     return MX_OK;
 }
 
+mx_status_t sys_port_wait_multiple(mx_handle_t handle, mx_time_t deadline,
+                                   user_ptr<mx_port_packet_t> _packets, uint32_t num_packets,
+                                   user_ptr<uint32_t> _actual_packets) {
+    LTRACEF("handle %x num_packets %u\n", handle, num_packets);
+
+    if (num_packets == 0u || num_packets > MX_PORT_MAX_WAIT_PACKETS)
+        return MX_ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<PortDispatcher> port;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_READ, &port);
+    if (status != MX_OK)
+        return status;
+
+    ktrace(TAG_PORT_WAIT, (uint32_t)port->get_koid(), 0, 0, 0);
+
+    mx_port_packet_t pps[MX_PORT_MAX_WAIT_PACKETS];
+    uint32_t actual = 0u;
+    mx_status_t st = port->DeQueue(deadline, pps, num_packets, &actual);
+
+    ktrace(TAG_PORT_WAIT_DONE, (uint32_t)port->get_koid(), st, 0, 0);
+
+    if (st != MX_OK)
+        return st;
+
+    // remove internal flag bits
+    for (uint32_t ix = 0; ix != actual; ++ix)
+        pps[ix].type &= PKT_FLAG_MASK;
+
+    if (_packets.copy_array_to_user(pps, actual) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+    if (_actual_packets.copy_to_user(actual) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    return MX_OK;
+}
+
 mx_status_t sys_port_cancel(mx_handle_t handle, mx_handle_t source, uint64_t key) {
     auto up = ProcessDispatcher::GetCurrent();
 
@@ -12,3 +12,7 @@
 
 #define MX_SYSCALL_PARAM_ATTR(x)
 #include <magenta/syscall-definitions.h>
+
+// Name of a syscall from the generated descriptor table, or "<invalid>"
+// for numbers that are out of range.  See syscalls_info.cpp.
+const char* syscall_name(uint64_t syscall_num);
@@ -20,6 +20,7 @@
 #include <magenta/process_dispatcher.h>
 #include <magenta/socket_dispatcher.h>
 #include <magenta/syscalls/policy.h>
+#include <magenta/vm_object_dispatcher.h>
 
 #include <mxtl/ref_ptr.h>
 
@@ -30,7 +31,8 @@
 mx_status_t sys_socket_create(uint32_t options, user_ptr<mx_handle_t> _out0, user_ptr<mx_handle_t> _out1) {
     LTRACEF("entry out_handles %p, %p\n", _out0.get(), _out1.get());
 
-    if (options != MX_SOCKET_STREAM && options != MX_SOCKET_DATAGRAM)
+    if (options != MX_SOCKET_STREAM && options != MX_SOCKET_DATAGRAM &&
+        options != MX_SOCKET_SHARED)
         return MX_ERR_INVALID_ARGS;
 
     auto up = ProcessDispatcher::GetCurrent();
@@ -69,9 +71,6 @@ mx_status_t sys_socket_write(mx_handle_t handle, uint32_t options,
                              user_ptr<size_t> _actual) {
     LTRACEF("handle %x\n", handle);
 
-    if ((size > 0u) && !_buffer)
-        return MX_ERR_INVALID_ARGS;
-
     auto up = ProcessDispatcher::GetCurrent();
 
     mxtl::RefPtr<SocketDispatcher> socket;
@@ -79,6 +78,10 @@ mx_status_t sys_socket_write(mx_handle_t handle, uint32_t options,
     if (status != MX_OK)
         return status;
 
+    // Shared-ring sockets never copy through |_buffer|, so it may be null.
+    if ((size > 0u) && !_buffer && !socket->is_shared())
+        return MX_ERR_INVALID_ARGS;
+
     switch (options) {
     case 0: {
         size_t nwritten;
@@ -90,6 +93,19 @@ mx_status_t sys_socket_write(mx_handle_t handle, uint32_t options,
 
         return status;
     }
+    case MX_SOCKET_WRITE_GATHER: {
+        // |_buffer| holds |size| mx_iovec_t entries to gather from.
+        if (size > MX_IOVEC_MAX)
+            return MX_ERR_INVALID_ARGS;
+        size_t nwritten;
+        status = socket->WriteGather(_buffer.reinterpret<const mx_iovec_t>(),
+                                     static_cast<uint32_t>(size), &nwritten);
+
+        if (status == MX_OK && _actual)
+            status = _actual.copy_to_user(nwritten);
+
+        return status;
+    }
     case MX_SOCKET_HALF_CLOSE:
         if (size == 0)
             return socket->HalfClose();
@@ -104,10 +120,7 @@ mx_status_t sys_socket_read(mx_handle_t handle, uint32_t options,
                             user_ptr<size_t> _actual) {
     LTRACEF("handle %x\n", handle);
 
-    if (options)
-        return MX_ERR_INVALID_ARGS;
-
-    if (!_buffer && size > 0)
+    if (options & ~MX_SOCKET_READ_BATCH)
         return MX_ERR_INVALID_ARGS;
 
     auto up = ProcessDispatcher::GetCurrent();
@@ -117,8 +130,14 @@ mx_status_t sys_socket_read(mx_handle_t handle, uint32_t options,
     if (status != MX_OK)
         return status;
 
+    // Shared-ring sockets never copy through |_buffer|, so it may be null.
+    if (!_buffer && size > 0 && !socket->is_shared())
+        return MX_ERR_INVALID_ARGS;
+
     size_t nread;
-    status = socket->Read(_buffer, size, &nread);
+    status = (options & MX_SOCKET_READ_BATCH)
+                 ? socket->ReadBatch(_buffer, size, &nread)
+                 : socket->Read(_buffer, size, &nread);
 
     // Caller may ignore results if desired.
     if (status == MX_OK && _actual)
@@ -126,3 +145,46 @@ mx_status_t sys_socket_read(mx_handle_t handle, uint32_t options,
 
     return status;
 }
+
+mx_status_t sys_socket_get_ring(mx_handle_t handle, uint32_t options,
+                                user_ptr<mx_handle_t> _out,
+                                user_ptr<uint64_t> _tx_offset) {
+    LTRACEF("handle %x\n", handle);
+
+    if (options != 0u)
+        return MX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<SocketDispatcher> socket;
+    mx_status_t status =
+        up->GetDispatcherWithRights(handle, MX_RIGHT_READ | MX_RIGHT_WRITE, &socket);
+    if (status != MX_OK)
+        return status;
+
+    mxtl::RefPtr<VmObject> vmo;
+    uint64_t tx_offset;
+    status = socket->GetSharedRing(&vmo, &tx_offset);
+    if (status != MX_OK)
+        return status;
+
+    mxtl::RefPtr<Dispatcher> dispatcher;
+    mx_rights_t rights;
+    status = VmObjectDispatcher::Create(mxtl::move(vmo), &dispatcher, &rights);
+    if (status != MX_OK)
+        return status;
+
+    HandleOwner vmo_handle(MakeHandle(mxtl::move(dispatcher), rights));
+    if (!vmo_handle)
+        return MX_ERR_NO_MEMORY;
+
+    if (_out.copy_to_user(up->MapHandleToValue(vmo_handle)) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    if (_tx_offset.copy_to_user(tx_offset) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    up->AddHandle(mxtl::move(vmo_handle));
+
+    return MX_OK;
+}
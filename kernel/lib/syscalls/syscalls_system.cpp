@@ -14,6 +14,8 @@
 #include <kernel/vm/vm_aspace.h>
 #include <kernel/vm/pmm.h>
 #include <magenta/compiler.h>
+#include <magenta/handle_owner.h>
+#include <magenta/magenta.h>
 #include <magenta/process_dispatcher.h>
 #include <magenta/types.h>
 #include <magenta/vm_object_dispatcher.h>
@@ -325,3 +327,28 @@ mx_status_t sys_system_mexec(mx_handle_t kernel_vmo,
     panic("Execution should never reach here\n");
     return MX_OK;
 }
+
+mx_status_t sys_system_get_memory_pressure_event(mx_handle_t root_resource,
+                                                 user_ptr<mx_handle_t> _out) {
+    mx_status_t status;
+    if ((status = validate_resource(root_resource, MX_RSRC_KIND_ROOT)) < 0)
+        return status;
+
+    mxtl::RefPtr<Dispatcher> event = GetMemoryPressureEventDispatcher();
+    if (!event)
+        return MX_ERR_NOT_SUPPORTED;
+
+    // No MX_RIGHT_WRITE: only the kernel may assert the pressure signals.
+    HandleOwner handle(MakeHandle(mxtl::move(event),
+                                  MX_RIGHT_DUPLICATE | MX_RIGHT_TRANSFER |
+                                      MX_RIGHT_READ));
+    if (!handle)
+        return MX_ERR_NO_MEMORY;
+
+    auto up = ProcessDispatcher::GetCurrent();
+    if (_out.copy_to_user(up->MapHandleToValue(handle)) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    up->AddHandle(mxtl::move(handle));
+    return MX_OK;
+}
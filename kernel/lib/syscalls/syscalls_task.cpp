@@ -237,6 +237,43 @@ mx_status_t sys_thread_set_priority(int32_t prio) {
 #endif
 }
 
+mx_status_t sys_thread_set_deadline(mx_handle_t handle, uint64_t capacity,
+                                    uint64_t deadline, uint64_t period) {
+    LTRACEF("handle %x, capacity %" PRIu64 ", deadline %" PRIu64 ", period %" PRIu64 "\n",
+            handle, capacity, deadline, period);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mx_status_t res = up->QueryPolicy(MX_POL_DEADLINE_SCHED);
+    if (res != MX_OK)
+        return res;
+
+    mxtl::RefPtr<ThreadDispatcher> thread;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_WRITE, &thread);
+    if (status != MX_OK)
+        return status;
+
+    return thread->SetDeadline(capacity, deadline, period);
+}
+
+mx_status_t sys_thread_set_affinity(mx_handle_t handle, uint32_t hard_mask,
+                                    uint32_t soft_mask) {
+    LTRACEF("handle %x, hard_mask %#x, soft_mask %#x\n", handle, hard_mask, soft_mask);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mx_status_t res = up->QueryPolicy(MX_POL_CPU_AFFINITY);
+    if (res != MX_OK)
+        return res;
+
+    mxtl::RefPtr<ThreadDispatcher> thread;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_WRITE, &thread);
+    if (status != MX_OK)
+        return status;
+
+    return thread->SetAffinity(hard_mask, soft_mask);
+}
+
 mx_status_t sys_task_suspend(mx_handle_t task_handle) {
     LTRACE_ENTRY;
 
@@ -390,28 +427,11 @@ void sys_process_exit(int retcode) {
     ProcessDispatcher::GetCurrent()->Exit(retcode);
 }
 
-mx_status_t sys_process_read_memory(mx_handle_t proc, uintptr_t vaddr,
-                                    user_ptr<void> _buffer,
-                                    size_t len, user_ptr<size_t> _actual) {
-    LTRACEF("vaddr 0x%" PRIxPTR ", size %zu\n", vaddr, len);
-
-    if (!_buffer)
-        return MX_ERR_INVALID_ARGS;
-    if (len == 0 || len > kMaxDebugReadBlock)
-        return MX_ERR_INVALID_ARGS;
-
-    auto up = ProcessDispatcher::GetCurrent();
-
-    mxtl::RefPtr<ProcessDispatcher> process;
-    mx_status_t status = up->GetDispatcherWithRights(proc, MX_RIGHT_READ | MX_RIGHT_WRITE,
-                                                     &process);
-    if (status != MX_OK)
-        return status;
-
-    auto aspace = process->aspace();
-    if (!aspace)
-        return MX_ERR_BAD_STATE;
-
+// Transfers one range out of |aspace|, shared by sys_process_read_memory
+// and sys_process_read_memory_vec.
+static mx_status_t process_read_one_range(VmAspace* aspace, uintptr_t vaddr,
+                                          user_ptr<void> _buffer, size_t len,
+                                          size_t* read) {
     auto region = aspace->FindRegion(vaddr);
     if (!region)
         return MX_ERR_NO_MEMORY;
@@ -425,7 +445,6 @@ mx_status_t sys_process_read_memory(mx_handle_t proc, uintptr_t vaddr,
         return MX_ERR_NO_MEMORY;
 
     uint64_t offset = vaddr - vm_mapping->base() + vm_mapping->object_offset();
-    size_t read = 0;
 
     // Force map the range, even if it crosses multiple mappings.
     // TODO(MG-730): This is a workaround for this bug.  If we start decommitting
@@ -434,49 +453,26 @@ mx_status_t sys_process_read_memory(mx_handle_t proc, uintptr_t vaddr,
         uint8_t byte = 0;
         auto int_data = _buffer.reinterpret<uint8_t>();
         for (size_t i = 0; i < len; i += PAGE_SIZE) {
-            status = int_data.copy_array_to_user(&byte, 1, i);
+            mx_status_t status = int_data.copy_array_to_user(&byte, 1, i);
             if (status != MX_OK) {
                 return status;
             }
         }
         if (len > 0) {
-            status = int_data.copy_array_to_user(&byte, 1, len - 1);
+            mx_status_t status = int_data.copy_array_to_user(&byte, 1, len - 1);
             if (status != MX_OK) {
                 return status;
             }
         }
     }
 
-    status_t st = vmo->ReadUser(_buffer, offset, len, &read);
-
-    if (st == MX_OK) {
-        if (_actual.copy_to_user(static_cast<size_t>(read)) != MX_OK)
-            return MX_ERR_INVALID_ARGS;
-    }
-    return st;
+    return vmo->ReadUser(_buffer, offset, len, read);
 }
 
-mx_status_t sys_process_write_memory(mx_handle_t proc, uintptr_t vaddr,
-                                     user_ptr<const void> _buffer,
-                                     size_t len, user_ptr<size_t> _actual) {
-    LTRACEF("vaddr 0x%" PRIxPTR ", size %zu\n", vaddr, len);
-
-    if (!_buffer)
-        return MX_ERR_INVALID_ARGS;
-    if (len == 0 || len > kMaxDebugWriteBlock)
-        return MX_ERR_INVALID_ARGS;
-
-    auto up = ProcessDispatcher::GetCurrent();
-
-    mxtl::RefPtr<ProcessDispatcher> process;
-    mx_status_t status = up->GetDispatcherWithRights(proc, MX_RIGHT_WRITE, &process);
-    if (status != MX_OK)
-        return status;
-
-    auto aspace = process->aspace();
-    if (!aspace)
-        return MX_ERR_BAD_STATE;
-
+// Write-side counterpart of process_read_one_range.
+static mx_status_t process_write_one_range(VmAspace* aspace, uintptr_t vaddr,
+                                           user_ptr<const void> _buffer, size_t len,
+                                           size_t* written) {
     auto region = aspace->FindRegion(vaddr);
     if (!region)
         return MX_ERR_NO_MEMORY;
@@ -496,13 +492,13 @@ mx_status_t sys_process_write_memory(mx_handle_t proc, uintptr_t vaddr,
         uint8_t byte = 0;
         auto int_data = _buffer.reinterpret<const uint8_t>();
         for (size_t i = 0; i < len; i += PAGE_SIZE) {
-            status = int_data.copy_array_from_user(&byte, 1, i);
+            mx_status_t status = int_data.copy_array_from_user(&byte, 1, i);
             if (status != MX_OK) {
                 return status;
             }
         }
         if (len > 0) {
-            status = int_data.copy_array_from_user(&byte, 1, len - 1);
+            mx_status_t status = int_data.copy_array_from_user(&byte, 1, len - 1);
             if (status != MX_OK) {
                 return status;
             }
@@ -510,9 +506,118 @@ mx_status_t sys_process_write_memory(mx_handle_t proc, uintptr_t vaddr,
     }
 
     uint64_t offset = vaddr - vm_mapping->base() + vm_mapping->object_offset();
+
+    return vmo->WriteUser(_buffer, offset, len, written);
+}
+
+mx_status_t sys_process_read_memory(mx_handle_t proc, uintptr_t vaddr,
+                                    user_ptr<void> _buffer,
+                                    size_t len, user_ptr<size_t> _actual) {
+    LTRACEF("vaddr 0x%" PRIxPTR ", size %zu\n", vaddr, len);
+
+    if (!_buffer)
+        return MX_ERR_INVALID_ARGS;
+    if (len == 0 || len > kMaxDebugReadBlock)
+        return MX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ProcessDispatcher> process;
+    mx_status_t status = up->GetDispatcherWithRights(proc, MX_RIGHT_READ | MX_RIGHT_WRITE,
+                                                     &process);
+    if (status != MX_OK)
+        return status;
+
+    auto aspace = process->aspace();
+    if (!aspace)
+        return MX_ERR_BAD_STATE;
+
+    size_t read = 0;
+
+    status_t st = process_read_one_range(aspace.get(), vaddr, _buffer, len, &read);
+
+    if (st == MX_OK) {
+        if (_actual.copy_to_user(static_cast<size_t>(read)) != MX_OK)
+            return MX_ERR_INVALID_ARGS;
+    }
+    return st;
+}
+
+mx_status_t sys_process_read_memory_vec(mx_handle_t proc,
+                                        user_ptr<const mx_process_memory_entry_t> _entries,
+                                        uint32_t num_entries,
+                                        user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("proc %x num_entries %u\n", proc, num_entries);
+
+    if (num_entries == 0u || num_entries > MX_PROCESS_MEMORY_VEC_MAX)
+        return MX_ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ProcessDispatcher> process;
+    mx_status_t status = up->GetDispatcherWithRights(proc, MX_RIGHT_READ | MX_RIGHT_WRITE,
+                                                     &process);
+    if (status != MX_OK)
+        return status;
+
+    auto aspace = process->aspace();
+    if (!aspace)
+        return MX_ERR_BAD_STATE;
+
+    mx_process_memory_entry_t entries[MX_PROCESS_MEMORY_VEC_MAX];
+    if (_entries.copy_array_from_user(entries, num_entries) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    // Ranges are transferred in order until the first failure; a short
+    // transfer counts as one so every completed entry is whole. The
+    // handle, rights and address space are resolved once per batch.
+    uint32_t done = 0;
+    for (; done < num_entries; ++done) {
+        const auto& entry = entries[done];
+        if (entry.buffer == 0u || entry.length == 0u || entry.length > kMaxDebugReadBlock) {
+            status = MX_ERR_INVALID_ARGS;
+            break;
+        }
+        size_t read = 0;
+        status = process_read_one_range(aspace.get(), entry.vaddr,
+                                        make_user_ptr(reinterpret_cast<void*>(entry.buffer)),
+                                        entry.length, &read);
+        if (status == MX_OK && read < entry.length)
+            status = MX_ERR_NO_MEMORY;
+        if (status != MX_OK)
+            break;
+    }
+
+    if (_actual_entries.copy_to_user(done) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    return (done == num_entries) ? MX_OK : status;
+}
+
+mx_status_t sys_process_write_memory(mx_handle_t proc, uintptr_t vaddr,
+                                     user_ptr<const void> _buffer,
+                                     size_t len, user_ptr<size_t> _actual) {
+    LTRACEF("vaddr 0x%" PRIxPTR ", size %zu\n", vaddr, len);
+
+    if (!_buffer)
+        return MX_ERR_INVALID_ARGS;
+    if (len == 0 || len > kMaxDebugWriteBlock)
+        return MX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ProcessDispatcher> process;
+    mx_status_t status = up->GetDispatcherWithRights(proc, MX_RIGHT_WRITE, &process);
+    if (status != MX_OK)
+        return status;
+
+    auto aspace = process->aspace();
+    if (!aspace)
+        return MX_ERR_BAD_STATE;
+
     size_t written = 0;
 
-    status_t st = vmo->WriteUser(_buffer, offset, len, &written);
+    status_t st = process_write_one_range(aspace.get(), vaddr, _buffer, len, &written);
 
     if (st == MX_OK) {
         if (_actual.copy_to_user(static_cast<size_t>(written)) != MX_OK)
@@ -521,6 +626,55 @@ mx_status_t sys_process_write_memory(mx_handle_t proc, uintptr_t vaddr,
     return st;
 }
 
+mx_status_t sys_process_write_memory_vec(mx_handle_t proc,
+                                         user_ptr<const mx_process_memory_entry_t> _entries,
+                                         uint32_t num_entries,
+                                         user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("proc %x num_entries %u\n", proc, num_entries);
+
+    if (num_entries == 0u || num_entries > MX_PROCESS_MEMORY_VEC_MAX)
+        return MX_ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ProcessDispatcher> process;
+    mx_status_t status = up->GetDispatcherWithRights(proc, MX_RIGHT_WRITE, &process);
+    if (status != MX_OK)
+        return status;
+
+    auto aspace = process->aspace();
+    if (!aspace)
+        return MX_ERR_BAD_STATE;
+
+    mx_process_memory_entry_t entries[MX_PROCESS_MEMORY_VEC_MAX];
+    if (_entries.copy_array_from_user(entries, num_entries) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    // Same in-order, whole-entry semantics as the vectored read; the
+    // entries already written stay written.
+    uint32_t done = 0;
+    for (; done < num_entries; ++done) {
+        const auto& entry = entries[done];
+        if (entry.buffer == 0u || entry.length == 0u || entry.length > kMaxDebugWriteBlock) {
+            status = MX_ERR_INVALID_ARGS;
+            break;
+        }
+        size_t written = 0;
+        status = process_write_one_range(aspace.get(), entry.vaddr,
+                                         make_user_ptr(reinterpret_cast<const void*>(entry.buffer)),
+                                         entry.length, &written);
+        if (status == MX_OK && written < entry.length)
+            status = MX_ERR_NO_MEMORY;
+        if (status != MX_OK)
+            break;
+    }
+
+    if (_actual_entries.copy_to_user(done) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    return (done == num_entries) ? MX_OK : status;
+}
+
 // helper routine for sys_task_kill
 template <typename T>
 static mx_status_t kill_task(mxtl::RefPtr<Dispatcher> dispatcher) {
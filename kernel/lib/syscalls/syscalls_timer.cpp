@@ -56,16 +56,19 @@ mx_status_t sys_timer_start(
     if (deadline == 0u)
         return MX_ERR_INVALID_ARGS;
 
-    // TODO(cpu): support timer coalescing (aka slack).
-
     auto up = ProcessDispatcher::GetCurrent();
 
+    // A slack of zero means the caller has no tolerance of its own; fall
+    // back to the default the enclosing job's policy specifies, if any.
+    if (slack == 0u)
+        slack = up->job()->GetTimerSlack();
+
     mxtl::RefPtr<TimerDispatcher> timer;
     mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_WRITE, &timer);
     if (status != MX_OK)
         return status;
 
-    return timer->Set(deadline, period);
+    return timer->Set(deadline, period, slack);
 }
 
 mx_status_t sys_timer_cancel(mx_handle_t handle) {
@@ -15,6 +15,7 @@
 #include <lib/user_copy/user_ptr.h>
 
 #include <magenta/handle_owner.h>
+#include <magenta/job_dispatcher.h>
 #include <magenta/magenta.h>
 #include <magenta/process_dispatcher.h>
 #include <magenta/user_copy.h>
@@ -43,6 +44,11 @@ mx_status_t sys_vmo_create(uint64_t size, uint32_t options, user_ptr<mx_handle_t
     if (res != MX_OK)
         return res;
 
+    // bill the object's pages to the creating process's job
+    auto job = up->job();
+    if (job)
+        vmo->set_page_counter(job->page_counter());
+
     // create a Vm Object dispatcher
     mxtl::RefPtr<Dispatcher> dispatcher;
     mx_rights_t rights;
@@ -63,6 +69,47 @@ mx_status_t sys_vmo_create(uint64_t size, uint32_t options, user_ptr<mx_handle_t
     return MX_OK;
 }
 
+// Force map the range, even if it crosses multiple mappings.
+// TODO(MG-730): This is a workaround for this bug.  If we start decommitting
+// things, the bug will come back.  We should fix this more properly.
+static mx_status_t force_map_for_read(user_ptr<void> _data, size_t len) {
+    uint8_t byte = 0;
+    auto int_data = _data.reinterpret<uint8_t>();
+    for (size_t i = 0; i < len; i += PAGE_SIZE) {
+        mx_status_t status = int_data.copy_array_to_user(&byte, 1, i);
+        if (status != MX_OK) {
+            return status;
+        }
+    }
+    if (len > 0) {
+        mx_status_t status = int_data.copy_array_to_user(&byte, 1, len - 1);
+        if (status != MX_OK) {
+            return status;
+        }
+    }
+    return MX_OK;
+}
+
+// See force_map_for_read; the write variant touches the buffer without
+// modifying it.
+static mx_status_t force_map_for_write(user_ptr<const void> _data, size_t len) {
+    uint8_t byte = 0;
+    auto int_data = _data.reinterpret<const uint8_t>();
+    for (size_t i = 0; i < len; i += PAGE_SIZE) {
+        mx_status_t status = int_data.copy_array_from_user(&byte, 1, i);
+        if (status != MX_OK) {
+            return status;
+        }
+    }
+    if (len > 0) {
+        mx_status_t status = int_data.copy_array_from_user(&byte, 1, len - 1);
+        if (status != MX_OK) {
+            return status;
+        }
+    }
+    return MX_OK;
+}
+
 mx_status_t sys_vmo_read(mx_handle_t handle, user_ptr<void> _data,
                          uint64_t offset, size_t len, user_ptr<size_t> _actual) {
     LTRACEF("handle %x, data %p, offset %#" PRIx64 ", len %#zx\n",
@@ -76,25 +123,9 @@ mx_status_t sys_vmo_read(mx_handle_t handle, user_ptr<void> _data,
     if (status != MX_OK)
         return status;
 
-    // Force map the range, even if it crosses multiple mappings.
-    // TODO(MG-730): This is a workaround for this bug.  If we start decommitting
-    // things, the bug will come back.  We should fix this more properly.
-    {
-        uint8_t byte = 0;
-        auto int_data = _data.reinterpret<uint8_t>();
-        for (size_t i = 0; i < len; i += PAGE_SIZE) {
-            status = int_data.copy_array_to_user(&byte, 1, i);
-            if (status != MX_OK) {
-                return status;
-            }
-        }
-        if (len > 0) {
-            status = int_data.copy_array_to_user(&byte, 1, len - 1);
-            if (status != MX_OK) {
-                return status;
-            }
-        }
-    }
+    status = force_map_for_read(_data, len);
+    if (status != MX_OK)
+        return status;
 
     // do the read operation
     size_t nread;
@@ -118,25 +149,9 @@ mx_status_t sys_vmo_write(mx_handle_t handle, user_ptr<const void> _data,
     if (status != MX_OK)
         return status;
 
-    // Force map the range, even if it crosses multiple mappings.
-    // TODO(MG-730): This is a workaround for this bug.  If we start decommitting
-    // things, the bug will come back.  We should fix this more properly.
-    {
-        uint8_t byte = 0;
-        auto int_data = _data.reinterpret<const uint8_t>();
-        for (size_t i = 0; i < len; i += PAGE_SIZE) {
-            status = int_data.copy_array_from_user(&byte, 1, i);
-            if (status != MX_OK) {
-                return status;
-            }
-        }
-        if (len > 0) {
-            status = int_data.copy_array_from_user(&byte, 1, len - 1);
-            if (status != MX_OK) {
-                return status;
-            }
-        }
-    }
+    status = force_map_for_write(_data, len);
+    if (status != MX_OK)
+        return status;
 
     // do the write operation
     size_t nwritten;
@@ -147,6 +162,90 @@ mx_status_t sys_vmo_write(mx_handle_t handle, user_ptr<const void> _data,
     return status;
 }
 
+mx_status_t sys_vmo_readv(mx_handle_t handle, user_ptr<const mx_vmo_iovec_t> _vec,
+                          size_t vec_count, user_ptr<size_t> _actual) {
+    LTRACEF("handle %x, vec %p, vec_count %zu\n", handle, _vec.get(), vec_count);
+
+    if ((vec_count == 0u) || (vec_count > MX_VMO_IOVEC_MAX))
+        return MX_ERR_INVALID_ARGS;
+
+    mx_vmo_iovec_t vec[MX_VMO_IOVEC_MAX];
+    if (_vec.copy_array_from_user(vec, vec_count) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // lookup the dispatcher from handle; one rights check covers all segments
+    mxtl::RefPtr<VmObjectDispatcher> vmo;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_READ, &vmo);
+    if (status != MX_OK)
+        return status;
+
+    size_t total = 0;
+    for (size_t ix = 0; ix < vec_count; ++ix) {
+        auto _data = make_user_ptr(vec[ix].buffer);
+
+        status = force_map_for_read(_data, vec[ix].capacity);
+        if (status != MX_OK)
+            return status;
+
+        size_t nread;
+        status = vmo->Read(_data, vec[ix].capacity, vec[ix].offset, &nread);
+        if (status != MX_OK)
+            return status;
+
+        total += nread;
+
+        // a short segment means the read ran off the end of the VMO
+        if (nread < vec[ix].capacity)
+            break;
+    }
+
+    return _actual.copy_to_user(total);
+}
+
+mx_status_t sys_vmo_writev(mx_handle_t handle, user_ptr<const mx_vmo_iovec_t> _vec,
+                           size_t vec_count, user_ptr<size_t> _actual) {
+    LTRACEF("handle %x, vec %p, vec_count %zu\n", handle, _vec.get(), vec_count);
+
+    if ((vec_count == 0u) || (vec_count > MX_VMO_IOVEC_MAX))
+        return MX_ERR_INVALID_ARGS;
+
+    mx_vmo_iovec_t vec[MX_VMO_IOVEC_MAX];
+    if (_vec.copy_array_from_user(vec, vec_count) != MX_OK)
+        return MX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // lookup the dispatcher from handle; one rights check covers all segments
+    mxtl::RefPtr<VmObjectDispatcher> vmo;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_WRITE, &vmo);
+    if (status != MX_OK)
+        return status;
+
+    size_t total = 0;
+    for (size_t ix = 0; ix < vec_count; ++ix) {
+        auto _data = make_user_ptr<const void>(vec[ix].buffer);
+
+        status = force_map_for_write(_data, vec[ix].capacity);
+        if (status != MX_OK)
+            return status;
+
+        size_t nwritten;
+        status = vmo->Write(_data, vec[ix].capacity, vec[ix].offset, &nwritten);
+        if (status != MX_OK)
+            return status;
+
+        total += nwritten;
+
+        // a short segment means the write ran off the end of the VMO
+        if (nwritten < vec[ix].capacity)
+            break;
+    }
+
+    return _actual.copy_to_user(total);
+}
+
 mx_status_t sys_vmo_get_size(mx_handle_t handle, user_ptr<uint64_t> _size) {
     LTRACEF("handle %x, sizep %p\n", handle, _size.get());
 
@@ -249,6 +348,11 @@ mx_status_t sys_vmo_clone(mx_handle_t handle, uint32_t options, uint64_t offset,
         DEBUG_ASSERT(clone_vmo);
     }
 
+    // bill any copied pages to the cloning process's job
+    auto job = up->job();
+    if (job)
+        clone_vmo->set_page_counter(job->page_counter());
+
     // create a Vm Object dispatcher
     mxtl::RefPtr<Dispatcher> dispatcher;
     mx_rights_t default_rights;
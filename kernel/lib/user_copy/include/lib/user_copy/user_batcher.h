@@ -0,0 +1,60 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <assert.h>
+#include <lib/user_copy/user_ptr.h>
+#include <stddef.h>
+
+// user_record_batcher<> stages fixed-size records headed for a user
+// array in a small kernel buffer, costing one copy_array_to_user per
+// buffer-full instead of one per record. Enumeration paths that emit
+// many records (job children, task trees, aspace maps) use it to keep
+// large queries single-pass and allocation free.
+//
+// Callers check has_room() before Append()ing and must Flush() after
+// the last record; written() is only meaningful after a successful
+// Flush(). Append() and Flush() return false only when the
+// destination faults, after which the batcher accepts nothing more.
+template <typename T>
+class user_record_batcher {
+public:
+    user_record_batcher(user_ptr<T> dst, size_t max) : dst_(dst), max_(max) {}
+
+    // true while another record fits in the user array
+    bool has_room() const { return written_ + staged_ < max_; }
+
+    bool Append(const T& rec) {
+        DEBUG_ASSERT(has_room());
+        if (staged_ == kBatchRecords && !Flush())
+            return false;
+        buf_[staged_++] = rec;
+        return true;
+    }
+
+    bool Flush() {
+        if (staged_ == 0)
+            return true;
+        if (dst_.copy_array_to_user(buf_, staged_, written_) != MX_OK)
+            return false;
+        written_ += staged_;
+        staged_ = 0;
+        return true;
+    }
+
+    size_t written() const { return written_; }
+
+private:
+    // A fixed 512-byte stage amortizes the user copy well while staying
+    // friendly to kernel stacks.
+    static constexpr size_t kBatchRecords =
+        (512u / sizeof(T)) > 0 ? (512u / sizeof(T)) : 1u;
+
+    T buf_[kBatchRecords];
+    const user_ptr<T> dst_;
+    const size_t max_;
+    size_t written_ = 0;
+    size_t staged_ = 0;
+};
@@ -11,9 +11,17 @@
 // environments.  It must use only the basic types so that struct
 // layouts match exactly in both contexts.
 
-#define VDSO_CONSTANTS_SIZE (4 * 4 + 2 * 8)
+#define VDSO_CONSTANTS_SIZE (8 * 4 + 2 * 8)
 #define VDSO_CONSTANTS_ALIGN 8
 
+// Values for the mono_ticks_source constant, identifying which raw
+// counter (if any) user mode can read to compute MX_CLOCK_MONOTONIC
+// without entering the kernel.
+#define VDSO_TICKS_SOURCE_SYSCALL 0
+#define VDSO_TICKS_SOURCE_TSC 1
+#define VDSO_TICKS_SOURCE_CNTVCT 2
+#define VDSO_TICKS_SOURCE_CNTPCT 3
+
 #ifndef ASSEMBLY
 
 #include <stdint.h>
@@ -34,6 +42,20 @@ struct vdso_constants {
     // Number of bytes in an instruction cache line.
     uint32_t icache_line_size;
 
+    // Which raw counter backs the monotonic clock, if user mode can
+    // read it directly; one of the VDSO_TICKS_SOURCE_* values.  When it
+    // is VDSO_TICKS_SOURCE_SYSCALL the remaining fields below are zero
+    // and mx_time_get always enters the kernel (the kernel only
+    // redirects mx_time_get to the fast path when it isn't).
+    uint32_t mono_ticks_source;
+
+    // The exact ticks->nanoseconds conversion factor the kernel's
+    // monotonic clock uses, as the three words of the kernel's 32.64
+    // fixed point struct fp_32_64 (see lib/fixed_point.h).
+    uint32_t ticks_to_mono_l0;  // integer part
+    uint32_t ticks_to_mono_l32; // bits -1..-32
+    uint32_t ticks_to_mono_l64; // bits -33..-64
+
     // Conversion factor for mx_ticks_get return values to seconds.
     uint64_t ticks_per_second;
 
@@ -12,6 +12,7 @@
 #include <kernel/vm/pmm.h>
 #include <kernel/vm/vm_aspace.h>
 #include <kernel/vm/vm_object.h>
+#include <lib/fixed_point.h>
 #include <mxalloc/new.h>
 #include <mxtl/type_support.h>
 #include <platform.h>
@@ -220,6 +221,29 @@ const VDso* VDso::Create() {
         "vDSO constants", vdso->vmo()->vmo(), VDSO_DATA_CONSTANTS);
     uint64_t per_second = ticks_per_second();
 
+    // Ask the platform whether user mode can read the counter behind
+    // the monotonic clock directly, and with what conversion factor.
+    struct fp_32_64 ticks_to_mono = {};
+    mono_ticks_source_t ticks_source = platform_usermode_ticks_source(&ticks_to_mono);
+    if (cmdline_get_bool("vdso.soft_time_get", false))
+        ticks_source = MONO_TICKS_SYSCALL;
+
+    uint32_t mono_ticks_source = VDSO_TICKS_SOURCE_SYSCALL;
+    switch (ticks_source) {
+    case MONO_TICKS_SYSCALL:
+        ticks_to_mono = {};
+        break;
+    case MONO_TICKS_TSC:
+        mono_ticks_source = VDSO_TICKS_SOURCE_TSC;
+        break;
+    case MONO_TICKS_CNTVCT:
+        mono_ticks_source = VDSO_TICKS_SOURCE_CNTVCT;
+        break;
+    case MONO_TICKS_CNTPCT:
+        mono_ticks_source = VDSO_TICKS_SOURCE_CNTPCT;
+        break;
+    }
+
     // Initialize the constants that should be visible to the vDSO.
     // Rather than assigning each member individually, do this with
     // struct assignment and a compound literal so that the compiler
@@ -228,10 +252,22 @@ const VDso* VDso::Create() {
         arch_max_num_cpus(),
         arch_dcache_line_size(),
         arch_icache_line_size(),
+        mono_ticks_source,
+        ticks_to_mono.l0,
+        ticks_to_mono.l32,
+        ticks_to_mono.l64,
         per_second,
         pmm_count_total_bytes(),
     };
 
+    // With the counter and conversion factor exported, user mode can
+    // compute mx_time_get(MX_CLOCK_MONOTONIC) without entering the
+    // kernel; adjust the entry point accordingly.
+    if (mono_ticks_source != VDSO_TICKS_SOURCE_SYSCALL) {
+        VDsoDynSymWindow dynsym_window(vdso->vmo()->vmo());
+        REDIRECT_SYSCALL(dynsym_window, mx_time_get, fast_monotonic_time_get);
+    }
+
     // If ticks_per_second has not been calibrated, it will return 0. In this
     // case, use soft_ticks instead.
     if (per_second == 0 || cmdline_get_bool("vdso.soft_ticks", false)) {
@@ -392,6 +392,9 @@ static void* allocate_one_stack(void) {
 }
 
 static void platform_cpu_init(void) {
+    // Stage the stacks for every secondary first, then release them all
+    // back to back so they run their early bringup concurrently instead of
+    // each one waiting out the previous cpu's firmware call and allocations.
     for (uint cluster = 0; cluster < cpu_cluster_count; cluster++) {
         for (uint cpu = 0; cpu < cpu_cluster_cpus[cluster]; cpu++) {
             if (cluster != 0 || cpu != 0) {
@@ -401,6 +404,13 @@ static void platform_cpu_init(void) {
                 unsafe_sp = allocate_one_stack();
 #endif
                 arm64_set_secondary_sp(cluster, cpu, sp, unsafe_sp);
+            }
+        }
+    }
+
+    for (uint cluster = 0; cluster < cpu_cluster_count; cluster++) {
+        for (uint cpu = 0; cpu < cpu_cluster_cpus[cluster]; cpu++) {
+            if (cluster != 0 || cpu != 0) {
                 platform_start_cpu(cluster, cpu);
             }
         }
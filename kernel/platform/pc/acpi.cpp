@@ -15,6 +15,8 @@
 #include <lk/init.h>
 
 #include <arch/x86/apic.h>
+#include <arch/x86/mp.h>
+#include <kernel/vm/pmm.h>
 #include <platform/pc/acpi.h>
 
 #define LOCAL_TRACE 0
@@ -307,3 +309,76 @@ status_t platform_find_hpet(struct acpi_hpet_descriptor *hpet)
 
     return MX_OK;
 }
+
+/* @brief Feed the ACPI SRAT topology into the physical allocator
+ *
+ * Tags each pmm arena and cpu with the NUMA proximity domain it belongs to
+ * so the allocator can prefer node local memory. Runs after platform_init()
+ * so the apic id to cpu number mapping is in place; quietly does nothing on
+ * machines without an SRAT.
+ */
+static void platform_init_numa(uint level)
+{
+    ACPI_TABLE_HEADER *table = NULL;
+    ACPI_STATUS status = AcpiGetTable((char *)ACPI_SIG_SRAT, 1, &table);
+    if (status != AE_OK) {
+        LTRACEF("no SRAT found, assuming non-NUMA system\n");
+        return;
+    }
+
+    uintptr_t records_start = ((uintptr_t)table) + sizeof(ACPI_TABLE_SRAT);
+    uintptr_t records_end = ((uintptr_t)table) + table->Length;
+    if (records_start >= records_end) {
+        TRACEF("SRAT wraps around address space\n");
+        return;
+    }
+
+    uintptr_t addr;
+    ACPI_SUBTABLE_HEADER *record_hdr;
+    for (addr = records_start; addr < records_end; addr += record_hdr->Length) {
+        record_hdr = (ACPI_SUBTABLE_HEADER *)addr;
+        switch (record_hdr->Type) {
+            case ACPI_SRAT_TYPE_CPU_AFFINITY: {
+                ACPI_SRAT_CPU_AFFINITY *r = (ACPI_SRAT_CPU_AFFINITY *)record_hdr;
+                if (!(r->Flags & ACPI_SRAT_CPU_ENABLED)) {
+                    break;
+                }
+                uint32_t node = (uint32_t)r->ProximityDomainLo |
+                                ((uint32_t)r->ProximityDomainHi[0] << 8) |
+                                ((uint32_t)r->ProximityDomainHi[1] << 16) |
+                                ((uint32_t)r->ProximityDomainHi[2] << 24);
+                int cpu = x86_apic_id_to_cpu_num(r->ApicId);
+                if (cpu >= 0) {
+                    pmm_numa_set_cpu_node((uint)cpu, node);
+                }
+                break;
+            }
+            case ACPI_SRAT_TYPE_X2APIC_CPU_AFFINITY: {
+                ACPI_SRAT_X2APIC_CPU_AFFINITY *r = (ACPI_SRAT_X2APIC_CPU_AFFINITY *)record_hdr;
+                if (!(r->Flags & ACPI_SRAT_CPU_ENABLED)) {
+                    break;
+                }
+                int cpu = x86_apic_id_to_cpu_num(r->ApicId);
+                if (cpu >= 0) {
+                    pmm_numa_set_cpu_node((uint)cpu, r->ProximityDomain);
+                }
+                break;
+            }
+            case ACPI_SRAT_TYPE_MEMORY_AFFINITY: {
+                ACPI_SRAT_MEM_AFFINITY *r = (ACPI_SRAT_MEM_AFFINITY *)record_hdr;
+                if (!(r->Flags & ACPI_SRAT_MEM_ENABLED)) {
+                    break;
+                }
+                pmm_numa_set_arena_node((paddr_t)r->BaseAddress, (size_t)r->Length,
+                                        r->ProximityDomain);
+                break;
+            }
+        }
+    }
+    if (addr != records_end) {
+        TRACEF("malformed SRAT, ignoring remainder\n");
+    }
+}
+// SRAT parsing is independent of the other platform-level hooks (it only tags
+// pmm arenas and cpus), so let it run concurrently with them.
+LK_INIT_HOOK_PARALLEL(acpi_numa, &platform_init_numa, LK_INIT_LEVEL_PLATFORM);
@@ -16,8 +16,11 @@
 #include <arch/x86.h>
 #include <arch/x86/interrupts.h>
 #include <arch/x86/apic.h>
+#include <arch/x86/mp.h>
 #include <lk/init.h>
 #include <kernel/spinlock.h>
+#include <kernel/tripwire.h>
+#include <lib/ktrace.h>
 #include "platform_p.h"
 #include <platform/pc.h>
 #include <platform/pc/acpi.h>
@@ -203,11 +206,21 @@ enum handler_return platform_irq(x86_iframe_t *frame)
 
     struct int_handler_struct *handler = &int_handler_table[x86_vector];
 
+    lk_time_t irq_start = unlikely(tripwire_irq_ns) ? current_time() : 0;
+
     spin_lock(&handler->lock);
     if (handler->handler)
         ret = handler->handler(handler->arg);
     spin_unlock(&handler->lock);
 
+    if (unlikely(tripwire_irq_ns)) {
+        lk_time_t took = current_time() - irq_start;
+        if (took > tripwire_irq_ns) {
+            ktrace_probe2("tripwire_irq", (uint32_t)x86_vector,
+                          (uint32_t)(took / 1000u));
+        }
+    }
+
     apic_issue_eoi();
     return ret;
 }
@@ -351,6 +364,32 @@ void x86_free_msi_block(pcie_msi_block_t* block) {
     memset(block, 0, sizeof(*block));
 }
 
+status_t x86_msi_target_for_cpu(uint cpu_num, uint64_t* out_tgt_addr) {
+    if (!out_tgt_addr)
+        return MX_ERR_INVALID_ARGS;
+
+    if (cpu_num >= x86_num_cpus)
+        return MX_ERR_INVALID_ARGS;
+
+    uint32_t apic_id = (cpu_num == 0) ? bp_percpu.apic_id
+                                      : ap_percpus[cpu_num - 1].apic_id;
+
+    // Compute the target address.
+    // See section 10.11.1 of the Intel 64 and IA-32 Architectures Software
+    // Developer's Manual Volume 3A.
+    //
+    // Unlike the block allocation above, leave the redirection hint clear so
+    // that delivery is pinned to the requested local APIC rather than being
+    // eligible for redirection.
+    uint32_t tgt_addr = 0xFEE00000;       // base addr
+    tgt_addr |= apic_id << 12;            // Dest ID == target CPU's local APIC ID
+    tgt_addr &= ~0x08;                    // Redir hint == 0
+    tgt_addr &= ~0x04;                    // Dest Mode == Physical
+
+    *out_tgt_addr = tgt_addr;
+    return MX_OK;
+}
+
 void x86_register_msi_handler(const pcie_msi_block_t* block,
                               uint                    msi_id,
                               int_handler             handler,
@@ -12,6 +12,7 @@
 #include <arch/x86/apic.h>
 #include <arch/x86/cpu_topology.h>
 #include <arch/x86/mmu.h>
+#include <arch/x86/mp.h>
 #include <platform.h>
 #include "platform_p.h"
 #include <platform/pc.h>
@@ -31,6 +32,7 @@
 #include <assert.h>
 #include <lk/init.h>
 #include <kernel/cmdline.h>
+#include <kernel/mp.h>
 #include <kernel/vm/initial_map.h>
 #include <kernel/vm/pmm.h>
 #include <kernel/vm/vm_aspace.h>
@@ -472,6 +474,23 @@ static void platform_init_smp(void)
 
     x86_init_smp(apic_ids, num_cpus);
 
+    // feed the decoded topology to the scheduler now that apic ids have
+    // been mapped to cpu numbers
+    for (uint32_t i = 0; i < num_cpus; ++i) {
+        x86_cpu_topology_t topo;
+        x86_cpu_topology_decode(apic_ids[i], &topo);
+
+        int cpu = x86_apic_id_to_cpu_num(apic_ids[i]);
+        if (cpu >= 0) {
+            mp_cpu_topology_t mp_topo = {
+                .package_id = topo.package_id,
+                .core_id = topo.core_id,
+                .smt_id = topo.smt_id,
+            };
+            mp_set_cpu_topology((uint)cpu, &mp_topo);
+        }
+    }
+
     for (uint i = 0; i < num_cpus - 1; ++i) {
         if (apic_ids[i] == bsp_apic_id) {
             apic_ids[i] = apic_ids[num_cpus - 1];
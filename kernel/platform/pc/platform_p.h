@@ -38,6 +38,7 @@ void x86_register_msi_handler(const pcie_msi_block_t* block,
                               uint msi_id,
                               int_handler handler,
                               void* ctx);
+status_t x86_msi_target_for_cpu(uint cpu_num, uint64_t* out_tgt_addr);
 
 status_t platform_configure_watchdog(uint32_t frequency);
 
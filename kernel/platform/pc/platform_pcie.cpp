@@ -41,6 +41,10 @@ public:
                             void*                   ctx) override {
         x86_register_msi_handler(block, msi_id, handler, ctx);
     }
+
+    status_t MsiTargetForCpu(uint cpu_num, uint64_t* out_tgt_addr) override {
+        return x86_msi_target_for_cpu(cpu_num, out_tgt_addr);
+    }
 };
 
 X86PciePlatformSupport platform_pcie_support;
@@ -134,6 +138,8 @@ static void x86_pcie_init_hook(uint level) {
     }
 }
 
-LK_INIT_HOOK(x86_pcie_init, x86_pcie_init_hook, LK_INIT_LEVEL_PLATFORM);
+// Bus scan only touches PCI config space and the bus driver's own state, so it
+// can overlap the other platform-level hooks on a worker thread.
+LK_INIT_HOOK_PARALLEL(x86_pcie_init, x86_pcie_init_hook, LK_INIT_LEVEL_PLATFORM);
 
 #endif  // WITH_DEV_PCIE
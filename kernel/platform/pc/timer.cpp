@@ -162,6 +162,18 @@ lk_time_t ticks_to_nanos(uint64_t ticks) {
     return u64_mul_u64_fp32_64(ticks, ns_per_tsc);
 }
 
+mono_ticks_source_t platform_usermode_ticks_source(struct fp_32_64 *ns_per_tick)
+{
+    // rdtsc is available to user mode (CR4.TSD is never set), so the vDSO
+    // can mirror the CLOCK_TSC arm of current_time() exactly.  The HPET
+    // and PIT are kernel-only.
+    if (wall_clock != CLOCK_TSC)
+        return MONO_TICKS_SYSCALL;
+
+    *ns_per_tick = ns_per_tsc;
+    return MONO_TICKS_TSC;
+}
+
 // The PIT timer will keep track of wall time if we aren't using the TSC
 static enum handler_return pit_timer_tick(void *arg)
 {
@@ -264,11 +276,28 @@ static inline void hpet_calibration_cycle_cleanup(void)
     hpet_disable();
 }
 
+// Returns true when two calibration samples agree to within 0.1%, which is
+// about as tight as these short reference delays resolve anyway.  Once two
+// samples converge there is nothing left to learn from further tries, so the
+// calibration loops bail early to save boot time.
+static inline bool calibration_converged(uint64_t a, uint64_t b)
+{
+    const uint64_t diff = (a > b) ? a - b : b - a;
+    return diff <= ((a < b) ? a : b) / 1000;
+}
+
 static void calibrate_apic_timer(void)
 {
     ASSERT(arch_ints_disabled());
 
-    const uint64_t apic_freq = x86_lookup_core_crystal_freq();
+    // A frequency handed in on the cmdline (e.g. recorded from an earlier
+    // boot of the same machine) skips reference-clock calibration entirely.
+    uint64_t apic_freq = cmdline_get_uint64("kernel.apic-freq-hz", 0);
+    if (apic_freq != 0) {
+        printf("APIC frequency (from cmdline): %" PRIu64 " Hz\n", apic_freq);
+    } else {
+        apic_freq = x86_lookup_core_crystal_freq();
+    }
     if (apic_freq != 0) {
         ASSERT(apic_freq / 1000 <= UINT32_MAX);
         apic_ticks_per_ms = static_cast<uint32_t>(apic_freq / 1000);
@@ -331,6 +360,11 @@ outer:
                         break;
                     default: PANIC_UNIMPLEMENTED;
                 }
+
+                if (tries > 0 &&
+                        calibration_converged(apic_ticks, best_time[trial])) {
+                    break;
+                }
             }
 
             // If the APIC ran out of time every time, try again with a higher
@@ -355,7 +389,12 @@ static void calibrate_tsc(void)
 {
     ASSERT(arch_ints_disabled());
 
-    const uint64_t tsc_freq = x86_lookup_tsc_freq();
+    uint64_t tsc_freq = cmdline_get_uint64("kernel.tsc-freq-hz", 0);
+    if (tsc_freq != 0) {
+        printf("TSC frequency (from cmdline): %" PRIu64 " Hz\n", tsc_freq);
+    } else {
+        tsc_freq = x86_lookup_tsc_freq();
+    }
     if (tsc_freq != 0) {
         tsc_ticks_per_ms = tsc_freq / 1000;
         printf("TSC frequency: %" PRIu64 " ticks/ms\n", tsc_ticks_per_ms);
@@ -412,6 +451,11 @@ static void calibrate_tsc(void)
                         break;
                     default: PANIC_UNIMPLEMENTED;
                 }
+
+                if (tries > 0 &&
+                        calibration_converged(tsc_ticks, best_time[trial])) {
+                    break;
+                }
             }
         }
 
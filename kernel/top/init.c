@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <magenta/compiler.h>
 #include <debug.h>
+#include <kernel/thread.h>
 #include <trace.h>
 
 #define LOCAL_TRACE 0
@@ -28,6 +29,54 @@
 extern const struct lk_init_struct __start_lk_init[] __WEAK;
 extern const struct lk_init_struct __stop_lk_init[] __WEAK;
 
+/* Hooks flagged LK_INIT_FLAG_PARALLEL are fanned out onto worker threads so
+ * independent subsystems at the same level initialize concurrently.  Workers
+ * are joined before anything at a higher level runs and before lk_init_level
+ * returns, so the level boundary remains a hard ordering edge.
+ */
+#define MAX_PARALLEL_HOOKS 8
+
+struct parallel_hook_state {
+    thread_t *workers[MAX_PARALLEL_HOOKS];
+    uint count;
+    uint level;
+};
+
+static int parallel_hook_worker(void *arg)
+{
+    const struct lk_init_struct *ptr = (const struct lk_init_struct *)arg;
+
+    ptr->hook(ptr->level);
+    return 0;
+}
+
+static void join_parallel_hooks(struct parallel_hook_state *state)
+{
+    for (uint i = 0; i < state->count; i++) {
+        thread_join(state->workers[i], NULL, INFINITE_TIME);
+    }
+    state->count = 0;
+}
+
+static bool spawn_parallel_hook(struct parallel_hook_state *state, const struct lk_init_struct *ptr)
+{
+    /* workers joined at level boundaries; see above */
+    if (state->count > 0 && state->level != ptr->level)
+        join_parallel_hooks(state);
+    if (state->count == MAX_PARALLEL_HOOKS)
+        join_parallel_hooks(state);
+
+    thread_t *t = thread_create(ptr->name, parallel_hook_worker, (void *)ptr,
+                                DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
+    if (!t)
+        return false;
+
+    state->workers[state->count++] = t;
+    state->level = ptr->level;
+    thread_resume(t);
+    return true;
+}
+
 void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop_level)
 {
     LTRACEF("flags %#x, start_level %#x, stop_level %#x\n",
@@ -36,6 +85,7 @@ void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop
     ASSERT(start_level > 0);
     uint last_called_level = start_level - 1;
     const struct lk_init_struct *last = NULL;
+    struct parallel_hook_state pstate = { .count = 0 };
     for (;;) {
         /* search for the lowest uncalled hook to call */
         LTRACEF("last %p, last_called_level %#x\n", last, last_called_level);
@@ -83,10 +133,25 @@ void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop
                    arch_curr_cpu_num(), found->hook, found->name, found->level, found->flags);
         }
 #endif
-        found->hook(found->level);
+        /* parallel hooks only fan out for the primary cpu pass, once the
+         * scheduler is running; anywhere else they degrade to an in-place call
+         */
+        bool spawned = false;
+        if ((found->flags & LK_INIT_FLAG_PARALLEL) &&
+                required_flag == LK_INIT_FLAG_PRIMARY_CPU &&
+                found->level >= LK_INIT_LEVEL_THREADING) {
+            spawned = spawn_parallel_hook(&pstate, found);
+        }
+        if (!spawned) {
+            /* hooks that didn't opt in never run concurrently with anything */
+            join_parallel_hooks(&pstate);
+            found->hook(found->level);
+        }
         last_called_level = found->level;
         last = found;
     }
+
+    join_parallel_hooks(&pstate);
 }
 
 #if 0
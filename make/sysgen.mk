@@ -18,6 +18,7 @@ SG_MAGENTA := $(GENERATED_INCLUDES)/magenta
 SG_KERNEL_CODE := $(SG_MAGENTA)/syscall-invocation-cases.inc
 SG_KERNEL_HEADER := $(SG_MAGENTA)/syscall-definitions.h
 SG_KERNEL_TRACE := $(SG_MAGENTA)/syscall-ktrace-info.inc
+SG_KERNEL_DESCRIPTORS := $(SG_MAGENTA)/syscall-descriptors.inc
 SG_KERNEL_CATEGORY := $(SG_MAGENTA)/syscall-category.inc
 SG_KERNEL_WRAPPERS := $(SG_MAGENTA)/syscall-kernel-wrappers.inc
 SG_KERNEL_BRANCHES := $(SG_MAGENTA)/syscall-kernel-branches.S
@@ -43,6 +44,7 @@ $(STAMPY): $(SYSGEN_APP) $(SYSCALLS_SRC)
 	$(NOECHO) $(SYSGEN_APP) \
 		-kernel-code $(SG_KERNEL_CODE) \
 		-trace $(SG_KERNEL_TRACE) \
+		-descriptors $(SG_KERNEL_DESCRIPTORS) \
 		-category $(SG_KERNEL_CATEGORY) \
 		-kernel-header $(SG_KERNEL_HEADER) \
 		-kernel-wrappers $(SG_KERNEL_WRAPPERS) \
@@ -60,6 +62,7 @@ $(STAMPY): $(SYSGEN_APP) $(SYSCALLS_SRC)
 run-sysgen $(SG_PUBLIC_HEADER) $(SG_PUBLIC_RUST) $(SG_SYSROOT_HEADER) $(SG_SYSROOT_RUST): $(STAMPY)
 
 GENERATED += $(SG_KERNEL_CODE) $(SG_KERNEL_HEADER) $(SG_KERNEL_TRACE) \
+	$(SG_KERNEL_DESCRIPTORS) \
 	$(SG_KERNEL_CATEGORY) $(SG_ULIB_X86) $(SG_ULIB_ARM) \
 	$(SG_KERNEL_WRAPPERS) $(SG_KERNEL_BRANCHES) \
 	$(SG_ULIB_SYSCALL_NUMBERS) \
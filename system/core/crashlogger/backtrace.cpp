@@ -377,3 +377,42 @@ void backtrace(mx_handle_t process, mx_handle_t thread,
     unw_destroy_addr_space(remote_as);
     unw_destroy_fuchsia(fuchsia);
 }
+
+// Like read_mem, but reads from a captured copy of the stack.
+
+static mx_status_t read_snapshot(const void* stack, uintptr_t stack_vaddr,
+                                 size_t stack_size,
+                                 uintptr_t vaddr, void* ptr, size_t len) {
+    if (vaddr < stack_vaddr ||
+        vaddr - stack_vaddr + len > stack_size) {
+        return MX_ERR_OUT_OF_RANGE;
+    }
+    memcpy(ptr, reinterpret_cast<const char*>(stack) + (vaddr - stack_vaddr), len);
+    return MX_OK;
+}
+
+void backtrace_from_snapshot(dsoinfo_t* dso_list,
+                             const void* stack, uintptr_t stack_vaddr,
+                             size_t stack_size,
+                             uintptr_t pc, uintptr_t sp, uintptr_t fp) {
+    dso_print_list(dso_list);
+
+    // The process is gone, so libunwind can't read its address space;
+    // walk the frame pointer chain through the captured stack instead.
+
+    DebugInfoCache di_cache(dso_list, kDebugInfoCacheNumWays);
+
+    int n = 1;
+    btprint(&di_cache, n++, pc, sp);
+    while ((sp >= 0x1000000) && (n < 50)) {
+        sp = fp;
+        if (read_snapshot(stack, stack_vaddr, stack_size, fp + 8, &pc, sizeof(pc))) {
+            break;
+        }
+        if (read_snapshot(stack, stack_vaddr, stack_size, fp, &fp, sizeof(fp))) {
+            break;
+        }
+        btprint(&di_cache, n++, pc, sp);
+    }
+    printf("bt#%02d: end\n", n);
+}
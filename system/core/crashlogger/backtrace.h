@@ -6,6 +6,8 @@
 
 #include <magenta/compiler.h>
 
+#include "dso-list.h"
+
 __BEGIN_CDECLS;
 
 #include <inttypes.h>
@@ -14,4 +16,13 @@ void backtrace(mx_handle_t process, mx_handle_t thread,
                uintptr_t pc, uintptr_t sp, uintptr_t fp,
                bool use_libunwind);
 
+// Print a backtrace from state captured while the process was still alive:
+// |stack| holds |stack_size| bytes copied from the thread's stack starting
+// at |stack_vaddr|. Only frame pointer unwinding is available since the
+// process is gone by the time this runs. Takes ownership of |dso_list|.
+void backtrace_from_snapshot(dsoinfo_t* dso_list,
+                             const void* stack, uintptr_t stack_vaddr,
+                             size_t stack_size,
+                             uintptr_t pc, uintptr_t sp, uintptr_t fp);
+
 __END_CDECLS;
@@ -46,6 +46,11 @@ static bool swbreak_backtrace_enabled = true;
 static bool pt_dump_enabled = false;
 #endif
 
+// If true then crashes are captured quickly (registers plus a snapshot of
+// the stack) and symbolized on a background thread, so that one crashing
+// process can't stall exception handling for everyone else.
+static bool capture_async_enabled = true;
+
 // Return true if the thread is to be resumed "successfully" (meaning the o/s
 // won't kill it, and thus the kill process).
 
@@ -106,6 +111,14 @@ constexpr uint64_t kSelfExceptionKey = 0x646a65u;
 // Space for this is allocated on the stack, so this can't be too large.
 constexpr size_t kMemoryDumpSize = 256;
 
+// How much of the crashed thread's stack to snapshot for the background
+// symbolizer, starting at the stack pointer.
+constexpr size_t kStackSnapshotSize = 65536;
+
+// Bound on the number of captured reports awaiting symbolization.
+// Beyond this a crash storm gets one-line reports instead of backtraces.
+constexpr size_t kMaxPendingReports = 16;
+
 // Handle of the thread we're dumping.
 // This is used by both the main thread and the self-dumper thread.
 // However there is no need to lock it as the self-dumper thread only runs
@@ -355,6 +368,252 @@ Fail:
     mx_handle_close(process);
 }
 
+// State captured from a crashed process while it was still alive.
+// Holds everything the background symbolizer needs; no handles are kept,
+// so the process can be released as soon as capture is done.
+
+typedef struct crash_report {
+    struct crash_report* next;
+    uint64_t pid;
+    uint64_t tid;
+    uint32_t type;
+    mx_exception_report_t exc_report;
+    gregs_type regs;
+    mx_vaddr_t pc, sp, fp;
+    dsoinfo_t* dso_list;
+    uint8_t* stack;             // snapshot of the stack starting at |sp|
+    size_t stack_size;
+} crash_report_t;
+
+static mtx_t report_lock = MTX_INIT;
+static cnd_t report_cond;
+static crash_report_t* report_queue_head;
+static crash_report_t* report_queue_tail;
+static size_t report_queue_len;
+
+static void free_report(crash_report_t* report) {
+    dso_free_list(report->dso_list);
+    free(report->stack);
+    free(report);
+}
+
+// Print a captured report. Runs on the symbolizer thread.
+
+static void output_report(crash_report_t* report) {
+    const char* fatal = "fatal ";
+    if (is_resumable_swbreak(report->type))
+        fatal = "";
+    // TODO(mseaborn): Remove this and make policy exceptions fatal (MG-922).
+    if (report->type == MX_EXCP_POLICY_ERROR)
+        fatal = "";
+
+    printf("<== %sexception: process [%" PRIu64 "] thread [%" PRIu64 "]\n",
+           fatal, report->pid, report->tid);
+    printf("<== %s, PC at 0x%" PRIxPTR "\n",
+           excp_type_to_str(report->exc_report.header.type), report->pc);
+
+#if defined(__x86_64__)
+    output_frame_x86_64(report->exc_report.context.arch.u.x86_64, report->regs);
+#elif defined(__aarch64__)
+    output_frame_arm64(report->exc_report.context.arch.u.arm_64, report->regs);
+
+    // Only output the Fault address register if there's a data fault.
+    if (MX_EXCP_FATAL_PAGE_FAULT == report->exc_report.header.type)
+        printf(" far %#18" PRIx64 "\n", report->exc_report.context.arch.u.arm_64.far);
+#else
+    __UNREACHABLE;
+#endif
+
+    printf("bottom of user stack:\n");
+    if (report->stack_size > 0) {
+        size_t len = report->stack_size;
+        if (len > kMemoryDumpSize)
+            len = kMemoryDumpSize;
+        hexdump_ex(report->stack, len, report->sp);
+    }
+
+#if defined(__x86_64__)
+    printf("arch: x86_64\n");
+#elif defined(__aarch64__)
+    printf("arch: aarch64\n");
+#endif
+
+    // Takes ownership of the dso list.
+    backtrace_from_snapshot(report->dso_list,
+                            report->stack, report->sp, report->stack_size,
+                            report->pc, report->sp, report->fp);
+    report->dso_list = nullptr;
+
+#ifdef __x86_64__
+    if (pt_dump_enabled) {
+        try_dump_pt_data();
+    }
+#endif
+}
+
+static int symbolize_func(void* arg) {
+    for (;;) {
+        mtx_lock(&report_lock);
+        while (report_queue_head == nullptr) {
+            cnd_wait(&report_cond, &report_lock);
+        }
+        crash_report_t* report = report_queue_head;
+        report_queue_head = report->next;
+        if (report_queue_head == nullptr)
+            report_queue_tail = nullptr;
+        report_queue_len--;
+        mtx_unlock(&report_lock);
+
+        output_report(report);
+        free_report(report);
+    }
+    return 0;
+}
+
+static void queue_report(crash_report_t* report) {
+    mtx_lock(&report_lock);
+    if (report_queue_len >= kMaxPendingReports) {
+        mtx_unlock(&report_lock);
+        // Keep the impact of a crash storm bounded: drop the detailed dump
+        // rather than stalling exception handling behind symbolization.
+        printf("<== exception: process [%" PRIu64 "] thread [%" PRIu64 "], PC at 0x%" PRIxPTR "\n",
+               report->pid, report->tid, report->pc);
+        printf("crashlogger: too many pending reports, dropping detailed dump\n");
+        free_report(report);
+        return;
+    }
+    report->next = nullptr;
+    if (report_queue_tail != nullptr) {
+        report_queue_tail->next = report;
+    } else {
+        report_queue_head = report;
+    }
+    report_queue_tail = report;
+    report_queue_len++;
+    cnd_signal(&report_cond);
+    mtx_unlock(&report_lock);
+}
+
+// Capture everything needed to report the crash, then release the thread.
+// The expensive work (symbolization, unwinding, printing) happens later on
+// the symbolizer thread; this path is bounded to a handful of syscalls and
+// small memory reads.
+
+static void capture_report(uint64_t pid, uint64_t tid, uint32_t type) {
+    if (!MX_EXCP_IS_ARCH(type) && type != MX_EXCP_POLICY_ERROR)
+        return;
+
+    mx_handle_t process;
+    mx_status_t status = mx_object_get_child(0, pid, MX_RIGHT_SAME_RIGHTS, &process);
+    if (status < 0) {
+        printf("failed to get a handle to [%" PRIu64 "] : error %d\n", pid, status);
+        return;
+    }
+    mx_handle_t thread;
+    status = mx_object_get_child(process, tid, MX_RIGHT_SAME_RIGHTS, &thread);
+    if (status < 0) {
+        printf("failed to get a handle to [%" PRIu64 ".%" PRIu64 "] : error %d\n", pid, tid, status);
+        mx_handle_close(process);
+        return;
+    }
+
+    // Record the crashed thread so that if we crash then self_dump_func
+    // can (try to) "resume" the thread so that it's not left hanging.
+    crashed_thread = thread;
+    crashed_thread_excp_type = type;
+
+    crash_report_t* report = nullptr;
+    gregs_type* regs = nullptr;
+
+    report = reinterpret_cast<crash_report_t*>(calloc(1, sizeof(*report)));
+    if (report == nullptr) {
+        print_error("out of memory capturing crash report");
+        goto Fail;
+    }
+    report->pid = pid;
+    report->tid = tid;
+    report->type = type;
+
+    status = mx_object_get_info(thread, MX_INFO_THREAD_EXCEPTION_REPORT,
+                                &report->exc_report, sizeof(report->exc_report), NULL, NULL);
+    if (status < 0) {
+        printf("failed to get exception report for [%" PRIu64 ".%" PRIu64 "] : error %d\n", pid, tid, status);
+        goto Fail;
+    }
+
+    if (!read_general_regs(thread, &report->regs, sizeof(report->regs)))
+        goto Fail;
+    // Delay setting this until here so Fail will know we now have the regs.
+    regs = &report->regs;
+
+#if defined(__x86_64__)
+    report->pc = regs->rip;
+    report->sp = regs->rsp;
+    report->fp = regs->rbp;
+#elif defined(__aarch64__)
+    report->pc = regs->pc;
+    report->sp = regs->sp;
+    report->fp = regs->r[29];
+#else
+    printf("unsupported architecture .. coming soon.\n");
+    goto Fail;
+#endif
+
+    {
+        // The dso list must be fetched while the process is still alive.
+        // It also records each dso's build id, which is all the symbolizer
+        // needs later to find debug info.
+        char name[MX_MAX_NAME_LEN + 4];
+        strcpy(name, "app:");
+        status = mx_object_get_property(process, MX_PROP_NAME, name + 4, sizeof(name) - 4);
+        if (status != MX_OK) {
+            strlcpy(name, "app", sizeof(name));
+        }
+        report->dso_list = dso_fetch_list(process, name);
+
+        report->stack = reinterpret_cast<uint8_t*>(malloc(kStackSnapshotSize));
+        if (report->stack != nullptr) {
+            // The snapshot may extend past the top of the stack, in which
+            // case the read fails; retry with less until it fits.
+            size_t want = kStackSnapshotSize;
+            size_t actual = 0;
+            for (;;) {
+                if (mx_process_read_memory(process, report->sp, report->stack,
+                                           want, &actual) == MX_OK) {
+                    break;
+                }
+                want /= 2;
+                if (want < 2 * sizeof(uint64_t)) {
+                    actual = 0;
+                    break;
+                }
+            }
+            report->stack_size = actual;
+        }
+    }
+
+Fail:
+    debugf(1, "Done capturing thread %" PRIu64 ".%" PRIu64 ".\n", pid, tid);
+
+    // Allow the thread (and then process) to die, unless the exception is
+    // to just trigger a backtrace (if enabled). Everything needed for the
+    // report has been captured at this point.
+    resume_thread_from_exception(thread, type, regs);
+    crashed_thread = MX_HANDLE_INVALID;
+    crashed_thread_excp_type = 0u;
+
+    mx_handle_close(thread);
+    mx_handle_close(process);
+
+    if (report != nullptr) {
+        if (regs != nullptr) {
+            queue_report(report);
+        } else {
+            free_report(report);
+        }
+    }
+}
+
 // A small wrapper to provide a useful name to the API call used to effect
 // the request.
 
@@ -431,7 +690,10 @@ void usage() {
     fprintf(stderr, "  -pt[on|off] = enable processor trace dumps,\n");
     fprintf(stderr, "      requires PT turned on in the kernel\n");
 #endif
-    fprintf(stderr, "  -n = do not use libunwind\n");
+    fprintf(stderr, "  -a[on|off] = capture crashes quickly and symbolize them\n");
+    fprintf(stderr, "      on a background thread (default on); when off,\n");
+    fprintf(stderr, "      crashes are fully processed inline\n");
+    fprintf(stderr, "  -n = do not use libunwind (inline processing only)\n");
     fprintf(stderr, "  -s[on|off] = enable s/w breakpoints to trigger\n");
     fprintf(stderr, "      a backtrace without terminating the process\n");
     fprintf(stderr, "\n");
@@ -469,6 +731,15 @@ int main(int argc, char** argv) {
                 return 1;
             }
 #endif
+        } else if (strncmp(arg, "-a", 2) == 0) {
+            if (arg[2] == '\0' || strcmp(arg, "-aon") == 0) {
+                capture_async_enabled = true;
+            } else if (strcmp(arg, "-aoff") == 0) {
+                capture_async_enabled = false;
+            } else {
+                usage();
+                return 1;
+            }
         } else if (strcmp(arg, "-n") == 0) {
             use_libunwind = false;
         } else if (strncmp(arg, "-s", 2) == 0) {
@@ -544,6 +815,23 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    // A thread to symbolize and print captured crash reports, so that the
+    // main loop only has to capture state and can get back to waiting for
+    // the next exception quickly.
+    if (capture_async_enabled) {
+        if (cnd_init(&report_cond) != thrd_success) {
+            print_error("cnd_init failed");
+            return 1;
+        }
+        thrd_t symbolize_thread;
+        ret = thrd_create_with_name(&symbolize_thread, symbolize_func,
+                                    nullptr, "symbolize-thread");
+        if (ret != thrd_success) {
+            print_error("thrd_create_with_name failed, processing crashes inline");
+            capture_async_enabled = false;
+        }
+    }
+
     // The exception port may be passed in from the parent process.  If it
     // wasn't, we bind the system exception port.
     mx_handle_t ex_port = mx_get_startup_handle(PA_HND(PA_USER0, 0));
@@ -570,7 +858,11 @@ int main(int argc, char** argv) {
             return 1;
         }
 
-        process_report(packet.exception.pid, packet.exception.tid, packet.type, use_libunwind);
+        if (capture_async_enabled) {
+            capture_report(packet.exception.pid, packet.exception.tid, packet.type);
+        } else {
+            process_report(packet.exception.pid, packet.exception.tid, packet.type, use_libunwind);
+        }
     }
 
     return 0;
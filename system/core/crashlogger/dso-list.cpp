@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <magenta/assert.h>
@@ -119,6 +120,82 @@ void dso_print_list(dsoinfo_t* dso_list) {
     }
 }
 
+// Cache of build id -> debug file lookups. dsoinfo_t entries only live for
+// one crash report, so without this every report re-probes the filesystem
+// for every dso. The cache persists across reports, which matters when the
+// same binary crashes repeatedly.
+
+typedef struct debug_file_cache_entry {
+    struct debug_file_cache_entry* next;
+    mx_status_t status;
+    char* path;                 // only valid when |status| is MX_OK
+    char buildid[MAX_BUILDID_SIZE * 2 + 1];
+} debug_file_cache_entry_t;
+
+static mtx_t debug_file_cache_lock = MTX_INIT;
+static debug_file_cache_entry_t* debug_file_cache;
+static size_t debug_file_cache_size;
+
+// Bound on cache growth; lookups beyond this many distinct build ids
+// are simply not cached.
+constexpr size_t kDebugFileCacheMaxSize = 64;
+
+// Returns true, and fills in |dso|'s debug file state, if |dso|'s build id
+// has been looked up before.
+
+static bool debug_file_cache_lookup(dsoinfo_t* dso) {
+    mtx_lock(&debug_file_cache_lock);
+    for (auto entry = debug_file_cache; entry != nullptr; entry = entry->next) {
+        if (!strcmp(entry->buildid, dso->buildid)) {
+            dso->debug_file_tried = true;
+            dso->debug_file_status = entry->status;
+            if (entry->status == MX_OK) {
+                dso->debug_file = strdup(entry->path);
+                if (dso->debug_file == nullptr) {
+                    dso->debug_file_status = MX_ERR_NO_MEMORY;
+                }
+            }
+            mtx_unlock(&debug_file_cache_lock);
+            debugf(2, "debug file cache hit for %s: %d\n",
+                   dso->buildid, dso->debug_file_status);
+            return true;
+        }
+    }
+    mtx_unlock(&debug_file_cache_lock);
+    return false;
+}
+
+static void debug_file_cache_add(const dsoinfo_t* dso) {
+    auto entry = reinterpret_cast<debug_file_cache_entry_t*>(
+        calloc(1, sizeof(debug_file_cache_entry_t)));
+    if (entry == nullptr) {
+        return;
+    }
+    entry->status = dso->debug_file_status;
+    if (dso->debug_file_status == MX_OK) {
+        entry->path = strdup(dso->debug_file);
+        if (entry->path == nullptr) {
+            free(entry);
+            return;
+        }
+    }
+    strlcpy(entry->buildid, dso->buildid, sizeof(entry->buildid));
+
+    mtx_lock(&debug_file_cache_lock);
+    if (debug_file_cache_size < kDebugFileCacheMaxSize) {
+        entry->next = debug_file_cache;
+        debug_file_cache = entry;
+        debug_file_cache_size++;
+        entry = nullptr;
+    }
+    mtx_unlock(&debug_file_cache_lock);
+
+    if (entry != nullptr) {
+        free(entry->path);
+        free(entry);
+    }
+}
+
 mx_status_t dso_find_debug_file(dsoinfo_t* dso, const char** out_debug_file) {
     // Have we already tried?
     // Yeah, if we OOM it's possible it'll succeed next time, but
@@ -137,6 +214,13 @@ mx_status_t dso_find_debug_file(dsoinfo_t* dso, const char** out_debug_file) {
         }
     }
 
+    if (debug_file_cache_lookup(dso)) {
+        if (dso->debug_file_status == MX_OK) {
+            *out_debug_file = dso->debug_file;
+        }
+        return dso->debug_file_status;
+    }
+
     dso->debug_file_tried = true;
 
     char* path;
@@ -161,5 +245,7 @@ mx_status_t dso_find_debug_file(dsoinfo_t* dso, const char** out_debug_file) {
         dso->debug_file_status = MX_OK;
     }
 
+    debug_file_cache_add(dso);
+
     return dso->debug_file_status;
 }
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 
 #include <fs-management/mount.h>
 #include <gpt/gpt.h>
@@ -16,6 +17,10 @@
 
 static mx_handle_t job;
 
+// Guards the mount bookkeeping below and the format cache; per-device
+// scanning itself runs unlocked on worker threads.
+static mtx_t scan_lock;
+
 static mx_status_t launch_blobstore(int argc, const char** argv, mx_handle_t* hnd,
                                     uint32_t* ids, size_t len) {
     return devmgr_launch(job, "blobstore:/blobstore", argc, argv, NULL, -1,
@@ -35,8 +40,80 @@ static mx_status_t launch_fat(int argc, const char** argv, mx_handle_t* hnd,
 }
 
 static bool data_mounted = false;
+static bool sys_mounted = false;
 static bool blobstore_mounted = false;
 
+// Claim one of the singleton mountpoints above.  Returns false if somebody
+// else already holds it; on a failed mount the claim must be released so a
+// later device can try again.
+static bool claim_mount(bool* flag) {
+    mtx_lock(&scan_lock);
+    bool claimed = !*flag;
+    *flag = true;
+    mtx_unlock(&scan_lock);
+    return claimed;
+}
+
+static void release_mount(bool* flag) {
+    mtx_lock(&scan_lock);
+    *flag = false;
+    mtx_unlock(&scan_lock);
+}
+
+// Cache of detection results keyed by partition GUID and device geometry,
+// so re-publishes of known partitions (e.g. after a devhost restart) skip
+// the probe read and re-enumeration is near-instant.  A reformat which
+// preserves both GUID and geometry goes stale here; the resulting failed
+// mount is harmless and the entry is overwritten once it falls out.
+// Devices without a partition GUID (raw disks) are always probed.
+typedef struct {
+    uint8_t guid[GPT_GUID_LEN];
+    uint64_t block_count;
+    uint32_t block_size;
+    disk_format_t df;
+    bool valid;
+} format_cache_entry_t;
+
+#define FORMAT_CACHE_SIZE 32
+static format_cache_entry_t format_cache[FORMAT_CACHE_SIZE];
+static size_t format_cache_next;
+
+static disk_format_t detect_disk_format_cached(int fd) {
+    uint8_t guid[GPT_GUID_LEN];
+    block_info_t info;
+    if ((ioctl_block_get_partition_guid(fd, guid, sizeof(guid)) != GPT_GUID_LEN) ||
+        (ioctl_block_get_info(fd, &info) < 0)) {
+        // No stable identity for this device; probe it directly.
+        return detect_disk_format(fd);
+    }
+
+    mtx_lock(&scan_lock);
+    for (size_t i = 0; i < FORMAT_CACHE_SIZE; i++) {
+        format_cache_entry_t* entry = &format_cache[i];
+        if (entry->valid && !memcmp(entry->guid, guid, sizeof(guid)) &&
+            (entry->block_count == info.block_count) &&
+            (entry->block_size == info.block_size)) {
+            disk_format_t df = entry->df;
+            mtx_unlock(&scan_lock);
+            return df;
+        }
+    }
+    mtx_unlock(&scan_lock);
+
+    disk_format_t df = detect_disk_format(fd);
+    if (df != DISK_FORMAT_UNKNOWN) {
+        mtx_lock(&scan_lock);
+        format_cache_entry_t* entry = &format_cache[format_cache_next++ % FORMAT_CACHE_SIZE];
+        memcpy(entry->guid, guid, sizeof(guid));
+        entry->block_count = info.block_count;
+        entry->block_size = info.block_size;
+        entry->df = df;
+        entry->valid = true;
+        mtx_unlock(&scan_lock);
+    }
+    return df;
+}
+
 /*
  * Attempt to mount the device pointed to be the file descriptor at a known
  * location.
@@ -55,7 +132,7 @@ static mx_status_t mount_minfs(int fd, mount_options_t* options) {
     // check if this partition matches any special type GUID
     if (read_sz == GPT_GUID_LEN) {
         if (is_sys_guid(type_guid, read_sz)) {
-            if (secondary_bootfs_ready()) {
+            if (secondary_bootfs_ready() || !claim_mount(&sys_mounted)) {
                 return MX_ERR_ALREADY_BOUND;
             }
 
@@ -66,21 +143,22 @@ static mx_status_t mount_minfs(int fd, mount_options_t* options) {
             mx_status_t st = mount(fd, PATH_SYSTEM, DISK_FORMAT_MINFS, options, launch_minfs);
             if (st != MX_OK) {
                 printf("devmgr: failed to mount %s, retcode = %d. Run fixfs to restore partition.\n", PATH_SYSTEM, st);
+                release_mount(&sys_mounted);
             } else {
                 devmgr_start_appmgr(NULL);
             }
 
             return st;
         } else if (is_data_guid(type_guid, read_sz)) {
-            if (data_mounted) {
+            if (!claim_mount(&data_mounted)) {
                 return MX_ERR_ALREADY_BOUND;
             }
-            data_mounted = true;
             options->wait_until_ready = true;
 
             mx_status_t st = mount(fd, PATH_DATA, DISK_FORMAT_MINFS, options, launch_minfs);
             if (st != MX_OK) {
                 printf("devmgr: failed to mount %s, retcode = %d. Run fixfs to restore partition.\n", PATH_DATA, st);
+                release_mount(&data_mounted);
             }
 
             return st;
@@ -94,22 +172,20 @@ static mx_status_t mount_minfs(int fd, mount_options_t* options) {
 #define MBR_DRIVER_LIB "/boot/driver/mbr.so"
 #define STRLEN(s) sizeof(s)/sizeof((s)[0])
 
-static mx_status_t block_device_added(int dirfd, int event, const char* name, void* cookie) {
-    if (event != WATCH_EVENT_ADD_FILE) {
-        printf("devmgr: block watch waiting...\n");
-        return MX_OK;
-    }
-
+typedef struct {
+    int fd;
     char device_path[PATH_MAX];
-    sprintf(device_path, "%s/%s", PATH_DEV_BLOCK, name);
+} scan_job_t;
 
-    printf("devmgr: new block device: %s\n", device_path);
-    int fd;
-    if ((fd = openat(dirfd, name, O_RDWR)) < 0) {
-        return MX_OK;
-    }
+// Probe and (if appropriate) mount a single block device.  Runs on its own
+// thread so one slow disk does not serialize bring-up of the others.
+// Takes ownership of the fd in the job.
+static int block_device_scan(void* arg) {
+    scan_job_t* scan = arg;
+    int fd = scan->fd;
+    const char* device_path = scan->device_path;
 
-    disk_format_t df = detect_disk_format(fd);
+    disk_format_t df = detect_disk_format_cached(fd);
 
     switch (df) {
     case DISK_FORMAT_GPT: {
@@ -117,35 +193,35 @@ static mx_status_t block_device_added(int dirfd, int event, const char* name, vo
         // probe for partition table
         ioctl_device_bind(fd, GPT_DRIVER_LIB, STRLEN(GPT_DRIVER_LIB));
         close(fd);
-        return MX_OK;
+        break;
     }
     case DISK_FORMAT_MBR: {
         printf("devmgr: %s: MBR?\n", device_path);
         // probe for partition table
         ioctl_device_bind(fd, MBR_DRIVER_LIB, STRLEN(MBR_DRIVER_LIB));
         close(fd);
-        return MX_OK;
+        break;
     }
     case DISK_FORMAT_BLOBFS: {
-        if (!blobstore_mounted) {
-            mount_options_t options = default_mount_options;
-            options.create_mountpoint = true;
-            mx_status_t status = mount(fd, PATH_BLOBSTORE, DISK_FORMAT_BLOBFS, &options, launch_blobstore);
-            if (status != MX_OK) {
-                printf("devmgr: Failed to mount blobstore partition %s at %s: %d. Please run fixfs to reformat.\n", device_path, PATH_BLOBSTORE, status);
-            } else {
-                blobstore_mounted = true;
-            }
+        if (!claim_mount(&blobstore_mounted)) {
+            close(fd);
+            break;
         }
-
-        return MX_OK;
+        mount_options_t options = default_mount_options;
+        options.create_mountpoint = true;
+        mx_status_t status = mount(fd, PATH_BLOBSTORE, DISK_FORMAT_BLOBFS, &options, launch_blobstore);
+        if (status != MX_OK) {
+            printf("devmgr: Failed to mount blobstore partition %s at %s: %d. Please run fixfs to reformat.\n", device_path, PATH_BLOBSTORE, status);
+            release_mount(&blobstore_mounted);
+        }
+        break;
     }
     case DISK_FORMAT_MINFS: {
         printf("devmgr: minfs\n");
         mount_options_t options = default_mount_options;
         options.wait_until_ready = false;
         mount_minfs(fd, &options);
-        return MX_OK;
+        break;
     }
     case DISK_FORMAT_FAT: {
         // Use the GUID to avoid auto-mounting the EFI partition as writable
@@ -158,24 +234,61 @@ static mx_status_t block_device_added(int dirfd, int event, const char* name, vo
         static int fat_counter = 0;
         static int efi_counter = 0;
         char mountpath[MXIO_MAX_FILENAME + 64];
+        mtx_lock(&scan_lock);
         if (efi) {
             snprintf(mountpath, sizeof(mountpath), "%s/efi-%d", PATH_VOLUME, efi_counter++);
         } else {
             snprintf(mountpath, sizeof(mountpath), "%s/fat-%d", PATH_VOLUME, fat_counter++);
         }
+        mtx_unlock(&scan_lock);
         options.wait_until_ready = false;
         printf("devmgr: fatfs\n");
         mount(fd, mountpath, df, &options, launch_fat);
-        return MX_OK;
+        break;
     }
     default:
         close(fd);
+        break;
+    }
+
+    free(scan);
+    return 0;
+}
+
+static mx_status_t block_device_added(int dirfd, int event, const char* name, void* cookie) {
+    if (event != WATCH_EVENT_ADD_FILE) {
+        printf("devmgr: block watch waiting...\n");
         return MX_OK;
     }
+
+    scan_job_t* scan = malloc(sizeof(scan_job_t));
+    if (scan == NULL) {
+        return MX_OK;
+    }
+    snprintf(scan->device_path, sizeof(scan->device_path), "%s/%s",
+             PATH_DEV_BLOCK, name);
+
+    printf("devmgr: new block device: %s\n", scan->device_path);
+    if ((scan->fd = openat(dirfd, name, O_RDWR)) < 0) {
+        free(scan);
+        return MX_OK;
+    }
+
+    // Scan each device on its own thread; detection reads and mounts on a
+    // slow device must not stall enumeration of the rest.
+    thrd_t t;
+    if (thrd_create_with_name(&t, block_device_scan, scan,
+                              "block-scan") == thrd_success) {
+        thrd_detach(t);
+    } else {
+        block_device_scan(scan);
+    }
+    return MX_OK;
 }
 
 void block_device_watcher(mx_handle_t _job) {
     job = _job;
+    mtx_init(&scan_lock, mtx_plain);
 
     int dirfd;
     if ((dirfd = open("/dev/class/block", O_DIRECTORY|O_RDONLY)) >= 0) {
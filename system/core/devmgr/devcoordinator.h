@@ -121,6 +121,9 @@ struct dc_driver {
     uint32_t flags;
     struct list_node node;
     const char* libname;
+
+    // cached vmo of the driver library, loaded on first bind
+    mx_handle_t dso_vmo;
 };
 
 #define DRIVER_NAME_LEN_MAX 64
@@ -140,6 +143,20 @@ bool dc_is_bindable(driver_t* drv, uint32_t protocol_id,
                     mx_device_prop_t* props, size_t prop_count,
                     bool autobind);
 
+// the list of all loaded drivers, in bind priority order
+list_node_t* dc_get_drivers(void);
+
+// bind-result cache (devmgr-bindcache.c): maps the inputs binding
+// programs actually read (protocol id + properties) to the resulting
+// in-order driver match set, persisted across boots under /data
+#define BC_MAX_MATCHES 16
+
+bool bc_lookup(uint32_t protocol_id, mx_device_prop_t* props, uint32_t prop_count,
+               bool want_all, driver_t** matches, uint32_t* match_count);
+void bc_store(uint32_t protocol_id, mx_device_prop_t* props, uint32_t prop_count,
+              bool complete, driver_t** matches, uint32_t match_count);
+void bc_invalidate(void);
+
 #define DC_MAX_DATA 4096
 
 // The first two fields of devcoordinator messages align
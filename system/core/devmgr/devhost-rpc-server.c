@@ -259,6 +259,56 @@ static ssize_t do_ioctl(mx_device_t* dev, uint32_t op, const void* in_buf, size_
         memcpy(info->name, devhost_name, strlen(devhost_name));
         return sizeof(vfs_query_info_t) + strlen(devhost_name);
     }
+    case IOCTL_DEVICE_BATCH: {
+        const uint8_t* in = in_buf;
+        uint8_t* out = out_buf;
+        size_t out_pos = 0;
+        char entry_in[MXIO_IOCTL_MAX_INPUT];
+
+        while (in_len > 0) {
+            device_batch_entry_t entry;
+            if (in_len < sizeof(entry)) {
+                return MX_ERR_INVALID_ARGS;
+            }
+            memcpy(&entry, in, sizeof(entry));
+            in += sizeof(entry);
+            in_len -= sizeof(entry);
+
+            size_t in_pad = DEVICE_BATCH_ALIGN(entry.in_len);
+            if ((entry.in_len > MXIO_IOCTL_MAX_INPUT) || (in_pad > in_len)) {
+                return MX_ERR_INVALID_ARGS;
+            }
+            // no nested batches, and no ioctls that move handles since
+            // the batched replies can't carry them
+            if ((entry.op == IOCTL_DEVICE_BATCH) ||
+                (IOCTL_KIND(entry.op) != IOCTL_KIND_DEFAULT)) {
+                return MX_ERR_NOT_SUPPORTED;
+            }
+            // entries may scribble on their input (BIND terminates the
+            // path in place), so give each one its own copy
+            memcpy(entry_in, in, entry.in_len);
+            in += in_pad;
+            in_len -= in_pad;
+
+            if (out_pos + sizeof(device_batch_result_t) +
+                DEVICE_BATCH_ALIGN(entry.out_len) > out_len) {
+                return MX_ERR_BUFFER_TOO_SMALL;
+            }
+            device_batch_result_t* result = (device_batch_result_t*)(out + out_pos);
+            out_pos += sizeof(device_batch_result_t);
+
+            ssize_t n = do_ioctl(dev, entry.op, entry_in, entry.in_len,
+                                 out + out_pos, entry.out_len);
+            result->status = (n > INT32_MAX) ? MX_ERR_OUT_OF_RANGE : (int32_t)n;
+            result->out_len = (n > 0) ? (uint32_t)n : 0;
+            // zero the alignment padding so stale buffer contents
+            // don't leak back to the client
+            memset(out + out_pos + result->out_len, 0,
+                   DEVICE_BATCH_ALIGN(result->out_len) - result->out_len);
+            out_pos += DEVICE_BATCH_ALIGN(result->out_len);
+        }
+        return out_pos;
+    }
     default: {
         size_t actual = 0;
         r = dev_op_ioctl(dev, op, in_buf, in_len, out_buf, out_len, &actual);
@@ -0,0 +1,259 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "devcoordinator.h"
+
+// Caches bind-program match results so devices with identical match
+// inputs are resolved with one lookup instead of re-running every
+// driver's binding program, and so warm boots can skip the matching
+// pass entirely for devices which appear after /data is mounted.
+//
+// Binding programs read exactly (protocol id, properties, autobind), so
+// that tuple is the cache key - it identifies the match result
+// precisely, where a topological path would only identify it
+// heuristically.  The persisted file is validated against a hash of the
+// entire driver set (paths, names, and binding programs, in list
+// order); any change to the drivers invalidates it wholesale.
+
+#define BC_CACHE_DIR "/data/devmgr"
+#define BC_CACHE_PATH BC_CACHE_DIR "/bind-cache"
+#define BC_CACHE_MAGIC 0x31484342 // 'BCH1'
+
+typedef struct {
+    list_node_t node;
+    uint32_t protocol_id;
+    uint32_t prop_count;
+    // true if the full driver list was scanned; a set truncated at the
+    // first match (non-multibind devices stop there) only answers
+    // lookups that also want just the first match.
+    bool complete;
+    uint32_t match_count;
+    driver_t* matches[BC_MAX_MATCHES];
+    mx_device_prop_t props[];
+} bc_entry_t;
+
+static list_node_t bc_entries = LIST_INITIAL_VALUE(bc_entries);
+static bool bc_loaded = false;
+
+static uint64_t fnv1a64(uint64_t hash, const void* data, size_t len) {
+    const uint8_t* p = data;
+    while (len-- > 0) {
+        hash = (hash ^ *p++) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Hash over every driver's identity and binding program, in list order
+// (order matters: it decides which match wins on non-multibind devices).
+static uint64_t bc_driver_set_hash(void) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    driver_t* drv;
+    list_for_every_entry(dc_get_drivers(), drv, driver_t, node) {
+        hash = fnv1a64(hash, drv->libname, strlen(drv->libname) + 1);
+        hash = fnv1a64(hash, drv->name, strlen(drv->name) + 1);
+        hash = fnv1a64(hash, drv->binding, drv->binding_size);
+    }
+    return hash;
+}
+
+static driver_t* bc_find_driver(const char* libname) {
+    driver_t* drv;
+    list_for_every_entry(dc_get_drivers(), drv, driver_t, node) {
+        if (!strcmp(drv->libname, libname)) {
+            return drv;
+        }
+    }
+    return NULL;
+}
+
+static bc_entry_t* bc_find(uint32_t protocol_id,
+                           mx_device_prop_t* props, uint32_t prop_count) {
+    bc_entry_t* entry;
+    list_for_every_entry(&bc_entries, entry, bc_entry_t, node) {
+        if ((entry->protocol_id == protocol_id) &&
+            (entry->prop_count == prop_count) &&
+            !memcmp(entry->props, props, prop_count * sizeof(mx_device_prop_t))) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void bc_save(void) {
+    // quietly do nothing until the minfs data partition is mounted
+    mkdir(BC_CACHE_DIR, 0700);
+
+    char tmp[] = BC_CACHE_DIR "/bind-cache.XXXXXX";
+    int fd = mkstemp(tmp);
+    if (fd < 0) {
+        return;
+    }
+    FILE* f = fdopen(fd, "w");
+    if (f == NULL) {
+        close(fd);
+        unlink(tmp);
+        return;
+    }
+
+    uint32_t header[2] = { BC_CACHE_MAGIC, 0 };
+    bc_entry_t* entry;
+    list_for_every_entry(&bc_entries, entry, bc_entry_t, node) {
+        header[1]++;
+    }
+    uint64_t hash = bc_driver_set_hash();
+    fwrite(header, sizeof(header), 1, f);
+    fwrite(&hash, sizeof(hash), 1, f);
+
+    list_for_every_entry(&bc_entries, entry, bc_entry_t, node) {
+        uint32_t rec[4] = {
+            entry->protocol_id, entry->prop_count,
+            entry->complete ? 1u : 0u, entry->match_count,
+        };
+        fwrite(rec, sizeof(rec), 1, f);
+        fwrite(entry->props, sizeof(mx_device_prop_t), entry->prop_count, f);
+        for (uint32_t n = 0; n < entry->match_count; n++) {
+            uint32_t len = (uint32_t)strlen(entry->matches[n]->libname) + 1;
+            fwrite(&len, sizeof(len), 1, f);
+            fwrite(entry->matches[n]->libname, len, 1, f);
+        }
+    }
+
+    if (ferror(f)) {
+        fclose(f);
+        unlink(tmp);
+        return;
+    }
+    fclose(f);
+    rename(tmp, BC_CACHE_PATH);
+}
+
+static void bc_try_load(void) {
+    FILE* f = fopen(BC_CACHE_PATH, "r");
+    if (f == NULL) {
+        // not mounted yet or first boot; retry on the next lookup
+        return;
+    }
+    // whether or not the contents check out, only parse the file once
+    // per driver-set generation (bc_invalidate resets this)
+    bc_loaded = true;
+
+    uint32_t header[2];
+    uint64_t hash;
+    if ((fread(header, sizeof(header), 1, f) != 1) ||
+        (fread(&hash, sizeof(hash), 1, f) != 1) ||
+        (header[0] != BC_CACHE_MAGIC) ||
+        (hash != bc_driver_set_hash())) {
+        printf("devcoord: stale bind cache, ignoring\n");
+        fclose(f);
+        return;
+    }
+
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < header[1]; i++) {
+        uint32_t rec[4];
+        if (fread(rec, sizeof(rec), 1, f) != 1) {
+            break;
+        }
+        uint32_t prop_count = rec[1];
+        uint32_t match_count = rec[3];
+        if ((prop_count > 1024) || (match_count > BC_MAX_MATCHES)) {
+            break;
+        }
+        bc_entry_t* entry = malloc(sizeof(bc_entry_t) +
+                                   prop_count * sizeof(mx_device_prop_t));
+        if (entry == NULL) {
+            break;
+        }
+        entry->protocol_id = rec[0];
+        entry->prop_count = prop_count;
+        entry->complete = (rec[2] != 0);
+        entry->match_count = match_count;
+        bool ok = (prop_count == 0) ||
+            (fread(entry->props, sizeof(mx_device_prop_t), prop_count, f) == prop_count);
+        for (uint32_t n = 0; ok && (n < match_count); n++) {
+            uint32_t len;
+            char libname[256 + 32];
+            if ((fread(&len, sizeof(len), 1, f) != 1) || (len > sizeof(libname)) ||
+                (fread(libname, len, 1, f) != 1) || (libname[len - 1] != 0) ||
+                ((entry->matches[n] = bc_find_driver(libname)) == NULL)) {
+                ok = false;
+            }
+        }
+        // in-memory results from earlier in this boot are fresher
+        if (!ok || bc_find(entry->protocol_id, entry->props, entry->prop_count)) {
+            free(entry);
+            if (!ok) {
+                break;
+            }
+            continue;
+        }
+        list_add_tail(&bc_entries, &entry->node);
+        accepted++;
+    }
+    fclose(f);
+    printf("devcoord: loaded %u cached bind results\n", accepted);
+}
+
+bool bc_lookup(uint32_t protocol_id, mx_device_prop_t* props, uint32_t prop_count,
+               bool want_all, driver_t** matches, uint32_t* match_count) {
+    if (!bc_loaded) {
+        bc_try_load();
+    }
+
+    bc_entry_t* entry = bc_find(protocol_id, props, prop_count);
+    if (entry == NULL) {
+        return false;
+    }
+    if (want_all && !entry->complete) {
+        return false;
+    }
+    memcpy(matches, entry->matches, entry->match_count * sizeof(driver_t*));
+    *match_count = entry->match_count;
+    return true;
+}
+
+void bc_store(uint32_t protocol_id, mx_device_prop_t* props, uint32_t prop_count,
+              bool complete, driver_t** matches, uint32_t match_count) {
+    if (match_count > BC_MAX_MATCHES) {
+        return;
+    }
+    bc_entry_t* entry = bc_find(protocol_id, props, prop_count);
+    if (entry == NULL) {
+        entry = malloc(sizeof(bc_entry_t) + prop_count * sizeof(mx_device_prop_t));
+        if (entry == NULL) {
+            return;
+        }
+        entry->protocol_id = protocol_id;
+        entry->prop_count = prop_count;
+        memcpy(entry->props, props, prop_count * sizeof(mx_device_prop_t));
+        list_add_tail(&bc_entries, &entry->node);
+    } else if (entry->complete && !complete) {
+        // don't replace a full scan with a truncated one
+        return;
+    }
+    entry->complete = complete;
+    entry->match_count = match_count;
+    memcpy(entry->matches, matches, match_count * sizeof(driver_t*));
+
+    bc_save();
+}
+
+// The driver set changed, so every cached result is suspect.  The
+// persisted file is left in place: it self-validates by driver hash,
+// so once the set settles (say, after the /system drivers load) a file
+// written by a matching previous boot becomes usable again.
+void bc_invalidate(void) {
+    bc_entry_t* entry;
+    while ((entry = list_remove_head_type(&bc_entries, bc_entry_t, node)) != NULL) {
+        free(entry);
+    }
+    bc_loaded = false;
+}
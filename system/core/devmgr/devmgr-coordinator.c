@@ -7,6 +7,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <threads.h>
 
 #include <ddk/driver.h>
 #include <driver-info/driver-info.h>
@@ -149,6 +150,10 @@ static list_node_t list_drivers_new = LIST_INITIAL_VALUE(list_drivers_new);
 // All Devices (excluding static immortal devices)
 static list_node_t list_devices = LIST_INITIAL_VALUE(list_devices);
 
+list_node_t* dc_get_drivers(void) {
+    return &list_drivers;
+}
+
 static driver_t* libname_to_driver(const char* libname) {
     driver_t* drv;
     list_for_every_entry(&list_drivers, drv, driver_t, node) {
@@ -165,17 +170,23 @@ static mx_status_t libname_to_vmo(const char* libname, mx_handle_t* out) {
         log(ERROR, "devcoord: cannot find driver '%s'\n", libname);
         return MX_ERR_NOT_FOUND;
     }
-    int fd = open(libname, O_RDONLY);
-    if (fd < 0) {
-        log(ERROR, "devcoord: cannot open driver '%s'\n", libname);
-        return MX_ERR_IO;
-    }
-    mx_status_t r = mxio_get_vmo(fd, out);
-    close(fd);
-    if (r < 0) {
-        log(ERROR, "devcoord: cannot get driver vmo '%s'\n", libname);
+    // cache the driver vmo, so binding the same driver to every device
+    // on a bus doesn't reread the library from the filesystem each time
+    if (drv->dso_vmo == MX_HANDLE_INVALID) {
+        int fd = open(libname, O_RDONLY);
+        if (fd < 0) {
+            log(ERROR, "devcoord: cannot open driver '%s'\n", libname);
+            return MX_ERR_IO;
+        }
+        mx_status_t r = mxio_get_vmo(fd, &drv->dso_vmo);
+        close(fd);
+        if (r < 0) {
+            log(ERROR, "devcoord: cannot get driver vmo '%s'\n", libname);
+            drv->dso_vmo = MX_HANDLE_INVALID;
+            return r;
+        }
     }
-    return r;
+    return mx_handle_duplicate(drv->dso_vmo, MX_RIGHT_SAME_RIGHTS, out);
 }
 
 static device_t root_device = {
@@ -570,6 +581,49 @@ static mx_status_t dc_launch_devhost(devhost_t* host,
     return MX_OK;
 }
 
+// context for a devhost launch running on a worker thread
+typedef struct {
+    port_handler_t ph;
+    devhost_t* host;
+    mx_handle_t hrpc;
+    mx_status_t status;
+    char name[32];
+} devhost_launch_t;
+
+static void dc_release_devhost(devhost_t* dh);
+
+// runs on the coordinator thread once the launch thread is done
+static mx_status_t dc_handle_launch_done(port_handler_t* ph, mx_signals_t signals, uint32_t evt) {
+    devhost_launch_t* launch = containerof(ph, devhost_launch_t, ph);
+    devhost_t* dh = launch->host;
+
+    if (launch->status < 0) {
+        log(ERROR, "devcoord: devhost '%s' never started: %d\n",
+            launch->name, launch->status);
+        // Closing our end of the rpc channel discards the create and
+        // bind messages queued while the launch was in flight.  The
+        // devices wired to this host observe their channels closing
+        // and are torn down through the usual removal path.
+        dh->flags |= DEV_HOST_DYING;
+        mx_handle_close(dh->hrpc);
+        dh->hrpc = MX_HANDLE_INVALID;
+    }
+
+    free(launch);
+
+    // drop the reference held by the launch thread
+    dc_release_devhost(dh);
+    return MX_OK;
+}
+
+static int dc_launch_devhost_thread(void* arg) {
+    devhost_launch_t* launch = arg;
+    launch->status = dc_launch_devhost(launch->host, launch->name, launch->hrpc);
+    // commit the result on the coordinator thread
+    port_queue(&dc_port, &launch->ph, 0);
+    return 0;
+}
+
 static mx_status_t dc_new_devhost(const char* name, devhost_t** out) {
     devhost_t* dh = calloc(1, sizeof(devhost_t));
     if (dh == NULL) {
@@ -583,14 +637,42 @@ static mx_status_t dc_new_devhost(const char* name, devhost_t** out) {
         return r;
     }
 
+    list_initialize(&dh->devices);
+
+    // Launch the devhost process on a worker thread.  Messages written
+    // to dh->hrpc sit in the channel until the new process starts
+    // reading them, so callers can create devices and bind drivers
+    // against this host immediately, and independent bus devhosts
+    // launch in parallel during enumeration instead of serializing
+    // boot behind process creation.
+    devhost_launch_t* launch;
+    if ((launch = calloc(1, sizeof(devhost_launch_t))) != NULL) {
+        launch->ph.func = dc_handle_launch_done;
+        launch->host = dh;
+        launch->hrpc = hrpc;
+        strlcpy(launch->name, name, sizeof(launch->name));
+
+        // the launch holds a host reference until it completes
+        dh->refcount++;
+
+        thrd_t t;
+        if (thrd_create_with_name(&t, dc_launch_devhost_thread, launch,
+                                  "devhost-launch") == thrd_success) {
+            thrd_detach(t);
+            *out = dh;
+            return MX_OK;
+        }
+        dh->refcount--;
+        free(launch);
+    }
+
+    // no worker; launch in place
     if ((r = dc_launch_devhost(dh, name, hrpc)) < 0) {
         mx_handle_close(dh->hrpc);
         free(dh);
         return r;
     }
 
-    list_initialize(&dh->devices);
-
     *out = dh;
     return MX_OK;
 }
@@ -1216,6 +1298,54 @@ static mx_status_t dh_bind_driver(device_t* dev, const char* libname) {
     return MX_OK;
 }
 
+// Devhost co-location policy.
+//
+// By default every bus device gets its own devhost, with a proxy device
+// in between, so a request crosses a channel at each such boundary. The
+// devmgr.colocate boot argument lists protocol classes (by the short
+// names from ddk/protodefs.h, e.g. "devmgr.colocate=pci,acpi-bus") whose
+// drivers are instead bound in the devhost their device already lives
+// in, trading fault isolation between those drivers for in-process
+// dispatch through the whole chain.
+#define MAX_COLOCATE 8
+static uint32_t colocate_protos[MAX_COLOCATE];
+static size_t colocate_count;
+
+static uint32_t proto_id_by_name(const char* name, size_t len) {
+#define DDK_PROTOCOL_DEF(tag, val, pname, flags) \
+    if ((strlen(pname) == len) && !memcmp(name, pname, len)) return val;
+#include <ddk/protodefs.h>
+    return 0;
+}
+
+static void dc_colocate_init(void) {
+    const char* list = getenv("devmgr.colocate");
+    if (list == NULL) {
+        return;
+    }
+    while (*list && (colocate_count < MAX_COLOCATE)) {
+        const char* next = strchr(list, ',');
+        size_t len = next ? (size_t) (next - list) : strlen(list);
+        uint32_t id = proto_id_by_name(list, len);
+        if (id != 0) {
+            colocate_protos[colocate_count++] = id;
+        } else {
+            log(ERROR, "devcoord: devmgr.colocate: unknown class '%.*s'\n",
+                (int) len, list);
+        }
+        list = next ? next + 1 : list + len;
+    }
+}
+
+static bool dc_should_colocate(device_t* dev) {
+    for (size_t n = 0; n < colocate_count; n++) {
+        if (colocate_protos[n] == dev->protocol_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static mx_status_t dc_attempt_bind(driver_t* drv, device_t* dev) {
     // cannot bind driver to already bound device
     if ((dev->flags & DEV_CTX_BOUND) && (!(dev->flags & DEV_CTX_MULTI_BIND))) {
@@ -1230,6 +1360,16 @@ static mx_status_t dc_attempt_bind(driver_t* drv, device_t* dev) {
         return dh_bind_driver(dev, drv->libname);
     }
 
+    // Co-located classes skip the proxy devhost and bind in the devhost
+    // where the device already lives; the new driver then reaches the
+    // bus driver through in-process device ops rather than a channel.
+    if ((dev->host != NULL) && !(dev->flags & DEV_CTX_SHADOW) &&
+        dc_should_colocate(dev)) {
+        log(INFO, "devcoord: colocating drv='%s' with dev='%s'\n",
+            drv->name, dev->name);
+        return dh_bind_driver(dev, drv->libname);
+    }
+
     // busdev args are "processname,args"
     const char* arg0 = (dev->flags & DEV_CTX_SHADOW) ? dev->parent->args : dev->args;
     const char* arg1 = strchr(arg0, ',');
@@ -1264,8 +1404,29 @@ static mx_status_t dc_attempt_bind(driver_t* drv, device_t* dev) {
 }
 
 static void dc_handle_new_device(device_t* dev) {
-    driver_t* drv;
+    driver_t* matches[BC_MAX_MATCHES];
+    uint32_t match_count = 0;
+    bool want_all = !!(dev->flags & DEV_CTX_MULTI_BIND);
+
+    // binding programs read nothing but the protocol id and properties,
+    // so devices sharing those reuse the cached match set instead of
+    // re-running every driver's program
+    if (bc_lookup(dev->protocol_id, dev->props, dev->prop_count,
+                  want_all, matches, &match_count)) {
+        for (uint32_t n = 0; n < match_count; n++) {
+            log(INFO, "devcoord: drv='%s' bindable to dev='%s'\n",
+                matches[n]->name, dev->name);
 
+            dc_attempt_bind(matches[n], dev);
+            if (!want_all) {
+                break;
+            }
+        }
+        return;
+    }
+
+    driver_t* drv;
+    bool cacheable = true;
     list_for_every_entry(&list_drivers, drv, driver_t, node) {
         if (dc_is_bindable(drv, dev->protocol_id,
                            dev->props, dev->prop_count, true)) {
@@ -1273,11 +1434,22 @@ static void dc_handle_new_device(device_t* dev) {
                 drv->name, dev->name);
 
             dc_attempt_bind(drv, dev);
-            if (!(dev->flags & DEV_CTX_MULTI_BIND)) {
+            if (match_count < BC_MAX_MATCHES) {
+                matches[match_count++] = drv;
+            } else {
+                // too many matches to record; still bind them all
+                cacheable = false;
+            }
+            if (!want_all) {
                 break;
             }
         }
     }
+    if (cacheable) {
+        // the set is complete unless the scan stopped at the first match
+        bc_store(dev->protocol_id, dev->props, dev->prop_count,
+                 want_all || (match_count == 0), matches, match_count);
+    }
 }
 
 // device binding program that pure (parentless)
@@ -1317,6 +1489,8 @@ static bool is_platform_bus_driver(driver_t* drv) {
 static work_t new_driver_work;
 
 void dc_driver_added(driver_t* drv, const char* version) {
+    // a new driver can change any device's match set
+    bc_invalidate();
     if (dc_running) {
         list_add_head(&list_drivers_new, &drv->node);
         if (new_driver_work.op == WORK_IDLE) {
@@ -1413,6 +1587,8 @@ void dc_bind_driver(driver_t* drv) {
 void dc_handle_new_driver(void) {
     driver_t* drv;
     while ((drv = list_remove_head_type(&list_drivers_new, driver_t, node)) != NULL) {
+        // cached match sets predate this driver joining the list
+        bc_invalidate();
         list_add_tail(&list_drivers, &drv->node);
         dc_bind_driver(drv);
     }
@@ -1452,6 +1628,7 @@ void coordinator(void) {
     if (getenv("devmgr.verbose")) {
         log_flags |= LOG_DEVLC;
     }
+    dc_colocate_init();
     acpi_init();
 
     devfs_publish(&root_device, &misc_device);
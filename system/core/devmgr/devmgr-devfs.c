@@ -29,6 +29,11 @@ struct dc_watcher {
     devnode_t* devnode;
     uint32_t mask;
     mx_handle_t handle;
+    // name prefix this watcher subscribed to; zero length matches all.
+    // Checked before the channel write so non-matching events do not
+    // wake the watcher at all.
+    uint32_t filter_len;
+    char filter[VFS_WATCH_FILTER_MAX];
 };
 
 struct dc_devnode {
@@ -222,6 +227,13 @@ static void devfs_notify(devnode_t* dn, const char* name, unsigned op) {
     for (wp = &dn->watchers; w != NULL; w = next) {
         next = w->next;
         if (!(w->mask & op)) {
+            wp = &w->next;
+            continue;
+        }
+        // nameless events (DELETED, IDLE) are delivered regardless of filter
+        if ((len > 0) && (w->filter_len > 0) &&
+            ((len < w->filter_len) || memcmp(name, w->filter, w->filter_len))) {
+            wp = &w->next;
             continue;
         }
         if (mx_channel_write(w->handle, 0, msg, len + 2, NULL, 0) < 0) {
@@ -234,7 +246,8 @@ static void devfs_notify(devnode_t* dn, const char* name, unsigned op) {
     }
 }
 
-static mx_status_t devfs_watch_v2(devnode_t* dn, mx_handle_t h, uint32_t mask) {
+static mx_status_t devfs_watch_v2(devnode_t* dn, mx_handle_t h, uint32_t mask,
+                                  const char* filter) {
     watcher_t* watcher = calloc(1, sizeof(watcher_t));
     if (watcher == NULL) {
         return MX_ERR_NO_MEMORY;
@@ -244,6 +257,10 @@ static mx_status_t devfs_watch_v2(devnode_t* dn, mx_handle_t h, uint32_t mask) {
     watcher->next = dn->watchers;
     watcher->handle = h;
     watcher->mask = mask;
+    if (filter != NULL) {
+        watcher->filter_len = strlen(filter);
+        memcpy(watcher->filter, filter, watcher->filter_len);
+    }
     dn->watchers = watcher;
 
     if (mask & VFS_WATCH_MASK_EXISTING) {
@@ -656,7 +673,22 @@ static mx_status_t devfs_rio_handler(mxrio_msg_t* msg, void* cookie) {
                 (wd->mask & (~VFS_WATCH_MASK_ALL))) {
                 r = MX_ERR_INVALID_ARGS;
             } else {
-                r = devfs_watch_v2(dn, msg->handle[0], wd->mask);
+                r = devfs_watch_v2(dn, msg->handle[0], wd->mask, NULL);
+            }
+            if (r != MX_OK) {
+                mx_handle_close(msg->handle[0]);
+            }
+            return r;
+        }
+        case IOCTL_VFS_WATCH_DIR_FILTERED: {
+            vfs_watch_dir_filtered_t* wd = (vfs_watch_dir_filtered_t*) msg->data;
+            if ((len != sizeof(vfs_watch_dir_filtered_t)) ||
+                (wd->options != 0) ||
+                (wd->mask & (~VFS_WATCH_MASK_ALL)) ||
+                (memchr(wd->filter, 0, sizeof(wd->filter)) == NULL)) {
+                r = MX_ERR_INVALID_ARGS;
+            } else {
+                r = devfs_watch_v2(dn, msg->handle[0], wd->mask, wd->filter);
             }
             if (r != MX_OK) {
                 mx_handle_close(msg->handle[0]);
@@ -278,9 +278,16 @@ static void setup_bootfs(void) {
             case BOOTDATA_BOOTFS_SYSTEM: {
                 const char* errmsg;
                 mx_handle_t bootfs_vmo;
-                status = decompress_bootdata(mx_vmar_root_self(), vmo,
-                                             off, bootdata.length + sizeof(bootdata),
-                                             &bootfs_vmo, &errmsg);
+                status = decompress_bootdata_parallel(mx_vmar_root_self(), vmo,
+                                                      off, bootdata.length + sizeof(bootdata),
+                                                      &bootfs_vmo, &errmsg);
+                if (status < 0) {
+                    // Fall back to the serial decoder; the parallel one
+                    // requires full-sized mid-stream blocks.
+                    status = decompress_bootdata(mx_vmar_root_self(), vmo,
+                                                 off, bootdata.length + sizeof(bootdata),
+                                                 &bootfs_vmo, &errmsg);
+                }
                 if (status < 0) {
                     printf("devmgr: failed to decompress bootdata: %s\n", errmsg);
                 } else {
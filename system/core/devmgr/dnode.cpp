@@ -45,6 +45,7 @@ void Dnode::RemoveFromParent() {
     // Detach from parent
     if (parent_) {
         parent_->children_.erase(*this);
+        parent_->names_.erase(*this);
         if (IsDirectory()) {
             // '..' no longer references parent.
             parent_->vnode_->link_count_--;
@@ -93,14 +94,13 @@ void Dnode::AddChild(mxtl::RefPtr<Dnode> parent, mxtl::RefPtr<Dnode> child) {
     } else {
         child->ordering_token_ = parent->children_.back().ordering_token_ + 1;
     }
+    parent->names_.insert(child);
     parent->children_.push_back(mxtl::move(child));
 }
 
 mx_status_t Dnode::Lookup(const char* name, size_t len, mxtl::RefPtr<Dnode>* out) const {
-    auto dn = children_.find_if([&name, &len](const Dnode& elem) -> bool {
-        return elem.NameMatch(name, len);
-    });
-    if (dn == children_.end()) {
+    auto dn = names_.find(NameKey{name, len});
+    if (dn == names_.end()) {
         return MX_ERR_NOT_FOUND;
     }
 
@@ -188,6 +188,9 @@ mxtl::unique_ptr<char[]> Dnode::TakeName() {
 }
 
 void Dnode::PutName(mxtl::unique_ptr<char[]> name, size_t len) {
+    // The name is the key of the parent's name index; it may only be
+    // replaced while the dnode is parent-less.
+    MX_DEBUG_ASSERT(!type_name_state_.InContainer());
     flags_ = static_cast<uint32_t>((flags_ & ~kDnodeNameMax) | len);
     name_ = mxtl::move(name);
 }
@@ -202,8 +205,4 @@ size_t Dnode::NameLen() const {
     return flags_ & kDnodeNameMax;
 }
 
-bool Dnode::NameMatch(const char* name, size_t len) const {
-    return (NameLen() == len) && (memcmp(name_.get(), name, len) == 0);
-}
-
 } // namespace memfs
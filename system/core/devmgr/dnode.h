@@ -10,6 +10,7 @@
 #include <fs/vfs.h>
 #include <mxio/vfs.h>
 #include <mxtl/intrusive_double_list.h>
+#include <mxtl/intrusive_wavl_tree.h>
 #include <mxtl/ref_counted.h>
 #include <mxtl/ref_ptr.h>
 #include <mxtl/unique_ptr.h>
@@ -39,8 +40,38 @@ public:
     // vnode appear in multiple locations within "/dev".
     struct TypeDeviceTraits { static NodeState& node_state(Dnode& dn) { return dn.type_device_state_; }};
 
+    using TreeNodeState = mxtl::WAVLTreeNodeState<mxtl::RefPtr<Dnode>>;
+
+    // NameTraits is the state used for a Dnode to appear in its parent's
+    // name index, so lookup in a large directory does not degrade to a
+    // linear walk of the child list.
+    struct TypeNameTraits { static TreeNodeState& node_state(Dnode& dn) { return dn.type_name_state_; }};
+
+    // A view of a dnode's name, used as the key of the name index. Only
+    // valid while the name it aliases is unchanged; dnodes must be
+    // removed from their parent before their name may be replaced.
+    struct NameKey {
+        const char* name;
+        size_t len;
+    };
+
+    struct NameKeyTraits {
+        static NameKey GetKey(const Dnode& dn) {
+            return NameKey{dn.name_.get(), dn.NameLen()};
+        }
+        static bool LessThan(const NameKey& a, const NameKey& b) {
+            int cmp = memcmp(a.name, b.name, (a.len < b.len) ? a.len : b.len);
+            return (cmp < 0) || ((cmp == 0) && (a.len < b.len));
+        }
+        static bool EqualTo(const NameKey& a, const NameKey& b) {
+            return (a.len == b.len) && (memcmp(a.name, b.name, a.len) == 0);
+        }
+    };
+
     using ChildList = mxtl::DoublyLinkedList<mxtl::RefPtr<Dnode>, Dnode::TypeChildTraits>;
     using DeviceList = mxtl::DoublyLinkedList<mxtl::RefPtr<Dnode>, Dnode::TypeDeviceTraits>;
+    using NameTree = mxtl::WAVLTree<NameKey, mxtl::RefPtr<Dnode>,
+                                    Dnode::NameKeyTraits, Dnode::TypeNameTraits>;
 
     // Allocates a dnode, attached to a vnode
     static mxtl::RefPtr<Dnode> Create(const char* name, size_t len, mxtl::RefPtr<VnodeMemfs> vn);
@@ -96,19 +127,24 @@ public:
 private:
     friend struct TypeChildTraits;
     friend struct TypeDeviceTraits;
+    friend struct TypeNameTraits;
+    friend struct NameKeyTraits;
 
     Dnode(mxtl::RefPtr<VnodeMemfs> vn, mxtl::unique_ptr<char[]> name, uint32_t flags);
 
     size_t NameLen() const;
-    bool NameMatch(const char* name, size_t len) const;
 
     NodeState type_child_state_;
     NodeState type_device_state_;
+    TreeNodeState type_name_state_;
     mxtl::RefPtr<VnodeMemfs> vnode_;
     mxtl::RefPtr<Dnode> parent_;
     // Used to impose an absolute order on dnodes within a directory.
     size_t ordering_token_;
+    // All children, in creation order (the order visible to readdir)...
     ChildList children_;
+    // ... and the same children, indexed by name for lookup.
+    NameTree names_;
     uint32_t flags_;
     mxtl::unique_ptr<char[]> name_;
 };
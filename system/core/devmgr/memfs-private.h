@@ -70,6 +70,9 @@ private:
 
     mx_handle_t vmo_;
     mx_off_t length_;
+    // Size of vmo_, which is grown ahead of length_ in doubling extents
+    // so a series of small appends doesn't resize the VMO per write.
+    mx_off_t vmo_size_;
 };
 
 class VnodeDir : public VnodeMemfs {
@@ -22,6 +22,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/dnode.cpp \
     $(LOCAL_DIR)/devhost-shared.c \
     $(LOCAL_DIR)/devmgr.c \
+    $(LOCAL_DIR)/devmgr-bindcache.c \
     $(LOCAL_DIR)/devmgr-binding.c \
     $(LOCAL_DIR)/devmgr-coordinator.c \
     $(LOCAL_DIR)/devmgr-devfs.c \
@@ -10,12 +10,13 @@
 #include <sys/stat.h>
 
 #include <ddk/device.h>
-#include <fs/mxio-dispatcher.h>
+#include <fs/vfs-dispatcher.h>
 #include <fs/vfs.h>
 #include <magenta/device/vfs.h>
 #include <magenta/thread_annotations.h>
 #include <mxalloc/new.h>
 #include <mxio/debug.h>
+#include <mxio/remoteio.h>
 #include <mxio/vfs.h>
 #include <mxtl/algorithm.h>
 #include <mxtl/auto_lock.h>
@@ -32,7 +33,13 @@ namespace memfs {
 namespace {
 
 fs::Vfs vfs;
-mxtl::unique_ptr<fs::MxioDispatcher> global_dispatcher;
+mxtl::unique_ptr<fs::VfsDispatcher> global_dispatcher;
+
+// Number of dispatcher threads serving memfs. The service-discovery path
+// hits /svc and /dev lookups from many processes at once; with per-vnode
+// locking in the rio handler, requests against independent vnodes may be
+// processed in parallel.
+constexpr uint32_t kDispatcherPoolSize = 4;
 
 }
 
@@ -59,8 +66,9 @@ VnodeMemfs::VnodeMemfs() : seqcount_(0), dnode_(nullptr), link_count_(0) {
 VnodeMemfs::~VnodeMemfs() {
 }
 
-VnodeFile::VnodeFile() : vmo_(MX_HANDLE_INVALID), length_(0) {}
-VnodeFile::VnodeFile(mx_handle_t vmo, mx_off_t length) : vmo_(vmo), length_(length) {}
+VnodeFile::VnodeFile() : vmo_(MX_HANDLE_INVALID), length_(0), vmo_size_(0) {}
+VnodeFile::VnodeFile(mx_handle_t vmo, mx_off_t length) :
+    vmo_(vmo), length_(length), vmo_size_(length) {}
 
 VnodeFile::~VnodeFile() {
     if (vmo_ != MX_HANDLE_INVALID) {
@@ -174,18 +182,25 @@ ssize_t VnodeFile::Write(const void* data, size_t len, size_t off) {
     size_t newlen = off + len;
     newlen = newlen > kMemfsMaxFileSize ? kMemfsMaxFileSize : newlen;
 
-    // TODO(smklein): Round up to PAGE_SIZE increments to reduce overhead on a series of small
-    // writes.
-    if (vmo_ == MX_HANDLE_INVALID) {
-        // First access to the file? Allocate it.
-        if ((status = mx_vmo_create(newlen, 0, &vmo_)) != MX_OK) {
-            return status;
+    if (newlen > vmo_size_) {
+        // Accessing beyond the end of the underlying VMO? Grow it in
+        // doubling extents rather than to the exact new length, so a
+        // stream of small appends amortizes to a constant number of
+        // resize syscalls per page rather than one per write.
+        size_t alloc = vmo_size_ ? vmo_size_ : PAGE_SIZE;
+        while (alloc < newlen) {
+            alloc <<= 1;
         }
-    } else if (newlen > length_) {
-        // Accessing beyond the end of the file? Extend it.
-        if ((status = mx_vmo_set_size(vmo_, newlen)) != MX_OK) {
+        alloc = alloc > kMemfsMaxFileSize ? kMemfsMaxFileSize : alloc;
+        if (vmo_ == MX_HANDLE_INVALID) {
+            // First access to the file? Allocate it.
+            if ((status = mx_vmo_create(alloc, 0, &vmo_)) != MX_OK) {
+                return status;
+            }
+        } else if ((status = mx_vmo_set_size(vmo_, alloc)) != MX_OK) {
             return status;
         }
+        vmo_size_ = alloc;
     }
 
     size_t actual;
@@ -398,6 +413,9 @@ mx_status_t VnodeFile::Truncate(size_t len) {
         return status;
     }
 
+    // Truncate resizes the VMO exactly; growth beyond this point begins
+    // doubling anew.
+    vmo_size_ = len;
     length_ = len;
     modify_time_ = mx_time_get(MX_CLOCK_UTC);
     return MX_OK;
@@ -786,8 +804,10 @@ mx_handle_t vfs_create_root_handle(VnodeMemfs* vn) {
     if ((r = mx::channel::create(0, &h1, &h2)) != MX_OK) {
         return r;
     }
-    fs::MxioDispatcher::Create(&memfs::global_dispatcher);
-    memfs::global_dispatcher->StartThread();
+    if ((r = fs::VfsDispatcher::Create(mxrio_handler, memfs::kDispatcherPoolSize,
+                                       &memfs::global_dispatcher)) != MX_OK) {
+        return r;
+    }
     memfs::vfs.SetDispatcher(memfs::global_dispatcher.get());
     if ((r = memfs::vfs.ServeDirectory(mxtl::RefPtr<fs::Vnode>(vn),
                                        mxtl::move(h1))) != MX_OK) {
@@ -12,6 +12,13 @@
 
 #define MAX_LOG_LINE (MX_LOG_RECORD_MAX + 32)
 
+// How long to hold a partially-filled packet open for more log lines.
+#define FLUSH_WINDOW MX_MSEC(5)
+
+// How long to wait before resending an unacknowledged packet, and
+// between polls for new log lines when idle.
+#define RETRY_INTERVAL MX_MSEC(100)
+
 static mx_handle_t loghandle;
 static logpacket_t pkt;
 static int pkt_len;
@@ -21,6 +28,9 @@ static volatile uint32_t pending = 0;
 
 mx_time_t debuglog_next_timeout;
 
+// When a partially-filled packet must go out even if more lines would fit.
+static mx_time_t pkt_deadline;
+
 static int get_log_line(char* out) {
     char buf[MX_LOG_RECORD_MAX + 1];
     mx_log_record_t* rec = (mx_log_record_t*)buf;
@@ -49,37 +59,48 @@ int debuglog_init(void) {
 
     seqno = 1;
     pending = 0;
+    pkt_len = 0;
 
     return 0;
 }
 
-// If we have an outstanding (unacknowledged) log, resend it. Otherwise, send new logs, if we
-// have any.
+// If we have an outstanding (unacknowledged) log, resend it. Otherwise, accumulate new log
+// lines into the packet and send it once it is full or its flush window expires.
 static void debuglog_send(void) {
+    mx_time_t now = mx_time_get(MX_CLOCK_MONOTONIC);
     if (pending == 0) {
-        pkt.magic = NB_DEBUGLOG_MAGIC;
-        pkt.seqno = seqno;
-        strncpy(pkt.nodename, nodename, sizeof(pkt.nodename) - 1);
-        pkt_len = 0;
+        if (pkt_len == 0) {
+            pkt.magic = NB_DEBUGLOG_MAGIC;
+            pkt.seqno = seqno;
+            strncpy(pkt.nodename, nodename, sizeof(pkt.nodename) - 1);
+        }
         while (pkt_len < (MAX_LOG_DATA - MAX_LOG_LINE)) {
             int r = get_log_line(pkt.data + pkt_len);
             if (r > 0) {
+                if (pkt_len == 0) {
+                    pkt_deadline = now + FLUSH_WINDOW;
+                }
                 pkt_len += r;
             } else {
                 break;
             }
         }
-        if (pkt_len) {
-            // include header and nodename in length
-            pkt_len += MAX_NODENAME_LENGTH + sizeof(uint32_t) * 2;
-            pending = 1;
-        } else {
-            goto done;
+        if (pkt_len == 0) {
+            debuglog_next_timeout = now + RETRY_INTERVAL;
+            return;
+        }
+        if ((pkt_len < (MAX_LOG_DATA - MAX_LOG_LINE)) && (now < pkt_deadline)) {
+            // Hold the partial packet open so a burst of short lines shares one
+            // datagram instead of going out line by line.
+            debuglog_next_timeout = pkt_deadline;
+            return;
         }
+        // include header and nodename in length
+        pkt_len += MAX_NODENAME_LENGTH + sizeof(uint32_t) * 2;
+        pending = 1;
     }
     udp6_send(&pkt, pkt_len, &ip6_ll_all_nodes, DEBUGLOG_PORT, DEBUGLOG_ACK_PORT);
-done:
-    debuglog_next_timeout = mx_time_get(MX_CLOCK_MONOTONIC) + MX_MSEC(100);
+    debuglog_next_timeout = now + RETRY_INTERVAL;
 }
 
 void debuglog_recv(void* data, size_t len, bool is_mcast) {
@@ -97,6 +118,7 @@ void debuglog_recv(void* data, size_t len, bool is_mcast) {
 
     seqno++;
     pending = 0;
+    pkt_len = 0;
     debuglog_send();
 }
 
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
@@ -28,6 +29,132 @@ netfile_state netfile = {
     .needs_rename = false,
 };
 
+// Writes are queued here and executed on a separate thread so that the
+// network poll loop never stalls on filesystem I/O. netsvc handles all
+// traffic (debuglog, netboot, tftp) on one thread, so while an image is
+// being received every filesystem stall delays the other services and
+// shows up on the wire as dropped packets and retransmits. Errors from
+// queued writes are reported on a later write, or on close, once the
+// worker catches up.
+#define WRITE_QUEUE_ENTRIES 16
+#define WRITE_QUEUE_DATA_MAX 2048
+
+typedef struct {
+    off_t offset;  // -1 for sequential writes
+    size_t len;
+    uint8_t data[WRITE_QUEUE_DATA_MAX];
+} netfile_write_op;
+
+static struct {
+    netfile_write_op op[WRITE_QUEUE_ENTRIES];
+    uint32_t head;  // next entry the worker executes
+    uint32_t tail;  // next entry a caller fills
+    int error;      // first error from a queued write, held until reported
+    bool started;
+    cnd_t work;     // signaled when ops are queued
+    cnd_t space;    // signaled when ops complete
+} write_queue;
+
+static mtx_t write_lock = MTX_INIT;
+
+// Performs a write in the calling thread. Only the write worker may call
+// this while ops are queued; everyone else must drain the queue first.
+static int netfile_write_now(const char* data, off_t offset, size_t len) {
+    if (netfile.fd < 0) {
+        printf("netsvc: write, but no open file\n");
+        return -EBADF;
+    }
+    if ((offset >= 0) && (offset != netfile.offset)) {
+        if (lseek(netfile.fd, offset, SEEK_SET) != offset) {
+            return -errno;
+        }
+        netfile.offset = offset;
+    }
+    ssize_t n = write(netfile.fd, data, len);
+    if (n != (ssize_t)len) {
+        printf("netsvc: error writing %s: %d\n", netfile.filename, errno);
+        int result = (errno == 0) ? -EIO : -errno;
+        close(netfile.fd);
+        netfile.fd = -1;
+        return result;
+    }
+    netfile.offset += len;
+    return len;
+}
+
+static int netfile_write_thread(void* arg) {
+    mtx_lock(&write_lock);
+    for (;;) {
+        while (write_queue.head == write_queue.tail) {
+            cnd_wait(&write_queue.work, &write_lock);
+        }
+        netfile_write_op* op = &write_queue.op[write_queue.head % WRITE_QUEUE_ENTRIES];
+        mtx_unlock(&write_lock);
+        int result = netfile_write_now((const char*)op->data, op->offset, op->len);
+        mtx_lock(&write_lock);
+        if ((result < 0) && (write_queue.error == 0)) {
+            write_queue.error = result;
+        }
+        write_queue.head++;
+        cnd_signal(&write_queue.space);
+    }
+    return 0;
+}
+
+// Waits for all queued writes to complete, after which the caller may
+// operate on the netfile state directly. Returns (and clears) the first
+// error hit by a queued write since the last drain.
+static int netfile_drain_writes(void) {
+    mtx_lock(&write_lock);
+    while (write_queue.head != write_queue.tail) {
+        cnd_wait(&write_queue.space, &write_lock);
+    }
+    int error = write_queue.error;
+    write_queue.error = 0;
+    mtx_unlock(&write_lock);
+    return error;
+}
+
+static int netfile_queue_write(const char* data, off_t offset, size_t len) {
+    mtx_lock(&write_lock);
+    if (!write_queue.started) {
+        cnd_init(&write_queue.work);
+        cnd_init(&write_queue.space);
+        thrd_t t;
+        if (thrd_create_with_name(&t, netfile_write_thread, NULL,
+                                  "netfile-write") == thrd_success) {
+            thrd_detach(t);
+            write_queue.started = true;
+        }
+    }
+    if (!write_queue.started || (len > WRITE_QUEUE_DATA_MAX)) {
+        // No worker (or an oversized request); write in place, after
+        // anything already queued.
+        while (write_queue.head != write_queue.tail) {
+            cnd_wait(&write_queue.space, &write_lock);
+        }
+        mtx_unlock(&write_lock);
+        return netfile_write_now(data, offset, len);
+    }
+    int error = write_queue.error;
+    if (error < 0) {
+        write_queue.error = 0;
+        mtx_unlock(&write_lock);
+        return error;
+    }
+    while (write_queue.tail - write_queue.head == WRITE_QUEUE_ENTRIES) {
+        cnd_wait(&write_queue.space, &write_lock);
+    }
+    netfile_write_op* op = &write_queue.op[write_queue.tail % WRITE_QUEUE_ENTRIES];
+    op->offset = offset;
+    op->len = len;
+    memcpy(op->data, data, len);
+    write_queue.tail++;
+    cnd_signal(&write_queue.work);
+    mtx_unlock(&write_lock);
+    return (int)len;
+}
+
 static int netfile_mkdir(const char* filename) {
     const char* ptr = filename[0] == '/' ? filename + 1 : filename;
     struct stat st;
@@ -53,6 +180,10 @@ static int netfile_mkdir(const char* filename) {
 }
 
 int netfile_open(const char *filename, uint32_t arg) {
+    // Any errors from the old file's queued writes were already logged by
+    // the worker; this open starts fresh.
+    netfile_drain_writes();
+
     if (netfile.fd >= 0) {
         printf("netsvc: closing still-open '%s', replacing with '%s'\n", netfile.filename, filename);
         close(netfile.fd);
@@ -110,6 +241,7 @@ err:
 }
 
 int netfile_offset_read(void* data_out, off_t offset, size_t max_len) {
+    netfile_drain_writes();
     if (netfile.fd < 0) {
         printf("netsvc: read, but no open file\n");
         return -EBADF;
@@ -124,6 +256,7 @@ int netfile_offset_read(void* data_out, off_t offset, size_t max_len) {
 }
 
 int netfile_read(void *data_out, size_t data_sz) {
+    netfile_drain_writes();
     if (netfile.fd < 0) {
         printf("netsvc: read, but no open file\n");
         return -EBADF;
@@ -141,40 +274,21 @@ int netfile_read(void *data_out, size_t data_sz) {
 }
 
 int netfile_offset_write(const char* data, off_t offset, size_t length) {
-    if (netfile.fd < 0) {
-        printf("netsvc: write, but no open file\n");
-        return -EBADF;
-    }
-    if (offset != netfile.offset) {
-        if (lseek(netfile.fd, offset, SEEK_SET) != offset) {
-            return -errno;
-        }
-        netfile.offset = offset;
-    }
-    return netfile_write(data, length);
+    return netfile_queue_write(data, offset, length);
 }
 
 int netfile_write(const char* data, size_t len) {
-    if (netfile.fd < 0) {
-        printf("netsvc: write, but no open file\n");
-        return -EBADF;
-    }
-    ssize_t n = write(netfile.fd, data, len);
-    if (n != (ssize_t)len) {
-        printf("netsvc: error writing %s: %d\n", netfile.filename, errno);
-        int result = (errno == 0) ? -EIO : -errno;
-        close(netfile.fd);
-        netfile.fd = -1;
-        return result;
-    }
-    netfile.offset += len;
-    return len;
+    return netfile_queue_write(data, -1, len);
 }
 
 int netfile_close(void) {
-    int result = 0;
+    int result = netfile_drain_writes();
     if (netfile.fd < 0) {
-        printf("netsvc: close, but no open file\n");
+        // A failed queued write already closed the file (and we're about
+        // to report that failure); only complain on a plain double close.
+        if (result == 0) {
+            printf("netsvc: close, but no open file\n");
+        }
     } else {
         if (netfile.needs_rename) {
             char src[PATH_MAX];
@@ -184,7 +298,7 @@ int netfile_close(void) {
                 printf("netsvc: failed to rename temporary file: %s\n", strerror(errno));
             }
         }
-        if (close(netfile.fd)) {
+        if (close(netfile.fd) && (result == 0)) {
             result = (errno == 0) ? -EIO : -errno;
         }
         netfile.fd = -1;
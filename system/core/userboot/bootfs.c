@@ -69,6 +69,43 @@ static struct bootfs_file bootfs_search(mx_handle_t log,
 
     size_t filename_len = strlen(filename) + 1;
 
+    if (magic->boothdr.flags & BOOTDATA_BOOTFS_FLAG_INDEXED) {
+        // The directory is sorted by name and preceded by a table of
+        // entry offsets, so the file can be found by binary search.
+        uint32_t count;
+        memcpy(&count, p, sizeof(count));
+        size_t dir_len = fs->len - magic_size;
+        if (sizeof(uint32_t) * ((size_t)count + 1) > dir_len)
+            fail(log, MX_ERR_INVALID_ARGS, "bootfs has bogus index\n");
+        uint32_t lo = 0;
+        uint32_t hi = count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            uint32_t entry_off;
+            memcpy(&entry_off, &p[sizeof(uint32_t) * (mid + 1)],
+                   sizeof(entry_off));
+            if (entry_off > dir_len - sizeof(struct bootfs_header))
+                fail(log, MX_ERR_INVALID_ARGS,
+                     "bootfs has bogus index entry\n");
+            struct bootfs_header header;
+            memcpy(&header, &p[entry_off], sizeof(header));
+            if (header.namelen == 0 ||
+                header.namelen > dir_len - entry_off - sizeof(header))
+                fail(log, MX_ERR_INVALID_ARGS,
+                     "bootfs has bogus namelen in header\n");
+            const char* name = (const void*)&p[entry_off + sizeof(header)];
+            int cmp = strncmp(filename, name, header.namelen);
+            if (cmp == 0)
+                return header.file;
+            if (cmp < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        struct bootfs_file runt = { 0, 0 };
+        return runt;
+    }
+
     while ((size_t)(p - fs->contents) < fs->len) {
         struct bootfs_header header;
         memcpy(&header, p, sizeof(header));
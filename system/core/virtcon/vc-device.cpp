@@ -63,10 +63,18 @@ static mx_status_t vc_setup(vc_t* vc) {
     if (!vc->text_buf)
         return MX_ERR_NO_MEMORY;
 
-    // allocate the scrollback buffer
-    vc->scrollback_buf = reinterpret_cast<vc_char_t*>(
-        calloc(1, vc->scrollback_rows_max * vc->columns * sizeof(vc_char_t)));
-    if (!vc->scrollback_buf) {
+    // allocate the scrollback line table; row contents are allocated as
+    // lines are pushed, sized to the compressed line
+    vc->scrollback_buf = reinterpret_cast<vc_sb_line_t*>(
+        calloc(1, vc->scrollback_rows_max * sizeof(vc_sb_line_t)));
+    vc->scrollback_scratch = reinterpret_cast<vc_char_t*>(
+        calloc(1, vc->columns * sizeof(vc_char_t)));
+    vc->shadow_buf = reinterpret_cast<uint32_t*>(
+        calloc(1, vc->rows * vc->columns * sizeof(uint32_t)));
+    if (!vc->scrollback_buf || !vc->scrollback_scratch || !vc->shadow_buf) {
+        free(vc->scrollback_buf);
+        free(vc->scrollback_scratch);
+        free(vc->shadow_buf);
         free(vc->text_buf);
         return MX_ERR_NO_MEMORY;
     }
@@ -178,9 +186,30 @@ static void vc_tc_push_scrollback_line(void* cookie, int y) {
         if (vc->scrollback_offset == vc->scrollback_rows_max)
             vc->scrollback_offset = 0;
     }
-    vc_char_t* dst = &vc->scrollback_buf[dest_row * vc->columns];
+    // Store only the cells before the row's trailing run of identical
+    // cells (usually blank padding); the run is regenerated on expansion.
     vc_char_t* src = &vc->text_buf[y * vc->columns];
-    memcpy(dst, src, vc->columns * sizeof(vc_char_t));
+    vc_sb_line_t* line = &vc->scrollback_buf[dest_row];
+    vc_char_t fill = src[vc->columns - 1];
+    unsigned len = vc->columns - 1;
+    while (len > 0 && src[len - 1] == fill)
+        len--;
+    vc_char_t* data = nullptr;
+    if (len > 0) {
+        data = reinterpret_cast<vc_char_t*>(
+            realloc(line->data, len * sizeof(vc_char_t)));
+        if (!data) {
+            // Degrade to an all-fill row rather than dropping the push.
+            len = 0;
+        } else {
+            memcpy(data, src, len * sizeof(vc_char_t));
+        }
+    }
+    if (!data)
+        free(line->data);
+    line->data = data;
+    line->len = static_cast<uint16_t>(len);
+    line->fill = fill;
 
     // If we're displaying only the main console region (and no
     // scrollback), then keep displaying that (i.e. don't modify
@@ -249,6 +278,10 @@ static void vc_tc_copy_lines(void* cookie, int y_dest, int y_src, int line_count
         gfx_copyrect(vc_gfx, 0, y_src * vc->charh,
                      vc_gfx->width, line_count * vc->charh,
                      0, y_dest * vc->charh);
+        // Mirror the pixel move in the shadow cells.
+        memmove(&vc->shadow_buf[y_dest * vc->columns],
+                &vc->shadow_buf[y_src * vc->columns],
+                line_count * vc->columns * sizeof(uint32_t));
 
         // Restore the cursor.
         vc_set_cursor_hidden(vc, old_hide_cursor);
@@ -283,6 +316,8 @@ static void vc_clear_gfx(vc_t* vc) {
     if (vc->active) {
         gfx_fillrect(vc_gfx, 0, 0, vc_gfx->width, vc_gfx->height,
                      palette_to_color(vc, vc->back_color));
+        // No cell shows a known character any more.
+        memset(vc->shadow_buf, 0, vc->rows * vc->columns * sizeof(uint32_t));
     }
 }
 
@@ -349,12 +384,19 @@ int vc_get_scrollback_lines(vc_t* vc) {
     return vc->scrollback_rows_count;
 }
 
+// Expands the stored (compressed) line into the scratch row. The result
+// is only valid until the next call.
 vc_char_t* vc_get_scrollback_line_ptr(vc_t* vc, unsigned row) {
     assert(row < vc->scrollback_rows_count);
     row += vc->scrollback_offset;
     if (row >= vc->scrollback_rows_max)
         row -= vc->scrollback_rows_max;
-    return &vc->scrollback_buf[row * vc->columns];
+    vc_sb_line_t* line = &vc->scrollback_buf[row];
+    vc_char_t* out = vc->scrollback_scratch;
+    memcpy(out, line->data, line->len * sizeof(vc_char_t));
+    for (unsigned i = line->len; i < vc->columns; i++)
+        out[i] = line->fill;
+    return out;
 }
 
 static void vc_scroll_viewport_abs(vc_t* vc, int vpy) {
@@ -377,12 +419,18 @@ static void vc_scroll_viewport_abs(vc_t* vc, int vpy) {
         if (diff > 0) {
             gfx_copyrect(vc_gfx, 0, diff_abs * vc->charh,
                          vc_gfx->width, (rows - diff_abs) * vc->charh, 0, 0);
+            memmove(&vc->shadow_buf[0],
+                    &vc->shadow_buf[diff_abs * vc->columns],
+                    (rows - diff_abs) * vc->columns * sizeof(uint32_t));
             vc_invalidate(vc, 0, vpy + rows - diff_abs, vc->columns,
                                  diff_abs);
         } else {
             gfx_copyrect(vc_gfx, 0, 0, vc_gfx->width,
                          (rows - diff_abs) * vc->charh, 0,
                          diff_abs * vc->charh);
+            memmove(&vc->shadow_buf[diff_abs * vc->columns],
+                    &vc->shadow_buf[0],
+                    (rows - diff_abs) * vc->columns * sizeof(uint32_t));
             vc_invalidate(vc, 0, vpy, vc->columns, diff_abs);
         }
     }
@@ -465,7 +513,11 @@ void vc_free(vc_t* vc) {
         close(vc->fd);
     }
     free(vc->text_buf);
+    for (unsigned i = 0; i < vc->scrollback_rows_max; i++)
+        free(vc->scrollback_buf[i].data);
     free(vc->scrollback_buf);
+    free(vc->scrollback_scratch);
+    free(vc->shadow_buf);
     free(vc);
 }
 
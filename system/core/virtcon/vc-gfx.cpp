@@ -25,10 +25,19 @@ void vc_gfx_draw_char(vc_t* vc, vc_char_t ch, unsigned x, unsigned y,
         fg_color = bg_color;
         bg_color = temp;
     }
+    // Skip the blit if the cell already shows exactly this glyph;
+    // invalidations are tracked per line, so most covered cells are
+    // unchanged on a busy console.
+    uint32_t shadow = VC_SHADOW_VALID |
+                      vc_char_make(vc_char_get_char(ch), fg_color, bg_color);
+    uint32_t* cell = &vc->shadow_buf[y * vc->columns + x];
+    if (*cell == shadow)
+        return;
     gfx_putchar(vc_gfx, vc->font, vc_char_get_char(ch),
                 x * vc->charw, y * vc->charh,
                 palette_to_color(vc, fg_color),
                 palette_to_color(vc, bg_color));
+    *cell = shadow;
 }
 
 #if BUILD_FOR_TEST
@@ -28,6 +28,19 @@ void vc_free_gfx();
 
 typedef void (*keypress_handler_t)(uint8_t keycode, int modifiers);
 
+// A scrollback line, stored as text+attributes with the trailing run of
+// identical cells (usually blank padding) elided. The full row is
+// reproduced on demand by vc_get_scrollback_line_ptr().
+typedef struct vc_sb_line {
+    vc_char_t* data; // stored cells (prefix of the row)
+    uint16_t len;    // number of stored cells
+    vc_char_t fill;  // value repeated across the remaining columns
+} vc_sb_line_t;
+
+// Marks a shadow_buf entry as holding a rendered character (any
+// vc_char_t value is possible, so validity needs an extra bit).
+#define VC_SHADOW_VALID (1u << 16)
+
 mx_status_t new_input_device(int fd, keypress_handler_t handler);
 
 // constraints on status bar tabs
@@ -56,7 +69,9 @@ typedef struct vc {
     // text buffer
 
     // Buffer containing scrollback lines.  This is a circular buffer.
-    vc_char_t* scrollback_buf;
+    vc_sb_line_t* scrollback_buf;
+    // Scratch row used to expand a scrollback line for rendering.
+    vc_char_t* scrollback_scratch;
     // Maximum number of rows that may be stored in the scrollback buffer.
     unsigned scrollback_rows_max;
     // Number of rows currently stored in the scrollback buffer.
@@ -72,6 +87,11 @@ typedef struct vc {
     int invy0, invy1;
     // offscreen invalid lines, tracked during textcon drawing
 
+    // What each on-screen character cell currently shows (vc_char_t with
+    // colors post-inversion, plus VC_SHADOW_VALID). Used to skip glyph
+    // draws for cells an invalidation covers but did not change.
+    uint32_t* shadow_buf;
+
     unsigned cursor_x, cursor_y;
     // cursor
     bool hide_cursor;
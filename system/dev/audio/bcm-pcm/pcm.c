@@ -19,6 +19,7 @@
 #include <magenta/compiler.h>
 #include <magenta/device/audio2.h>
 #include <magenta/device/i2c.h>
+#include <magenta/process.h>
 #include <magenta/syscalls.h>
 #include <magenta/syscalls/port.h>
 #include <magenta/threads.h>
@@ -50,6 +51,10 @@
 #define BCM_PCM_REF_FREQUENCY   19200000
 #define BCM_PCM_BCLK_PER_FRAME  64
 
+// position register update cadence when the client asked for no channel
+// notifications and is polling the shared position vmo instead
+#define BCM_PCM_POSITION_UPDATES_PER_RING 16
+
 #define DMA_CHAN 11
 #define PCM_TRACE 0
 
@@ -65,6 +70,7 @@ typedef union {
     audio2_rb_cmd_start_req_t start_req;
     audio2_rb_cmd_stop_req_t stop_req;
     audio2_rb_cmd_get_fifo_depth_req_t get_fifo_req;
+    audio2_rb_cmd_get_position_vmo_req_t get_position_vmo_req;
 } buffer_packet_t;
 
 typedef struct {
@@ -85,6 +91,11 @@ typedef struct {
     size_t buffer_size; // size of buffer in bytes
     uint32_t buffer_notifications;
 
+    mx_handle_t position_vmo;
+    // driver mapping of the shared position register; clients map the vmo
+    // read-only and poll it instead of taking per-period channel messages
+    volatile audio2_rb_position_buffer_t* position_buffer;
+
     thrd_t notify_thrd;
     thrd_t port_thrd;
     volatile atomic_bool notify_running;
@@ -163,6 +174,21 @@ static void pcm_deinit(bcm_pcm_t* ctx) {
     mtx_unlock(&ctx->pcm_lock);
 }
 
+// Publish the current ring position to the shared position register.  The
+// sequence count is odd while an update is in flight; readers retry until
+// they observe the same even value on both sides of their copy.
+static void pcm_update_position_buffer(bcm_pcm_t* ctx, uint32_t offset) {
+    volatile audio2_rb_position_buffer_t* pb = ctx->position_buffer;
+    if (pb == NULL)
+        return;
+    pb->seq++;
+    hw_wmb();
+    pb->ring_buffer_pos = offset;
+    pb->timestamp = mx_time_get(MX_CLOCK_MONOTONIC);
+    hw_wmb();
+    pb->seq++;
+}
+
 static int pcm_notify_thread(void* arg) {
 
     bcm_pcm_t* ctx = arg;
@@ -172,8 +198,15 @@ static int pcm_notify_thread(void* arg) {
 
     mx_status_t status = MX_OK;
 
+    uint32_t updates_per_ring = ctx->buffer_notifications;
+    if (updates_per_ring == 0) {
+        // no channel notifications requested; we are only here to keep the
+        // shared position register fresh
+        updates_per_ring = BCM_PCM_POSITION_UPDATES_PER_RING;
+    }
+
     double notify_time = (1000000.0 * ctx->buffer_size) /
-                         (ctx->sample_rate * ctx->audio_frame_size * ctx->buffer_notifications);
+                         (ctx->sample_rate * ctx->audio_frame_size * updates_per_ring);
 
     uint64_t notify_period_us = (uint64_t)notify_time;
 
@@ -188,6 +221,11 @@ static int pcm_notify_thread(void* arg) {
         mx_paddr_t pos = bcm_dma_get_position(&ctx->dma);
         bcm_dma_paddr_to_offset(&ctx->dma, pos, &offset);
 
+        pcm_update_position_buffer(ctx, offset);
+
+        if (ctx->buffer_notifications == 0)
+            continue;
+
         audio2_rb_position_notify_t resp;
         resp.hdr.cmd = AUDIO2_RB_POSITION_NOTIFY;
         resp.ring_buffer_pos = offset;
@@ -210,6 +248,49 @@ static mx_status_t pcm_get_fifo_depth(bcm_pcm_t* ctx, audio2_rb_cmd_get_fifo_dep
     return mx_channel_write(ctx->buffer_ch, 0, &resp, sizeof(resp), NULL, 0);
 }
 
+static mx_status_t pcm_get_position_vmo(bcm_pcm_t* ctx, audio2_rb_cmd_get_position_vmo_req_t req) {
+
+    mtx_lock(&ctx->pcm_lock);
+
+    mx_status_t status = MX_OK;
+    mx_handle_t ret_handle = MX_HANDLE_INVALID;
+
+    audio2_rb_cmd_get_position_vmo_resp_t resp;
+    resp.hdr = req.hdr;
+
+    if (ctx->position_vmo == MX_HANDLE_INVALID) {
+        status = mx_vmo_create(sizeof(audio2_rb_position_buffer_t), 0, &ctx->position_vmo);
+        if (status != MX_OK)
+            goto gpv_done;
+
+        uintptr_t vaddr;
+        status = mx_vmar_map(mx_vmar_root_self(), 0, ctx->position_vmo, 0,
+                             sizeof(audio2_rb_position_buffer_t),
+                             MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE, &vaddr);
+        if (status != MX_OK) {
+            pcm_close_handle(&ctx->position_vmo);
+            goto gpv_done;
+        }
+        ctx->position_buffer = (volatile audio2_rb_position_buffer_t*)vaddr;
+    }
+
+    // clients may only read the position register
+    status = mx_handle_duplicate(ctx->position_vmo, MX_RIGHT_TRANSFER |
+                                                    MX_RIGHT_READ     |
+                                                    MX_RIGHT_MAP,
+                                                    &ret_handle);
+
+gpv_done:
+    resp.result = status;
+    if (status == MX_OK) {
+        status = mx_channel_write(ctx->buffer_ch, 0, &resp, sizeof(resp), &ret_handle, 1);
+    } else {
+        status = mx_channel_write(ctx->buffer_ch, 0, &resp, sizeof(resp), NULL, 0);
+    }
+    mtx_unlock(&ctx->pcm_lock);
+    return status;
+}
+
 static mx_status_t pcm_stop_locked(bcm_pcm_t* ctx) {
     mx_status_t res;
 
@@ -269,7 +350,7 @@ static mx_status_t pcm_start(bcm_pcm_t* ctx, audio2_rb_cmd_start_req_t req) {
 
     hifiberry_start();
 
-    if (ctx->buffer_notifications > 0) {
+    if ((ctx->buffer_notifications > 0) || (ctx->position_buffer != NULL)) {
 
         int thrd_rc = thrd_create_with_name(&ctx->notify_thrd,
                                             pcm_notify_thread, ctx,
@@ -319,6 +400,14 @@ static mx_status_t pcm_deinit_buffer_locked(bcm_pcm_t* ctx) {
 
     pcm_close_handle(&ctx->buffer_vmo);
 
+    // notify thread is down at this point, safe to tear out the position page
+    if (ctx->position_buffer != NULL) {
+        mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)ctx->position_buffer,
+                      sizeof(audio2_rb_position_buffer_t));
+        ctx->position_buffer = NULL;
+    }
+    pcm_close_handle(&ctx->position_vmo);
+
     ctx->state &= ~BCM_PCM_STATE_SHUTTING_DOWN;
 
     return MX_OK;
@@ -547,6 +636,7 @@ static int pcm_port_thread(void* arg) {
                     HANDLE_REQ(AUDIO2_RB_CMD_STOP, stop_req, pcm_stop_req);
                     HANDLE_REQ(AUDIO2_RB_CMD_GET_BUFFER, get_buffer_req, pcm_get_buffer);
                     HANDLE_REQ(AUDIO2_RB_CMD_GET_FIFO_DEPTH, get_fifo_req, pcm_get_fifo_depth);
+                    HANDLE_REQ(AUDIO2_RB_CMD_GET_POSITION_VMO, get_position_vmo_req, pcm_get_position_vmo);
                 case AUDIO2_RB_POSITION_NOTIFY:
                 default:
                     xprintf("unrecognized buffer command\n");
@@ -60,6 +60,7 @@ typedef struct ahci_port {
     mtx_t lock;
 
     uint32_t running;   // bitmask of running commands
+    uint32_t queued;    // bitmask of running commands issued as ncq
     uint32_t completed; // bitmask of completed commands
     iotxn_t* commands[AHCI_MAX_COMMANDS]; // commands in flight
 
@@ -204,11 +205,11 @@ static bool cmd_is_queued(uint8_t cmd) {
 
 static void ahci_port_complete_txn(ahci_device_t* dev, ahci_port_t* port, mx_status_t status) {
     mtx_lock(&port->lock);
-    uint32_t sact = ahci_read(&port->regs->sact);
-    uint32_t running = port->running;
-    uint32_t done = sact ^ running;
-    // assert if a channel without an outstanding transaction is active
-    MX_DEBUG_ASSERT(!(done & sact));
+    // a command slot is done when the hardware has cleared its bit in ci
+    // (non-queued) or sact (ncq); out-of-order ncq completions surface here
+    // as soon as each tag retires
+    uint32_t active = ahci_read(&port->regs->sact) | ahci_read(&port->regs->ci);
+    uint32_t done = port->running & ~active;
     port->completed |= done;
     mtx_unlock(&port->lock);
     // hit the worker thread to complete commands
@@ -229,14 +230,6 @@ static mx_status_t ahci_do_txn(ahci_device_t* dev, ahci_port_t* port, int slot,
     iotxn_phys_iter_t iter;
     iotxn_phys_iter_init(&iter, txn, AHCI_PRD_MAX_SIZE);
 
-    if (dev->cap & AHCI_CAP_NCQ) {
-        if (pdata->cmd == SATA_CMD_READ_DMA_EXT) {
-            pdata->cmd = SATA_CMD_READ_FPDMA_QUEUED;
-        } else if (pdata->cmd == SATA_CMD_WRITE_DMA_EXT) {
-            pdata->cmd = SATA_CMD_WRITE_FPDMA_QUEUED;
-        }
-    }
-
     // build the command
     ahci_cl_t* cl = port->cl + slot;
     // don't clear the cl since we set up ctba/ctbau at init
@@ -310,13 +303,16 @@ static mx_status_t ahci_do_txn(ahci_device_t* dev, ahci_port_t* port, int slot,
 
     // start command
     if (cmd_is_queued(pdata->cmd)) {
+        port->queued |= (1 << slot);
         ahci_write(&port->regs->sact, (1 << slot));
     }
     ahci_write(&port->regs->ci, (1 << slot));
 
     // set the watchdog
     // TODO: general timeout mechanism
-    pdata->timeout = mx_time_get(MX_CLOCK_MONOTONIC) + MX_SEC(1);
+    // a full ncq queue can legitimately hold a command for a while on
+    // slow media, so allow for the depth of the queue ahead of it
+    pdata->timeout = mx_time_get(MX_CLOCK_MONOTONIC) + MX_SEC(5);
     completion_signal(&dev->watchdog_completion);
     return MX_OK;
 }
@@ -473,6 +469,7 @@ static int ahci_worker_thread(void* arg) {
                 }
                 port->completed &= ~(1 << slot);
                 port->running &= ~(1 << slot);
+                port->queued &= ~(1 << slot);
                 port->commands[slot] = NULL;
                 // resume the port if paused for sync and no outstanding transactions
                 if ((port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) && !port->running) {
@@ -480,39 +477,58 @@ static int ahci_worker_thread(void* arg) {
                 }
             }
 
-            if (port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) {
-                goto next;
-            }
+            // issue queued txns until the list drains or the command
+            // slots fill, so the device sees the full ncq queue depth
+            // instead of one command per worker wakeup
+            while (!(port->flags & AHCI_PORT_FLAG_SYNC_PAUSED)) {
+                txn = list_peek_head_type(&port->txn_list, iotxn_t, node);
+                if (!txn) {
+                    break;
+                }
 
-            txn = list_peek_head_type(&port->txn_list, iotxn_t, node);
-            if (!txn) {
-                goto next;
-            }
+                // if IOTXN_SYNC_BEFORE, pause the port if there are transactions in flight
+                if ((txn->flags & IOTXN_SYNC_BEFORE) && port->running) {
+                    port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                    break;
+                }
 
-            // if IOTXN_SYNC_BEFORE, pause the port if there are transactions in flight
-            if ((txn->flags & IOTXN_SYNC_BEFORE) && port->running) {
-                port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
-                goto next;
-            }
+                // promote to ncq when both the controller and the device
+                // support it, so tagged reads and writes complete out of
+                // order across the 32 slots
+                sata_pdata_t* pdata = sata_iotxn_pdata(txn);
+                if ((dev->cap & AHCI_CAP_NCQ) && (pdata->max_cmd > 0)) {
+                    if (pdata->cmd == SATA_CMD_READ_DMA_EXT) {
+                        pdata->cmd = SATA_CMD_READ_FPDMA_QUEUED;
+                    } else if (pdata->cmd == SATA_CMD_WRITE_DMA_EXT) {
+                        pdata->cmd = SATA_CMD_WRITE_FPDMA_QUEUED;
+                    }
+                }
 
-            // find a free command tag
-            sata_pdata_t* pdata = sata_iotxn_pdata(txn);
-            int max = MIN(pdata->max_cmd, (int)((dev->cap >> 8) & 0x1f));
-            int i = 0;
-            for (i = 0; i <= max; i++) {
-                if (!ahci_port_cmd_busy(port, i)) break;
-            }
-            if (i > max) {
-                goto next;
-            }
+                // the device may not mix queued and non-queued commands;
+                // hold the txn until the other kind drains
+                if (cmd_is_queued(pdata->cmd) ? (port->running & ~port->queued)
+                                              : port->queued) {
+                    break;
+                }
 
-            list_delete(&txn->node);
-            // if IOTXN_SYNC_AFTER, pause the port until this command is complete
-            if (txn->flags & IOTXN_SYNC_AFTER) {
-                port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                // find a free command tag
+                int max = MIN(pdata->max_cmd, (int)((dev->cap >> 8) & 0x1f));
+                int slot = 0;
+                for (slot = 0; slot <= max; slot++) {
+                    if (!ahci_port_cmd_busy(port, slot)) break;
+                }
+                if (slot > max) {
+                    break;
+                }
+
+                list_delete(&txn->node);
+                // if IOTXN_SYNC_AFTER, pause the port until this command is complete
+                if (txn->flags & IOTXN_SYNC_AFTER) {
+                    port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                }
+                // run the command
+                ahci_do_txn(dev, port, slot, txn);
             }
-            // run the command
-            ahci_do_txn(dev, port, i, txn);
 next:
             mtx_unlock(&port->lock);
         }
@@ -548,6 +564,7 @@ static int ahci_watchdog_thread(void* arg) {
                         // time out
                         printf("ahci: txn time out on port %d txn %p\n", port->nr, txn);
                         port->running &= ~(1 << slot);
+                        port->queued &= ~(1 << slot);
                         port->commands[slot] = NULL;
                         mtx_unlock(&port->lock);
                         iotxn_complete(txn, MX_ERR_TIMED_OUT, 0);
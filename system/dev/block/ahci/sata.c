@@ -128,8 +128,16 @@ static mx_status_t sata_device_identify(sata_device_t* dev, mx_device_t* control
     } else {
         xprintf(" PIO");
     }
-    dev->max_cmd = *(devinfo + SATA_DEVINFO_QUEUE_DEPTH);
-    xprintf(" %d commands\n", dev->max_cmd + 1);
+    uint16_t sata_cap = *(devinfo + SATA_DEVINFO_SATA_CAP);
+    if (sata_cap & (1 << 8)) {
+        // word 75 bits 4:0 holds the ncq queue depth - 1
+        dev->max_cmd = *(devinfo + SATA_DEVINFO_QUEUE_DEPTH) & 0x1f;
+        xprintf(" NCQ %d commands\n", dev->max_cmd + 1);
+    } else {
+        // no ncq; one command at a time
+        dev->max_cmd = 0;
+        xprintf(" no NCQ\n");
+    }
     if (cap & (1 << 9)) {
         dev->sector_sz = 512; // default
         if ((*(devinfo + SATA_DEVINFO_SECTOR_SIZE) & 0xd000) == 0x5000) {
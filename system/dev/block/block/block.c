@@ -27,24 +27,34 @@ typedef struct blkdev {
 
     mtx_t lock;
     uint32_t threadcount;
-    BlockServer* bs;
+    uint32_t queuecount; // Number of queues exposed; immutable after bind.
+    BlockServer* bs[MAX_BLOCK_MQ_QUEUES];
     bool dead; // Release has been called; we should free memory and leave.
 } blkdev_t;
 
+typedef struct blockserver_args {
+    blkdev_t* bdev;
+    BlockServer* bs;
+    uint32_t queue;
+} blockserver_args_t;
+
 static int blockserver_thread(void* arg) {
-    blkdev_t* bdev = (blkdev_t*)arg;
-    BlockServer* bs = bdev->bs;
+    blockserver_args_t* args = (blockserver_args_t*)arg;
+    blkdev_t* bdev = args->bdev;
+    BlockServer* bs = args->bs;
+    uint32_t queue = args->queue;
+    free(args);
     bdev->threadcount++;
     mtx_unlock(&bdev->lock);
 
     blockserver_serve(bs, &bdev->proto);
 
     mtx_lock(&bdev->lock);
-    if (bdev->bs == bs) {
+    if (bdev->bs[queue] == bs) {
         // Only nullify 'bs' if no one has replaced it yet. This is the
         // case when the blockserver shuts itself down because the fifo
         // has closed.
-        bdev->bs = NULL;
+        bdev->bs[queue] = NULL;
     }
     bdev->threadcount--;
     bool cleanup = bdev->dead & (bdev->threadcount == 0);
@@ -58,57 +68,78 @@ static int blockserver_thread(void* arg) {
     return 0;
 }
 
-static mx_status_t blkdev_get_fifos(blkdev_t* bdev, void* out_buf, size_t out_len) {
+static mx_status_t blkdev_get_queue_fifo(blkdev_t* bdev, uint32_t queue,
+                                         void* out_buf, size_t out_len) {
     if (out_len < sizeof(mx_handle_t)) {
         return MX_ERR_INVALID_ARGS;
     }
     mx_status_t status;
+    blockserver_args_t* args = NULL;
     mtx_lock(&bdev->lock);
-    if (bdev->bs != NULL) {
+    if (queue >= bdev->queuecount) {
+        status = MX_ERR_OUT_OF_RANGE;
+        goto done;
+    }
+    if (bdev->bs[queue] != NULL) {
         status = MX_ERR_ALREADY_BOUND;
         goto done;
     }
 
+    if ((args = malloc(sizeof(blockserver_args_t))) == NULL) {
+        status = MX_ERR_NO_MEMORY;
+        goto done;
+    }
+
     BlockServer* bs;
-    if ((status = blockserver_create(out_buf, &bs)) != MX_OK) {
+    if ((status = blockserver_create(queue, out_buf, &bs)) != MX_OK) {
         goto done;
     }
 
     // As soon as we launch a thread, the background thread is responsible
-    // for the blockserver in the bdev->bs field.
-    bdev->bs = bs;
+    // for the blockserver in the bdev->bs[queue] field.
+    bdev->bs[queue] = bs;
+    args->bdev = bdev;
+    args->bs = bs;
+    args->queue = queue;
     thrd_t thread;
-    if (thrd_create(&thread, blockserver_thread, bdev) != thrd_success) {
+    if (thrd_create(&thread, blockserver_thread, args) != thrd_success) {
         blockserver_free(bs);
-        bdev->bs = NULL;
+        bdev->bs[queue] = NULL;
         status = MX_ERR_NO_MEMORY;
         goto done;
     }
     thrd_detach(thread);
 
-    // On success, the blockserver thread holds the lock.
+    // On success, the blockserver thread holds the lock and frees 'args'.
     return sizeof(mx_handle_t);
 done:
+    free(args);
     mtx_unlock(&bdev->lock);
     return status;
 }
 
-static mx_status_t blkdev_attach_vmo(blkdev_t* bdev,
-                                 const void* in_buf, size_t in_len,
-                                 void* out_buf, size_t out_len, size_t* out_actual) {
-    if ((in_len < sizeof(mx_handle_t)) || (out_len < sizeof(vmoid_t))) {
+static mx_status_t blkdev_get_fifos(blkdev_t* bdev, void* out_buf, size_t out_len) {
+    return blkdev_get_queue_fifo(bdev, 0, out_buf, out_len);
+}
+
+static mx_status_t blkdev_attach_queue_vmo(blkdev_t* bdev, uint32_t queue, mx_handle_t h,
+                                           void* out_buf, size_t out_len, size_t* out_actual) {
+    if (out_len < sizeof(vmoid_t)) {
         return MX_ERR_INVALID_ARGS;
     }
 
     mx_status_t status;
     mtx_lock(&bdev->lock);
-    if (bdev->bs == NULL) {
+    if (queue >= bdev->queuecount) {
+        status = MX_ERR_OUT_OF_RANGE;
+        goto done;
+    }
+    if (bdev->bs[queue] == NULL) {
         status = MX_ERR_BAD_STATE;
         goto done;
     }
 
-    mx_handle_t h = *(mx_handle_t*)in_buf;
-    if ((status = blockserver_attach_vmo(bdev->bs, h, out_buf)) != MX_OK) {
+    if ((status = blockserver_attach_vmo(bdev->bs[queue], h, out_buf)) != MX_OK) {
         goto done;
     }
     *out_actual = sizeof(vmoid_t);
@@ -118,57 +149,95 @@ done:
     return status;
 }
 
-static mx_status_t blkdev_alloc_txn(blkdev_t* bdev,
-                                const void* in_buf, size_t in_len,
-                                void* out_buf, size_t out_len, size_t* out_actual) {
-    if ((in_len != 0) || (out_len < sizeof(txnid_t))) {
+static mx_status_t blkdev_attach_vmo(blkdev_t* bdev,
+                                 const void* in_buf, size_t in_len,
+                                 void* out_buf, size_t out_len, size_t* out_actual) {
+    if (in_len < sizeof(mx_handle_t)) {
+        return MX_ERR_INVALID_ARGS;
+    }
+    mx_handle_t h = *(mx_handle_t*)in_buf;
+    return blkdev_attach_queue_vmo(bdev, 0, h, out_buf, out_len, out_actual);
+}
+
+static mx_status_t blkdev_alloc_queue_txn(blkdev_t* bdev, uint32_t queue,
+                                          void* out_buf, size_t out_len, size_t* out_actual) {
+    if (out_len < sizeof(txnid_t)) {
         return MX_ERR_INVALID_ARGS;
     }
 
     mx_status_t status;
     mtx_lock(&bdev->lock);
-    if (bdev->bs == NULL) {
+    if (queue >= bdev->queuecount) {
+        status = MX_ERR_OUT_OF_RANGE;
+        goto done;
+    }
+    if (bdev->bs[queue] == NULL) {
         status = MX_ERR_BAD_STATE;
         goto done;
     }
 
-    if ((status = blockserver_allocate_txn(bdev->bs, out_buf)) != MX_OK) {
+    if ((status = blockserver_allocate_txn(bdev->bs[queue], out_buf)) != MX_OK) {
         goto done;
     }
-    *out_actual = sizeof(vmoid_t);
+    *out_actual = sizeof(txnid_t);
 
 done:
     mtx_unlock(&bdev->lock);
     return status;
 }
 
-static mx_status_t blkdev_free_txn(blkdev_t* bdev, const void* in_buf,
-                                   size_t in_len) {
-    if (in_len != sizeof(txnid_t)) {
+static mx_status_t blkdev_alloc_txn(blkdev_t* bdev,
+                                const void* in_buf, size_t in_len,
+                                void* out_buf, size_t out_len, size_t* out_actual) {
+    if (in_len != 0) {
         return MX_ERR_INVALID_ARGS;
     }
+    return blkdev_alloc_queue_txn(bdev, 0, out_buf, out_len, out_actual);
+}
 
+static mx_status_t blkdev_free_queue_txn(blkdev_t* bdev, uint32_t queue, txnid_t txnid) {
     mx_status_t status;
     mtx_lock(&bdev->lock);
-    if (bdev->bs == NULL) {
+    if (queue >= bdev->queuecount) {
+        status = MX_ERR_OUT_OF_RANGE;
+        goto done;
+    }
+    if (bdev->bs[queue] == NULL) {
         status = MX_ERR_BAD_STATE;
         goto done;
     }
 
-    txnid_t txnid = *(txnid_t*)in_buf;
-    blockserver_free_txn(bdev->bs, txnid);
+    blockserver_free_txn(bdev->bs[queue], txnid);
     status = MX_OK;
 done:
     mtx_unlock(&bdev->lock);
     return status;
 }
 
-static mx_status_t blkdev_fifo_close_locked(blkdev_t* bdev) {
-    if (bdev->bs != NULL) {
-        blockserver_shutdown(bdev->bs);
+static mx_status_t blkdev_free_txn(blkdev_t* bdev, const void* in_buf,
+                                   size_t in_len) {
+    if (in_len != sizeof(txnid_t)) {
+        return MX_ERR_INVALID_ARGS;
+    }
+    return blkdev_free_queue_txn(bdev, 0, *(txnid_t*)in_buf);
+}
+
+static mx_status_t blkdev_queue_fifo_close_locked(blkdev_t* bdev, uint32_t queue) {
+    if (queue >= bdev->queuecount) {
+        return MX_ERR_OUT_OF_RANGE;
+    }
+    if (bdev->bs[queue] != NULL) {
+        blockserver_shutdown(bdev->bs[queue]);
         // Ensure that the next thread to call "get_fifos" will
         // not see the previous block server.
-        bdev->bs = NULL;
+        bdev->bs[queue] = NULL;
+    }
+    return MX_OK;
+}
+
+static mx_status_t blkdev_fifo_close_all_locked(blkdev_t* bdev) {
+    for (uint32_t queue = 0; queue < bdev->queuecount; queue++) {
+        blkdev_queue_fifo_close_locked(bdev, queue);
     }
     return MX_OK;
 }
@@ -189,7 +258,51 @@ static mx_status_t blkdev_ioctl(void* ctx, uint32_t op, const void* cmd,
         return blkdev_free_txn(blkdev, cmd, cmdlen);
     case IOCTL_BLOCK_FIFO_CLOSE: {
         mtx_lock(&blkdev->lock);
-        mx_status_t status = blkdev_fifo_close_locked(blkdev);
+        mx_status_t status = blkdev_queue_fifo_close_locked(blkdev, 0);
+        mtx_unlock(&blkdev->lock);
+        return status;
+    }
+    case IOCTL_BLOCK_MQ_GET_QUEUE_COUNT: {
+        if (max < sizeof(uint32_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        *(uint32_t*)reply = blkdev->queuecount;
+        *out_actual = sizeof(uint32_t);
+        return MX_OK;
+    }
+    case IOCTL_BLOCK_MQ_GET_FIFO: {
+        if (cmdlen < sizeof(uint32_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        return blkdev_get_queue_fifo(blkdev, *(uint32_t*)cmd, reply, max);
+    }
+    case IOCTL_BLOCK_MQ_ATTACH_VMO: {
+        if (cmdlen < sizeof(block_mq_attach_vmo_args_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        const block_mq_attach_vmo_args_t* args = cmd;
+        return blkdev_attach_queue_vmo(blkdev, args->queue, args->vmo,
+                                       reply, max, out_actual);
+    }
+    case IOCTL_BLOCK_MQ_ALLOC_TXN: {
+        if (cmdlen < sizeof(uint32_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        return blkdev_alloc_queue_txn(blkdev, *(uint32_t*)cmd, reply, max, out_actual);
+    }
+    case IOCTL_BLOCK_MQ_FREE_TXN: {
+        if (cmdlen < sizeof(block_mq_free_txn_args_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        const block_mq_free_txn_args_t* args = cmd;
+        return blkdev_free_queue_txn(blkdev, args->queue, args->txnid);
+    }
+    case IOCTL_BLOCK_MQ_FIFO_CLOSE: {
+        if (cmdlen < sizeof(uint32_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        mtx_lock(&blkdev->lock);
+        mx_status_t status = blkdev_queue_fifo_close_locked(blkdev, *(uint32_t*)cmd);
         mtx_unlock(&blkdev->lock);
         return status;
     }
@@ -217,7 +330,7 @@ static void blkdev_release(void* ctx) {
     blkdev_t* blkdev = ctx;
     mtx_lock(&blkdev->lock);
     bool bg_thread_running = (blkdev->threadcount != 0);
-    blkdev_fifo_close_locked(blkdev);
+    blkdev_fifo_close_all_locked(blkdev);
     blkdev->dead = true;
     mtx_unlock(&blkdev->lock);
 
@@ -254,6 +367,11 @@ static mx_status_t block_driver_bind(void* ctx, mx_device_t* dev, void** cookie)
         goto fail;
     }
 
+    bdev->queuecount = MIN(block_get_queue_count(&bdev->proto), MAX_BLOCK_MQ_QUEUES);
+    if (bdev->queuecount == 0) {
+        bdev->queuecount = 1;
+    }
+
    device_add_args_t args = {
         .version = DEVICE_ADD_ARGS_VERSION,
         .name = "block",
@@ -198,9 +198,9 @@ void BlockServer::FreeTxn(txnid_t txnid) {
     txns_[txnid] = nullptr;
 }
 
-mx_status_t BlockServer::Create(mx::fifo* fifo_out, BlockServer** out) {
+mx_status_t BlockServer::Create(uint32_t queue, mx::fifo* fifo_out, BlockServer** out) {
     AllocChecker ac;
-    BlockServer* bs = new (&ac) BlockServer();
+    BlockServer* bs = new (&ac) BlockServer(queue);
     if (!ac.check()) {
         return MX_ERR_NO_MEMORY;
     }
@@ -291,10 +291,10 @@ mx_status_t BlockServer::Serve(block_protocol_t* proto) {
                 }
 
                 if ((requests[i].opcode & BLOCKIO_OP_MASK) == BLOCKIO_READ) {
-                    block_read(proto, iobuf->io_vmo_.get(), requests[i].length,
+                    block_queue_read(proto, queue_, iobuf->io_vmo_.get(), requests[i].length,
                                      requests[i].vmo_offset, requests[i].dev_offset, msg);
                 } else {
-                    block_write(proto, iobuf->io_vmo_.get(), requests[i].length,
+                    block_queue_write(proto, queue_, iobuf->io_vmo_.get(), requests[i].length,
                                       requests[i].vmo_offset, requests[i].dev_offset, msg);
                 }
                 break;
@@ -320,7 +320,7 @@ mx_status_t BlockServer::Serve(block_protocol_t* proto) {
     }
 }
 
-BlockServer::BlockServer() : last_id(0) {}
+BlockServer::BlockServer(uint32_t queue) : queue_(queue), last_id(0) {}
 BlockServer::~BlockServer() {
     ShutDown();
 }
@@ -332,9 +332,9 @@ void BlockServer::ShutDown() {
 }
 
 // C declarations
-mx_status_t blockserver_create(mx_handle_t* fifo_out, BlockServer** out) {
+mx_status_t blockserver_create(uint32_t queue, mx_handle_t* fifo_out, BlockServer** out) {
     mx::fifo fifo;
-    mx_status_t status = BlockServer::Create(&fifo, out);
+    mx_status_t status = BlockServer::Create(queue, &fifo, out);
     *fifo_out = fifo.release();
     return status;
 }
@@ -82,8 +82,9 @@ private:
 
 class BlockServer {
 public:
-    // Creates a new BlockServer
-    static mx_status_t Create(mx::fifo* fifo_out, BlockServer** out);
+    // Creates a new BlockServer which issues its operations on the given
+    // device queue.  Single-queue clients use queue zero.
+    static mx_status_t Create(uint32_t queue, mx::fifo* fifo_out, BlockServer** out);
 
     // Starts the BlockServer using the current thread
     mx_status_t Serve(block_protocol_t* proto);
@@ -96,12 +97,13 @@ public:
     ~BlockServer();
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(BlockServer);
-    BlockServer();
+    explicit BlockServer(uint32_t queue);
 
     mx_status_t Read(block_fifo_request_t* requests, uint32_t* count);
     mx_status_t FindVmoIDLocked(vmoid_t* out) TA_REQ(server_lock_);
 
     mx::fifo fifo_;
+    const uint32_t queue_;
 
     mxtl::Mutex server_lock_;
     mxtl::WAVLTree<vmoid_t, mxtl::RefPtr<IoBuffer>> tree_ TA_GUARDED(server_lock_);
@@ -118,8 +120,9 @@ typedef struct BlockServer BlockServer;
 
 __BEGIN_CDECLS
 
-// Allocate a new blockserver + FIFO combo
-mx_status_t blockserver_create(mx_handle_t* fifo_out, BlockServer** out);
+// Allocate a new blockserver + FIFO combo, serving the given device queue
+// (queue zero for single-queue clients)
+mx_status_t blockserver_create(uint32_t queue, mx_handle_t* fifo_out, BlockServer** out);
 
 // Shut down the blockserver. It will stop serving requests.
 void blockserver_shutdown(BlockServer* bs);
@@ -151,6 +151,47 @@ static mx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd,
         ramdisk_unbind(ramdev);
         return MX_OK;
     }
+    case IOCTL_RAMDISK_TRIM: {
+        if (cmdlen != sizeof(ramdisk_ioctl_trim_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        ramdisk_ioctl_trim_t* trim = (ramdisk_ioctl_trim_t*)cmd;
+        mx_off_t offset = trim->offset;
+        mx_off_t length = trim->length;
+        mx_status_t status = constrain_args(ramdev, &offset, &length);
+        if (status != MX_OK) {
+            return status;
+        }
+        // Decommit is page-granular while blocks may be smaller, so only
+        // the page-aligned interior of the range is released. Trim is
+        // advisory; the remainder simply keeps its pages.
+        uint64_t start = (offset + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+        uint64_t end = (offset + length) & ~(uint64_t)(PAGE_SIZE - 1);
+        if (end <= start) {
+            return MX_OK;
+        }
+        mtx_lock(&ramdev->lock);
+        if (ramdev->dead) {
+            status = MX_ERR_BAD_STATE;
+        } else {
+            status = mx_vmo_op_range(ramdev->vmo, MX_VMO_OP_DECOMMIT,
+                                     start, end - start, NULL, 0);
+        }
+        mtx_unlock(&ramdev->lock);
+        return status;
+    }
+    case IOCTL_RAMDISK_GET_VMO: {
+        if (max < sizeof(mx_handle_t)) {
+            return MX_ERR_BUFFER_TOO_SMALL;
+        }
+        mx_handle_t* out = reply;
+        mx_status_t status = mx_handle_duplicate(ramdev->vmo, MX_RIGHT_SAME_RIGHTS, out);
+        if (status != MX_OK) {
+            return status;
+        }
+        *out_actual = sizeof(mx_handle_t);
+        return MX_OK;
+    }
     // Block Protocol
     case IOCTL_BLOCK_GET_NAME: {
         char* name = reply;
@@ -70,10 +70,11 @@ static void ums_send_cbw(ums_t* ums, uint8_t lun, uint32_t transfer_length, uint
     // copy command_len bytes from the command passed in into the command_len
     memcpy(cbw->CBWCB, command, command_len);
 
-    completion_t completion = COMPLETION_INIT;
-    txn->cookie = &completion;
+    // Queue without waiting: the data and CSW stages queue up behind the CBW
+    // on the endpoint rings, and every command ends with a CSW wait, so the
+    // CBW has long since completed before it is rebuilt for the next command.
+    txn->cookie = NULL;
     ums_queue_request(ums, txn);
-    completion_wait(&completion, MX_TIME_INFINITE);
 }
 
 static mx_status_t ums_read_csw(ums_t* ums, uint32_t* out_residue) {
@@ -240,31 +241,40 @@ static mx_status_t ums_mode_sense6(ums_t* ums, uint8_t lun, scsi_mode_sense_6_da
     return status;
 }
 
-static mx_status_t ums_data_transfer(ums_t* ums, iotxn_t* txn, mx_off_t offset, size_t length,
-                                     uint8_t ep_address) {
-    iotxn_t* clone = NULL;
-    mx_status_t status = iotxn_clone_partial(txn, txn->vmo_offset + offset, length, &clone);
+// Queue the data stage of a command without waiting for it.  The driver's
+// pre-allocated clone is recycled for every data stage, so no allocation
+// happens per transfer.  The caller must wait on |completion| (which is
+// guaranteed signaled once the CSW arrives) and then check the transfer
+// result with ums_check_data_transfer().
+static mx_status_t ums_queue_data_transfer(ums_t* ums, iotxn_t* txn, mx_off_t offset,
+                                           size_t length, uint8_t ep_address,
+                                           completion_t* completion) {
+    mx_status_t status = iotxn_clone_partial(txn, txn->vmo_offset + offset, length,
+                                             &ums->clone_iotxn);
     if (status != MX_OK) {
         return status;
     }
+    iotxn_t* clone = ums->clone_iotxn;
     clone->complete_cb = ums_txn_complete;
 
     usb_protocol_data_t* pdata = iotxn_pdata(clone, usb_protocol_data_t);
     memset(pdata, 0, sizeof(*pdata));
     pdata->ep_address = ep_address;
 
-    completion_t completion = COMPLETION_INIT;
-    clone->cookie = &completion;
+    clone->cookie = completion;
     ums_queue_request(ums, clone);
-    completion_wait(&completion, MX_TIME_INFINITE);
+    return MX_OK;
+}
 
-    status = clone->status;
-    if (status == MX_OK && clone->actual != length) {
-        status = MX_ERR_IO;
+static mx_status_t ums_check_data_transfer(ums_t* ums, size_t length) {
+    iotxn_t* clone = ums->clone_iotxn;
+    if (clone->status != MX_OK) {
+        return clone->status;
     }
-
-    iotxn_release(clone);
-    return status;
+    if (clone->actual != length) {
+        return MX_ERR_IO;
+    }
+    return MX_OK;
 }
 
 static ssize_t ums_read(ums_block_t* dev, iotxn_t* txn) {
@@ -319,13 +329,23 @@ static ssize_t ums_read(ums_block_t* dev, iotxn_t* txn) {
             ums_send_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command), &command);
         }
 
-        status = ums_data_transfer(ums, txn, blocks_transferred * dev->block_size, length,
-                                   ums->bulk_in_addr);
+        // Queue the data stage behind the CBW; the endpoint rings execute the
+        // stages in order and we only block once, on the CSW.
+        completion_t completion = COMPLETION_INIT;
+        status = ums_queue_data_transfer(ums, txn, blocks_transferred * dev->block_size, length,
+                                         ums->bulk_in_addr, &completion);
+        if (status != MX_OK) {
+            break;
+        }
         blocks_transferred += blocks;
 
         // receive CSW
         uint32_t residue;
         status = ums_read_csw(ums, &residue);
+        completion_wait(&completion, MX_TIME_INFINITE);
+        if (status == MX_OK) {
+            status = ums_check_data_transfer(ums, length);
+        }
         if (status == MX_OK && residue) {
             printf("unexpected residue in ums_read\n");
             status = MX_ERR_IO;
@@ -390,13 +410,23 @@ static ssize_t ums_write(ums_block_t* dev, iotxn_t* txn) {
             ums_send_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command), &command);
         }
 
-        status = ums_data_transfer(ums, txn, blocks_transferred * dev->block_size, length,
-                                   ums->bulk_out_addr);
+        // Queue the data stage behind the CBW; the endpoint rings execute the
+        // stages in order and we only block once, on the CSW.
+        completion_t completion = COMPLETION_INIT;
+        status = ums_queue_data_transfer(ums, txn, blocks_transferred * dev->block_size, length,
+                                         ums->bulk_out_addr, &completion);
+        if (status != MX_OK) {
+            break;
+        }
         blocks_transferred += blocks;
 
         // receive CSW
         uint32_t residue;
         status = ums_read_csw(ums, &residue);
+        completion_wait(&completion, MX_TIME_INFINITE);
+        if (status == MX_OK) {
+            status = ums_check_data_transfer(ums, length);
+        }
         if (status == MX_OK && residue) {
             printf("unexpected residue in ums_write\n");
             status = MX_ERR_IO;
@@ -446,6 +476,9 @@ static void ums_release(void* ctx) {
     if (ums->csw_iotxn) {
         iotxn_release(ums->csw_iotxn);
     }
+    if (ums->clone_iotxn) {
+        iotxn_release(ums->clone_iotxn);
+    }
 
     free(ums);
 }
@@ -761,6 +794,11 @@ static mx_status_t ums_bind(void* ctx, mx_device_t* device, void** cookie) {
         status = MX_ERR_NO_MEMORY;
         goto fail;
     }
+    // pre-allocate the clone recycled by ums_queue_data_transfer()
+    status = iotxn_alloc(&ums->clone_iotxn, IOTXN_ALLOC_POOL, 0);
+    if (status != MX_OK) {
+        goto fail;
+    }
 
     ums->cbw_iotxn->length = sizeof(ums_cbw_t);
     ums->csw_iotxn->length = sizeof(ums_csw_t);
@@ -54,6 +54,8 @@ typedef struct {
     iotxn_t* cbw_iotxn;
     iotxn_t* data_iotxn;
     iotxn_t* csw_iotxn;
+    iotxn_t* clone_iotxn;       // pre-allocated clone recycled for data stages,
+                                // so steady-state I/O does no per-transfer allocation
 
     thrd_t worker_thread;
     bool dead;
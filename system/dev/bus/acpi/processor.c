@@ -32,6 +32,7 @@ typedef struct {
 // Command functions.  These should return an error only if the connection
 // should be aborted.  Otherwise they should send their own replies.
 static mx_status_t cmd_list_children(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
+static mx_status_t cmd_list_subtree(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_get_child_handle(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_get_pci_init_arg(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_s_state_transition(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
@@ -44,6 +45,7 @@ static mx_status_t cmd_new_connection(mx_handle_t h, acpi_handle_ctx_t* ctx, voi
 typedef mx_status_t (*cmd_handler_t)(mx_handle_t, acpi_handle_ctx_t*, void*);
 static const cmd_handler_t cmd_table[] = {
         [ACPI_CMD_LIST_CHILDREN] = cmd_list_children,
+        [ACPI_CMD_LIST_SUBTREE] = cmd_list_subtree,
         [ACPI_CMD_GET_CHILD_HANDLE] = cmd_get_child_handle,
         [ACPI_CMD_GET_PCI_INIT_ARG] = cmd_get_pci_init_arg,
         [ACPI_CMD_S_STATE_TRANSITION] = cmd_s_state_transition,
@@ -267,6 +269,57 @@ static mx_status_t send_error(mx_handle_t h, uint32_t req_id, mx_status_t status
     return mx_channel_write(h, 0, &rsp, sizeof(rsp), NULL, 0);
 }
 
+// Fill out an info record for a namespace device node.
+static mx_status_t populate_node_info(ACPI_HANDLE node, acpi_node_info_t* out) {
+    ACPI_DEVICE_INFO* info = NULL;
+    ACPI_STATUS acpi_status = AcpiGetObjectInfo(node, &info);
+    if (acpi_status == AE_NO_MEMORY) {
+        return MX_ERR_NO_MEMORY;
+    } else if (acpi_status != AE_OK) {
+        return MX_ERR_BAD_STATE;
+    }
+
+    // Populate name
+    memcpy(out->name, &info->Name, 4);
+
+    // Populate HID
+    if (info->Valid & ACPI_VALID_HID) {
+        // Add 1 since the Length values count null bytes
+        if (is_pnp_acpi_id(info->HardwareId.String,
+                           info->HardwareId.Length - 1)) {
+
+            assert(info->HardwareId.Length <= sizeof(out->hid) + 1);
+            memcpy(out->hid,
+                   info->HardwareId.String,
+                   info->HardwareId.Length - 1);
+        }
+    }
+
+    // Populate CID list
+    if (info->Valid & ACPI_VALID_CID) {
+        ACPI_PNP_DEVICE_ID_LIST* cid_list = &info->CompatibleIdList;
+
+        for (uint32_t i = 0, cid_used = 0;
+             i < cid_list->Count && cid_used < countof(out->cid);
+             ++i) {
+
+            if (!is_pnp_acpi_id(cid_list->Ids[i].String,
+                                cid_list->Ids[i].Length - 1)) {
+                continue;
+            }
+
+            assert(cid_list->Ids[i].Length <= sizeof(out->cid[0]) + 1);
+            memcpy(out->cid[cid_used],
+                   cid_list->Ids[i].String,
+                   cid_list->Ids[i].Length - 1);
+
+            cid_used++;
+        }
+    }
+    ACPI_FREE(info);
+    return MX_OK;
+}
+
 static mx_status_t cmd_list_children(mx_handle_t h, acpi_handle_ctx_t* ctx, void* _cmd) {
     mx_status_t status = MX_OK;
 
@@ -315,60 +368,125 @@ static mx_status_t cmd_list_children(mx_handle_t h, acpi_handle_ctx_t* ctx, void
             goto cleanup;
         }
 
-        ACPI_DEVICE_INFO* info = NULL;
-        acpi_status = AcpiGetObjectInfo(child, &info);
-        if (acpi_status == AE_NO_MEMORY) {
+        status = populate_node_info(child, &rsp->children[num_children]);
+        if (status == MX_ERR_NO_MEMORY) {
             status = send_error(h, cmd->hdr.request_id, MX_ERR_NO_MEMORY);
             goto cleanup;
-        } else if (acpi_status != AE_OK) {
-            status = MX_ERR_BAD_STATE;
+        } else if (status != MX_OK) {
             goto cleanup;
         }
 
-        // Populate name
-        memcpy(rsp->children[num_children].name, &info->Name, 4);
+        num_children++;
+    }
 
-        // Populate HID
-        if (info->Valid & ACPI_VALID_HID) {
-            // Add 1 since the Length values count null bytes
-            if (is_pnp_acpi_id(info->HardwareId.String,
-                               info->HardwareId.Length - 1)) {
+    // Sanity check that we enumerated the same number as we started with
+    if (num_children != rsp->num_children) {
+        status = MX_ERR_BAD_STATE;
+        goto cleanup;
+    }
 
-                assert(info->HardwareId.Length <= sizeof(rsp->children[0].cid[0]) + 1);
-                memcpy(rsp->children[num_children].hid,
-                       info->HardwareId.String,
-                       info->HardwareId.Length - 1);
-            }
-        }
+    status = mx_channel_write(h, 0, rsp, rsp_size, NULL, 0);
 
-        // Populate CID list
-        if (info->Valid & ACPI_VALID_CID) {
-            ACPI_PNP_DEVICE_ID_LIST* cid_list = &info->CompatibleIdList;
+cleanup:
+    free(rsp);
+    return status;
+}
 
-            for (uint32_t i = 0, cid_used = 0;
-                 i < cid_list->Count && cid_used < countof(rsp->children[0].cid);
-                 ++i) {
+// Count the device nodes below *node*, not including *node* itself.
+static mx_status_t count_subtree(ACPI_HANDLE node, uint32_t depth, uint32_t max_depth,
+                                 uint32_t* count) {
+    ACPI_HANDLE child = NULL;
+    while (1) {
+        ACPI_STATUS acpi_status = AcpiGetNextObject(
+            ACPI_TYPE_DEVICE, node, child, &child);
+        if (acpi_status == AE_NOT_FOUND) {
+            break;
+        }
+        if (acpi_status != AE_OK) {
+            return MX_ERR_BAD_STATE;
+        }
+        (*count)++;
+        if ((max_depth == 0) || (depth + 1 < max_depth)) {
+            mx_status_t status = count_subtree(child, depth + 1, max_depth, count);
+            if (status != MX_OK) {
+                return status;
+            }
+        }
+    }
+    return MX_OK;
+}
 
-                if (!is_pnp_acpi_id(cid_list->Ids[i].String,
-                                    cid_list->Ids[i].Length - 1)) {
-                    continue;
-                }
+// Record the device nodes below *node* in pre-order, starting at nodes[*idx*].
+static mx_status_t fill_subtree(ACPI_HANDLE node, uint32_t depth, uint32_t max_depth,
+                                acpi_rsp_list_subtree_t* rsp, uint32_t* idx) {
+    ACPI_HANDLE child = NULL;
+    while (1) {
+        ACPI_STATUS acpi_status = AcpiGetNextObject(
+            ACPI_TYPE_DEVICE, node, child, &child);
+        if (acpi_status == AE_NOT_FOUND) {
+            break;
+        }
+        if (acpi_status != AE_OK) {
+            return MX_ERR_BAD_STATE;
+        }
+        // the namespace grew between the count and fill passes
+        if (*idx >= rsp->num_nodes) {
+            return MX_ERR_BAD_STATE;
+        }
 
-                assert(cid_list->Ids[i].Length <= sizeof(rsp->children[0].cid[0]) + 1);
-                memcpy(rsp->children[num_children].cid[cid_used],
-                       cid_list->Ids[i].String,
-                       cid_list->Ids[i].Length - 1);
+        mx_status_t status = populate_node_info(child, &rsp->nodes[*idx].info);
+        if (status != MX_OK) {
+            return status;
+        }
+        rsp->nodes[*idx].depth = depth;
+        (*idx)++;
 
-                cid_used++;
+        if ((max_depth == 0) || (depth + 1 < max_depth)) {
+            status = fill_subtree(child, depth + 1, max_depth, rsp, idx);
+            if (status != MX_OK) {
+                return status;
             }
         }
-        ACPI_FREE(info);
+    }
+    return MX_OK;
+}
 
-        num_children++;
+static mx_status_t cmd_list_subtree(mx_handle_t h, acpi_handle_ctx_t* ctx, void* _cmd) {
+    acpi_cmd_list_subtree_t* cmd = _cmd;
+    if (cmd->hdr.len != sizeof(*cmd)) {
+        return send_error(h, cmd->hdr.request_id, MX_ERR_INVALID_ARGS);
+    }
+
+    uint32_t num_nodes = 0;
+    mx_status_t status = count_subtree(ctx->ns_node, 0, cmd->max_depth, &num_nodes);
+    if (status != MX_OK) {
+        return status;
+    }
+
+    acpi_rsp_list_subtree_t* rsp = NULL;
+
+    const uint32_t rsp_size = sizeof(*rsp) + sizeof(rsp->nodes[0]) * num_nodes;
+    rsp = calloc(1, rsp_size);
+    if (!rsp) {
+        return send_error(h, cmd->hdr.request_id, MX_ERR_NO_MEMORY);
+    }
+
+    rsp->hdr.status = MX_OK;
+    rsp->hdr.len = rsp_size;
+    rsp->hdr.request_id = cmd->hdr.request_id;
+    rsp->num_nodes = num_nodes;
+
+    uint32_t idx = 0;
+    status = fill_subtree(ctx->ns_node, 0, cmd->max_depth, rsp, &idx);
+    if (status == MX_ERR_NO_MEMORY) {
+        status = send_error(h, cmd->hdr.request_id, MX_ERR_NO_MEMORY);
+        goto cleanup;
+    } else if (status != MX_OK) {
+        goto cleanup;
     }
 
     // Sanity check that we enumerated the same number as we started with
-    if (num_children != rsp->num_children) {
+    if (idx != num_nodes) {
         status = MX_ERR_BAD_STATE;
         goto cleanup;
     }
@@ -329,6 +329,27 @@ mx_status_t Device::CopyDeviceConfig(void* _buf, size_t len) {
     return MX_OK;
 }
 
+uint32_t Device::ReadDeviceFeatures() {
+    if (!mmio_regs_.common_config) {
+        return ReadConfigBar<uint32_t>(VIRTIO_PCI_DEVICE_FEATURES);
+    } else {
+        mmio_regs_.common_config->device_feature_select = 0;
+        return mmio_regs_.common_config->device_feature;
+    }
+}
+
+void Device::SetDriverFeatures(uint32_t features) {
+    LTRACEF("features %#x\n", features);
+
+    if (!mmio_regs_.common_config) {
+        WriteConfigBar(VIRTIO_PCI_DRIVER_FEATURES, features);
+    } else {
+        mmio_regs_.common_config->driver_feature_select = 0;
+        mmio_regs_.common_config->driver_feature = features;
+    }
+    driver_features_ = features;
+}
+
 uint16_t Device::GetRingSize(uint16_t index) {
     if (!mmio_regs_.common_config) {
         if (bar0_pio_base_) {
@@ -60,6 +60,9 @@ public:
     uint16_t GetRingSize(uint16_t index);
     void RingKick(uint16_t ring_index);
 
+    // feature bits the driver acked via SetDriverFeatures()
+    uint32_t driver_features() const { return driver_features_; }
+
 protected:
     // read bytes out of BAR 0's config space
     template <typename T> T ReadConfigBar(uint16_t offset);
@@ -70,6 +73,11 @@ protected:
     void StatusAcknowledgeDriver();
     void StatusDriverOK();
 
+    // feature negotiation; call between StatusAcknowledgeDriver() and
+    // setting up any rings
+    uint32_t ReadDeviceFeatures();
+    void SetDriverFeatures(uint32_t features);
+
     static int IrqThreadEntry(void* arg);
     void IrqWorker();
 
@@ -102,6 +110,9 @@ protected:
         volatile void* device_config;
     } mmio_regs_ = {};
 
+    // feature bits we acked with the device
+    uint32_t driver_features_ = 0;
+
     // irq thread object
     thrd_t irq_thread_ = {};
 
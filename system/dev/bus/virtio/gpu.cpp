@@ -471,7 +471,15 @@ mx_status_t GpuDevice::Init() {
     // ack and set the driver status bit
     StatusAcknowledgeDriver();
 
-    // XXX check features bits and ack/nak them
+    // check the feature bits and ack the ones we support
+    uint32_t features = ReadDeviceFeatures();
+    uint32_t ack = 0;
+    if (features & (1u << VIRTIO_RING_F_EVENT_IDX)) {
+        // lets us suppress most ring kicks and interrupts while the
+        // other side is still working through the ring
+        ack |= (1u << VIRTIO_RING_F_EVENT_IDX);
+    }
+    SetDriverFeatures(ack);
 
     // allocate the main vring
     auto err = vring_.Init(0, 16);
@@ -11,6 +11,7 @@
 
 #include <ddk/driver.h>
 #include <mx/vmar.h>
+#include <mxtl/atomic.h>
 
 #include "device.h"
 #include "trace.h"
@@ -67,6 +68,9 @@ mx_status_t Ring::Init(uint16_t index, uint16_t count) {
     ring_.free_list = 0xffff;
     ring_.free_count = 0;
 
+    /* the device must have already acked the features we negotiated */
+    uses_event_idx_ = !!(device_->driver_features() & (1u << VIRTIO_RING_F_EVENT_IDX));
+
     /* add all the descriptors to the free list */
     for (uint16_t i = 0; i < count; i++) {
         FreeDesc(i);
@@ -156,13 +160,34 @@ void Ring::SubmitChain(uint16_t desc_index) {
     struct vring_avail* avail = ring_.avail;
 
     avail->ring[avail->idx & ring_.num_mask] = desc_index;
-    //mb();
+
+    /* the descriptors must be visible before the updated index */
+    mxtl::atomic_thread_fence(mxtl::memory_order_seq_cst);
     avail->idx++;
 }
 
 void Ring::Kick() {
     LTRACE_ENTRY;
 
+    /* make sure the avail index update is visible before we read the
+     * device's event index (or notify it) */
+    mxtl::atomic_thread_fence(mxtl::memory_order_seq_cst);
+
+    uint16_t avail_idx = ring_.avail->idx;
+    if (uses_event_idx_) {
+        /* the device publishes the avail index it wants to be kicked at;
+         * if it hasn't caught up to our previous kick yet, it will pick
+         * up the new chains on its own and the notify (a vmexit on
+         * virtual machines) can be skipped */
+        uint16_t avail_event = vring_avail_event(&ring_);
+        if (!vring_need_event(avail_event, avail_idx, avail_idx_kicked_)) {
+            LTRACEF_LEVEL(2, "skipping kick, device is still behind\n");
+            avail_idx_kicked_ = avail_idx;
+            return;
+        }
+    }
+    avail_idx_kicked_ = avail_idx;
+
     device_->RingKick(index_);
 }
 
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <magenta/types.h>
+#include <mxtl/atomic.h>
 #include <virtio/virtio_ring.h>
 
 #include "trace.h"
@@ -42,6 +43,13 @@ private:
 
     uint16_t index_ = 0;
 
+    // set when VIRTIO_RING_F_EVENT_IDX was negotiated with the device;
+    // kicks and interrupts are then elided via the ring event indices
+    bool uses_event_idx_ = false;
+
+    // avail->idx as of the last time we actually notified the device
+    uint16_t avail_idx_kicked_ = 0;
+
     vring ring_ = {};
 };
 
@@ -64,6 +72,14 @@ inline void Ring::IrqRingUpdate(T free_chain) {
 
         ring_.last_used = ((ring_.last_used + 1) & ring_.num_mask) & 0xffff;
     }
+
+    if (uses_event_idx_) {
+        // tell the device it only needs to interrupt us for entries past the
+        // point we've drained to; anything it queued while we were in the
+        // loop above was already picked up without another interrupt
+        vring_used_event(&ring_) = (uint16_t)cur_idx;
+        mxtl::atomic_thread_fence(mxtl::memory_order_seq_cst);
+    }
 }
 
 void virtio_dump_desc(const struct vring_desc* desc);
@@ -24,6 +24,21 @@ typedef struct fb fb_t;
 #define GROUP_VIRTCON 0
 #define GROUP_FULLSCREEN 1
 
+// Number of frames that may be queued ahead of scanout.  Two queued
+// frames plus the one the client is rendering gives triple buffering.
+#define FLIP_QUEUE_DEPTH 2
+
+// None of the underlying display drivers surface a vsync interrupt yet,
+// so presents are paced by a software refresh timer at roughly 60Hz.
+// When a driver grows real vsync the flip thread can block on it instead.
+#define FB_REFRESH_PERIOD MX_USEC(16667)
+
+typedef struct fb_frame {
+    mx_handle_t vmo;
+    uint32_t seq;
+    fbi_t* owner;
+} fb_frame_t;
+
 struct fb {
     mx_device_t* mxdev;
     display_protocol_t dpy;
@@ -41,6 +56,15 @@ struct fb {
     // only one fullscreen client may exist at a time
     // and we keep track of it here
     fbi_t* fullscreen;
+
+    // frames waiting for the next refresh, guarded by lock
+    fb_frame_t flip_queue[FLIP_QUEUE_DEPTH];
+    uint32_t flip_count;
+
+    // refresh pacing thread, started on first present
+    thrd_t flip_thread;
+    bool flip_running;
+    bool flip_shutdown;
 };
 
 #define FB_HAS_GPU(fb) (fb->dpy.ops->acquire_or_release_display != NULL)
@@ -57,6 +81,11 @@ struct fbi {
     void* buffer;
     mx_handle_t vmo;
     uint32_t group;
+
+    // flip state, guarded by fb->lock
+    mx_handle_t flip_event;
+    uint32_t last_seq;
+    mx_time_t last_vsync;
 };
 
 void fb_callback(bool acquired, void* cookie) {
@@ -97,6 +126,63 @@ done:
     return r;
 }
 
+static int fb_flip_thread(void* arg) {
+    fb_t* fb = arg;
+    mx_time_t next = mx_deadline_after(FB_REFRESH_PERIOD);
+    for (;;) {
+        mx_nanosleep(next);
+        next += FB_REFRESH_PERIOD;
+
+        mtx_lock(&fb->lock);
+        if (fb->flip_shutdown) {
+            mtx_unlock(&fb->lock);
+            break;
+        }
+        if (fb->flip_count == 0) {
+            mtx_unlock(&fb->lock);
+            continue;
+        }
+        fb_frame_t frame = fb->flip_queue[0];
+        fb->flip_count--;
+        memmove(&fb->flip_queue[0], &fb->flip_queue[1],
+                fb->flip_count * sizeof(fb_frame_t));
+        if (frame.owner->group == fb->active) {
+            size_t actual;
+            mx_vmo_read(frame.vmo, fb->buffer, 0, fb->bufsz, &actual);
+            FB_FLUSH(fb);
+        }
+        frame.owner->last_seq = frame.seq;
+        frame.owner->last_vsync = mx_time_get(MX_CLOCK_MONOTONIC);
+        if (frame.owner->flip_event != MX_HANDLE_INVALID) {
+            // queue has space again
+            mx_object_signal(frame.owner->flip_event, 0, MX_USER_SIGNAL_0);
+        }
+        mtx_unlock(&fb->lock);
+
+        mx_handle_close(frame.vmo);
+
+        // if we fell behind, restart the cadence rather than bursting
+        mx_time_t now = mx_time_get(MX_CLOCK_MONOTONIC);
+        if (next < now) {
+            next = now + FB_REFRESH_PERIOD;
+        }
+    }
+    return 0;
+}
+
+// called with fb->lock held
+static mx_status_t fb_start_flip_thread_locked(fb_t* fb) {
+    if (fb->flip_running) {
+        return MX_OK;
+    }
+    if (thrd_create_with_name(&fb->flip_thread, fb_flip_thread, fb,
+                              "fb-flip") != thrd_success) {
+        return MX_ERR_NO_MEMORY;
+    }
+    fb->flip_running = true;
+    return MX_OK;
+}
+
 static mx_status_t fbi_ioctl(void* ctx, uint32_t op,
                              const void* in_buf, size_t in_len,
                              void* out_buf, size_t out_len, size_t* out_actual) {
@@ -213,6 +299,73 @@ static mx_status_t fbi_ioctl(void* ctx, uint32_t op,
             return MX_OK;
         }
     }
+    case IOCTL_DISPLAY_PRESENT_FB: {
+        if (in_len != sizeof(ioctl_display_present_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        const ioctl_display_present_t* p = in_buf;
+        mtx_lock(&fb->lock);
+        if ((r = fb_start_flip_thread_locked(fb)) != MX_OK) {
+            mtx_unlock(&fb->lock);
+            mx_handle_close(p->vmo);
+            return r;
+        }
+        if (fb->flip_count == FLIP_QUEUE_DEPTH) {
+            mtx_unlock(&fb->lock);
+            mx_handle_close(p->vmo);
+            return MX_ERR_SHOULD_WAIT;
+        }
+        fb_frame_t* frame = &fb->flip_queue[fb->flip_count++];
+        frame->vmo = p->vmo;
+        frame->seq = p->seq;
+        frame->owner = fbi;
+        if ((fb->flip_count == FLIP_QUEUE_DEPTH) &&
+            (fbi->flip_event != MX_HANDLE_INVALID)) {
+            mx_object_signal(fbi->flip_event, MX_USER_SIGNAL_0, 0);
+        }
+        mtx_unlock(&fb->lock);
+        return MX_OK;
+    }
+    case IOCTL_DISPLAY_GET_FLIP_EVENT: {
+        if (out_len != sizeof(mx_handle_t)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+        mtx_lock(&fb->lock);
+        if (fbi->flip_event == MX_HANDLE_INVALID) {
+            if ((r = mx_event_create(0, &fbi->flip_event)) < 0) {
+                mtx_unlock(&fb->lock);
+                return r;
+            }
+            // the queue starts out with space available
+            mx_object_signal(fbi->flip_event, 0, MX_USER_SIGNAL_0);
+        }
+        mtx_unlock(&fb->lock);
+        mx_handle_t* out = out_buf;
+        if ((r = mx_handle_duplicate(fbi->flip_event, MX_RIGHT_READ | MX_RIGHT_TRANSFER | MX_RIGHT_DUPLICATE, out)) < 0) {
+            return r;
+        }
+        *out_actual = sizeof(mx_handle_t);
+        return MX_OK;
+    }
+    case IOCTL_DISPLAY_GET_PRESENT_INFO: {
+        if (out_len < sizeof(ioctl_display_present_info_t)) {
+            return MX_ERR_BUFFER_TOO_SMALL;
+        }
+        ioctl_display_present_info_t* out = out_buf;
+        mtx_lock(&fb->lock);
+        out->seq = fbi->last_seq;
+        out->vsync_time = fbi->last_vsync;
+        uint32_t queued = 0;
+        for (uint32_t i = 0; i < fb->flip_count; i++) {
+            if (fb->flip_queue[i].owner == fbi) {
+                queued++;
+            }
+        }
+        out->queued = queued;
+        mtx_unlock(&fb->lock);
+        *out_actual = sizeof(ioctl_display_present_info_t);
+        return MX_OK;
+    }
 
     default:
         return MX_ERR_NOT_SUPPORTED;
@@ -234,8 +387,24 @@ static void fbi_release(void* ctx) {
             mx_object_signal(fb->event, MX_USER_SIGNAL_1, MX_USER_SIGNAL_0);
         }
     }
+    // drop any of our frames still waiting in the flip queue
+    uint32_t i = 0;
+    while (i < fb->flip_count) {
+        if (fb->flip_queue[i].owner == fbi) {
+            mx_handle_close(fb->flip_queue[i].vmo);
+            fb->flip_count--;
+            memmove(&fb->flip_queue[i], &fb->flip_queue[i + 1],
+                    (fb->flip_count - i) * sizeof(fb_frame_t));
+        } else {
+            i++;
+        }
+    }
     mtx_unlock(&fb->lock);
 
+    if (fbi->flip_event != MX_HANDLE_INVALID) {
+        mx_handle_close(fbi->flip_event);
+    }
+
     if (fbi->buffer) {
         mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t) fbi->buffer, fbi->fb->bufsz);
     }
@@ -310,6 +479,18 @@ static mx_status_t fb_open(void* ctx, mx_device_t** out, uint32_t flags) {
 
 static void fb_release(void* ctx) {
     fb_t* fb = ctx;
+
+    mtx_lock(&fb->lock);
+    bool join = fb->flip_running;
+    fb->flip_shutdown = true;
+    mtx_unlock(&fb->lock);
+    if (join) {
+        thrd_join(fb->flip_thread, NULL);
+    }
+    while (fb->flip_count > 0) {
+        mx_handle_close(fb->flip_queue[--fb->flip_count].vmo);
+    }
+
     mx_handle_close(fb->event);
     free(fb);
 }
@@ -13,6 +13,7 @@
 #include <magenta/syscalls.h>
 #include <magenta/types.h>
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -96,6 +97,21 @@ typedef struct ethdev {
     void* io_buf;
     size_t io_size;
 
+    // cached rx buffer entries, refilled in batches so that
+    // delivering a packet does not cost a fifo read syscall
+    eth_fifo_entry_t rx_cache[FIFO_DEPTH / 8];
+    uint32_t rx_cache_count;
+    uint32_t rx_cache_next;
+
+    // receive packet filter, guarded by edev0->lock like the rx path
+    eth_filter_insn_t filter[ETH_FILTER_MAX_INSNS];
+    uint32_t filter_len;
+
+    // shared-vmo capture ring; when installed, rx packets bypass the fifo
+    mx_handle_t capture_vmo;
+    volatile eth_capture_header_t* capture_hdr;
+    uint32_t capture_slots;
+
     // fifo thread
     thrd_t tx_thr;
 
@@ -108,24 +124,107 @@ typedef struct ethdev {
 
 #define FAIL_REPORT_RATE 50
 
+// Evaluate the client's packet filter.  Returns true if the packet
+// should be delivered.  Jump targets are forward skips, so evaluation
+// always terminates.
+static bool eth_run_filter(ethdev_t* edev, const uint8_t* data, size_t len) {
+    if (edev->filter_len == 0) {
+        return true;
+    }
+    uint32_t acc = 0;
+    for (uint32_t pc = 0; pc < edev->filter_len; pc++) {
+        const eth_filter_insn_t* i = &edev->filter[pc];
+        switch (i->op) {
+        case ETH_FILTER_OP_LDB:
+            acc = (i->k < len) ? data[i->k] : 0;
+            break;
+        case ETH_FILTER_OP_LDH:
+            acc = ((i->k + 2) <= len) ?
+                (((uint32_t)data[i->k] << 8) | data[i->k + 1]) : 0;
+            break;
+        case ETH_FILTER_OP_LDW:
+            acc = ((i->k + 4) <= len) ?
+                (((uint32_t)data[i->k] << 24) | ((uint32_t)data[i->k + 1] << 16) |
+                 ((uint32_t)data[i->k + 2] << 8) | data[i->k + 3]) : 0;
+            break;
+        case ETH_FILTER_OP_JEQ:
+            pc += (acc == i->k) ? i->jt : i->jf;
+            break;
+        case ETH_FILTER_OP_JGT:
+            pc += (acc > i->k) ? i->jt : i->jf;
+            break;
+        case ETH_FILTER_OP_JSET:
+            pc += (acc & i->k) ? i->jt : i->jf;
+            break;
+        case ETH_FILTER_OP_ACCEPT:
+            return true;
+        case ETH_FILTER_OP_REJECT:
+            return false;
+        }
+    }
+    // running off the end accepts
+    return true;
+}
+
+static void eth_capture_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra) {
+    volatile eth_capture_header_t* hdr = edev->capture_hdr;
+    uint32_t rd = hdr->rd;
+    uint32_t wr = hdr->wr;
+
+    if ((wr - rd) >= edev->capture_slots) {
+        hdr->dropped++;
+        return;
+    }
+
+    eth_capture_record_t* rec = (void*)((uintptr_t)hdr +
+            (1 + (wr % edev->capture_slots)) * ETH_CAPTURE_SLOT_SIZE);
+    if (len > ETH_CAPTURE_MAX_DATA) {
+        len = ETH_CAPTURE_MAX_DATA;
+    }
+    memcpy(rec + 1, data, len);
+    rec->length = len;
+    rec->flags = ETH_FIFO_RX_OK | extra;
+    rec->timestamp = mx_time_get(MX_CLOCK_MONOTONIC);
+
+    // make the record visible before publishing it
+    atomic_thread_fence(memory_order_release);
+    hdr->wr = wr + 1;
+
+    if (wr == rd) {
+        mx_object_signal_peer(edev->rx_fifo, 0, ETH_SIGNAL_CAPTURE);
+    }
+}
+
 static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra) {
-    eth_fifo_entry_t e;
     mx_status_t status;
     uint32_t count;
 
-    // TODO: read multiple and cache locally to reduce syscalls
-    if ((status = mx_fifo_read(edev->rx_fifo, &e, sizeof(e), &count)) < 0) {
-        if (status == MX_ERR_SHOULD_WAIT) {
-            if ((edev->fail_rx_read++ % FAIL_REPORT_RATE) == 0) {
-                printf("eth [%s]: no rx buffers available (%u times)\n",
-                       edev->name, edev->fail_rx_read);
+    if (!eth_run_filter(edev, data, len)) {
+        return;
+    }
+    if (edev->capture_hdr != NULL) {
+        eth_capture_rx(edev, data, len, extra);
+        return;
+    }
+
+    if (edev->rx_cache_next == edev->rx_cache_count) {
+        if ((status = mx_fifo_read(edev->rx_fifo, edev->rx_cache,
+                                   sizeof(edev->rx_cache), &count)) < 0) {
+            if (status == MX_ERR_SHOULD_WAIT) {
+                if ((edev->fail_rx_read++ % FAIL_REPORT_RATE) == 0) {
+                    printf("eth [%s]: no rx buffers available (%u times)\n",
+                           edev->name, edev->fail_rx_read);
+                }
+            } else {
+                // Fatal, should force teardown
+                printf("eth [%s]: rx fifo read failed %d\n", edev->name, status);
             }
-        } else {
-            // Fatal, should force teardown
-            printf("eth [%s]: rx fifo read failed %d\n", edev->name, status);
+            return;
         }
-        return;
+        edev->rx_cache_count = count;
+        edev->rx_cache_next = 0;
     }
+    eth_fifo_entry_t e = edev->rx_cache[edev->rx_cache_next++];
 
     if ((e.offset >= edev->io_size) || ((e.length > (edev->io_size - e.offset)))) {
         // invalid offset/length. report error. drop packet
@@ -174,10 +273,12 @@ static void eth0_status(void* cookie, uint32_t status) {
 static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
     ethdev0_t* edev0 = cookie;
 
+    uint32_t extra = (flags & ETHMAC_RX_CSUM_OK) ? ETH_FIFO_RX_CSUM_OK : 0;
+
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        eth_handle_rx(edev, data, len, 0);
+        eth_handle_rx(edev, data, len, extra);
     }
     mtx_unlock(&edev0->lock);
 }
@@ -266,6 +367,10 @@ static int eth_tx_thread(void* arg) {
                 if (opt) {
                     xprintf("setting OPT_MORE (%u packets to go)\n", count);
                 }
+                if ((e->flags & ETH_FIFO_TX_CSUM) &&
+                    (edev0->info.features & ETHMAC_FEATURE_TX_CSUM)) {
+                    opt |= ETHMAC_TX_OPT_CSUM;
+                }
                 edev0->mac.ops->send(edev0->mac.ctx, opt, edev->io_buf + e->offset, e->length);
                 e->flags = ETH_FIFO_TX_OK;
                 if (edev->state & ETHDEV_TX_LOOPBACK) {
@@ -363,11 +468,85 @@ fail:
     return status;
 }
 
+static ssize_t eth_set_filter_locked(ethdev_t* edev, const void* in_buf, size_t in_len) {
+    if (in_len % sizeof(eth_filter_insn_t)) {
+        return MX_ERR_INVALID_ARGS;
+    }
+    size_t n = in_len / sizeof(eth_filter_insn_t);
+    if (n > ETH_FILTER_MAX_INSNS) {
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    const eth_filter_insn_t* insns = in_buf;
+    for (size_t i = 0; i < n; i++) {
+        if ((insns[i].op < ETH_FILTER_OP_LDB) || (insns[i].op > ETH_FILTER_OP_REJECT)) {
+            return MX_ERR_INVALID_ARGS;
+        }
+    }
+
+    // the rx path runs under the same lock, so this cannot race delivery
+    memcpy(edev->filter, insns, in_len);
+    edev->filter_len = n;
+    return MX_OK;
+}
+
+static ssize_t eth_set_capture_ring_locked(ethdev_t* edev, const void* in_buf, size_t in_len) {
+    if (in_len < sizeof(mx_handle_t)) {
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    mx_handle_t vmo = *((mx_handle_t*)in_buf);
+
+    if (edev->capture_vmo != MX_HANDLE_INVALID) {
+        mx_handle_close(vmo);
+        return MX_ERR_ALREADY_BOUND;
+    }
+
+    size_t size;
+    mx_status_t status;
+
+    if ((status = mx_vmo_get_size(vmo, &size)) < 0) {
+        printf("eth [%s]: could not get capture ring size: %d\n", edev->name, status);
+        goto fail;
+    }
+
+    // header slot plus at least one record slot
+    if (size < 2 * ETH_CAPTURE_SLOT_SIZE) {
+        status = MX_ERR_INVALID_ARGS;
+        goto fail;
+    }
+
+    uintptr_t mapping;
+    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, vmo, 0, size,
+                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE,
+                              &mapping)) < 0) {
+        printf("eth [%s]: could not map capture ring: %d\n", edev->name, status);
+        goto fail;
+    }
+
+    volatile eth_capture_header_t* hdr = (void*)mapping;
+    hdr->rd = 0;
+    hdr->wr = 0;
+    hdr->slots = (size / ETH_CAPTURE_SLOT_SIZE) - 1;
+    hdr->dropped = 0;
+
+    edev->capture_vmo = vmo;
+    edev->capture_slots = hdr->slots;
+    edev->capture_hdr = hdr;
+
+    return MX_OK;
+
+fail:
+    mx_handle_close(vmo);
+    return status;
+}
+
 static mx_status_t eth_start_locked(ethdev_t* edev) {
     ethdev0_t* edev0 = edev->edev0;
 
-    // Cannot start unless tx/rx rings are configured
-    if ((edev->io_vmo == MX_HANDLE_INVALID) ||
+    // Cannot start unless tx/rx rings are configured.  A capture ring
+    // substitutes for the io buffer on the rx path.
+    if (((edev->io_vmo == MX_HANDLE_INVALID) && (edev->capture_hdr == NULL)) ||
         (edev->tx_fifo == MX_HANDLE_INVALID) ||
         (edev->rx_fifo == MX_HANDLE_INVALID)) {
         return MX_ERR_BAD_STATE;
@@ -411,6 +590,25 @@ static mx_status_t eth_start_locked(ethdev_t* edev) {
     return status;
 }
 
+// Return any rx buffer entries we read from the fifo but have not
+// yet filled, so the client does not lose their ownership across a
+// stop/start cycle.  A zero length and no RX_OK flag marks them as
+// unused rather than received.
+static void eth_rx_flush_cache_locked(ethdev_t* edev) {
+    uint32_t count;
+    while (edev->rx_cache_next < edev->rx_cache_count) {
+        eth_fifo_entry_t* e = &edev->rx_cache[edev->rx_cache_next];
+        e->length = 0;
+        e->flags = 0;
+        if (mx_fifo_write(edev->rx_fifo, e, sizeof(*e), &count) < 0) {
+            break;
+        }
+        edev->rx_cache_next++;
+    }
+    edev->rx_cache_count = 0;
+    edev->rx_cache_next = 0;
+}
+
 static mx_status_t eth_stop_locked(ethdev_t* edev) {
     ethdev0_t* edev0 = edev->edev0;
 
@@ -418,6 +616,7 @@ static mx_status_t eth_stop_locked(ethdev_t* edev) {
         edev->state &= (~ETHDEV_RUNNING);
         list_delete(&edev->node);
         list_add_tail(&edev0->list_idle, &edev->node);
+        eth_rx_flush_cache_locked(edev);
         if (list_is_empty(&edev0->list_active)) {
             if (!(edev->state & ETHDEV_DEAD)) {
                 // Release the lock to allow other device operations in callback routine.
@@ -491,6 +690,15 @@ static mx_status_t eth_ioctl(void* ctx, uint32_t op,
             if (edev->edev0->info.features & ETHMAC_FEATURE_WLAN) {
                 info->features |= ETH_FEATURE_WLAN;
             }
+            if (edev->edev0->info.features & ETHMAC_FEATURE_RX_CSUM) {
+                info->features |= ETH_FEATURE_RX_CSUM;
+            }
+            if (edev->edev0->info.features & ETHMAC_FEATURE_TX_CSUM) {
+                info->features |= ETH_FEATURE_TX_CSUM;
+            }
+            if (edev->edev0->info.features & ETHMAC_FEATURE_TSO) {
+                info->features |= ETH_FEATURE_TSO;
+            }
             info->mtu = edev->edev0->info.mtu;
             *out_actual = sizeof(*info);
             status = MX_OK;
@@ -521,6 +729,24 @@ static mx_status_t eth_ioctl(void* ctx, uint32_t op,
     case IOCTL_ETHERNET_GET_STATUS:
         status = eth_get_status_locked(edev, out_buf, out_len, out_actual);
         break;
+    case IOCTL_ETHERNET_SET_FILTER:
+        status = eth_set_filter_locked(edev, in_buf, in_len);
+        break;
+    case IOCTL_ETHERNET_SET_CAPTURE_RING:
+        status = eth_set_capture_ring_locked(edev, in_buf, in_len);
+        break;
+    case IOCTL_ETHERNET_SET_MODERATION: {
+        if (in_len != sizeof(int32_t)) {
+            status = MX_ERR_INVALID_ARGS;
+        } else if (edev->edev0->mac.ops->set_param == NULL) {
+            status = MX_ERR_NOT_SUPPORTED;
+        } else {
+            status = edev->edev0->mac.ops->set_param(edev->edev0->mac.ctx,
+                                                     ETHMAC_SETPARAM_INT_MODERATION,
+                                                     *(const int32_t*)in_buf);
+        }
+        break;
+    }
     default:
         // TODO: consider if we want this under the edev0->lock or not
         status = device_ioctl(edev->edev0->macdev, op, in_buf, in_len, out_buf, out_len, out_actual);
@@ -559,6 +785,10 @@ static void eth_kill_locked(ethdev_t* edev) {
         mx_handle_close(edev->io_vmo);
         edev->io_vmo = MX_HANDLE_INVALID;
     }
+    if (edev->capture_vmo) {
+        mx_handle_close(edev->capture_vmo);
+        edev->capture_vmo = MX_HANDLE_INVALID;
+    }
 
     if (edev->state & ETHDEV_TX_THREAD) {
         edev->state &= (~ETHDEV_TX_THREAD);
@@ -576,6 +806,10 @@ static void eth_kill_locked(ethdev_t* edev) {
         mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)edev->io_buf, 0);
         edev->io_buf = NULL;
     }
+    if (edev->capture_hdr) {
+        mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)edev->capture_hdr, 0);
+        edev->capture_hdr = NULL;
+    }
     xprintf("eth [%s]: all resources released\n", edev->name);
 }
 
@@ -56,13 +56,16 @@ static int irq_thread(void* arg) {
         if (irq & ETH_IRQ_RX) {
             void* data;
             size_t len;
+            unsigned frames = 0;
 
             while (eth_rx(&edev->eth, &data, &len) == MX_OK) {
                 if (edev->ifc) {
                     edev->ifc->recv(edev->cookie, data, len, 0);
                 }
                 eth_rx_ack(&edev->eth);
+                frames++;
             }
+            eth_itr_adapt(&edev->eth, frames);
         }
         if (irq & ETH_IRQ_LSC) {
             bool was_online = edev->online;
@@ -126,11 +129,26 @@ static void eth_send(void* ctx, uint32_t options, void* data, size_t length) {
     eth_tx(&edev->eth, data, length);
 }
 
+static mx_status_t eth_set_param(void* ctx, uint32_t param, int32_t value) {
+    ethernet_device_t* edev = ctx;
+
+    switch (param) {
+    case ETHMAC_SETPARAM_INT_MODERATION:
+        mtx_lock(&edev->lock);
+        eth_set_moderation(&edev->eth, value);
+        mtx_unlock(&edev->lock);
+        return MX_OK;
+    default:
+        return MX_ERR_NOT_SUPPORTED;
+    }
+}
+
 static ethmac_protocol_ops_t ethmac_ops = {
     .query = eth_query,
     .stop = eth_stop,
     .start = eth_start,
     .send = eth_send,
+    .set_param = eth_set_param,
 };
 
 static void eth_release(void* ctx) {
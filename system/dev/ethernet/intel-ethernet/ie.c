@@ -45,6 +45,53 @@ unsigned eth_handle_irq(ethdev_t* eth) {
     return readl(IE_ICR);
 }
 
+// ITR enforces a minimum gap between interrupts in 256ns units;
+// zero fires immediately. The adaptive levels trade a little
+// latency for batching as the per-interrupt frame count grows.
+#define ETH_ITR_IMMEDIATE 0
+#define ETH_ITR_LOW       (1000000000 / 256 / 20000) // 20k ints/sec
+#define ETH_ITR_HIGH      (1000000000 / 256 / 8000)  // 8k ints/sec
+
+static void eth_write_itr(ethdev_t* eth, uint32_t itr) {
+    if (itr != eth->itr_current) {
+        eth->itr_current = itr;
+        writel(itr, IE_ITR);
+    }
+}
+
+void eth_set_moderation(ethdev_t* eth, int32_t rate) {
+    if (rate < 0) {
+        eth->itr_adaptive = true;
+        eth->itr_load = 0;
+        eth_write_itr(eth, ETH_ITR_IMMEDIATE);
+    } else {
+        eth->itr_adaptive = false;
+        uint32_t itr = rate ? (1000000000u / 256u / (uint32_t)rate) : 0;
+        if (itr > 0xFFFF) {
+            itr = 0xFFFF;
+        }
+        eth_write_itr(eth, itr);
+    }
+}
+
+void eth_itr_adapt(ethdev_t* eth, unsigned frames) {
+    if (!eth->itr_adaptive) {
+        return;
+    }
+    // low-pass filter the batch size (x16 fixed point) so a single
+    // quiet or busy interrupt doesn't flap the rate
+    eth->itr_load = (3 * eth->itr_load + frames * 16) / 4;
+    uint32_t itr;
+    if (eth->itr_load >= 8 * 16) {
+        itr = ETH_ITR_HIGH;
+    } else if (eth->itr_load >= 2 * 16) {
+        itr = ETH_ITR_LOW;
+    } else {
+        itr = ETH_ITR_IMMEDIATE;
+    }
+    eth_write_itr(eth, itr);
+}
+
 bool eth_status_online(ethdev_t* eth) {
     return readl(IE_STATUS) & IE_STATUS_LU;
 }
@@ -180,6 +227,10 @@ void eth_init_hw(ethdev_t* eth) {
     writel(IE_INT_RXT0, IE_IMS);
     // enable link status change irq
     writel(IE_INT_LSC, IE_IMS);
+
+    // adaptive interrupt moderation by default
+    eth->itr_current = 1; // force the initial ITR write
+    eth_set_moderation(eth, -1);
 }
 
 void eth_setup_buffers(ethdev_t* eth, void* iomem, mx_paddr_t iophys) {
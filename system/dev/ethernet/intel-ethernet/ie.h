@@ -42,6 +42,11 @@ struct ethdev {
 
     uint8_t mac[6];
 
+    // interrupt moderation state (see eth_set_moderation)
+    bool itr_adaptive;
+    uint32_t itr_current;
+    uint32_t itr_load;
+
     mtx_t send_lock;
 };
 
@@ -75,3 +80,11 @@ bool eth_status_online(ethdev_t* eth);
 #define ETH_IRQ_RX IE_INT_RXT0
 #define ETH_IRQ_LSC IE_INT_LSC
 unsigned eth_handle_irq(ethdev_t* eth);
+
+// rate < 0: adaptive, rate == 0: one interrupt per event,
+// rate > 0: cap interrupts at `rate` per second
+void eth_set_moderation(ethdev_t* eth, int32_t rate);
+
+// feed the adaptive moderation with the number of frames
+// handled by the interrupt that just completed
+void eth_itr_adapt(ethdev_t* eth, unsigned frames);
@@ -12,6 +12,7 @@
 
 #include <magenta/assert.h>
 #include <magenta/listnode.h>
+#include <magenta/syscalls.h>
 
 #include <assert.h>
 #include <stdio.h>
@@ -83,6 +84,13 @@ typedef struct hid_instance {
 
     mx_hid_fifo_t fifo;
 
+    // Wakeup moderation (see IOCTL_INPUT_SET_WAKE_CONFIG).  All guarded by
+    // fifo.lock.
+    uint32_t wake_threshold;
+    uint32_t wake_latency_usec;
+    uint32_t pending_reports;
+    mx_time_t oldest_report_time;
+
     struct list_node node;
 } hid_instance_t;
 
@@ -305,19 +313,37 @@ static mx_status_t hid_read_instance(void* ctx, void* buf, size_t count, mx_off_
         return MX_ERR_BUFFER_TOO_SMALL;
     }
 
-    r = mx_hid_fifo_read(&hid->fifo, buf, xfer);
+    // Drain as many whole queued reports as fit in the caller's buffer, so
+    // high-rate devices cost one syscall per batch rather than per report.
+    size_t total = 0;
+    for (;;) {
+        r = mx_hid_fifo_read(&hid->fifo, (uint8_t*)buf + total, xfer);
+        if (r <= 0) {
+            break;
+        }
+        total += r;
+        if (hid->pending_reports > 0) {
+            hid->pending_reports--;
+        }
+        if (mx_hid_fifo_peek(&hid->fifo, &rpt_id) < 1) {
+            break;
+        }
+        xfer = hid_get_report_size_by_id(hid->base, rpt_id, INPUT_REPORT_INPUT);
+        if ((xfer == 0) || (xfer > count - total)) {
+            break;
+        }
+    }
     left = mx_hid_fifo_size(&hid->fifo);
     if (left == 0) {
+        hid->pending_reports = 0;
         device_state_clr(hid->mxdev, DEV_STATE_READABLE);
     }
     mtx_unlock(&hid->fifo.lock);
-    if (r > 0) {
-        *actual = r;
-        r = MX_OK;
-    } else if (r == 0) {
-        r = MX_ERR_SHOULD_WAIT;
+    if (total > 0) {
+        *actual = total;
+        return MX_OK;
     }
-    return r;
+    return (r == 0) ? MX_ERR_SHOULD_WAIT : r;
 }
 
 static mx_status_t hid_ioctl_instance(void* ctx, uint32_t op,
@@ -344,6 +370,16 @@ static mx_status_t hid_ioctl_instance(void* ctx, uint32_t op,
         return hid_get_report(hid->base, in_buf, in_len, out_buf, out_len, out_actual);
     case IOCTL_INPUT_SET_REPORT:
         return hid_set_report(hid->base, in_buf, in_len);
+    case IOCTL_INPUT_SET_WAKE_CONFIG: {
+        if (in_len < sizeof(input_wake_config_t)) return MX_ERR_INVALID_ARGS;
+        const input_wake_config_t* config = in_buf;
+        if (config->threshold_reports == 0) return MX_ERR_INVALID_ARGS;
+        mtx_lock(&hid->fifo.lock);
+        hid->wake_threshold = config->threshold_reports;
+        hid->wake_latency_usec = config->max_latency_usec;
+        mtx_unlock(&hid->fifo.lock);
+        return MX_OK;
+    }
     }
     return MX_ERR_NOT_SUPPORTED;
 }
@@ -689,6 +725,7 @@ static mx_status_t hid_open_device(void* ctx, mx_device_t** dev_out, uint32_t fl
         return MX_ERR_NO_MEMORY;
     }
     mx_hid_fifo_init(&inst->fifo);
+    inst->wake_threshold = 1;
 
     device_add_args_t args = {
         .version = DEVICE_ADD_ARGS_VERSION,
@@ -806,6 +843,7 @@ void hid_io_queue(void* cookie, const uint8_t* buf, size_t len) {
         len -= consumed;
 
         hid_instance_t* instance;
+        mx_time_t now = 0;
         foreach_instance(hid, instance) {
             mtx_lock(&instance->fifo.lock);
             bool was_empty = mx_hid_fifo_size(&instance->fifo) == 0;
@@ -819,8 +857,26 @@ void hid_io_queue(void* cookie, const uint8_t* buf, size_t len) {
                 }
             } else {
                 instance->flags &= ~HID_FLAGS_WRITE_FAILED;
-                if (was_empty) {
-                    device_state_set(instance->mxdev, DEV_STATE_READABLE);
+                instance->pending_reports++;
+                if (instance->wake_threshold <= 1) {
+                    if (was_empty) {
+                        device_state_set(instance->mxdev, DEV_STATE_READABLE);
+                    }
+                } else {
+                    // Wakeup moderation: only signal once enough reports have
+                    // accumulated or the oldest one has waited long enough.
+                    if (now == 0) {
+                        now = mx_time_get(MX_CLOCK_MONOTONIC);
+                    }
+                    if (was_empty) {
+                        instance->oldest_report_time = now;
+                    }
+                    if ((instance->pending_reports >= instance->wake_threshold) ||
+                        ((instance->wake_latency_usec != 0) &&
+                         (now - instance->oldest_report_time >=
+                          MX_USEC(instance->wake_latency_usec)))) {
+                        device_state_set(instance->mxdev, DEV_STATE_READABLE);
+                    }
                 }
             }
             mtx_unlock(&instance->fifo.lock);
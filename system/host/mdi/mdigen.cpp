@@ -52,6 +52,35 @@ static bool run(std::vector<std::string>& in_paths, const char* out_path,
         // write the nodes
         root.serialize(out_file);
 
+        // append the node lookup index after the tree
+        std::vector<mdi_index_entry_t> entries;
+        root.collect_index(0, entries);
+        if (!entries.empty()) {
+            // size the hash table for a load factor of at most one half,
+            // so an empty bucket always terminates a failed lookup
+            uint32_t bucket_count = 1;
+            while (bucket_count < 2 * entries.size()) {
+                bucket_count <<= 1;
+            }
+            // empty buckets have node_off set to zero
+            std::vector<mdi_index_entry_t> buckets(bucket_count);
+            uint32_t mask = bucket_count - 1;
+            for (auto iter = entries.begin(); iter != entries.end(); iter++) {
+                uint32_t bucket = MDI_INDEX_HASH(iter->parent_off, iter->id) & mask;
+                while (buckets[bucket].node_off != 0) {
+                    bucket = (bucket + 1) & mask;
+                }
+                buckets[bucket] = *iter;
+            }
+
+            mdi_index_t index;
+            index.magic = MDI_INDEX_MAGIC;
+            index.bucket_count = bucket_count;
+            out_file.write((const char *)&index, sizeof(index));
+            out_file.write((const char *)buckets.data(),
+                           bucket_count * sizeof(mdi_index_entry_t));
+        }
+
         size_t total_len = out_file.tellp();
 
         // back up and fill in the headers
@@ -236,3 +236,37 @@ bool Node::serialize(std::ofstream& out_file) {
 // TODO - error handling
     return true;
 }
+
+// collects a lookup index entry for each child of each list node
+// node_off is this node's offset from the start of the root node
+// must be called after compute_node_length()
+void Node::collect_index(uint32_t node_off, std::vector<mdi_index_entry_t>& entries) const {
+    if (MDI_ID_TYPE(id) != MDI_LIST) {
+        return;
+    }
+
+    uint32_t child_off = node_off + sizeof(mdi_node_t);
+    uint32_t child_index = 0;
+    for (auto iter = children.begin(); iter != children.end(); iter++) {
+        // only index the first child with a given id,
+        // to match mdi_find_node's first-match semantics
+        bool duplicate = false;
+        for (auto prev = children.begin(); prev != iter; prev++) {
+            if (prev->id == iter->id) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            mdi_index_entry_t entry;
+            entry.id = iter->id;
+            entry.parent_off = node_off;
+            entry.node_off = child_off;
+            entry.child_index = child_index;
+            entries.push_back(entry);
+        }
+        iter->collect_index(child_off, entries);
+        child_off += iter->serialized_length;
+        child_index++;
+    }
+}
@@ -39,6 +39,7 @@ public:
 
     void compute_node_length();
     bool serialize(std::ofstream& out_file);
+    void collect_index(uint32_t node_off, std::vector<mdi_index_entry_t>& entries) const;
 
 private:
     void print_indent(int depth);
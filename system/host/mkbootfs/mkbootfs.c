@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -19,6 +20,7 @@
 #include <sys/stat.h>
 
 #include <lz4frame.h>
+#include <lz4hc.h>
 
 #include <magenta/boot/bootdata.h>
 
@@ -170,6 +172,41 @@ void add_entry(item_t* fs, fsentry_t* e) {
     fs->hdrsize += e->namelen + FSENTRYSZ;
 }
 
+static int entry_compare(const void* a, const void* b) {
+    const fsentry_t* ea = *(const fsentry_t* const*)a;
+    const fsentry_t* eb = *(const fsentry_t* const*)b;
+    return strcmp(ea->name, eb->name);
+}
+
+// Sort the item's entries by name, so that the directory can carry a
+// binary-searchable index.  Returns the number of entries.
+unsigned sort_entries(item_t* item) {
+    unsigned count = 0;
+    for (fsentry_t* e = item->first; e != NULL; e = e->next) {
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    fsentry_t** sorted = malloc(count * sizeof(fsentry_t*));
+    if (sorted == NULL) {
+        fprintf(stderr, "OUT OF MEMORY\n");
+        exit(-1);
+    }
+    unsigned i = 0;
+    for (fsentry_t* e = item->first; e != NULL; e = e->next) {
+        sorted[i++] = e;
+    }
+    qsort(sorted, count, sizeof(fsentry_t*), entry_compare);
+    for (i = 0; i < count; i++) {
+        sorted[i]->next = (i + 1 < count) ? sorted[i + 1] : NULL;
+    }
+    item->first = sorted[0];
+    item->last = sorted[count - 1];
+    free(sorted);
+    return count;
+}
+
 int import_manifest(FILE* fp, const char* fn, item_t* fs) {
     int lineno = 0;
     fsentry_t* e;
@@ -404,7 +441,152 @@ static bool check_and_log_lz4_error(LZ4F_errorCode_t code, const char* msg) {
     return false;
 }
 
+// The preferences above select 64kB independent blocks and no content
+// checksum, so apart from the frame header the output is just a sequence
+// of blocks (4 byte size word + payload) that don't depend on each other,
+// followed by a 4 byte end mark. That means the blocks can be compressed
+// on a pool of worker threads and concatenated in order, producing output
+// byte-identical to what LZ4F_compressUpdate() would have streamed out.
+//
+// The cookie accumulates input into 64kB slots; workers claim filled
+// slots in block order and compress them with the lock dropped; a writer
+// thread drains finished slots strictly in order.
+
+#define CBLOCK_SIZE 65536
+// Slots per worker: two keeps every worker busy while the writer drains
+// without much memory (each slot is one input block plus its output).
+#define CSLOTS_PER_WORKER 2
+
+// High bit of a block's size word marks a stored (uncompressed) block.
+#define CBLOCK_UNCOMPRESSED 0x80000000U
+
+typedef enum {
+    CSLOT_FREE,     // available for compress_data() to fill
+    CSLOT_FULL,     // holds input waiting for a worker
+    CSLOT_DONE,     // holds a finished block waiting for the writer
+} cslot_state_t;
+
+typedef struct {
+    cslot_state_t state;
+    size_t inlen;
+    size_t outlen;
+    uint8_t inbuf[CBLOCK_SIZE];
+    uint8_t outbuf[4 + CBLOCK_SIZE];
+} cslot_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t slot_freed;   // a slot went CSLOT_DONE -> CSLOT_FREE
+    pthread_cond_t slot_filled;  // a slot went CSLOT_FREE -> CSLOT_FULL, or input ended
+    pthread_cond_t slot_done;    // a slot went CSLOT_FULL -> CSLOT_DONE, or input ended
+
+    cslot_t* slots;
+    unsigned nslots;
+
+    // Block sequence numbers; block b lives in slots[b % nslots]. Blocks
+    // are filled, claimed, and written in order.
+    uint64_t next_fill;
+    uint64_t next_claim;
+    uint64_t next_write;
+
+    size_t pending;     // bytes accumulated in the slot being filled
+    bool input_done;
+    bool failed;
+
+    int fd;
+    pthread_t* workers;
+    unsigned nworkers;
+    pthread_t writer;
+} cstate_t;
+
+static void compress_fail_locked(cstate_t* cs) {
+    cs->failed = true;
+    pthread_cond_broadcast(&cs->slot_freed);
+    pthread_cond_broadcast(&cs->slot_filled);
+    pthread_cond_broadcast(&cs->slot_done);
+}
+
+static void* compress_worker(void* arg) {
+    cstate_t* cs = arg;
+
+    pthread_mutex_lock(&cs->lock);
+    for (;;) {
+        while (!cs->failed && cs->next_claim == cs->next_fill && !cs->input_done) {
+            pthread_cond_wait(&cs->slot_filled, &cs->lock);
+        }
+        if (cs->failed || cs->next_claim == cs->next_fill) {
+            break;
+        }
+
+        cslot_t* slot = &cs->slots[cs->next_claim % cs->nslots];
+        cs->next_claim++;
+        pthread_mutex_unlock(&cs->lock);
+
+        // Mirror what LZ4F does for an independent block: try to shave at
+        // least a byte off, otherwise store the block uncompressed with
+        // the high bit set in its size word.
+        int csz = LZ4_compress_HC((const char*)slot->inbuf, (char*)slot->outbuf + 4,
+                                  (int)slot->inlen, (int)slot->inlen - 1,
+                                  lz4_prefs.compressionLevel);
+        uint32_t sizeword;
+        if (csz > 0) {
+            sizeword = (uint32_t)csz;
+            slot->outlen = 4 + csz;
+        } else {
+            sizeword = (uint32_t)slot->inlen | CBLOCK_UNCOMPRESSED;
+            memcpy(slot->outbuf + 4, slot->inbuf, slot->inlen);
+            slot->outlen = 4 + slot->inlen;
+        }
+        memcpy(slot->outbuf, &sizeword, sizeof(sizeword));
+
+        pthread_mutex_lock(&cs->lock);
+        slot->state = CSLOT_DONE;
+        pthread_cond_broadcast(&cs->slot_done);
+    }
+    pthread_mutex_unlock(&cs->lock);
+    return NULL;
+}
+
+static void* compress_writer(void* arg) {
+    cstate_t* cs = arg;
+
+    pthread_mutex_lock(&cs->lock);
+    for (;;) {
+        cslot_t* slot = &cs->slots[cs->next_write % cs->nslots];
+        while (!cs->failed && slot->state != CSLOT_DONE &&
+               !(cs->input_done && cs->next_write == cs->next_fill)) {
+            pthread_cond_wait(&cs->slot_done, &cs->lock);
+        }
+        if (cs->failed || (cs->input_done && cs->next_write == cs->next_fill)) {
+            break;
+        }
+
+        pthread_mutex_unlock(&cs->lock);
+        int r = writex(cs->fd, slot->outbuf, slot->outlen);
+        pthread_mutex_lock(&cs->lock);
+
+        if (r < 0) {
+            compress_fail_locked(cs);
+            break;
+        }
+        slot->state = CSLOT_FREE;
+        cs->next_write++;
+        pthread_cond_broadcast(&cs->slot_freed);
+    }
+    pthread_mutex_unlock(&cs->lock);
+    return NULL;
+}
+
+static void compress_teardown(cstate_t* cs) {
+    free(cs->slots);
+    free(cs->workers);
+    free(cs);
+}
+
 ssize_t compress_setup(int fd, void** cookie) {
+    // The frame header (magic, flags, content size) still comes from
+    // LZ4F so it stays in sync with lz4_prefs; only the blocks and the
+    // end mark are written by hand.
     LZ4F_compressionContext_t cctx;
     LZ4F_errorCode_t errc = LZ4F_createCompressionContext(&cctx, LZ4F_VERSION);
     if (check_and_log_lz4_error(errc, "could not initialize compression context")) {
@@ -412,26 +594,94 @@ ssize_t compress_setup(int fd, void** cookie) {
     }
     uint8_t buf[128];
     size_t r = LZ4F_compressBegin(cctx, buf, sizeof(buf), &lz4_prefs);
+    LZ4F_freeCompressionContext(cctx);
     if (check_and_log_lz4_error(r, "could not begin compression")) {
-        return r;
+        return -1;
+    }
+    if (writex(fd, buf, r) < 0) {
+        return -1;
     }
 
-    // Note: LZ4F_compressionContext_t is a typedef to a pointer, so this is
-    // "safe".
-    *cookie = (void*)cctx;
+    cstate_t* cs = calloc(1, sizeof(cstate_t));
+    if (cs == NULL) {
+        fprintf(stderr, "OUT OF MEMORY\n");
+        return -1;
+    }
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cs->nworkers = (ncpus > 1) ? (unsigned)ncpus : 1;
+    cs->nslots = cs->nworkers * CSLOTS_PER_WORKER;
+    cs->fd = fd;
+    cs->slots = calloc(cs->nslots, sizeof(cslot_t));
+    cs->workers = calloc(cs->nworkers, sizeof(pthread_t));
+    if ((cs->slots == NULL) || (cs->workers == NULL)) {
+        fprintf(stderr, "OUT OF MEMORY\n");
+        compress_teardown(cs);
+        return -1;
+    }
+    pthread_mutex_init(&cs->lock, NULL);
+    pthread_cond_init(&cs->slot_freed, NULL);
+    pthread_cond_init(&cs->slot_filled, NULL);
+    pthread_cond_init(&cs->slot_done, NULL);
 
-    return writex(fd, buf, r);
+    unsigned started;
+    for (started = 0; started < cs->nworkers; started++) {
+        if (pthread_create(&cs->workers[started], NULL, compress_worker, cs) != 0) {
+            break;
+        }
+    }
+    if ((started < cs->nworkers) ||
+        (pthread_create(&cs->writer, NULL, compress_writer, cs) != 0)) {
+        fprintf(stderr, "error: could not start compression threads\n");
+        pthread_mutex_lock(&cs->lock);
+        compress_fail_locked(cs);
+        pthread_mutex_unlock(&cs->lock);
+        for (unsigned i = 0; i < started; i++) {
+            pthread_join(cs->workers[i], NULL);
+        }
+        compress_teardown(cs);
+        return -1;
+    }
+
+    *cookie = cs;
+    return 0;
 }
 
 ssize_t compress_data(int fd, const void* src, size_t len, void* cookie) {
-    // max will be, worst case, a bit larger than MAXBUFFER
-    size_t max = LZ4F_compressBound(len, &lz4_prefs);
-    uint8_t buf[max];
-    size_t r = LZ4F_compressUpdate((LZ4F_compressionContext_t)cookie, buf, max, src, len, NULL);
-    if (check_and_log_lz4_error(r, "could not compress data")) {
-        return -1;
+    cstate_t* cs = cookie;
+    const uint8_t* p = src;
+    size_t remaining = len;
+
+    pthread_mutex_lock(&cs->lock);
+    while (remaining > 0 && !cs->failed) {
+        cslot_t* slot = &cs->slots[cs->next_fill % cs->nslots];
+        while (!cs->failed && slot->state != CSLOT_FREE) {
+            pthread_cond_wait(&cs->slot_freed, &cs->lock);
+        }
+        if (cs->failed) {
+            break;
+        }
+
+        size_t xfer = CBLOCK_SIZE - cs->pending;
+        if (xfer > remaining) {
+            xfer = remaining;
+        }
+        memcpy(slot->inbuf + cs->pending, p, xfer);
+        cs->pending += xfer;
+        p += xfer;
+        remaining -= xfer;
+
+        if (cs->pending == CBLOCK_SIZE) {
+            slot->inlen = cs->pending;
+            slot->state = CSLOT_FULL;
+            cs->next_fill++;
+            cs->pending = 0;
+            pthread_cond_broadcast(&cs->slot_filled);
+        }
     }
-    return writex(fd, buf, r);
+    bool failed = cs->failed;
+    pthread_mutex_unlock(&cs->lock);
+
+    return failed ? -1 : (ssize_t)len;
 }
 
 ssize_t compress_file(int fd, const char* fn, size_t len, void* cookie) {
@@ -464,21 +714,44 @@ ssize_t compress_file(int fd, const char* fn, size_t len, void* cookie) {
 }
 
 ssize_t compress_finish(int fd, void* cookie) {
-    // Max write is one block (64kB uncompressed) plus 8 bytes of footer.
-    size_t max = LZ4F_compressBound(65536, &lz4_prefs) + 8;
-    uint8_t buf[max];
-    size_t r = LZ4F_compressEnd((LZ4F_compressionContext_t)cookie, buf, max, NULL);
-    if (check_and_log_lz4_error(r, "could not finish compression")) {
-        r = -1;
-    } else {
-        r = writex(fd, buf, r);
+    cstate_t* cs = cookie;
+    ssize_t r = 0;
+
+    pthread_mutex_lock(&cs->lock);
+    // Flush the partial final block, then let the pool drain.
+    if (cs->pending > 0 && !cs->failed) {
+        cslot_t* slot = &cs->slots[cs->next_fill % cs->nslots];
+        while (!cs->failed && slot->state != CSLOT_FREE) {
+            pthread_cond_wait(&cs->slot_freed, &cs->lock);
+        }
+        if (!cs->failed) {
+            slot->inlen = cs->pending;
+            slot->state = CSLOT_FULL;
+            cs->next_fill++;
+            cs->pending = 0;
+        }
     }
+    cs->input_done = true;
+    pthread_cond_broadcast(&cs->slot_filled);
+    pthread_cond_broadcast(&cs->slot_done);
+    pthread_mutex_unlock(&cs->lock);
 
-    LZ4F_errorCode_t errc = LZ4F_freeCompressionContext((LZ4F_compressionContext_t)cookie);
-    if (check_and_log_lz4_error(errc, "could not free compression context")) {
+    for (unsigned i = 0; i < cs->nworkers; i++) {
+        pthread_join(cs->workers[i], NULL);
+    }
+    pthread_join(cs->writer, NULL);
+
+    if (cs->failed) {
+        fprintf(stderr, "could not finish compression\n");
         r = -1;
+    } else {
+        // End mark: a zero size word. lz4_prefs requests no content
+        // checksum, so nothing follows it.
+        uint32_t endmark = 0;
+        r = writex(fd, &endmark, sizeof(endmark));
     }
 
+    compress_teardown(cs);
     return r;
 }
 
@@ -570,6 +843,21 @@ fail:
         CHECK(op->setup(fd, &cookie));
     }
 
+    // Directory index: entry count followed by the offset of each
+    // directory entry relative to the end of the bootdata header.
+    // The entries were sorted by name in the preflight pass, so the
+    // index supports lookup by binary search.
+    uint32_t count = 0;
+    for (e = item->first; e != NULL; e = e->next) {
+        count++;
+    }
+    CHECK(op->write(fd, &count, sizeof(count), cookie));
+    n = sizeof(uint32_t) * (count + 1);
+    for (e = item->first; e != NULL; e = e->next) {
+        CHECK(op->write(fd, &n, sizeof(n), cookie));
+        n += FSENTRYSZ + e->namelen;
+    }
+
     fsentry_t* last_entry = NULL;
     for (e = item->first; e != NULL; e = e->next) {
         uint32_t hdr[3];
@@ -635,7 +923,8 @@ fail:
                 BOOTDATA_BOOTFS_SYSTEM : BOOTDATA_BOOTFS_BOOT,
         .length = wrote,
         .extra = compressed ? item->outsize : wrote,
-        .flags = compressed ? BOOTDATA_BOOTFS_FLAG_COMPRESSED : 0
+        .flags = (compressed ? BOOTDATA_BOOTFS_FLAG_COMPRESSED : 0) |
+                 BOOTDATA_BOOTFS_FLAG_INDEXED,
     };
     if (writex(fd, &boothdr, sizeof(boothdr)) < 0) {
         return -1;
@@ -964,9 +1253,12 @@ int main(int argc, char **argv) {
     for (item_t* item = first_item; item != NULL; item = item->next) {
         switch (item->type) {
         case ITEM_BOOTFS_BOOT:
-        case ITEM_BOOTFS_SYSTEM:
-            // account for bootdata plus the end record
+        case ITEM_BOOTFS_SYSTEM: {
+            unsigned count = sort_entries(item);
+
+            // account for bootdata, the directory index, and the end record
             item->hdrsize += sizeof(bootdata_t) + 12;
+            item->hdrsize += sizeof(uint32_t) * (count + 1);
 
             size_t off = PAGEALIGN(item->hdrsize);
             fsentry_t* last_entry = NULL;
@@ -984,6 +1276,7 @@ int main(int argc, char **argv) {
             }
             item->outsize = off;
             break;
+        }
         default:
             break;
         }
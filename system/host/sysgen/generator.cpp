@@ -94,6 +94,27 @@ bool TraceInfoGenerator::syscall(ofstream& os, const Syscall& sc) {
     return os.good();
 }
 
+bool DescriptorInfoGenerator::syscall(ofstream& os, const Syscall& sc) {
+    if (sc.is_vdso())
+        return true;
+
+    // Bit i is set when the i-th argument register carries a handle
+    // value.  Output handles and handle arrays arrive through pointers,
+    // so they are not part of the mask.
+    uint32_t handle_args = 0;
+    for (size_t i = 0; i < sc.arg_spec.size(); ++i) {
+        const auto& arg = sc.arg_spec[i];
+        if (arg.type == "mx_handle_t" && arg.arr_spec == nullptr)
+            handle_args |= (1u << i);
+    }
+
+    // Can be injected as an array of structs indexed by syscall number.
+    os << "{\"" << sc.name << "\", " << sc.num_kernel_args() << ", "
+       << handle_args << "},\n";
+
+    return os.good();
+}
+
 bool CategoryGenerator::syscall(ofstream& os, const Syscall& sc) {
     for (const auto& attr : sc.attributes) {
         if (attr != "*" && attr != "internal")
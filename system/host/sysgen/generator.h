@@ -70,6 +70,13 @@ public:
     bool syscall(std::ofstream& os, const Syscall& sc) override;
 };
 
+// Generate the per-syscall descriptor table (name, argument count,
+// which argument registers carry handles).
+class DescriptorInfoGenerator : public Generator {
+public:
+    bool syscall(std::ofstream& os, const Syscall& sc) override;
+};
+
 // Generate category list.
 class CategoryGenerator : public Generator {
 public:
@@ -56,7 +56,7 @@ bool KernelWrapperGenerator::syscall(ofstream& os, const Syscall& sc) {
 
     write_x86_syscall_signature_line(os, sc, wrapper_prefix_);
 
-    os << in << "return do_syscall("
+    os << in << "return " << (sc.is_fastcall() ? "do_fast_syscall(" : "do_syscall(")
        << define_prefix_ << sc.name << ", "
        << "ip, "
        << "&VDso::ValidSyscallPC::" << sc.name << ", "
@@ -103,6 +103,7 @@ static SyscallNumbersGenerator syscall_num_generator("#define MX_SYS_");
 
 static RustBindingGenerator rust_binding_generator;
 static TraceInfoGenerator trace_generator;
+static DescriptorInfoGenerator descriptor_generator;
 static CategoryGenerator category_generator;
 
 const map<string, Generator&> type_to_generator = {
@@ -136,6 +137,10 @@ const map<string, Generator&> type_to_generator = {
     // The trace subsystem data, to be interpreted as an array of structs.
     {"trace", trace_generator},
 
+    // The per-syscall descriptor table, an array of structs indexed by
+    // syscall number.
+    {"descriptors", descriptor_generator},
+
     // Rust bindings.
     {"rust", rust_binding_generator},
 
@@ -157,6 +162,7 @@ const map<string, string> type_to_default_suffix = {
     {"arm-asm", ".arm64.S"},
     {"numbers", ".syscall-numbers.h"},
     {"trace", ".trace.inc"},
+    {"descriptors", ".descriptors.inc"},
     {"rust", ".rs"},
     {"vdso-wrappers", ".vdso-wrappers.inc"},
     {"category", ".category.inc"},
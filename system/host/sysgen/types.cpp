@@ -165,6 +165,10 @@ bool Syscall::is_internal() const {
     return has_attribute("internal", attributes);
 }
 
+bool Syscall::is_fastcall() const {
+    return has_attribute("fastcall", attributes);
+}
+
 size_t Syscall::num_kernel_args() const {
     return is_noreturn() ? arg_spec.size() : arg_spec.size() + ret_spec.size() - 1;
 }
@@ -203,6 +207,17 @@ bool Syscall::validate() const {
         return false;
     }
 
+    if (is_fastcall()) {
+        if (is_vdso() || is_blocking() || is_noreturn()) {
+            print_error("fastcall cannot be vdsocall, blocking or noreturn");
+            return false;
+        }
+        if (num_kernel_args() > 6) {
+            print_error("fastcall arguments must fit in registers (six or fewer)");
+            return false;
+        }
+    }
+
     bool valid_args = true;
     for_each_kernel_arg([this, &valid_args](const TypeSpec& arg) {
         if (arg.name.empty()) {
@@ -42,6 +42,11 @@
 // Flag indicating that the bootfs is compressed.
 #define BOOTDATA_BOOTFS_FLAG_COMPRESSED  (1 << 0)
 
+// Flag indicating that the bootfs directory is sorted by name and is
+// preceded by a bootdata_bootfs_index_t, so lookups may binary search
+// instead of scanning every entry.
+#define BOOTDATA_BOOTFS_FLAG_INDEXED     (1 << 1)
+
 
 // These items are for passing from bootloader to kernel
 
@@ -110,6 +115,16 @@ typedef struct {
     uint32_t flags;
 } bootdata_t;
 
+// When BOOTDATA_BOOTFS_FLAG_INDEXED is set, the bootfs payload begins
+// with this index rather than the first directory entry.  entry_off
+// holds the offset of each directory entry, relative to the first byte
+// after the bootdata_t header, ordered so that the entry names are
+// sorted (strcmp order).  The directory entries follow the index.
+typedef struct {
+    uint32_t count;
+    uint32_t entry_off[];
+} bootdata_bootfs_index_t;
+
 typedef struct {
     uint64_t phys_base;
     uint32_t width;
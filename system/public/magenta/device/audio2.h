@@ -35,6 +35,7 @@ typedef enum audio2_cmd {
     AUDIO2_RB_CMD_GET_BUFFER         = 0x3001,
     AUDIO2_RB_CMD_START              = 0x3002,
     AUDIO2_RB_CMD_STOP               = 0x3003,
+    AUDIO2_RB_CMD_GET_POSITION_VMO   = 0x3004,
 
     // Async notifications sent on the ring buffer channel.
     AUDIO2_RB_POSITION_NOTIFY        = 0x4000,
@@ -295,6 +296,43 @@ typedef struct audio2_rb_cmd_stop_resp {
     mx_status_t      result;
 } audio2_rb_cmd_stop_resp_t;
 
+// AUDIO2_RB_CMD_GET_POSITION_VMO
+//
+// Request a read-only VMO containing a single audio2_rb_position_buffer_t
+// which the driver keeps up to date while the ring buffer is started.
+// Clients which poll the shared buffer instead of subscribing to
+// AUDIO2_RB_POSITION_NOTIFY messages (by passing notifications_per_ring == 0
+// to AUDIO2_RB_CMD_GET_BUFFER) can observe the playback/capture position with
+// no syscalls in steady state; the channel is then only needed for
+// start/stop.
+//
+// The buffer is a sequence-locked register.  The driver increments `seq`
+// before updating the position and timestamp and again afterwards, so `seq`
+// is odd while an update is in flight.  Readers should load `seq`, copy the
+// fields, re-load `seq`, and retry if the two loads differ or are odd.
+//
+// The returned VMO remains valid until the ring buffer is reconfigured with
+// another AUDIO2_RB_CMD_GET_BUFFER request.
+//
+// May not be used with the NO_ACK flag.
+typedef struct audio2_rb_position_buffer {
+    uint32_t  seq;             // update sequence count; odd while inconsistent
+    uint32_t  ring_buffer_pos; // same semantics as audio2_rb_position_notify_t
+    mx_time_t timestamp;       // MX_CLOCK_MONOTONIC time the position was sampled
+} audio2_rb_position_buffer_t;
+
+typedef struct audio2_rb_cmd_get_position_vmo_req {
+    audio2_cmd_hdr_t hdr;
+} audio2_rb_cmd_get_position_vmo_req_t;
+
+typedef struct audio2_rb_cmd_get_position_vmo_resp {
+    audio2_cmd_hdr_t hdr;
+    mx_status_t      result;
+
+    // Note: Upon success, a read-only VMO handle containing the position
+    // buffer will also be returned.
+} audio2_rb_cmd_get_position_vmo_resp_t;
+
 // AUDIO2_RB_POSITION_NOTIFY
 typedef struct audio2_rb_position_notify {
     audio2_cmd_hdr_t hdr;
@@ -43,6 +43,34 @@
 #define IOCTL_BLOCK_FIFO_CLOSE \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 10)
 
+// Multi-queue interface. A block device exposes some number of independent
+// queues, each of which is a separate FIFO with its own VMO attachments,
+// txns, and completions. Queues share no locks on the submission path, so
+// clients (typically one queue per thread) can scale IOPS with cores on
+// hardware which provides multiple submission/completion rings.
+//
+// The single-FIFO interface above is equivalent to operating queue 0 alone,
+// and may not be mixed with the multi-queue interface on the same device.
+
+// Get the number of independent queues supported by the block device
+#define IOCTL_BLOCK_MQ_GET_QUEUE_COUNT \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 11)
+// Set up a FIFO-based server on a single queue; acquire the handle to it
+#define IOCTL_BLOCK_MQ_GET_FIFO \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_BLOCK, 12)
+// Attach a VMO to a single queue's running FIFO server
+#define IOCTL_BLOCK_MQ_ATTACH_VMO \
+    IOCTL(IOCTL_KIND_SET_HANDLE, IOCTL_FAMILY_BLOCK, 13)
+// Allocate a txn with a single queue's running FIFO server
+#define IOCTL_BLOCK_MQ_ALLOC_TXN \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 14)
+// Free a txn from a single queue's running FIFO server
+#define IOCTL_BLOCK_MQ_FREE_TXN \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 15)
+// Shut down a single queue's fifo server; see IOCTL_BLOCK_FIFO_CLOSE
+#define IOCTL_BLOCK_MQ_FIFO_CLOSE \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 16)
+
 // Block Core ioctls (specific to each block device):
 
 #define BLOCK_FLAG_READONLY  0x00000001
@@ -96,6 +124,42 @@ IOCTL_WRAPPER_IN(ioctl_block_free_txn, IOCTL_BLOCK_FREE_TXN, txnid_t);
 // ssize_t ioctl_block_fifo_close(int fd);
 IOCTL_WRAPPER(ioctl_block_fifo_close, IOCTL_BLOCK_FIFO_CLOSE);
 
+// An upper bound on the number of queues a device may expose through the
+// multi-queue interface; the actual count is reported by
+// IOCTL_BLOCK_MQ_GET_QUEUE_COUNT and may be smaller.
+#define MAX_BLOCK_MQ_QUEUES 8
+
+// ssize_t ioctl_block_mq_get_queue_count(int fd, uint32_t* out_count);
+IOCTL_WRAPPER_OUT(ioctl_block_mq_get_queue_count, IOCTL_BLOCK_MQ_GET_QUEUE_COUNT, uint32_t);
+
+// ssize_t ioctl_block_mq_get_fifo(int fd, const uint32_t* in_queue, mx_handle_t* fifo_out);
+IOCTL_WRAPPER_INOUT(ioctl_block_mq_get_fifo, IOCTL_BLOCK_MQ_GET_FIFO, uint32_t, mx_handle_t);
+
+typedef struct {
+    mx_handle_t vmo; // The handle must lead so the ioctl layer can splice it in.
+    uint32_t queue;
+} block_mq_attach_vmo_args_t;
+
+// ssize_t ioctl_block_mq_attach_vmo(int fd, const block_mq_attach_vmo_args_t* in,
+//                                   vmoid_t* out_vmoid);
+IOCTL_WRAPPER_INOUT(ioctl_block_mq_attach_vmo, IOCTL_BLOCK_MQ_ATTACH_VMO,
+                    block_mq_attach_vmo_args_t, vmoid_t);
+
+// ssize_t ioctl_block_mq_alloc_txn(int fd, const uint32_t* in_queue, txnid_t* out_txnid);
+IOCTL_WRAPPER_INOUT(ioctl_block_mq_alloc_txn, IOCTL_BLOCK_MQ_ALLOC_TXN, uint32_t, txnid_t);
+
+typedef struct {
+    uint32_t queue;
+    txnid_t txnid;
+    uint16_t reserved0;
+} block_mq_free_txn_args_t;
+
+// ssize_t ioctl_block_mq_free_txn(int fd, const block_mq_free_txn_args_t* in);
+IOCTL_WRAPPER_IN(ioctl_block_mq_free_txn, IOCTL_BLOCK_MQ_FREE_TXN, block_mq_free_txn_args_t);
+
+// ssize_t ioctl_block_mq_fifo_close(int fd, const uint32_t* in_queue);
+IOCTL_WRAPPER_IN(ioctl_block_mq_fifo_close, IOCTL_BLOCK_MQ_FIFO_CLOSE, uint32_t);
+
 // Multiple Block IO operations may be sent at once before a response is actually sent back.
 // Block IO ops may be sent concurrently to different vmoids, and they also may be sent
 // to different transactions at any point in time. Up to MAX_TXN_COUNT transactions may
@@ -58,6 +58,30 @@
 #define IOCTL_DEVICE_DEBUG_RESUME \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DEVICE, 8)
 
+// Perform a batch of ioctls in a single message
+//   in: sequence of device_batch_entry_t, each followed by its input
+//       payload, padded to 4 byte alignment
+//   out: sequence of device_batch_result_t, one per entry in order, each
+//       followed by its output payload, padded to 4 byte alignment
+// Only IOCTL_KIND_DEFAULT ioctls may be batched (no handle transfer),
+// and batches may not nest.  Entries are executed in order; a failed
+// entry does not stop the batch.
+#define IOCTL_DEVICE_BATCH \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DEVICE, 9)
+
+typedef struct {
+    uint32_t op;      // the ioctl to perform
+    uint32_t in_len;  // bytes of input payload following this header
+    uint32_t out_len; // maximum bytes of output wanted
+} device_batch_entry_t;
+
+typedef struct {
+    int32_t status;   // result of the ioctl
+    uint32_t out_len; // bytes of output payload following this header
+} device_batch_result_t;
+
+#define DEVICE_BATCH_ALIGN(n) (((n) + 3) & ~3u)
+
 // Indicates if there's data available to read,
 // or room to write, or an error condition.
 #define DEVICE_SIGNAL_READABLE MX_USER_SIGNAL_0
@@ -89,3 +113,6 @@ IOCTL_WRAPPER(ioctl_device_debug_resume, IOCTL_DEVICE_DEBUG_RESUME);
 
 // ssize_t ioctl_device_sync(int fd);
 IOCTL_WRAPPER(ioctl_device_sync, IOCTL_DEVICE_SYNC);
+
+// ssize_t ioctl_device_batch(int fd, const void* in, size_t in_len, void* out, size_t out_len);
+IOCTL_WRAPPER_VARIN_VAROUT(ioctl_device_batch, IOCTL_DEVICE_BATCH, void, void);
@@ -59,6 +59,30 @@ typedef struct mx_display_info {
 #define IOCTL_DISPLAY_SET_OWNER \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DISPLAY, 6)
 
+// Queue a VMO-backed frame for scanout at the next display refresh.
+// The vmo handle is consumed.  Returns MX_ERR_SHOULD_WAIT if the flip
+// queue is full; wait for the flip event before presenting again.
+//   in: ioctl_display_present_t
+//   out: none
+#define IOCTL_DISPLAY_PRESENT_FB \
+    IOCTL(IOCTL_KIND_SET_HANDLE, IOCTL_FAMILY_DISPLAY, 7)
+
+// Get an event used to pace presentation.  MX_USER_SIGNAL_0 is asserted
+// whenever the flip queue has space for another frame, and cleared while
+// it is full.  A client that renders, presents, then waits for the signal
+// draws exactly once per display refresh once the queue is saturated.
+//   in: none
+//   out: mx_handle_t
+#define IOCTL_DISPLAY_GET_FLIP_EVENT \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_DISPLAY, 8)
+
+// Return the sequence number and refresh timestamp of the most recently
+// scanned out frame queued by this client.
+//   in: none
+//   out: ioctl_display_present_info_t
+#define IOCTL_DISPLAY_GET_PRESENT_INFO \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DISPLAY, 9)
+
 typedef struct {
     mx_handle_t vmo;
     mx_display_info_t info;
@@ -71,6 +95,17 @@ typedef struct {
     uint32_t height;
 } ioctl_display_region_t;
 
+typedef struct {
+    mx_handle_t vmo;    // frame contents; consumed by the ioctl
+    uint32_t seq;       // client-chosen id, reported back in present info
+} ioctl_display_present_t;
+
+typedef struct {
+    uint32_t seq;        // seq of the last frame scanned out
+    uint32_t queued;     // frames still waiting in the flip queue
+    mx_time_t vsync_time; // MX_CLOCK_MONOTONIC time of the refresh that displayed it
+} ioctl_display_present_info_t;
+
 // ssize_t ioctl_display_get_fb(int fd, ioctl_display_get_fb_t* out);
 IOCTL_WRAPPER_OUT(ioctl_display_get_fb, IOCTL_DISPLAY_GET_FB, ioctl_display_get_fb_t);
 
@@ -87,4 +122,13 @@ IOCTL_WRAPPER_IN(ioctl_display_set_fullscreen, IOCTL_DISPLAY_SET_FULLSCREEN, uin
 IOCTL_WRAPPER_OUT(ioctl_display_get_ownership_change_event, IOCTL_DISPLAY_GET_OWNERSHIP_CHANGE_EVENT, mx_handle_t);
 
 // ssize_t ioctl_display_set_owner(int fd, uint32_t owner);
-IOCTL_WRAPPER_IN(ioctl_display_set_owner, IOCTL_DISPLAY_SET_OWNER, uint32_t)
\ No newline at end of file
+IOCTL_WRAPPER_IN(ioctl_display_set_owner, IOCTL_DISPLAY_SET_OWNER, uint32_t)
+
+// ssize_t ioctl_display_present_fb(int fd, const ioctl_display_present_t* in);
+IOCTL_WRAPPER_IN(ioctl_display_present_fb, IOCTL_DISPLAY_PRESENT_FB, ioctl_display_present_t);
+
+// ssize_t ioctl_display_get_flip_event(int fd, mx_handle_t* out);
+IOCTL_WRAPPER_OUT(ioctl_display_get_flip_event, IOCTL_DISPLAY_GET_FLIP_EVENT, mx_handle_t);
+
+// ssize_t ioctl_display_get_present_info(int fd, ioctl_display_present_info_t* out);
+IOCTL_WRAPPER_OUT(ioctl_display_get_present_info, IOCTL_DISPLAY_GET_PRESENT_INFO, ioctl_display_present_info_t);
\ No newline at end of file
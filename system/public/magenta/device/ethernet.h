@@ -26,7 +26,19 @@ typedef struct eth_info_t {
 } eth_info_t;
 
 #define ETH_SIGNAL_STATUS MX_USER_SIGNAL_0
-#define ETH_FEATURE_WLAN 1
+
+// Feature bits reported in eth_info_t.features:
+// ETH_FEATURE_RX_CSUM: the device validates IP/TCP/UDP checksums on
+//   receive; rx fifo entries carry ETH_FIFO_RX_CSUM_OK when they passed.
+// ETH_FEATURE_TX_CSUM: the device inserts checksums on transmit for
+//   packets queued with ETH_FIFO_TX_CSUM.
+// ETH_FEATURE_TSO: the device can segment large TCP payloads on transmit.
+//   Per-packet segmentation parameters are not carried by the fifo entry
+//   yet, so this bit only advertises the capability.
+#define ETH_FEATURE_WLAN    (1u)
+#define ETH_FEATURE_RX_CSUM (2u)
+#define ETH_FEATURE_TX_CSUM (4u)
+#define ETH_FEATURE_TSO     (8u)
 
 // Get the fifos to submit tx and rx operations
 //   in: none
@@ -76,6 +88,87 @@ typedef struct eth_fifos_t {
 // Link status bits:
 #define ETH_STATUS_ONLINE (1u)
 
+// Install a receive packet filter for this client.
+//   in: array of eth_filter_insn_t (an empty program removes the filter)
+//   out: none
+#define IOCTL_ETHERNET_SET_FILTER \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_ETH, 9)
+
+// Install a shared-vmo capture ring for this client.
+//   in: mx_handle_t (vmo)
+//   out: none
+#define IOCTL_ETHERNET_SET_CAPTURE_RING \
+    IOCTL(IOCTL_KIND_SET_HANDLE, IOCTL_FAMILY_ETH, 10)
+
+// Configure interrupt moderation on the underlying device.
+//   in: int32_t (< 0: adaptive, 0: one interrupt per event,
+//                > 0: cap interrupts at this many per second)
+//   out: none
+// Returns MX_ERR_NOT_SUPPORTED if the device has no moderation control.
+#define IOCTL_ETHERNET_SET_MODERATION \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_ETH, 11)
+
+// Filter programs are a sequence of eth_filter_insn_t evaluated against
+// each received packet in the driver, before any copy into the client's
+// buffers.  The accumulator starts at 0 and loads beyond the end of the
+// packet evaluate to 0.  Jump targets are forward skip counts, so every
+// program terminates; a program that runs off its end accepts the packet.
+enum {
+    ETH_FILTER_OP_LDB = 1,    // acc = packet byte at k
+    ETH_FILTER_OP_LDH = 2,    // acc = big-endian 16 bits at k
+    ETH_FILTER_OP_LDW = 3,    // acc = big-endian 32 bits at k
+    ETH_FILTER_OP_JEQ = 4,    // skip jt insns if acc == k, else skip jf
+    ETH_FILTER_OP_JGT = 5,    // skip jt insns if acc > k, else skip jf
+    ETH_FILTER_OP_JSET = 6,   // skip jt insns if acc & k, else skip jf
+    ETH_FILTER_OP_ACCEPT = 7, // deliver the packet
+    ETH_FILTER_OP_REJECT = 8, // drop the packet
+};
+
+typedef struct eth_filter_insn {
+    uint16_t op;
+    uint8_t jt;
+    uint8_t jf;
+    uint32_t k;
+} eth_filter_insn_t;
+
+#define ETH_FILTER_MAX_INSNS 64
+
+// Capture ring operation
+//
+// The vmo is divided into ETH_CAPTURE_SLOT_SIZE slots.  The first slot
+// holds the eth_capture_header_t; the rest each hold one received packet
+// as an eth_capture_record_t followed by up to ETH_CAPTURE_MAX_DATA bytes
+// of packet data (longer packets are truncated).  While a ring is
+// installed, received packets that pass the filter are written into the
+// ring instead of the rx fifo, so steady-state capture does no syscalls.
+//
+// rd and wr are free-running slot counts (index with wr % slots).  The
+// driver fills the slot, then advances wr; the client consumes the slot,
+// then advances rd.  If the ring is full the packet is counted in
+// dropped instead.
+//
+// ETH_SIGNAL_CAPTURE is asserted on the rx fifo whenever the ring goes
+// from empty to non-empty.  Before waiting, the client should clear the
+// signal and then re-check the ring to avoid missing that transition.
+#define ETH_CAPTURE_SLOT_SIZE 2048
+
+typedef struct eth_capture_header {
+    uint32_t rd;       // advanced by the client
+    uint32_t wr;       // advanced by the driver
+    uint32_t slots;    // record slots in the ring, set by the driver
+    uint32_t dropped;  // packets lost because the ring was full
+} eth_capture_header_t;
+
+typedef struct eth_capture_record {
+    uint32_t length;     // captured bytes following this record
+    uint32_t flags;      // ETH_FIFO_RX_* flags
+    mx_time_t timestamp; // MX_CLOCK_MONOTONIC time of receipt
+} eth_capture_record_t;
+
+#define ETH_CAPTURE_MAX_DATA (ETH_CAPTURE_SLOT_SIZE - sizeof(eth_capture_record_t))
+
+#define ETH_SIGNAL_CAPTURE MX_USER_SIGNAL_1
+
 // Operation
 //
 // Packets are transmitted by writing data into the io_vmo and writing
@@ -98,13 +191,16 @@ typedef struct eth_fifos_t {
 // are returned along with the fifo handles in the eth_fifos_t.
 
 // flags values for request messages
-// - none -
+#define ETH_FIFO_TX_CSUM (8u)   // device should insert IP/TCP/UDP checksums
+                                // (only with ETH_FEATURE_TX_CSUM)
 
 // flags values for response messages
 #define ETH_FIFO_RX_OK   (1u)   // packet received okay
 #define ETH_FIFO_TX_OK   (1u)   // packet transmitted okay
 #define ETH_FIFO_INVALID (2u)   // offset+length not within io_vmo bounds
 #define ETH_FIFO_RX_TX   (4u)   // received our own tx packet (when TX_LISTEN)
+#define ETH_FIFO_RX_CSUM_OK (8u) // device validated IP/TCP/UDP checksums
+                                 // (only with ETH_FEATURE_RX_CSUM)
 
 typedef struct eth_fifo_entry {
     // offset from start of io_vmo to packet data
@@ -141,4 +237,13 @@ IOCTL_WRAPPER(ioctl_ethernet_tx_listen_stop, IOCTL_ETHERNET_TX_LISTEN_STOP);
 IOCTL_WRAPPER_VARIN(ioctl_ethernet_set_client_name, IOCTL_ETHERNET_SET_CLIENT_NAME, char);
 
 // ssize_t ioctl_ethernet_get_status(int fd, uint32_t*);
-IOCTL_WRAPPER_OUT(ioctl_ethernet_get_status, IOCTL_ETHERNET_GET_STATUS, uint32_t);
\ No newline at end of file
+IOCTL_WRAPPER_OUT(ioctl_ethernet_get_status, IOCTL_ETHERNET_GET_STATUS, uint32_t);
+
+// ssize_t ioctl_ethernet_set_filter(int fd, const eth_filter_insn_t* in, size_t in_len);
+IOCTL_WRAPPER_VARIN(ioctl_ethernet_set_filter, IOCTL_ETHERNET_SET_FILTER, eth_filter_insn_t);
+
+// ssize_t ioctl_ethernet_set_capture_ring(int fd, mx_handle_t* in);
+IOCTL_WRAPPER_IN(ioctl_ethernet_set_capture_ring, IOCTL_ETHERNET_SET_CAPTURE_RING, mx_handle_t);
+
+// ssize_t ioctl_ethernet_set_moderation(int fd, const int32_t* in);
+IOCTL_WRAPPER_IN(ioctl_ethernet_set_moderation, IOCTL_ETHERNET_SET_MODERATION, int32_t);
\ No newline at end of file
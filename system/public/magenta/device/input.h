@@ -26,6 +26,8 @@
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 7)
 #define IOCTL_INPUT_SET_REPORT \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 8)
+#define IOCTL_INPUT_SET_WAKE_CONFIG \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 9)
 
 enum {
     INPUT_PROTO_NONE = 0,
@@ -59,6 +61,19 @@ typedef struct input_set_report {
     uint8_t data[];
 } input_set_report_t;
 
+// Moderates how often a hid device instance wakes its reader.  The instance
+// signals readable once |threshold_reports| input reports are queued, or as
+// soon as a report arrives |max_latency_usec| or more after the oldest queued
+// report (0 disables the latency bound).  A threshold of 1 (the default)
+// signals on every report.  Intended for high-rate devices; note that if the
+// report stream pauses, up to threshold-1 trailing reports wait until the
+// next report arrives, so pick a threshold suited to your read cadence.
+// Reads always drain as many whole queued reports as fit in the buffer.
+typedef struct input_wake_config {
+    uint32_t threshold_reports;
+    uint32_t max_latency_usec;
+} input_wake_config_t;
+
 typedef struct boot_kbd_report {
     uint8_t modifier;
     uint8_t reserved;
@@ -101,3 +116,6 @@ IOCTL_WRAPPER_IN_VAROUT(ioctl_input_get_report, IOCTL_INPUT_GET_REPORT,
 
 // ssize_t ioctl_input_set_report(int fd, const input_set_report_t* in, size_t in_len);
 IOCTL_WRAPPER_VARIN(ioctl_input_set_report, IOCTL_INPUT_SET_REPORT, input_set_report_t);
+
+// ssize_t ioctl_input_set_wake_config(int fd, const input_wake_config_t* in);
+IOCTL_WRAPPER_IN(ioctl_input_set_wake_config, IOCTL_INPUT_SET_WAKE_CONFIG, input_wake_config_t);
@@ -7,11 +7,20 @@
 #include <limits.h>
 #include <magenta/device/ioctl.h>
 #include <magenta/device/ioctl-wrapper.h>
+#include <magenta/types.h>
 
 #define IOCTL_RAMDISK_CONFIG \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 1)
 #define IOCTL_RAMDISK_UNLINK \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 2)
+// Release the pages backing a block-aligned range of the ramdisk to the
+// system. Reading a trimmed range returns zeros until it is written again.
+#define IOCTL_RAMDISK_TRIM \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 3)
+// Obtain a duplicate handle to the VMO backing the ramdisk. Mapping it
+// gives direct access to the disk contents, without any copies.
+#define IOCTL_RAMDISK_GET_VMO \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_RAMDISK, 4)
 
 typedef struct ramdisk_ioctl_config {
     uint64_t blk_size;
@@ -22,6 +31,11 @@ typedef struct ramdisk_ioctl_config_response {
     char name[NAME_MAX + 1];
 } ramdisk_ioctl_config_response_t;
 
+typedef struct ramdisk_ioctl_trim {
+    uint64_t offset; // bytes; must be block aligned
+    uint64_t length; // bytes; must be block aligned
+} ramdisk_ioctl_trim_t;
+
 // ssize_t ioctl_ramdisk_config(int fd, const ramdisk_ioctl_config_t* in,
 //                              ramdisk_ioctl_config_response_t* out);
 IOCTL_WRAPPER_INOUT(ioctl_ramdisk_config, IOCTL_RAMDISK_CONFIG, ramdisk_ioctl_config_t,
@@ -29,3 +43,9 @@ IOCTL_WRAPPER_INOUT(ioctl_ramdisk_config, IOCTL_RAMDISK_CONFIG, ramdisk_ioctl_co
 
 // ssize_t ioctl_ramdisk_unlink(int fd);
 IOCTL_WRAPPER(ioctl_ramdisk_unlink, IOCTL_RAMDISK_UNLINK);
+
+// ssize_t ioctl_ramdisk_trim(int fd, const ramdisk_ioctl_trim_t* in);
+IOCTL_WRAPPER_IN(ioctl_ramdisk_trim, IOCTL_RAMDISK_TRIM, ramdisk_ioctl_trim_t);
+
+// ssize_t ioctl_ramdisk_get_vmo(int fd, mx_handle_t* out);
+IOCTL_WRAPPER_OUT(ioctl_ramdisk_get_vmo, IOCTL_RAMDISK_GET_VMO, mx_handle_t);
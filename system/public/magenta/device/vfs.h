@@ -63,12 +63,32 @@
 #define IOCTL_VFS_GET_DEVICE_PATH \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_VFS, 9)
 
+// Watch a directory for changes to entries whose names begin with a
+// given prefix. Events for other names are filtered at the source, so
+// the watch channel is not written (and the watcher not woken) for them.
+// Message format matches IOCTL_VFS_WATCH_DIR.
+// in: vfs_watch_dir_filtered_t
+//
+// This ioctl is currently only supported by devfs.
+#define IOCTL_VFS_WATCH_DIR_FILTERED \
+    IOCTL(IOCTL_KIND_SET_HANDLE, IOCTL_FAMILY_VFS, 10)
+
 typedef struct {
     mx_handle_t channel; // Channel to which watch events will be sent
     uint32_t mask;       // Bitmask of desired events (1 << WATCH_EVT_*)
     uint32_t options;    // Options.  Must be zero.
 } vfs_watch_dir_t;
 
+#define VFS_WATCH_FILTER_MAX 32
+
+typedef struct {
+    mx_handle_t channel; // Channel to which watch events will be sent
+    uint32_t mask;       // Bitmask of desired events (1 << WATCH_EVT_*)
+    uint32_t options;    // Options.  Must be zero.
+    char filter[VFS_WATCH_FILTER_MAX]; // Null-terminated name prefix;
+                                       // "" matches every name.
+} vfs_watch_dir_filtered_t;
+
 // Indicates that the directory being watched has been deleted.
 // namelen will be 0
 #define VFS_WATCH_EVT_DELETED 0
@@ -89,6 +109,11 @@ typedef struct {
 // namelen will be 0
 #define VFS_WATCH_EVT_IDLE 4
 
+// Indication that the server dropped events because the client
+// could not keep up; the client should rescan the directory.
+// Sent regardless of the watch mask.  namelen will be 0
+#define VFS_WATCH_EVT_OVERFLOW 5
+
 typedef struct {
     uint8_t event;
     uint8_t len;
@@ -144,6 +169,9 @@ IOCTL_WRAPPER_IN(ioctl_vfs_watch_dir, IOCTL_VFS_WATCH_DIR_V2, vfs_watch_dir_t);
 __attribute__((deprecated("This has been renamed to ioctl_vfs_watch_dir")))
 IOCTL_WRAPPER_IN(ioctl_vfs_watch_dir_v2, IOCTL_VFS_WATCH_DIR_V2, vfs_watch_dir_t);
 
+// ssize_t ioctl_vfs_watch_dir_filtered(int fd, vfs_watch_dir_filtered_t* in);
+IOCTL_WRAPPER_IN(ioctl_vfs_watch_dir_filtered, IOCTL_VFS_WATCH_DIR_FILTERED, vfs_watch_dir_filtered_t);
+
 // ssize_t ioctl_vfs_get_device_path(int fd, char* out, size_t out_len);
 IOCTL_WRAPPER_VAROUT(ioctl_vfs_get_device_path, IOCTL_VFS_GET_DEVICE_PATH, char);
 
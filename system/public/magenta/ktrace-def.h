@@ -51,6 +51,8 @@ KTRACE_DEF(0x143,32B,PORT_QUEUE,IPC) // id, size
 KTRACE_DEF(0x150,32B,WAIT_ONE,IPC) // id, signals, timeoutlo, timeouthi
 KTRACE_DEF(0x151,32B,WAIT_ONE_DONE,IPC) // id, status, pending
 
+KTRACE_DEF(0x160,32B,PROF_SAMPLE,PROFILE) // pc_lo, pc_hi, caller_lo, caller_hi
+
 // events from 0x200-0x2ff are for arch-specific needs
 
 #ifdef __x86_64__
@@ -58,6 +60,7 @@ KTRACE_DEF(0x200,32B,IPT_START,ARCH) // MSR_PLATFORM_INFO[15:8], kernel cr3
 KTRACE_DEF(0x201,32B,IPT_CPU_INFO,ARCH) // family, model, stepping
 KTRACE_DEF(0x202,32B,IPT_STOP,ARCH)
 KTRACE_DEF(0x203,32B,IPT_PROCESS_CREATE,ARCH) // pid, cr3
+KTRACE_DEF(0x204,32B,PMU_SAMPLE,ARCH) // instructions, cycles, llc_misses, branch_misses
 #endif
 
 #undef KTRACE_DEF
@@ -63,6 +63,16 @@ static inline void list_delete(list_node_t* item) {
     item->prev = item->next = 0;
 }
 
+// replaces old_node with new_node in the list it is linked into;
+// old_node is left cleared
+static inline void list_replace_node(list_node_t* old_node, list_node_t* new_node) {
+    new_node->next = old_node->next;
+    new_node->prev = old_node->prev;
+    old_node->prev->next = new_node;
+    old_node->next->prev = new_node;
+    old_node->prev = old_node->next = 0;
+}
+
 static inline list_node_t* list_remove_head(list_node_t* list) {
     if (list->next != list) {
         list_node_t* item = list->next;
@@ -70,4 +70,33 @@ typedef struct {
 } mdi_node_t;
 static_assert(sizeof(mdi_node_t) == 16, "");
 
+// An MDI file may optionally contain a node lookup index following the root
+// node's subtree, so mdi_find_node() does not need to scan lists linearly.
+// The index maps (parent list offset, child id) pairs to child node offsets.
+// All offsets are relative to the start of the root node.
+// mdi_index_t is followed by bucket_count mdi_index_entry_t buckets forming
+// an open addressed hash table with linear probing. bucket_count is a power
+// of two and at least twice the number of live entries, so an empty bucket
+// (node_off == 0) always terminates a failed lookup.
+// Only the first child with a given id within a list is indexed, matching
+// mdi_find_node's first-match semantics.
+
+#define MDI_INDEX_MAGIC 0x5849444d  // MDIX
+
+#define MDI_INDEX_HASH(parent_off, id) \
+    ((((uint32_t)(id)) * 2654435761u) ^ ((uint32_t)(parent_off)))
+
+typedef struct {
+    uint32_t    magic;          // MDI_INDEX_MAGIC
+    uint32_t    bucket_count;   // number of hash buckets following this struct
+} mdi_index_t;
+
+typedef struct {
+    mdi_id_t    id;             // id of the child node
+    uint32_t    parent_off;     // offset of the child's parent list node
+    uint32_t    node_off;       // offset of the child node, zero if this bucket is empty
+    uint32_t    child_index;    // position of the child within its parent's list
+} mdi_index_entry_t;
+static_assert(sizeof(mdi_index_entry_t) == 16, "");
+
 __END_CDECLS;
@@ -17,6 +17,8 @@ __BEGIN_CDECLS
 // before it's useful; it's here in the interests of hackability in the
 // interim.
 #define MTRACE_KIND_IPT 0
+#define MTRACE_KIND_PROFILE 1
+#define MTRACE_KIND_PMU 2
 
 // Actions for perf_control
 
@@ -35,6 +37,30 @@ __BEGIN_CDECLS
 #define MTRACE_IPT_CPU_MODE_STOP 5
 #define MTRACE_IPT_CPU_MODE_FREE 6
 
+// Actions for the sampling profiler.
+
+// Start sampling on every cpu. |options| is the sampling period in
+// microseconds, or 0 for the default. Samples land in the ktrace stream
+// as PROF_SAMPLE records, so ktrace must be started with
+// KTRACE_GRP_PROFILE in its group mask for any to be recorded.
+#define MTRACE_PROFILE_START 0
+
+// Stop sampling on every cpu.
+#define MTRACE_PROFILE_STOP 1
+
+// Actions for hardware performance counter sampling.
+
+// Start counting on every cpu. The fixed counters (instructions
+// retired, unhalted core cycles) and two programmable counters (LLC
+// misses, branch misses) are zeroed and enabled; every context switch
+// emits the deltas charged to the outgoing thread as a PMU_SAMPLE
+// ktrace record, so ktrace must be started with KTRACE_GRP_ARCH in
+// its group mask for any to be recorded. |options| must be 0.
+#define MTRACE_PMU_START 0
+
+// Stop counting on every cpu.
+#define MTRACE_PMU_STOP 1
+
 // Encode/decode options values for mtrace_control().
 // At present we just encode the cpu number here.
 // We only support 32 cpus at the moment, the extra bit is for magic values.
@@ -19,6 +19,7 @@ __BEGIN_CDECLS
 #define MX_HYPERVISOR_OP_VCPU_INTERRUPT     5u
 #define MX_HYPERVISOR_OP_VCPU_READ_STATE    6u
 #define MX_HYPERVISOR_OP_VCPU_WRITE_STATE   7u
+#define MX_HYPERVISOR_OP_GUEST_COMMIT       8u
 
 #define MX_GUEST_MAX_PKT_SIZE               32u
 
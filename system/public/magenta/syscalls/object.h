@@ -30,6 +30,11 @@ typedef enum {
     MX_INFO_CPU_STATS                  = 16, // mx_info_cpu_stats_t[n]
     MX_INFO_KMEM_STATS                 = 17, // mx_info_kmem_stats_t[1]
     MX_INFO_RESOURCE                   = 18, // mx_info_resource_t[1]
+    MX_INFO_JOB_STATS                  = 19, // mx_info_job_stats_t[1]
+    MX_INFO_NUMA_NODES                 = 20, // mx_info_numa_node_t[n]
+    MX_INFO_CPU_TOPOLOGY               = 21, // mx_info_cpu_topology_t[n]
+    MX_INFO_TASK_TREE                  = 22, // mx_info_task_tree_entry_t[n]
+    MX_INFO_KMEM_ARENAS                = 23, // mx_info_kmem_arena_t[n]
     MX_INFO_LAST
 } mx_object_info_topic_t;
 
@@ -143,6 +148,47 @@ typedef struct mx_info_task_stats {
     size_t mem_scaled_shared_bytes;
 } mx_info_task_stats_t;
 
+// Statistics about resources used by a job. Unlike MX_INFO_TASK_STATS,
+// these are maintained incrementally by the kernel and are cheap to read.
+typedef struct mx_info_job_stats {
+    // Memory committed to VMOs created by processes in this job. VMOs
+    // created by processes in descendant jobs are billed to those jobs,
+    // and a VMO stays billed to the job whose process created it even if
+    // the handle moves elsewhere.
+    size_t mem_committed_bytes;
+} mx_info_job_stats_t;
+
+// A single task in a MX_INFO_TASK_TREE snapshot of a job subtree.
+// Tasks are returned in depth-first pre-order: a job's processes come
+// before its child jobs, a process's threads immediately follow the
+// process, and every task's parent appears earlier in the list. The
+// first entry is the job the query was made on.
+typedef struct mx_info_task_tree_entry {
+    mx_koid_t koid;
+
+    // koid of the containing task: the process for a thread, the job
+    // for a process or a job. Zero if the task has no parent.
+    mx_koid_t parent_koid;
+
+    // One of MX_OBJ_TYPE_JOB, MX_OBJ_TYPE_PROCESS or MX_OBJ_TYPE_THREAD.
+    uint32_t type;
+
+    // One of MX_THREAD_STATE_* for threads; zero for jobs and processes.
+    uint32_t state;
+
+    // MX_EXCEPTION_PORT_TYPE_* if a thread is waiting for an exception
+    // to be handled; zero otherwise.
+    uint32_t wait_exception_port_type;
+
+    uint32_t reserved;
+
+    // Total accumulated running time for threads; zero for jobs and
+    // processes.
+    mx_time_t runtime;
+
+    char name[MX_MAX_NAME_LEN];
+} mx_info_task_tree_entry_t;
+
 typedef struct mx_info_vmar {
     // Base address of the region.
     uintptr_t base;
@@ -244,6 +290,12 @@ typedef struct mx_info_vmo {
     // See |flags| for the type of clone.
     mx_koid_t parent_koid;
 
+    // If this VMO is a clone, the number of ancestors between it and the
+    // root of its clone tree. Otherwise, zero. Every page fault on a clone
+    // may need to walk this many parents, so large values are a red flag;
+    // the kernel flattens chains as intermediate clones are closed.
+    uint32_t clone_chain_depth;
+
     // The number of clones of this VMO, if any.
     size_t num_children;
 
@@ -335,6 +387,59 @@ typedef struct mx_info_kmem_stats {
     uint64_t other_bytes;
 } mx_info_kmem_stats_t;
 
+// One physical memory arena of the kernel's page allocator. Unlike
+// MX_INFO_KMEM_STATS, everything except |largest_free_run_bytes| is
+// maintained incrementally by the allocator, so this topic is cheap
+// enough to poll for fragmentation monitoring.
+typedef struct mx_info_kmem_arena {
+    char name[MX_MAX_NAME_LEN];
+
+    // NUMA node the arena's memory is attached to.
+    uint32_t numa_node;
+
+    // Physical address range covered by the arena.
+    uint64_t base;
+    uint64_t size_bytes;
+
+    // The portion of |size_bytes| that is unallocated.
+    uint64_t free_bytes;
+
+    // Number of maximal runs of contiguous free pages; free_bytes /
+    // free_runs is the average free run size, a fragmentation signal.
+    uint64_t free_runs;
+
+    // Longest run of contiguous free pages, in bytes: an upper bound on
+    // the largest contiguous (DMA) allocation the arena can satisfy.
+    // Found by sweeping the arena's page state, so it costs about as
+    // much as MX_INFO_KMEM_STATS to gather.
+    uint64_t largest_free_run_bytes;
+} mx_info_kmem_arena_t;
+
+// Topology of one NUMA node. On non-NUMA systems there is a single node
+// covering every cpu and all of physical memory.
+typedef struct mx_info_numa_node {
+    uint32_t node_id;
+
+    // Number of cpus attached to this node.
+    uint32_t num_cpus;
+
+    // Physical memory attached to this node, in bytes.
+    uint64_t mem_bytes;
+
+    // The portion of |mem_bytes| that is currently free.
+    uint64_t free_bytes;
+} mx_info_numa_node_t;
+
+// Where one logical cpu sits in the machine, for cache-aware thread
+// pinning. Cpus with equal package and core ids are smt siblings sharing
+// a physical core; cpus with equal package ids share a last level cache.
+typedef struct mx_info_cpu_topology {
+    uint32_t cpu_number;
+    uint32_t package_id;
+    uint32_t core_id;
+    uint32_t smt_id;
+} mx_info_cpu_topology_t;
+
 typedef struct mx_info_resource {
     // The resource kind, one of:
     // {MX_RSRC_KIND_ROOT, MX_RSRC_KIND_MMIO, MX_RSRC_KIND_IOPORT, MX_RSRC_KIND_IRQ}
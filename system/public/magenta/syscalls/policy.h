@@ -39,7 +39,14 @@ typedef struct mx_policy_basic {
 #define MX_POL_NEW_SOCKET                   9u
 #define MX_POL_NEW_FIFO                     10u
 #define MX_POL_NEW_GUEST                    11u
-#define MX_POL_MAX                          12u
+#define MX_POL_DEADLINE_SCHED               12u
+#define MX_POL_CPU_AFFINITY                 13u
+// Unlike the conditions above, MX_POL_TIMER_SLACK carries a value rather
+// than an action: the default timer slack, in nanoseconds, applied to
+// timers started by processes in the job with a slack of zero. A child
+// job may only grow the slack it inherited.
+#define MX_POL_TIMER_SLACK                  14u
+#define MX_POL_MAX                          15u
 
 // Policy actions.
 // MX_POL_ACTION_ALLOW and MX_POL_ACTION_DENY can be ORed with MX_POL_ACTION_EXCEPTION.
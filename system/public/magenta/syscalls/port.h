@@ -12,6 +12,9 @@ __BEGIN_CDECLS
 #define MX_WAIT_ASYNC_ONCE          0u
 #define MX_WAIT_ASYNC_REPEATING     1u
 
+// maximum number of packets mx_port_wait_multiple() can return at once.
+#define MX_PORT_MAX_WAIT_PACKETS    16u
+
 // packet types.
 #define MX_PKT_TYPE_USER            0x00u
 #define MX_PKT_TYPE_SIGNAL_ONE      0x01u
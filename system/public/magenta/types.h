@@ -105,6 +105,12 @@ typedef uint32_t mx_signals_t;
 #define MX_EVENT_SIGNALED           __MX_OBJECT_SIGNALED
 #define MX_EVENT_SIGNAL_MASK        (MX_USER_SIGNAL_ALL | __MX_OBJECT_SIGNALED)
 
+// Memory pressure event (see mx_system_get_memory_pressure_event).
+// MX_MEMORY_PRESSURE_LOW stays asserted while the pressure is low *or*
+// critical, so a waiter watching for "any pressure" only needs one signal.
+#define MX_MEMORY_PRESSURE_LOW      MX_USER_SIGNAL_0
+#define MX_MEMORY_PRESSURE_CRITICAL MX_USER_SIGNAL_1
+
 // EventPair
 #define MX_EPAIR_SIGNALED           __MX_OBJECT_SIGNALED
 #define MX_EPAIR_PEER_CLOSED        __MX_OBJECT_PEER_CLOSED
@@ -167,6 +173,27 @@ typedef struct {
     uint32_t rd_num_handles;
 } mx_channel_call_args_t;
 
+// One outbound message for mx_channel_write_multiple().
+typedef struct {
+    const void* bytes;
+    const mx_handle_t* handles;
+    uint32_t num_bytes;
+    uint32_t num_handles;
+} mx_channel_write_entry_t;
+
+// One range for mx_process_read_memory_vec()/mx_process_write_memory_vec().
+// |vaddr| is an address in the target process, |buffer| an address in the
+// calling process.
+typedef struct {
+    uintptr_t vaddr;
+    uintptr_t buffer;
+    size_t length;
+} mx_process_memory_entry_t;
+
+// Largest entry array accepted by a single vectored process memory
+// read or write.
+#define MX_PROCESS_MEMORY_VEC_MAX 32u
+
 // Structure for mx_object_wait_many():
 typedef struct {
     mx_handle_t handle;
@@ -203,6 +230,8 @@ typedef uint32_t mx_rights_t;
 #define MX_VMO_OP_CACHE_INVALIDATE       7u
 #define MX_VMO_OP_CACHE_CLEAN            8u
 #define MX_VMO_OP_CACHE_CLEAN_INVALIDATE 9u
+#define MX_VMO_OP_WILL_NEED              10u
+#define MX_VMO_OP_DONT_NEED              11u
 
 // VM Object clone flags
 #define MX_VMO_CLONE_COPY_ON_WRITE       1u
@@ -245,16 +274,54 @@ typedef int64_t mx_rel_off_t;
 // interrupt flags
 #define MX_FLAG_REMAP_IRQ  0x1
 
+// Segment of a vectored data transfer.
+typedef struct mx_iovec {
+    void* buffer;
+    size_t capacity;
+} mx_iovec_t;
+
+// Largest iovec array accepted by a single gather write.
+#define MX_IOVEC_MAX                        16u
+
+// Segment of a vectored VMO transfer.
+typedef struct mx_vmo_iovec {
+    void* buffer;      // user buffer to transfer to/from
+    size_t capacity;   // number of bytes to transfer
+    uint64_t offset;   // offset into the VMO
+} mx_vmo_iovec_t;
+
+// Largest segment array accepted by a single vectored VMO read/write.
+#define MX_VMO_IOVEC_MAX                    64u
+
 // Channel options and limits.
 #define MX_CHANNEL_READ_MAY_DISCARD         1u
+// The bytes argument points to an array of mx_iovec_t and the byte count
+// is the number of array entries; the message is gathered from the
+// segments directly into the kernel.
+#define MX_CHANNEL_WRITE_GATHER             2u
 
 #define MX_CHANNEL_MAX_MSG_BYTES            65536u
 #define MX_CHANNEL_MAX_MSG_HANDLES          64u
+#define MX_CHANNEL_MAX_WRITE_MULTIPLE       16u
 
 // Socket options and limits.
 #define MX_SOCKET_HALF_CLOSE                1u
+#define MX_SOCKET_READ_BATCH                2u
+// The buffer argument points to an array of mx_iovec_t and the size is
+// the number of array entries; a datagram socket sends the segments as
+// one packet.
+#define MX_SOCKET_WRITE_GATHER              4u
 #define MX_SOCKET_STREAM                    0u
 #define MX_SOCKET_DATAGRAM                  1u
+#define MX_SOCKET_SHARED                    2u
+
+// Per-direction data ring size of a MX_SOCKET_SHARED socket's ring VMO.
+#define MX_SOCKET_SHARED_RING_SIZE          (64u * 1024u)
+
+// Fifo options.
+// The fifo has exactly one writer and one reader per direction; reads
+// and writes take a wait-free fast path.
+#define MX_FIFO_SPSC                        1u
 
 // Flags which can be used to to control cache policy for APIs which map memory.
 typedef enum {
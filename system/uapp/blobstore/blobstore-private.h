@@ -154,15 +154,39 @@ private:
     mx_status_t Mmap(int flags, size_t len, size_t* off, mx_handle_t* out) final;
     mx_status_t Sync() final;
 
-    // Read both VMOs into memory, if we haven't already.
+    // Maps the blob VMO and reads the Merkle tree into memory, if we
+    // haven't already. Data blocks are not read here; they are loaded and
+    // verified on demand by LoadAndVerifyRange.
     //
-    // TODO(smklein): When we have can register the Blob Store as a pager
-    // service, and it can properly handle pages faults on a vnode's contents,
-    // then we can avoid reading the entire blob up-front. Until then, read
-    // the contents of a VMO into memory when it is opened.
+    // TODO(smklein): When we can register the Blob Store as a pager
+    // service, and it can properly handle page faults on a vnode's contents,
+    // demand loading can move to actual fault granularity. Until then, it
+    // happens at read granularity.
     mx_status_t InitVmos();
 
-    mx_status_t WriteShared(WriteTxn* txn, size_t start, size_t len, uint64_t start_block);
+    // Ensures the data blocks covering bytes [off, off + len) of the blob
+    // are resident in the VMO and have passed Merkle leaf verification.
+    // Each block is read from disk and hashed at most once.
+    mx_status_t LoadAndVerifyRange(uint64_t off, uint64_t len);
+
+    // Maps the scratch VMO for a compressed blob and reads its chunk
+    // table; called from InitVmos for blobs with kBlobLZ4Compressed set.
+    mx_status_t InitCompressed();
+
+    // Decompresses all chunks overlapping data blocks [first, last]
+    // (inclusive) into the blob VMO, reading only the compressed bytes
+    // of chunks which are not yet resident. Updates loaded_map_.
+    mx_status_t LoadCompressedRange(uint64_t first, uint64_t last);
+
+    // Writes the data section (and chunk table, if compressed) to disk
+    // once all blob data has arrived and the Merkle tree is built.
+    mx_status_t WriteData(WriteTxn* txn);
+
+    // Attempts to store the blob as LZ4 chunks, shrinking its block
+    // allocation. Returns MX_ERR_NO_SPACE if compression would not save
+    // at least one block; the caller falls back to the raw layout.
+    mx_status_t WriteCompressed(WriteTxn* txn);
+
     // Called by Blob once the last write has completed, updating the
     // on-disk metadata.
     mx_status_t WriteMetadata();
@@ -176,12 +200,26 @@ private:
     const mxtl::RefPtr<Blobstore> blobstore_;
     BlobFlags flags_;
 
+    bool Compressed() const;
+
     // The blob_ here consists of:
     // 1) The Merkle Tree
-    // 2) The Blob itself, aligned to the nearest kBlobstoreBlockSize
+    // 2) The Blob itself (always uncompressed), aligned to the nearest
+    //    kBlobstoreBlockSize
     mxtl::unique_ptr<MappedVmo> blob_{};
     vmoid_t vmoid_{};
 
+    // Scratch space for compressed blobs: the chunk table followed by
+    // (on write) the packed compressed chunks, or (on read) a staging
+    // area for the compressed bytes of a single chunk.
+    mxtl::unique_ptr<MappedVmo> lz4_{};
+    vmoid_t lz4_vmoid_{};
+
+    // One bit per data block: which blocks have been read from disk, and
+    // which have passed Merkle verification. Sized when blob_ is created.
+    RawBitmap loaded_map_{};
+    RawBitmap verified_map_{};
+
     mx::event readable_event_{};
     uint64_t bytes_written_{};
     uint8_t digest_[Digest::kLength]{};
@@ -13,6 +13,7 @@
 #include <digest/digest.h>
 #include <digest/merkle-tree.h>
 #include <fs/block-txn.h>
+#include <lz4/lz4.h>
 #include <magenta/process.h>
 #include <magenta/syscalls.h>
 #include <mxalloc/new.h>
@@ -50,6 +51,13 @@ mx_status_t vmo_write_exact(mx_handle_t h, const void* data, uint64_t offset, si
     return MX_OK;
 }
 
+// Staging area for the compressed bytes of a single chunk on the read
+// path. No stored chunk exceeds LZ4_compressBound of the chunk size, and
+// the extra block absorbs the chunk's byte offset within its first block.
+constexpr size_t kLZ4StagingSize =
+    ((LZ4_COMPRESSBOUND(kBlobstoreLZ4ChunkSize) + kBlobstoreBlockSize - 1) /
+     kBlobstoreBlockSize + 1) * kBlobstoreBlockSize;
+
 } // namespace
 
 namespace blobstore {
@@ -77,10 +85,171 @@ mx_status_t VnodeBlob::InitVmos() {
         BlobCloseHandles();
         return status;
     }
+    if (((status = loaded_map_.Reset(BlobDataBlocks(*inode))) != MX_OK) ||
+        ((status = verified_map_.Reset(BlobDataBlocks(*inode))) != MX_OK)) {
+        BlobCloseHandles();
+        return status;
+    }
+
+    // Only the Merkle tree is read up front; data blocks stream in on
+    // demand (see LoadAndVerifyRange), so first-byte latency is not gated
+    // on reading and hashing the whole blob.
+    if (MerkleTreeBlocks(*inode) > 0) {
+        ReadTxn txn(blobstore_.get());
+        txn.Enqueue(vmoid_, 0, inode->start_block, MerkleTreeBlocks(*inode));
+        if ((status = txn.Flush()) != MX_OK) {
+            return status;
+        }
+    }
+    if (Compressed()) {
+        return InitCompressed();
+    }
+    return MX_OK;
+}
+
+bool VnodeBlob::Compressed() const {
+    return (blobstore_->GetNode(map_index_)->flags & kBlobLZ4Compressed) != 0;
+}
+
+mx_status_t VnodeBlob::InitCompressed() {
+    auto inode = blobstore_->GetNode(map_index_);
+    uint64_t table_blocks = BlobLZ4TableBlocks(*inode);
+
+    mx_status_t status;
+    if ((status = MappedVmo::Create(table_blocks * kBlobstoreBlockSize + kLZ4StagingSize,
+                                    "blob-lz4", &lz4_)) != MX_OK) {
+        return status;
+    }
+    if ((status = blobstore_->AttachVmo(lz4_->GetVmo(), &lz4_vmoid_)) != MX_OK) {
+        lz4_ = nullptr;
+        return status;
+    }
 
     ReadTxn txn(blobstore_.get());
-    txn.Enqueue(vmoid_, 0, inode->start_block, BlobDataBlocks(*inode) + MerkleTreeBlocks(*inode));
-    return txn.Flush();
+    txn.Enqueue(lz4_vmoid_, 0, inode->start_block + MerkleTreeBlocks(*inode), table_blocks);
+    if ((status = txn.Flush()) != MX_OK) {
+        return status;
+    }
+
+    // Sanity check the chunk table before trusting its offsets.
+    const uint64_t* table = static_cast<const uint64_t*>(lz4_->GetData());
+    uint64_t nchunks = BlobLZ4Chunks(*inode);
+    uint64_t climit = (inode->num_blocks - MerkleTreeBlocks(*inode) - table_blocks) *
+                      kBlobstoreBlockSize;
+    for (uint64_t c = 0; c < nchunks; c++) {
+        if ((table[c] >= table[c + 1]) ||
+            (table[c + 1] - table[c] > LZ4_COMPRESSBOUND(kBlobstoreLZ4ChunkSize))) {
+            FS_TRACE_ERROR("blobstore: bad LZ4 chunk table\n");
+            return MX_ERR_IO_DATA_INTEGRITY;
+        }
+    }
+    if (table[nchunks] > climit) {
+        FS_TRACE_ERROR("blobstore: LZ4 chunk table overflows allocation\n");
+        return MX_ERR_IO_DATA_INTEGRITY;
+    }
+    return MX_OK;
+}
+
+mx_status_t VnodeBlob::LoadCompressedRange(uint64_t first, uint64_t last) {
+    auto inode = blobstore_->GetNode(map_index_);
+    uint64_t table_blocks = BlobLZ4TableBlocks(*inode);
+    uint64_t cdata_block = inode->start_block + MerkleTreeBlocks(*inode) + table_blocks;
+    const uint64_t* table = static_cast<const uint64_t*>(lz4_->GetData());
+    char* staging = static_cast<char*>(lz4_->GetData()) + table_blocks * kBlobstoreBlockSize;
+
+    for (uint64_t c = first / kBlobstoreLZ4ChunkBlocks;
+         c <= last / kBlobstoreLZ4ChunkBlocks; c++) {
+        uint64_t blk = c * kBlobstoreLZ4ChunkBlocks;
+        uint64_t blk_end = mxtl::min<uint64_t>(blk + kBlobstoreLZ4ChunkBlocks,
+                                               BlobDataBlocks(*inode));
+        if (loaded_map_.Get(blk, blk_end)) {
+            continue;
+        }
+
+        // Read the compressed bytes of this chunk; the first and last
+        // blocks may carry bytes of neighboring chunks.
+        uint64_t c_first = table[c] / kBlobstoreBlockSize;
+        uint64_t c_last = (table[c + 1] - 1) / kBlobstoreBlockSize; // Inclusive
+        ReadTxn txn(blobstore_.get());
+        txn.Enqueue(lz4_vmoid_, table_blocks, cdata_block + c_first, c_last - c_first + 1);
+        mx_status_t status = txn.Flush();
+        if (status != MX_OK) {
+            return status;
+        }
+
+        size_t src_len = table[c + 1] - table[c];
+        size_t dst_len = mxtl::min<uint64_t>(kBlobstoreLZ4ChunkSize,
+                                             inode->blob_size - c * kBlobstoreLZ4ChunkSize);
+        char* dst = static_cast<char*>(GetData()) + c * kBlobstoreLZ4ChunkSize;
+        int r = LZ4_decompress_safe(staging + (table[c] % kBlobstoreBlockSize), dst,
+                                    static_cast<int>(src_len), static_cast<int>(dst_len));
+        if (r != static_cast<int>(dst_len)) {
+            FS_TRACE_ERROR("blobstore: LZ4 chunk %lu failed to decompress\n", c);
+            return MX_ERR_IO_DATA_INTEGRITY;
+        }
+        loaded_map_.Set(blk, blk_end);
+    }
+    return MX_OK;
+}
+
+mx_status_t VnodeBlob::LoadAndVerifyRange(uint64_t off, uint64_t len) {
+    if (len == 0) {
+        return MX_OK;
+    }
+
+    auto inode = blobstore_->GetNode(map_index_);
+    uint64_t merkle_blocks = MerkleTreeBlocks(*inode);
+    uint64_t first = off / kBlobstoreBlockSize;
+    uint64_t last = (off + len - 1) / kBlobstoreBlockSize; // Inclusive
+    MX_DEBUG_ASSERT(last < BlobDataBlocks(*inode));
+
+    // Read any blocks in the range not yet resident. Compressed blobs
+    // decompress whole chunks; raw blobs batch contiguous runs of missing
+    // blocks into single transactions.
+    if (!loaded_map_.Get(first, last + 1)) {
+        if (Compressed()) {
+            mx_status_t status = LoadCompressedRange(first, last);
+            if (status != MX_OK) {
+                return status;
+            }
+        } else {
+            ReadTxn txn(blobstore_.get());
+            uint64_t n = first;
+            while (n <= last) {
+                n = loaded_map_.Scan(n, last + 1, true);
+                if (n > last) {
+                    break;
+                }
+                uint64_t run_end = loaded_map_.Scan(n, last + 1, false);
+                txn.Enqueue(vmoid_, merkle_blocks + n,
+                            inode->start_block + merkle_blocks + n, run_end - n);
+                n = run_end;
+            }
+            mx_status_t status = txn.Flush();
+            if (status != MX_OK) {
+                return status;
+            }
+            loaded_map_.Set(first, last + 1);
+        }
+    }
+
+    // Verify the Merkle leaves covering any not-yet-verified blocks. The
+    // verifier only hashes the nodes spanning the requested range.
+    if (!verified_map_.Get(first, last + 1)) {
+        Digest d;
+        d = ((const uint8_t*)&digest_[0]);
+        uint64_t voff = first * kBlobstoreBlockSize;
+        uint64_t vend = mxtl::min<uint64_t>((last + 1) * kBlobstoreBlockSize,
+                                            inode->blob_size);
+        mx_status_t status = MerkleTree::Verify(GetData(), inode->blob_size, GetMerkle(),
+                                                MerkleTree::GetTreeLength(inode->blob_size),
+                                                voff, vend - voff, d);
+        if (status != MX_OK) {
+            return status;
+        }
+        verified_map_.Set(first, last + 1);
+    }
+    return MX_OK;
 }
 
 uint64_t VnodeBlob::SizeData() const {
@@ -104,6 +273,7 @@ VnodeBlob::VnodeBlob(mxtl::RefPtr<Blobstore> bs)
 
 void VnodeBlob::BlobCloseHandles() {
     blob_ = nullptr;
+    lz4_ = nullptr;
     readable_event_.reset();
 }
 
@@ -121,11 +291,14 @@ mx_status_t VnodeBlob::SpaceAllocate(uint64_t size_data) {
         return status;
     }
 
-    // Initialize the inode with known fields
+    // Initialize the inode with known fields. The blob starts out raw;
+    // WriteCompressed may shrink num_blocks and set kBlobLZ4Compressed
+    // once all data has arrived.
     blobstore_inode_t* inode = blobstore_->GetNode(map_index_);
     memset(inode->merkle_root_hash, 0, Digest::kLength);
     inode->blob_size = size_data;
     inode->num_blocks = MerkleTreeBlocks(*inode) + BlobDataBlocks(*inode);
+    inode->flags = 0;
 
     // Open VMOs, so we can begin writing after allocate succeeds.
     if ((status = MappedVmo::Create(inode->num_blocks * kBlobstoreBlockSize, "blob", &blob_)) != MX_OK) {
@@ -134,6 +307,15 @@ mx_status_t VnodeBlob::SpaceAllocate(uint64_t size_data) {
     if ((status = blobstore_->AttachVmo(blob_->GetVmo(), &vmoid_)) != MX_OK) {
         goto fail;
     }
+    // Data written through this path is resident by construction and is
+    // verified against the digest before the blob becomes readable, so mark
+    // every block up front.
+    if (((status = loaded_map_.Reset(BlobDataBlocks(*inode))) != MX_OK) ||
+        ((status = verified_map_.Reset(BlobDataBlocks(*inode))) != MX_OK)) {
+        goto fail;
+    }
+    loaded_map_.Set(0, BlobDataBlocks(*inode));
+    verified_map_.Set(0, BlobDataBlocks(*inode));
 
     // Allocate space for the blob
     if ((status = blobstore_->AllocateBlocks(inode->num_blocks, &inode->start_block)) != MX_OK) {
@@ -149,13 +331,85 @@ fail:
     return status;
 }
 
-// A helper function for dumping either the Merkle Tree or the actual blob data
-// to both (1) The containing VMO, and (2) disk.
-mx_status_t VnodeBlob::WriteShared(WriteTxn* txn, size_t start, size_t len, uint64_t start_block) {
-    // Write as many 'entire blocks' as possible
-    uint64_t n = start / kBlobstoreBlockSize;
-    uint64_t n_end = (start + len + kBlobstoreBlockSize - 1) / kBlobstoreBlockSize;
-    txn->Enqueue(vmoid_, n, n + start_block, n_end - n);
+// Writes the blob to disk in one transaction once it is fully resident:
+// either [merkle][data] raw, or [merkle][chunk table][compressed chunks].
+mx_status_t VnodeBlob::WriteData(WriteTxn* txn) {
+    auto inode = blobstore_->GetNode(map_index_);
+
+    // Compression can only pay off if there is more than one data block
+    // to save (the chunk table costs at least one).
+    if (BlobDataBlocks(*inode) >= 2) {
+        mx_status_t status = WriteCompressed(txn);
+        if (status != MX_ERR_NO_SPACE) {
+            return status;
+        }
+        // Did not shrink; fall through to the raw layout.
+    }
+
+    txn->Enqueue(vmoid_, 0, inode->start_block, inode->num_blocks);
+    return txn->Flush();
+}
+
+mx_status_t VnodeBlob::WriteCompressed(WriteTxn* txn) {
+    auto inode = blobstore_->GetNode(map_index_);
+    uint64_t merkle_blocks = MerkleTreeBlocks(*inode);
+    uint64_t data_blocks = BlobDataBlocks(*inode);
+    uint64_t nchunks = BlobLZ4Chunks(*inode);
+    uint64_t table_blocks = BlobLZ4TableBlocks(*inode);
+
+    mx_status_t status;
+    if ((status = MappedVmo::Create((table_blocks + data_blocks) * kBlobstoreBlockSize,
+                                    "blob-lz4", &lz4_)) != MX_OK) {
+        return status;
+    }
+    if ((status = blobstore_->AttachVmo(lz4_->GetVmo(), &lz4_vmoid_)) != MX_OK) {
+        lz4_ = nullptr;
+        return status;
+    }
+
+    uint64_t* table = static_cast<uint64_t*>(lz4_->GetData());
+    char* cdata = static_cast<char*>(lz4_->GetData()) + table_blocks * kBlobstoreBlockSize;
+    const char* data = static_cast<const char*>(GetData());
+    uint64_t avail = data_blocks * kBlobstoreBlockSize;
+    uint64_t off = 0;
+
+    for (uint64_t c = 0; c < nchunks; c++) {
+        size_t src_len = mxtl::min<uint64_t>(kBlobstoreLZ4ChunkSize,
+                                             inode->blob_size - c * kBlobstoreLZ4ChunkSize);
+        int bound = LZ4_compressBound(static_cast<int>(src_len));
+        if (off + bound > avail) {
+            lz4_ = nullptr;
+            return MX_ERR_NO_SPACE;
+        }
+        int clen = LZ4_compress_default(data + c * kBlobstoreLZ4ChunkSize, cdata + off,
+                                        static_cast<int>(src_len), bound);
+        if (clen <= 0) {
+            lz4_ = nullptr;
+            return MX_ERR_NO_SPACE;
+        }
+        table[c] = off;
+        off += clen;
+    }
+    table[nchunks] = off;
+
+    uint64_t compressed_blocks = mxtl::roundup(off, kBlobstoreBlockSize) / kBlobstoreBlockSize;
+    uint64_t num_blocks = merkle_blocks + table_blocks + compressed_blocks;
+    if (num_blocks >= inode->num_blocks) {
+        lz4_ = nullptr;
+        return MX_ERR_NO_SPACE;
+    }
+
+    // The tail blocks were only ever allocated in memory; release them
+    // before WriteMetadata flushes the bitmap.
+    blobstore_->FreeBlocks(inode->num_blocks - num_blocks, inode->start_block + num_blocks);
+    inode->num_blocks = num_blocks;
+    inode->flags |= kBlobLZ4Compressed;
+
+    if (merkle_blocks > 0) {
+        txn->Enqueue(vmoid_, 0, inode->start_block, merkle_blocks);
+    }
+    txn->Enqueue(lz4_vmoid_, 0, inode->start_block + merkle_blocks,
+                 table_blocks + compressed_blocks);
     return txn->Flush();
 }
 
@@ -231,16 +485,11 @@ mx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
             return status;
         }
 
-        status = WriteShared(&txn, offset, len, inode->start_block);
-        if (status != MX_OK) {
-            SetState(kBlobStateError);
-            return status;
-        }
-
         *actual = to_write;
         bytes_written_ += to_write;
 
-        // More data to write.
+        // More data to write. Nothing reaches disk until the whole blob
+        // has arrived, so the compressor gets to see it in full.
         if (bytes_written_ < inode->blob_size) {
             return MX_OK;
         }
@@ -253,24 +502,24 @@ mx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
             Digest digest;
             void* merkle_data = GetMerkle();
             const void* blob_data = GetData();
-            if (MerkleTree::Create(blob_data, inode->blob_size, merkle_data,
-                                   merkle_size, &digest) != MX_OK) {
+            if ((status = MerkleTree::CreateParallel(blob_data, inode->blob_size,
+                                                     merkle_data, merkle_size, &digest,
+                                                     mx_system_get_num_cpus())) != MX_OK) {
                 SetState(kBlobStateError);
                 return status;
             } else if (digest != digest_) {
                 // Downloaded blob did not match provided digest
                 SetState(kBlobStateError);
-                return status;
+                return MX_ERR_IO_DATA_INTEGRITY;
             }
+        }
 
-            status = WriteShared(&txn, 0, merkle_size, inode->start_block);
-            if (status != MX_OK) {
-                SetState(kBlobStateError);
-                return status;
-            }
+        // No more data to write. Compress (if profitable) and flush to disk.
+        if ((status = WriteData(&txn)) != MX_OK) {
+            SetState(kBlobStateError);
+            return status;
         }
 
-        // No more data to write. Flush to disk.
         if ((status = WriteMetadata()) != MX_OK) {
             SetState(kBlobStateError);
             return status;
@@ -308,18 +557,11 @@ mx_status_t VnodeBlob::CopyVmo(mx_rights_t rights, mx_handle_t* out) {
         return status;
     }
 
-    // TODO(smklein): We could lazily verify more of the VMO if
-    // we could fault in pages on-demand.
-    //
-    // For now, we aggressively verify the entire VMO up front.
-    Digest d;
-    d = ((const uint8_t*)&digest_[0]);
+    // The entire blob escapes our read path through the returned VMO, so
+    // everything must be resident and verified before handing it out.
+    // Already-verified chunks are not hashed again.
     auto inode = blobstore_->GetNode(map_index_);
-    uint64_t size_merkle = MerkleTree::GetTreeLength(inode->blob_size);
-    const void* merkle_data = GetMerkle();
-    const void* blob_data = GetData();
-    status = MerkleTree::Verify(blob_data, inode->blob_size, merkle_data,
-                                size_merkle, 0, inode->blob_size, d);
+    status = LoadAndVerifyRange(0, inode->blob_size);
     if (status != MX_OK) {
         return status;
     }
@@ -350,8 +592,6 @@ mx_status_t VnodeBlob::ReadInternal(void* data, size_t len, size_t off, size_t*
         return status;
     }
 
-    Digest d;
-    d = ((const uint8_t*)&digest_[0]);
     auto inode = blobstore_->GetNode(map_index_);
     if (off >= inode->blob_size) {
         *actual = 0;
@@ -361,11 +601,7 @@ mx_status_t VnodeBlob::ReadInternal(void* data, size_t len, size_t off, size_t*
         len = inode->blob_size - off;
     }
 
-    uint64_t size_merkle = MerkleTree::GetTreeLength(inode->blob_size);
-    const void* merkle_data = GetMerkle();
-    const void* blob_data = GetData();
-    status = MerkleTree::Verify(blob_data, inode->blob_size, merkle_data,
-                                size_merkle, off, len, d);
+    status = LoadAndVerifyRange(off, len);
     if (status != MX_OK) {
         return status;
     }
@@ -33,7 +33,7 @@ using RawBitmap = bitmap::RawBitmapGeneric<bitmap::DefaultStorage>;
 
 constexpr uint64_t kBlobstoreMagic0  = (0xac2153479e694d21ULL);
 constexpr uint64_t kBlobstoreMagic1  = (0x985000d4d4d3d314ULL);
-constexpr uint32_t kBlobstoreVersion = 0x00000002;
+constexpr uint32_t kBlobstoreVersion = 0x00000003;
 
 constexpr uint32_t kBlobstoreFlagClean      = 1;
 constexpr uint32_t kBlobstoreFlagDirty      = 2;
@@ -87,13 +87,16 @@ constexpr uint64_t kStartBlockFree     = 0;
 constexpr uint64_t kStartBlockReserved = 1;
 constexpr uint64_t kStartBlockMinimum  = 2; // Smallest 'data' block possible
 
+// Inode flags
+constexpr uint64_t kBlobLZ4Compressed = 1; // Data is stored as LZ4 chunks
+
 using digest::Digest;
 typedef struct {
     uint8_t  merkle_root_hash[Digest::kLength];
     uint64_t start_block;
-    uint64_t num_blocks;
-    uint64_t blob_size;
-    uint64_t reserved;
+    uint64_t num_blocks; // Blocks occupied on disk (compressed size for LZ4 blobs)
+    uint64_t blob_size;  // Size of the (uncompressed) blob data
+    uint64_t flags;
 } blobstore_inode_t;
 
 static_assert(sizeof(blobstore_inode_t) == kBlobstoreInodeSize,
@@ -106,5 +109,24 @@ constexpr uint64_t BlobDataBlocks(const blobstore_inode_t& blobNode) {
     return mxtl::roundup(blobNode.blob_size, kBlobstoreBlockSize) / kBlobstoreBlockSize;
 }
 
+// Compressed blobs are divided into independently compressed chunks of
+// kBlobstoreLZ4ChunkSize bytes of blob data, so reads only decompress the
+// touched ranges. On disk a compressed blob is laid out as:
+//   [ merkle tree ][ chunk table ][ compressed chunks, byte-packed ]
+// The chunk table holds BlobLZ4Chunks() + 1 uint64 byte offsets into the
+// compressed region; entries [i, i+1) delimit chunk i and the final entry
+// is the total number of compressed bytes.
+constexpr uint32_t kBlobstoreLZ4ChunkBlocks = 8;
+constexpr uint32_t kBlobstoreLZ4ChunkSize   = kBlobstoreLZ4ChunkBlocks * kBlobstoreBlockSize;
+
+constexpr uint64_t BlobLZ4Chunks(const blobstore_inode_t& blobNode) {
+    return mxtl::roundup(blobNode.blob_size, kBlobstoreLZ4ChunkSize) / kBlobstoreLZ4ChunkSize;
+}
+
+constexpr uint64_t BlobLZ4TableBlocks(const blobstore_inode_t& blobNode) {
+    return mxtl::roundup((BlobLZ4Chunks(blobNode) + 1) * sizeof(uint64_t),
+                         kBlobstoreBlockSize) / kBlobstoreBlockSize;
+}
+
 void* GetBlock(const RawBitmap& bitmap, uint32_t blkno);
 void* GetBitBlock(const RawBitmap& bitmap, uint32_t* blkno_out, uint32_t bitno);
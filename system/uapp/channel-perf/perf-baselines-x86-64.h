@@ -0,0 +1,15 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <unittest/perftest.h>
+
+// Expected median delivery latency (ns) for the default contention
+// configuration on the x86-64 perf builder (NUC). Histogram buckets are
+// powers of two, so medians are upper bounds. Initial seed; re-record
+// with PERF_GATE off on the builder after any intentional change.
+static const perf_baseline_t kPerfBaselines[] = {
+    {"contention_latency", 131072, 100},
+};
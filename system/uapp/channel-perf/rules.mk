@@ -11,7 +11,7 @@ MODULE_TYPE := userapp
 MODULE_SRCS += \
     $(LOCAL_DIR)/main.cpp \
 
-MODULE_LIBS := system/ulib/magenta system/ulib/mxio system/ulib/c
+MODULE_LIBS := system/ulib/magenta system/ulib/mxio system/ulib/unittest system/ulib/c
 MODULE_STATIC_LIBS := system/ulib/mxcpp system/ulib/mxtl
 
 include make/module.mk
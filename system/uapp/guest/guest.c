@@ -9,9 +9,11 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <block-client/client.h>
 #include <hypervisor/acpi.h>
 #include <hypervisor/guest.h>
 #include <hypervisor/vcpu.h>
+#include <magenta/device/block.h>
 #include <magenta/process.h>
 #include <magenta/syscalls.h>
 #include <magenta/syscalls/hypervisor.h>
@@ -74,6 +76,19 @@ int main(int argc, char** argv) {
         return status;
     }
 
+    // Map all of guest RAM up front, so the guest doesn't take an EPT
+    // violation on every first touch of a page while it boots.
+    struct {
+        mx_vaddr_t addr;
+        size_t len;
+    } guest_commit_args = { 0, kVmoSize };
+    status = mx_hypervisor_op(guest, MX_HYPERVISOR_OP_GUEST_COMMIT,
+                              &guest_commit_args, sizeof(guest_commit_args), NULL, 0);
+    if (status != MX_OK) {
+        fprintf(stderr, "Failed to commit guest physical memory\n");
+        return status;
+    }
+
     guest_state_t guest_state;
     memset(&guest_state, 0, sizeof(guest_state));
     guest_state.guest = guest;
@@ -89,7 +104,9 @@ int main(int argc, char** argv) {
     guest_state.block_fd = -1;
     guest_state.block_size = 1u << 30;
     if (block_path != NULL) {
-        guest_state.block_fd = open(block_path, O_RDONLY);
+        guest_state.block_fd = open(block_path, O_RDWR);
+        if (guest_state.block_fd < 0)
+            guest_state.block_fd = open(block_path, O_RDONLY);
         if (guest_state.block_fd < 0) {
             fprintf(stderr, "Failed to open block file \"%s\"\n", block_path);
             return MX_ERR_IO;
@@ -100,6 +117,37 @@ int main(int argc, char** argv) {
             return MX_ERR_IO;
         }
         guest_state.block_size = ret;
+        // If the backing store speaks the block fifo protocol, attach
+        // guest memory to it as a VMO; virtio requests are then queued
+        // by guest-physical offset and the device moves data in and out
+        // of guest memory directly. Files fall back to read/write.
+        mx_handle_t fifo;
+        if (ioctl_block_get_fifos(guest_state.block_fd, &fifo) == sizeof(fifo)) {
+            mx_handle_t vmo_dup;
+            status = mx_handle_duplicate(physmem_vmo, MX_RIGHT_SAME_RIGHTS, &vmo_dup);
+            if (status != MX_OK) {
+                fprintf(stderr, "Failed to duplicate guest physical memory\n");
+                return status;
+            }
+            vmoid_t vmoid;
+            if (ioctl_block_attach_vmo(guest_state.block_fd, &vmo_dup, &vmoid) !=
+                sizeof(vmoid)) {
+                fprintf(stderr, "Failed to attach guest physical memory to block device\n");
+                return MX_ERR_IO;
+            }
+            txnid_t txnid;
+            if (ioctl_block_alloc_txn(guest_state.block_fd, &txnid) != sizeof(txnid)) {
+                fprintf(stderr, "Failed to allocate block transaction\n");
+                return MX_ERR_IO;
+            }
+            status = block_fifo_create_client(fifo, &guest_state.block_fifo);
+            if (status != MX_OK) {
+                fprintf(stderr, "Failed to create block fifo client\n");
+                return status;
+            }
+            guest_state.block_vmoid = vmoid;
+            guest_state.block_txnid = txnid;
+        }
     }
     // Setup each PCI device's BAR 0 register.
     for (unsigned i = 0; i < PCI_MAX_DEVICES; i++) {
@@ -13,6 +13,10 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/linux.c \
     $(LOCAL_DIR)/magenta.c \
 
+MODULE_STATIC_LIBS := \
+    system/ulib/block-client \
+    system/ulib/sync \
+
 MODULE_LIBS := \
     system/ulib/c \
     system/ulib/hypervisor \
@@ -4,9 +4,11 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <fs-management/ramdisk.h>
@@ -232,12 +234,258 @@ int iotime_fread(int argc, char** argv) {
     return 0;
 }
 
+// fifo benchmark: worker threads keep the device's queue filled to the
+// requested depth, each timing its own requests, so both throughput and
+// the latency distribution under load are visible
+
+typedef struct {
+    fifo_client_t* client;
+    txnid_t txnid;
+    vmoid_t vmoid;
+    uint64_t vmo_offset; // each worker owns a slice of the shared vmo
+    size_t xfer;
+    size_t ops;
+    uint64_t nblocks;  // device range measured, in xfer-size units
+    unsigned read_pct; // 0..100
+    bool random;
+    uint32_t seed;
+    uint64_t* lat; // ns per op, filled in by the worker
+    int error;
+} bench_worker_t;
+
+static atomic_uint_fast64_t bench_seq_next;
+
+static uint32_t rand32(uint32_t* seed) {
+    // xorshift; cheap enough to not show up in the measurement
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+static int bench_worker(void* arg) {
+    bench_worker_t* w = arg;
+
+    for (size_t n = 0; n < w->ops; n++) {
+        uint64_t blk;
+        if (w->random) {
+            blk = rand32(&w->seed) % w->nblocks;
+        } else {
+            blk = atomic_fetch_add(&bench_seq_next, 1) % w->nblocks;
+        }
+        bool is_read = (rand32(&w->seed) % 100) < w->read_pct;
+        block_fifo_request_t request = {
+            .txnid = w->txnid,
+            .vmoid = w->vmoid,
+            .opcode = is_read ? BLOCKIO_READ : BLOCKIO_WRITE,
+            .length = w->xfer,
+            .vmo_offset = w->vmo_offset,
+            .dev_offset = blk * w->xfer,
+        };
+        mx_time_t t0 = mx_time_get(MX_CLOCK_MONOTONIC);
+        if (block_fifo_txn(w->client, &request, 1) != MX_OK) {
+            w->error = 1;
+            return -1;
+        }
+        w->lat[n] = mx_time_get(MX_CLOCK_MONOTONIC) - t0;
+    }
+    return 0;
+}
+
+static int cmp_u64(const void* _a, const void* _b) {
+    uint64_t a = *(const uint64_t*)_a;
+    uint64_t b = *(const uint64_t*)_b;
+    return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+static uint64_t percentile(uint64_t* sorted, size_t count, unsigned num, unsigned den) {
+    size_t i = (count * num) / den;
+    return sorted[(i < count) ? i : (count - 1)];
+}
+
+static int bench_run(fifo_client_t* client, int fd, vmoid_t vmoid,
+                     size_t total, size_t xfer, unsigned qd,
+                     unsigned read_pct, bool random) {
+    size_t ops = total / xfer;
+    if (ops < qd) {
+        ops = qd;
+    }
+
+    uint64_t* lat = malloc(ops * sizeof(uint64_t));
+    bench_worker_t* workers = calloc(qd, sizeof(bench_worker_t));
+    thrd_t* threads = malloc(qd * sizeof(thrd_t));
+    if ((lat == NULL) || (workers == NULL) || (threads == NULL)) {
+        fprintf(stderr, "error: out of memory\n");
+        return -1;
+    }
+
+    atomic_store(&bench_seq_next, 0);
+
+    size_t next = 0;
+    for (unsigned i = 0; i < qd; i++) {
+        bench_worker_t* w = &workers[i];
+        w->client = client;
+        w->vmoid = vmoid;
+        w->vmo_offset = (uint64_t)i * xfer;
+        w->xfer = xfer;
+        // spread any remainder over the first workers
+        w->ops = ops / qd + ((i < (ops % qd)) ? 1 : 0);
+        w->nblocks = total / xfer;
+        w->read_pct = read_pct;
+        w->random = random;
+        w->seed = 0x12345678 + i * 0x9E3779B9;
+        w->lat = lat + next;
+        next += w->ops;
+        if (ioctl_block_alloc_txn(fd, &w->txnid) != sizeof(txnid_t)) {
+            fprintf(stderr, "error: cannot allocate txn\n");
+            return -1;
+        }
+    }
+
+    mx_time_t t0 = mx_time_get(MX_CLOCK_MONOTONIC);
+    for (unsigned i = 0; i < qd; i++) {
+        if (thrd_create(&threads[i], bench_worker, &workers[i]) != thrd_success) {
+            fprintf(stderr, "error: cannot create worker thread\n");
+            return -1;
+        }
+    }
+    int failed = 0;
+    for (unsigned i = 0; i < qd; i++) {
+        int res;
+        thrd_join(threads[i], &res);
+        failed |= workers[i].error;
+    }
+    mx_time_t t1 = mx_time_get(MX_CLOCK_MONOTONIC);
+
+    for (unsigned i = 0; i < qd; i++) {
+        ioctl_block_free_txn(fd, &workers[i].txnid);
+    }
+
+    if (failed) {
+        fprintf(stderr, "error: block_fifo_txn error\n");
+        return -1;
+    }
+
+    qsort(lat, ops, sizeof(uint64_t), cmp_u64);
+
+    uint64_t ns = t1 - t0;
+    double s = ((double)ns) / 1000000000.0;
+    printf("bench,qd=%u,mode=%s,read=%u,xfer=%zu,ops=%zu,ns=%zu,"
+           "iops=%g,mbps=%g,p50ns=%zu,p99ns=%zu,p999ns=%zu\n",
+           qd, random ? "rand" : "seq", read_pct, xfer, ops, ns,
+           ((double)ops) / s,
+           ((double)(ops * xfer)) / s / (1024 * 1024),
+           percentile(lat, ops, 50, 100),
+           percentile(lat, ops, 99, 100),
+           percentile(lat, ops, 999, 1000));
+
+    free(lat);
+    free(workers);
+    free(threads);
+    return 0;
+}
+
+#define BENCH_MAX_QD 128
+
+int iotime_bench(int argc, char** argv) {
+    if (argc != 8) {
+        return usage();
+    }
+    size_t total = number(argv[3]);
+    size_t xfer = number(argv[4]);
+    unsigned read_pct = number(argv[6]);
+    bool random;
+    if (!strcmp(argv[7], "rand")) {
+        random = true;
+    } else if (!strcmp(argv[7], "seq")) {
+        random = false;
+    } else {
+        return usage();
+    }
+
+    if ((total == 0) || (xfer == 0) || (total % xfer) || (read_pct > 100)) {
+        fprintf(stderr, "error: total must be a multiple of xfer, read%% 0..100\n");
+        return -1;
+    }
+
+    unsigned qd_lo, qd_hi;
+    if (!strcmp(argv[5], "sweep")) {
+        qd_lo = 1;
+        qd_hi = BENCH_MAX_QD;
+    } else {
+        qd_lo = qd_hi = number(argv[5]);
+        if ((qd_lo < 1) || (qd_hi > BENCH_MAX_QD)) {
+            fprintf(stderr, "error: queue depth must be 1..%u\n", BENCH_MAX_QD);
+            return -1;
+        }
+    }
+
+    int fd;
+    if (!strcmp(argv[2], "--ramdisk")) {
+        if ((fd = make_ramdisk(total)) < 0) {
+            fprintf(stderr, "error: cannot create %zu-byte ramdisk\n", total);
+            return -1;
+        }
+    } else {
+        if ((fd = open(argv[2], O_RDWR)) < 0) {
+            fprintf(stderr, "error: cannot open '%s'\n", argv[2]);
+            return -1;
+        }
+    }
+
+    mx_handle_t vmo;
+    if (mx_vmo_create(xfer * BENCH_MAX_QD, 0, &vmo) != MX_OK) {
+        fprintf(stderr, "error: out of memory\n");
+        return -1;
+    }
+
+    mx_handle_t fifo;
+    if (ioctl_block_get_fifos(fd, &fifo) != sizeof(fifo)) {
+        fprintf(stderr, "err: cannot get fifo for '%s'\n", argv[2]);
+        return -1;
+    }
+
+    mx_handle_t dup;
+    if (mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &dup) != MX_OK) {
+        fprintf(stderr, "error: cannot duplicate handle\n");
+        return -1;
+    }
+
+    vmoid_t vmoid;
+    if (ioctl_block_attach_vmo(fd, &dup, &vmoid) != sizeof(vmoid)) {
+        fprintf(stderr, "error: cannot attach vmo for '%s'\n", argv[2]);
+        return -1;
+    }
+
+    fifo_client_t* client;
+    if (block_fifo_create_client(fifo, &client) != MX_OK) {
+        fprintf(stderr, "err: cannot create block client for '%s'\n", argv[2]);
+        return -1;
+    }
+
+    for (unsigned qd = qd_lo; qd <= qd_hi; qd *= 2) {
+        if (bench_run(client, fd, vmoid, total, xfer, qd, read_pct, random)) {
+            return -1;
+        }
+    }
+
+    block_fifo_release_client(client);
+    close(fd);
+    return 0;
+}
+
 int usage(void) {
     fprintf(stderr,
             "usage: iotime <op>...\n\n"
             "   op: lread <device> <bytes> <bufsize>   posix linear read\n"
             "       bread <device> <bytes> <bufsize>   block linear read\n"
-            "       fread <device> <bytes> <bufsize>   fifo linear read\n");
+            "       fread <device> <bytes> <bufsize>   fifo linear read\n"
+            "       bench <device> <bytes> <xfer> <qd|sweep> <read%%> <rand|seq>\n"
+            "                                          fifo benchmark; sweep\n"
+            "                                          doubles qd from 1 to 128,\n"
+            "                                          one csv line per run\n");
     return -1;
 }
 
@@ -252,6 +500,8 @@ int main(int argc, char** argv) {
         return iotime_bread(argc, argv);
     } else if (!strcmp(argv[1], "fread")) {
         return iotime_fread(argc, argv);
+    } else if (!strcmp(argv[1], "bench")) {
+        return iotime_bench(argc, argv);
     } else {
         return usage();
     }
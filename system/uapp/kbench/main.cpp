@@ -0,0 +1,416 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// kbench: kernel microbenchmark suite.
+//
+// Measures the primitives the kernel is on the hot path for - syscall
+// entry, channel echo, port wakeup fanout, futex handoff, vmo
+// commit/decommit and page fault rates - and reports latency percentiles
+// per benchmark, so regressions show up as a shifted p99 rather than only
+// as a shifted mean. Run with -m for machine-readable CSV output suitable
+// for diffing between builds.
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <magenta/compiler.h>
+#include <magenta/process.h>
+#include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
+#include <mxtl/algorithm.h>
+#include <mxtl/unique_ptr.h>
+#include <unittest/perftest.h>
+
+#include PERF_BASELINE_FILE
+
+namespace {
+
+bool machine_readable = false;
+bool gate_failed = false;
+
+void fatal(const char* what, mx_status_t status) {
+    fprintf(stderr, "kbench: %s failed: %d\n", what, status);
+    exit(EXIT_FAILURE);
+}
+
+#define CHECK(expr)                     \
+    do {                                \
+        mx_status_t _st = (expr);       \
+        if (_st != MX_OK)               \
+            fatal(#expr, _st);          \
+    } while (0)
+
+// spin the cpu a bit to make sure the frequency is cranked to the top
+void spin(mx_time_t nanosecs) {
+    mx_time_t t = mx_time_get(MX_CLOCK_MONOTONIC);
+
+    while (mx_time_get(MX_CLOCK_MONOTONIC) - t < nanosecs)
+        ;
+}
+
+// Sorts |samples| in place and prints min/p50/p90/p99/max/avg, each in
+// nanoseconds per operation, then checks the median against the
+// checked-in baseline (enforced only when PERF_GATE is set).
+void report(const char* name, uint64_t* samples, size_t count) {
+    perf_results_t r;
+    unittest_perf_results(samples, count, &r);
+
+    if (machine_readable) {
+        printf("%s,%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+               ",%" PRIu64 ",%" PRIu64 "\n",
+               name, r.samples, r.min, r.p50, r.p90, r.p99, r.max, r.avg);
+    } else {
+        printf("%-24s %8zu samples: min %6" PRIu64 "  p50 %6" PRIu64
+               "  p90 %6" PRIu64 "  p99 %6" PRIu64 "  max %8" PRIu64
+               "  avg %6" PRIu64 "  (ns/op)\n",
+               name, r.samples, r.min, r.p50, r.p90, r.p99, r.max, r.avg);
+    }
+    if (!unittest_perf_check(name, &r, kPerfBaselines, countof(kPerfBaselines)))
+        gate_failed = true;
+}
+
+// Samples |rounds| batches of |batch| calls of |func| and records the per
+// call cost of each batch. Batching keeps the clock-read overhead out of
+// operations that are cheaper than a timestamp.
+template <typename T>
+void sample_batched(const char* name, size_t rounds, uint64_t batch, T func) {
+    mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[rounds]);
+
+    spin(MX_MSEC(10));
+
+    for (size_t i = 0; i < rounds; i++) {
+        mx_time_t t = mx_time_get(MX_CLOCK_MONOTONIC);
+        for (uint64_t j = 0; j < batch; j++)
+            func();
+        samples[i] = (mx_time_get(MX_CLOCK_MONOTONIC) - t) / batch;
+    }
+
+    report(name, samples.get(), rounds);
+}
+
+// -- syscall round trip -----------------------------------------------------
+
+void bench_syscall() {
+    sample_batched("syscall_null", 1000, 100, []() {
+        mx_syscall_test_0();
+    });
+}
+
+// -- channel echo -----------------------------------------------------------
+
+constexpr uint32_t kEchoMsgSize = 64u;
+
+int echo_thread(void* arg) {
+    mx_handle_t channel = static_cast<mx_handle_t>(reinterpret_cast<uintptr_t>(arg));
+    uint8_t msg[kEchoMsgSize];
+
+    for (;;) {
+        uint32_t actual_bytes, actual_handles;
+        mx_status_t status = mx_object_wait_one(
+            channel, MX_CHANNEL_READABLE | MX_CHANNEL_PEER_CLOSED,
+            MX_TIME_INFINITE, NULL);
+        if (status != MX_OK)
+            break;
+        status = mx_channel_read(channel, 0u, msg, NULL, sizeof(msg), 0u,
+                                 &actual_bytes, &actual_handles);
+        if (status != MX_OK)
+            break;
+        if (mx_channel_write(channel, 0u, msg, actual_bytes, NULL, 0u) != MX_OK)
+            break;
+    }
+    return 0;
+}
+
+void bench_channel_echo() {
+    constexpr size_t kRounds = 10000;
+
+    mx_handle_t local, remote;
+    CHECK(mx_channel_create(0u, &local, &remote));
+
+    thrd_t echo;
+    if (thrd_create(&echo, echo_thread,
+                    reinterpret_cast<void*>(static_cast<uintptr_t>(remote))) != thrd_success)
+        fatal("thrd_create", MX_ERR_INTERNAL);
+
+    uint8_t msg[kEchoMsgSize] = {0};
+    mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[kRounds]);
+
+    spin(MX_MSEC(10));
+
+    for (size_t i = 0; i < kRounds; i++) {
+        mx_time_t t = mx_time_get(MX_CLOCK_MONOTONIC);
+
+        CHECK(mx_channel_write(local, 0u, msg, sizeof(msg), NULL, 0u));
+        CHECK(mx_object_wait_one(local, MX_CHANNEL_READABLE, MX_TIME_INFINITE, NULL));
+        uint32_t actual_bytes, actual_handles;
+        CHECK(mx_channel_read(local, 0u, msg, NULL, sizeof(msg), 0u,
+                              &actual_bytes, &actual_handles));
+
+        samples[i] = mx_time_get(MX_CLOCK_MONOTONIC) - t;
+    }
+
+    report("channel_echo_64b", samples.get(), kRounds);
+
+    // closing our end unblocks the echo thread
+    mx_handle_close(local);
+    thrd_join(echo, NULL);
+}
+
+// -- port wakeup fanout -----------------------------------------------------
+
+constexpr uint32_t kFanoutWaiters = 8u;
+
+struct FanoutArgs {
+    mx_handle_t port;     // waiters block here
+    mx_handle_t ack_port; // and acknowledge here
+};
+
+int fanout_thread(void* arg) {
+    auto* args = static_cast<FanoutArgs*>(arg);
+
+    for (;;) {
+        mx_port_packet_t packet;
+        if (mx_port_wait(args->port, MX_TIME_INFINITE, &packet, sizeof(packet)) != MX_OK)
+            return 0;
+        if (packet.key == UINT64_MAX)
+            return 0;
+        if (mx_port_queue(args->ack_port, &packet, sizeof(packet)) != MX_OK)
+            return 0;
+    }
+}
+
+void bench_port_fanout() {
+    constexpr size_t kRounds = 2000;
+
+    FanoutArgs args;
+    CHECK(mx_port_create(0u, &args.port));
+    CHECK(mx_port_create(0u, &args.ack_port));
+
+    thrd_t waiters[kFanoutWaiters];
+    for (auto& waiter : waiters) {
+        if (thrd_create(&waiter, fanout_thread, &args) != thrd_success)
+            fatal("thrd_create", MX_ERR_INTERNAL);
+    }
+
+    mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[kRounds]);
+
+    spin(MX_MSEC(10));
+
+    // each round: queue one packet per waiter, then collect every ack. The
+    // sample is the time from the first queue to the last ack.
+    for (size_t i = 0; i < kRounds; i++) {
+        mx_port_packet_t packet = {};
+        packet.type = MX_PKT_TYPE_USER;
+
+        mx_time_t t = mx_time_get(MX_CLOCK_MONOTONIC);
+
+        for (uint32_t w = 0; w < kFanoutWaiters; w++)
+            CHECK(mx_port_queue(args.port, &packet, sizeof(packet)));
+        for (uint32_t w = 0; w < kFanoutWaiters; w++)
+            CHECK(mx_port_wait(args.ack_port, MX_TIME_INFINITE, &packet, sizeof(packet)));
+
+        samples[i] = mx_time_get(MX_CLOCK_MONOTONIC) - t;
+    }
+
+    report("port_fanout_8", samples.get(), kRounds);
+
+    // poison packets shut the waiters down
+    for (uint32_t w = 0; w < kFanoutWaiters; w++) {
+        mx_port_packet_t packet = {};
+        packet.key = UINT64_MAX;
+        packet.type = MX_PKT_TYPE_USER;
+        CHECK(mx_port_queue(args.port, &packet, sizeof(packet)));
+    }
+    for (auto& waiter : waiters)
+        thrd_join(waiter, NULL);
+
+    mx_handle_close(args.port);
+    mx_handle_close(args.ack_port);
+}
+
+// -- futex handoff / context switch -----------------------------------------
+
+struct FutexArgs {
+    mx_futex_t ping;
+    mx_futex_t pong;
+    size_t iterations;
+};
+
+int futex_thread(void* arg) {
+    auto* args = static_cast<FutexArgs*>(arg);
+
+    for (size_t i = 0; i < args->iterations; i++) {
+        while (mx_futex_wait(&args->ping, 0, MX_TIME_INFINITE) != MX_OK)
+            ;
+        args->ping = 0;
+        args->pong = 1;
+        mx_futex_wake(&args->pong, 1u);
+    }
+    return 0;
+}
+
+void bench_futex_handoff() {
+    constexpr size_t kRounds = 1000;
+    constexpr uint64_t kBatch = 20;
+
+    FutexArgs args = {};
+    args.iterations = kRounds * kBatch;
+
+    thrd_t partner;
+    if (thrd_create(&partner, futex_thread, &args) != thrd_success)
+        fatal("thrd_create", MX_ERR_INTERNAL);
+
+    // each handoff is a wake plus a wait on both sides, so one sample
+    // covers two context switches
+    sample_batched("futex_handoff", kRounds, kBatch, [&args]() {
+        args.ping = 1;
+        mx_futex_wake(&args.ping, 1u);
+        while (mx_futex_wait(&args.pong, 0, MX_TIME_INFINITE) != MX_OK)
+            ;
+        args.pong = 0;
+    });
+
+    thrd_join(partner, NULL);
+}
+
+// -- vmo commit / decommit --------------------------------------------------
+
+void bench_vmo_commit() {
+    constexpr size_t kRounds = 500;
+    constexpr size_t kVmoSize = 4u * 1024 * 1024;
+    const size_t pages = kVmoSize / PAGE_SIZE;
+
+    mx_handle_t vmo;
+    CHECK(mx_vmo_create(kVmoSize, 0u, &vmo));
+
+    mxtl::unique_ptr<uint64_t[]> commit_samples(new uint64_t[kRounds]);
+    mxtl::unique_ptr<uint64_t[]> decommit_samples(new uint64_t[kRounds]);
+
+    spin(MX_MSEC(10));
+
+    for (size_t i = 0; i < kRounds; i++) {
+        mx_time_t t = mx_time_get(MX_CLOCK_MONOTONIC);
+        CHECK(mx_vmo_op_range(vmo, MX_VMO_OP_COMMIT, 0u, kVmoSize, NULL, 0u));
+        commit_samples[i] = (mx_time_get(MX_CLOCK_MONOTONIC) - t) / pages;
+
+        t = mx_time_get(MX_CLOCK_MONOTONIC);
+        CHECK(mx_vmo_op_range(vmo, MX_VMO_OP_DECOMMIT, 0u, kVmoSize, NULL, 0u));
+        decommit_samples[i] = (mx_time_get(MX_CLOCK_MONOTONIC) - t) / pages;
+    }
+
+    report("vmo_commit_page", commit_samples.get(), kRounds);
+    report("vmo_decommit_page", decommit_samples.get(), kRounds);
+
+    mx_handle_close(vmo);
+}
+
+// -- page faults ------------------------------------------------------------
+
+void bench_page_fault() {
+    constexpr size_t kRounds = 500;
+    constexpr size_t kVmoSize = 4u * 1024 * 1024;
+    const size_t pages = kVmoSize / PAGE_SIZE;
+
+    mx_handle_t vmo;
+    CHECK(mx_vmo_create(kVmoSize, 0u, &vmo));
+
+    uintptr_t ptr;
+    CHECK(mx_vmar_map(mx_vmar_root_self(), 0u, vmo, 0u, kVmoSize,
+                      MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE, &ptr));
+
+    mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[kRounds]);
+
+    spin(MX_MSEC(10));
+
+    // decommitting between rounds makes every touch a hard fault again
+    for (size_t i = 0; i < kRounds; i++) {
+        mx_time_t t = mx_time_get(MX_CLOCK_MONOTONIC);
+        for (size_t off = 0; off < kVmoSize; off += PAGE_SIZE)
+            (reinterpret_cast<volatile uint8_t*>(ptr))[off] = 1u;
+        samples[i] = (mx_time_get(MX_CLOCK_MONOTONIC) - t) / pages;
+
+        CHECK(mx_vmo_op_range(vmo, MX_VMO_OP_DECOMMIT, 0u, kVmoSize, NULL, 0u));
+    }
+
+    report("page_fault_write", samples.get(), kRounds);
+
+    mx_vmar_unmap(mx_vmar_root_self(), ptr, kVmoSize);
+    mx_handle_close(vmo);
+}
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    {"syscall", bench_syscall},
+    {"channel", bench_channel_echo},
+    {"port", bench_port_fanout},
+    {"futex", bench_futex_handoff},
+    {"vmo", bench_vmo_commit},
+    {"fault", bench_page_fault},
+};
+
+void print_usage(const char* argv0) {
+    printf("Usage: %s [options] [benchmark ...]\n"
+           "Kernel microbenchmarks. With no arguments, runs all of them.\n"
+           "Options:\n"
+           "  -h    show this help and exit\n"
+           "  -m    machine-readable output: one CSV line per benchmark,\n"
+           "        name,samples,min,p50,p90,p99,max,avg (all ns/op)\n"
+           "Benchmarks:\n",
+           argv0);
+    for (const auto& b : benchmarks)
+        printf("  %s\n", b.name);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "hm")) != -1) {
+        switch (opt) {
+        case 'h':
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        case 'm':
+            machine_readable = true;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (machine_readable)
+        printf("benchmark,samples,min,p50,p90,p99,max,avg\n");
+
+    if (optind == argc) {
+        for (const auto& b : benchmarks)
+            b.run();
+        return gate_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        bool found = false;
+        for (const auto& b : benchmarks) {
+            if (!strcmp(argv[i], b.name)) {
+                b.run();
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "%s: unknown benchmark '%s'\n", argv[0], argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    return gate_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
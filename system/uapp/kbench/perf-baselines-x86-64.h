@@ -0,0 +1,20 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <unittest/perftest.h>
+
+// Expected medians (ns/op) on the x86-64 perf builder (NUC). Initial
+// seeds; re-record with PERF_GATE off on the builder after any
+// intentional change.
+static const perf_baseline_t kPerfBaselines[] = {
+    {"syscall_null",       150, 30},
+    {"channel_echo_64b",  8000, 30},
+    {"port_fanout_8",    30000, 30},
+    {"futex_handoff",    12000, 30},
+    {"vmo_commit_page",   2500, 30},
+    {"vmo_decommit_page", 2500, 30},
+    {"page_fault_write",  3500, 30},
+};
@@ -11,20 +11,27 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <lz4/lz4frame.h>
 
 #define BLOCK_SIZE 65536
 
+// Pipeline slots per compression thread. Two lets the reader stay a
+// block ahead of each worker without burning much memory (each slot
+// holds one input block plus its compressed output).
+#define SLOTS_PER_THREAD 2
+
 #define WR_NEWFILE O_WRONLY | O_CREAT | O_TRUNC
 #define PERM_644 S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
 
 static void usage(const char* arg0) {
-    printf("usage: %s [-1|-9] [-d] <input file> <output file>\n", arg0);
+    printf("usage: %s [-1|-9] [-d] [-t <n>] <input file> <output file>\n", arg0);
     printf("   -1  fast compression (default)\n");
     printf("   -9  high compression (slower)\n");
     printf("   -d  decompress\n");
+    printf("   -t  use <n> compression threads (default: one per cpu)\n");
 }
 
 static int do_decompress(const char* infile, const char* outfile) {
@@ -123,6 +130,249 @@ done:
     return 0;
 }
 
+// Each 64K block of input is compressed into its own LZ4 frame and the
+// frames are concatenated, which the frame format (and do_decompress
+// above) explicitly allows. Since the frames are independent they can
+// be compressed in parallel: the reader fills slots in block order,
+// workers claim blocks in order and compress them without the lock
+// held, and the writer drains finished slots strictly in order so the
+// output is byte-identical to a single-threaded run.
+typedef enum {
+    SLOT_FREE,      // available for the reader to fill
+    SLOT_FULL,      // holds input waiting for a worker
+    SLOT_DONE,      // holds compressed output waiting for the writer
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    size_t inlen;
+    size_t outlen;
+    uint8_t* outbuf;
+    uint8_t inbuf[BLOCK_SIZE];
+} cslot_t;
+
+typedef struct {
+    mtx_t lock;
+    cnd_t slot_freed;   // a slot went SLOT_DONE -> SLOT_FREE
+    cnd_t slot_filled;  // a slot went SLOT_FREE -> SLOT_FULL, or input ended
+    cnd_t slot_done;    // a slot went SLOT_FULL -> SLOT_DONE, or input ended
+
+    cslot_t** slots;
+    unsigned nslots;
+
+    // Block sequence numbers; slot for block b is slots[b % nslots].
+    // Blocks are filled, claimed, and written in order, so
+    // next_write <= next_claim <= next_fill always holds.
+    uint64_t next_fill;
+    uint64_t next_claim;
+    uint64_t next_write;
+
+    bool input_done;
+    bool failed;
+
+    const LZ4F_preferences_t* prefs;
+    size_t outsize;
+    int outfd;
+    const char* outfile;
+} cpipeline_t;
+
+static void pipeline_fail(cpipeline_t* p) {
+    p->failed = true;
+    cnd_broadcast(&p->slot_freed);
+    cnd_broadcast(&p->slot_filled);
+    cnd_broadcast(&p->slot_done);
+}
+
+static int compress_thread(void* arg) {
+    cpipeline_t* p = arg;
+
+    mtx_lock(&p->lock);
+    for (;;) {
+        while (!p->failed && p->next_claim == p->next_fill && !p->input_done) {
+            cnd_wait(&p->slot_filled, &p->lock);
+        }
+        if (p->failed || p->next_claim == p->next_fill) {
+            break;
+        }
+
+        cslot_t* slot = p->slots[p->next_claim % p->nslots];
+        p->next_claim++;
+
+        mtx_unlock(&p->lock);
+        size_t csz = LZ4F_compressFrame(slot->outbuf, p->outsize,
+                                        slot->inbuf, slot->inlen, p->prefs);
+        mtx_lock(&p->lock);
+
+        if (LZ4F_isError(csz)) {
+            fprintf(stderr, "error compressing block: %s\n", LZ4F_getErrorName(csz));
+            pipeline_fail(p);
+            break;
+        }
+        slot->outlen = csz;
+        slot->state = SLOT_DONE;
+        cnd_broadcast(&p->slot_done);
+    }
+    mtx_unlock(&p->lock);
+    return 0;
+}
+
+static int write_thread(void* arg) {
+    cpipeline_t* p = arg;
+
+    mtx_lock(&p->lock);
+    for (;;) {
+        cslot_t* slot = p->slots[p->next_write % p->nslots];
+        while (!p->failed && slot->state != SLOT_DONE &&
+               !(p->input_done && p->next_write == p->next_fill)) {
+            cnd_wait(&p->slot_done, &p->lock);
+        }
+        if (p->failed || (p->input_done && p->next_write == p->next_fill)) {
+            break;
+        }
+
+        mtx_unlock(&p->lock);
+        ssize_t nw = write(p->outfd, slot->outbuf, slot->outlen);
+        mtx_lock(&p->lock);
+
+        if (nw != (ssize_t)slot->outlen) {
+            fprintf(stderr, "could not write to %s", p->outfile);
+            if (nw < 0) {
+                fprintf(stderr, ": %s", strerror(errno));
+            }
+            fprintf(stderr, "\n");
+            pipeline_fail(p);
+            break;
+        }
+        slot->state = SLOT_FREE;
+        p->next_write++;
+        cnd_broadcast(&p->slot_freed);
+    }
+    mtx_unlock(&p->lock);
+    return 0;
+}
+
+static int do_compress_parallel(const char* infile, const char* outfile,
+                                int clevel, unsigned nthreads) {
+    int infd, outfd;
+    int ret = -1;
+
+    infd = open(infile, O_RDONLY);
+    if (infd < 0) {
+        fprintf(stderr, "could not open %s: %s\n", infile, strerror(errno));
+        return -1;
+    }
+
+    outfd = open(outfile, WR_NEWFILE, PERM_644);
+    if (outfd < 0) {
+        fprintf(stderr, "could not open %s: %s\n", outfile, strerror(errno));
+        close(infd);
+        return -1;
+    }
+
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.compressionLevel = clevel;
+
+    cpipeline_t p;
+    memset(&p, 0, sizeof(p));
+    mtx_init(&p.lock, mtx_plain);
+    cnd_init(&p.slot_freed);
+    cnd_init(&p.slot_filled);
+    cnd_init(&p.slot_done);
+    p.nslots = nthreads * SLOTS_PER_THREAD;
+    p.prefs = &prefs;
+    p.outsize = LZ4F_compressFrameBound(BLOCK_SIZE, &prefs);
+    p.outfd = outfd;
+    p.outfile = outfile;
+
+    p.slots = calloc(p.nslots, sizeof(cslot_t*));
+    thrd_t* workers = calloc(nthreads, sizeof(thrd_t));
+    if (!p.slots || !workers) {
+        goto oom;
+    }
+    for (unsigned i = 0; i < p.nslots; i++) {
+        p.slots[i] = malloc(sizeof(cslot_t) + p.outsize);
+        if (!p.slots[i]) {
+            goto oom;
+        }
+        p.slots[i]->state = SLOT_FREE;
+        p.slots[i]->outbuf = (uint8_t*)(p.slots[i] + 1);
+    }
+
+    unsigned started = 0;
+    bool have_writer = false;
+    thrd_t writer;
+    for (; started < nthreads; started++) {
+        if (thrd_create(&workers[started], compress_thread, &p) != thrd_success) {
+            break;
+        }
+    }
+    if (started == nthreads) {
+        have_writer = (thrd_create(&writer, write_thread, &p) == thrd_success);
+    }
+
+    mtx_lock(&p.lock);
+    if (started < nthreads || !have_writer) {
+        fprintf(stderr, "could not start compression threads\n");
+        pipeline_fail(&p);
+    }
+
+    while (!p.failed) {
+        cslot_t* slot = p.slots[p.next_fill % p.nslots];
+        while (!p.failed && slot->state != SLOT_FREE) {
+            cnd_wait(&p.slot_freed, &p.lock);
+        }
+        if (p.failed) {
+            break;
+        }
+
+        mtx_unlock(&p.lock);
+        ssize_t nr = read(infd, slot->inbuf, BLOCK_SIZE);
+        mtx_lock(&p.lock);
+
+        if (nr < 0) {
+            fprintf(stderr, "error reading %s: %s\n", infile, strerror(errno));
+            pipeline_fail(&p);
+            break;
+        }
+        if (nr == 0) {
+            break;
+        }
+        slot->inlen = nr;
+        slot->state = SLOT_FULL;
+        p.next_fill++;
+        cnd_broadcast(&p.slot_filled);
+    }
+
+    p.input_done = true;
+    cnd_broadcast(&p.slot_filled);
+    cnd_broadcast(&p.slot_done);
+    mtx_unlock(&p.lock);
+
+    for (unsigned i = 0; i < started; i++) {
+        thrd_join(workers[i], NULL);
+    }
+    if (have_writer) {
+        thrd_join(writer, NULL);
+    }
+    ret = p.failed ? -1 : 0;
+
+    if (0) {
+oom:
+        fprintf(stderr, "out of memory\n");
+    }
+    if (p.slots) {
+        for (unsigned i = 0; i < p.nslots; i++) {
+            free(p.slots[i]);
+        }
+    }
+    free(p.slots);
+    free(workers);
+    close(outfd);
+    close(infd);
+    return ret;
+}
+
 static int do_compress(const char* infile, const char* outfile, int clevel) {
     int infd, outfd;
 
@@ -189,6 +439,7 @@ done:
 int main(int argc, char* argv[]) {
     int clevel = 1;
     bool decompress = false;
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
     const char* infile = NULL;
     const char* outfile = NULL;
 
@@ -197,10 +448,26 @@ int main(int argc, char* argv[]) {
             decompress = true;
             continue;
         }
+        if (!strcmp("-1", argv[i])) {
+            clevel = 1;
+            continue;
+        }
         if (!strcmp("-9", argv[i])) {
             clevel = 9;
             continue;
         }
+        if (!strcmp("-t", argv[i])) {
+            if (++i == argc) {
+                usage(argv[0]);
+                return -1;
+            }
+            nthreads = atol(argv[i]);
+            if (nthreads < 1) {
+                fprintf(stderr, "bad thread count: %s\n", argv[i]);
+                return -1;
+            }
+            continue;
+        }
         if (!strcmp("-h", argv[i])) {
             usage(argv[0]);
             return 0;
@@ -236,6 +503,8 @@ int main(int argc, char* argv[]) {
 
     if (decompress) {
         return do_decompress(infile, outfile);
+    } else if (nthreads > 1) {
+        return do_compress_parallel(infile, outfile, clevel, nthreads);
     } else {
         return do_compress(infile, outfile, clevel);
     }
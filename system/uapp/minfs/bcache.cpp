@@ -14,14 +14,27 @@
 #include <mxtl/unique_ptr.h>
 #include <magenta/device/device.h>
 
+#ifdef __Fuchsia__
+#include <magenta/syscalls.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "minfs.h"
 #include "minfs-private.h"
 
 namespace minfs {
 
-mx_status_t Bcache::Readblk(uint32_t bno, void* data) {
+mx_status_t Bcache::ReadblkRaw(uint32_t bno, void* data) {
     off_t off = bno * kMinfsBlockSize;
     FS_TRACE(IO, "readblk() bno=%u off=%#llx\n", bno, (unsigned long long)off);
+#ifndef __Fuchsia__
+    if (map_ != nullptr) {
+        memcpy(data, map_ + off, kMinfsBlockSize);
+        return MX_OK;
+    }
+#endif
     if (lseek(fd_, off, SEEK_SET) < 0) {
         FS_TRACE_ERROR("minfs: cannot seek to block %u\n", bno);
         return MX_ERR_IO;
@@ -33,9 +46,15 @@ mx_status_t Bcache::Readblk(uint32_t bno, void* data) {
     return MX_OK;
 }
 
-mx_status_t Bcache::Writeblk(uint32_t bno, const void* data) {
+mx_status_t Bcache::WriteblkRaw(uint32_t bno, const void* data) {
     off_t off = bno * kMinfsBlockSize;
     FS_TRACE(IO, "writeblk() bno=%u off=%#llx\n", bno, (unsigned long long)off);
+#ifndef __Fuchsia__
+    if (map_ != nullptr) {
+        memcpy(map_ + off, data, kMinfsBlockSize);
+        return MX_OK;
+    }
+#endif
     if (lseek(fd_, off, SEEK_SET) < 0) {
         FS_TRACE_ERROR("minfs: cannot seek to block %u\n", bno);
         return MX_ERR_IO;
@@ -47,7 +66,75 @@ mx_status_t Bcache::Writeblk(uint32_t bno, const void* data) {
     return MX_OK;
 }
 
+mx_status_t Bcache::Readblk(uint32_t bno, void* data) {
+    auto iter = dirty_.find(bno);
+    if (iter.IsValid()) {
+        FS_TRACE(IO, "readblk() bno=%u (dirty)\n", bno);
+        memcpy(data, iter->data_, kMinfsBlockSize);
+        return MX_OK;
+    }
+    return ReadblkRaw(bno, data);
+}
+
+mx_status_t Bcache::Writeblk(uint32_t bno, const void* data) {
+    if (!writeback_enabled_) {
+        return WriteblkRaw(bno, data);
+    }
+
+    auto iter = dirty_.find(bno);
+    if (iter.IsValid()) {
+        FS_TRACE(IO, "writeblk() bno=%u (dirty hit)\n", bno);
+        memcpy(iter->data_, data, kMinfsBlockSize);
+        return MX_OK;
+    }
+
+    AllocChecker ac;
+    mxtl::unique_ptr<DirtyBlock> db(new (&ac) DirtyBlock(bno));
+    if (!ac.check()) {
+        // Degrade to write-through rather than failing the write
+        return WriteblkRaw(bno, data);
+    }
+    FS_TRACE(IO, "writeblk() bno=%u (dirty)\n", bno);
+    memcpy(db->data_, data, kMinfsBlockSize);
+    dirty_.insert(mxtl::move(db));
+
+    if (dirty_.size() >= kMaxDirtyBlocks) {
+        return FlushDirty();
+    }
+    return MX_OK;
+}
+
+mx_status_t Bcache::FlushDirty() {
+    mx_status_t status = MX_OK;
+    // Tree iteration order is ascending bno, so the device sees the burst
+    // as (mostly) sequential writes.
+    while (!dirty_.is_empty()) {
+        mxtl::unique_ptr<DirtyBlock> db = dirty_.pop_front();
+        mx_status_t s = WriteblkRaw(db->bno_, db->data_);
+        if ((s != MX_OK) && (status == MX_OK)) {
+            status = s;
+        }
+    }
+    return status;
+}
+
+mx_status_t Bcache::SetWriteback(bool enabled) {
+    writeback_enabled_ = enabled;
+    if (!enabled) {
+        return FlushDirty();
+    }
+    return MX_OK;
+}
+
 int Bcache::Sync() {
+    if (FlushDirty() != MX_OK) {
+        return -1;
+    }
+#ifndef __Fuchsia__
+    if (map_ != nullptr) {
+        return msync(map_, map_len_, MS_SYNC);
+    }
+#endif
     return fsync(fd_);
 }
 
@@ -72,6 +159,50 @@ mx_status_t Bcache::Create(mxtl::unique_ptr<Bcache>* out, int fd, uint32_t block
         mx_handle_close(fifo);
         return status;
     }
+
+    // Directory walks and cache flushes batch many small adjacent blocks;
+    // let the fifo client merge them before submission.
+    block_fifo_set_coalescing(bc->fifo_client_, true);
+
+    // Set up the async pipeline: a bounce buffer with one block per txn
+    // slot, its own txn (the background thread submits concurrently with
+    // synchronous users of txnid_), and a thread to drain the queue.
+    if ((status = mx_vmo_create(kMinfsBlockSize * MAX_TXN_MESSAGES, 0,
+                                &bc->async_vmo_)) != MX_OK) {
+        return status;
+    }
+    if ((status = bc->AttachVmo(bc->async_vmo_, &bc->async_vmoid_)) != MX_OK) {
+        return status;
+    }
+    if ((r = ioctl_block_alloc_txn(fd, &bc->async_txnid_)) < 0) {
+        return static_cast<mx_status_t>(r);
+    }
+    mtx_init(&bc->async_lock_, mtx_plain);
+    cnd_init(&bc->async_work_cnd_);
+    cnd_init(&bc->async_space_cnd_);
+    if (thrd_create(&bc->async_thread_, AsyncThread, bc.get()) != thrd_success) {
+        return MX_ERR_NO_MEMORY;
+    }
+    bc->async_started_ = true;
+#else
+    // When the image is a regular file, map it and turn block I/O into
+    // memory copies; image builds then run at memory speed and the page
+    // cache writes the result back sequentially. Block devices (and
+    // filesystems without mmap) keep the fd path.
+    struct stat st;
+    if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode)) {
+        off_t len = (off_t)blockmax * kMinfsBlockSize;
+        if ((st.st_size >= len) || (ftruncate(fd, len) == 0)) {
+            void* map = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) {
+                bc->map_ = static_cast<uint8_t*>(map);
+                bc->map_len_ = len;
+                // Writes land directly in the mapping; the dirty-block
+                // cache would only add a copy on top.
+                bc->writeback_enabled_ = false;
+            }
+        }
+    }
 #endif
 
     *out = mxtl::move(bc);
@@ -96,18 +227,168 @@ mx_status_t Bcache::AttachVmo(mx_handle_t vmo, vmoid_t* out) {
     }
     return MX_OK;
 }
+
+mx_status_t Bcache::AsyncEnqueue(const AsyncOp& op) {
+    if (op.bno >= blockmax_) {
+        return MX_ERR_OUT_OF_RANGE;
+    }
+    // Async I/O travels over the fifo, which bypasses the dirty-block cache;
+    // flush it so the enqueued op cannot observe (or be overwritten by) a
+    // stale copy of a cached block.
+    mx_status_t status = FlushDirty();
+    if (status != MX_OK) {
+        return status;
+    }
+    mtx_lock(&async_lock_);
+    while (async_count_ == kAsyncDepth) {
+        cnd_wait(&async_space_cnd_, &async_lock_);
+    }
+    async_ops_[(async_head_ + async_count_) % kAsyncDepth] = op;
+    async_count_++;
+    cnd_signal(&async_work_cnd_);
+    mtx_unlock(&async_lock_);
+    return MX_OK;
+}
+
+mx_status_t Bcache::AsyncReadblk(uint32_t bno, void* data, AsyncCallback cb, void* cookie) {
+    FS_TRACE(IO, "async readblk() bno=%u\n", bno);
+    AsyncOp op = {bno, false, data, cb, cookie};
+    return AsyncEnqueue(op);
+}
+
+mx_status_t Bcache::AsyncWriteblk(uint32_t bno, const void* data, AsyncCallback cb, void* cookie) {
+    FS_TRACE(IO, "async writeblk() bno=%u\n", bno);
+    // The data is only read from, but AsyncOp is shared with the read path.
+    AsyncOp op = {bno, true, const_cast<void*>(data), cb, cookie};
+    return AsyncEnqueue(op);
+}
+
+mx_status_t Bcache::AsyncFlush() {
+    mtx_lock(&async_lock_);
+    while ((async_count_ != 0) || (async_inflight_ != 0)) {
+        cnd_wait(&async_space_cnd_, &async_lock_);
+    }
+    mx_status_t status = async_status_;
+    async_status_ = MX_OK;
+    mtx_unlock(&async_lock_);
+    return status;
+}
+
+// Issues up to one txn's worth of same-direction ops through the bounce
+// buffer and delivers their callbacks. The fifo server reports a single
+// status for the whole txn, so every op in the batch observes that status.
+mx_status_t Bcache::AsyncIo(AsyncOp* ops, size_t count) {
+    block_fifo_request_t requests[MAX_TXN_MESSAGES];
+    size_t actual;
+    mx_status_t status = MX_OK;
+    for (size_t i = 0; i < count; i++) {
+        if (ops[i].write) {
+            if ((status = mx_vmo_write(async_vmo_, ops[i].data, i * kMinfsBlockSize,
+                                       kMinfsBlockSize, &actual)) != MX_OK) {
+                break;
+            }
+        }
+        requests[i].txnid = async_txnid_;
+        requests[i].vmoid = async_vmoid_;
+        requests[i].opcode = ops[i].write ? BLOCKIO_WRITE : BLOCKIO_READ;
+        requests[i].length = kMinfsBlockSize;
+        requests[i].vmo_offset = i * kMinfsBlockSize;
+        requests[i].dev_offset = ops[i].bno * static_cast<uint64_t>(kMinfsBlockSize);
+    }
+    if (status == MX_OK) {
+        status = block_fifo_txn(fifo_client_, requests, count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        mx_status_t op_status = status;
+        if ((op_status == MX_OK) && !ops[i].write) {
+            op_status = mx_vmo_read(async_vmo_, ops[i].data, i * kMinfsBlockSize,
+                                    kMinfsBlockSize, &actual);
+        }
+        if (ops[i].cb != nullptr) {
+            ops[i].cb(ops[i].cookie, op_status);
+        }
+        if ((op_status != MX_OK) && (status == MX_OK)) {
+            status = op_status;
+        }
+    }
+    return status;
+}
+
+void Bcache::AsyncWork() {
+    mtx_lock(&async_lock_);
+    while (true) {
+        while ((async_count_ == 0) && !async_shutdown_) {
+            cnd_wait(&async_work_cnd_, &async_lock_);
+        }
+        if (async_count_ == 0) {
+            break;
+        }
+
+        // Dequeue a run of same-direction ops, at most one txn's worth, so
+        // they can travel to the device as a single batch.
+        AsyncOp ops[MAX_TXN_MESSAGES];
+        size_t count = 0;
+        bool write = async_ops_[async_head_].write;
+        while ((count < MAX_TXN_MESSAGES) && (async_count_ > 0) &&
+               (async_ops_[async_head_].write == write)) {
+            ops[count++] = async_ops_[async_head_];
+            async_head_ = (async_head_ + 1) % kAsyncDepth;
+            async_count_--;
+        }
+        async_inflight_ += count;
+        cnd_broadcast(&async_space_cnd_);
+        mtx_unlock(&async_lock_);
+
+        mx_status_t status = AsyncIo(ops, count);
+
+        mtx_lock(&async_lock_);
+        async_inflight_ -= count;
+        if ((status != MX_OK) && (async_status_ == MX_OK)) {
+            async_status_ = status;
+        }
+        if ((async_count_ == 0) && (async_inflight_ == 0)) {
+            // Wake anyone blocked in AsyncFlush
+            cnd_broadcast(&async_space_cnd_);
+        }
+    }
+    mtx_unlock(&async_lock_);
+}
+
+int Bcache::AsyncThread(void* arg) {
+    static_cast<Bcache*>(arg)->AsyncWork();
+    return 0;
+}
 #endif
 
 Bcache::Bcache(int fd, uint32_t blockmax) :
     fd_(fd), blockmax_(blockmax) {}
 
 Bcache::~Bcache() {
+    FlushDirty();
 #ifdef __Fuchsia__
+    if (async_started_) {
+        // Drain the queue, then ask the background thread to exit.
+        mtx_lock(&async_lock_);
+        async_shutdown_ = true;
+        cnd_signal(&async_work_cnd_);
+        mtx_unlock(&async_lock_);
+        thrd_join(async_thread_, nullptr);
+        cnd_destroy(&async_work_cnd_);
+        cnd_destroy(&async_space_cnd_);
+        ioctl_block_free_txn(fd_, &async_txnid_);
+    }
+    if (async_vmo_ != MX_HANDLE_INVALID) {
+        mx_handle_close(async_vmo_);
+    }
     if (fifo_client_ != nullptr) {
         ioctl_block_free_txn(fd_, &txnid_);
         ioctl_block_fifo_close(fd_);
         block_fifo_release_client(fifo_client_);
     }
+#else
+    if (map_ != nullptr) {
+        munmap(map_, map_len_);
+    }
 #endif
     close(fd_);
 }
@@ -24,6 +24,8 @@
 
 #include "minfs-private.h"
 #ifndef __Fuchsia__
+#include <errno.h>
+#include <pthread.h>
 #include "host.h"
 #endif
 
@@ -65,6 +67,9 @@ int do_minfs_mount(mxtl::unique_ptr<minfs::Bcache> bc, int argc, char** argv) {
         return status;
     }
     minfs::vfs.SetDispatcher(dispatcher.get());
+    // minfs's allocators and block cache are not yet safe for concurrent
+    // vnode operations; serialize messages until they grow their own locks.
+    minfs::vfs.SetSerializeAll(true);
     if ((status = minfs::vfs.ServeDirectory(mxtl::move(vn),
                                             mx::channel(h))) != MX_OK) {
         return status;
@@ -240,6 +245,219 @@ int do_ls(mxtl::unique_ptr<minfs::Bcache> bc, int argc, char** argv) {
     return 0;
 }
 
+// -- manifest ingestion ------------------------------------------------------
+//
+// Ingests a whole manifest of dst=src lines in one invocation, instead of
+// one process (and one mount) per file. The filesystem structures are
+// single-threaded, so a pool of reader threads pulls source files into
+// memory a bounded window ahead while the main thread appends them to the
+// image; host-side file reads overlap image construction.
+
+constexpr size_t kManifestReaders = 4;
+constexpr size_t kManifestWindow = 16;
+
+struct ManifestEntry {
+    char* dst;
+    char* src;
+    uint8_t* data;
+    size_t len;
+    bool ready;
+    bool failed;
+};
+
+struct ManifestQueue {
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t ready_cnd = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t space_cnd = PTHREAD_COND_INITIALIZER;
+    ManifestEntry* entries = nullptr;
+    size_t count = 0;
+    size_t next = 0;     // next entry a reader should claim
+    size_t consumed = 0; // entries the main thread is done with
+};
+
+void* manifest_reader(void* arg) {
+    auto* q = static_cast<ManifestQueue*>(arg);
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while ((q->next < q->count) &&
+               (q->next >= q->consumed + kManifestWindow)) {
+            pthread_cond_wait(&q->space_cnd, &q->lock);
+        }
+        if (q->next == q->count) {
+            pthread_mutex_unlock(&q->lock);
+            return nullptr;
+        }
+        ManifestEntry* e = &q->entries[q->next++];
+        pthread_mutex_unlock(&q->lock);
+
+        int fd = open(e->src, O_RDONLY);
+        struct stat st;
+        if ((fd < 0) || (fstat(fd, &st) < 0)) {
+            e->failed = true;
+        } else {
+            e->len = st.st_size;
+            e->data = static_cast<uint8_t*>(malloc(e->len ? e->len : 1));
+            if (e->data == nullptr) {
+                e->failed = true;
+            } else {
+                size_t off = 0;
+                while (off < e->len) {
+                    ssize_t r = read(fd, e->data + off, e->len - off);
+                    if (r <= 0) {
+                        e->failed = true;
+                        break;
+                    }
+                    off += r;
+                }
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        pthread_mutex_lock(&q->lock);
+        e->ready = true;
+        pthread_cond_broadcast(&q->ready_cnd);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+// create each missing parent of |path| (an emu path, prefix included)
+int manifest_mkdir_parents(char* path) {
+    for (char* p = path + PREFIX_SIZE + 1; (p = strchr(p, '/')) != nullptr; p++) {
+        *p = 0;
+        int r = emu_mkdir(path, 0);
+        *p = '/';
+        if ((r < 0) && (errno != EEXIST)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int do_manifest(mxtl::unique_ptr<minfs::Bcache> bc, int argc, char** argv) {
+    if (argc != 1) {
+        fprintf(stderr, "manifest requires one argument\n");
+        return -1;
+    }
+
+    FILE* f = fopen(argv[0], "r");
+    if (f == nullptr) {
+        fprintf(stderr, "error: cannot open '%s'\n", argv[0]);
+        return -1;
+    }
+
+    // parse dst=src lines; blank lines and #-comments are skipped
+    size_t max = 0;
+    ManifestQueue q;
+    char line[4096];
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        char* nl = strchr(line, '\n');
+        if (nl) {
+            *nl = 0;
+        }
+        if ((line[0] == 0) || (line[0] == '#')) {
+            continue;
+        }
+        char* eq = strchr(line, '=');
+        if (eq == nullptr) {
+            fprintf(stderr, "error: manifest line lacks '=': '%s'\n", line);
+            fclose(f);
+            return -1;
+        }
+        *eq = 0;
+        if (q.count == max) {
+            max = max ? (max * 2) : 256;
+            auto* grown = static_cast<ManifestEntry*>(
+                realloc(q.entries, max * sizeof(ManifestEntry)));
+            if (grown == nullptr) {
+                fclose(f);
+                return -1;
+            }
+            q.entries = grown;
+        }
+        ManifestEntry* e = &q.entries[q.count++];
+        memset(e, 0, sizeof(*e));
+        size_t dstlen = PREFIX_SIZE + 1 + strlen(line) + 1;
+        e->dst = static_cast<char*>(malloc(dstlen));
+        if (e->dst == nullptr) {
+            fclose(f);
+            return -1;
+        }
+        snprintf(e->dst, dstlen, PATH_PREFIX "%s%s",
+                 (line[0] == '/') ? "" : "/", line);
+        e->src = strdup(eq + 1);
+    }
+    fclose(f);
+
+    if (io_setup(mxtl::move(bc))) {
+        return -1;
+    }
+
+    pthread_t readers[kManifestReaders];
+    size_t started = 0;
+    while ((started < kManifestReaders) &&
+           (pthread_create(&readers[started], nullptr, manifest_reader, &q) == 0)) {
+        started++;
+    }
+    if (started == 0) {
+        fprintf(stderr, "error: cannot start manifest readers\n");
+        return -1;
+    }
+
+    int status = 0;
+    for (size_t i = 0; i < q.count; i++) {
+        ManifestEntry* e = &q.entries[i];
+        pthread_mutex_lock(&q.lock);
+        while (!e->ready) {
+            pthread_cond_wait(&q.ready_cnd, &q.lock);
+        }
+        pthread_mutex_unlock(&q.lock);
+
+        if (e->failed) {
+            fprintf(stderr, "error: reading '%s'\n", e->src);
+            status = -1;
+        } else if ((manifest_mkdir_parents(e->dst) < 0)) {
+            fprintf(stderr, "error: creating parents of '%s'\n", e->dst);
+            status = -1;
+        } else {
+            int fd = emu_open(e->dst, O_WRONLY | O_CREAT | O_EXCL, 0644);
+            if (fd < 0) {
+                fprintf(stderr, "error: cannot create '%s'\n", e->dst);
+                status = -1;
+            } else {
+                size_t off = 0;
+                while (off < e->len) {
+                    ssize_t r = emu_write(fd, e->data + off, e->len - off);
+                    if (r <= 0) {
+                        fprintf(stderr, "error: writing '%s'\n", e->dst);
+                        status = -1;
+                        break;
+                    }
+                    off += r;
+                }
+                emu_close(fd);
+            }
+        }
+
+        free(e->data);
+        e->data = nullptr;
+        free(e->dst);
+        free(e->src);
+
+        pthread_mutex_lock(&q.lock);
+        q.consumed = i + 1;
+        pthread_cond_broadcast(&q.space_cnd);
+        pthread_mutex_unlock(&q.lock);
+    }
+
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(readers[i], nullptr);
+    }
+    free(q.entries);
+    return status;
+}
+
 #endif
 
 int do_minfs_mkfs(mxtl::unique_ptr<minfs::Bcache> bc, int argc, char** argv) {
@@ -267,6 +485,7 @@ struct {
     {"mv", do_rename, O_RDWR, "rename file or directory"},
     {"rename", do_rename, O_RDWR, "rename file or directory"},
     {"ls", do_ls, O_RDWR, "list content of directory"},
+    {"manifest", do_manifest, O_RDWR, "add files from manifest (dst=src lines)"},
 #endif
 };
 
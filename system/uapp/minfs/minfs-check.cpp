@@ -33,6 +33,9 @@ mx_status_t MinfsChecker::GetInode(minfs_inode_t* inode, uint32_t ino) {
 #define CD_DUMP 1
 #define CD_RECURSE 2
 
+// How often (in allocated inodes) CheckInode reports progress.
+constexpr uint32_t kProgressInterval = 16384;
+
 mx_status_t MinfsChecker::GetInodeNthBno(minfs_inode_t* inode, uint32_t n,
                                          uint32_t* bno_out) {
     if (n < kMinfsDirect) {
@@ -47,21 +50,36 @@ mx_status_t MinfsChecker::GetInodeNthBno(minfs_inode_t* inode, uint32_t n,
         return MX_ERR_OUT_OF_RANGE;
     }
 
-    uint32_t ibno;
-    if ((ibno = inode->inum[i]) == 0) {
+    if (inode->inum[i] == 0) {
         *bno_out = 0;
         return MX_OK;
     }
-    char data[kMinfsBlockSize];
-    mx_status_t status;
-    if ((status = fs_->bc_->Readblk(ibno, data)) != MX_OK) {
-        return status;
-    }
-    uint32_t* ientry = reinterpret_cast<uint32_t*>(data);
+    const uint32_t* ientry = reinterpret_cast<const uint32_t*>(
+        indirect_cache_.get() + i * kMinfsBlockSize);
     *bno_out = ientry[j];
     return MX_OK;
 }
 
+mx_status_t MinfsChecker::LoadIndirectBlocks(minfs_inode_t* inode) {
+    if (indirect_cache_.get() == nullptr) {
+        indirect_cache_.reset(new char[kMinfsIndirect * kMinfsBlockSize],
+                              kMinfsIndirect * kMinfsBlockSize);
+    }
+    bool any = false;
+    mx_status_t status;
+    for (unsigned n = 0; n < kMinfsIndirect; n++) {
+        if (inode->inum[n]) {
+            if ((status = fs_->bc_->AsyncReadblk(inode->inum[n],
+                                                 indirect_cache_.get() + n * kMinfsBlockSize,
+                                                 nullptr, nullptr)) != MX_OK) {
+                return status;
+            }
+            any = true;
+        }
+    }
+    return any ? fs_->bc_->AsyncFlush() : MX_OK;
+}
+
 mx_status_t MinfsChecker::CheckDirectory(minfs_inode_t* inode, uint32_t ino,
                                          uint32_t parent, uint32_t flags) {
     unsigned eno = 0;
@@ -239,9 +257,13 @@ mx_status_t MinfsChecker::CheckFile(minfs_inode_t* inode, uint32_t ino) {
 
     // count and sanity-check data blocks
 
+    mx_status_t status;
+    if ((status = LoadIndirectBlocks(inode)) != MX_OK) {
+        return status;
+    }
+
     unsigned blocks_allocated = 0;
     for (unsigned n = 0;; n++) {
-        mx_status_t status;
         uint32_t bno;
         if ((status = GetInodeNthBno(inode, n, &bno)) < 0) {
             if (status == MX_ERR_OUT_OF_RANGE) {
@@ -302,6 +324,13 @@ mx_status_t MinfsChecker::CheckInode(uint32_t ino, uint32_t parent, bool dot_or_
     checked_inodes_.Set(ino, ino + 1);
     alloc_inodes_++;
 
+    // Large volumes take a while; report progress so a boot-time check
+    // does not look hung.
+    if ((alloc_inodes_ % kProgressInterval) == 0) {
+        fprintf(stderr, "check: %u/%u inodes scanned...\n",
+                alloc_inodes_, fs_->info_.alloc_inode_count);
+    }
+
     if (!fs_->inode_map_.Get(ino, ino + 1)) {
        FS_TRACE_WARN("check: ino#%u: not marked in-use\n", ino);
         conforming_ = false;
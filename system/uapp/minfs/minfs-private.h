@@ -48,6 +48,10 @@ constexpr uint32_t kMxFsSyncCtime = (1 << 1);
 
 constexpr uint32_t kMinfsBlockCacheSize = 64;
 
+// Number of block bitmap bits summarized by each bit of the block allocation
+// summary (one summary bit per 64 words of bitmap).
+constexpr size_t kMinfsGroupBits = 64 * bitmap::kBits;
+
 // Used by fsck
 class MinfsChecker;
 
@@ -109,6 +113,10 @@ private:
     // Find a free inode, allocate it in the inode bitmap, and write it back to disk
     mx_status_t InoNew(WriteTxn* txn, const minfs_inode_t* inode, uint32_t* ino_out);
 
+    // Find a free bit in [bitoff, bitmax) of the block bitmap, skipping
+    // fully allocated groups via the block allocation summary.
+    mx_status_t FindFreeBlock(size_t bitoff, size_t bitmax, size_t* out) const;
+
     // Enqueues an update for allocated inode/block counts
     mx_status_t CountUpdate(WriteTxn* txn);
 #ifdef __Fuchsia__
@@ -116,8 +124,16 @@ private:
 #endif
     uint32_t abmblks_{};
     uint32_t ibmblks_{};
+    // Rotating cursors into the allocation bitmaps.  Searches resume from
+    // the last allocation rather than rescanning the (mostly allocated)
+    // front of the bitmap; frees rewind them so freed space is found again.
+    uint32_t block_hint_{};
+    uint32_t ino_hint_{};
     RawBitmap inode_map_{};
     RawBitmap block_map_{};
+    // One bit per kMinfsGroupBits-sized group of block_map_, set when the
+    // group is fully allocated.  In-memory only; rebuilt at mount.
+    bitmap::RawBitmapGeneric<bitmap::DefaultStorage> block_summary_{};
 #ifdef __Fuchsia__
     mxtl::unique_ptr<MappedVmo> inode_table_{};
     mxtl::unique_ptr<MappedVmo> info_vmo_{};
@@ -305,6 +321,10 @@ private:
 
     mx_status_t GetInode(minfs_inode_t* inode, uint32_t ino);
     mx_status_t GetInodeNthBno(minfs_inode_t* inode, uint32_t n, uint32_t* bno_out);
+    // Reads all of an inode's indirect blocks into indirect_cache_ ahead of
+    // the data-block walk, pipelined through the async reader, so
+    // GetInodeNthBno does not reread one per entry.
+    mx_status_t LoadIndirectBlocks(minfs_inode_t* inode);
     mx_status_t CheckDirectory(minfs_inode_t* inode, uint32_t ino,
                                uint32_t parent, uint32_t flags);
     const char* CheckDataBlock(uint32_t bno);
@@ -317,6 +337,9 @@ private:
     uint32_t alloc_inodes_;
     uint32_t alloc_blocks_;
     mxtl::Array<int32_t> links_;
+    // Indirect blocks of the inode currently being walked, allocated on
+    // first use; slot i holds the contents of inode->inum[i].
+    mxtl::Array<char> indirect_cache_;
 };
 
 mx_status_t minfs_check(mxtl::unique_ptr<Bcache> bc);
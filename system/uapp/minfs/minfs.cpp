@@ -115,6 +115,9 @@ mx_status_t Minfs::InoFree(
     // Free the inode bit itself
     inode_map_.Clear(ino, ino + 1);
     info_.alloc_inode_count--;
+    if (ino < ino_hint_) {
+        ino_hint_ = ino;
+    }
 
     uint32_t bitblock = ino / kMinfsBlockBits;
     txn.Enqueue(ibm_id, bitblock, info_.ibm_block + bitblock, 1);
@@ -163,7 +166,10 @@ mx_status_t Minfs::InoFree(
 
 mx_status_t Minfs::InoNew(WriteTxn* txn, const minfs_inode_t* inode, uint32_t* ino_out) {
     size_t bitoff_start;
-    mx_status_t status = inode_map_.Find(false, 0, inode_map_.size(), 1, &bitoff_start);
+    mx_status_t status = inode_map_.Find(false, ino_hint_, inode_map_.size(), 1, &bitoff_start);
+    if (status != MX_OK && ino_hint_ != 0) {
+        status = inode_map_.Find(false, 0, ino_hint_, 1, &bitoff_start);
+    }
     if (status != MX_OK) {
         return status;
     }
@@ -172,6 +178,7 @@ mx_status_t Minfs::InoNew(WriteTxn* txn, const minfs_inode_t* inode, uint32_t* i
     assert(status == MX_OK);
     info_.alloc_inode_count++;
     uint32_t ino = static_cast<uint32_t>(bitoff_start);
+    ino_hint_ = (ino + 1 < inode_map_.size()) ? ino + 1 : 0;
 
     // locate data and block offset of bitmap
     void* bmdata;
@@ -187,6 +194,9 @@ mx_status_t Minfs::InoNew(WriteTxn* txn, const minfs_inode_t* inode, uint32_t* i
     if ((status = InodeSync(txn, ino, inode)) != MX_OK) {
         inode_map_.Clear(ino, ino + 1);
         info_.alloc_inode_count--;
+        if (ino < ino_hint_) {
+            ino_hint_ = ino;
+        }
         return status;
     }
 
@@ -273,11 +283,36 @@ mx_status_t Minfs::BlockFree(WriteTxn* txn, uint32_t bno) {
 
     block_map_.Clear(bno, bno + 1);
     info_.alloc_block_count--;
+    block_summary_.ClearOne(bno / kMinfsGroupBits);
+    if (bno < block_hint_) {
+        block_hint_ = bno;
+    }
     uint32_t bitblock = bno / kMinfsBlockBits;
     txn->Enqueue(bbm_id, bitblock, info_.abm_block + bitblock, 1);
     return CountUpdate(txn);
 }
 
+mx_status_t Minfs::FindFreeBlock(size_t bitoff, size_t bitmax, size_t* out) const {
+    size_t group_max = (bitmax + kMinfsGroupBits - 1) / kMinfsGroupBits;
+    size_t group = bitoff / kMinfsGroupBits;
+    while (group < group_max) {
+        // A clear summary bit means the group has at least one free block,
+        // so fully allocated stretches of the bitmap cost one summary scan
+        // rather than a scan of the bitmap itself.
+        if (block_summary_.Find(false, group, group_max, 1, &group) != MX_OK) {
+            break;
+        }
+        size_t start = mxtl::max(group * kMinfsGroupBits, bitoff);
+        size_t end = mxtl::min((group + 1) * kMinfsGroupBits, bitmax);
+        if (block_map_.Find(false, start, end, 1, out) == MX_OK) {
+            return MX_OK;
+        }
+        // The group's free blocks lie outside [bitoff, bitmax); keep going.
+        group++;
+    }
+    return MX_ERR_NO_SPACE;
+}
+
 // Allocate a new data block from the block bitmap.
 //
 // If hint is nonzero it indicates which block number to start the search for
@@ -285,8 +320,12 @@ mx_status_t Minfs::BlockFree(WriteTxn* txn, uint32_t bno) {
 mx_status_t Minfs::BlockNew(WriteTxn* txn, uint32_t hint, uint32_t* out_bno) {
     size_t bitoff_start;
     mx_status_t status;
-    if ((status = block_map_.Find(false, hint, block_map_.size(), 1, &bitoff_start)) != MX_OK) {
-        if ((status = block_map_.Find(false, 0, hint, 1, &bitoff_start)) != MX_OK) {
+    if (hint == 0) {
+        // No placement preference; resume wherever the last search left off.
+        hint = block_hint_;
+    }
+    if ((status = FindFreeBlock(hint, block_map_.size(), &bitoff_start)) != MX_OK) {
+        if ((status = FindFreeBlock(0, hint, &bitoff_start)) != MX_OK) {
             return MX_ERR_NO_SPACE;
         }
     }
@@ -296,6 +335,15 @@ mx_status_t Minfs::BlockNew(WriteTxn* txn, uint32_t hint, uint32_t* out_bno) {
     info_.alloc_block_count++;
     uint32_t bno = static_cast<uint32_t>(bitoff_start);
     ValidateBno(bno);
+    block_hint_ = (bno + 1 < block_map_.size()) ? bno + 1 : 0;
+
+    // Mark the group full in the summary if this was its last free block.
+    size_t group = bitoff_start / kMinfsGroupBits;
+    size_t group_start = group * kMinfsGroupBits;
+    size_t group_end = mxtl::min(group_start + kMinfsGroupBits, block_map_.size());
+    if (block_map_.Get(group_start, group_end)) {
+        block_summary_.SetOne(group);
+    }
 
     // obtain the in-memory bitmap block
     uint32_t bmbno_rel = bno / kMinfsBlockBits;       // bmbno relative to bitmap
@@ -445,6 +493,21 @@ mx_status_t Minfs::Create(Minfs** out, mxtl::unique_ptr<Bcache> bc, const minfs_
     }
 #endif
 
+    // Build the block allocation summary: one bit per group of the block
+    // bitmap, set when every block in the group is allocated.
+    size_t ngroups = (fs->info_.block_count + kMinfsGroupBits - 1) / kMinfsGroupBits;
+    if ((status = fs->block_summary_.Reset(ngroups)) < 0) {
+        return status;
+    }
+    for (size_t group = 0; group < ngroups; group++) {
+        size_t start = group * kMinfsGroupBits;
+        size_t end = mxtl::min(start + kMinfsGroupBits,
+                               static_cast<size_t>(fs->info_.block_count));
+        if (fs->block_map_.Get(start, end)) {
+            fs->block_summary_.SetOne(group);
+        }
+    }
+
     *out = fs.release();
     return MX_OK;
 }
@@ -8,6 +8,7 @@
 #include <bitmap/storage.h>
 #include <mxtl/intrusive_double_list.h>
 #include <mxtl/intrusive_hash_table.h>
+#include <mxtl/intrusive_wavl_tree.h>
 #include <mxtl/macros.h>
 #include <mxtl/ref_counted.h>
 #include <mxtl/ref_ptr.h>
@@ -25,6 +26,7 @@
 
 #ifdef __Fuchsia__
 #include <block-client/client.h>
+#include <threads.h>
 using RawBitmap = bitmap::RawBitmapGeneric<bitmap::VmoStorage>;
 #else
 using RawBitmap = bitmap::RawBitmapGeneric<bitmap::DefaultStorage>;
@@ -164,6 +166,18 @@ static_assert(kMinfsMaxDirectorySize <= kMinfsReclenMask,
 // Block Cache (bcache.c)
 constexpr uint32_t kMinfsHashBits = (8);
 
+// A block which has been written but not yet flushed to the device.
+// Dirty blocks live in a tree keyed by block number, so flushing them in
+// iteration order produces ascending (sequential) device writes.
+class DirtyBlock : public mxtl::WAVLTreeContainable<mxtl::unique_ptr<DirtyBlock>> {
+public:
+    explicit DirtyBlock(uint32_t bno) : bno_(bno) {}
+    uint32_t GetKey() const { return bno_; }
+
+    const uint32_t bno_;
+    uint8_t data_[kMinfsBlockSize];
+};
+
 class Bcache {
 public:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Bcache);
@@ -172,19 +186,51 @@ public:
     static mx_status_t Create(mxtl::unique_ptr<Bcache>* out, int fd, uint32_t blockmax);
 
     // Raw block read functions.
-    // These do not track blocks (or attempt to access the block cache)
+    // These do not track blocks (or attempt to access the block cache).
+    // Writes are cached as dirty blocks (and reads observe them) until
+    // kMaxDirtyBlocks accumulate, Sync() is called, or write-back is
+    // disabled; see SetWriteback.
     mx_status_t Readblk(uint32_t bno, void* data);
     mx_status_t Writeblk(uint32_t bno, const void* data);
 
+    // Controls write-back caching of block writes (enabled by default).
+    // Disabling flushes any dirty blocks and returns the flush status;
+    // subsequent writes go straight to the device.
+    mx_status_t SetWriteback(bool enabled);
+
     uint32_t Maxblk() const { return blockmax_; };
 
 #ifdef __Fuchsia__
     ssize_t GetDevicePath(char* out, size_t out_len);
     mx_status_t AttachVmo(mx_handle_t vmo, vmoid_t* out);
     mx_status_t Txn(block_fifo_request_t* requests, size_t count) {
+        // Fifo I/O bypasses the dirty-block cache; flush it first so the
+        // device and the cache never disagree about a block's contents.
+        mx_status_t status = FlushDirty();
+        if (status != MX_OK) {
+            return status;
+        }
         return block_fifo_txn(fifo_client_, requests, count);
     }
     txnid_t TxnId() const { return txnid_; }
+
+    // Asynchronous raw block I/O.
+    //
+    // Enqueued operations are pipelined: a background thread batches
+    // adjacent pending operations of the same direction into single fifo
+    // txns, so callers may keep many operations in flight. 'cb' is invoked
+    // exactly once from the background thread with the operation's status;
+    // for reads, 'data' is not valid until then. Operations may complete in
+    // any order. Enqueueing blocks only when kAsyncDepth operations are
+    // already pending.
+    using AsyncCallback = void (*)(void* cookie, mx_status_t status);
+    mx_status_t AsyncReadblk(uint32_t bno, void* data, AsyncCallback cb, void* cookie);
+    mx_status_t AsyncWriteblk(uint32_t bno, const void* data, AsyncCallback cb, void* cookie);
+
+    // Waits until every async operation enqueued so far has completed.
+    // Returns the first error (if any) reported by a callback since the
+    // previous AsyncFlush, without disturbing per-op callback delivery.
+    mx_status_t AsyncFlush();
 #endif
 
     int Sync();
@@ -194,9 +240,60 @@ public:
 private:
     Bcache(int fd, uint32_t blockmax);
 
+    // Write-through to the underlying device, bypassing the dirty cache
+    mx_status_t ReadblkRaw(uint32_t bno, void* data);
+    mx_status_t WriteblkRaw(uint32_t bno, const void* data);
+
+    // Writes out (and drops) every dirty block, in ascending bno order
+    mx_status_t FlushDirty();
+
+    // How many blocks may be dirty before Writeblk forces a flush
+    static constexpr size_t kMaxDirtyBlocks = 64;
+
+    mxtl::WAVLTree<uint32_t, mxtl::unique_ptr<DirtyBlock>> dirty_;
+    bool writeback_enabled_ = true;
+
 #ifdef __Fuchsia__
+    // The maximum number of async operations which may be pending before
+    // AsyncReadblk/AsyncWriteblk block the caller.
+    static constexpr size_t kAsyncDepth = 64;
+
+    struct AsyncOp {
+        uint32_t bno;
+        bool write;
+        void* data;
+        AsyncCallback cb;
+        void* cookie;
+    };
+
+    static int AsyncThread(void* arg);
+    void AsyncWork();
+    mx_status_t AsyncEnqueue(const AsyncOp& op);
+    mx_status_t AsyncIo(AsyncOp* ops, size_t count);
+
     fifo_client_t* fifo_client_{}; // Fast path to interact with block device
     txnid_t txnid_{}; // TODO(smklein): One per thread
+
+    // Async state; the ring and counters are guarded by async_lock_.
+    mx_handle_t async_vmo_ = MX_HANDLE_INVALID; // Bounce buffer, one block per txn slot
+    vmoid_t async_vmoid_{};
+    txnid_t async_txnid_{};
+    thrd_t async_thread_{};
+    bool async_started_ = false;
+    mtx_t async_lock_{};
+    cnd_t async_work_cnd_{};  // Signalled when ops are enqueued (or at shutdown)
+    cnd_t async_space_cnd_{}; // Signalled when queue space frees up or all ops drain
+    AsyncOp async_ops_[kAsyncDepth] = {};
+    size_t async_head_ = 0;     // Next slot to dequeue
+    size_t async_count_ = 0;    // Enqueued but not yet dequeued
+    size_t async_inflight_ = 0; // Dequeued but not yet completed
+    mx_status_t async_status_ = MX_OK; // Sticky; cleared by AsyncFlush
+    bool async_shutdown_ = false;
+#else
+    // When the image is a regular file it is mapped here and block I/O is
+    // direct memory access; fd-based I/O remains the fallback.
+    uint8_t* map_ = nullptr;
+    size_t map_len_ = 0;
 #endif
     int fd_ = -1;
     uint32_t blockmax_{};
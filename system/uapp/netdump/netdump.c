@@ -13,43 +13,60 @@
 #include <stdio.h>
 #include <string.h>
 
-#define BUFSIZE 2048
+// header slot + record slots
+#define RING_SLOTS 256
+#define RING_SIZE ((RING_SLOTS + 1) * ETH_CAPTURE_SLOT_SIZE)
 
-void handle_rx(mx_handle_t rx_fifo, char* iobuf, unsigned count) {
-    eth_fifo_entry_t entries[count];
+void handle_capture(mx_handle_t rx_fifo, volatile eth_capture_header_t* hdr) {
+    uint32_t slots = hdr->slots;
+    uint32_t dropped = 0;
 
     for (;;) {
-        uint32_t n;
-        mx_status_t status;
-        if ((status = mx_fifo_read(rx_fifo, entries, sizeof(entries), &n)) < 0) {
-            if (status == MX_ERR_SHOULD_WAIT) {
-                mx_object_wait_one(rx_fifo, MX_FIFO_READABLE | MX_FIFO_PEER_CLOSED, MX_TIME_INFINITE, NULL);
-                continue;
+        if (hdr->rd == hdr->wr) {
+            // clear the doorbell, then re-check the ring so we cannot
+            // miss an empty->non-empty transition
+            mx_object_signal(rx_fifo, ETH_SIGNAL_CAPTURE, 0);
+            if (hdr->rd == hdr->wr) {
+                mx_signals_t observed;
+                mx_status_t status;
+                if ((status = mx_object_wait_one(rx_fifo,
+                                                 ETH_SIGNAL_CAPTURE | MX_FIFO_PEER_CLOSED,
+                                                 MX_TIME_INFINITE, &observed)) < 0) {
+                    fprintf(stderr, "netdump: failed to wait for packets: %d\n", status);
+                    return;
+                }
+                if (observed & MX_FIFO_PEER_CLOSED) {
+                    return;
+                }
             }
-            fprintf(stderr, "netdump: failed to read rx packets: %d\n", status);
-            return;
+            continue;
         }
 
-        eth_fifo_entry_t* e = entries;
-        for (uint32_t i = 0; i < n; i++, e++) {
-            if (e->flags & ETH_FIFO_RX_OK) {
-                printf("---\n");
-                hexdump8_ex(iobuf + e->offset, e->length, 0);
-            }
-            e->length = BUFSIZE;
-            e->flags = 0;
-            uint32_t actual;
-            if ((status = mx_fifo_write(rx_fifo, e, sizeof(*e), &actual)) < 0) {
-                fprintf(stderr, "netdump: failed to queue rx packet: %d\n", status);
-                break;
-            }
+        while (hdr->rd != hdr->wr) {
+            eth_capture_record_t* rec = (void*)((uintptr_t)hdr +
+                    (1 + (hdr->rd % slots)) * ETH_CAPTURE_SLOT_SIZE);
+            printf("--- %u bytes (flags %x)\n", rec->length, rec->flags);
+            hexdump8_ex(rec + 1, rec->length, 0);
+            hdr->rd++;
+        }
+
+        if (hdr->dropped != dropped) {
+            fprintf(stderr, "netdump: %u packets dropped\n", hdr->dropped - dropped);
+            dropped = hdr->dropped;
         }
     }
 }
 
 int main(int argc, char** argv) {
+    unsigned long ethertype = 0;
+
+    while ((argc > 2) && !strcmp(argv[1], "-e")) {
+        ethertype = strtoul(argv[2], NULL, 0);
+        argc -= 2;
+        argv += 2;
+    }
     if (argc != 2) {
-        fprintf(stderr, "usage:  netdump <network-device>\n");
+        fprintf(stderr, "usage:  netdump [-e <ethertype>] <network-device>\n");
         return -1;
     }
 
@@ -68,42 +85,41 @@ int main(int argc, char** argv) {
         return r;
     }
 
-    unsigned count = fifos.rx_depth / 2;
-    mx_handle_t iovmo;
-    // allocate shareable ethernet buffer data heap
-    if ((status = mx_vmo_create(count * BUFSIZE, 0, &iovmo)) < 0) {
-        return -1;
+    if ((r = ioctl_ethernet_set_client_name(fd, "netdump", 7)) < 0) {
+        fprintf(stderr, "netdump: failed to set client name %zd\n", r);
     }
 
-    char* iobuf;
-    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, iovmo, 0, count * BUFSIZE,
-                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE,
-                              (uintptr_t*)&iobuf)) < 0) {
-        return -1;
+    if (ethertype != 0) {
+        // accept only packets whose ethertype matches, before they are
+        // copied out of the driver
+        eth_filter_insn_t filter[] = {
+            { .op = ETH_FILTER_OP_LDH, .k = 12 },
+            { .op = ETH_FILTER_OP_JEQ, .jt = 0, .jf = 1, .k = ethertype },
+            { .op = ETH_FILTER_OP_ACCEPT },
+            { .op = ETH_FILTER_OP_REJECT },
+        };
+        if ((r = ioctl_ethernet_set_filter(fd, filter, sizeof(filter))) < 0) {
+            fprintf(stderr, "netdump: failed to set filter: %zd\n", r);
+            return -1;
+        }
     }
 
-    if ((r = ioctl_ethernet_set_iobuf(fd, &iovmo)) < 0) {
-        fprintf(stderr, "netdump: failed to set iobuf: %zd\n", r);
+    // allocate and install the shared capture ring
+    mx_handle_t ringvmo;
+    if ((status = mx_vmo_create(RING_SIZE, 0, &ringvmo)) < 0) {
         return -1;
     }
 
-    if ((r = ioctl_ethernet_set_client_name(fd, "netdump", 7)) < 0) {
-        fprintf(stderr, "netdump: failed to set client name %zd\n", r);
+    volatile eth_capture_header_t* hdr;
+    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, ringvmo, 0, RING_SIZE,
+                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE,
+                              (uintptr_t*)&hdr)) < 0) {
+        return -1;
     }
 
-    // assign data chunks to ethbufs
-    for (unsigned n = 0; n < count; n++) {
-        eth_fifo_entry_t entry = {
-            .offset = n * BUFSIZE,
-            .length = BUFSIZE,
-            .flags = 0,
-            .cookie = NULL,
-        };
-        uint32_t actual;
-        if ((status = mx_fifo_write(fifos.rx_fifo, &entry, sizeof(entry), &actual)) < 0) {
-            fprintf(stderr, "netdump: failed to queue rx packet: %d\n", status);
-            return -1;
-        }
+    if ((r = ioctl_ethernet_set_capture_ring(fd, &ringvmo)) < 0) {
+        fprintf(stderr, "netdump: failed to set capture ring: %zd\n", r);
+        return -1;
     }
 
     if (ioctl_ethernet_start(fd) < 0) {
@@ -116,7 +132,7 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    handle_rx(fifos.rx_fifo, iobuf, count);
+    handle_capture(fifos.rx_fifo, hdr);
 
     return 0;
 }
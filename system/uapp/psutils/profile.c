@@ -0,0 +1,236 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Sampling profiler for another process's user stacks.
+//
+// Each round suspends every thread of the target process in one pass,
+// waits for the suspensions to land, walks each thread's frame pointer
+// chain, and resumes everything. The stack walk reads the target's
+// stack in page-sized chunks through mx_process_read_memory and follows
+// the chain inside the local copy, so a typical sample costs one memory
+// read per thread rather than one per frame. Output is one line per
+// thread per round ("<tid> <pc> <caller> ...", addresses in hex);
+// symbolization and folding are left to host-side tooling.
+//
+// Frames are only as honest as the target's frame pointers: leaf
+// functions and code built with -fomit-frame-pointer truncate the walk.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <magenta/syscalls.h>
+#include <magenta/syscalls/debug.h>
+#include <magenta/syscalls/object.h>
+#include <task-utils/get.h>
+
+#define MAX_THREADS 256
+#define MAX_FRAMES 32
+
+// One chunk usually covers the whole hot part of the stack.
+#define STACK_CHUNK_SIZE 4096u
+
+// How long to wait for a suspension to land before skipping the thread.
+#define SUSPEND_WAIT_TRIES 50
+#define SUSPEND_WAIT_STEP MX_USEC(20)
+
+#if defined(__x86_64__)
+typedef mx_x86_64_general_regs_t general_regs_t;
+#elif defined(__aarch64__)
+typedef mx_arm64_general_regs_t general_regs_t;
+#else
+#error unsupported architecture
+#endif
+
+static void get_pc_fp(const general_regs_t* regs, uint64_t* pc, uint64_t* fp) {
+#if defined(__x86_64__)
+    *pc = regs->rip;
+    *fp = regs->rbp;
+#elif defined(__aarch64__)
+    *pc = regs->pc;
+    *fp = regs->r[29];
+#endif
+}
+
+// Walks the frame pointer chain out of |regs|, filling in up to |max|
+// pcs. Reads the target stack in chunks and only goes back to the
+// kernel when the chain leaves the chunk in hand.
+static size_t walk_stack(mx_handle_t process, const general_regs_t* regs,
+                         uint64_t* pcs, size_t max) {
+    uint64_t chunk[STACK_CHUNK_SIZE / sizeof(uint64_t)];
+    uint64_t chunk_base = 0;
+    size_t chunk_len = 0;
+
+    uint64_t pc, fp;
+    get_pc_fp(regs, &pc, &fp);
+
+    size_t n = 0;
+    pcs[n++] = pc;
+
+    while (n < max && fp != 0 && (fp & 7) == 0) {
+        // A frame is two words: [fp] = next fp, [fp + 8] = return pc.
+        if (fp < chunk_base || fp + 16 > chunk_base + chunk_len) {
+            size_t actual;
+            if (mx_process_read_memory(process, fp, chunk, sizeof(chunk),
+                                       &actual) != MX_OK ||
+                actual < 16) {
+                break;
+            }
+            chunk_base = fp;
+            chunk_len = actual;
+        }
+        uint64_t next_fp = chunk[(fp - chunk_base) / sizeof(uint64_t)];
+        uint64_t ret_pc = chunk[(fp - chunk_base) / sizeof(uint64_t) + 1];
+        if (ret_pc == 0)
+            break;
+        pcs[n++] = ret_pc;
+        if (next_fp <= fp) // stacks grow down; refuse to walk in circles
+            break;
+        fp = next_fp;
+    }
+    return n;
+}
+
+static int sample_round(mx_handle_t process) {
+    mx_koid_t koids[MAX_THREADS];
+    size_t actual = 0;
+    mx_status_t status =
+        mx_object_get_info(process, MX_INFO_PROCESS_THREADS, koids,
+                           sizeof(koids), &actual, NULL);
+    if (status != MX_OK) {
+        fprintf(stderr, "profile: cannot list threads: %d\n", status);
+        return -1;
+    }
+
+    mx_handle_t threads[MAX_THREADS];
+    mx_koid_t tids[MAX_THREADS];
+    size_t num_threads = 0;
+
+    // Suspend everything first so the threads stop together; the
+    // suspensions land while we pick up the remaining handles.
+    for (size_t i = 0; i < actual; i++) {
+        mx_handle_t thread;
+        if (mx_object_get_child(process, koids[i], MX_RIGHT_SAME_RIGHTS,
+                                &thread) != MX_OK) {
+            continue; // thread exited; skip it
+        }
+        if (mx_task_suspend(thread) != MX_OK) {
+            mx_handle_close(thread);
+            continue;
+        }
+        tids[num_threads] = koids[i];
+        threads[num_threads++] = thread;
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+        // Wait for the suspension to land. Threads blocked in a
+        // syscall stay blocked and cannot be sampled; skip them.
+        mx_info_thread_t info;
+        int tries = SUSPEND_WAIT_TRIES;
+        do {
+            if (mx_object_get_info(threads[i], MX_INFO_THREAD, &info,
+                                   sizeof(info), NULL, NULL) != MX_OK) {
+                info.state = MX_THREAD_STATE_DEAD;
+                break;
+            }
+            if (info.state == MX_THREAD_STATE_SUSPENDED)
+                break;
+            if (info.state == MX_THREAD_STATE_BLOCKED ||
+                info.state == MX_THREAD_STATE_DYING ||
+                info.state == MX_THREAD_STATE_DEAD)
+                break;
+            mx_nanosleep(mx_deadline_after(SUSPEND_WAIT_STEP));
+        } while (--tries > 0);
+        if (info.state != MX_THREAD_STATE_SUSPENDED)
+            continue;
+
+        general_regs_t regs;
+        uint32_t regs_size = sizeof(regs);
+        if (mx_thread_read_state(threads[i], MX_THREAD_STATE_REGSET0, &regs,
+                                 regs_size, &regs_size) != MX_OK) {
+            continue;
+        }
+
+        uint64_t pcs[MAX_FRAMES];
+        size_t frames = walk_stack(process, &regs, pcs, MAX_FRAMES);
+
+        printf("%" PRIu64, tids[i]);
+        for (size_t f = 0; f < frames; f++) {
+            printf(" %" PRIx64, pcs[f]);
+        }
+        printf("\n");
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+        mx_task_resume(threads[i], 0);
+        mx_handle_close(threads[i]);
+    }
+    return 0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-n samples] [-i interval-ms] <process koid>\n",
+            name);
+    fprintf(stderr, " Samples the user stacks of every thread in the process\n");
+    fprintf(stderr, " (default: 100 samples, 10ms apart).\n");
+}
+
+int main(int argc, char** argv) {
+    int samples = 100;
+    int interval_ms = 10;
+
+    int c;
+    while ((c = getopt(argc, argv, "n:i:")) != -1) {
+        switch (c) {
+        case 'n':
+            samples = atoi(optarg);
+            break;
+        case 'i':
+            interval_ms = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (optind != argc - 1 || samples <= 0 || interval_ms < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    mx_koid_t koid = atoll(argv[optind]);
+    mx_obj_type_t type;
+    mx_handle_t process;
+    mx_status_t status = get_task_by_koid(koid, &type, &process);
+    if (status != MX_OK) {
+        fprintf(stderr, "profile: cannot find task %" PRIu64 ": %d\n",
+                koid, status);
+        return -1;
+    }
+    if (type != MX_OBJ_TYPE_PROCESS) {
+        fprintf(stderr, "profile: task %" PRIu64 " is not a process\n", koid);
+        mx_handle_close(process);
+        return -1;
+    }
+
+    mx_time_t spent = 0;
+    for (int i = 0; i < samples; i++) {
+        mx_time_t start = mx_time_get(MX_CLOCK_MONOTONIC);
+        if (sample_round(process) < 0) {
+            mx_handle_close(process);
+            return -1;
+        }
+        spent += mx_time_get(MX_CLOCK_MONOTONIC) - start;
+        if (interval_ms > 0) {
+            mx_nanosleep(mx_deadline_after(MX_MSEC(interval_ms)));
+        }
+    }
+    fprintf(stderr, "profile: %d rounds, %" PRIu64 "us stopped-time total\n",
+            samples, spent / 1000u);
+
+    mx_handle_close(process);
+    return 0;
+}
@@ -193,3 +193,23 @@ MODULE_STATIC_LIBS := \
     system/ulib/pretty
 
 include make/module.mk
+
+
+MODULE := $(LOCAL_DIR).profile
+
+MODULE_TYPE := userapp
+
+MODULE_SRCS += \
+    $(LOCAL_DIR)/profile.c
+
+MODULE_NAME := profile
+
+MODULE_LIBS := \
+    system/ulib/mxio \
+    system/ulib/magenta \
+    system/ulib/c
+
+MODULE_STATIC_LIBS := \
+    system/ulib/task-utils
+
+include make/module.mk
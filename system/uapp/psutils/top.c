@@ -34,8 +34,9 @@ typedef struct {
     // information about the thread
     mx_koid_t proc_koid;
     mx_koid_t koid;
-    mx_info_thread_t info;
-    mx_info_thread_stats_t stats;
+    uint32_t state;
+    uint32_t wait_exception_port_type;
+    mx_time_t runtime;
     char name[MX_MAX_NAME_LEN];
     char proc_name[MX_MAX_NAME_LEN];
 } thread_info_t;
@@ -53,11 +54,11 @@ static char last_process_name[MX_MAX_NAME_LEN];
 static mx_koid_t last_process_scanned;
 
 // Return text representation of thread state.
-static const char* state_string(const mx_info_thread_t* info) {
-    if (info->wait_exception_port_type != MX_EXCEPTION_PORT_TYPE_NONE) {
+static const char* state_string(const thread_info_t* e) {
+    if (e->wait_exception_port_type != MX_EXCEPTION_PORT_TYPE_NONE) {
         return "excp";
     } else {
-        switch (info->state) {
+        switch (e->state) {
         case MX_THREAD_STATE_NEW:
             return "new";
         case MX_THREAD_STATE_RUNNING:
@@ -76,43 +77,32 @@ static const char* state_string(const mx_info_thread_t* info) {
     }
 }
 
-static mx_status_t process_callback(void* unused_ctx, int depth,
-                                    mx_handle_t proc,
-                                    mx_koid_t koid, mx_koid_t parent_koid) {
-    last_process_scanned = koid;
-
-    mx_status_t status = mx_object_get_property(
-        proc, MX_PROP_NAME, &last_process_name, sizeof(last_process_name));
-    return status;
-}
+// Adds a thread's information to the thread_list. Runs against the
+// MX_INFO_TASK_TREE snapshot, so a whole scan is a single syscall.
+static mx_status_t task_callback(void* unused_ctx, int depth,
+                                 const mx_info_task_tree_entry_t* entry) {
+    if (entry->type == MX_OBJ_TYPE_PROCESS) {
+        // a process's threads follow it in the snapshot
+        last_process_scanned = entry->koid;
+        strlcpy(last_process_name, entry->name, sizeof(last_process_name));
+        return MX_OK;
+    }
+    if (entry->type != MX_OBJ_TYPE_THREAD) {
+        return MX_OK;
+    }
 
-// Adds a thread's information to the thread_list
-static mx_status_t thread_callback(void* unused_ctx, int depth,
-                                   mx_handle_t thread,
-                                   mx_koid_t koid, mx_koid_t parent_koid) {
     thread_info_t e = {};
 
-    e.koid = koid;
+    e.koid = entry->koid;
     e.scanned = true;
 
     e.proc_koid = last_process_scanned;
     strlcpy(e.proc_name, last_process_name, sizeof(e.proc_name));
 
-    mx_status_t status =
-        mx_object_get_property(thread, MX_PROP_NAME, e.name, sizeof(e.name));
-    if (status != MX_OK) {
-        return status;
-    }
-    status = mx_object_get_info(
-        thread, MX_INFO_THREAD, &e.info, sizeof(e.info), NULL, NULL);
-    if (status != MX_OK) {
-        return status;
-    }
-    status = mx_object_get_info(
-        thread, MX_INFO_THREAD_STATS, &e.stats, sizeof(e.stats), NULL, NULL);
-    if (status != MX_OK) {
-        return status;
-    }
+    strlcpy(e.name, entry->name, sizeof(e.name));
+    e.state = entry->state;
+    e.wait_exception_port_type = entry->wait_exception_port_type;
+    e.runtime = entry->runtime;
 
     // see if this thread is in the list
     thread_info_t* temp;
@@ -121,10 +111,10 @@ static mx_status_t thread_callback(void* unused_ctx, int depth,
             // mark it scanned, compute the delta time,
             // and copy the new state over
             temp->scanned = true;
-            temp->delta_time =
-                e.stats.total_runtime - temp->stats.total_runtime;
-            temp->info = e.info;
-            temp->stats = e.stats;
+            temp->delta_time = e.runtime - temp->runtime;
+            temp->state = e.state;
+            temp->wait_exception_port_type = e.wait_exception_port_type;
+            temp->runtime = e.runtime;
             return MX_OK;
         }
     }
@@ -185,11 +175,11 @@ static void print_threads(void) {
                 percent = e->delta_time / (double)delay * 100;
 
             printf("%8lu %8lu %10.2f %5s %s:%s\n",
-                   e->proc_koid, e->koid, percent, state_string(&e->info),
+                   e->proc_koid, e->koid, percent, state_string(e),
                    e->proc_name, e->name);
         } else {
             printf("%8lu %8lu %10lu %5s %s:%s\n",
-                   e->proc_koid, e->koid, e->delta_time, state_string(&e->info),
+                   e->proc_koid, e->koid, e->delta_time, state_string(e),
                    e->proc_name, e->name);
         }
 
@@ -294,10 +284,9 @@ int main(int argc, char** argv) {
         }
 
         // iterate the entire job tree
-        mx_status_t status =
-            walk_root_job_tree(NULL, process_callback, thread_callback, NULL);
+        mx_status_t status = walk_root_job_tree_stats(task_callback, NULL);
         if (status != MX_OK) {
-            fprintf(stderr, "WARNING: walk_root_job_tree failed: %s (%d)\n",
+            fprintf(stderr, "WARNING: walk_root_job_tree_stats failed: %s (%d)\n",
                     mx_status_get_string(status), status);
             ret = 1;
         }
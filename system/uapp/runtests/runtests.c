@@ -9,10 +9,13 @@
 #include <magenta/listnode.h>
 #include <magenta/syscalls.h>
 #include <magenta/syscalls/object.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
+#include <unistd.h>
 
 #include <unittest/unittest.h>
 
@@ -33,17 +36,49 @@ static void fail_test(list_node_t* failures, const char* name, int cause, int rc
 }
 
 enum {
+    TEST_PASSED = -1,
     FAILED_TO_LAUNCH,
     FAILED_TO_WAIT,
     FAILED_TO_RETURN_CODE,
     FAILED_NONZERO_RETURN_CODE,
 };
 
+// One test binary, from discovery through completion. In parallel mode the
+// output of the child is captured through pipes and printed once the test is
+// the next one in launch order, so runs with -j N produce the same merged
+// log every time.
+typedef struct test {
+    list_node_t node;
+
+    int cause; // TEST_PASSED, or one of the failure causes above
+    int rc;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+
+    // captured output (parallel mode only)
+    char* output;
+    size_t output_len;
+    size_t output_cap;
+
+    mx_handle_t proc;
+    int out_fd;
+    int err_fd;
+    thrd_t thread;
+    bool thread_running;
+
+    char name[NAME_MAX + 1];
+    char path[64 + NAME_MAX];
+} test_t;
+
 static list_node_t failures = LIST_INITIAL_VALUE(failures);
+static list_node_t finished_tests = LIST_INITIAL_VALUE(finished_tests);
 
 static int total_count = 0;
 static int failed_count = 0;
 
+// Maximum number of test processes to keep in flight (-j).
+static int jobs = 1;
+
 // We want the default to be the same, whether the test is run by us
 // or run standalone. Do this by leaving the verbosity unspecified unless
 // provided by the user.
@@ -54,6 +89,198 @@ static const char* default_test_groups[] = {
 };
 #define DEFAULT_NUM_TEST_GROUPS 5
 
+static void test_append_output(test_t* test, const char* buf, size_t len) {
+    if (test->output_len + len > test->output_cap) {
+        size_t new_cap = test->output_cap ? test->output_cap * 2 : 4096;
+        while (test->output_len + len > new_cap)
+            new_cap *= 2;
+        test->output = realloc(test->output, new_cap);
+        test->output_cap = new_cap;
+    }
+    memcpy(test->output + test->output_len, buf, len);
+    test->output_len += len;
+}
+
+// Reads the process return code into test->cause / test->rc.
+static void reap_test(test_t* test) {
+    mx_status_t status = mx_object_wait_one(test->proc, MX_PROCESS_TERMINATED,
+                                            MX_TIME_INFINITE, NULL);
+    test->duration_ns = mx_time_get(MX_CLOCK_MONOTONIC) - test->start_ns;
+    if (status != MX_OK) {
+        test->cause = FAILED_TO_WAIT;
+        mx_handle_close(test->proc);
+        return;
+    }
+
+    mx_info_process_t proc_info;
+    status = mx_object_get_info(test->proc, MX_INFO_PROCESS, &proc_info,
+                                sizeof(proc_info), NULL, NULL);
+    mx_handle_close(test->proc);
+
+    if (status < 0) {
+        test->cause = FAILED_TO_RETURN_CODE;
+    } else if (proc_info.return_code == 0) {
+        test->cause = TEST_PASSED;
+    } else {
+        test->cause = FAILED_NONZERO_RETURN_CODE;
+        test->rc = proc_info.return_code;
+    }
+}
+
+// Drains the test's stdout/stderr pipes into its output buffer until both
+// hit EOF, then reaps the process. One of these runs per in-flight test.
+static int test_io_thread(void* arg) {
+    test_t* test = arg;
+    struct pollfd pfds[2] = {
+        {.fd = test->out_fd, .events = POLLIN},
+        {.fd = test->err_fd, .events = POLLIN},
+    };
+    int open_fds = 2;
+    char buf[4096];
+
+    while (open_fds > 0) {
+        if (poll(pfds, 2, -1) <= 0)
+            break;
+        for (int i = 0; i < 2; i++) {
+            if (pfds[i].fd < 0 || !(pfds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            ssize_t n = read(pfds[i].fd, buf, sizeof(buf));
+            if (n <= 0) {
+                close(pfds[i].fd);
+                pfds[i].fd = -1;
+                open_fds--;
+            } else {
+                test_append_output(test, buf, n);
+            }
+        }
+    }
+
+    reap_test(test);
+    return 0;
+}
+
+static mx_status_t launch_test(test_t* test, bool capture_output) {
+    // when the child inherits our stdio, the banner has to go out before
+    // its own output does; captured output gets its banner when merged
+    if (!capture_output && verbosity) {
+        printf(
+            "\n------------------------------------------------\n"
+            "RUNNING TEST: %s\n\n",
+            test->name);
+    }
+
+    char verbose_opt[] = {'v', '=', verbosity + '0', 0};
+    const char* argv[] = {test->path, verbose_opt};
+    int argc = verbosity >= 0 ? 2 : 1;
+
+    launchpad_t* lp;
+    launchpad_create(0, test->path, &lp);
+    launchpad_load_from_file(lp, argv[0]);
+    if (capture_output) {
+        launchpad_clone(lp, LP_CLONE_ALL & ~LP_CLONE_MXIO_STDIO);
+        launchpad_add_pipe(lp, &test->out_fd, STDOUT_FILENO);
+        launchpad_add_pipe(lp, &test->err_fd, STDERR_FILENO);
+    } else {
+        launchpad_clone(lp, LP_CLONE_ALL);
+    }
+    launchpad_set_args(lp, argc, argv);
+
+    test->start_ns = mx_time_get(MX_CLOCK_MONOTONIC);
+    const char* errmsg;
+    mx_status_t status = launchpad_go(lp, &test->proc, &errmsg);
+    if (status < 0) {
+        printf("FAILURE: Failed to launch %s: %d: %s\n", test->name, status, errmsg);
+        test->cause = FAILED_TO_LAUNCH;
+        if (capture_output) {
+            close(test->out_fd);
+            close(test->err_fd);
+        }
+        return status;
+    }
+
+    if (capture_output) {
+        if (thrd_create(&test->thread, test_io_thread, test) != thrd_success) {
+            // fall back to draining in-line when we collect the test
+            test_io_thread(test);
+        } else {
+            test->thread_running = true;
+        }
+    }
+    return MX_OK;
+}
+
+// Records a completed test's verdict and prints its captured output (if
+// any). Called in launch order, so the merged log is deterministic.
+static void process_result(test_t* test) {
+    total_count++;
+    if (jobs > 1 && verbosity) {
+        printf(
+            "\n------------------------------------------------\n"
+            "RUNNING TEST: %s\n\n",
+            test->name);
+    }
+    if (test->output_len) {
+        fwrite(test->output, 1, test->output_len, stdout);
+        free(test->output);
+        test->output = NULL;
+    }
+
+    switch (test->cause) {
+    case TEST_PASSED:
+        printf("PASSED: %s passed\n", test->name);
+        break;
+    case FAILED_TO_LAUNCH:
+        // the launch failure message was already printed
+        fail_test(&failures, test->name, FAILED_TO_LAUNCH, 0);
+        failed_count++;
+        break;
+    case FAILED_TO_WAIT:
+        printf("FAILURE: Failed to wait for process exiting %s\n", test->name);
+        fail_test(&failures, test->name, FAILED_TO_WAIT, 0);
+        failed_count++;
+        break;
+    case FAILED_TO_RETURN_CODE:
+        printf("FAILURE: Failed to get process return code %s\n", test->name);
+        fail_test(&failures, test->name, FAILED_TO_RETURN_CODE, 0);
+        failed_count++;
+        break;
+    case FAILED_NONZERO_RETURN_CODE:
+        printf("FAILED: %s exited with nonzero status: %d\n", test->name, test->rc);
+        fail_test(&failures, test->name, FAILED_NONZERO_RETURN_CODE, test->rc);
+        failed_count++;
+        break;
+    }
+}
+
+// Runs the tests on |pending| keeping up to |jobs| processes in flight.
+// Tests are launched and collected in list order.
+static void run_test_list(list_node_t* pending) {
+    test_t* next_to_launch = list_peek_head_type(pending, test_t, node);
+    test_t* next_to_collect = next_to_launch;
+    int in_flight = 0;
+
+    while (next_to_collect != NULL) {
+        while (next_to_launch != NULL && in_flight < jobs) {
+            if (launch_test(next_to_launch, jobs > 1) == MX_OK)
+                in_flight++;
+            next_to_launch = list_next_type(pending, &next_to_launch->node,
+                                            test_t, node);
+        }
+
+        if (next_to_collect->cause != FAILED_TO_LAUNCH) {
+            if (next_to_collect->thread_running) {
+                thrd_join(next_to_collect->thread, NULL);
+            } else if (jobs == 1) {
+                reap_test(next_to_collect);
+            }
+            in_flight--;
+        }
+        process_result(next_to_collect);
+        next_to_collect = list_next_type(pending, &next_to_collect->node,
+                                         test_t, node);
+    }
+}
+
 static bool run_tests(const char* dirn, const char* test_name) {
     DIR* dir = opendir(dirn);
     if (dir == NULL) {
@@ -61,6 +288,7 @@ static bool run_tests(const char* dirn, const char* test_name) {
     }
 
     int init_failed_count = failed_count;
+    list_node_t pending = LIST_INITIAL_VALUE(pending);
     struct dirent* de;
     struct stat stat_buf;
     while ((de = readdir(dir)) != NULL) {
@@ -74,70 +302,57 @@ static bool run_tests(const char* dirn, const char* test_name) {
             continue;
         }
 
-        total_count++;
-        if (verbosity) {
-            printf(
-                "\n------------------------------------------------\n"
-                "RUNNING TEST: %s\n\n",
-                de->d_name);
-        }
+        test_t* test = calloc(1, sizeof(test_t));
+        strncpy(test->name, de->d_name, NAME_MAX);
+        strcpy(test->path, name);
+        list_add_tail(&pending, &test->node);
+    }
+    closedir(dir);
 
-        char verbose_opt[] = {'v','=', verbosity + '0', 0};
-        const char* argv[] = {name, verbose_opt};
-        int argc = verbosity >= 0 ? 2 : 1;
+    run_test_list(&pending);
 
-        launchpad_t* lp;
-        launchpad_create(0, name, &lp);
-        launchpad_load_from_file(lp, argv[0]);
-        launchpad_clone(lp, LP_CLONE_ALL);
-        launchpad_set_args(lp, argc, argv);
-        const char* errmsg;
-        mx_handle_t handle;
-        mx_status_t status = launchpad_go(lp, &handle, &errmsg);
-        if (status < 0) {
-            printf("FAILURE: Failed to launch %s: %d: %s\n", de->d_name, status, errmsg);
-            fail_test(&failures, de->d_name, FAILED_TO_LAUNCH, 0);
-            failed_count++;
-            continue;
-        }
+    // keep the finished tests around for the time report
+    test_t* test;
+    test_t* temp;
+    list_for_every_entry_safe (&pending, test, temp, test_t, node) {
+        list_delete(&test->node);
+        list_add_tail(&finished_tests, &test->node);
+    }
 
-        status = mx_object_wait_one(handle, MX_PROCESS_TERMINATED,
-                                    MX_TIME_INFINITE, NULL);
-        if (status != MX_OK) {
-            printf("FAILURE: Failed to wait for process exiting %s: %d\n", de->d_name, status);
-            fail_test(&failures, de->d_name, FAILED_TO_WAIT, 0);
-            failed_count++;
-            continue;
-        }
+    return (init_failed_count == failed_count);
+}
 
-        // read the return code
-        mx_info_process_t proc_info;
-        status = mx_object_get_info(handle, MX_INFO_PROCESS, &proc_info, sizeof(proc_info), NULL, NULL);
-        mx_handle_close(handle);
+static int compare_duration(const void* a, const void* b) {
+    const test_t* lhs = *(const test_t* const*)a;
+    const test_t* rhs = *(const test_t* const*)b;
+    return (lhs->duration_ns < rhs->duration_ns) - (lhs->duration_ns > rhs->duration_ns);
+}
 
-        if (status < 0) {
-            printf("FAILURE: Failed to get process return code %s: %d\n", de->d_name, status);
-            fail_test(&failures, de->d_name, FAILED_TO_RETURN_CODE, 0);
-            failed_count++;
-            continue;
-        }
+static void print_time_report(void) {
+    test_t* test;
+    size_t count = 0;
+    list_for_every_entry (&finished_tests, test, test_t, node)
+        count++;
+    if (count == 0)
+        return;
 
-        if (proc_info.return_code == 0) {
-            printf("PASSED: %s passed\n", de->d_name);
-        } else {
-            printf("FAILED: %s exited with nonzero status: %d\n", de->d_name, proc_info.return_code);
-            fail_test(&failures, de->d_name, FAILED_NONZERO_RETURN_CODE, proc_info.return_code);
-            failed_count++;
-        }
-    }
+    test_t** sorted = malloc(count * sizeof(test_t*));
+    size_t i = 0;
+    list_for_every_entry (&finished_tests, test, test_t, node)
+        sorted[i++] = test;
+    qsort(sorted, count, sizeof(test_t*), compare_duration);
 
-    closedir(dir);
-    return (init_failed_count == failed_count);
+    printf("\nTest times (slowest first):\n");
+    for (i = 0; i < count; i++) {
+        printf("%8" PRIu64 " msec: %s\n",
+               sorted[i]->duration_ns / 1000000, sorted[i]->name);
+    }
+    free(sorted);
 }
 
 int usage(char* name) {
     fprintf(stderr,
-            "usage: %s [-q|-v] [-S|-s] [-M|-m] [-L|-l] [-P|-p] [-a] [-t test name] [group ...]\n"
+            "usage: %s [-q|-v] [-S|-s] [-M|-m] [-L|-l] [-P|-p] [-a] [-j jobs] [-t test name] [group ...]\n"
             "\n"
             "The optional [group ...] is a list of test groups to  \n"
             "run. Valid groups are \"core\" \"ddk\" \"sys\" \"fs\" \n"
@@ -156,7 +371,10 @@ int usage(char* name) {
             "   -l: Turn OFF Large tests                           \n"
             "   -P: Turn ON Performance tests    (off by default)  \n"
             "   -p: Turn OFF Performance tests                     \n"
-            "   -a: Turn on All tests                              \n", name);
+            "   -a: Turn on All tests                              \n"
+            "   -j: Run up to N test processes in parallel, with   \n"
+            "       output captured per test and merged in launch  \n"
+            "       order (default: 1)                             \n", name);
     return -1;
 }
 
@@ -193,6 +411,16 @@ int main(int argc, char** argv) {
             test_type |= TEST_ALL;
         } else if (strcmp(argv[i], "-h") == 0) {
             return usage(argv[0]);
+        } else if (strcmp(argv[i], "-j") == 0) {
+            if (i + 1 < argc) {
+                jobs = atoi(argv[i + 1]);
+                if (jobs < 1) {
+                    return usage(argv[0]);
+                }
+                i++;
+            } else {
+                return usage(argv[0]);
+            }
         } else if (strcmp(argv[i], "-t") == 0) {
             if (i + 1 < argc) {
                 test_name = argv[i + 1];
@@ -253,6 +481,8 @@ int main(int argc, char** argv) {
     // It's not catastrophic if we can't unset it; we're just trying to clean up
     unsetenv(TEST_ENV_NAME);
 
+    print_time_report();
+
     printf("\nSUMMARY: Ran %d tests: %d failed\n", total_count, failed_count);
 
     if (failed_count) {
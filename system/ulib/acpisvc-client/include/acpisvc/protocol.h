@@ -22,6 +22,7 @@ enum {
     ACPI_CMD_BST = 6,
     ACPI_CMD_BIF = 7,
     ACPI_CMD_ENABLE_EVENT = 8,
+    ACPI_CMD_LIST_SUBTREE = 9,
 };
 
 typedef struct {
@@ -55,6 +56,17 @@ typedef struct {
 
 static_assert(sizeof(mx_port_packet_t) == sizeof(acpi_event_packet_t), "");
 
+// Identifying information for a single namespace device node.
+typedef struct {
+    // All of these values are non-NULL terminated.  name is a unique
+    // identifier (scoped to the node's parent) that may be used to
+    // request a handle to the node.
+    char name[4];
+    char hid[8];
+    // We return the first 4 PNP/ACPI IDs found in the CID list
+    char cid[4][8];
+} __PACKED acpi_node_info_t;
+
 // List all children of the node associated with the handle used to issue the
 // request.
 typedef struct {
@@ -64,17 +76,33 @@ typedef struct {
     acpi_rsp_hdr_t hdr;
 
     uint32_t num_children;
-    struct {
-        // All of these values are non-NULL terminated.  name is a unique
-        // identifier (scoped to the handle associated with the request)
-        // that may be used to request a handle to a child below.
-        char name[4];
-        char hid[8];
-        // We return the first 4 PNP/ACPI IDs found in the CID list
-        char cid[4][8];
-    } children[];
+    acpi_node_info_t children[];
 } __PACKED acpi_rsp_list_children_t;
 
+// List every device node in the subtree rooted at the node associated with
+// the handle used to issue the request, in depth-first pre-order.  This
+// returns the same information as issuing LIST_CHILDREN at each level of
+// the subtree, in a single round-trip.
+typedef struct {
+    acpi_cmd_hdr_t hdr;
+
+    // Maximum depth to descend; nodes with depth >= max_depth are omitted.
+    // 0 means no limit.
+    uint32_t max_depth;
+} __PACKED acpi_cmd_list_subtree_t;
+typedef struct {
+    acpi_rsp_hdr_t hdr;
+
+    uint32_t num_nodes;
+    struct {
+        acpi_node_info_t info;
+        // Number of ancestors between this node and the queried node;
+        // immediate children have depth 0.  Since nodes are in pre-order,
+        // a node's parent is the nearest preceding node of smaller depth.
+        uint32_t depth;
+    } __PACKED nodes[];
+} __PACKED acpi_rsp_list_subtree_t;
+
 // Request a handle to a child node by name.
 typedef struct {
     acpi_cmd_hdr_t hdr;
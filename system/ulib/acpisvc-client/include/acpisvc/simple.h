@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <stdlib.h>
 #include <threads.h>
 
 #include <acpisvc/protocol.h>
@@ -20,17 +21,26 @@ typedef struct {
     mx_handle_t pipe;
     mtx_t lock;
     uint32_t next_req_id;
+    // Cached LIST_CHILDREN response.  The namespace topology and device
+    // ids are immutable for the life of the service, so the first
+    // response is reused for all later calls on this handle.
+    void* children_cache;
+    size_t children_cache_len;
 } acpi_handle_t;
 
 static void acpi_handle_init(acpi_handle_t* h, mx_handle_t pipe) {
     h->pipe = pipe;
     h->lock = (mtx_t)MTX_INIT;
     h->next_req_id = 0;
+    h->children_cache = NULL;
+    h->children_cache_len = 0;
 }
 
 static void acpi_handle_close(acpi_handle_t* h) {
     mtx_lock(&h->lock);
     mx_handle_close(h->pipe);
+    free(h->children_cache);
+    h->children_cache = NULL;
     mtx_unlock(&h->lock);
 }
 
@@ -46,6 +56,16 @@ mx_handle_t acpi_clone_handle(acpi_handle_t* h);
 mx_status_t acpi_list_children(acpi_handle_t* h,
                                acpi_rsp_list_children_t** rsp, size_t* len);
 
+// List every device node in the subtree below the ACPI node, in depth-first
+// pre-order, using a single round-trip to the service.
+//
+// *max_depth* limits how far to descend; 0 means no limit.
+// *rsp* is a pointer to store the response into.  The response can be released
+// with free().
+// *len* is a pointer to store the length of the response into
+mx_status_t acpi_list_subtree(acpi_handle_t* h, uint32_t max_depth,
+                              acpi_rsp_list_subtree_t** rsp, size_t* len);
+
 // Get a handle to the specified child of the ACPI node.
 //
 // *name* is a 4-character name returned from list_children().
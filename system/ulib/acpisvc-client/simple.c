@@ -169,6 +169,23 @@ exit:
 mx_status_t acpi_list_children(acpi_handle_t* h,
                                acpi_rsp_list_children_t** response, size_t* len) {
 
+    // The child list of a node never changes, so answer from the cache
+    // if we have already asked the service.
+    mtx_lock(&h->lock);
+    if (h->children_cache != NULL) {
+        acpi_rsp_list_children_t* copy = malloc(h->children_cache_len);
+        if (copy == NULL) {
+            mtx_unlock(&h->lock);
+            return MX_ERR_NO_MEMORY;
+        }
+        memcpy(copy, h->children_cache, h->children_cache_len);
+        *response = copy;
+        *len = h->children_cache_len;
+        mtx_unlock(&h->lock);
+        return MX_OK;
+    }
+    mtx_unlock(&h->lock);
+
     acpi_cmd_list_children_t cmd = {
         .hdr = {
             .version = 0,
@@ -191,6 +208,49 @@ mx_status_t acpi_list_children(acpi_handle_t* h,
         return MX_ERR_BAD_STATE;
     }
 
+    mtx_lock(&h->lock);
+    if (h->children_cache == NULL) {
+        void* cache = malloc(rsp_len);
+        if (cache != NULL) {
+            memcpy(cache, rsp, rsp_len);
+            h->children_cache = cache;
+            h->children_cache_len = rsp_len;
+        }
+        // failing to populate the cache is not an error
+    }
+    mtx_unlock(&h->lock);
+
+    *response = rsp;
+    *len = rsp_len;
+    return MX_OK;
+}
+
+mx_status_t acpi_list_subtree(acpi_handle_t* h, uint32_t max_depth,
+                              acpi_rsp_list_subtree_t** response, size_t* len) {
+
+    acpi_cmd_list_subtree_t cmd = {
+        .hdr = {
+            .version = 0,
+            .cmd = ACPI_CMD_LIST_SUBTREE,
+            .len = sizeof(cmd),
+        },
+        .max_depth = max_depth,
+    };
+
+    acpi_rsp_list_subtree_t* rsp;
+    size_t rsp_len;
+    mx_status_t status =
+        run_txn(h, &cmd, sizeof(cmd), (void**)&rsp, &rsp_len, 0, NULL, 0);
+    if (status != MX_OK) {
+        return status;
+    }
+
+    // Validate the response
+    if (rsp_len != sizeof(*rsp) + sizeof(rsp->nodes[0]) * rsp->num_nodes) {
+        free(rsp);
+        return MX_ERR_BAD_STATE;
+    }
+
     *response = rsp;
     *len = rsp_len;
     return MX_OK;
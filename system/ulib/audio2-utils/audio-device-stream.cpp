@@ -516,7 +516,74 @@ mx_status_t AudioDeviceStream::StopRingBuffer() {
     return DoCall(rb_ch_, req, &resp);
 }
 
+mx_status_t AudioDeviceStream::GetPositionBuffer() {
+    mx_status_t res;
+
+    if (!rb_ch_.is_valid())
+        return MX_ERR_BAD_STATE;
+
+    if (pos_buf_ != nullptr)
+        return MX_OK;
+
+    audio2_rb_cmd_get_position_vmo_req_t  req;
+    audio2_rb_cmd_get_position_vmo_resp_t resp;
+
+    req.hdr.cmd = AUDIO2_RB_CMD_GET_POSITION_VMO;
+    req.hdr.transaction_id = 1;
+
+    mx::handle tmp;
+    res = DoCall(rb_ch_, req, &resp, &tmp);
+    if (res != MX_OK) {
+        printf("Failed to fetch position buffer VMO (res %d)\n", res);
+        return res;
+    }
+
+    pos_vmo_.reset(tmp.release());
+
+    uintptr_t tmp_addr;
+    res = mx_vmar_map(mx_vmar_root_self(), 0, pos_vmo_.get(), 0,
+                      sizeof(audio2_rb_position_buffer_t),
+                      MX_VM_FLAG_PERM_READ, &tmp_addr);
+    if (res != MX_OK) {
+        printf("Failed to map position buffer VMO (res %d)\n", res);
+        pos_vmo_.reset();
+        return res;
+    }
+
+    pos_buf_ = reinterpret_cast<const volatile audio2_rb_position_buffer_t*>(tmp_addr);
+    return MX_OK;
+}
+
+bool AudioDeviceStream::GetPosition(uint32_t* out_pos, mx_time_t* out_timestamp) const {
+    if ((pos_buf_ == nullptr) || (out_pos == nullptr) || (out_timestamp == nullptr))
+        return false;
+
+    // Sequence-locked read; the driver holds seq odd while updating.  Give up
+    // after a few attempts rather than spinning forever on a wedged driver.
+    for (uint32_t attempt = 0; attempt < 100; ++attempt) {
+        uint32_t seq = pos_buf_->seq;
+        if (seq & 1u)
+            continue;
+        uint32_t  pos  = pos_buf_->ring_buffer_pos;
+        mx_time_t time = pos_buf_->timestamp;
+        if (pos_buf_->seq == seq) {
+            *out_pos = pos;
+            *out_timestamp = time;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void AudioDeviceStream::ResetRingBuffer() {
+    if (pos_buf_ != nullptr) {
+        mx_vmar_unmap(mx_vmar_root_self(),
+                      reinterpret_cast<uintptr_t>(pos_buf_),
+                      sizeof(audio2_rb_position_buffer_t));
+        pos_buf_ = nullptr;
+    }
+    pos_vmo_.reset();
     rb_ch_.reset();
     rb_vmo_.reset();
     rb_sz_ = 0;
@@ -24,10 +24,16 @@ public:
                           uint16_t channels,
                           audio2_sample_format_t sample_format);
     mx_status_t GetBuffer(uint32_t frames, uint32_t irqs_per_ring);
+    mx_status_t GetPositionBuffer();
     mx_status_t StartRingBuffer();
     mx_status_t StopRingBuffer();
     void        ResetRingBuffer();
 
+    // Read the driver's shared position register without any syscalls.
+    // GetPositionBuffer() must have succeeded first.  Returns false if no
+    // position buffer is mapped or a consistent snapshot could not be taken.
+    bool GetPosition(uint32_t* out_pos, mx_time_t* out_timestamp) const;
+
     bool IsStreamBufChannelConnected() const { return IsChannelConnected(stream_ch_); }
     bool IsRingBufChannelConnected() const { return IsChannelConnected(rb_ch_); }
 
@@ -58,6 +64,7 @@ protected:
     mx::channel stream_ch_;
     mx::channel rb_ch_;
     mx::vmo     rb_vmo_;
+    mx::vmo     pos_vmo_;
 
     const bool  input_;
     char        name_[64] = { 0 };
@@ -71,6 +78,7 @@ protected:
     uint64_t start_ticks_ = 0;
     uint32_t rb_sz_       = 0;
     void*    rb_virt_     = nullptr;
+    const volatile audio2_rb_position_buffer_t* pos_buf_ = nullptr;
 };
 
 }  // namespace utils
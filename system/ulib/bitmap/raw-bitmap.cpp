@@ -76,22 +76,28 @@ size_t RawBitmapBase::Scan(size_t bitoff, size_t bitmax, bool is_set) const {
     }
     size_t first_idx = FirstIdx(bitoff);
     size_t last_idx = LastIdx(bitmax);
+    // XORing with all ones when scanning for set bits reduces both cases to
+    // "find the first non-zero masked word".
+    size_t invert = 0;
+    if (is_set) {
+        invert = ~invert;
+    }
+    // Check the first (possibly partial) word.
     size_t i = first_idx;
-    size_t value = 0;
-    for (i = first_idx; i <= last_idx; ++i) {
-        value = GetMask(i == first_idx, i == last_idx, bitoff, bitmax);
-        if (is_set) {
-            // If is_set=true, invert the mask, OR it with the value, and invert
-            // it again to hopefully get all zeros.
-            value = ~(~value | data_[i]);
-        } else {
-            // If is_set=false, just AND the mask with the value to hopefully
-            // get all zeros.
-            value &= data_[i];
-        }
-        if (value != 0) {
-            break;
+    size_t value = (data_[i] ^ invert) &
+            GetMask(true, i == last_idx, bitoff, bitmax);
+    if (value == 0 && i < last_idx) {
+        // Whole words between the first and last need no masking; skip over
+        // matching words with a simple compare.  This tight loop is the hot
+        // path when scanning large bitmaps and lets the compiler unroll and
+        // vectorize the search.
+        for (++i; i < last_idx; ++i) {
+            if (data_[i] != invert) {
+                break;
+            }
         }
+        value = (data_[i] ^ invert) &
+                GetMask(false, i == last_idx, bitoff, bitmax);
     }
     return mxtl::min(bitmax, CountZeros(i, value));
 }
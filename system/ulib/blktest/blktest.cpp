@@ -232,6 +232,182 @@ bool blkdev_test_fifo_basic(void) {
     END_TEST;
 }
 
+bool blkdev_test_fifo_coalescing(void) {
+    BEGIN_TEST;
+    uint64_t blk_size, blk_count;
+    // Set up the initial handshake connection with the blkdev
+    int fd = get_testdev(&blk_size, &blk_count);
+    mx_handle_t fifo;
+    ssize_t expected = sizeof(fifo);
+    ASSERT_EQ(ioctl_block_get_fifos(fd, &fifo), expected, "Failed to get FIFO");
+    txnid_t txnid;
+    expected = sizeof(txnid_t);
+    ASSERT_EQ(ioctl_block_alloc_txn(fd, &txnid), expected, "Failed to allocate txn");
+
+    // Create an arbitrary VMO, fill it with some stuff
+    uint64_t vmo_size = PAGE_SIZE * 4;
+    mx_handle_t vmo;
+    ASSERT_EQ(mx_vmo_create(vmo_size, 0, &vmo), MX_OK, "Failed to create VMO");
+    AllocChecker ac;
+    mxtl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check(), "");
+    fill_random(buf.get(), vmo_size);
+
+    size_t actual;
+    ASSERT_EQ(mx_vmo_write(vmo, buf.get(), 0, vmo_size, &actual), MX_OK, "");
+
+    vmoid_t vmoid;
+    expected = sizeof(vmoid_t);
+    mx_handle_t xfer_vmo;
+    ASSERT_EQ(mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &xfer_vmo), MX_OK, "");
+    ASSERT_EQ(ioctl_block_attach_vmo(fd, &xfer_vmo, &vmoid), expected,
+              "Failed to attach vmo");
+
+    // Write the VMO as three contiguous requests issued out of order, plus
+    // one discontiguous request; with coalescing enabled the contiguous run
+    // should be merged and sorted, with identical results on disk.
+    block_fifo_request_t requests[4];
+    for (size_t i = 0; i < mxtl::count_of(requests); i++) {
+        requests[i].txnid  = txnid;
+        requests[i].vmoid  = vmoid;
+        requests[i].opcode = BLOCKIO_WRITE;
+        requests[i].length = blk_size;
+    }
+    requests[0].vmo_offset = blk_size * 2;
+    requests[0].dev_offset = blk_size * 2;
+    requests[1].vmo_offset = 0;
+    requests[1].dev_offset = 0;
+    requests[2].vmo_offset = blk_size;
+    requests[2].dev_offset = blk_size;
+    requests[3].vmo_offset = blk_size * 3;
+    requests[3].dev_offset = blk_size * 100;
+
+    fifo_client_t* client;
+    ASSERT_EQ(block_fifo_create_client(fifo, &client), MX_OK, "");
+    block_fifo_set_coalescing(client, true);
+    ASSERT_EQ(block_fifo_txn(client, &requests[0], mxtl::count_of(requests)), MX_OK, "");
+
+    // Empty the vmo, then read everything back and verify it
+    mxtl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[vmo_size]());
+    ASSERT_TRUE(ac.check(), "");
+    ASSERT_EQ(mx_vmo_write(vmo, out.get(), 0, vmo_size, &actual), MX_OK, "");
+    for (size_t i = 0; i < mxtl::count_of(requests); i++) {
+        requests[i].opcode = BLOCKIO_READ;
+    }
+    ASSERT_EQ(block_fifo_txn(client, &requests[0], mxtl::count_of(requests)), MX_OK, "");
+    ASSERT_EQ(mx_vmo_read(vmo, out.get(), 0, vmo_size, &actual), MX_OK, "");
+    ASSERT_EQ(memcmp(buf.get(), out.get(), blk_size * 4), 0,
+              "Read data not equal to written data");
+
+    ASSERT_EQ(mx_handle_close(vmo), MX_OK, "");
+    block_fifo_release_client(client);
+    ASSERT_EQ(ioctl_block_fifo_close(fd), MX_OK, "Failed to close fifo");
+    close(fd);
+    END_TEST;
+}
+
+bool blkdev_test_mq_basic(void) {
+    BEGIN_TEST;
+    uint64_t blk_size, blk_count;
+    // Set up the initial handshake connection with the blkdev
+    int fd = get_testdev(&blk_size, &blk_count);
+
+    // Every block device supports at least one queue; requesting a fifo
+    // beyond the advertised count should fail.
+    uint32_t queue_count;
+    ssize_t expected = sizeof(queue_count);
+    ASSERT_EQ(ioctl_block_mq_get_queue_count(fd, &queue_count), expected,
+              "Failed to get queue count");
+    ASSERT_GE(queue_count, 1u, "Expected at least one queue");
+    mx_handle_t bad_fifo;
+    ASSERT_LT(ioctl_block_mq_get_fifo(fd, &queue_count, &bad_fifo), 0,
+              "Expected failure for out of range queue");
+
+    // Acquire a fifo, txn, and vmoid on each queue.
+    mx_handle_t fifos[MAX_BLOCK_MQ_QUEUES];
+    txnid_t txnids[MAX_BLOCK_MQ_QUEUES];
+    vmoid_t vmoids[MAX_BLOCK_MQ_QUEUES];
+
+    // Create an arbitrary VMO, fill it with some stuff
+    uint64_t vmo_size = PAGE_SIZE * 3;
+    mx_handle_t vmo;
+    ASSERT_EQ(mx_vmo_create(vmo_size, 0, &vmo), MX_OK, "Failed to create VMO");
+    AllocChecker ac;
+    mxtl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check(), "");
+    fill_random(buf.get(), vmo_size);
+    size_t actual;
+    ASSERT_EQ(mx_vmo_write(vmo, buf.get(), 0, vmo_size, &actual), MX_OK, "");
+
+    for (uint32_t queue = 0; queue < queue_count; queue++) {
+        expected = sizeof(mx_handle_t);
+        ASSERT_EQ(ioctl_block_mq_get_fifo(fd, &queue, &fifos[queue]), expected,
+                  "Failed to get queue FIFO");
+        expected = sizeof(txnid_t);
+        ASSERT_EQ(ioctl_block_mq_alloc_txn(fd, &queue, &txnids[queue]), expected,
+                  "Failed to allocate txn");
+
+        block_mq_attach_vmo_args_t args;
+        ASSERT_EQ(mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &args.vmo), MX_OK, "");
+        args.queue = queue;
+        expected = sizeof(vmoid_t);
+        ASSERT_EQ(ioctl_block_mq_attach_vmo(fd, &args, &vmoids[queue]), expected,
+                  "Failed to attach vmo");
+    }
+
+    mq_client_t* client;
+    ASSERT_EQ(block_mq_create_client(fifos, queue_count, &client), MX_OK, "");
+    ASSERT_EQ(block_mq_queue_count(client), queue_count, "");
+
+    // Write the VMO to a distinct region of the disk through each queue,
+    // then read each region back and verify it.
+    for (uint32_t queue = 0; queue < queue_count; queue++) {
+        block_fifo_request_t request;
+        request.txnid      = txnids[queue];
+        request.vmoid      = vmoids[queue];
+        request.opcode     = BLOCKIO_WRITE;
+        request.length     = blk_size;
+        request.vmo_offset = 0;
+        request.dev_offset = blk_size * 10 * queue;
+        ASSERT_EQ(block_mq_txn(client, queue, &request, 1), MX_OK, "");
+    }
+
+    mxtl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[vmo_size]());
+    ASSERT_TRUE(ac.check(), "");
+    for (uint32_t queue = 0; queue < queue_count; queue++) {
+        ASSERT_EQ(mx_vmo_write(vmo, out.get(), 0, vmo_size, &actual), MX_OK, "");
+        block_fifo_request_t request;
+        request.txnid      = txnids[queue];
+        request.vmoid      = vmoids[queue];
+        request.opcode     = BLOCKIO_READ;
+        request.length     = blk_size;
+        request.vmo_offset = 0;
+        request.dev_offset = blk_size * 10 * queue;
+        ASSERT_EQ(block_mq_txn(client, queue, &request, 1), MX_OK, "");
+        ASSERT_EQ(mx_vmo_read(vmo, out.get(), 0, vmo_size, &actual), MX_OK, "");
+        ASSERT_EQ(memcmp(buf.get(), out.get(), blk_size), 0,
+                  "Read data not equal to written data");
+    }
+
+    // Requests on an out of range queue should fail without touching the device
+    block_fifo_request_t request;
+    request.txnid = txnids[0];
+    request.vmoid = vmoids[0];
+    request.opcode = BLOCKIO_READ;
+    request.length = blk_size;
+    request.vmo_offset = 0;
+    request.dev_offset = 0;
+    ASSERT_EQ(block_mq_txn(client, queue_count, &request, 1), MX_ERR_OUT_OF_RANGE, "");
+
+    ASSERT_EQ(mx_handle_close(vmo), MX_OK, "");
+    block_mq_release_client(client);
+    for (uint32_t queue = 0; queue < queue_count; queue++) {
+        ASSERT_EQ(ioctl_block_mq_fifo_close(fd, &queue), MX_OK, "Failed to close fifo");
+    }
+    close(fd);
+    END_TEST;
+}
+
 bool blkdev_test_fifo_whole_disk(void) {
     BEGIN_TEST;
     uint64_t blk_size, blk_count;
@@ -902,6 +1078,8 @@ RUN_TEST(blkdev_test_multiple)
 #endif
 RUN_TEST(blkdev_test_fifo_no_op)
 RUN_TEST(blkdev_test_fifo_basic)
+RUN_TEST(blkdev_test_fifo_coalescing)
+RUN_TEST(blkdev_test_mq_basic)
 //RUN_TEST(blkdev_test_fifo_whole_disk)
 RUN_TEST(blkdev_test_fifo_multiple_vmo)
 RUN_TEST(blkdev_test_fifo_multiple_vmo_multithreaded)
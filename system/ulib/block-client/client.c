@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <assert.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <magenta/compiler.h>
@@ -68,9 +69,39 @@ typedef struct block_completion {
 
 typedef struct fifo_client {
     mx_handle_t fifo;
+    bool coalesce;
     block_completion_t txns[MAX_TXN_COUNT];
 } fifo_client_t;
 
+// Sorts 'requests' by device offset (insertion sort; batches are at most
+// MAX_TXN_MESSAGES entries), then merges entries which target contiguous
+// device and vmo ranges of the same vmoid. Returns the merged count.
+static size_t coalesce_requests(block_fifo_request_t* requests, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        block_fifo_request_t tmp = requests[i];
+        size_t j = i;
+        while (j > 0 && requests[j - 1].dev_offset > tmp.dev_offset) {
+            requests[j] = requests[j - 1];
+            j--;
+        }
+        requests[j] = tmp;
+    }
+
+    size_t out = 0;
+    for (size_t i = 1; i < count; i++) {
+        block_fifo_request_t* prev = &requests[out];
+        block_fifo_request_t* cur = &requests[i];
+        if ((prev->vmoid == cur->vmoid) &&
+            (prev->dev_offset + prev->length == cur->dev_offset) &&
+            (prev->vmo_offset + prev->length == cur->vmo_offset)) {
+            prev->length += cur->length;
+        } else {
+            requests[++out] = *cur;
+        }
+    }
+    return out + 1;
+}
+
 mx_status_t block_fifo_create_client(mx_handle_t fifo, fifo_client_t** out) {
     fifo_client_t* client = calloc(sizeof(fifo_client_t), 1);
     if (client == NULL) {
@@ -90,6 +121,10 @@ void block_fifo_release_client(fifo_client_t* client) {
     free(client);
 }
 
+void block_fifo_set_coalescing(fifo_client_t* client, bool enabled) {
+    client->coalesce = enabled;
+}
+
 mx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests, size_t count) {
     if (count == 0) {
         return MX_OK;
@@ -108,6 +143,28 @@ mx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests
         requests[i].opcode = (requests[i].opcode & BLOCKIO_OP_MASK) |
                              (i == count - 1 ? BLOCKIO_TXN_END : 0);
     }
+
+    // If coalescing is enabled for this client and every request in the batch
+    // is the same data-moving op, sort and merge a copy of the batch before
+    // submission. The server responds once per txn regardless of how many
+    // requests compose it, so shrinking the batch is invisible to the caller.
+    block_fifo_request_t coalesced[MAX_TXN_MESSAGES];
+    if (client->coalesce && count > 1) {
+        uint16_t op = requests[0].opcode & BLOCKIO_OP_MASK;
+        bool eligible = (op == BLOCKIO_READ) || (op == BLOCKIO_WRITE);
+        for (size_t i = 1; eligible && i < count; i++) {
+            eligible = (requests[i].opcode & BLOCKIO_OP_MASK) == op;
+        }
+        if (eligible) {
+            memcpy(coalesced, requests, count * sizeof(block_fifo_request_t));
+            count = coalesce_requests(coalesced, count);
+            for (size_t i = 0; i < count; i++) {
+                coalesced[i].opcode = op | (i == count - 1 ? BLOCKIO_TXN_END : 0);
+            }
+            requests = coalesced;
+        }
+    }
+
     if ((status = do_write(client->fifo, &requests[0], count)) != MX_OK) {
         return status;
     }
@@ -129,3 +186,65 @@ mx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests
 
     return client->txns[txnid].status;
 }
+
+typedef struct mq_client {
+    uint32_t queue_count;
+    fifo_client_t* queues[];
+} mq_client_t;
+
+mx_status_t block_mq_create_client(const mx_handle_t* fifos, uint32_t count, mq_client_t** out) {
+    if (count == 0) {
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    mq_client_t* client = calloc(sizeof(mq_client_t) + count * sizeof(fifo_client_t*), 1);
+    if (client == NULL) {
+        for (uint32_t i = 0; i < count; i++) {
+            mx_handle_close(fifos[i]);
+        }
+        return MX_ERR_NO_MEMORY;
+    }
+    client->queue_count = count;
+
+    mx_status_t status = MX_OK;
+    for (uint32_t i = 0; i < count; i++) {
+        if (status == MX_OK) {
+            status = block_fifo_create_client(fifos[i], &client->queues[i]);
+        }
+        if (status != MX_OK && client->queues[i] == NULL) {
+            // A per-queue client takes ownership of its fifo on success;
+            // once something has failed, close the remaining fifos ourselves.
+            mx_handle_close(fifos[i]);
+        }
+    }
+    if (status != MX_OK) {
+        block_mq_release_client(client);
+        return status;
+    }
+
+    *out = client;
+    return MX_OK;
+}
+
+void block_mq_release_client(mq_client_t* client) {
+    if (client == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < client->queue_count; i++) {
+        block_fifo_release_client(client->queues[i]);
+    }
+    free(client);
+}
+
+uint32_t block_mq_queue_count(mq_client_t* client) {
+    return client->queue_count;
+}
+
+mx_status_t block_mq_txn(mq_client_t* client, uint32_t queue,
+                         block_fifo_request_t* requests, size_t count) {
+    if (queue >= client->queue_count) {
+        return MX_ERR_OUT_OF_RANGE;
+    }
+    return block_fifo_txn(client->queues[queue], requests, count);
+}
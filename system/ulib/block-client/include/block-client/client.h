@@ -21,6 +21,15 @@ mx_status_t block_fifo_create_client(mx_handle_t fifo, fifo_client_t** out);
 // Frees a block fifo client
 void block_fifo_release_client(fifo_client_t* client);
 
+// Enables (or disables) request coalescing on the client; off by default.
+// When enabled, batches passed to block_fifo_txn in which every request is
+// a read (or every request is a write) are sorted by device offset and
+// contiguous runs are merged into single larger requests before fifo
+// submission, cutting per-op overhead for callers which issue many small
+// adjacent operations. Since requests within a txn carry no ordering
+// guarantee, completion semantics are unchanged.
+void block_fifo_set_coalescing(fifo_client_t* client, bool enabled);
+
 // Sends 'count' block device requests and waits for a response.
 // The current implementation is thread-safe, but may only be called from a
 // single process, as it differentiates callers by stack addresses (in an
@@ -37,4 +46,26 @@ void block_fifo_release_client(fifo_client_t* client);
 // dev_offset                               read, write
 mx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests, size_t count);
 
+typedef struct mq_client mq_client_t;
+
+// Allocates a multi-queue block fifo client from 'count' fifos, one per
+// queue, as acquired from IOCTL_BLOCK_MQ_GET_FIFO. Each queue is an
+// independent fifo_client_t; threads which send transactions on distinct
+// queues share no state on the submission path, so giving each thread its
+// own queue (and its own txnids/vmoids, which are per-queue) scales with
+// cores. Takes ownership of the fifos, even on failure.
+mx_status_t block_mq_create_client(const mx_handle_t* fifos, uint32_t count, mq_client_t** out);
+
+// Frees a multi-queue block fifo client (and all its per-queue clients)
+void block_mq_release_client(mq_client_t* client);
+
+// Returns the number of queues the client was created with
+uint32_t block_mq_queue_count(mq_client_t* client);
+
+// Sends 'count' block device requests on the given queue and waits for a
+// response; see block_fifo_txn for the per-request requirements. The
+// requests' txnid must have been allocated on the same queue.
+mx_status_t block_mq_txn(mq_client_t* client, uint32_t queue,
+                         block_fifo_request_t* requests, size_t count);
+
 __END_CDECLS
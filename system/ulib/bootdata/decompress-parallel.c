@@ -0,0 +1,281 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <bootdata/decompress.h>
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <magenta/boot/bootdata.h>
+#include <magenta/compiler.h>
+#include <magenta/syscalls.h>
+
+#include <lz4/lz4.h>
+
+#include "private.h"
+
+// Parallel counterpart to decompress_bootdata, for callers which can use
+// threads (userboot cannot; it compiles only decompress.c).  The frames
+// written by mkbootfs use independent 64kB blocks, so each block can be
+// decoded on its own; we fan the blocks out across one worker per CPU.
+//
+// Every block but the last must decompress to exactly 64kB for the
+// output placement to be computed up front.  That holds for frames
+// produced by sequential LZ4F compression (as mkbootfs does), but is not
+// required by the frame format itself, so a mid-stream short block makes
+// this function fail and the caller should fall back to the serial path.
+
+#define MAX_WORKERS 8
+
+typedef struct {
+    const uint8_t* src;
+    uint8_t* dst;
+    uint32_t src_size;
+    uint32_t dst_size;
+    bool raw; // block is stored uncompressed
+} lz4_block_t;
+
+typedef struct {
+    lz4_block_t* blocks;
+    size_t count;
+    atomic_size_t next;
+    atomic_bool failed;
+} lz4_work_t;
+
+static int decompress_worker(void* arg) {
+    lz4_work_t* work = arg;
+    for (;;) {
+        size_t i = atomic_fetch_add(&work->next, 1);
+        if (i >= work->count) {
+            return 0;
+        }
+        lz4_block_t* b = &work->blocks[i];
+        if (b->raw) {
+            if (b->src_size != b->dst_size) {
+                atomic_store(&work->failed, true);
+                return 0;
+            }
+            memcpy(b->dst, b->src, b->src_size);
+        } else {
+            int dcmp = LZ4_decompress_safe((const char*)b->src, (char*)b->dst,
+                                           b->src_size, b->dst_size);
+            if (dcmp != (int)b->dst_size) {
+                atomic_store(&work->failed, true);
+                return 0;
+            }
+        }
+    }
+}
+
+static mx_status_t decompress_bootfs_vmo_parallel(mx_handle_t vmar,
+                                                  const uint8_t* data,
+                                                  size_t length,
+                                                  mx_handle_t* out,
+                                                  const char** err) {
+    const bootdata_t* hdr = (bootdata_t*)data;
+    const uint8_t* end = data + length;
+
+    // Skip past the bootdata header
+    data += sizeof(bootdata_t);
+
+    if (*(const uint32_t*)data != MX_LZ4_MAGIC) {
+        *err = "bad magic number for compressed bootfs";
+        return MX_ERR_INVALID_ARGS;
+    }
+    data += sizeof(uint32_t);
+
+    size_t newsize = hdr->extra;
+    mx_status_t status = check_lz4_frame((const lz4_frame_desc*)data,
+                                         newsize - sizeof(bootdata_t), err);
+    if (status < 0) {
+        return status;
+    }
+    data += sizeof(lz4_frame_desc);
+
+    newsize = (newsize + 4095) & ~4095;
+    if (newsize < hdr->extra) {
+        // newsize wrapped, which means the outsize was too large
+        *err = "lz4 output size too large";
+        return MX_ERR_NO_MEMORY;
+    }
+
+    // Walk the block headers to find where each block lives in the
+    // source; output offsets follow from the 64kB block size.
+    size_t content = hdr->extra - sizeof(bootdata_t);
+    size_t count = (content + MX_LZ4_BLOCK_SIZE - 1) / MX_LZ4_BLOCK_SIZE;
+    lz4_block_t* blocks = malloc(count * sizeof(lz4_block_t));
+    if (blocks == NULL) {
+        *err = "out of memory for lz4 block table";
+        return MX_ERR_NO_MEMORY;
+    }
+
+    size_t n = 0;
+    size_t remaining = content;
+    for (;;) {
+        if (end - data < (ptrdiff_t)sizeof(uint32_t)) {
+            *err = "lz4 block truncated";
+            goto fail_blocks;
+        }
+        uint32_t blocksize = *(const uint32_t*)data;
+        data += sizeof(uint32_t);
+        if (blocksize == 0) {
+            break;
+        }
+        // If the data is uncompressed, the high bit is 1.
+        bool raw = (blocksize >> 31) != 0;
+        blocksize &= 0x7fffffff;
+        if ((size_t)(end - data) < blocksize) {
+            *err = "lz4 block truncated";
+            goto fail_blocks;
+        }
+        if (n == count || remaining == 0) {
+            *err = "more lz4 blocks than the content size allows";
+            goto fail_blocks;
+        }
+        blocks[n].src = data;
+        blocks[n].src_size = blocksize;
+        blocks[n].dst_size = (remaining < MX_LZ4_BLOCK_SIZE)
+                                 ? remaining : MX_LZ4_BLOCK_SIZE;
+        blocks[n].raw = raw;
+        remaining -= blocks[n].dst_size;
+        n++;
+        data += blocksize;
+    }
+    if (n != count || remaining != 0) {
+        *err = "lz4 block count does not match bootdata outsize";
+        goto fail_blocks;
+    }
+
+    mx_handle_t dst_vmo;
+    status = mx_vmo_create((uint64_t)newsize, 0, &dst_vmo);
+    if (status < 0) {
+        *err = "mx_vmo_create failed for decompressing bootfs";
+        free(blocks);
+        return status;
+    }
+    mx_object_set_property(dst_vmo, MX_PROP_NAME, "bootfs", 6);
+
+    uintptr_t dst_addr = 0;
+    status = mx_vmar_map(vmar, 0, dst_vmo, 0, newsize,
+            MX_VM_FLAG_PERM_READ|MX_VM_FLAG_PERM_WRITE, &dst_addr);
+    if (status < 0) {
+        *err = "mx_vmar_map failed on bootfs vmo during decompression";
+        mx_handle_close(dst_vmo);
+        free(blocks);
+        return status;
+    }
+
+    bootdata_t* boothdr = (bootdata_t*)dst_addr;
+    // Copy the bootdata header but mark it as not compressed
+    *boothdr = *hdr;
+    boothdr->length = hdr->extra;
+    boothdr->flags &= ~BOOTDATA_BOOTFS_FLAG_COMPRESSED;
+
+    uint8_t* dst = (uint8_t*)dst_addr + sizeof(bootdata_t);
+    for (size_t i = 0; i < count; i++) {
+        blocks[i].dst = dst;
+        dst += MX_LZ4_BLOCK_SIZE;
+    }
+
+    lz4_work_t work = {
+        .blocks = blocks,
+        .count = count,
+    };
+    atomic_init(&work.next, 0);
+    atomic_init(&work.failed, false);
+
+    // One worker per CPU, including this thread.  Workers pull blocks
+    // from a shared counter, so if thread creation fails the remaining
+    // workers (at minimum, this thread) still finish the whole table.
+    uint32_t workers = mx_system_get_num_cpus();
+    if (workers > count) {
+        workers = count;
+    }
+    if (workers > MAX_WORKERS) {
+        workers = MAX_WORKERS;
+    }
+    thrd_t threads[MAX_WORKERS];
+    uint32_t started = 0;
+    for (uint32_t i = 1; i < workers; i++) {
+        if (thrd_create(&threads[started], decompress_worker, &work) != thrd_success) {
+            break;
+        }
+        started++;
+    }
+    decompress_worker(&work);
+    for (uint32_t i = 0; i < started; i++) {
+        int result;
+        thrd_join(threads[i], &result);
+    }
+    free(blocks);
+
+    if (atomic_load(&work.failed)) {
+        *err = "lz4 block did not decompress to its expected size";
+        mx_vmar_unmap(vmar, dst_addr, newsize);
+        mx_handle_close(dst_vmo);
+        return MX_ERR_BAD_STATE;
+    }
+
+    status = mx_vmar_unmap(vmar, dst_addr, newsize);
+    if (status < 0) {
+        *err = "mx_vmar_unmap after decompress failed";
+        mx_handle_close(dst_vmo);
+        return status;
+    }
+    *out = dst_vmo;
+    return MX_OK;
+
+fail_blocks:
+    free(blocks);
+    return MX_ERR_INVALID_ARGS;
+}
+
+mx_status_t decompress_bootdata_parallel(mx_handle_t vmar, mx_handle_t vmo,
+                                         size_t offset, size_t length,
+                                         mx_handle_t* out, const char** err) {
+    *err = "none";
+
+    if (length > SIZE_MAX) {
+        *err = "bootfs VMO too large to map";
+        return MX_ERR_BUFFER_TOO_SMALL;
+    }
+
+    uintptr_t addr = 0;
+    size_t aligned_offset = offset & ~(PAGE_SIZE - 1);
+    size_t align_shift = offset - aligned_offset;
+    length += align_shift;
+    mx_status_t status = mx_vmar_map(vmar, 0, vmo, aligned_offset, length, MX_VM_FLAG_PERM_READ, &addr);
+    if (status < 0) {
+        *err = "mx_vmar_map failed on bootfs vmo";
+        return status;
+    }
+    uintptr_t bootdata_addr = addr + align_shift;
+
+    const bootdata_t* hdr = (bootdata_t*)bootdata_addr;
+    switch (hdr->type) {
+    case BOOTDATA_BOOTFS_BOOT:
+    case BOOTDATA_BOOTFS_SYSTEM:
+        if (hdr->flags & BOOTDATA_BOOTFS_FLAG_COMPRESSED) {
+            status = decompress_bootfs_vmo_parallel(vmar, (const uint8_t*)bootdata_addr,
+                                                    length - align_shift, out, err);
+        }
+        break;
+    default:
+        *err = "unknown bootdata type, not attempting decompression\n";
+        status = MX_ERR_NOT_SUPPORTED;
+        break;
+    }
+
+    mx_status_t s = mx_vmar_unmap(vmar, addr, length);
+    if (s < 0) {
+        *err = "mx_vmar_unmap failed on bootfs vmo";
+        return s;
+    }
+
+    return status;
+}
@@ -16,4 +16,12 @@ mx_status_t decompress_bootdata(mx_handle_t vmar, mx_handle_t vmo,
                                 size_t offset, size_t length,
                                 mx_handle_t* out, const char** errmsg);
 
+// As decompress_bootdata, but decodes the independent LZ4 blocks across
+// one thread per CPU.  Fails if any block but the last decompresses to
+// less than the 64kB block size (legal in the frame format but never
+// produced by mkbootfs); callers should fall back to the serial path.
+mx_status_t decompress_bootdata_parallel(mx_handle_t vmar, mx_handle_t vmo,
+                                         size_t offset, size_t length,
+                                         mx_handle_t* out, const char** errmsg);
+
 #pragma GCC visibility pop
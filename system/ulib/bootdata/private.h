@@ -0,0 +1,49 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <magenta/types.h>
+#include <stdint.h>
+
+// The LZ4 Frame format is used to compress a bootfs image, but we cannot use
+// the LZ4 library's decompression functions in userboot. The following
+// definitions are used in the reimplementation of LZ4 Frame decompression,
+// with a few restrictions on the frame options:
+//  - Blocks must be independent
+//  - No block checksums
+//  - Final content size must be included in frame header
+//  - Max block size is 64kB
+//
+//  See https://github.com/lz4/lz4/blob/dev/lz4_Frame_format.md for details.
+#define MX_LZ4_MAGIC 0x184D2204
+#define MX_LZ4_VERSION (1 << 6)
+
+typedef struct {
+    uint8_t flag;
+    uint8_t block_desc;
+    uint64_t content_size;
+    uint8_t header_cksum;
+} __PACKED lz4_frame_desc;
+
+#define MX_LZ4_FLAG_VERSION       (1 << 6)
+#define MX_LZ4_FLAG_BLOCK_DEP     (1 << 5)
+#define MX_LZ4_FLAG_BLOCK_CKSUM   (1 << 4)
+#define MX_LZ4_FLAG_CONTENT_SZ    (1 << 3)
+#define MX_LZ4_FLAG_CONTENT_CKSUM (1 << 2)
+#define MX_LZ4_FLAG_RESERVED      0x03
+
+#define MX_LZ4_BLOCK_MAX_MASK     (7 << 4)
+#define MX_LZ4_BLOCK_64KB         (4 << 4)
+#define MX_LZ4_BLOCK_256KB        (5 << 4)
+#define MX_LZ4_BLOCK_1MB          (6 << 4)
+#define MX_LZ4_BLOCK_4MB          (7 << 4)
+
+// Uncompressed size of every block but the last, given the 64kB max
+// block size enforced above.
+#define MX_LZ4_BLOCK_SIZE 65536
+
+mx_status_t check_lz4_frame(const lz4_frame_desc* fd,
+                            size_t expected, const char** err);
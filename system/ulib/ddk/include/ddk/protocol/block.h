@@ -21,6 +21,18 @@ typedef struct block_protocol_ops {
                  uint64_t dev_offset, void* cookie);
     void (*write)(void* ctx, mx_handle_t vmo, uint64_t length, uint64_t vmo_offset,
                   uint64_t dev_offset, void* cookie);
+
+    // Optional multi-queue extension. Devices backed by hardware with
+    // multiple submission/completion rings (NVMe, for example) may implement
+    // these to accept independent streams of operations; ops issued on
+    // distinct queues may complete in any order relative to one another.
+    // Devices with a single submission stream leave these NULL and the
+    // wrappers below collapse every queue onto read/write.
+    uint32_t (*get_queue_count)(void* ctx);
+    void (*queue_read)(void* ctx, uint32_t queue, mx_handle_t vmo, uint64_t length,
+                       uint64_t vmo_offset, uint64_t dev_offset, void* cookie);
+    void (*queue_write)(void* ctx, uint32_t queue, mx_handle_t vmo, uint64_t length,
+                        uint64_t vmo_offset, uint64_t dev_offset, void* cookie);
 } block_protocol_ops_t;
 
 typedef struct {
@@ -52,4 +64,34 @@ static inline void block_write(block_protocol_t* block, mx_handle_t vmo, uint64_
     block->ops->write(block->ctx, vmo, length, vmo_offset, dev_offset, cookie);
 }
 
+// Get the number of independent queues the block device supports
+static inline uint32_t block_get_queue_count(block_protocol_t* block) {
+    if (block->ops->get_queue_count == NULL) {
+        return 1;
+    }
+    return block->ops->get_queue_count(block->ctx);
+}
+
+// Read to the VMO from the block device on a specific queue
+static inline void block_queue_read(block_protocol_t* block, uint32_t queue, mx_handle_t vmo,
+                                    uint64_t length, uint64_t vmo_offset, uint64_t dev_offset,
+                                    void* cookie) {
+    if (block->ops->queue_read == NULL) {
+        block->ops->read(block->ctx, vmo, length, vmo_offset, dev_offset, cookie);
+        return;
+    }
+    block->ops->queue_read(block->ctx, queue, vmo, length, vmo_offset, dev_offset, cookie);
+}
+
+// Write from the VMO to the block device on a specific queue
+static inline void block_queue_write(block_protocol_t* block, uint32_t queue, mx_handle_t vmo,
+                                     uint64_t length, uint64_t vmo_offset, uint64_t dev_offset,
+                                     void* cookie) {
+    if (block->ops->queue_write == NULL) {
+        block->ops->write(block->ctx, vmo, length, vmo_offset, dev_offset, cookie);
+        return;
+    }
+    block->ops->queue_write(block->ctx, queue, vmo, length, vmo_offset, dev_offset, cookie);
+}
+
 __END_CDECLS;
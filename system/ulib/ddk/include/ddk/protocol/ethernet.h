@@ -25,10 +25,29 @@ __BEGIN_CDECLS;
 // these will not be loaded.
 //
 // The FEATURE_WLAN flag indicates a device that supports wlan operations.
+//
+// The FEATURE_?X_CSUM and FEATURE_TSO flags advertise hardware offloads.
+// Devices report them from query(); the ethernet middle layer forwards
+// them to clients via IOCTL_ETHERNET_GET_INFO so netstacks can skip
+// software checksum loops:
+// - FEATURE_RX_CSUM: the device validates IP/TCP/UDP checksums on receive
+//   and sets ETHMAC_RX_CSUM_OK in the flags passed to recv()
+// - FEATURE_TX_CSUM: the device inserts checksums on transmit when
+//   ETHMAC_TX_OPT_CSUM is passed to send()
+// - FEATURE_TSO: the device segments large TCP payloads on transmit.
+//   Per-packet segmentation parameters are not carried by this interface
+//   yet, so the flag only advertises the capability.
 
 #define ETHMAC_FEATURE_RX_QUEUE (1u)
 #define ETHMAC_FEATURE_TX_QUEUE (2u)
 #define ETHMAC_FEATURE_WLAN     (4u)
+#define ETHMAC_FEATURE_RX_CSUM  (8u)
+#define ETHMAC_FEATURE_TX_CSUM  (16u)
+#define ETHMAC_FEATURE_TSO      (32u)
+
+// flags for ethmac_ifc recv(): the device verified the IP/TCP/UDP
+// checksums of this packet (only with FEATURE_RX_CSUM)
+#define ETHMAC_RX_CSUM_OK (1u)
 
 typedef struct ethmac_info {
     uint32_t features;
@@ -53,6 +72,18 @@ typedef struct ethmac_ifc_virt {
 // driver to batch tx to hardware if possible.
 #define ETHMAC_TX_OPT_MORE (1u)
 
+// Requests that the device insert the IP/TCP/UDP checksums for this packet
+// (only with FEATURE_TX_CSUM)
+#define ETHMAC_TX_OPT_CSUM (2u)
+
+// Parameters for set_param():
+// ETHMAC_SETPARAM_INT_MODERATION controls interrupt moderation:
+// - value < 0: adaptive; the driver scales its interrupt rate with
+//   offered load (batching under high rate, immediate when idle)
+// - value == 0: no moderation; one interrupt per event
+// - value > 0: cap interrupts at `value` per second
+#define ETHMAC_SETPARAM_INT_MODERATION (1u)
+
 // The ethernet midlayer will never call ethermac_protocol
 // methods from multiple threads simultaneously, but it
 // can call send() methods at the same time as non-send
@@ -80,6 +111,10 @@ typedef struct ethmac_protocol_ops {
                      uintptr_t pa0, uintptr_t pa1, size_t length);
     void (*queue_rx)(void* ctx, uint32_t options,
                      uintptr_t pa0, uintptr_t pa1, size_t length);
+
+    // Set a device parameter (ETHMAC_SETPARAM_*); optional (may be NULL).
+    // Returns MX_ERR_NOT_SUPPORTED for unrecognized parameters.
+    mx_status_t (*set_param)(void* ctx, uint32_t param, int32_t value);
 } ethmac_protocol_ops_t;
 
 typedef struct ethmac_protocol {
@@ -35,6 +35,7 @@
 #define IOTXN_PFLAG_MMAP       (1 << 3)   // we performed mmap() on this vmo
 #define IOTXN_PFLAG_FREE       (1 << 4)   // this txn has been released
 #define IOTXN_PFLAG_QUEUED     (1 << 5)   // transaction has been queued and not yet released
+#define IOTXN_PFLAG_PHYS_CACHED (1 << 6)  // phys points into the physmap cache, not malloced memory
 
 #define IOTXN_STATE_MASK       (IOTXN_PFLAG_FREE | IOTXN_PFLAG_QUEUED)
 
@@ -48,6 +49,98 @@ static size_t free_list_monitor_warned = 0;
 // This assert will fail if we attempt to access the buffer of a cloned txn after it has been completed
 #define ASSERT_BUFFER_VALID(priv) MX_DEBUG_ASSERT(!(priv->flags & IOTXN_FLAG_DEAD))
 
+// Cache of physical page translations keyed by VMO koid and page range.
+// Steady-state I/O against a long-lived VMO (e.g. the block server's shared
+// buffer) hits here and skips the per-transaction commit and page list walk.
+// Entries rely on the same assumption iotxn_physmap_paged() already makes:
+// committed pages are never auto-decommitted.
+#define PHYSMAP_CACHE_SIZE 16
+
+typedef struct {
+    uint64_t koid;          // koid of the VMO, 0 if the entry is empty
+    uint64_t page_offset;   // page-aligned offset covered by paddrs
+    uint64_t pages;         // number of entries in paddrs
+    mx_paddr_t* paddrs;
+    uint32_t refcount;      // in-flight txns pointing at paddrs
+} physmap_cache_entry_t;
+
+static physmap_cache_entry_t physmap_cache[PHYSMAP_CACHE_SIZE];
+static size_t physmap_cache_next;
+static mtx_t physmap_cache_mutex = MTX_INIT;
+
+static uint64_t iotxn_vmo_koid(mx_handle_t vmo) {
+    mx_info_handle_basic_t info;
+    if (mx_object_get_info(vmo, MX_INFO_HANDLE_BASIC, &info, sizeof(info),
+                           NULL, NULL) != MX_OK) {
+        return 0;
+    }
+    return info.koid;
+}
+
+static mx_paddr_t* physmap_cache_lookup(uint64_t koid, uint64_t page_offset, uint64_t pages) {
+    if (koid == 0) {
+        return NULL;
+    }
+    mx_paddr_t* paddrs = NULL;
+    mtx_lock(&physmap_cache_mutex);
+    for (size_t i = 0; i < PHYSMAP_CACHE_SIZE; i++) {
+        physmap_cache_entry_t* entry = &physmap_cache[i];
+        if ((entry->koid == koid) && (entry->page_offset == page_offset) &&
+            (entry->pages >= pages)) {
+            entry->refcount++;
+            paddrs = entry->paddrs;
+            break;
+        }
+    }
+    mtx_unlock(&physmap_cache_mutex);
+    return paddrs;
+}
+
+// Try to take ownership of |paddrs| for future lookups. Returns true if the
+// cache now owns the list (and holds a reference for the caller), false if
+// the cache was full of busy entries and the caller keeps ownership.
+static bool physmap_cache_insert(uint64_t koid, uint64_t page_offset, uint64_t pages,
+                                 mx_paddr_t* paddrs) {
+    if (koid == 0) {
+        return false;
+    }
+    bool inserted = false;
+    mtx_lock(&physmap_cache_mutex);
+    for (size_t i = 0; i < PHYSMAP_CACHE_SIZE; i++) {
+        physmap_cache_entry_t* entry = &physmap_cache[physmap_cache_next % PHYSMAP_CACHE_SIZE];
+        physmap_cache_next++;
+        if (entry->refcount > 0) {
+            // still referenced by in-flight txns; not evictable
+            continue;
+        }
+        if (entry->paddrs) {
+            free(entry->paddrs);
+        }
+        entry->koid = koid;
+        entry->page_offset = page_offset;
+        entry->pages = pages;
+        entry->paddrs = paddrs;
+        entry->refcount = 1;
+        inserted = true;
+        break;
+    }
+    mtx_unlock(&physmap_cache_mutex);
+    return inserted;
+}
+
+static void physmap_cache_release(mx_paddr_t* paddrs) {
+    mtx_lock(&physmap_cache_mutex);
+    for (size_t i = 0; i < PHYSMAP_CACHE_SIZE; i++) {
+        physmap_cache_entry_t* entry = &physmap_cache[i];
+        if (entry->paddrs == paddrs) {
+            MX_DEBUG_ASSERT(entry->refcount > 0);
+            entry->refcount--;
+            break;
+        }
+    }
+    mtx_unlock(&physmap_cache_mutex);
+}
+
 static uint32_t alloc_flags_to_pflags(uint32_t alloc_flags) {
     if (alloc_flags & IOTXN_ALLOC_CONTIGUOUS) {
         return IOTXN_PFLAG_CONTIGUOUS;
@@ -116,6 +209,8 @@ static void iotxn_release_free_list(iotxn_t* txn) {
             if (phys != NULL) {
                 free(phys);
             }
+        } else if (pflags & IOTXN_PFLAG_PHYS_CACHED) {
+            physmap_cache_release(phys);
         }
         if (pflags & IOTXN_PFLAG_MMAP) {
             // only unmap if we called mmap()
@@ -149,6 +244,8 @@ static void iotxn_release_free(iotxn_t* txn) {
         if (txn->phys != NULL) {
             free(txn->phys);
         }
+    } else if (txn->pflags & IOTXN_PFLAG_PHYS_CACHED) {
+        physmap_cache_release(txn->phys);
     }
     if (txn->pflags & IOTXN_PFLAG_MMAP) {
         if (txn->virt) {
@@ -172,6 +269,11 @@ static void iotxn_release_static(iotxn_t* txn) {
             txn->phys = NULL;
             txn->phys_count = 0;
         }
+    } else if (pflags & IOTXN_PFLAG_PHYS_CACHED) {
+        physmap_cache_release(txn->phys);
+        txn->pflags &= ~IOTXN_PFLAG_PHYS_CACHED;
+        txn->phys = NULL;
+        txn->phys_count = 0;
     }
     if (pflags & IOTXN_PFLAG_MMAP) {
         // only unmap if we called mmap()
@@ -242,6 +344,18 @@ static mx_status_t iotxn_physmap_paged(iotxn_t* txn) {
     uint64_t pages = ROUNDUP(page_length, PAGE_SIZE) / PAGE_SIZE;
 
     bool use_inline = pages <= 3;
+    uint64_t koid = 0;
+    if (!use_inline) {
+        // the cache only holds out-of-line page lists; inline lookups are cheap
+        koid = iotxn_vmo_koid(txn->vmo_handle);
+        mx_paddr_t* cached = physmap_cache_lookup(koid, page_offset, pages);
+        if (cached != NULL) {
+            txn->pflags |= IOTXN_PFLAG_PHYS_CACHED;
+            txn->phys = cached;
+            txn->phys_count = pages;
+            return MX_OK;
+        }
+    }
     mx_paddr_t* paddrs = use_inline ? txn->phys_inline : malloc(sizeof(mx_paddr_t) * pages);
     if (paddrs == NULL) {
         xprintf("iotxn_physmap_paged: out of memory\n");
@@ -269,7 +383,11 @@ static mx_status_t iotxn_physmap_paged(iotxn_t* txn) {
     }
 
     if (!use_inline) {
-        txn->pflags |= IOTXN_PFLAG_PHYSMAP;
+        if (physmap_cache_insert(koid, page_offset, pages, paddrs)) {
+            txn->pflags |= IOTXN_PFLAG_PHYS_CACHED;
+        } else {
+            txn->pflags |= IOTXN_PFLAG_PHYSMAP;
+        }
     }
     txn->phys = paddrs;
     txn->phys_count = pages;
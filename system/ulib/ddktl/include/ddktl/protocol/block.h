@@ -54,15 +54,16 @@ class BlockProtocol : public internal::base_protocol {
   public:
     BlockProtocol() {
         internal::CheckBlockProtocolSubclass<D>();
-        ops_.set_callbacks = SetCallbacks;
-        ops_.get_info = GetInfo;
-        ops_.read = Read;
-        ops_.write = Write;
+        static_assert(kOps.set_callbacks == &BlockProtocol<D>::SetCallbacks &&
+                      kOps.get_info == &BlockProtocol<D>::GetInfo &&
+                      kOps.read == &BlockProtocol<D>::Read &&
+                      kOps.write == &BlockProtocol<D>::Write,
+                      "BlockProtocol table entries must point directly at the trampolines");
 
         // Can only inherit from one base_protocol implemenation
         MX_ASSERT(ddk_proto_ops_ == nullptr);
         ddk_proto_id_ = MX_PROTOCOL_BLOCK_CORE;
-        ddk_proto_ops_ = &ops_;
+        ddk_proto_ops_ = const_cast<block_protocol_ops_t*>(&kOps);
     }
 
   private:
@@ -84,7 +85,13 @@ class BlockProtocol : public internal::base_protocol {
         static_cast<D*>(ctx)->BlockWrite(vmo, length, vmo_offset, dev_offset, cookie);
     }
 
-    block_protocol_ops_t ops_ = {};
+    // One table per driver class, emitted in rodata at compile time and
+    // shared by every instance; the optional queue entries stay NULL so
+    // the C-side wrappers collapse them onto read/write.
+    static constexpr block_protocol_ops_t kOps = {&SetCallbacks, &GetInfo, &Read, &Write};
 };
 
+template <typename D>
+constexpr block_protocol_ops_t BlockProtocol<D>::kOps;
+
 }  // namespace ddk
@@ -119,11 +119,16 @@ class EthmacIfc {
   public:
     EthmacIfc() {
         internal::CheckEthmacIfc<D>();
-        ifc_.status = Status;
-        ifc_.recv = Recv;
+        static_assert(kIfc.status == &EthmacIfc<D>::Status &&
+                      kIfc.recv == &EthmacIfc<D>::Recv,
+                      "EthmacIfc table entries must point directly at the trampolines");
+        static_assert(sizeof(EthmacIfc<D>) == 1,
+                      "EthmacIfc must stay empty; per-instance state would defeat the "
+                      "shared compile-time table");
     }
 
-    ethmac_ifc_t* ethmac_ifc() { return &ifc_; }
+    // The table is immutable; the C protocol structs merely lack const.
+    ethmac_ifc_t* ethmac_ifc() { return const_cast<ethmac_ifc_t*>(&kIfc); }
 
   private:
     static void Status(void* cookie, uint32_t status) {
@@ -134,9 +139,14 @@ class EthmacIfc {
         static_cast<D*>(cookie)->EthmacRecv(data, length, flags);
     }
 
-    ethmac_ifc_t ifc_ = {};
+    // One table per driver class, emitted in rodata at compile time and
+    // shared by every instance.
+    static constexpr ethmac_ifc_t kIfc = {&Status, &Recv};
 };
 
+template <typename D>
+constexpr ethmac_ifc_t EthmacIfc<D>::kIfc;
+
 class EthmacIfcProxy {
   public:
     EthmacIfcProxy(ethmac_ifc_t* ifc, void* cookie)
@@ -155,20 +165,26 @@ class EthmacIfcProxy {
     void* cookie_;
 };
 
+// A call through the proxy is a single load of the table entry plus the
+// indirect call; the wrapper itself is just the {table, cookie} pair.
+static_assert(sizeof(EthmacIfcProxy) == 2 * sizeof(void*),
+              "EthmacIfcProxy must add no state beyond the wrapped pair");
+
 template <typename D>
 class EthmacProtocol : public internal::base_protocol {
   public:
     EthmacProtocol() {
         internal::CheckEthmacProtocolSubclass<D>();
-        ops_.query = Query;
-        ops_.stop = Stop;
-        ops_.start = Start;
-        ops_.send = Send;
+        static_assert(kOps.query == &EthmacProtocol<D>::Query &&
+                      kOps.stop == &EthmacProtocol<D>::Stop &&
+                      kOps.start == &EthmacProtocol<D>::Start &&
+                      kOps.send == &EthmacProtocol<D>::Send,
+                      "EthmacProtocol table entries must point directly at the trampolines");
 
         // Can only inherit from one base_protocol implemenation
         MX_ASSERT(ddk_proto_ops_ == nullptr);
         ddk_proto_id_ = MX_PROTOCOL_ETHERMAC;
-        ddk_proto_ops_ = &ops_;
+        ddk_proto_ops_ = const_cast<ethmac_protocol_ops_t*>(&kOps);
     }
 
   private:
@@ -189,9 +205,14 @@ class EthmacProtocol : public internal::base_protocol {
         static_cast<D*>(ctx)->EthmacSend(options, data, length);
     }
 
-    ethmac_protocol_ops_t ops_ = {};
+    // One table per driver class, emitted in rodata at compile time and
+    // shared by every instance.
+    static constexpr ethmac_protocol_ops_t kOps = {&Query, &Stop, &Start, &Send};
 };
 
+template <typename D>
+constexpr ethmac_protocol_ops_t EthmacProtocol<D>::kOps;
+
 class EthmacProtocolProxy {
   public:
     EthmacProtocolProxy(ethmac_protocol_t* proto)
@@ -221,4 +242,7 @@ class EthmacProtocolProxy {
     void* ctx_;
 };
 
+static_assert(sizeof(EthmacProtocolProxy) == 2 * sizeof(void*),
+              "EthmacProtocolProxy must add no state beyond the wrapped pair");
+
 }  // namespace ddk
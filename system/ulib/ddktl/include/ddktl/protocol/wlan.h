@@ -125,11 +125,16 @@ class WlanmacIfc {
   public:
     WlanmacIfc() {
         internal::CheckWlanmacIfc<D>();
-        ifc_.status = Status;
-        ifc_.recv = Recv;
+        static_assert(kIfc.status == &WlanmacIfc<D>::Status &&
+                      kIfc.recv == &WlanmacIfc<D>::Recv,
+                      "WlanmacIfc table entries must point directly at the trampolines");
+        static_assert(sizeof(WlanmacIfc<D>) == 1,
+                      "WlanmacIfc must stay empty; per-instance state would defeat the "
+                      "shared compile-time table");
     }
 
-    wlanmac_ifc_t* wlanmac_ifc() { return &ifc_; }
+    // The table is immutable; the C protocol structs merely lack const.
+    wlanmac_ifc_t* wlanmac_ifc() { return const_cast<wlanmac_ifc_t*>(&kIfc); }
 
   private:
     static void Status(void* cookie, uint32_t status) {
@@ -141,9 +146,14 @@ class WlanmacIfc {
         static_cast<D*>(cookie)->WlanmacRecv(flags, data, length, info);
     }
 
-    wlanmac_ifc_t ifc_ = {};
+    // One table per driver class, emitted in rodata at compile time and
+    // shared by every instance.
+    static constexpr wlanmac_ifc_t kIfc = {&Status, &Recv};
 };
 
+template <typename D>
+constexpr wlanmac_ifc_t WlanmacIfc<D>::kIfc;
+
 class WlanmacIfcProxy {
   public:
     WlanmacIfcProxy(wlanmac_ifc_t* ifc, void* cookie)
@@ -162,21 +172,27 @@ class WlanmacIfcProxy {
     void* cookie_;
 };
 
+// A call through the proxy is a single load of the table entry plus the
+// indirect call; the wrapper itself is just the {table, cookie} pair.
+static_assert(sizeof(WlanmacIfcProxy) == 2 * sizeof(void*),
+              "WlanmacIfcProxy must add no state beyond the wrapped pair");
+
 template <typename D>
 class WlanmacProtocol : public internal::base_protocol {
   public:
     WlanmacProtocol() {
         internal::CheckWlanmacProtocolSubclass<D>();
-        ops_.query = Query;
-        ops_.stop = Stop;
-        ops_.start = Start;
-        ops_.tx = Tx;
-        ops_.set_channel = SetChannel;
+        static_assert(kOps.query == &WlanmacProtocol<D>::Query &&
+                      kOps.stop == &WlanmacProtocol<D>::Stop &&
+                      kOps.start == &WlanmacProtocol<D>::Start &&
+                      kOps.tx == &WlanmacProtocol<D>::Tx &&
+                      kOps.set_channel == &WlanmacProtocol<D>::SetChannel,
+                      "WlanmacProtocol table entries must point directly at the trampolines");
 
         // Can only inherit from one base_protocol implemenation
         MX_ASSERT(this->ddk_proto_ops_ == nullptr);
         ddk_proto_id_ = MX_PROTOCOL_WLANMAC;
-        ddk_proto_ops_ = &ops_;
+        ddk_proto_ops_ = const_cast<wlanmac_protocol_ops_t*>(&kOps);
     }
 
   private:
@@ -201,9 +217,15 @@ class WlanmacProtocol : public internal::base_protocol {
         return static_cast<D*>(ctx)->WlanmacSetChannel(options, chan);
     }
 
-    wlanmac_protocol_ops_t ops_ = {};
+    // One table per driver class, emitted in rodata at compile time and
+    // shared by every instance.
+    // Note the C table orders start before stop, unlike ethmac.
+    static constexpr wlanmac_protocol_ops_t kOps = {&Query, &Start, &Stop, &Tx, &SetChannel};
 };
 
+template <typename D>
+constexpr wlanmac_protocol_ops_t WlanmacProtocol<D>::kOps;
+
 class WlanmacProtocolProxy {
   public:
     WlanmacProtocolProxy(wlanmac_protocol_t* proto)
@@ -237,4 +259,7 @@ class WlanmacProtocolProxy {
     void* ctx_;
 };
 
+static_assert(sizeof(WlanmacProtocolProxy) == 2 * sizeof(void*),
+              "WlanmacProtocolProxy must add no state beyond the wrapped pair");
+
 }  // namespace ddk
@@ -58,6 +58,17 @@ public:
     static mx_status_t Create(const void* data, size_t data_len, void* tree,
                               size_t tree_len, Digest* digest);
 
+    // As |Create|, but splits the hashing of the data (leaf) nodes across up
+    // to |num_threads| worker threads.  Each leaf digest depends only on its
+    // own node's data, so the leaves can be hashed independently; the upper
+    // levels of the tree are then built sequentially from the leaf digests.
+    // The resulting tree and root digest are identical to those produced by
+    // |Create|.  Falls back to |Create| when the data fits in a single node,
+    // when |num_threads| is less than 2, or when built for the host.
+    static mx_status_t CreateParallel(const void* data, size_t data_len,
+                                      void* tree, size_t tree_len,
+                                      Digest* digest, uint32_t num_threads);
+
     // Checks the integrity of a the region of data given by the offset and
     // length.  It checks integrity using the given Merkle tree and trusted root
     // digest. |tree_len| must be at least as much as returned by
@@ -6,6 +6,9 @@
 
 #include <stdint.h>
 #include <string.h>
+#ifdef __Fuchsia__
+#include <threads.h>
+#endif
 
 #include <digest/digest.h>
 #include <magenta/assert.h>
@@ -93,6 +96,45 @@ size_t NextAligned(size_t length) {
     return mxtl::roundup(NextLength(length), MerkleTree::kNodeSize);
 }
 
+#ifdef __Fuchsia__
+////////
+// Helpers for CreateParallel.
+
+// An upper bound on the number of leaf-hashing threads used by CreateParallel;
+// beyond this, thread creation costs outweigh the extra parallelism.
+const uint32_t kMaxCreateThreads = 16;
+
+// One thread's share of the leaf hashing: |count| leaf nodes starting at leaf
+// |first|, with one digest written per node into the bottom level of |tree|.
+struct LeafHashArgs {
+    const uint8_t* data;
+    size_t data_len;
+    uint8_t* tree;
+    size_t first;
+    size_t count;
+};
+
+// Hashes the leaf nodes described by |args|, exactly as CreateUpdate would for
+// level 0 of the tree.
+void HashLeaves(const LeafHashArgs* args) {
+    Digest digest;
+    for (size_t i = args->first; i < args->first + args->count; ++i) {
+        size_t offset = i * MerkleTree::kNodeSize;
+        size_t length =
+            mxtl::min(args->data_len - offset, MerkleTree::kNodeSize);
+        DigestInit(&digest, offset /* | level 0 */, args->data_len - offset);
+        DigestUpdate(&digest, args->data + offset, offset, length);
+        DigestFinal(&digest, offset + length);
+        digest.CopyTo(args->tree + (i * Digest::kLength), Digest::kLength);
+    }
+}
+
+int HashLeavesThread(void* arg) {
+    HashLeaves(static_cast<const LeafHashArgs*>(arg));
+    return 0;
+}
+#endif // __Fuchsia__
+
 } // namespace
 
 ////////
@@ -115,6 +157,76 @@ mx_status_t MerkleTree::Create(const void* data, size_t data_len, void* tree,
     return MX_OK;
 }
 
+mx_status_t MerkleTree::CreateParallel(const void* data, size_t data_len,
+                                       void* tree, size_t tree_len,
+                                       Digest* digest, uint32_t num_threads) {
+#ifndef __Fuchsia__
+    return Create(data, data_len, tree, tree_len, digest);
+#else
+    // Data fitting in a single node has no leaves to fan out, and a single
+    // thread is just |Create|.
+    if (data_len <= kNodeSize || num_threads < 2) {
+        return Create(data, data_len, tree, tree_len, digest);
+    }
+    if (!data || !tree || !digest) {
+        return MX_ERR_INVALID_ARGS;
+    }
+    if (tree_len < GetTreeLength(data_len)) {
+        return MX_ERR_BUFFER_TOO_SMALL;
+    }
+    // Hash the leaf nodes in parallel.  The bottom level of the tree is zeroed
+    // first so that the tail of its last node is correctly padded.
+    size_t num_leaves = (data_len + kNodeSize - 1) / kNodeSize;
+    size_t level0_len = NextAligned(data_len);
+    memset(tree, 0, level0_len);
+    size_t num_slices = mxtl::min(
+        static_cast<size_t>(mxtl::min(num_threads, kMaxCreateThreads)),
+        num_leaves);
+    LeafHashArgs args[kMaxCreateThreads];
+    size_t first = 0;
+    for (size_t i = 0; i < num_slices; ++i) {
+        args[i].data = static_cast<const uint8_t*>(data);
+        args[i].data_len = data_len;
+        args[i].tree = static_cast<uint8_t*>(tree);
+        args[i].first = first;
+        args[i].count =
+            (num_leaves / num_slices) + (i < num_leaves % num_slices ? 1 : 0);
+        first += args[i].count;
+    }
+    thrd_t threads[kMaxCreateThreads];
+    bool spawned[kMaxCreateThreads] = {};
+    for (size_t i = 1; i < num_slices; ++i) {
+        if (thrd_create(&threads[i], HashLeavesThread, &args[i]) ==
+            thrd_success) {
+            spawned[i] = true;
+        } else {
+            // Out of threads; do this slice's share on the calling thread.
+            HashLeaves(&args[i]);
+        }
+    }
+    HashLeaves(&args[0]);
+    for (size_t i = 1; i < num_slices; ++i) {
+        if (spawned[i]) {
+            thrd_join(threads[i], nullptr);
+        }
+    }
+    // Build the upper levels sequentially from the leaf digests.  This is at
+    // most 1/|kDigestsPerNode| of the hashing work, so it isn't worth fanning
+    // out.  Feeding the whole (padded) bottom level produces the same digests
+    // as the incremental path, which pads each level from the tree buffer.
+    mx_status_t rc;
+    MerkleTree mt;
+    mt.level_ = 1;
+    uint8_t* next = static_cast<uint8_t*>(tree) + level0_len;
+    if ((rc = mt.CreateInit(level0_len, tree_len - level0_len)) != MX_OK ||
+        (rc = mt.CreateUpdate(tree, level0_len, next)) != MX_OK ||
+        (rc = mt.CreateFinal(next, digest)) != MX_OK) {
+        return rc;
+    }
+    return MX_OK;
+#endif // __Fuchsia__
+}
+
 MerkleTree::MerkleTree()
     : initialized_(false), next_(nullptr), level_(0), offset_(0), length_(0) {}
 
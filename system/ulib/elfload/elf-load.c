@@ -216,8 +216,14 @@ static mx_status_t finish_load_segment(
     return status;
 }
 
+// If data_vmo is valid, it is a copy-on-write clone of the leading
+// portion of vmo (made by the caller, covering every writable
+// segment's file data) and writable segments map from it at their
+// original file offsets.  Otherwise each writable segment makes its
+// own clone here.
 static mx_status_t load_segment(mx_handle_t vmar, size_t vmar_offset,
-                                mx_handle_t vmo, const char* vmo_name,
+                                mx_handle_t vmo, mx_handle_t data_vmo,
+                                const char* vmo_name,
                                 const elf_phdr_t* ph) {
     // The p_vaddr can start in the middle of a page, but the
     // semantics are that all the whole pages containing the
@@ -247,6 +253,11 @@ static mx_status_t load_segment(mx_handle_t vmar, size_t vmar_offset,
         return finish_load_segment(vmar, vmo, vmo_name, ph, start, size,
                                    file_start, file_end, partial_page);
 
+    // The caller already made one writable clone for the whole file.
+    if (data_vmo != MX_HANDLE_INVALID)
+        return finish_load_segment(vmar, data_vmo, vmo_name, ph, start, size,
+                                   file_start, file_end, partial_page);
+
     // For a writable segment, we need a writable VMO.
     mx_handle_t writable_vmo;
     mx_status_t status = mx_vmo_clone(vmo, MX_VMO_CLONE_COPY_ON_WRITE,
@@ -266,18 +277,13 @@ static mx_status_t load_segment(mx_handle_t vmar, size_t vmar_offset,
     return status;
 }
 
-mx_status_t elf_load_map_segments(mx_handle_t root_vmar,
-                                  const elf_load_header_t* header,
-                                  const elf_phdr_t phdrs[],
-                                  mx_handle_t vmo,
-                                  mx_handle_t* segments_vmar,
-                                  mx_vaddr_t* base, mx_vaddr_t* entry) {
-    char vmo_name[MX_MAX_NAME_LEN];
-    if (mx_object_get_property(vmo, MX_PROP_NAME,
-                               vmo_name, sizeof(vmo_name)) != MX_OK ||
-        vmo_name[0] == '\0')
-        memcpy(vmo_name, VMO_NAME_UNKNOWN, sizeof(VMO_NAME_UNKNOWN));
-
+static mx_status_t map_segments(mx_handle_t root_vmar,
+                                const elf_load_header_t* header,
+                                const elf_phdr_t phdrs[],
+                                mx_handle_t vmo, mx_handle_t data_vmo,
+                                const char* vmo_name,
+                                mx_handle_t* segments_vmar,
+                                mx_vaddr_t* base, mx_vaddr_t* entry) {
     uintptr_t vmar_base = 0;
     uintptr_t bias = 0;
     mx_handle_t vmar = MX_HANDLE_INVALID;
@@ -287,7 +293,8 @@ mx_status_t elf_load_map_segments(mx_handle_t root_vmar,
     size_t vmar_offset = bias - vmar_base;
     for (uint_fast16_t i = 0; status == MX_OK && i < header->e_phnum; ++i) {
         if (phdrs[i].p_type == PT_LOAD)
-            status = load_segment(vmar, vmar_offset, vmo, vmo_name, &phdrs[i]);
+            status = load_segment(vmar, vmar_offset, vmo, data_vmo,
+                                  vmo_name, &phdrs[i]);
     }
 
     if (status == MX_OK && segments_vmar != NULL)
@@ -304,6 +311,79 @@ mx_status_t elf_load_map_segments(mx_handle_t root_vmar,
     return status;
 }
 
+mx_status_t elf_load_map_segments(mx_handle_t root_vmar,
+                                  const elf_load_header_t* header,
+                                  const elf_phdr_t phdrs[],
+                                  mx_handle_t vmo,
+                                  mx_handle_t* segments_vmar,
+                                  mx_vaddr_t* base, mx_vaddr_t* entry) {
+    char vmo_name[MX_MAX_NAME_LEN];
+    if (mx_object_get_property(vmo, MX_PROP_NAME,
+                               vmo_name, sizeof(vmo_name)) != MX_OK ||
+        vmo_name[0] == '\0')
+        memcpy(vmo_name, VMO_NAME_UNKNOWN, sizeof(VMO_NAME_UNKNOWN));
+
+    return map_segments(root_vmar, header, phdrs, vmo, MX_HANDLE_INVALID,
+                        vmo_name, segments_vmar, base, entry);
+}
+
+mx_status_t elf_load_cache(mx_handle_t vmo, const elf_load_header_t* header,
+                           uintptr_t phoff, elf_load_cached_t* cached) {
+    cached->header = *header;
+    if (mx_object_get_property(vmo, MX_PROP_NAME, cached->vmo_name,
+                               sizeof(cached->vmo_name)) != MX_OK ||
+        cached->vmo_name[0] == '\0')
+        memcpy(cached->vmo_name, VMO_NAME_UNKNOWN, sizeof(VMO_NAME_UNKNOWN));
+    return elf_load_read_phdrs(vmo, cached->phdrs, phoff, header->e_phnum);
+}
+
+mx_status_t elf_load_map_cached(mx_handle_t root_vmar,
+                                const elf_load_cached_t* cached,
+                                mx_handle_t vmo,
+                                mx_handle_t* segments_vmar,
+                                mx_vaddr_t* base, mx_vaddr_t* entry) {
+    // One copy-on-write clone of the file's leading pages covers every
+    // writable segment's data, so each load makes at most one clone no
+    // matter how many writable segments the image has.  The read-only
+    // segments still map straight from the (possibly cached, shared)
+    // file VMO, and pages the clone never maps writable cost nothing.
+    size_t data_end = 0;
+    for (uint_fast16_t i = 0; i < cached->header.e_phnum; ++i) {
+        const elf_phdr_t* ph = &cached->phdrs[i];
+        if (ph->p_type == PT_LOAD && (ph->p_flags & PF_W)) {
+            size_t end = (ph->p_offset + ph->p_filesz +
+                          PAGE_SIZE - 1) & -PAGE_SIZE;
+            if (end > data_end)
+                data_end = end;
+        }
+    }
+
+    mx_handle_t data_vmo = MX_HANDLE_INVALID;
+    if (data_end > 0) {
+        mx_status_t status = mx_vmo_clone(vmo, MX_VMO_CLONE_COPY_ON_WRITE,
+                                          0, data_end, &data_vmo);
+        if (status != MX_OK)
+            return status;
+        char name[MX_MAX_NAME_LEN] = VMO_NAME_PREFIX_DATA;
+        memcpy(&name[sizeof(VMO_NAME_PREFIX_DATA) - 1], cached->vmo_name,
+               MX_MAX_NAME_LEN - sizeof(VMO_NAME_PREFIX_DATA));
+        status = mx_object_set_property(data_vmo, MX_PROP_NAME,
+                                        name, strlen(name));
+        if (status != MX_OK) {
+            mx_handle_close(data_vmo);
+            return status;
+        }
+    }
+
+    mx_status_t status = map_segments(root_vmar, &cached->header,
+                                      cached->phdrs, vmo, data_vmo,
+                                      cached->vmo_name,
+                                      segments_vmar, base, entry);
+    if (data_vmo != MX_HANDLE_INVALID)
+        mx_handle_close(data_vmo);
+    return status;
+}
+
 bool elf_load_find_interp(const elf_phdr_t phdrs[], size_t phnum,
                           uintptr_t* interp_off, size_t* interp_len) {
     for (size_t i = 0; i < phnum; ++i) {
@@ -33,6 +33,21 @@ typedef struct {
     uint_fast16_t e_phnum;
 } elf_load_header_t;
 
+// A fully parsed image, suitable for caching across many loads of the
+// same file: the validated header, the file VMO's name, and all the
+// program headers.  The caller allocates it, sized for e_phnum program
+// headers, and fills it with elf_load_cache; thereafter
+// elf_load_map_cached can map the image any number of times without
+// reading headers back out of the file.
+typedef struct elf_load_cached {
+    elf_load_header_t header;
+    char vmo_name[MX_MAX_NAME_LEN];
+    elf_phdr_t phdrs[];
+} elf_load_cached_t;
+
+#define ELF_LOAD_CACHED_SIZE(phnum) \
+    (sizeof(elf_load_cached_t) + (phnum) * sizeof(elf_phdr_t))
+
 // These routines use this error code to indicate an invalid file format,
 // including wrong machine, wrong endian, etc. as well as a truncated file.
 #define ERR_ELF_BAD_FORMAT MX_ERR_NOT_FOUND
@@ -56,6 +71,23 @@ mx_status_t elf_load_map_segments(mx_handle_t vmar,
                                   mx_handle_t* segments_vmar,
                                   mx_vaddr_t* bias, mx_vaddr_t* entry);
 
+// Fill in a cached image descriptor.  The caller has already called
+// elf_load_prepare and allocated ELF_LOAD_CACHED_SIZE(header->e_phnum)
+// bytes for 'cached'.
+mx_status_t elf_load_cache(mx_handle_t vmo, const elf_load_header_t* header,
+                           uintptr_t phoff, elf_load_cached_t* cached);
+
+// Load the image into the process from a cached descriptor.  Unlike
+// elf_load_map_segments, this reads nothing from the file but segment
+// contents, and all writable segments share one copy-on-write clone of
+// 'vmo' rather than cloning it per segment, so a load costs a single
+// fixed pass of map calls.
+mx_status_t elf_load_map_cached(mx_handle_t vmar,
+                                const elf_load_cached_t* cached,
+                                mx_handle_t vmo,
+                                mx_handle_t* segments_vmar,
+                                mx_vaddr_t* bias, mx_vaddr_t* entry);
+
 // Locate the PT_INTERP program header and extract its bounds in the file.
 // Returns false if there was no PT_INTERP.
 bool elf_load_find_interp(const elf_phdr_t* phdrs, size_t phnum,
@@ -75,15 +75,6 @@ private:
 
 #ifdef __Fuchsia__
 
-struct VnodeWatcher : public mxtl::DoublyLinkedListable<mxtl::unique_ptr<VnodeWatcher>> {
-public:
-    VnodeWatcher(mx::channel h, uint32_t mask);
-    ~VnodeWatcher();
-
-    mx::channel h;
-    uint32_t mask;
-};
-
 // Transmission buffer for sending directory watcher notifications to clients.
 // Allows enqueueing multiple messages in a buffer before sending an IPC message
 // to a client.
@@ -95,16 +86,47 @@ public:
     mx_status_t AddMsg(const mx::channel& c, unsigned event, const char* name);
     mx_status_t Send(const mx::channel& c);
 
+    // Append a message without transmitting; fails with MX_ERR_NO_MEMORY
+    // if the buffer is full.
+    mx_status_t TryAddMsg(unsigned event, const char* name, size_t len);
+    // true if an identical message is already buffered.
+    bool Contains(unsigned event, const char* name, size_t len) const;
+
 private:
     size_t watch_buf_size_ = 0;
     char watch_buf_[VFS_WATCH_MSG_MAX]{};
 };
 
-class WatcherContainer {
+struct VnodeWatcher : public mxtl::DoublyLinkedListable<mxtl::unique_ptr<VnodeWatcher>> {
+public:
+    VnodeWatcher(mx::channel h, uint32_t mask);
+    ~VnodeWatcher();
+
+    mx::channel h;
+    uint32_t mask;
+    // Events coalesced since the last flush, and whether any were dropped
+    // because the buffer filled up.
+    WatchBuffer pending;
+    bool overflowed = false;
+};
+
+class WatcherContainer : public mxtl::DoublyLinkedListable<WatcherContainer*> {
 public:
+    WatcherContainer() = default;
+    ~WatcherContainer();
+
     mx_status_t WatchDir(mx_handle_t* out);
     mx_status_t WatchDirV2(Vfs* vfs, Vnode* vn, const vfs_watch_dir_t* cmd);
+
+    // Buffers an event for each interested watcher.  Repeated events for the
+    // same name are merged, and the buffered batch is transmitted once the
+    // coalescing window closes, so heavy churn costs a few messages per
+    // window rather than one per event.
     void Notify(const char* name, size_t len, unsigned event);
+
+    // Transmits all buffered events.  Called by the deferred flusher; not
+    // for general use.
+    void FlushPending();
 private:
     mxtl::Mutex lock_;
     mxtl::DoublyLinkedList<mxtl::unique_ptr<VnodeWatcher>> watch_list_ __TA_GUARDED(lock_);
@@ -295,6 +317,16 @@ public:
         flags_ |= V_FLAG_DEVICE_DETACHED;
     }
     bool IsDetachedDevice() const { return (flags_ & V_FLAG_DEVICE_DETACHED); }
+
+#ifdef __Fuchsia__
+    // A lock which should be used to serialize I/O and attribute operations
+    // on a single vnode. Operations on distinct vnodes may execute in
+    // parallel across a multithreaded dispatcher's worker pool; operations
+    // which walk or modify the directory hierarchy are serialized by the
+    // owning Vfs's vfs_lock_ instead.
+    // TODO(smklein): Encapsulate the lock; make it private.
+    mtx_t vnlock_{};
+#endif
 protected:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Vnode);
     Vnode() : flags_(0) {};
@@ -359,6 +391,13 @@ public:
 
     void SetDispatcher(Dispatcher* dispatcher) { dispatcher_ = dispatcher; }
 
+    // Filesystems whose vnode operations touch shared state which is not
+    // yet guarded by finer-grained locks may opt to serialize all incoming
+    // rio messages on a single lock (see vfs_handler). New filesystems
+    // should prefer relying on the per-vnode lock and vfs_lock_, which
+    // allow requests against independent vnodes to proceed in parallel.
+    void SetSerializeAll(bool serialize) { serialize_all_ = serialize; }
+
     // Dispatches to a Vnode over the specified handle (normal case)
     mx_status_t Serve(mx::channel channel, void* ios);
 
@@ -379,6 +418,10 @@ public:
     // TODO(smklein): Encapsulate the lock; make it private.
     mtx_t vfs_lock_{};
 
+    // See SetSerializeAll. Only used by vfs_handler.
+    mtx_t handler_lock_{};
+    bool serialize_all_ = false;
+
 private:
     // The mount list is a global static variable, but it only uses
     // constexpr constructors during initialization. As a consequence,
@@ -23,9 +23,11 @@
 
 #define MXDEBUG 0
 
-// ** NOTE -- this prototype multithreaded dispatcher is only used by
-// ** minfs as part of ongoing multithread development. Not yet safe
-// ** for general consumption
+// ** NOTE -- this multithreaded dispatcher is used by minfs and by
+// ** devmgr's memfs. Messages on a single connection are serialized (a
+// ** handler is only re-armed once its batch completes), while requests
+// ** on different connections run concurrently across the worker pool,
+// ** relying on the per-vnode and per-Vfs locking in vfs_handler.
 
 namespace fs {
 
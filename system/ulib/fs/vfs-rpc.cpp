@@ -11,6 +11,7 @@
 
 #include <fs/vfs.h>
 #include <magenta/process.h>
+#include <magenta/syscalls.h>
 #include <mxio/debug.h>
 #include <mxio/dispatcher.h>
 #include <mxio/io.h>
@@ -269,6 +270,7 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         if (!readable(ios->io_flags)) {
             return MX_ERR_BAD_HANDLE;
         }
+        mxtl::AutoLock lock(&vn->vnlock_);
         ssize_t r = vn->Read(msg->data, arg, ios->io_off);
         if (r >= 0) {
             ios->io_off += r;
@@ -281,6 +283,7 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         if (!readable(ios->io_flags)) {
             return MX_ERR_BAD_HANDLE;
         }
+        mxtl::AutoLock lock(&vn->vnlock_);
         ssize_t r = vn->Read(msg->data, arg, msg->arg2.off);
         if (r >= 0) {
             msg->datalen = static_cast<uint32_t>(r);
@@ -291,6 +294,10 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         if (!writable(ios->io_flags)) {
             return MX_ERR_BAD_HANDLE;
         }
+        // Hold the vnode lock across the Getattr and the Write, so
+        // O_APPEND writes land at the (current) end of the file even when
+        // other connections are appending concurrently.
+        mxtl::AutoLock lock(&vn->vnlock_);
         if (ios->io_flags & O_APPEND) {
             vnattr_t attr;
             mx_status_t r;
@@ -310,12 +317,133 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         if (!writable(ios->io_flags)) {
             return MX_ERR_BAD_HANDLE;
         }
+        mxtl::AutoLock lock(&vn->vnlock_);
         ssize_t r = vn->Write(msg->data, len, msg->arg2.off);
         return static_cast<mx_status_t>(r);
     }
+    case MXRIO_READ_VMO: {
+        // Bulk read: fill the client-provided VMO (starting at VMO offset
+        // zero) and reply once with the byte count, rather than moving the
+        // data a chunk per round trip. An arg2.off of -1 means "use (and
+        // advance) the connection's offset".
+        mx_handle_t vmo = msg->handle[0];
+        if (!readable(ios->io_flags)) {
+            mx_handle_close(vmo);
+            return MX_ERR_BAD_HANDLE;
+        }
+        if (arg < 0) {
+            mx_handle_close(vmo);
+            return MX_ERR_INVALID_ARGS;
+        }
+        mxtl::AutoLock lock(&vn->vnlock_);
+        size_t off = (msg->arg2.off < 0) ? ios->io_off
+                                         : static_cast<size_t>(msg->arg2.off);
+        char buf[MXIO_CHUNK_SIZE];
+        size_t count = static_cast<size_t>(arg);
+        size_t actual = 0;
+        mx_status_t status = MX_OK;
+        while (actual < count) {
+            size_t xfer = count - actual;
+            if (xfer > MXIO_CHUNK_SIZE) {
+                xfer = MXIO_CHUNK_SIZE;
+            }
+            ssize_t nread = vn->Read(buf, xfer, off + actual);
+            if (nread < 0) {
+                status = static_cast<mx_status_t>(nread);
+                break;
+            } else if (nread == 0) {
+                break;
+            }
+            size_t nwritten;
+            if ((status = mx_vmo_write(vmo, buf, actual, nread, &nwritten)) != MX_OK) {
+                break;
+            } else if (nwritten != static_cast<size_t>(nread)) {
+                status = MX_ERR_IO;
+                break;
+            }
+            actual += nread;
+            if (static_cast<size_t>(nread) < xfer) {
+                break; // short read
+            }
+        }
+        mx_handle_close(vmo);
+        if ((actual == 0) && (status != MX_OK)) {
+            return status;
+        }
+        if (msg->arg2.off < 0) {
+            ios->io_off = off + actual;
+        }
+        msg->arg2.off = off + actual;
+        return static_cast<mx_status_t>(actual);
+    }
+    case MXRIO_WRITE_VMO: {
+        // Bulk write: drain the client-provided VMO (starting at VMO
+        // offset zero); see MXRIO_READ_VMO above.
+        mx_handle_t vmo = msg->handle[0];
+        if (!writable(ios->io_flags)) {
+            mx_handle_close(vmo);
+            return MX_ERR_BAD_HANDLE;
+        }
+        if (arg < 0) {
+            mx_handle_close(vmo);
+            return MX_ERR_INVALID_ARGS;
+        }
+        mxtl::AutoLock lock(&vn->vnlock_);
+        size_t off;
+        if (msg->arg2.off < 0) {
+            off = ios->io_off;
+            if (ios->io_flags & O_APPEND) {
+                vnattr_t attr;
+                mx_status_t r;
+                if ((r = vn->Getattr(&attr)) < 0) {
+                    mx_handle_close(vmo);
+                    return r;
+                }
+                off = attr.size;
+            }
+        } else {
+            off = static_cast<size_t>(msg->arg2.off);
+        }
+        char buf[MXIO_CHUNK_SIZE];
+        size_t count = static_cast<size_t>(arg);
+        size_t actual = 0;
+        mx_status_t status = MX_OK;
+        while (actual < count) {
+            size_t xfer = count - actual;
+            if (xfer > MXIO_CHUNK_SIZE) {
+                xfer = MXIO_CHUNK_SIZE;
+            }
+            size_t nread;
+            if ((status = mx_vmo_read(vmo, buf, actual, xfer, &nread)) != MX_OK) {
+                break;
+            } else if (nread != xfer) {
+                status = MX_ERR_IO;
+                break;
+            }
+            ssize_t nwritten = vn->Write(buf, xfer, off + actual);
+            if (nwritten < 0) {
+                status = static_cast<mx_status_t>(nwritten);
+                break;
+            }
+            actual += nwritten;
+            if (static_cast<size_t>(nwritten) < xfer) {
+                break; // short write
+            }
+        }
+        mx_handle_close(vmo);
+        if ((actual == 0) && (status != MX_OK)) {
+            return status;
+        }
+        if (msg->arg2.off < 0) {
+            ios->io_off = off + actual;
+        }
+        msg->arg2.off = off + actual;
+        return static_cast<mx_status_t>(actual);
+    }
     case MXRIO_SEEK: {
         vnattr_t attr;
         mx_status_t r;
+        mxtl::AutoLock lock(&vn->vnlock_);
         if ((r = vn->Getattr(&attr)) < 0) {
             return r;
         }
@@ -375,12 +503,14 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
     case MXRIO_STAT: {
         mx_status_t r;
         msg->datalen = sizeof(vnattr_t);
+        mxtl::AutoLock lock(&vn->vnlock_);
         if ((r = vn->Getattr((vnattr_t*)msg->data)) < 0) {
             return r;
         }
         return msg->datalen;
     }
     case MXRIO_SETATTR: {
+        mxtl::AutoLock lock(&vn->vnlock_);
         mx_status_t r = vn->Setattr((vnattr_t*)msg->data);
         return r;
     }
@@ -415,6 +545,47 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         }
         return r;
     }
+    case MXRIO_READDIR_VMO: {
+        mx_handle_t vmo = msg->handle[0];
+        if (arg < MXIO_CHUNK_SIZE) {
+            mx_handle_close(vmo);
+            return MX_ERR_INVALID_ARGS;
+        }
+        // Fill the client's vmo in a single pass, bouncing dirents
+        // through a chunk-sized buffer.  Holding the vfs lock across
+        // the pass keeps the listing coherent and lets the filesystem
+        // walk its directory once instead of re-seeking from the
+        // cookie for every chunk.
+        uint64_t off = 0;
+        size_t len = static_cast<size_t>(arg);
+        mx_status_t r = MX_OK;
+        {
+            mxtl::AutoLock lock(&ios->vfs->vfs_lock_);
+            char buf[MXIO_CHUNK_SIZE];
+            // only issue full-sized chunks, so that a short return
+            // from Readdir always means the directory is exhausted
+            // rather than a dirent failing to fit in a partial chunk
+            while (len >= sizeof(buf)) {
+                r = vn->Readdir(&ios->dircookie, buf, sizeof(buf));
+                if (r <= 0) {
+                    break;
+                }
+                size_t actual;
+                if ((mx_vmo_write(vmo, buf, off, r, &actual) != MX_OK) ||
+                    (actual != static_cast<size_t>(r))) {
+                    r = MX_ERR_IO;
+                    break;
+                }
+                off += r;
+                len -= r;
+            }
+        }
+        mx_handle_close(vmo);
+        if ((r < 0) && (off == 0)) {
+            return r;
+        }
+        return static_cast<mx_status_t>(off);
+    }
     case MXRIO_IOCTL_1H: {
         if ((len > MXIO_IOCTL_MAX_INPUT) ||
             (arg > (ssize_t)sizeof(msg->data)) ||
@@ -445,8 +616,12 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
             }
             // If our permissions validate, fall through to the VFS ioctl
         }
-        ssize_t r = ios->vfs->Ioctl(mxtl::move(vn), msg->arg2.op, in_buf, len,
-                                    msg->data, arg);
+        ssize_t r;
+        {
+            mxtl::AutoLock lock(&vn->vnlock_);
+            r = ios->vfs->Ioctl(mxtl::move(vn), msg->arg2.op, in_buf, len,
+                                msg->data, arg);
+        }
 
         if (r == MX_ERR_NOT_SUPPORTED) {
             mx_handle_close(msg->handle[0]);
@@ -484,9 +659,11 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
                 break;
             }
             // If our permissions validate, fall through to the VFS ioctl
-        default:
+        default: {
+            mxtl::AutoLock lock(&vn->vnlock_);
             r = ios->vfs->Ioctl(mxtl::move(vn), msg->arg2.op, in_buf, len, msg->data, arg);
         }
+        }
         if (r >= 0) {
             switch (IOCTL_KIND(msg->arg2.op)) {
             case IOCTL_KIND_DEFAULT:
@@ -516,6 +693,7 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         if (msg->arg2.off < 0) {
             return MX_ERR_INVALID_ARGS;
         }
+        mxtl::AutoLock lock(&vn->vnlock_);
         return vn->Truncate(msg->arg2.off);
     }
     case MXRIO_RENAME:
@@ -575,6 +753,7 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
             return MX_ERR_ACCESS_DENIED;
         }
 
+        mxtl::AutoLock lock(&vn->vnlock_);
         mx_status_t status = vn->Mmap(data->flags, data->length, &data->offset,
                                       &msg->handle[0]);
         if (status == MX_OK) {
@@ -583,10 +762,13 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
         return status;
     }
     case MXRIO_SYNC: {
+        mxtl::AutoLock lock(&vn->vnlock_);
         return vn->Sync();
     }
-    case MXRIO_UNLINK:
+    case MXRIO_UNLINK: {
+        mxtl::AutoLock lock(&ios->vfs->vfs_lock_);
         return ios->vfs->Unlink(mxtl::move(vn), (const char*)msg->data, len);
+    }
     default:
         // close inbound handles so they do not leak
         for (unsigned i = 0; i < MXRIO_HC(msg->op); i++) {
@@ -596,15 +778,20 @@ static mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mxtl::RefPtr<fs::Vnode> vn,
     }
 }
 
-// TODO(orr): temporary; prevent multithread weirdness while we
-// make locking more fine grained
-static mtx_t vfs_big_lock = MTX_INIT;
-
 mx_status_t vfs_handler(mxrio_msg_t* msg, void* cookie) {
     vfs_iostate_t* ios = static_cast<vfs_iostate_t*>(cookie);
-
-    mxtl::AutoLock lock(&vfs_big_lock);
     mxtl::RefPtr<fs::Vnode> vn = ios->vn;
-    mx_status_t status = vfs_handler_vn(msg, mxtl::move(vn), ios);
-    return status;
+
+    // Filesystems which have not yet adopted finer-grained locking may ask
+    // to have all of their messages serialized (see Vfs::SetSerializeAll).
+    if (ios->vfs->serialize_all_) {
+        mxtl::AutoLock lock(&ios->vfs->handler_lock_);
+        return vfs_handler_vn(msg, mxtl::move(vn), ios);
+    }
+
+    // Otherwise, no global lock is held here: messages for a single
+    // connection are serialized by the dispatcher, iostate is only touched
+    // by that connection, and vnode state is guarded by the per-vnode lock
+    // (or vfs_lock_, for operations on the directory hierarchy).
+    return vfs_handler_vn(msg, mxtl::move(vn), ios);
 }
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 
 #ifdef __Fuchsia__
@@ -20,6 +21,69 @@
 
 namespace fs {
 
+namespace {
+
+// Deferred flush machinery shared by all watched directories.  Containers
+// with buffered events queue themselves here; a single lazily-created
+// flusher thread transmits each batch once the coalescing window closes.
+constexpr mx_time_t kWatchFlushWindow = MX_MSEC(5);
+
+struct WatchFlusher {
+    mxtl::Mutex lock;
+    cnd_t cond;
+    bool thread_running = false;
+    mxtl::DoublyLinkedList<WatcherContainer*> dirty;
+};
+
+WatchFlusher g_flusher;
+
+int WatchFlushThread(void*) {
+    for (;;) {
+        {
+            mxtl::AutoLock lock(&g_flusher.lock);
+            while (g_flusher.dirty.is_empty()) {
+                cnd_wait(&g_flusher.cond, g_flusher.lock.GetInternal());
+            }
+        }
+        // Let the window fill before transmitting.
+        mx_nanosleep(mx_deadline_after(kWatchFlushWindow));
+        mxtl::AutoLock lock(&g_flusher.lock);
+        while (!g_flusher.dirty.is_empty()) {
+            // Holding the flusher lock keeps the container alive: its
+            // destructor must take the same lock to deregister.
+            g_flusher.dirty.pop_front()->FlushPending();
+        }
+    }
+    return 0;
+}
+
+// Queue |container| for a deferred flush, starting the flusher on first use.
+// Falls back to flushing inline if no thread can be created.
+void WatchFlushQueue(WatcherContainer* container) {
+    {
+        mxtl::AutoLock lock(&g_flusher.lock);
+        if (!g_flusher.thread_running) {
+            cnd_init(&g_flusher.cond);
+            thrd_t t;
+            if (thrd_create_with_name(&t, WatchFlushThread, nullptr,
+                                      "vfs-watch-flush") == thrd_success) {
+                thrd_detach(t);
+                g_flusher.thread_running = true;
+            }
+        }
+        if (g_flusher.thread_running) {
+            if (!container->InContainer()) {
+                g_flusher.dirty.push_back(container);
+                cnd_signal(&g_flusher.cond);
+            }
+            return;
+        }
+    }
+    container->FlushPending();
+}
+
+} // namespace
+
 VnodeWatcher::VnodeWatcher(mx::channel h, uint32_t mask) : h(mxtl::move(h)),
     mask(mask & ~(VFS_WATCH_MASK_EXISTING | VFS_WATCH_MASK_IDLE)) {}
 
@@ -55,6 +119,32 @@ mx_status_t WatchBuffer::Send(const mx::channel& c) {
     return MX_OK;
 }
 
+mx_status_t WatchBuffer::TryAddMsg(unsigned event, const char* name, size_t len) {
+    size_t mlen = sizeof(vfs_watch_msg_t) + len;
+    if (mlen + watch_buf_size_ > sizeof(watch_buf_)) {
+        return MX_ERR_NO_MEMORY;
+    }
+    vfs_watch_msg_t* vmsg = reinterpret_cast<vfs_watch_msg_t*>((uintptr_t)watch_buf_ + watch_buf_size_);
+    vmsg->event = static_cast<uint8_t>(event);
+    vmsg->len = static_cast<uint8_t>(len);
+    memcpy(vmsg->name, name, len);
+    watch_buf_size_ += mlen;
+    return MX_OK;
+}
+
+bool WatchBuffer::Contains(unsigned event, const char* name, size_t len) const {
+    size_t off = 0;
+    while (off + sizeof(vfs_watch_msg_t) <= watch_buf_size_) {
+        auto vmsg = reinterpret_cast<const vfs_watch_msg_t*>((uintptr_t)watch_buf_ + off);
+        if ((vmsg->event == event) && (vmsg->len == len) &&
+            (memcmp(vmsg->name, name, len) == 0)) {
+            return true;
+        }
+        off += sizeof(vfs_watch_msg_t) + vmsg->len;
+    }
+    return false;
+}
+
 mx_status_t WatcherContainer::WatchDir(mx_handle_t* out) {
     AllocChecker ac;
     mxtl::unique_ptr<VnodeWatcher> watcher(new (&ac) VnodeWatcher(mx::channel(),
@@ -133,29 +223,60 @@ mx_status_t WatcherContainer::WatchDirV2(Vfs* vfs, Vnode* vn, const vfs_watch_di
     return MX_OK;
 }
 
+WatcherContainer::~WatcherContainer() {
+    mxtl::AutoLock lock(&g_flusher.lock);
+    if (InContainer()) {
+        g_flusher.dirty.erase(*this);
+    }
+}
+
 void WatcherContainer::Notify(const char* name, size_t len, unsigned event) {
     if (len > VFS_WATCH_NAME_MAX) {
         return;
     }
 
-    mxtl::AutoLock lock(&lock_);
+    bool buffered = false;
+    {
+        mxtl::AutoLock lock(&lock_);
 
-    if (watch_list_.is_empty()) {
-        return;
+        for (auto& watcher : watch_list_) {
+            if (!(watcher.mask & VFS_WATCH_EVT_MASK(event))) {
+                continue;
+            }
+            if (watcher.overflowed ||
+                watcher.pending.Contains(event, name, len)) {
+                // Already dropped or already buffered; either way the
+                // client learns nothing new from this event.
+                buffered = true;
+                continue;
+            }
+            if (watcher.pending.TryAddMsg(event, name, len) != MX_OK) {
+                watcher.overflowed = true;
+            }
+            buffered = true;
+        }
     }
 
-    uint8_t msg[sizeof(vfs_watch_msg_t) + len];
-    vfs_watch_msg_t* vmsg = reinterpret_cast<vfs_watch_msg_t*>(msg);
-    vmsg->event = static_cast<uint8_t>(event);
-    vmsg->len = static_cast<uint8_t>(len);
-    memcpy(vmsg->name, name, len);
+    // Queue the deferred flush outside lock_: the flusher takes its own
+    // lock first and then lock_, so the order must not be inverted here.
+    if (buffered) {
+        WatchFlushQueue(this);
+    }
+}
+
+void WatcherContainer::FlushPending() {
+    mxtl::AutoLock lock(&lock_);
 
     for (auto it = watch_list_.begin(); it != watch_list_.end();) {
-        if (!(it->mask & VFS_WATCH_EVT_MASK(event))) {
-            continue;
+        mx_status_t status = it->pending.Send(it->h);
+        if ((status == MX_OK) && it->overflowed) {
+            // Tell the client events were dropped so it can rescan.
+            vfs_watch_msg_t vmsg;
+            vmsg.event = VFS_WATCH_EVT_OVERFLOW;
+            vmsg.len = 0;
+            status = it->h.write(0, &vmsg, sizeof(vmsg), nullptr, 0);
         }
-
-        mx_status_t status = it->h.write(0, msg, static_cast<uint32_t>(sizeof(msg)), nullptr, 0);
+        it->overflowed = false;
         if (status < 0) {
             // Lazily remove watchers when their handles cannot accept incoming
             // watch messages.
@@ -76,6 +76,51 @@ static uint32_t ARGB8888_to_RGB2220(uint32_t in) {
     return out;
 }
 
+// Grow the surface's dirty bounding box to cover an already-clipped
+// rectangle of modified pixels.
+static void mark_dirty(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height) {
+    if (x < surface->dirty_x0)
+        surface->dirty_x0 = x;
+    if (y < surface->dirty_y0)
+        surface->dirty_y0 = y;
+    if (x + width - 1 > surface->dirty_x1)
+        surface->dirty_x1 = x + width - 1;
+    if (y + height - 1 > surface->dirty_y1)
+        surface->dirty_y1 = y + height - 1;
+}
+
+void gfx_surface_mark_dirty(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height) {
+    if (x >= surface->width)
+        return;
+    if (y >= surface->height)
+        return;
+    if (width == 0 || height == 0)
+        return;
+
+    if (x + width > surface->width)
+        width = surface->width - x;
+    if (y + height > surface->height)
+        height = surface->height - y;
+
+    mark_dirty(surface, x, y, width, height);
+}
+
+bool gfx_get_dirty_rows(gfx_surface* surface, unsigned* start, unsigned* end) {
+    if (surface->dirty_y0 > surface->dirty_y1)
+        return false;
+
+    *start = surface->dirty_y0;
+    *end = surface->dirty_y1;
+    return true;
+}
+
+void gfx_clear_dirty(gfx_surface* surface) {
+    surface->dirty_x0 = surface->width;
+    surface->dirty_y0 = surface->height;
+    surface->dirty_x1 = 0;
+    surface->dirty_y1 = 0;
+}
+
 /**
  * @brief  Copy a rectangle of pixels from one part of the display to another.
  */
@@ -105,6 +150,7 @@ void gfx_copyrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width,
         height = surface->height - y2;
 
     surface->copyrect(surface, x, y, width, height, x2, y2);
+    mark_dirty(surface, x2, y2, width, height);
 }
 
 void gfx_copylines(gfx_surface* dst, gfx_surface* src, unsigned srcy, unsigned dsty, unsigned height) {
@@ -120,6 +166,7 @@ void gfx_copylines(gfx_surface* dst, gfx_surface* src, unsigned srcy, unsigned d
     memcpy(dst->ptr + dsty * dst->stride * dst->pixelsize,
            src->ptr + srcy * src->stride * src->pixelsize,
            height * src->stride * src->pixelsize);
+    mark_dirty(dst, 0, dsty, dst->width, height);
 }
 
 /**
@@ -144,6 +191,7 @@ void gfx_fillrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width,
         height = surface->height - y;
 
     surface->fillrect(surface, x, y, width, height, color);
+    mark_dirty(surface, x, y, width, height);
 }
 
 /**
@@ -156,6 +204,7 @@ void gfx_putpixel(gfx_surface* surface, unsigned x, unsigned y, unsigned color)
         return;
 
     surface->putpixel(surface, x, y, color);
+    mark_dirty(surface, x, y, 1, 1);
 }
 
 static void putpixel16(gfx_surface* surface, unsigned x, unsigned y, unsigned color) {
@@ -212,156 +261,78 @@ void gfx_putchar(gfx_surface* surface, const gfx_font* font, unsigned ch, unsign
         bg = surface->translate_color(bg);
     }
     surface->putchar(surface, font, ch, x, y, fg, bg);
+    mark_dirty(surface, x, y, font->width, font->height);
 }
 
-static void copyrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint8_t* src = &((const uint8_t*)surface->ptr)[x + y * surface->stride];
-    uint8_t* dest = &((uint8_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
+// Copy a rect a row at a time with memmove, which the architectures
+// provide optimized wide-copy implementations of. Rows are walked in an
+// order which is safe for overlapping source and destination.
+static void copyrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
+    const size_t rowbytes = (size_t)width * surface->pixelsize;
+    const size_t stridebytes = (size_t)surface->stride * surface->pixelsize;
+    const uint8_t* src = &((const uint8_t*)surface->ptr)[(x + y * surface->stride) * surface->pixelsize];
+    uint8_t* dest = &((uint8_t*)surface->ptr)[(x2 + y2 * surface->stride) * surface->pixelsize];
 
     if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
+        for (unsigned i = 0; i < height; i++) {
+            memmove(dest, src, rowbytes);
+            dest += stridebytes;
+            src += stridebytes;
         }
     } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        // copy bottom up, so overlapping rows are read before they are
+        // overwritten
+        src += (height - 1) * stridebytes;
+        dest += (height - 1) * stridebytes;
+
+        for (unsigned i = 0; i < height; i++) {
+            memmove(dest, src, rowbytes);
+            dest -= stridebytes;
+            src -= stridebytes;
         }
     }
 }
 
 static void fillrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint8_t* dest = &((uint8_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
     uint8_t color8 = (uint8_t)(surface->translate_color(color));
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color8;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
-
-static void copyrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint16_t* src = &((const uint16_t*)surface->ptr)[x + y * surface->stride];
-    uint16_t* dest = &((uint16_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    for (unsigned i = 0; i < height; i++) {
+        memset(dest, color8, width);
+        dest += surface->stride;
     }
 }
 
 static void fillrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint16_t* dest = &((uint16_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
     uint16_t color16 = (uint16_t)(surface->translate_color(color));
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color16;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
+    for (unsigned j = 0; j < width; j++)
+        dest[j] = color16;
 
-static void copyrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint32_t* src = &((const uint32_t*)surface->ptr)[x + y * surface->stride];
-    uint32_t* dest = &((uint32_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    // every remaining row is identical to the first; replicate it with
+    // memcpy rather than storing a pixel at a time
+    uint16_t* row = dest;
+    for (unsigned i = 1; i < height; i++) {
+        dest += surface->stride;
+        memcpy(dest, row, width * sizeof(uint16_t));
     }
 }
 
 static void fillrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint32_t* dest = &((uint32_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
+    for (unsigned j = 0; j < width; j++)
+        dest[j] = color;
+
+    // every remaining row is identical to the first; replicate it with
+    // memcpy rather than storing a pixel at a time
+    uint32_t* row = dest;
+    for (unsigned i = 1; i < height; i++) {
+        dest += surface->stride;
+        memcpy(dest, row, width * sizeof(uint32_t));
     }
 }
 
@@ -414,6 +385,10 @@ void gfx_line(gfx_surface* surface, unsigned x1, unsigned y1, unsigned x2, unsig
             surface->putpixel(surface, px, py, color);
         }
     }
+
+    unsigned left = (x1 < x2) ? x1 : x2;
+    unsigned top = (y1 < y2) ? y1 : y2;
+    mark_dirty(surface, left, top, dxabs + 1, dyabs + 1);
 }
 
 uint32_t alpha32_add_ignore_destalpha(uint32_t dest, uint32_t src) {
@@ -494,20 +469,12 @@ void gfx_blend(gfx_surface* target, gfx_surface* source, unsigned srcx, unsigned
         // 16 bit to 16 bit
         const uint16_t* src = &((const uint16_t*)source->ptr)[srcx + srcy * source->stride];
         uint16_t* dest = &((uint16_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
 
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
+        unsigned i;
         for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+            memcpy(dest, src, width * sizeof(uint16_t));
+            dest += target->stride;
+            src += source->stride;
         }
     } else if (source->format == MX_PIXEL_FORMAT_ARGB_8888 && target->format == MX_PIXEL_FORMAT_ARGB_8888) {
         // both are 32 bit modes, both alpha
@@ -533,44 +500,30 @@ void gfx_blend(gfx_surface* target, gfx_surface* source, unsigned srcx, unsigned
         // both are 32 bit modes, no alpha
         const uint32_t* src = &((const uint32_t*)source->ptr)[srcx + srcy * source->stride];
         uint32_t* dest = &((uint32_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
 
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
+        unsigned i;
         for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+            memcpy(dest, src, width * sizeof(uint32_t));
+            dest += target->stride;
+            src += source->stride;
         }
     } else if (source->format == MX_PIXEL_FORMAT_MONO_1 && target->format == MX_PIXEL_FORMAT_MONO_1) {
         // both are 8 bit modes, no alpha
         const uint8_t* src = &((const uint8_t*)source->ptr)[srcx + srcy * source->stride];
         uint8_t* dest = &((uint8_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
 
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
+        unsigned i;
         for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+            memcpy(dest, src, width);
+            dest += target->stride;
+            src += source->stride;
         }
     } else {
         xprintf("gfx_surface_blend: unimplemented colorspace combination (source %d target %d)\n", source->format, target->format);
         assert(0);
     }
+
+    mark_dirty(target, destx, desty, width, height);
 }
 
 /**
@@ -584,6 +537,8 @@ void gfx_flush(gfx_surface* surface) {
 
     if (surface->flush)
         surface->flush(0, surface->height - 1);
+
+    gfx_clear_dirty(surface);
 }
 
 /**
@@ -612,6 +567,18 @@ void gfx_flush_rows(struct gfx_surface* surface, unsigned start, unsigned end) {
         surface->flush(start, end);
 }
 
+/**
+ * @brief  Flush only the rows modified since the last flush.
+ */
+void gfx_flush_dirty(gfx_surface* surface) {
+    unsigned start, end;
+    if (!gfx_get_dirty_rows(surface, &start, &end))
+        return;
+
+    gfx_flush_rows(surface, start, end);
+    gfx_clear_dirty(surface);
+}
+
 /**
  * @brief  Create a new graphics surface object
  */
@@ -644,7 +611,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
     switch (format) {
     case MX_PIXEL_FORMAT_RGB_565:
         surface->translate_color = &ARGB8888_to_RGB565;
-        surface->copyrect = &copyrect16;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect16;
         surface->putpixel = &putpixel16;
         surface->putchar = &putchar16;
@@ -654,7 +621,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
     case MX_PIXEL_FORMAT_RGB_x888:
     case MX_PIXEL_FORMAT_ARGB_8888:
         surface->translate_color = NULL;
-        surface->copyrect = &copyrect32;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect32;
         surface->putpixel = &putpixel32;
         surface->putchar = &putchar32;
@@ -663,7 +630,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case MX_PIXEL_FORMAT_MONO_1:
         surface->translate_color = &ARGB8888_to_Luma;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -672,7 +639,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case MX_PIXEL_FORMAT_RGB_332:
         surface->translate_color = &ARGB8888_to_RGB332;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -681,7 +648,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case MX_PIXEL_FORMAT_RGB_2220:
         surface->translate_color = &ARGB8888_to_RGB2220;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -703,6 +670,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         surface->flags |= GFX_FLAG_FREE_ON_DESTROY;
     }
     surface->ptr = ptr;
+    gfx_clear_dirty(surface);
     return 0;
 }
 
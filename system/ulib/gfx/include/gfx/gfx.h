@@ -46,6 +46,10 @@ struct gfx_surface {
     size_t len;
     unsigned alpha;
 
+    // bounding box of pixels modified since the last flush;
+    // dirty_y0 > dirty_y1 means the surface is clean
+    unsigned dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+
     // function pointers
     uint32_t (*translate_color)(uint32_t input);
     void (*copyrect)(gfx_surface*, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2);
@@ -91,9 +95,23 @@ void gfx_flush(struct gfx_surface* surface);
 // flush a subset of the surface
 void gfx_flush_rows(struct gfx_surface* surface, unsigned start, unsigned end);
 
+// flush only the rows modified since the last flush
+void gfx_flush_dirty(struct gfx_surface* surface);
+
+// grow the dirty region to cover a rectangle modified behind the
+// library's back (e.g. by writing to ptr directly)
+void gfx_surface_mark_dirty(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height);
+
+// fetch the bounding rows modified since the dirty region was last
+// cleared; returns false if the surface is clean
+bool gfx_get_dirty_rows(gfx_surface* surface, unsigned* start, unsigned* end);
+
+// reset the dirty region to empty
+void gfx_clear_dirty(gfx_surface* surface);
+
 // clear the entire surface with a color
 static inline void gfx_clear(gfx_surface* surface, unsigned color) {
-    surface->fillrect(surface, 0, 0, surface->width, surface->height, color);
+    gfx_fillrect(surface, 0, 0, surface->width, surface->height, color);
     gfx_flush(surface);
 }
 
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <block-client/client.h>
 #include <hypervisor/block.h>
 #include <hypervisor/vcpu.h>
 #include <magenta/syscalls.h>
@@ -113,6 +114,8 @@ mx_status_t handle_virtio_block_write(vcpu_context_t* vcpu_context, uint16_t por
         mx_status_t status;
         if (block_fd < 0) {
             status = null_block_device(queue, mem_addr, mem_size);
+        } else if (vcpu_context->guest_state->block_fifo != NULL) {
+            status = fifo_block_device(queue, mem_addr, mem_size, vcpu_context->guest_state);
         } else {
             status = file_block_device(queue, mem_addr, mem_size, block_fd);
         }
@@ -254,3 +257,93 @@ mx_status_t file_block_device(virtio_queue_t* queue, void* mem_addr, size_t mem_
     file_state_t state = { fd, 0 };
     return handle_virtio_queue(queue, mem_addr, mem_size, sizeof(virtio_blk_req_t), &state, file_req);
 }
+
+// Forwards virtio descriptor chains into the block fifo. Guest memory is
+// attached to the device as a VMO, so payload descriptors are queued by
+// guest-physical offset and the device reads or writes guest memory
+// directly; the request data never passes through this process. A chain's
+// payload descriptors are submitted as a single transaction, which the
+// fifo client may coalesce further.
+mx_status_t fifo_block_device(virtio_queue_t* queue, void* mem_addr, size_t mem_size,
+                              guest_state_t* guest_state) {
+    block_fifo_request_t requests[MAX_TXN_MESSAGES];
+    for (; queue->index < queue->avail->idx; queue->index++, queue->used->idx++) {
+        uint16_t desc_index = queue->avail->ring[ring_index(queue, queue->index)];
+        if (desc_index >= queue->size)
+            return MX_ERR_OUT_OF_RANGE;
+        volatile struct vring_used_elem* used =
+            &queue->used->ring[ring_index(queue, queue->used->idx)];
+        used->id = desc_index;
+
+        virtio_blk_req_t* blk_req = NULL;
+        uint64_t dev_offset = 0;
+        uint32_t queued_len = 0;
+        size_t count = 0;
+        mx_status_t chain_status = MX_OK;
+        while (true) {
+            struct vring_desc desc = queue->desc[desc_index];
+            const uint64_t end = desc.addr + desc.len;
+            if (end < desc.addr || end > mem_size)
+                return MX_ERR_OUT_OF_RANGE;
+            if (blk_req == NULL) {
+                // Header.
+                if (desc.len != sizeof(virtio_blk_req_t))
+                    return MX_ERR_INVALID_ARGS;
+                blk_req = mem_addr + desc.addr;
+                dev_offset = blk_req->sector * SECTOR_SIZE;
+            } else if (desc.flags & VRING_DESC_F_NEXT) {
+                // Payload.
+                uint16_t opcode = 0;
+                switch (blk_req->type) {
+                case VIRTIO_BLK_T_IN:
+                    opcode = BLOCKIO_READ;
+                    break;
+                case VIRTIO_BLK_T_OUT:
+                    opcode = BLOCKIO_WRITE;
+                    break;
+                default:
+                    chain_status = MX_ERR_INVALID_ARGS;
+                }
+                if (chain_status == MX_OK && count == MAX_TXN_MESSAGES) {
+                    chain_status = block_fifo_txn(guest_state->block_fifo, requests, count);
+                    count = 0;
+                }
+                if (chain_status == MX_OK) {
+                    requests[count].txnid = guest_state->block_txnid;
+                    requests[count].vmoid = guest_state->block_vmoid;
+                    requests[count].opcode = opcode;
+                    requests[count].length = desc.len;
+                    requests[count].vmo_offset = desc.addr;
+                    requests[count].dev_offset = dev_offset;
+                    count++;
+                    dev_offset += desc.len;
+                    queued_len += desc.len;
+                }
+            } else {
+                // Status.
+                if (desc.len != sizeof(uint8_t))
+                    return MX_ERR_INVALID_ARGS;
+                if (blk_req->type == VIRTIO_BLK_T_FLUSH) {
+                    // See note in file_req.
+                    if (blk_req->sector != 0)
+                        chain_status = MX_ERR_IO_DATA_INTEGRITY;
+                    else if (fsync(guest_state->block_fd) != 0)
+                        chain_status = MX_ERR_IO;
+                } else if (chain_status == MX_OK) {
+                    chain_status = block_fifo_txn(guest_state->block_fifo, requests, count);
+                }
+                uint8_t* virtio_status = mem_addr + desc.addr;
+                if (chain_status == MX_OK) {
+                    *virtio_status = VIRTIO_BLK_S_OK;
+                    used->len += queued_len;
+                } else {
+                    fprintf(stderr, "Block fifo request failed %d\n", chain_status);
+                    *virtio_status = VIRTIO_BLK_S_IOERR;
+                }
+                break;
+            }
+            desc_index = desc.next;
+        };
+    }
+    return MX_OK;
+}
@@ -20,3 +20,5 @@ mx_status_t handle_virtio_block_write(vcpu_context_t* context, uint16_t port,
 
 mx_status_t null_block_device(virtio_queue_t* queue, void* mem_addr, size_t mem_size);
 mx_status_t file_block_device(virtio_queue_t* queue, void* mem_addr, size_t mem_size, int fd);
+mx_status_t fifo_block_device(virtio_queue_t* queue, void* mem_addr, size_t mem_size,
+                              guest_state_t* guest_state);
@@ -19,6 +19,7 @@
 struct vring_desc;
 struct vring_avail;
 struct vring_used;
+typedef struct fifo_client fifo_client_t;
 
 /* Stores the local APIC state across VM exits. */
 typedef struct local_apic_state {
@@ -90,6 +91,12 @@ typedef struct guest_state {
     // Guest block.
     int block_fd;
     uint64_t block_size;
+    // Non-NULL when the block device speaks the fifo protocol. Guest
+    // memory is attached to the device as block_vmoid, so requests move
+    // directly between the device and guest memory.
+    fifo_client_t* block_fifo;
+    uint16_t block_vmoid;
+    uint16_t block_txnid;
     virtio_queue_t block_queue;
 
     io_apic_state_t io_apic_state;
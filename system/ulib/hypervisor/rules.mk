@@ -30,7 +30,9 @@ MODULE_LIBS := \
     system/ulib/mxio \
 
 MODULE_STATIC_LIBS := \
+    system/ulib/block-client \
     system/ulib/ddk \
+    system/ulib/sync \
     system/ulib/virtio \
     third_party/ulib/acpica \
 
@@ -13,6 +13,7 @@
 #include <hypervisor/vcpu.h>
 #include <hw/pci.h>
 #include <magenta/assert.h>
+#include <virtio/virtio.h>
 #include <magenta/syscalls.h>
 #include <magenta/syscalls/hypervisor.h>
 
@@ -634,6 +635,71 @@ static int serial_loop(void* arg) {
     }
 }
 
+static int block_loop(void* arg) {
+    vcpu_context_t* vcpu_context = arg;
+    guest_state_t* guest_state = vcpu_context->guest_state;
+
+    mx_handle_t user_fifo;
+    mx_handle_t kernel_fifo;
+    mx_status_t status = fifo_create(&user_fifo, &kernel_fifo);
+    if (status != MX_OK) {
+        fprintf(stderr, "Failed to create block FIFO %d\n", status);
+        return status;
+    }
+
+    // Trap the virtio block queue notify port into the FIFO. The kernel
+    // coalesces back-to-back identical doorbell writes while one is still
+    // unread, so a burst of notifies costs a single ring slot.
+    uint16_t bar0 = guest_state->pci_device_state[PCI_DEVICE_VIRTIO_BLOCK].bar[0];
+    bar0 &= ~PCI_BAR_IO_TYPE_PIO;
+    struct {
+        mx_trap_address_space_t aspace;
+        mx_vaddr_t addr;
+        size_t len;
+        mx_handle_t fifo;
+    } trap_args = { MX_TRAP_IO, bar0 + VIRTIO_PCI_QUEUE_NOTIFY, 2, kernel_fifo };
+    status = mx_hypervisor_op(guest_state->guest, MX_HYPERVISOR_OP_GUEST_SET_TRAP,
+                              &trap_args, sizeof(trap_args), NULL, 0);
+    if (status != MX_OK) {
+        fprintf(stderr, "Failed to set trap for block FIFO %d\n", status);
+        return status;
+    }
+
+    mx_guest_packet_t packets[PAGE_SIZE / MX_GUEST_MAX_PKT_SIZE];
+    while (true) {
+        status = fifo_wait(user_fifo, MX_FIFO_READABLE);
+        if (status != MX_OK) {
+            fprintf(stderr, "Failed to wait for block FIFO %d\n", status);
+            return status;
+        }
+
+        // Drain the FIFO completely before blocking again. A batch of
+        // notifies needs only one pass over the virtio queue, so handle
+        // the last packet of each read.
+        uint32_t num_packets;
+        while ((status = mx_fifo_read(user_fifo, packets, sizeof(packets),
+                                      &num_packets)) == MX_OK) {
+            mx_guest_io_t* io = &packets[num_packets - 1].io;
+            if (packets[num_packets - 1].type != MX_GUEST_PKT_TYPE_IO ||
+                io->port != bar0 + VIRTIO_PCI_QUEUE_NOTIFY) {
+                fprintf(stderr, "Invalid packet for block FIFO\n");
+                return MX_ERR_INTERNAL;
+            }
+            mtx_lock(&guest_state->mutex);
+            status = handle_virtio_block_write(vcpu_context, VIRTIO_PCI_QUEUE_NOTIFY, io);
+            mtx_unlock(&guest_state->mutex);
+            if (status != MX_OK) {
+                fprintf(stderr, "Failed to handle block queue notify %d\n", status);
+                return status;
+            }
+        }
+        if (status != MX_ERR_SHOULD_WAIT) {
+            fprintf(stderr, "Failed to read from block FIFO %d\n", status);
+            return status;
+        }
+    }
+}
+
 static mx_status_t vcpu_state_read(vcpu_context_t* vcpu_context,
                                    mx_vcpu_state_t* vcpu_state) {
     return mx_hypervisor_op(vcpu_context->vcpu, MX_HYPERVISOR_OP_VCPU_READ_STATE,
@@ -665,6 +731,18 @@ mx_status_t vcpu_loop(vcpu_context_t* vcpu_context) {
         return MX_ERR_INTERNAL;
     }
 
+    thrd_t block_thread;
+    ret = thrd_create(&block_thread, block_loop, vcpu_context);
+    if (ret != thrd_success) {
+        fprintf(stderr, "Failed to create block thread %d\n", ret);
+        return MX_ERR_INTERNAL;
+    }
+    ret = thrd_detach(block_thread);
+    if (ret != thrd_success) {
+        fprintf(stderr, "Failed to detach block thread %d\n", ret);
+        return MX_ERR_INTERNAL;
+    }
+
     while (true) {
         mx_guest_packet_t packet;
         mx_status_t status = mx_hypervisor_op(vcpu_context->vcpu, MX_HYPERVISOR_OP_VCPU_RESUME,
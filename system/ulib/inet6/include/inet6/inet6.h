@@ -133,6 +133,13 @@ char* ip6toa(char* _out, void* ip6addr);
 void ip6_init(void* macaddr);
 void eth_recv(void* data, size_t len);
 
+// As eth_recv(), but with ETH_RX_* flags describing work the network
+// device already performed on the packet.
+void eth_recv_etc(void* data, size_t len, uint32_t flags);
+
+// the device verified the IP/TCP/UDP checksums of this packet
+#define ETH_RX_CSUM_OK (1u)
+
 typedef struct eth_buffer eth_buffer_t;
 
 // provided by interface driver
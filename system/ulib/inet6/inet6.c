@@ -96,9 +96,46 @@ ip6_addr_t ll_ip6_addr;
 mac_addr_t snm_mac_addr;
 ip6_addr_t snm_ip6_addr;
 
-// cache for the last source addresses we've seen
-static mac_addr_t rx_mac_addr;
-static ip6_addr_t rx_ip6_addr;
+// precomputed partial checksum of our link-local address, for the
+// source half of the transmit pseudo-header (see ip6_checksum)
+static uint16_t ll_src_csum;
+
+// neighbor cache: maps recently-seen IPv6 sources to their mac
+// addresses. direct-mapped by a hash of the address so lookup and
+// insert are O(1); a colliding neighbor simply replaces the old entry.
+#define NCACHE_SIZE 8 // must be a power of two
+
+typedef struct {
+    ip6_addr_t ip;
+    mac_addr_t mac;
+    bool valid;
+} ncache_entry_t;
+
+static ncache_entry_t ncache[NCACHE_SIZE];
+
+static ncache_entry_t* ncache_slot(const ip6_addr_t* ip) {
+    // on a local segment the interface identifier carries the entropy
+    uint32_t hash = (ip->u32[2] ^ ip->u32[3]) * 2654435761u;
+    return &ncache[(hash >> 16) & (NCACHE_SIZE - 1)];
+}
+
+static void ncache_put(const ip6_addr_t* ip, const mac_addr_t* mac) {
+    ncache_entry_t* e = ncache_slot(ip);
+    e->ip = *ip;
+    e->mac = *mac;
+    e->valid = true;
+}
+
+static bool ncache_get(const ip6_addr_t* ip, mac_addr_t* mac) {
+    ncache_entry_t* e = ncache_slot(ip);
+    if (e->valid && ip6_addr_eq(&e->ip, ip)) {
+        *mac = e->mac;
+        return true;
+    }
+    return false;
+}
+
+static uint16_t checksum(const void* _data, size_t len, uint16_t _sum);
 
 void ip6_init(void* macaddr) {
     char tmp[IP6TOAMAX];
@@ -115,6 +152,10 @@ void ip6_init(void* macaddr) {
     multicast_from_ip6(&all, &ip6_ll_all_nodes);
     eth_add_mcast_filter(&all);
 
+    // our source address never changes, so sum its share of the
+    // transmit pseudo-header once
+    ll_src_csum = checksum(&ll_ip6_addr, sizeof(ip6_addr_t), 0);
+
     printf("macaddr: %02x:%02x:%02x:%02x:%02x:%02x\n",
            ll_mac_addr.x[0], ll_mac_addr.x[1], ll_mac_addr.x[2],
            ll_mac_addr.x[3], ll_mac_addr.x[4], ll_mac_addr.x[5]);
@@ -131,10 +172,9 @@ static int resolve_ip6(mac_addr_t* _mac, const ip6_addr_t* _ip) {
         return 0;
     }
 
-    // Trying to send to the IP that we last received a packet from?
+    // A peer we've recently received a packet from?
     // Assume their mac address has not changed
-    if (ip6_addr_eq(_ip, &rx_ip6_addr)) {
-        memcpy(_mac, &rx_mac_addr, sizeof(rx_mac_addr));
+    if (ncache_get(_ip, _mac)) {
         return 0;
     }
 
@@ -143,19 +183,48 @@ static int resolve_ip6(mac_addr_t* _mac, const ip6_addr_t* _ip) {
 }
 
 static uint16_t checksum(const void* _data, size_t len, uint16_t _sum) {
-    uint32_t sum = _sum;
-    const uint16_t* data = _data;
+    uint64_t sum = _sum;
+    const uint8_t* data = _data;
+
+    // walk up to a word boundary (all callers start on even addresses)
+    while (((uintptr_t)data & 7) && (len > 1)) {
+        sum += *(const uint16_t*)data;
+        data += 2;
+        len -= 2;
+    }
+
+    // the bulk of the packet, a word at a time; the ones-complement sum
+    // is invariant under word size as long as carries wrap around
+    while (len >= 8) {
+        uint64_t word = *(const uint64_t*)data;
+        sum += word;
+        if (sum < word) {
+            sum++;
+        }
+        data += 8;
+        len -= 8;
+    }
+
     while (len > 1) {
-        sum += *data++;
+        sum += *(const uint16_t*)data;
+        data += 2;
         len -= 2;
     }
     if (len) {
         sum += (*data & 0xFF);
     }
-    while (sum > 0xFFFF) {
-        sum = (sum & 0xFFFF) + (sum >> 16);
-    }
-    return sum;
+
+    // fold back down to 16 bits
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)((sum & 0xFFFF) + (sum >> 16));
+}
+
+// combine two partial ones-complement sums
+static uint16_t csum_add(uint16_t a, uint16_t b) {
+    uint32_t sum = (uint32_t)a + b;
+    return (uint16_t)((sum & 0xFFFF) + (sum >> 16));
 }
 
 typedef struct {
@@ -176,8 +245,14 @@ unsigned ip6_checksum(ip6_hdr_t* ip, unsigned type, size_t length) {
 
     // length and protocol field for pseudo-header
     sum = checksum(&ip->length, 2, htons(type));
-    // src/dst for pseudo-header + payload
-    sum = checksum(&ip->src, 32 + length, sum);
+    if (ip6_addr_eq(&ip->src, &ll_ip6_addr)) {
+        // the usual case on transmit: our own source address was
+        // summed once at init, so skip it and cover dst + payload
+        sum = checksum(&ip->dst, 16 + length, csum_add(sum, ll_src_csum));
+    } else {
+        // src/dst for pseudo-header + payload
+        sum = checksum(&ip->src, 32 + length, sum);
+    }
 
     // 0 is illegal, so 0xffff remains 0xffff
     if (sum != 0xffff) {
@@ -262,21 +337,27 @@ fail:
     return -1;
 }
 
+// set while dispatching the current packet if the device already
+// verified its checksums, so the software checks below can be skipped
+static bool rx_csum_ok = false;
+
 void _udp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
     udp_hdr_t* udp = _data;
     uint16_t sum, n;
 
     if (len < UDP_HDR_LEN)
         BAD("Bogus Header Len");
-    if (udp->checksum == 0)
-        BAD("Checksum Invalid");
-    if (udp->checksum == 0xFFFF)
-        udp->checksum = 0;
-
-    sum = checksum(&ip->length, 2, htons(HDR_UDP));
-    sum = checksum(&ip->src, 32 + len, sum);
-    if (sum != 0xFFFF)
-        BAD("Checksum Incorrect");
+    if (!rx_csum_ok) {
+        if (udp->checksum == 0)
+            BAD("Checksum Invalid");
+        if (udp->checksum == 0xFFFF)
+            udp->checksum = 0;
+
+        sum = checksum(&ip->length, 2, htons(HDR_UDP));
+        sum = checksum(&ip->src, 32 + len, sum);
+        if (sum != 0xFFFF)
+            BAD("Checksum Incorrect");
+    }
 
     n = ntohs(udp->length);
     if (n < UDP_HDR_LEN)
@@ -294,15 +375,17 @@ void icmp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
     icmp6_hdr_t* icmp = _data;
     uint16_t sum;
 
-    if (icmp->checksum == 0)
-        BAD("Checksum Invalid");
-    if (icmp->checksum == 0xFFFF)
-        icmp->checksum = 0;
+    if (!rx_csum_ok) {
+        if (icmp->checksum == 0)
+            BAD("Checksum Invalid");
+        if (icmp->checksum == 0xFFFF)
+            icmp->checksum = 0;
 
-    sum = checksum(&ip->length, 2, htons(HDR_ICMP6));
-    sum = checksum(&ip->src, 32 + len, sum);
-    if (sum != 0xFFFF)
-        BAD("Checksum Incorrect");
+        sum = checksum(&ip->length, 2, htons(HDR_ICMP6));
+        sum = checksum(&ip->src, 32 + len, sum);
+        if (sum != 0xFFFF)
+            BAD("Checksum Incorrect");
+    }
 
     if (icmp->type == ICMP6_NDP_N_SOLICIT) {
         ndp_n_hdr_t* ndp = _data;
@@ -342,10 +425,16 @@ void icmp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
 }
 
 void eth_recv(void* _data, size_t len) {
+    eth_recv_etc(_data, len, 0);
+}
+
+void eth_recv_etc(void* _data, size_t len, uint32_t flags) {
     uint8_t* data = _data;
     ip6_hdr_t* ip;
     uint32_t n;
 
+    rx_csum_ok = (flags & ETH_RX_CSUM_OK) != 0;
+
     if (len < (ETH_HDR_LEN + IP6_HDR_LEN))
         BAD("Bogus Header Len");
     if (data[12] != (ETH_IP6 >> 8))
@@ -376,9 +465,8 @@ void eth_recv(void* _data, size_t len) {
         return;
     }
 
-    // stash the sender's info to simplify replies
-    memcpy(&rx_mac_addr, (uint8_t*)_data + 6, ETH_ADDR_LEN);
-    rx_ip6_addr = ip->src;
+    // remember the sender to simplify replies
+    ncache_put(&ip->src, (const mac_addr_t*)((uint8_t*)_data + 6));
 
     switch (ip->next_header) {
     case HDR_ICMP6:
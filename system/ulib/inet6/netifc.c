@@ -384,7 +384,8 @@ void netifc_close(void) {
 static void rx_complete(void* ctx, void* cookie, size_t len, uint32_t flags) {
     eth_buffer_t* ethbuf = cookie;
     check_ethbuf(ethbuf, ETH_BUFFER_RX);
-    netifc_recv(ethbuf->data, len);
+    uint32_t rx_flags = (flags & ETH_FIFO_RX_CSUM_OK) ? ETH_RX_CSUM_OK : 0;
+    netifc_recv(ethbuf->data, len, rx_flags);
     eth_queue_rx(eth, ethbuf, ethbuf->data, NET_BUFFERSZ, 0);
 }
 
@@ -4,17 +4,10 @@
 
 #include "elf.h"
 
-#include <elfload/elfload.h>
-
 #include <magenta/process.h>
 #include <magenta/syscalls.h>
 #include <stdlib.h>
 
-struct elf_load_info {
-    elf_load_header_t header;
-    elf_phdr_t phdrs[];
-};
-
 void elf_load_destroy(elf_load_info_t* info) {
     free(info);
 }
@@ -25,14 +18,12 @@ mx_status_t elf_load_start(mx_handle_t vmo, const void* hdr_buf, size_t buf_sz,
     uintptr_t phoff;
     mx_status_t status = elf_load_prepare(vmo, hdr_buf, buf_sz, &header, &phoff);
     if (status == MX_OK) {
-        // Now allocate the data structure and read in the phdrs.
-        size_t phdrs_size = (size_t)header.e_phnum * sizeof(elf_phdr_t);
-        elf_load_info_t* info = malloc(sizeof(*info) + phdrs_size);
+        // Now allocate the cached descriptor and fill it in.
+        elf_load_info_t* info = malloc(ELF_LOAD_CACHED_SIZE(header.e_phnum));
         if (info == NULL)
             return MX_ERR_NO_MEMORY;
-        status = elf_load_read_phdrs(vmo, info->phdrs, phoff, header.e_phnum);
+        status = elf_load_cache(vmo, &header, phoff, info);
         if (status == MX_OK) {
-            info->header = header;
             *infop = info;
         } else {
             free(info);
@@ -70,8 +61,7 @@ mx_status_t elf_load_finish(mx_handle_t vmar, elf_load_info_t* info,
                             mx_handle_t vmo,
                             mx_handle_t* segments_vmar,
                             mx_vaddr_t* base, mx_vaddr_t* entry) {
-    return elf_load_map_segments(vmar, &info->header, info->phdrs, vmo,
-                                 segments_vmar, base, entry);
+    return elf_load_map_cached(vmar, info, vmo, segments_vmar, base, entry);
 }
 
 size_t elf_load_get_stack_size(elf_load_info_t* info) {
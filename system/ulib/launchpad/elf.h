@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include <elfload/elfload.h>
 #include <magenta/types.h>
 #include <stddef.h>
 
 #pragma GCC visibility push(hidden)
 
-typedef struct elf_load_info elf_load_info_t;
+// A parsed image is just elfload's cached descriptor, malloc'd here.
+typedef elf_load_cached_t elf_load_info_t;
 
 // Validate the ELF headers and set up for further use.
 // The pointer returned must be passed to elf_load_destroy when finished.
@@ -160,6 +160,60 @@ mx_status_t launchpad_add_handle(launchpad_t* lp, mx_handle_t h, uint32_t id);
 mx_status_t launchpad_add_handles(launchpad_t* lp, size_t n,
                                   const mx_handle_t h[], const uint32_t id[]);
 
+// As launchpad_add_handles, but duplicates of the given handles are
+// added rather than the handles themselves, which remain owned by the
+// caller.  The handles must carry MX_RIGHT_DUPLICATE.
+mx_status_t launchpad_add_handles_duplicated(launchpad_t* lp, size_t n,
+                                             const mx_handle_t h[],
+                                             const uint32_t id[]);
+
+
+// LAUNCH TEMPLATES
+// For callers that spawn many processes with mostly identical
+// configuration, a template holds the static portion of a launch --
+// argument, environment, and nametable string tables, handles, and
+// stack size -- prebuilt once, so each launch only pays for its
+// per-instance deltas.
+// ---------------------------------------------------------------------
+
+// Opaque type representing prebuilt launch state.
+// Use of this object is not thread-safe.
+typedef struct launchpad_template launchpad_template_t;
+
+// Create an empty launch template.
+mx_status_t launchpad_template_create(launchpad_template_t** result);
+
+// Clean up a launch template, freeing all resources stored therein
+// (including closing any handles added to it).
+void launchpad_template_destroy(launchpad_template_t* tl);
+
+// Set the static portion of the template.  These follow the same rules
+// as the corresponding launchpad_*() calls.  Handles added to the
+// template are owned by it and must carry MX_RIGHT_DUPLICATE, since a
+// duplicate is handed to every process launched from the template.
+mx_status_t launchpad_template_set_args(launchpad_template_t* tl,
+                                        int argc, const char* const* argv);
+mx_status_t launchpad_template_set_environ(launchpad_template_t* tl,
+                                           const char* const* envp);
+mx_status_t launchpad_template_set_nametable(launchpad_template_t* tl,
+                                             size_t count,
+                                             const char* const* names);
+mx_status_t launchpad_template_add_handle(launchpad_template_t* tl,
+                                          mx_handle_t h, uint32_t id);
+size_t launchpad_template_set_stack_size(launchpad_template_t* tl,
+                                         size_t new_size);
+
+// Create a new process and a launchpad prepopulated from the template.
+// The job and name arguments are as for launchpad_create().  The
+// template's string tables are copied and its handles duplicated into
+// the launchpad; per-instance state (the binary to load, extra handles,
+// fds, etc) is then added with the normal launchpad_*() calls.  The
+// template may be instantiated again while launchpads created from it
+// are still live.
+mx_status_t launchpad_template_instantiate(launchpad_template_t* tl,
+                                           mx_handle_t job, const char* name,
+                                           launchpad_t** result);
+
 // ADDING MXIO FILE DESCRIPTORS
 // These functions configure the initial file descriptors, root directory,
 // and current working directory for processes which use libmxio for the
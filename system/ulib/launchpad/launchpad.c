@@ -333,6 +333,123 @@ mx_status_t launchpad_add_handles(launchpad_t* lp, size_t n,
     return status;
 }
 
+mx_status_t launchpad_add_handles_duplicated(launchpad_t* lp, size_t n,
+                                             const mx_handle_t h[],
+                                             const uint32_t id[]) {
+    mx_status_t status = more_handles(lp, n);
+    if (status != MX_OK)
+        return status;
+    for (size_t i = 0; i < n; ++i) {
+        mx_handle_t copy;
+        status = mx_handle_duplicate(h[i], MX_RIGHT_SAME_RIGHTS, &copy);
+        if (status != MX_OK)
+            return lp_error(lp, status, "cannot duplicate handle to add");
+        lp->handles[lp->handle_count] = copy;
+        lp->handles_info[lp->handle_count] = id[i];
+        ++lp->handle_count;
+    }
+    return MX_OK;
+}
+
+// A launch template is just a launchpad that never gets a process:
+// its string tables and handle list hold the prebuilt static portion
+// of a launch, copied into each launchpad instantiated from it.
+struct launchpad_template {
+    launchpad_t* lp;
+};
+
+mx_status_t launchpad_template_create(launchpad_template_t** result) {
+    launchpad_template_t* tl = calloc(1, sizeof(*tl));
+    if (tl == NULL)
+        return MX_ERR_NO_MEMORY;
+    launchpad_t* lp = calloc(1, sizeof(*lp));
+    if (lp == NULL) {
+        free(tl);
+        return MX_ERR_NO_MEMORY;
+    }
+    lp->errmsg = "no error";
+    tl->lp = lp;
+    *result = tl;
+    return MX_OK;
+}
+
+void launchpad_template_destroy(launchpad_template_t* tl) {
+    launchpad_destroy(tl->lp);
+    free(tl);
+}
+
+mx_status_t launchpad_template_set_args(launchpad_template_t* tl,
+                                        int argc, const char* const* argv) {
+    return launchpad_set_args(tl->lp, argc, argv);
+}
+
+mx_status_t launchpad_template_set_environ(launchpad_template_t* tl,
+                                           const char* const* envp) {
+    return launchpad_set_environ(tl->lp, envp);
+}
+
+mx_status_t launchpad_template_set_nametable(launchpad_template_t* tl,
+                                             size_t count,
+                                             const char* const* names) {
+    return launchpad_set_nametable(tl->lp, count, names);
+}
+
+mx_status_t launchpad_template_add_handle(launchpad_template_t* tl,
+                                          mx_handle_t h, uint32_t id) {
+    return launchpad_add_handle(tl->lp, h, id);
+}
+
+size_t launchpad_template_set_stack_size(launchpad_template_t* tl,
+                                         size_t new_size) {
+    return launchpad_set_stack_size(tl->lp, new_size);
+}
+
+// Copy an already-flattened string table, so instantiation doesn't
+// rewalk the original string vectors.
+static mx_status_t copy_stringtable(launchpad_t* lp, const char* src,
+                                    size_t len, char** out) {
+    char* buffer = NULL;
+    if (len > 0) {
+        buffer = malloc(len);
+        if (buffer == NULL)
+            return lp_error(lp, MX_ERR_NO_MEMORY, "out of memory for string array");
+        memcpy(buffer, src, len);
+    }
+    *out = buffer;
+    return MX_OK;
+}
+
+mx_status_t launchpad_template_instantiate(launchpad_template_t* tl,
+                                           mx_handle_t job, const char* name,
+                                           launchpad_t** result) {
+    launchpad_t* lp;
+    launchpad_create(job, name, &lp);
+    *result = lp;
+
+    launchpad_t* s = tl->lp;
+    if (s->error)
+        return lp_error(lp, s->error, s->errmsg);
+
+    if (copy_stringtable(lp, s->args, s->args_len, &lp->args) == MX_OK) {
+        lp->argc = s->argc;
+        lp->args_len = s->args_len;
+    }
+    if (copy_stringtable(lp, s->env, s->env_len, &lp->env) == MX_OK) {
+        lp->envc = s->envc;
+        lp->env_len = s->env_len;
+    }
+    if (copy_stringtable(lp, s->names, s->names_len, &lp->names) == MX_OK) {
+        lp->namec = s->namec;
+        lp->names_len = s->names_len;
+    }
+    if (s->set_stack_size)
+        launchpad_set_stack_size(lp, s->stack_size);
+
+    launchpad_add_handles_duplicated(lp, s->handle_count,
+                                     s->handles, s->handles_info);
+    return lp->error;
+}
+
 //TODO: use transfer_fd here and eliminate mxio_pipe_half()
 mx_status_t launchpad_add_pipe(launchpad_t* lp, int* fd_out, int target_fd) {
     mx_handle_t handle;
@@ -7,6 +7,11 @@
 #include "private.h"
 
 mx_time_t _mx_deadline_after(mx_duration_t nanoseconds) {
+    // When user mode can read the counter behind the monotonic clock
+    // directly, compute the deadline without entering the kernel.  Event
+    // loops call this once per wait, so the syscall would dominate.
+    if (DATA_CONSTANTS.mono_ticks_source != VDSO_TICKS_SOURCE_SYSCALL)
+        return nanoseconds + CODE_fast_monotonic_time_get(MX_CLOCK_MONOTONIC);
     return nanoseconds + VDSO_mx_time_get(MX_CLOCK_MONOTONIC);
 }
 
@@ -0,0 +1,47 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <magenta/syscalls.h>
+
+// This defines struct fp_32_64 and the exact multiply the kernel's
+// current_time() uses, so the fast path below matches the syscall's
+// result bit for bit.
+#include <lib/fixed_point.h>
+
+#include "private.h"
+
+static uint64_t read_mono_ticks(void) {
+#if __aarch64__
+    uint64_t ticks;
+    if (DATA_CONSTANTS.mono_ticks_source == VDSO_TICKS_SOURCE_CNTVCT) {
+        __asm__ volatile("mrs %0, cntvct_el0" : "=r" (ticks));
+    } else {
+        __asm__ volatile("mrs %0, cntpct_el0" : "=r" (ticks));
+    }
+    return ticks;
+#elif __x86_64__
+    uint32_t ticks_low;
+    uint32_t ticks_high;
+    __asm__ volatile("rdtsc" : "=a" (ticks_low), "=d" (ticks_high));
+    return ((uint64_t)ticks_high << 32) | ticks_low;
+#else
+#error Unsupported architecture
+#endif
+}
+
+// At boot time the kernel can decide to redirect the {_,}mx_time_get
+// dynamic symbol table entries to point to this instead, when user mode
+// can read the counter behind the monotonic clock directly.  See
+// VDso::Create.
+VDSO_KERNEL_EXPORT mx_time_t CODE_fast_monotonic_time_get(uint32_t clock_id) {
+    if (clock_id != MX_CLOCK_MONOTONIC)
+        return VDSO_mx_time_get(clock_id);
+
+    struct fp_32_64 ns_per_tick = {
+        DATA_CONSTANTS.ticks_to_mono_l0,
+        DATA_CONSTANTS.ticks_to_mono_l32,
+        DATA_CONSTANTS.ticks_to_mono_l64,
+    };
+    return u64_mul_u64_fp32_64(read_mono_ticks(), ns_per_tick);
+}
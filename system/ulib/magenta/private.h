@@ -20,6 +20,7 @@ extern "C" {
 #include <magenta/syscall-vdso-definitions.h>
 
 __LOCAL decltype(mx_ticks_get) CODE_soft_ticks_get;
+__LOCAL decltype(mx_time_get) CODE_fast_monotonic_time_get;
 
 };
 
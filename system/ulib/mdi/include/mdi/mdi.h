@@ -14,6 +14,8 @@ typedef struct mdi_node_ref {
     const mdi_node_t* node;
     uint32_t siblings_count;        // number of siblings following node in list
     const void* siblings_end;       // pointer to end of remaining siblings
+    const void* base;               // pointer to start of root node, for index offsets
+    const mdi_index_t* index;       // node lookup index, or NULL if the MDI has none
 } mdi_node_ref_t;
 
 static inline bool mdi_valid(const mdi_node_ref_t* ref) {
@@ -36,15 +36,34 @@ mx_status_t mdi_init(const void* mdi_data, size_t length, mdi_node_ref_t* out_re
     }
 
     const mdi_node_t* node = (const mdi_node_t *)(header + 1);
-    if (node->length != header->length) {
+    if (node->length > header->length) {
         xprintf("%s: bad root node length\n", __FUNCTION__);
         out_ref->node = NULL;
         return MX_ERR_INVALID_ARGS;
     }
 
+    // any data following the root node's subtree must be the node lookup index
+    const mdi_index_t* index = NULL;
+    if (node->length < header->length) {
+        size_t remaining = header->length - node->length;
+        const mdi_index_t* trailer = (const mdi_index_t *)((const void *)node + node->length);
+        if (remaining < sizeof(*trailer)
+            || trailer->magic != MDI_INDEX_MAGIC
+            || trailer->bucket_count == 0
+            || (trailer->bucket_count & (trailer->bucket_count - 1)) != 0
+            || trailer->bucket_count > (remaining - sizeof(*trailer)) / sizeof(mdi_index_entry_t)) {
+            xprintf("%s: bad node lookup index\n", __FUNCTION__);
+            out_ref->node = NULL;
+            return MX_ERR_INVALID_ARGS;
+        }
+        index = trailer;
+    }
+
     out_ref->node = node;
     out_ref->siblings_count = 0;
     out_ref->siblings_end = NULL;
+    out_ref->base = node;
+    out_ref->index = index;
     return MX_OK;
 }
 
@@ -198,6 +217,8 @@ mx_status_t mdi_first_child(const mdi_node_ref_t* ref, mdi_node_ref_t* out_ref)
     out_ref->node = NULL;
     out_ref->siblings_count = 0;
     out_ref->siblings_end = NULL;
+    out_ref->base = ref->base;
+    out_ref->index = ref->index;
 
    if (mdi_node_type(ref) != MDI_LIST) {
         xprintf("%s: ref not a list\n", __FUNCTION__);
@@ -224,6 +245,8 @@ mx_status_t mdi_first_child(const mdi_node_ref_t* ref, mdi_node_ref_t* out_ref)
 }
 
 mx_status_t mdi_next_child(const mdi_node_ref_t* ref, mdi_node_ref_t* out_ref) {
+    out_ref->base = ref->base;
+    out_ref->index = ref->index;
     if (ref->siblings_count == 0) {
         out_ref->node = NULL;
         out_ref->siblings_count = 0;
@@ -253,6 +276,46 @@ uint32_t mdi_child_count(const mdi_node_ref_t* ref) {
 }
 
 mx_status_t mdi_find_node(const mdi_node_ref_t* ref, mdi_id_t id, mdi_node_ref_t* out_ref) {
+    if (ref->index && mdi_node_type(ref) == MDI_LIST) {
+        const mdi_index_t* index = ref->index;
+        const mdi_index_entry_t* buckets = (const mdi_index_entry_t *)(index + 1);
+        uint32_t mask = index->bucket_count - 1;
+        uint32_t parent_off = (uint32_t)((const void *)ref->node - ref->base);
+        uint32_t bucket = MDI_INDEX_HASH(parent_off, id) & mask;
+
+        for (uint32_t probes = 0; probes < index->bucket_count; probes++) {
+            const mdi_index_entry_t* entry = &buckets[bucket];
+            if (entry->node_off == 0) {
+                // an empty bucket means the id is not in this list
+                out_ref->node = NULL;
+                out_ref->siblings_count = 0;
+                out_ref->siblings_end = NULL;
+                out_ref->base = ref->base;
+                out_ref->index = ref->index;
+                return MX_ERR_NOT_FOUND;
+            }
+            if (entry->id == id && entry->parent_off == parent_off) {
+                const mdi_node_t* node = (const mdi_node_t *)(ref->base + entry->node_off);
+                const void* siblings_end = (const void *)ref->node + ref->node->length;
+                if (entry->child_index >= ref->node->value.child_count
+                    || (const void *)node + sizeof(*node) > siblings_end
+                    || (const void *)node + node->length > siblings_end
+                    || node->id != id) {
+                    xprintf("%s: node lookup index does not match tree\n", __FUNCTION__);
+                    break;
+                }
+                out_ref->node = node;
+                out_ref->siblings_count = ref->node->value.child_count - entry->child_index - 1;
+                out_ref->siblings_end = siblings_end;
+                out_ref->base = ref->base;
+                out_ref->index = ref->index;
+                return MX_OK;
+            }
+            bucket = (bucket + 1) & mask;
+        }
+        // inconsistent index - fall back to scanning the list
+    }
+
     out_ref->siblings_count = 0;
     out_ref->siblings_end = NULL;
     mx_status_t status = mdi_first_child(ref, out_ref);
@@ -0,0 +1,369 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
+
+#include <mxio/async.h>
+#include <mxio/io.h>
+#include <mxio/remoteio.h>
+#include <mxio/util.h>
+
+#include "private.h"
+#include "private-remoteio.h"
+#include "unistd.h"
+
+// A submitted operation awaiting its reply.  Reads and writes are matched to
+// replies arriving on the connection's channel by transaction id; opens wait
+// on their own reply channel, remoteio-style.
+typedef struct aio_op aio_op_t;
+struct aio_op {
+    aio_op_t* next;
+    uint64_t key;
+    mx_txid_t txid;
+    uint32_t op;
+    void* data;
+    size_t len;
+    mx_handle_t reply; // open only: reply channel, else MX_HANDLE_INVALID
+};
+
+struct mxio_aio {
+    mtx_t lock;
+    mxio_t* io;       // holds a reference on the bound descriptor's object
+    mx_handle_t h;    // rio channel, borrowed from io
+    mx_handle_t port; // borrowed from the caller
+    uint64_t key;
+    atomic_uint_fast32_t next_txid;
+    aio_op_t* pending;
+};
+
+// Synchronous transactions ride mx_channel_call(), whose kernel-assigned
+// txids always have the top bit set; async txids stay out of that space
+// (and are never zero) so the two never collide on one channel.
+static mx_txid_t aio_next_txid(mxio_aio_t* aio) {
+    mx_txid_t txid;
+    do {
+        txid = atomic_fetch_add(&aio->next_txid, 1) & 0x7fffffff;
+    } while (txid == 0);
+    return txid;
+}
+
+static void aio_unlink_locked(mxio_aio_t* aio, aio_op_t* op) {
+    aio_op_t** prevnext = &aio->pending;
+    while (*prevnext != op) {
+        prevnext = &(*prevnext)->next;
+    }
+    *prevnext = op->next;
+}
+
+mx_status_t mxio_aio_create(int fd, mx_handle_t port, uint64_t key,
+                            mxio_aio_t** out) {
+    mxio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return MX_ERR_BAD_HANDLE;
+    }
+    if (!__mxio_is_remoteio(io)) {
+        mxio_release(io);
+        return MX_ERR_NOT_SUPPORTED;
+    }
+    mxio_aio_t* aio = calloc(1, sizeof(mxio_aio_t));
+    if (aio == NULL) {
+        mxio_release(io);
+        return MX_ERR_NO_MEMORY;
+    }
+    mtx_init(&aio->lock, mtx_plain);
+    aio->io = io;
+    aio->h = ((mxrio_t*)io)->h;
+    aio->port = port;
+    aio->key = key;
+    atomic_store(&aio->next_txid, 1);
+
+    mx_status_t r = mx_object_wait_async(aio->h, port, key,
+                                         MX_CHANNEL_READABLE | MX_CHANNEL_PEER_CLOSED,
+                                         MX_WAIT_ASYNC_REPEATING);
+    if (r != MX_OK) {
+        mxio_release(io);
+        free(aio);
+        return r;
+    }
+    *out = aio;
+    return MX_OK;
+}
+
+static mx_status_t aio_submit(mxio_aio_t* aio, uint64_t key, uint32_t op,
+                              void* data, size_t len, off_t off) {
+    if (len > MXIO_CHUNK_SIZE) {
+        return MX_ERR_INVALID_ARGS;
+    }
+    aio_op_t* pending = calloc(1, sizeof(aio_op_t));
+    if (pending == NULL) {
+        return MX_ERR_NO_MEMORY;
+    }
+    pending->key = key;
+    pending->txid = aio_next_txid(aio);
+    pending->op = op;
+    pending->data = data;
+    pending->len = len;
+    pending->reply = MX_HANDLE_INVALID;
+
+    mxrio_msg_t msg;
+    memset(&msg, 0, MXRIO_HDR_SZ);
+    msg.txid = pending->txid;
+    msg.op = op;
+    msg.arg2.off = off;
+    if (op == MXRIO_READ_AT) {
+        msg.arg = len;
+    } else {
+        msg.datalen = len;
+        memcpy(msg.data, data, len);
+    }
+
+    // Publish the op before writing so a reply arriving on another thread
+    // between the write and the insert cannot go unmatched.
+    mtx_lock(&aio->lock);
+    pending->next = aio->pending;
+    aio->pending = pending;
+    mtx_unlock(&aio->lock);
+
+    mx_status_t r = mx_channel_write(aio->h, 0, &msg,
+                                     MXRIO_HDR_SZ + msg.datalen, NULL, 0);
+    if (r != MX_OK) {
+        mtx_lock(&aio->lock);
+        aio_unlink_locked(aio, pending);
+        mtx_unlock(&aio->lock);
+        free(pending);
+    }
+    return r;
+}
+
+mx_status_t mxio_aio_read_at(mxio_aio_t* aio, uint64_t key,
+                             void* data, size_t len, off_t off) {
+    return aio_submit(aio, key, MXRIO_READ_AT, data, len, off);
+}
+
+mx_status_t mxio_aio_write_at(mxio_aio_t* aio, uint64_t key,
+                              const void* data, size_t len, off_t off) {
+    return aio_submit(aio, key, MXRIO_WRITE_AT, (void*)data, len, off);
+}
+
+mx_status_t mxio_aio_open(mxio_aio_t* aio, uint64_t key, const char* path,
+                          int32_t flags, uint32_t mode) {
+    size_t len = strlen(path);
+    if (len >= PATH_MAX) {
+        return MX_ERR_BAD_PATH;
+    }
+    aio_op_t* pending = calloc(1, sizeof(aio_op_t));
+    if (pending == NULL) {
+        return MX_ERR_NO_MEMORY;
+    }
+    pending->key = key;
+    pending->op = MXRIO_OPEN;
+
+    mx_handle_t cnxn;
+    mx_status_t r;
+    if ((r = mx_channel_create(0, &pending->reply, &cnxn)) != MX_OK) {
+        free(pending);
+        return r;
+    }
+    // The reply channel sees exactly one message, so a one-shot wait is
+    // enough to get a port packet when the open resolves (or the server
+    // closes its end without answering).
+    if ((r = mx_object_wait_async(pending->reply, aio->port, aio->key,
+                                  MX_CHANNEL_READABLE | MX_CHANNEL_PEER_CLOSED,
+                                  MX_WAIT_ASYNC_ONCE)) != MX_OK) {
+        mx_handle_close(pending->reply);
+        mx_handle_close(cnxn);
+        free(pending);
+        return r;
+    }
+
+    mxrio_msg_t msg;
+    memset(&msg, 0, MXRIO_HDR_SZ);
+    msg.op = MXRIO_OPEN;
+    msg.datalen = len;
+    msg.arg = flags;
+    msg.arg2.mode = mode;
+    msg.hcount = 1;
+    msg.handle[0] = cnxn;
+    memcpy(msg.data, path, len);
+
+    mtx_lock(&aio->lock);
+    pending->next = aio->pending;
+    aio->pending = pending;
+    mtx_unlock(&aio->lock);
+
+    if ((r = mx_channel_write(aio->h, 0, &msg, MXRIO_HDR_SZ + len,
+                              msg.handle, 1)) != MX_OK) {
+        mtx_lock(&aio->lock);
+        aio_unlink_locked(aio, pending);
+        mtx_unlock(&aio->lock);
+        mx_handle_close(pending->reply);
+        free(pending);
+    }
+    return r;
+}
+
+// Finish a resolved open: turn the reply object into an mxio and install it
+// in the fd table.  Consumes op.
+static mx_status_t aio_complete_open(aio_op_t* op, mx_status_t r,
+                                     mxrio_object_t* info,
+                                     mxio_aio_result_t* result) {
+    result->key = op->key;
+    result->actual = 0;
+    result->fd = -1;
+    if (r == MX_OK) {
+        // As with the synchronous path, the reply channel itself becomes
+        // the new connection's control channel.
+        info->handle[0] = op->reply;
+        info->hcount++;
+        op->reply = MX_HANDLE_INVALID;
+        r = info->status;
+        if (r == MX_OK) {
+            mxio_t* out_io;
+            r = mxio_from_handles(info->type, info->handle, info->hcount,
+                                  info->extra, info->esize, &out_io);
+            if (r == MX_OK) {
+                int fd = mxio_bind_to_fd(out_io, -1, 0);
+                if (fd < 0) {
+                    mxio_close(out_io);
+                    mxio_release(out_io);
+                    r = MX_ERR_NO_RESOURCES;
+                } else {
+                    result->fd = fd;
+                }
+            }
+        } else {
+            while (info->hcount > 0) {
+                mx_handle_close(info->handle[--info->hcount]);
+            }
+        }
+    }
+    if (op->reply != MX_HANDLE_INVALID) {
+        mx_handle_close(op->reply);
+    }
+    free(op);
+    result->status = r;
+    return MX_OK;
+}
+
+mx_status_t mxio_aio_complete(mxio_aio_t* aio, mxio_aio_result_t* result) {
+    // Replies to reads and writes arrive on the connection's channel.
+    mxrio_msg_t msg;
+    mx_handle_t handles[MXIO_MAX_HANDLES];
+    uint32_t dsize = MXRIO_HDR_SZ + MXIO_CHUNK_SIZE;
+    uint32_t hcount = 0;
+    mx_status_t r = mx_channel_read(aio->h, 0, &msg, handles, dsize,
+                                    MXIO_MAX_HANDLES, &dsize, &hcount);
+    if (r == MX_OK) {
+        // Replies to these ops never carry handles; drop any that show up.
+        while (hcount > 0) {
+            mx_handle_close(handles[--hcount]);
+        }
+        if ((dsize < MXRIO_HDR_SZ) || (MXRIO_OP(msg.op) != MXRIO_STATUS)) {
+            return MX_ERR_IO;
+        }
+        mtx_lock(&aio->lock);
+        aio_op_t* op = aio->pending;
+        while ((op != NULL) &&
+               ((op->reply != MX_HANDLE_INVALID) || (op->txid != msg.txid))) {
+            op = op->next;
+        }
+        if (op != NULL) {
+            aio_unlink_locked(aio, op);
+        }
+        mtx_unlock(&aio->lock);
+        if (op == NULL) {
+            // a reply for a transaction nobody is waiting on
+            return MX_ERR_IO;
+        }
+        result->key = op->key;
+        result->fd = -1;
+        if (msg.arg < 0) {
+            result->status = msg.arg;
+            result->actual = 0;
+        } else {
+            result->status = MX_OK;
+            size_t actual = msg.arg;
+            if (op->op == MXRIO_READ_AT) {
+                if (actual > op->len) {
+                    actual = op->len;
+                }
+                if (actual > msg.datalen) {
+                    actual = msg.datalen;
+                }
+                memcpy(op->data, msg.data, actual);
+            }
+            result->actual = actual;
+        }
+        free(op);
+        return MX_OK;
+    }
+    if (r != MX_ERR_SHOULD_WAIT) {
+        return r;
+    }
+
+    // Nothing on the main channel; poll any outstanding open replies.
+    mtx_lock(&aio->lock);
+    for (aio_op_t* op = aio->pending; op != NULL; op = op->next) {
+        if (op->reply == MX_HANDLE_INVALID) {
+            continue;
+        }
+        mxrio_object_t info;
+        memset(&info, 0, MXRIO_OBJECT_MINSIZE);
+        uint32_t bytes = MXRIO_OBJECT_MAXSIZE;
+        uint32_t hc = MXIO_MAX_HANDLES;
+        r = mx_channel_read(op->reply, 0, &info, &info.handle[1], bytes,
+                            hc, &bytes, &hc);
+        if (r == MX_ERR_SHOULD_WAIT) {
+            // No reply yet; if the server closed without answering, the
+            // open failed.
+            if (mx_object_wait_one(op->reply, MX_CHANNEL_PEER_CLOSED,
+                                   0u, NULL) != MX_OK) {
+                continue;
+            }
+            r = MX_ERR_PEER_CLOSED;
+        }
+        aio_unlink_locked(aio, op);
+        mtx_unlock(&aio->lock);
+        if (r == MX_OK) {
+            info.hcount = hc;
+            if (bytes < MXRIO_OBJECT_MINSIZE) {
+                for (uint32_t i = 1; i <= hc; i++) {
+                    mx_handle_close(info.handle[i]);
+                }
+                info.hcount = 0;
+                r = MX_ERR_IO;
+            } else {
+                info.esize = bytes - MXRIO_OBJECT_MINSIZE;
+            }
+        }
+        return aio_complete_open(op, r, &info, result);
+    }
+    mtx_unlock(&aio->lock);
+    return MX_ERR_SHOULD_WAIT;
+}
+
+void mxio_aio_destroy(mxio_aio_t* aio) {
+    mx_port_cancel(aio->port, aio->h, aio->key);
+    mtx_lock(&aio->lock);
+    aio_op_t* op = aio->pending;
+    aio->pending = NULL;
+    mtx_unlock(&aio->lock);
+    while (op != NULL) {
+        aio_op_t* next = op->next;
+        if (op->reply != MX_HANDLE_INVALID) {
+            mx_handle_close(op->reply);
+        }
+        free(op);
+        op = next;
+    }
+    mxio_release(aio->io);
+    free(aio);
+}
@@ -54,6 +54,19 @@ void bootfs_parse(mx_handle_t vmo, size_t len,
     uint32_t header[3];
 
     off += sizeof(hdr);
+
+    if (hdr.flags & BOOTDATA_BOOTFS_FLAG_INDEXED) {
+        // Skip the directory index; this is a full enumeration, so the
+        // linear walk below visits every entry anyway.
+        uint32_t count;
+        r = mx_vmo_read(vmo, &count, off, sizeof(count), &rlen);
+        if (r < 0 || rlen < sizeof(count)) {
+            printf("bootfs_parse: couldn't read index\n");
+            return;
+        }
+        off += sizeof(uint32_t) * ((size_t)count + 1);
+    }
+
     for (;;) {
         if ((end - data) < (int)sizeof(header)) {
             // read in another xxx headers
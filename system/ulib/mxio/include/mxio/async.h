@@ -0,0 +1,66 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <magenta/types.h>
+
+#include <stddef.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS
+
+// Asynchronous remoteio submission.
+//
+// An mxio_aio_t binds one remoteio-backed file descriptor to an mx port.
+// Operations are submitted with a caller-chosen key and return immediately;
+// the request travels over the connection's channel with its own transaction
+// id, so submissions coexist with synchronous operations on the same fd.
+// When replies may be pending, a packet carrying the binding's key is queued
+// to the port, and mxio_aio_complete() reaps finished operations.  One
+// event-loop thread can drive many outstanding operations across many
+// bindings this way, with no thread parked per operation.
+
+typedef struct mxio_aio mxio_aio_t;
+
+typedef struct {
+    uint64_t key;       // key passed when the operation was submitted
+    mx_status_t status; // MX_OK or the operation's error
+    size_t actual;      // bytes transferred (read/write), 0 otherwise
+    int fd;             // new descriptor (open), -1 otherwise
+} mxio_aio_result_t;
+
+// Binds |fd| (which must be remoteio-backed: files, directories, devices)
+// to |port|.  Whenever completions may be pending, a packet with |key| is
+// queued to |port|; the caller should then invoke mxio_aio_complete() until
+// it returns MX_ERR_SHOULD_WAIT.  The port is borrowed, not owned, and must
+// outlive the binding.
+mx_status_t mxio_aio_create(int fd, mx_handle_t port, uint64_t key,
+                            mxio_aio_t** out);
+
+// Submits a read of up to |len| bytes at absolute offset |off| into |data|,
+// or a write of |len| bytes from |data|.  |data| must remain valid until the
+// operation completes.  |len| may not exceed MXIO_CHUNK_SIZE.
+mx_status_t mxio_aio_read_at(mxio_aio_t* aio, uint64_t key,
+                             void* data, size_t len, off_t off);
+mx_status_t mxio_aio_write_at(mxio_aio_t* aio, uint64_t key,
+                              const void* data, size_t len, off_t off);
+
+// Submits an open of |path| relative to the bound descriptor.  On success
+// the completion carries a new file descriptor in |fd|.
+mx_status_t mxio_aio_open(mxio_aio_t* aio, uint64_t key, const char* path,
+                          int32_t flags, uint32_t mode);
+
+// Reaps one completed operation into |result|.  Returns MX_ERR_SHOULD_WAIT
+// when no completion is currently ready.
+mx_status_t mxio_aio_complete(mxio_aio_t* aio, mxio_aio_result_t* result);
+
+// Tears down the binding.  Operations still outstanding are abandoned: their
+// keys are never delivered and any replies that later arrive remain queued
+// on the connection, so bindings should normally be destroyed only once
+// idle.  The bound fd and the port remain usable.
+void mxio_aio_destroy(mxio_aio_t* aio);
+
+__END_CDECLS
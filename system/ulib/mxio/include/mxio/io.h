@@ -40,6 +40,33 @@ __BEGIN_CDECLS
 // wait until one or more events are pending
 mx_status_t mxio_wait_fd(int fd, uint32_t events, uint32_t* pending, mx_time_t deadline);
 
+// Persistent wait sets. An fd is translated to its underlying handle and
+// signals once, when it is added, and the set is waited on through a single
+// port, so polling the same fds repeatedly does not pay a per-fd setup cost
+// on every iteration the way poll() and select() do.
+//
+// Keys name registrations and are chosen by the caller; they must be unique
+// within a set. An added fd is held referenced by the set until it is
+// removed or the set is destroyed, even if the fd itself is closed.
+typedef struct mxio_waitset mxio_waitset_t;
+
+typedef struct mxio_waitset_result {
+    uint64_t key;
+    uint32_t events;
+} mxio_waitset_result_t;
+
+mx_status_t mxio_waitset_create(mxio_waitset_t** out);
+mx_status_t mxio_waitset_add(mxio_waitset_t* ws, uint64_t key, int fd, uint32_t events);
+mx_status_t mxio_waitset_remove(mxio_waitset_t* ws, uint64_t key);
+
+// Wait until at least one registration has pending events, or the deadline
+// passes. Up to |count| results are returned; |count| must not exceed
+// MX_PORT_MAX_WAIT_PACKETS.
+mx_status_t mxio_waitset_wait(mxio_waitset_t* ws, mx_time_t deadline,
+                              mxio_waitset_result_t* results, size_t count,
+                              size_t* actual);
+void mxio_waitset_destroy(mxio_waitset_t* ws);
+
 // create a fd that works with wait APIs (epoll, select, etc.) from a handle
 // and expected signals (signals_in/signals_out correspond to POLLIN/POLLOUT
 // events respectively). the handle will be closed when the fd is closed, unless
@@ -51,7 +51,10 @@ __BEGIN_CDECLS
 #define MXRIO_LINK        (0x0000001a | MXRIO_ONE_HANDLE)
 #define MXRIO_MMAP         0x0000001b
 #define MXRIO_FCNTL        0x0000001c
-#define MXRIO_NUM_OPS      29
+#define MXRIO_READ_VMO    (0x0000001d | MXRIO_ONE_HANDLE)
+#define MXRIO_WRITE_VMO   (0x0000001e | MXRIO_ONE_HANDLE)
+#define MXRIO_READDIR_VMO (0x0000001f | MXRIO_ONE_HANDLE)
+#define MXRIO_NUM_OPS      32
 
 #define MXRIO_OP(n)        ((n) & 0x3FF) // opcode
 #define MXRIO_HC(n)        (((n) >> 8) & 3) // handle count
@@ -64,7 +67,8 @@ __BEGIN_CDECLS
     "read_at", "write_at", "truncate", "rename", \
     "connect", "bind", "listen", "getsockname", \
     "getpeername", "getsockopt", "setsockopt", "getaddrinfo", \
-    "setattr", "sync", "link", "mmap", "fcntl" }
+    "setattr", "sync", "link", "mmap", "fcntl", \
+    "read_vmo", "write_vmo", "readdir_vmo" }
 
 const char* mxio_opname(uint32_t op);
 
@@ -193,6 +197,27 @@ static_assert(MXIO_CHUNK_SIZE >= PATH_MAX, "MXIO_CHUNK_SIZE must be large enough
 // LINK        0          0        <name1>0<name2>0  0           -               -
 // MMAP        maxreply   0        mmap_data_msg     0           mmap_data_msg   vmohandle
 // FCNTL       cmd        flags    0                 flags       -               -
+// READ_VMO    maxread    offset   - (h: vmo)        newoffset   -               -
+// WRITE_VMO   count      offset   - (h: vmo)        newoffset   -               -
+// READDIR_VMO maxbytes   0        - (h: vmo)        0           -               -
+//
+// READDIR_VMO is the bulk directory listing path: the server packs
+// vdirent_t records into the provided VMO (starting at VMO offset 0,
+// at most arg bytes) in a single pass, continuing from the
+// connection's readdir position and replying once with the byte count
+// in arg.  There is no reset command; clients needing a reset issue a
+// chunked READDIR with READDIR_CMD_RESET first.  Servers which do not
+// implement the op return MX_ERR_NOT_SUPPORTED and clients fall back
+// to chunked READDIR.
+//
+// READ_VMO and WRITE_VMO are the bulk transfer path: instead of moving
+// data through msg.data (MXIO_CHUNK_SIZE bytes per round trip), the client
+// sends a VMO and the server fills it (READ_VMO) or drains it (WRITE_VMO)
+// starting at VMO offset 0, replying once with the byte count in arg.
+// An arg2.off of -1 directs the server to use (and advance) the
+// connection's seek offset; otherwise arg2.off is an absolute offset.
+// Servers which do not implement these ops return MX_ERR_NOT_SUPPORTED
+// and clients fall back to chunked transfers.
 //
 // proposed:
 //
@@ -47,6 +47,21 @@ static void __PRINTFLIKE(2, 3) log_printf(mx_handle_t log,
     mx_log_write(log, len, buf, 0u);
 }
 
+// Cache of VMOs for previously loaded objects, so repeated loads of the
+// same library (libc, libmxio, ...) across process spawns are satisfied
+// without rereading the file.  Entries are validated against the file's
+// mtime and callers receive copy-on-write clones, so the cached pages
+// are shared by every process using the library.
+#define VMO_CACHE_BUCKETS 32
+
+typedef struct vmo_cache_entry {
+    struct vmo_cache_entry* next;
+    mx_handle_t vmo;
+    uint64_t size;
+    uint64_t mtime;
+    char path[];
+} vmo_cache_entry_t;
+
 struct mxio_multiloader {
     char name[MX_MAX_NAME_LEN];
     mtx_t dispatcher_lock;
@@ -55,6 +70,9 @@ struct mxio_multiloader {
 
     char config_prefix[32];
     bool config_exclusive;
+
+    mtx_t vmo_cache_lock;
+    vmo_cache_entry_t* vmo_cache[VMO_CACHE_BUCKETS];
 };
 
 static const char* const libpaths[] = {
@@ -138,16 +156,98 @@ static mx_status_t publish_data_sink(mx_handle_t vmo, const char* sink_name) {
 }
 
 // When loading a library object, search in the hard-coded locations.
-static int open_from_libpath(const char* prefix, const char* fn) {
+// On success, path_out holds the path the object was opened from.
+static int open_from_libpath(const char* prefix, const char* fn,
+                             char path_out[PATH_MAX]) {
     int fd = -1;
     for (size_t n = 0; fd < 0 && n < countof(libpaths); ++n) {
-        char path[PATH_MAX];
-        snprintf(path, sizeof(path), "%s/%s%s", libpaths[n], prefix, fn);
-        fd = open(path, O_RDONLY);
+        snprintf(path_out, PATH_MAX, "%s/%s%s", libpaths[n], prefix, fn);
+        fd = open(path_out, O_RDONLY);
     }
     return fd;
 }
 
+static uint32_t vmo_cache_hash(const char* path) {
+    uint32_t n = 5381;
+    while (*path) {
+        n = (n * 33) + *path++;
+    }
+    return n % VMO_CACHE_BUCKETS;
+}
+
+// Hand out a copy-on-write clone of a cached vmo, named after the object.
+static mx_status_t vmo_cache_clone(vmo_cache_entry_t* entry, const char* fn,
+                                   mx_handle_t* out) {
+    mx_status_t status = mx_vmo_clone(entry->vmo, MX_VMO_CLONE_COPY_ON_WRITE,
+                                      0, entry->size, out);
+    if (status == MX_OK)
+        mx_object_set_property(*out, MX_PROP_NAME, fn, strlen(fn));
+    return status;
+}
+
+// As load_object_fd(), but consults (and fills) the multiloader's vmo
+// cache.  Always consumes the fd.
+static mx_status_t load_object_cached(mxio_multiloader_t* ml, int fd,
+                                      const char* path, const char* fn,
+                                      mx_handle_t* out) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        // without an mtime the entry cannot be validated; load directly
+        return load_object_fd(fd, fn, out);
+    }
+    uint64_t mtime = (uint64_t)st.st_mtim.tv_sec * MX_SEC(1) + st.st_mtim.tv_nsec;
+
+    uint32_t bucket = vmo_cache_hash(path);
+    mtx_lock(&ml->vmo_cache_lock);
+    vmo_cache_entry_t* entry;
+    for (entry = ml->vmo_cache[bucket]; entry != NULL; entry = entry->next) {
+        if (!strcmp(entry->path, path)) {
+            break;
+        }
+    }
+    mx_status_t status;
+    if ((entry != NULL) && (entry->mtime == mtime)) {
+        status = vmo_cache_clone(entry, fn, out);
+        mtx_unlock(&ml->vmo_cache_lock);
+        close(fd);
+        return status;
+    }
+
+    mx_handle_t vmo;
+    if ((status = load_object_fd(fd, fn, &vmo)) != MX_OK) {
+        mtx_unlock(&ml->vmo_cache_lock);
+        return status;
+    }
+    uint64_t size;
+    if (mx_vmo_get_size(vmo, &size) != MX_OK) {
+        // the cache is best-effort; hand the vmo out uncached
+        mtx_unlock(&ml->vmo_cache_lock);
+        *out = vmo;
+        return MX_OK;
+    }
+
+    if (entry == NULL) {
+        if ((entry = malloc(sizeof(vmo_cache_entry_t) + strlen(path) + 1)) == NULL) {
+            mtx_unlock(&ml->vmo_cache_lock);
+            *out = vmo;
+            return MX_OK;
+        }
+        strcpy(entry->path, path);
+        entry->next = ml->vmo_cache[bucket];
+        ml->vmo_cache[bucket] = entry;
+    } else {
+        // stale entry: the file was replaced since it was cached
+        mx_handle_close(entry->vmo);
+    }
+    entry->vmo = vmo;
+    entry->size = size;
+    entry->mtime = mtime;
+
+    status = vmo_cache_clone(entry, fn, out);
+    mtx_unlock(&ml->vmo_cache_lock);
+    return status;
+}
+
 static mx_status_t default_load_object(void* cookie,
                                        uint32_t load_op,
                                        mx_handle_t request_handle,
@@ -180,13 +280,14 @@ static mx_status_t default_load_object(void* cookie,
         return MX_OK;
     }
     case LOADER_SVC_OP_LOAD_OBJECT: {
+        char path[PATH_MAX];
         int fd = -1;
         if (ml->config_prefix[0] != '\0')
-            fd = open_from_libpath(ml->config_prefix, fn);
+            fd = open_from_libpath(ml->config_prefix, fn, path);
         if (fd < 0 && !ml->config_exclusive)
-            fd = open_from_libpath("", fn);
+            fd = open_from_libpath("", fn, path);
         if (fd >= 0)
-            return load_object_fd(fd, fn, out);
+            return load_object_cached(ml, fd, path, fn, out);
         break;
     }
     case LOADER_SVC_OP_LOAD_SCRIPT_INTERP:
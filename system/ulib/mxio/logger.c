@@ -6,6 +6,7 @@
 
 #include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
 #include <threads.h>
 
 #include <magenta/syscalls.h>
@@ -22,12 +23,34 @@ struct mxio_log {
 
 #define LOGBUF_MAX (MX_LOG_RECORD_MAX - sizeof(mx_log_record_t))
 
-static ssize_t log_write(mxio_t* io, const void* _data, size_t len) {
-    static thread_local struct {
-        unsigned next;
-        char data[LOGBUF_MAX];
-    }* logbuf = NULL;
+// A log write syscall per line makes verbose programs I/O-bound on their
+// own logging, so complete lines are held back briefly and pushed out as
+// one newline-separated record once enough accumulate or the oldest one
+// has waited long enough.
+#define LOG_BATCH_MAX_LINES 8
+#define LOG_BATCH_HOLD_NS MX_MSEC(5)
+
+typedef struct logbuf {
+    unsigned next;      // bytes buffered
+    unsigned line_end;  // offset just past the last complete line
+    unsigned lines;     // complete lines buffered
+    mx_time_t oldest;   // when the oldest buffered line was completed
+    char data[LOGBUF_MAX];
+} logbuf_t;
+
+static thread_local logbuf_t* logbuf = NULL;
+
+// Sends the complete lines, keeping any partial line buffered. The final
+// newline is implied by the record boundary, as it was for single lines.
+static void log_flush(mx_handle_t handle, logbuf_t* lb) {
+    mx_log_write(handle, lb->line_end ? lb->line_end - 1 : 0, lb->data, 0);
+    memmove(lb->data, lb->data + lb->line_end, lb->next - lb->line_end);
+    lb->next -= lb->line_end;
+    lb->line_end = 0;
+    lb->lines = 0;
+}
 
+static ssize_t log_write(mxio_t* io, const void* _data, size_t len) {
     mxio_log_t* log_io = (mxio_log_t*)io;
 
     if (logbuf == NULL) {
@@ -42,8 +65,15 @@ static ssize_t log_write(mxio_t* io, const void* _data, size_t len) {
     while (len-- > 0) {
         char c = *data++;
         if (c == '\n') {
-            mx_log_write(log_io->handle, logbuf->next, logbuf->data, 0);
-            logbuf->next = 0;
+            if (logbuf->lines == 0) {
+                logbuf->oldest = mx_time_get(MX_CLOCK_MONOTONIC);
+            }
+            logbuf->data[logbuf->next++] = c;
+            logbuf->line_end = logbuf->next;
+            logbuf->lines++;
+            if (logbuf->lines == LOG_BATCH_MAX_LINES || logbuf->next == LOGBUF_MAX) {
+                log_flush(log_io->handle, logbuf);
+            }
             continue;
         }
         if (c < ' ') {
@@ -51,11 +81,24 @@ static ssize_t log_write(mxio_t* io, const void* _data, size_t len) {
         }
         logbuf->data[logbuf->next++] = c;
         if (logbuf->next == LOGBUF_MAX) {
-            mx_log_write(log_io->handle, logbuf->next, logbuf->data, 0);
-            logbuf->next = 0;
-            continue;
+            // flush what we have; an over-long line goes out unterminated,
+            // as before
+            if (logbuf->line_end == 0) {
+                mx_log_write(log_io->handle, logbuf->next, logbuf->data, 0);
+                logbuf->next = 0;
+            } else {
+                log_flush(log_io->handle, logbuf);
+            }
         }
     }
+
+    // Held-back lines go out once the oldest has aged past the deadline;
+    // the next write (including stdio's flush at exit) or close picks up
+    // anything younger.
+    if (logbuf->lines > 0 &&
+        (mx_time_get(MX_CLOCK_MONOTONIC) - logbuf->oldest) >= LOG_BATCH_HOLD_NS) {
+        log_flush(log_io->handle, logbuf);
+    }
     return r;
 }
 
@@ -63,6 +106,9 @@ static mx_status_t log_close(mxio_t* io) {
     mxio_log_t* log_io = (mxio_log_t*)io;
     mx_handle_t h = log_io->handle;
     log_io->handle = 0;
+    if (logbuf != NULL && logbuf->lines > 0) {
+        log_flush(h, logbuf);
+    }
     mx_handle_close(h);
     return MX_OK;
 }
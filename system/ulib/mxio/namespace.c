@@ -12,7 +12,9 @@
 #include <magenta/listnode.h>
 #include <magenta/syscalls.h>
 #include <magenta/processargs.h>
+#include <magenta/device/vfs.h>
 
+#include <mxio/io.h>
 #include <mxio/namespace.h>
 #include <mxio/remoteio.h>
 #include <mxio/util.h>
@@ -48,14 +50,52 @@ struct mxio_vnode {
     mxvn_t* next;
     mx_handle_t remote;
     uint32_t namelen;
+    uint8_t dc_state;
     char name[];
 };
 
+// dc_state values -- whether the remote fs behind a vnode can
+// participate in the dentry cache (see below)
+#define MXDC_UNKNOWN 0      // haven't tried caching under this vnode yet
+#define MXDC_OK 1           // remote supports directory watching
+#define MXDC_UNSUPPORTED 2  // remote rejected the watch ioctl; never cache
+
+// Client-side cache of resolved remote directories (a "dentry cache").
+//
+// Tools that repeatedly stat the same portion of the tree pay for a
+// full component-by-component walk on the remote VFS for every open.
+// We remember connections to the parent directories of recent remote
+// opens, so that a repeated lookup sends only the final path component
+// to the remote (and an open of a cached directory itself is satisfied
+// by a pipelined clone, with no synchronous round trip at all).
+//
+// Coherence: each cached connection is paired with a vfs-watcher
+// channel (IOCTL_VFS_WATCH_DIR) on that directory.  Any queued event
+// -- or the server having dropped the watcher -- evicts the entry
+// before it can be used.  Filesystems that don't support watching are
+// detected once per namespace vnode and never cached.  Since the leaf
+// component is always resolved by the live server, staleness is
+// limited to the case where a cached directory is itself replaced by
+// a new one at the same path; the watcher on the old directory (or
+// eviction) bounds that window.
+
+#define MXDC_ENTRIES 8
+
+typedef struct {
+    mxvn_t* vn;        // namespace vnode this path is relative to
+    char* path;        // remote directory path (no leading or trailing slash)
+    size_t len;
+    mx_handle_t h;     // open connection to the remote directory
+    mx_handle_t watch; // vfs-watcher channel used for invalidation
+} mxdc_entry_t;
+
 // refcount is incremented when a mxio_dir references any of its vnodes
 // when refcount is nonzero it may not be modified or destroyed
 struct mxio_namespace {
     mtx_t lock;
     int32_t refcount;
+    mxdc_entry_t dc[MXDC_ENTRIES];
+    uint32_t dc_next; // round-robin eviction cursor
     mxvn_t root;
 };
 
@@ -165,6 +205,176 @@ static void vn_destroy_children_locked(mxvn_t* parent) {
     }
 }
 
+static void dc_evict_locked(mxdc_entry_t* dc) {
+    if (dc->vn == NULL) {
+        return;
+    }
+    free(dc->path);
+    mx_handle_close(dc->h);
+    mx_handle_close(dc->watch);
+    memset(dc, 0, sizeof(*dc));
+}
+
+static void dc_flush_locked(mxio_ns_t* ns) {
+    for (unsigned n = 0; n < MXDC_ENTRIES; n++) {
+        dc_evict_locked(&ns->dc[n]);
+    }
+}
+
+// Find the cached directory for (vn, path[:len]), if it is still
+// coherent.  A queued watch event -- or a watcher the server has
+// dropped -- means the directory changed, so the entry is evicted
+// rather than returned.
+static mxdc_entry_t* dc_lookup_locked(mxio_ns_t* ns, mxvn_t* vn,
+                                      const char* path, size_t len) {
+    for (unsigned n = 0; n < MXDC_ENTRIES; n++) {
+        mxdc_entry_t* dc = &ns->dc[n];
+        if ((dc->vn == vn) && (dc->len == len) &&
+            (memcmp(dc->path, path, len) == 0)) {
+            if (mx_object_wait_one(dc->watch,
+                                   MX_CHANNEL_READABLE | MX_CHANNEL_PEER_CLOSED,
+                                   0u, NULL) != MX_ERR_TIMED_OUT) {
+                dc_evict_locked(dc);
+                return NULL;
+            }
+            return dc;
+        }
+    }
+    return NULL;
+}
+
+// Install (h, watch) for (vn, path[:len]), taking ownership of both
+// handles.  Replaces the oldest entry.
+static void dc_install_locked(mxio_ns_t* ns, mxvn_t* vn, const char* path,
+                              size_t len, mx_handle_t h, mx_handle_t watch) {
+    char* copy;
+    if ((copy = malloc(len + 1)) == NULL) {
+        mx_handle_close(h);
+        mx_handle_close(watch);
+        return;
+    }
+    memcpy(copy, path, len);
+    copy[len] = 0;
+    mxdc_entry_t* dc = &ns->dc[ns->dc_next++ % MXDC_ENTRIES];
+    dc_evict_locked(dc);
+    dc->vn = vn;
+    dc->path = copy;
+    dc->len = len;
+    dc->h = h;
+    dc->watch = watch;
+}
+
+// Attach a vfs-watcher to the directory connection |h|, returning the
+// event channel.  ADDED is the only change event the VFS broadcasts
+// today; we don't ask for EXISTING or IDLE since a cached entry only
+// needs to hear about changes made after it was created.
+static mx_status_t dc_watch(mx_handle_t h, mx_handle_t* out) {
+    mx_handle_t local, remote;
+    mx_status_t r;
+    if ((r = mx_channel_create(0, &local, &remote)) < 0) {
+        return r;
+    }
+    vfs_watch_dir_t wd = {
+        .channel = remote,
+        .mask = VFS_WATCH_MASK_ADDED,
+        .options = 0,
+    };
+    // the ioctl consumes (or discards) the remote end
+    if ((r = mxrio_ioctl_handle(h, IOCTL_VFS_WATCH_DIR, &wd, sizeof(wd),
+                                NULL, 0)) < 0) {
+        mx_handle_close(local);
+        return r;
+    }
+    *out = local;
+    return MX_OK;
+}
+
+// Hand an OPEN off to the remote filesystem at |vn|, sending the
+// shortest path we can resolve through the dentry cache.  Called with
+// the namespace lock held; releases it.
+static mx_status_t mxdir_remote_open_locked(mxio_ns_t* ns, mxvn_t* vn,
+                                            const char* path, int32_t flags,
+                                            uint32_t mode, mxio_t** out) {
+    mxdc_entry_t* dc;
+    mx_status_t r;
+
+    // an open of a cached directory itself is just a clone of the
+    // cached connection -- pipelined, no synchronous round trip
+    if (((flags & ~O_DIRECTORY) == O_RDONLY) &&
+        ((dc = dc_lookup_locked(ns, vn, path, strlen(path))) != NULL)) {
+        mx_handle_t h = mxio_service_clone(dc->h);
+        mtx_unlock(&ns->lock);
+        if (h == MX_HANDLE_INVALID) {
+            return MX_ERR_BAD_HANDLE;
+        }
+        return mxio_from_handles(MXIO_PROTOCOL_REMOTE, &h, 1, NULL, 0, out);
+    }
+
+    const char* last = strrchr(path, '/');
+    if ((last == NULL) || (vn->dc_state == MXDC_UNSUPPORTED)) {
+        mtx_unlock(&ns->lock);
+        return mxrio_open_handle(vn->remote, path, flags, mode, out);
+    }
+
+    // if the parent directory is cached, only the final component
+    // needs to be resolved by the remote
+    size_t dlen = last - path;
+    const char* leaf = last + 1;
+    if ((dc = dc_lookup_locked(ns, vn, path, dlen)) != NULL) {
+        // clone the cached connection so the entry can't be evicted
+        // (and its handle closed) under us once we drop the lock
+        mx_handle_t h = mxio_service_clone(dc->h);
+        mtx_unlock(&ns->lock);
+        if (h == MX_HANDLE_INVALID) {
+            return MX_ERR_BAD_HANDLE;
+        }
+        r = mxrio_open_handle(h, leaf, flags, mode, out);
+        mx_handle_close(h);
+        return r;
+    }
+    mtx_unlock(&ns->lock);
+
+    // miss: resolve and cache the parent, then open the leaf relative
+    // to it.  the extra OPEN here is repaid as soon as anything in the
+    // directory is looked up again.
+    // (vn is safe to use unlocked: vnodes and their remotes are
+    // immutable while the namespace refcount is nonzero, and our
+    // caller's mxio_dir holds a reference)
+    char dirpath[PATH_MAX];
+    if (dlen < sizeof(dirpath)) {
+        memcpy(dirpath, path, dlen);
+        dirpath[dlen] = 0;
+        mx_handle_t dh;
+        if (mxrio_open_handle_raw(vn->remote, dirpath, O_RDONLY | O_DIRECTORY,
+                                  0, &dh) == MX_OK) {
+            mx_handle_t watch;
+            if ((r = dc_watch(dh, &watch)) == MX_OK) {
+                r = mxrio_open_handle(dh, leaf, flags, mode, out);
+                mtx_lock(&ns->lock);
+                vn->dc_state = MXDC_OK;
+                if (dc_lookup_locked(ns, vn, path, dlen) != NULL) {
+                    // another thread cached it while we were unlocked
+                    mx_handle_close(dh);
+                    mx_handle_close(watch);
+                } else {
+                    dc_install_locked(ns, vn, path, dlen, dh, watch);
+                }
+                mtx_unlock(&ns->lock);
+                return r;
+            }
+            mx_handle_close(dh);
+            if (r == MX_ERR_NOT_SUPPORTED) {
+                // this filesystem can't tell us when directories
+                // change, so it is never safe to cache
+                mtx_lock(&ns->lock);
+                vn->dc_state = MXDC_UNSUPPORTED;
+                mtx_unlock(&ns->lock);
+            }
+        }
+    }
+    return mxrio_open_handle(vn->remote, path, flags, mode, out);
+}
+
 static mx_status_t mxdir_close(mxio_t* io) {
     mxdir_t* dir = (mxdir_t*) io;
     mtx_lock(&dir->ns->lock);
@@ -328,9 +538,9 @@ static mx_status_t mxdir_open(mxio_t* io, const char* path,
             break;
         }
 
-        // hand off to remote filesystem
-        mtx_unlock(&dir->ns->lock);
-        return mxrio_open_handle(vn->remote, path, flags, mode, out);
+        // hand off to remote filesystem, via the dentry cache
+        // (which releases the namespace lock)
+        return mxdir_remote_open_locked(dir->ns, vn, path, flags, mode, out);
     }
     if (r == MX_OK) {
         if ((vn->remote == MX_HANDLE_INVALID) && (save_vn != NULL)) {
@@ -450,6 +660,11 @@ static mx_status_t mxdir_misc(mxio_t* io, uint32_t op, int64_t off,
         }
         mtx_unlock(&dir->ns->lock);
         return r;
+    case MXRIO_READDIR_VMO:
+        // bulk readdir bypasses the local-children merge and filter
+        // above, so force callers back onto the chunked path
+        mx_handle_close((mx_handle_t) off);
+        return MX_ERR_NOT_SUPPORTED;
     case MXRIO_STAT:
         if (maxreply < sizeof(vnattr_t)) {
             return MX_ERR_INVALID_ARGS;
@@ -527,6 +742,7 @@ mx_status_t mxio_ns_destroy(mxio_ns_t* ns) {
         mtx_unlock(&ns->lock);
         return MX_ERR_BAD_STATE;
     } else {
+        dc_flush_locked(ns);
         vn_destroy_children_locked(&ns->root);
         mtx_unlock(&ns->lock);
         free(ns);
@@ -552,6 +768,9 @@ mx_status_t mxio_ns_bind(mxio_ns_t* ns, const char* path, mx_handle_t remote) {
         r = MX_ERR_BAD_STATE;
         goto done;
     }
+    // rebinding changes what paths resolve to; don't let cached
+    // directories from the old layout survive
+    dc_flush_locked(ns);
     mxvn_t* vn = &ns->root;
     if (path[0] == 0) {
         // the path was "/" so we're trying to bind to the root vnode
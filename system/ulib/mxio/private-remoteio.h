@@ -19,8 +19,24 @@ struct mxrio {
 
     // transaction id used for synchronous remoteio calls
     _Atomic mx_txid_t txid;
+
+    // set once the remote rejects MXRIO_READ_VMO/MXRIO_WRITE_VMO, so
+    // large transfers stop retrying the bulk path on this connection
+    _Atomic bool bulk_unsupported;
+
+    // MSG_MORE coalescing state for stream sockets. Sends flagged MSG_MORE
+    // accumulate in |more_buf| (allocated on first use) until a send
+    // without the flag, a full buffer, shutdown or close pushes everything
+    // out as one socket write. Guarded by |more_lock|, which is valid
+    // zero-initialized.
+    mtx_t more_lock;
+    char* more_buf;
+    uint32_t more_len;
 };
 
+// true if io is a plain remoteio object (not a socket or other transport)
+bool __mxio_is_remoteio(mxio_t* io);
+
 // These are for the benefit of namespace.c
 // which needs lower level access to remoteio internals
 
@@ -38,6 +54,10 @@ mx_status_t mxrio_open_handle_raw(mx_handle_t h, const char* path, int32_t flags
 mx_status_t mxrio_open(mxio_t* io, const char* path, int32_t flags,
                        uint32_t mode, mxio_t** out);
 
+// ioctl operation directly on a remoteio handle
+ssize_t mxrio_ioctl_handle(mx_handle_t h, uint32_t op, const void* in_buf,
+                           size_t in_len, void* out_buf, size_t out_len);
+
 // misc operation directly on remoteio mxio_t
 mx_status_t mxrio_misc(mxio_t* io, uint32_t op, int64_t off,
                        uint32_t maxreply, void* ptr, size_t len);
@@ -334,6 +334,77 @@ ssize_t mxrio_ioctl(mxio_t* io, uint32_t op, const void* in_buf,
     return r;
 }
 
+// Bulk transfer path for large reads and writes. Rather than moving the
+// data MXIO_CHUNK_SIZE bytes per synchronous round trip, hand the server a
+// VMO to fill (MXRIO_READ_VMO) or drain (MXRIO_WRITE_VMO) and reply once.
+// An |offset| of -1 directs the server to use (and advance) the
+// connection's seek offset. Returns MX_ERR_NOT_SUPPORTED when the remote
+// does not implement the bulk ops; callers fall back to chunking.
+static ssize_t rw_vmo_common(uint32_t op, mxrio_t* rio, void* data, size_t len, off_t offset) {
+    if (atomic_load(&rio->bulk_unsupported)) {
+        return MX_ERR_NOT_SUPPORTED;
+    }
+    if (len > INT32_MAX) {
+        // arg is 32 bits; callers treat the result as a short transfer
+        len = INT32_MAX;
+    }
+
+    mx_handle_t vmo;
+    mx_status_t r;
+    if ((r = mx_vmo_create(len, 0, &vmo)) != MX_OK) {
+        // without a transfer VMO, chunking is the only option
+        return MX_ERR_NOT_SUPPORTED;
+    }
+    // keep our own handle; a duplicate travels to the server
+    mx_handle_t xfer;
+    if ((r = mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &xfer)) != MX_OK) {
+        mx_handle_close(vmo);
+        return MX_ERR_NOT_SUPPORTED;
+    }
+
+    size_t actual;
+    if (op == MXRIO_WRITE_VMO) {
+        if (((r = mx_vmo_write(vmo, data, 0, len, &actual)) != MX_OK) ||
+            (actual != len)) {
+            mx_handle_close(xfer);
+            mx_handle_close(vmo);
+            return MX_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    mxrio_msg_t msg;
+    memset(&msg, 0, MXRIO_HDR_SZ);
+    msg.op = op;
+    msg.arg = (int32_t)len;
+    msg.arg2.off = offset;
+    msg.hcount = 1;
+    msg.handle[0] = xfer; // consumed by mxrio_txn, even on failure
+
+    if ((r = mxrio_txn(rio, &msg)) < 0) {
+        mx_handle_close(vmo);
+        if (r == MX_ERR_NOT_SUPPORTED) {
+            // old server: stop asking on this connection
+            atomic_store(&rio->bulk_unsupported, true);
+        }
+        return r;
+    }
+    discard_handles(msg.handle, msg.hcount);
+
+    if ((size_t)r > len) {
+        mx_handle_close(vmo);
+        return MX_ERR_IO;
+    }
+    if ((op == MXRIO_READ_VMO) && (r > 0)) {
+        mx_status_t rr = mx_vmo_read(vmo, data, 0, r, &actual);
+        if ((rr != MX_OK) || (actual != (size_t)r)) {
+            mx_handle_close(vmo);
+            return MX_ERR_IO;
+        }
+    }
+    mx_handle_close(vmo);
+    return r;
+}
+
 static ssize_t write_common(uint32_t op, mxio_t* io, const void* _data, size_t len, off_t offset) {
     mxrio_t* rio = (mxrio_t*)io;
     const uint8_t* data = _data;
@@ -342,6 +413,16 @@ static ssize_t write_common(uint32_t op, mxio_t* io, const void* _data, size_t l
     mxrio_msg_t msg;
     ssize_t xfer;
 
+    // large writes: try to hand the server a VMO and transfer in a
+    // single round trip, falling back to chunking on old servers
+    if (len > MXIO_CHUNK_SIZE) {
+        r = rw_vmo_common(MXRIO_WRITE_VMO, rio, (void*)data, len,
+                          (op == MXRIO_WRITE_AT) ? offset : -1);
+        if (r != MX_ERR_NOT_SUPPORTED) {
+            return r;
+        }
+    }
+
     while (len > 0) {
         xfer = (len > MXIO_CHUNK_SIZE) ? MXIO_CHUNK_SIZE : len;
 
@@ -390,6 +471,16 @@ static ssize_t read_common(uint32_t op, mxio_t* io, void* _data, size_t len, off
     mxrio_msg_t msg;
     ssize_t xfer;
 
+    // large reads: try to hand the server a VMO and transfer in a
+    // single round trip, falling back to chunking on old servers
+    if (len > MXIO_CHUNK_SIZE) {
+        r = rw_vmo_common(MXRIO_READ_VMO, rio, data, len,
+                          (op == MXRIO_READ_AT) ? offset : -1);
+        if (r != MX_ERR_NOT_SUPPORTED) {
+            return r;
+        }
+    }
+
     while (len > 0) {
         xfer = (len > MXIO_CHUNK_SIZE) ? MXIO_CHUNK_SIZE : len;
 
@@ -596,7 +687,10 @@ mx_status_t mxrio_misc(mxio_t* io, uint32_t op, int64_t off,
     mxrio_msg_t msg;
     mx_status_t r;
 
-    if ((len > MXIO_CHUNK_SIZE) || (maxreply > MXIO_CHUNK_SIZE)) {
+    // READDIR_VMO replies carry no inline data, so maxreply (the vmo
+    // capacity) may exceed the message chunk size
+    if ((len > MXIO_CHUNK_SIZE) ||
+        ((maxreply > MXIO_CHUNK_SIZE) && (op != MXRIO_READDIR_VMO))) {
         return MX_ERR_INVALID_ARGS;
     }
 
@@ -615,6 +709,13 @@ mx_status_t mxrio_misc(mxio_t* io, uint32_t op, int64_t off,
         // the offset argument.
         msg.handle[0] = (mx_handle_t) off;
         msg.hcount = 1;
+        break;
+    case MXRIO_READDIR_VMO:
+        // ...as does 'ReaddirVmo' for the vmo to fill
+        msg.handle[0] = (mx_handle_t) off;
+        msg.hcount = 1;
+        msg.arg2.off = 0;
+        break;
     }
 
     if ((r = mxrio_txn(rio, &msg)) < 0) {
@@ -809,6 +910,14 @@ mx_status_t mxrio_open_handle_raw(mx_handle_t h, const char* path, int32_t flags
     return MX_ERR_WRONG_TYPE;
 }
 
+ssize_t mxrio_ioctl_handle(mx_handle_t h, uint32_t op, const void* in_buf,
+                           size_t in_len, void* out_buf, size_t out_len) {
+    mxrio_t rio;
+    memset(&rio, 0, sizeof(rio));
+    rio.h = h;
+    return mxrio_ioctl(&rio.io, op, in_buf, in_len, out_buf, out_len);
+}
+
 mx_status_t mxrio_open(mxio_t* io, const char* path, int32_t flags, uint32_t mode, mxio_t** out) {
     mxrio_t* rio = (void*)io;
     mxrio_object_t info;
@@ -901,6 +1010,10 @@ static mxio_ops_t mx_remote_ops = {
     .get_vmo = mxio_default_get_vmo,
 };
 
+bool __mxio_is_remoteio(mxio_t* io) {
+    return io->ops == &mx_remote_ops;
+}
+
 mxio_t* mxio_remote_create(mx_handle_t h, mx_handle_t e) {
     mxrio_t* rio = calloc(1, sizeof(*rio));
     if (rio == NULL) {
@@ -74,7 +74,7 @@ static ssize_t mxsio_recvfrom(mxio_t* io, void* data, size_t len, int flags, str
     return r;
 }
 
-static ssize_t mxsio_write_stream(mxio_t* io, const void* data, size_t len) {
+static ssize_t mxsio_write_stream_raw(mxio_t* io, const void* data, size_t len) {
     mxrio_t* rio = (mxrio_t*)io;
     int nonblock = rio->io.flags & MXIO_FLAG_NONBLOCK;
 
@@ -105,6 +105,38 @@ static ssize_t mxsio_write_stream(mxio_t* io, const void* data, size_t len) {
     }
 }
 
+// Largest send that is worth gathering into one socket write, and the size
+// of the MSG_MORE holdback buffer. Covers a typical header + small body.
+#define MXSIO_COALESCE_MAX 2048u
+
+static mx_status_t mxsio_flush_more_locked(mxrio_t* rio) {
+    while (rio->more_len > 0) {
+        ssize_t r = mxsio_write_stream_raw(&rio->io, rio->more_buf, rio->more_len);
+        if (r < 0) {
+            return (mx_status_t)r;
+        }
+        memmove(rio->more_buf, rio->more_buf + r, rio->more_len - r);
+        rio->more_len -= r;
+    }
+    return MX_OK;
+}
+
+static ssize_t mxsio_write_stream(mxio_t* io, const void* data, size_t len) {
+    mxrio_t* rio = (mxrio_t*)io;
+
+    // Anything held back by MSG_MORE must go out first so bytes stay in
+    // order. The common case (no holdback) is a flag test.
+    if (rio->more_len > 0) {
+        mtx_lock(&rio->more_lock);
+        mx_status_t r = mxsio_flush_more_locked(rio);
+        mtx_unlock(&rio->more_lock);
+        if (r != MX_OK) {
+            return r;
+        }
+    }
+    return mxsio_write_stream_raw(io, data, len);
+}
+
 static ssize_t mxsio_sendto(mxio_t* io, const void* data, size_t len, int flags, const struct sockaddr* addr, socklen_t addrlen) {
     struct iovec iov;
     iov.iov_base = (void*)data;
@@ -137,6 +169,30 @@ static ssize_t mxsio_recvmsg_stream(mxio_t* io, struct msghdr* msg, int flags) {
     } else {
         return MX_ERR_BAD_STATE;
     }
+    // A small scattered read costs one socket read into a local buffer
+    // instead of one per iovec.
+    size_t want = 0;
+    for (int i = 0; i < msg->msg_iovlen; i++) {
+        want += msg->msg_iov[i].iov_len;
+    }
+    if (msg->msg_iovlen > 1 && want <= MXSIO_COALESCE_MAX) {
+        char buf[MXSIO_COALESCE_MAX];
+        ssize_t n = mxsio_read_stream(io, buf, want);
+        if (n < 0) {
+            return n;
+        }
+        size_t resid = n;
+        char* data = buf;
+        for (int i = 0; i < msg->msg_iovlen && resid > 0; i++) {
+            struct iovec *iov = &msg->msg_iov[i];
+            size_t copy_len = (resid < iov->iov_len) ? resid : iov->iov_len;
+            memcpy(iov->iov_base, data, copy_len);
+            data += copy_len;
+            resid -= copy_len;
+        }
+        return n;
+    }
+
     ssize_t total = 0;
     for (int i = 0; i < msg->msg_iovlen; i++) {
         struct iovec *iov = &msg->msg_iov[i];
@@ -153,11 +209,11 @@ static ssize_t mxsio_recvmsg_stream(mxio_t* io, struct msghdr* msg, int flags) {
 }
 
 static ssize_t mxsio_sendmsg_stream(mxio_t* io, const struct msghdr* msg, int flags) {
-    if (flags != 0) {
+    if (flags & ~MSG_MORE) {
         // TODO: support MSG_OOB
         return MX_ERR_NOT_SUPPORTED;
     }
-    // TODO: support flags and control messages
+    // TODO: support control messages
     if (io->flags & MXIO_FLAG_SOCKET_CONNECTED) {
         // if connected, can't specify address
         if (msg->msg_name != NULL || msg->msg_namelen != 0) {
@@ -166,22 +222,71 @@ static ssize_t mxsio_sendmsg_stream(mxio_t* io, const struct msghdr* msg, int fl
     } else {
         return MX_ERR_BAD_STATE;
     }
-    ssize_t total = 0;
+
+    mxrio_t* rio = (mxrio_t*)io;
+
+    size_t total = 0;
     for (int i = 0; i < msg->msg_iovlen; i++) {
-        struct iovec *iov = &msg->msg_iov[i];
-        if (iov->iov_len <= 0) {
+        if (msg->msg_iov[i].iov_len <= 0) {
             return MX_ERR_INVALID_ARGS;
         }
-        ssize_t n = mxsio_write_stream(io, iov->iov_base, iov->iov_len);
+        total += msg->msg_iov[i].iov_len;
+    }
+
+    mtx_lock(&rio->more_lock);
+
+    // A send flagged MSG_MORE is held back so a header written separately
+    // from its body still goes out as one socket write.
+    if ((flags & MSG_MORE) && rio->more_len + total <= MXSIO_COALESCE_MAX) {
+        if (rio->more_buf == NULL &&
+            (rio->more_buf = malloc(MXSIO_COALESCE_MAX)) == NULL) {
+            mtx_unlock(&rio->more_lock);
+            return MX_ERR_NO_MEMORY;
+        }
+        for (int i = 0; i < msg->msg_iovlen; i++) {
+            memcpy(rio->more_buf + rio->more_len, msg->msg_iov[i].iov_base,
+                   msg->msg_iov[i].iov_len);
+            rio->more_len += msg->msg_iov[i].iov_len;
+        }
+        mtx_unlock(&rio->more_lock);
+        return total;
+    }
+
+    // Push out anything previously held back (or an oversized MSG_MORE
+    // payload's predecessors) before this send, to keep bytes in order.
+    mx_status_t r = mxsio_flush_more_locked(rio);
+    if (r != MX_OK) {
+        mtx_unlock(&rio->more_lock);
+        return r;
+    }
+
+    // Gather small scattered sends into one socket write.
+    if (msg->msg_iovlen > 1 && total <= MXSIO_COALESCE_MAX) {
+        char buf[MXSIO_COALESCE_MAX];
+        char* data = buf;
+        for (int i = 0; i < msg->msg_iovlen; i++) {
+            memcpy(data, msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+            data += msg->msg_iov[i].iov_len;
+        }
+        ssize_t n = mxsio_write_stream_raw(io, buf, total);
+        mtx_unlock(&rio->more_lock);
+        return n;
+    }
+    mtx_unlock(&rio->more_lock);
+
+    ssize_t sent = 0;
+    for (int i = 0; i < msg->msg_iovlen; i++) {
+        struct iovec *iov = &msg->msg_iov[i];
+        ssize_t n = mxsio_write_stream_raw(io, iov->iov_base, iov->iov_len);
         if (n < 0) {
             return n;
         }
-        total += n;
+        sent += n;
         if ((size_t)n != iov->iov_len) {
             break;
         }
     }
-    return total;
+    return sent;
 }
 
 static mx_status_t mxsio_clone_stream(mxio_t* io, mx_handle_t* handles, uint32_t* types) {
@@ -300,6 +405,20 @@ static void mxsio_wait_end_stream(mxio_t* io, mx_signals_t signals, uint32_t* _e
     *_events = events;
 }
 
+static mx_status_t mxsio_close_stream(mxio_t* io) {
+    mxrio_t* rio = (mxrio_t*)io;
+
+    // Best effort: anything still held back by MSG_MORE goes out before
+    // the handles are closed.
+    mtx_lock(&rio->more_lock);
+    mxsio_flush_more_locked(rio);
+    free(rio->more_buf);
+    rio->more_buf = NULL;
+    mtx_unlock(&rio->more_lock);
+
+    return mxrio_close(io);
+}
+
 static ssize_t mxsio_posix_ioctl_stream(mxio_t* io, int req, va_list va) {
     mxrio_t* rio = (mxrio_t*)io;
     switch (req) {
@@ -382,15 +501,24 @@ static ssize_t mxsio_recvmsg_dgram(mxio_t* io, struct msghdr* msg, int flags) {
     }
     mlen += MXIO_SOCKET_MSG_HEADER_SIZE;
 
-    // TODO: avoid malloc
-    mxio_socket_msg_t* m = malloc(mlen);
+    // Typical datagrams fit on the stack; only jumbo ones pay for a malloc.
+    union {
+        mxio_socket_msg_t msg;
+        char bytes[MXSIO_COALESCE_MAX];
+    } stack;
+    mxio_socket_msg_t* m = &stack.msg;
+    if (mlen > sizeof(stack) && (m = malloc(mlen)) == NULL) {
+        return MX_ERR_NO_MEMORY;
+    }
     ssize_t n = mxsio_rx_dgram(io, m, mlen);
     if (n < 0) {
-        free(m);
+        if (m != &stack.msg)
+            free(m);
         return n;
     }
     if ((size_t)n < MXIO_SOCKET_MSG_HEADER_SIZE) {
-        free(m);
+        if (m != &stack.msg)
+            free(m);
         return MX_ERR_INTERNAL;
     }
     n -= MXIO_SOCKET_MSG_HEADER_SIZE;
@@ -414,7 +542,8 @@ static ssize_t mxsio_recvmsg_dgram(mxio_t* io, struct msghdr* msg, int flags) {
             resid -= iov->iov_len;
         }
     }
-    free(m);
+    if (m != &stack.msg)
+        free(m);
     return n;
 }
 
@@ -440,8 +569,14 @@ static ssize_t mxsio_sendmsg_dgram(mxio_t* io, const struct msghdr* msg, int fla
     }
     size_t mlen = n + MXIO_SOCKET_MSG_HEADER_SIZE;
 
-    // TODO: avoid malloc m
-    mxio_socket_msg_t* m = malloc(mlen);
+    union {
+        mxio_socket_msg_t msg;
+        char bytes[MXSIO_COALESCE_MAX];
+    } stack;
+    mxio_socket_msg_t* m = &stack.msg;
+    if (mlen > sizeof(stack) && (m = malloc(mlen)) == NULL) {
+        return MX_ERR_NO_MEMORY;
+    }
     if (msg->msg_name != NULL) {
         memcpy(&m->addr, msg->msg_name, msg->msg_namelen);
     }
@@ -454,7 +589,8 @@ static ssize_t mxsio_sendmsg_dgram(mxio_t* io, const struct msghdr* msg, int fla
         data += iov->iov_len;
     }
     ssize_t r = mxsio_tx_dgram(io, m, mlen);
-    free(m);
+    if (m != &stack.msg)
+        free(m);
     return r == MX_OK ? n : r;
 }
 
@@ -503,7 +639,7 @@ static mxio_ops_t mxio_socket_stream_ops = {
     .sendmsg = mxsio_sendmsg_stream,
     .seek = mxio_default_seek,
     .misc = mxrio_misc,
-    .close = mxrio_close,
+    .close = mxsio_close_stream,
     .open = mxrio_open,
     .clone = mxsio_clone_stream,
     .ioctl = mxrio_ioctl,
@@ -574,6 +710,11 @@ mx_status_t mxio_socket_shutdown(mxio_t* io, int how) {
     }
     if (how == SHUT_WR || how == SHUT_RDWR) {
         // TODO: turn on a flag to prevent all write attempts
+        if (rio->more_len > 0) {
+            mtx_lock(&rio->more_lock);
+            mxsio_flush_more_locked(rio);
+            mtx_unlock(&rio->more_lock);
+        }
         mx_object_signal_peer(rio->h2, 0u, MXSIO_SIGNAL_HALFCLOSED);
     }
     return MX_OK;
@@ -1164,6 +1164,23 @@ static int getdirents(int fd, void* ptr, size_t len, long cmd) {
     return r;
 }
 
+// Asks the server to pack dirents into (a duplicate of) the provided
+// vmo in a single pass.  Returns the raw status, so callers can tell
+// MX_ERR_NOT_SUPPORTED apart and fall back to chunked readdir.
+static mx_status_t getdirents_vmo(int fd, mx_handle_t vmo, size_t len) {
+    mxio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return MX_ERR_BAD_HANDLE;
+    }
+    mx_handle_t h;
+    mx_status_t r = mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &h);
+    if (r == MX_OK) {
+        r = io->ops->misc(io, MXRIO_READDIR_VMO, (int64_t)h, len, NULL, 0);
+    }
+    mxio_release(io);
+    return r;
+}
+
 static int truncateat(int dirfd, const char* path, off_t len) {
     mxio_t* io;
     mx_status_t r;
@@ -1585,6 +1602,13 @@ int chdir(const char* path) {
 
 #define DIR_BUFSIZE 2048
 
+// Once a directory has delivered DIR_BULK_THRESHOLD chunked buffers
+// without ending, assume it is large and switch to streaming dirents
+// through a vmo filled by a single MXRIO_READDIR_VMO round trip,
+// rather than one RPC per DIR_BUFSIZE of entries.
+#define DIR_BULK_THRESHOLD 4
+#define DIR_VMO_SIZE (1 << 21)
+
 struct __dirstream {
     mtx_t lock;
     int fd;
@@ -1593,8 +1617,18 @@ struct __dirstream {
     // Offset into 'data' of next ptr. NULL to reset the
     // directory lazily on the next call to getdirents
     uint8_t* ptr;
-    // Internal cache of dirents
-    uint8_t data[DIR_BUFSIZE];
+    // Bulk streaming state: dirents buffered in 'vmo' between
+    // 'vmo_off' and 'vmo_len' are consumed before any further RPCs
+    mx_handle_t vmo;
+    size_t vmo_off;
+    size_t vmo_len;
+    // Consecutive chunked refills without the directory ending
+    int refills;
+    // Remote does not implement MXRIO_READDIR_VMO
+    bool no_bulk;
+    // Internal cache of dirents (keep 4-byte aligned: it is parsed
+    // in place as packed vdirent_t records)
+    uint8_t data[DIR_BUFSIZE] __attribute__((aligned(4)));
     // Buffer returned to user
     struct dirent de;
 };
@@ -1635,6 +1669,9 @@ DIR* fdopendir(int fd) {
 }
 
 int closedir(DIR* dir) {
+    if (dir->vmo != MX_HANDLE_INVALID) {
+        mx_handle_close(dir->vmo);
+    }
     close(dir->fd);
     free(dir);
     return 0;
@@ -1664,11 +1701,68 @@ struct dirent* readdir(DIR* dir) {
             }
             dir->size = 0;
         }
+        if (dir->ptr == NULL) {
+            // rewound: discard any buffered bulk dirents; the RESET
+            // command below also resets the remote readdir position
+            dir->vmo_off = 0;
+            dir->vmo_len = 0;
+            dir->refills = 0;
+        }
+        // drain buffered bulk dirents before issuing any RPC
+        if (dir->vmo_off < dir->vmo_len) {
+            size_t n = dir->vmo_len - dir->vmo_off;
+            if (n > DIR_BUFSIZE) {
+                n = DIR_BUFSIZE;
+            }
+            size_t actual = 0;
+            mx_vmo_read(dir->vmo, dir->data, dir->vmo_off, n, &actual);
+            // take only whole dirents; one split by the buffer
+            // boundary stays in the vmo for the next refill
+            size_t used = 0;
+            while (actual - used >= sizeof(vdirent_t)) {
+                vdirent_t* vde = (void*)(dir->data + used);
+                if ((vde->size < sizeof(vdirent_t)) ||
+                    (vde->size > actual - used)) {
+                    break;
+                }
+                used += vde->size;
+            }
+            if (used > 0) {
+                dir->vmo_off += used;
+                dir->ptr = dir->data;
+                dir->size = used;
+                continue;
+            }
+            // short read or malformed data; fall back to RPC
+            dir->vmo_off = 0;
+            dir->vmo_len = 0;
+        }
         int64_t cmd = (dir->ptr == NULL) ? READDIR_CMD_RESET : READDIR_CMD_NONE;
+        if (!dir->no_bulk && (cmd == READDIR_CMD_NONE) &&
+            (dir->refills >= DIR_BULK_THRESHOLD)) {
+            if ((dir->vmo == MX_HANDLE_INVALID) &&
+                (mx_vmo_create(DIR_VMO_SIZE, 0, &dir->vmo) != MX_OK)) {
+                dir->no_bulk = true;
+            }
+            if (dir->vmo != MX_HANDLE_INVALID) {
+                mx_status_t rs = getdirents_vmo(dir->fd, dir->vmo, DIR_VMO_SIZE);
+                if (rs > 0) {
+                    dir->vmo_off = 0;
+                    dir->vmo_len = rs;
+                    continue;
+                }
+                if (rs == MX_ERR_NOT_SUPPORTED) {
+                    dir->no_bulk = true;
+                }
+                // on any other result (including end-of-directory)
+                // let the chunked path below produce the answer
+            }
+        }
         int r = getdirents(dir->fd, dir->data, DIR_BUFSIZE, cmd);
         if (r > 0) {
             dir->ptr = dir->data;
             dir->size = r;
+            dir->refills++;
             continue;
         }
         de = NULL;
@@ -5,11 +5,14 @@
 #include <poll.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <threads.h>
 
 #include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
 #include <mxio/io.h>
 
 #include "private.h"
+#include "unistd.h"
 
 typedef struct mxwio mxwio_t;
 struct mxwio {
@@ -87,6 +90,172 @@ static mxio_ops_t mxio_waitable_ops = {
     .posix_ioctl = mxio_default_posix_ioctl,
 };
 
+// Wait sets ------------------------------------------------------------------
+//
+// A wait set translates each fd to its handle/signals pair once, at
+// registration, and arms a repeating async wait on a port. A steady-state
+// polling loop then costs one mx_port_wait_multiple() per iteration instead
+// of re-running wait_begin across every fd and rebuilding a wait item array
+// the way poll() does.
+
+typedef struct mxws_entry mxws_entry_t;
+struct mxws_entry {
+    mxws_entry_t* next;
+    mxio_t* io; // held referenced while registered
+    mx_handle_t h; // borrowed from io
+    uint64_t key;
+    uint32_t events;
+};
+
+struct mxio_waitset {
+    mtx_t lock;
+    mx_handle_t port;
+    mxws_entry_t* entries;
+};
+
+mx_status_t mxio_waitset_create(mxio_waitset_t** out) {
+    mxio_waitset_t* ws = calloc(1, sizeof(*ws));
+    if (ws == NULL) {
+        return MX_ERR_NO_MEMORY;
+    }
+    mx_status_t status = mx_port_create(0, &ws->port);
+    if (status != MX_OK) {
+        free(ws);
+        return status;
+    }
+    mtx_init(&ws->lock, mtx_plain);
+    *out = ws;
+    return MX_OK;
+}
+
+mx_status_t mxio_waitset_add(mxio_waitset_t* ws, uint64_t key, int fd, uint32_t events) {
+    mxio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return MX_ERR_BAD_HANDLE;
+    }
+
+    mx_handle_t h = MX_HANDLE_INVALID;
+    mx_signals_t sigs = 0;
+    io->ops->wait_begin(io, events, &h, &sigs);
+    if (h == MX_HANDLE_INVALID) {
+        mxio_release(io);
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    mxws_entry_t* entry = calloc(1, sizeof(*entry));
+    if (entry == NULL) {
+        mxio_release(io);
+        return MX_ERR_NO_MEMORY;
+    }
+
+    mtx_lock(&ws->lock);
+    for (mxws_entry_t* e = ws->entries; e != NULL; e = e->next) {
+        if (e->key == key) {
+            mtx_unlock(&ws->lock);
+            free(entry);
+            mxio_release(io);
+            return MX_ERR_ALREADY_EXISTS;
+        }
+    }
+
+    mx_status_t status = mx_object_wait_async(h, ws->port, key, sigs,
+                                              MX_WAIT_ASYNC_REPEATING);
+    if (status != MX_OK) {
+        mtx_unlock(&ws->lock);
+        free(entry);
+        mxio_release(io);
+        return status;
+    }
+
+    // The entry keeps |io| referenced, so |h| stays valid even if the fd
+    // is closed while still registered.
+    entry->io = io;
+    entry->h = h;
+    entry->key = key;
+    entry->events = events;
+    entry->next = ws->entries;
+    ws->entries = entry;
+    mtx_unlock(&ws->lock);
+    return MX_OK;
+}
+
+mx_status_t mxio_waitset_remove(mxio_waitset_t* ws, uint64_t key) {
+    mtx_lock(&ws->lock);
+    mxws_entry_t** prev = &ws->entries;
+    mxws_entry_t* entry = ws->entries;
+    while (entry != NULL && entry->key != key) {
+        prev = &entry->next;
+        entry = entry->next;
+    }
+    if (entry == NULL) {
+        mtx_unlock(&ws->lock);
+        return MX_ERR_NOT_FOUND;
+    }
+    *prev = entry->next;
+    mx_port_cancel(ws->port, entry->h, entry->key);
+    mtx_unlock(&ws->lock);
+
+    mxio_release(entry->io);
+    free(entry);
+    return MX_OK;
+}
+
+mx_status_t mxio_waitset_wait(mxio_waitset_t* ws, mx_time_t deadline,
+                              mxio_waitset_result_t* results, size_t count,
+                              size_t* actual) {
+    if (count == 0 || count > MX_PORT_MAX_WAIT_PACKETS) {
+        return MX_ERR_INVALID_ARGS;
+    }
+
+    mx_port_packet_t packets[MX_PORT_MAX_WAIT_PACKETS];
+    uint32_t num_packets = 0;
+    mx_status_t status = mx_port_wait_multiple(ws->port, deadline, packets,
+                                               (uint32_t)count, &num_packets);
+    if (status != MX_OK) {
+        return status;
+    }
+
+    size_t n = 0;
+    mtx_lock(&ws->lock);
+    for (uint32_t i = 0; i < num_packets; i++) {
+        if (!MX_PKT_IS_SIGNAL_REP(packets[i].type)) {
+            continue;
+        }
+        for (mxws_entry_t* e = ws->entries; e != NULL; e = e->next) {
+            if (e->key != packets[i].key) {
+                continue;
+            }
+            uint32_t events = 0;
+            e->io->ops->wait_end(e->io, packets[i].signal.observed, &events);
+            results[n].key = e->key;
+            results[n].events = events & (e->events | POLLHUP | POLLERR);
+            n++;
+            break;
+        }
+    }
+    mtx_unlock(&ws->lock);
+
+    *actual = n;
+    return MX_OK;
+}
+
+void mxio_waitset_destroy(mxio_waitset_t* ws) {
+    mtx_lock(&ws->lock);
+    mxws_entry_t* entry = ws->entries;
+    ws->entries = NULL;
+    mtx_unlock(&ws->lock);
+
+    while (entry != NULL) {
+        mxws_entry_t* next = entry->next;
+        mx_port_cancel(ws->port, entry->h, entry->key);
+        mxio_release(entry->io);
+        free(entry);
+        entry = next;
+    }
+    mx_handle_close(ws->port);
+    free(ws);
+}
+
 mxio_t* mxio_waitable_create(mx_handle_t h, mx_signals_t signals_in,
                              mx_signals_t signals_out, bool shared_handle) {
     mxwio_t* wio = calloc(1, sizeof(*wio));
@@ -0,0 +1,37 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/assert.h>
+#include <mxalloc/new.h>
+
+namespace mxtl {
+
+struct DefaultAllocatorTraits {
+    // Allocate receives a request for "size" contiguous bytes.
+    // size will always be greater than zero.
+    // The return value must be "nullptr" on error, or a non-null
+    // pointer on success. This same pointer may later be passed
+    // to deallocate when resizing.
+    static void* Allocate(size_t size) {
+        MX_DEBUG_ASSERT(size > 0);
+        AllocChecker ac;
+        void* object = new (&ac) char[size]();
+        return ac.check() ? object : nullptr;
+    }
+
+    // Deallocate receives a pointer to an object which is
+    // 1) Either a pointer provided by Allocate, or
+    // 2) nullptr.
+    // If the pointer is not null, deallocate must free
+    // the underlying memory used by the object.
+    static void Deallocate(void* object) {
+        if (object != nullptr) {
+            delete reinterpret_cast<char*>(object);
+        }
+    }
+};
+
+}  // namespace mxtl
@@ -0,0 +1,84 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <mxtl/ref_ptr.h>
+#include <mxtl/type_support.h>
+
+namespace mxtl {
+
+// Borrowed<T> is a non-owning reference to a refcounted object of type T.
+//
+// Passing Borrowed<T> instead of RefPtr<T> (or instead of a raw T*) documents
+// that the callee only uses the object for the duration of the call and takes
+// no reference of its own, so the call touches neither AddRef() nor Release().
+// In hot paths (for example a dispatcher that lives for one syscall) this
+// keeps the refcount cacheline out of the picture entirely.
+//
+// The caller must guarantee that an owning reference outlives the borrow;
+// borrowing from a RefPtr is implicit and free. A callee that decides it
+// must keep the object beyond the call takes its own reference explicitly
+// with CopyRef().
+//
+// Borrowed<T> is not for storing: anything with a lifetime of its own wants
+// a RefPtr<T>.
+template <typename T>
+class Borrowed final {
+public:
+    constexpr Borrowed()
+        : ptr_(nullptr) {}
+    constexpr Borrowed(decltype(nullptr))
+        : Borrowed() {}
+    Borrowed(const RefPtr<T>& r)
+        : ptr_(r.get()) {}
+
+    // Borrow a RefPtr to a derived type without materializing (and
+    // refcounting) a temporary RefPtr<T>.
+    template <typename U,
+              typename = typename enable_if<is_convertible_pointer<U*, T*>::value>::type>
+    Borrowed(const RefPtr<U>& r)
+        : ptr_(r.get()) {}
+    explicit Borrowed(T* ptr)
+        : ptr_(ptr) {}
+
+    // Implicit upcast, mirroring RefPtr<U> -> RefPtr<T>.
+    template <typename U,
+              typename = typename enable_if<is_convertible_pointer<U*, T*>::value>::type>
+    Borrowed(Borrowed<U> r)
+        : ptr_(r.get()) {}
+
+    T* get() const {
+        return ptr_;
+    }
+    T& operator*() const {
+        return *ptr_;
+    }
+    T* operator->() const {
+        return ptr_;
+    }
+    explicit operator bool() const {
+        return !!ptr_;
+    }
+
+    bool operator==(const Borrowed<T>& other) const { return ptr_ == other.ptr_; }
+    bool operator!=(const Borrowed<T>& other) const { return ptr_ != other.ptr_; }
+
+    // Take an owning reference, for the rare callee that must keep the
+    // object alive beyond the borrow.
+    RefPtr<T> CopyRef() const {
+        return RefPtr<T>(ptr_);
+    }
+
+private:
+    T* ptr_;
+};
+
+template <typename T>
+inline Borrowed<T> Borrow(const RefPtr<T>& ptr) {
+    return Borrowed<T>(ptr);
+}
+
+} // namespace mxtl
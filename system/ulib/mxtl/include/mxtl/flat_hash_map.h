@@ -0,0 +1,419 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/assert.h>
+#include <mxtl/algorithm.h>
+#include <mxtl/allocator_traits.h>
+#include <mxtl/macros.h>
+#include <mxtl/type_support.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace mxtl {
+
+// DefaultFlatHashTraits provides the hash and equality operations used by
+// FlatHashMap. The default implementation handles integral key types by
+// running them through a 64-bit finalizer (the one from splitmix64) so
+// that every input bit influences the low bits used for bucket selection.
+//
+// Users with other key types must supply their own traits, implementing:
+//
+// GetHash : A static method taking a constant reference to a key and
+//           returning its hash as a size_t. Equal keys must hash equally.
+// Equals  : A static method taking constant references to two keys and
+//           returning true when they are equal.
+template <typename KeyType>
+struct DefaultFlatHashTraits {
+    static size_t GetHash(const KeyType& key) {
+        static_assert(is_integral<KeyType>::value,
+                      "DefaultFlatHashTraits requires an integral key type");
+        uint64_t h = static_cast<uint64_t>(key);
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9u;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebu;
+        h ^= h >> 31;
+        return static_cast<size_t>(h);
+    }
+
+    static bool Equals(const KeyType& key1, const KeyType& key2) {
+        return key1 == key2;
+    }
+};
+
+// FlatHashMap<> is a non-intrusive hash map which stores its entries
+// directly in a single flat bucket array, using open addressing with
+// Robin Hood displacement and backward-shift deletion. Unlike
+// HashTable<>, a lookup walks contiguous buckets instead of chasing
+// list nodes, so collision handling stays within a few cache lines.
+//
+// Notably, FlatHashMap<> returns information about allocation failures
+// rather than throwing exceptions, and entries are moved (never copied)
+// so both keys and values may be move-only types.
+//
+// The bucket array is kept a power of two in size at a maximum load
+// factor of 3/4. insert() and erase() may move entries between buckets;
+// they invalidate all iterators and any pointer previously returned by
+// find().
+template <typename _KeyType, typename _ValueType,
+          typename HashTraits = DefaultFlatHashTraits<_KeyType>,
+          typename AllocatorTraits = DefaultAllocatorTraits>
+class FlatHashMap {
+private:
+    // Forward declaration of the bucket type, needed by the iterator.
+    struct Bucket;
+
+public:
+    using KeyType = _KeyType;
+    using ValueType = _ValueType;
+
+    // The portion of a bucket which iterators expose to users.
+    struct Entry {
+        KeyType key;
+        ValueType value;
+    };
+
+    // move semantics only
+    DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(FlatHashMap);
+
+    constexpr FlatHashMap() : buckets_(nullptr), bucket_count_(0U), size_(0U) {}
+
+    FlatHashMap(FlatHashMap&& other)
+        : buckets_(other.buckets_),
+          bucket_count_(other.bucket_count_),
+          size_(other.size_) {
+        other.buckets_ = nullptr;
+        other.bucket_count_ = 0U;
+        other.size_ = 0U;
+    }
+
+    FlatHashMap& operator=(FlatHashMap&& other) {
+        clear();
+        buckets_ = other.buckets_;
+        bucket_count_ = other.bucket_count_;
+        size_ = other.size_;
+        other.buckets_ = nullptr;
+        other.bucket_count_ = 0U;
+        other.size_ = 0U;
+        return *this;
+    }
+
+    ~FlatHashMap() {
+        clear();
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool is_empty() const {
+        return size_ == 0;
+    }
+
+    // Insert a mapping from |key| to |value|, replacing the value of any
+    // existing entry for |key|.
+    // Returns true on success, false on allocation failure (in which
+    // case the map is unchanged).
+    bool insert(KeyType key, ValueType value) __WARN_UNUSED_RESULT {
+        size_t hash = HashOf(key);
+        size_t ndx = FindIndex(hash, key);
+        if (ndx != bucket_count_) {
+            buckets_[ndx].value = mxtl::move(value);
+            return true;
+        }
+        if (!GrowIfNeeded()) {
+            return false;
+        }
+        Place(hash, mxtl::move(key), mxtl::move(value));
+        ++size_;
+        return true;
+    }
+
+    // Return a pointer to the value stored for |key|, or nullptr if the
+    // map holds no entry for |key|. The pointer is valid only until the
+    // next insert() or erase().
+    ValueType* find(const KeyType& key) {
+        size_t ndx = FindIndex(HashOf(key), key);
+        return (ndx == bucket_count_) ? nullptr : &buckets_[ndx].value;
+    }
+
+    const ValueType* find(const KeyType& key) const {
+        size_t ndx = FindIndex(HashOf(key), key);
+        return (ndx == bucket_count_) ? nullptr : &buckets_[ndx].value;
+    }
+
+    // Remove the entry for |key|, if any.
+    // Returns true if an entry was removed.
+    bool erase(const KeyType& key) {
+        size_t ndx = FindIndex(HashOf(key), key);
+        if (ndx == bucket_count_) {
+            return false;
+        }
+        // Shift the displaced cluster which follows back toward its home
+        // buckets so probe distances stay minimal.
+        size_t mask = bucket_count_ - 1;
+        size_t next = (ndx + 1) & mask;
+        while ((buckets_[next].hash != 0) &&
+               (ProbeDistance(buckets_[next].hash, next) != 0)) {
+            buckets_[ndx].hash = buckets_[next].hash;
+            buckets_[ndx].key = mxtl::move(buckets_[next].key);
+            buckets_[ndx].value = mxtl::move(buckets_[next].value);
+            ndx = next;
+            next = (next + 1) & mask;
+        }
+        EmptyBucket(buckets_[ndx]);
+        --size_;
+        return true;
+    }
+
+    // Grow the bucket array until |count| entries fit without rehashing.
+    // Returns true on success, false on allocation failure.
+    bool reserve(size_t count) __WARN_UNUSED_RESULT {
+        size_t needed = kBucketCountMinimum;
+        while ((count * kLoadFactorDenominator) >
+               (needed * kLoadFactorNumerator)) {
+            needed *= kBucketCountGrowthFactor;
+        }
+        if (needed <= bucket_count_) {
+            return true;
+        }
+        return Rehash(needed);
+    }
+
+    // Discard all entries and return the bucket array to the allocator.
+    void clear() {
+        for (size_t i = 0; i < bucket_count_; ++i) {
+            if (buckets_[i].hash != 0) {
+                buckets_[i].key.~KeyType();
+                buckets_[i].value.~ValueType();
+            }
+        }
+        AllocatorTraits::Deallocate(buckets_);
+        buckets_ = nullptr;
+        bucket_count_ = 0U;
+        size_ = 0U;
+    }
+
+    // Iterators walk the occupied buckets in an unspecified order; they
+    // are invalidated by insert() and erase().
+    template <bool IsConst>
+    class iterator_impl {
+    private:
+        using MapPtrType = typename conditional<IsConst,
+                                                const FlatHashMap*,
+                                                FlatHashMap*>::type;
+        using EntryType = typename conditional<IsConst,
+                                               const Entry,
+                                               Entry>::type;
+
+    public:
+        iterator_impl() : map_(nullptr), ndx_(0U) {}
+        iterator_impl(const iterator_impl& other) = default;
+        iterator_impl& operator=(const iterator_impl& other) = default;
+
+        bool IsValid() const {
+            return (map_ != nullptr) && (ndx_ < map_->bucket_count_);
+        }
+
+        bool operator==(const iterator_impl& other) const {
+            return (map_ == other.map_) && (ndx_ == other.ndx_);
+        }
+        bool operator!=(const iterator_impl& other) const {
+            return !(*this == other);
+        }
+
+        // Prefix
+        iterator_impl& operator++() {
+            if (IsValid()) {
+                ++ndx_;
+                AdvanceToOccupied();
+            }
+            return *this;
+        }
+
+        // Postfix
+        iterator_impl operator++(int) {
+            iterator_impl ret(*this);
+            ++(*this);
+            return ret;
+        }
+
+        EntryType& operator*() const {
+            MX_DEBUG_ASSERT(IsValid());
+            return map_->buckets_[ndx_];
+        }
+
+        EntryType* operator->() const {
+            MX_DEBUG_ASSERT(IsValid());
+            return &map_->buckets_[ndx_];
+        }
+
+    private:
+        friend class FlatHashMap;
+
+        iterator_impl(MapPtrType map, size_t ndx) : map_(map), ndx_(ndx) {
+            AdvanceToOccupied();
+        }
+
+        void AdvanceToOccupied() {
+            while ((ndx_ < map_->bucket_count_) &&
+                   (map_->buckets_[ndx_].hash == 0)) {
+                ++ndx_;
+            }
+        }
+
+        MapPtrType map_;
+        size_t ndx_;
+    };
+
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    iterator begin() { return iterator(this, 0U); }
+    iterator end() { return iterator(this, bucket_count_); }
+    const_iterator begin() const { return const_iterator(this, 0U); }
+    const_iterator end() const { return const_iterator(this, bucket_count_); }
+
+private:
+    // A bucket holds an entry plus the cached hash of its key. A hash of
+    // zero marks an empty bucket; HashOf never returns zero.
+    struct Bucket : public Entry {
+        size_t hash;
+    };
+
+    static size_t HashOf(const KeyType& key) {
+        size_t hash = HashTraits::GetHash(key);
+        return (hash == 0) ? 1U : hash;
+    }
+
+    // Distance from the bucket at |ndx| back to the home bucket of an
+    // entry whose key hashed to |hash|.
+    size_t ProbeDistance(size_t hash, size_t ndx) const {
+        return (ndx - hash) & (bucket_count_ - 1);
+    }
+
+    // Find the bucket index holding |key|, or bucket_count_ if the map
+    // holds no entry for |key|.
+    size_t FindIndex(size_t hash, const KeyType& key) const {
+        if (bucket_count_ == 0) {
+            return bucket_count_;
+        }
+        size_t mask = bucket_count_ - 1;
+        size_t ndx = hash & mask;
+        size_t dist = 0;
+        while (true) {
+            const Bucket& bucket = buckets_[ndx];
+            if (bucket.hash == 0) {
+                return bucket_count_;
+            }
+            // The Robin Hood invariant: if this bucket's entry sits
+            // closer to its home than we are to ours, |key| would have
+            // displaced it during insertion. It cannot be further on.
+            if (ProbeDistance(bucket.hash, ndx) < dist) {
+                return bucket_count_;
+            }
+            if ((bucket.hash == hash) && HashTraits::Equals(bucket.key, key)) {
+                return ndx;
+            }
+            ndx = (ndx + 1) & mask;
+            ++dist;
+        }
+    }
+
+    // Robin Hood insertion into the current bucket array. The caller has
+    // already ensured that a free bucket exists and that |key| is not
+    // present.
+    void Place(size_t hash, KeyType key, ValueType value) {
+        size_t mask = bucket_count_ - 1;
+        size_t ndx = hash & mask;
+        size_t dist = 0;
+        while (true) {
+            Bucket& bucket = buckets_[ndx];
+            if (bucket.hash == 0) {
+                bucket.hash = hash;
+                bucket.key = mxtl::move(key);
+                bucket.value = mxtl::move(value);
+                return;
+            }
+            // Take from the rich: displace any entry which sits closer
+            // to its home bucket than we do to ours, then carry it
+            // forward instead.
+            size_t bucket_dist = ProbeDistance(bucket.hash, ndx);
+            if (bucket_dist < dist) {
+                size_t tmp_hash = bucket.hash;
+                bucket.hash = hash;
+                hash = tmp_hash;
+
+                KeyType tmp_key(mxtl::move(bucket.key));
+                bucket.key = mxtl::move(key);
+                key = mxtl::move(tmp_key);
+
+                ValueType tmp_value(mxtl::move(bucket.value));
+                bucket.value = mxtl::move(value);
+                value = mxtl::move(tmp_value);
+
+                dist = bucket_dist;
+            }
+            ndx = (ndx + 1) & mask;
+            ++dist;
+        }
+    }
+
+    bool GrowIfNeeded() {
+        if (((size_ + 1) * kLoadFactorDenominator) <=
+            (bucket_count_ * kLoadFactorNumerator)) {
+            return true;
+        }
+        return Rehash((bucket_count_ == 0)
+                      ? kBucketCountMinimum
+                      : bucket_count_ * kBucketCountGrowthFactor);
+    }
+
+    // Replace the bucket array with one of newBucketCount buckets and
+    // re-place every entry. Returns true on success; on allocation
+    // failure the map is unchanged.
+    bool Rehash(size_t newBucketCount) {
+        MX_DEBUG_ASSERT(is_pow2(newBucketCount));
+        Bucket* oldBuckets = buckets_;
+        size_t oldBucketCount = bucket_count_;
+        buckets_ = reinterpret_cast<Bucket*>(
+                AllocatorTraits::Allocate(newBucketCount * sizeof(Bucket)));
+        if (buckets_ == nullptr) {
+            buckets_ = oldBuckets;
+            return false;
+        }
+        bucket_count_ = newBucketCount;
+        for (size_t i = 0; i < oldBucketCount; ++i) {
+            if (oldBuckets[i].hash != 0) {
+                Place(oldBuckets[i].hash,
+                      mxtl::move(oldBuckets[i].key),
+                      mxtl::move(oldBuckets[i].value));
+            }
+        }
+        AllocatorTraits::Deallocate(oldBuckets);
+        return true;
+    }
+
+    // Destroy a bucket's entry and return its bytes to the zeroed state
+    // which future assignments expect.
+    static void EmptyBucket(Bucket& bucket) {
+        bucket.key.~KeyType();
+        bucket.value.~ValueType();
+        memset(static_cast<void*>(&bucket), 0, sizeof(Bucket));
+    }
+
+    Bucket* buckets_;
+    size_t bucket_count_;
+    size_t size_;
+
+    static constexpr size_t kBucketCountMinimum = 16;
+    static constexpr size_t kBucketCountGrowthFactor = 2;
+    // Maximum load factor of 3/4 keeps probe sequences short.
+    static constexpr size_t kLoadFactorNumerator = 3;
+    static constexpr size_t kLoadFactorDenominator = 4;
+};
+
+}  // namespace mxtl
@@ -9,6 +9,7 @@
 #include <mxtl/intrusive_pointer_traits.h>
 #include <mxtl/intrusive_wavl_tree_internal.h>
 #include <mxtl/macros.h>
+#include <mxtl/type_support.h>
 
 // Implementation Notes:
 //
@@ -38,6 +39,11 @@
 // upper_bound(key) : Finds the element (E) in the tree such that E.key > key
 // lower_bound(key) : Finds the element (E) in the tree such that E.key >= key
 //
+// Finally, trees whose node state tracks subtree sizes (see
+// WAVLTreeSizedNodeState) support two O(log n) order-statistic operations:
+// select(ndx) : Finds the ndx'th smallest element in the tree.
+// rank(key)   : Counts the elements whose keys are strictly less than key.
+//
 // The worst depth of a WAVL tree depends on whether or not the tree has ever
 // been subject to erase operations.
 // ++ If the tree has seen only insert operations, the worst case depth of the
@@ -99,6 +105,54 @@ private:
     WAVLTreeNodeState<PtrType, bool> wavl_node_state_;
 };
 
+// A node state which additionally tracks the size of the subtree rooted at its
+// node.  Using it (either via WAVLTreeSizedContainable, or via custom
+// NodeTraits whose node_state returns one) enables the tree's O(log n)
+// order-statistic operations, select() and rank(), at the cost of one extra
+// word per node and a constant amount of extra bookkeeping per mutation.
+//
+// Note: unlike WAVLTreeNodeState<>, this is not a standard layout type.
+template <typename PtrType, typename RankType = bool>
+struct WAVLTreeSizedNodeState : public WAVLTreeNodeState<PtrType, RankType> {
+    // The number of nodes in the subtree rooted at this node, including the
+    // node itself.  Only meaningful while the node is in a tree.
+    size_t subtree_size_ = 0;
+};
+
+template <typename PtrType>
+struct DefaultWAVLTreeSizedTraits {
+    using PtrTraits = internal::ContainerPtrTraits<PtrType>;
+    static WAVLTreeSizedNodeState<PtrType>& node_state(typename PtrTraits::RefType obj) {
+        return obj.wavl_sized_node_state_;
+    }
+};
+
+template <typename PtrType>
+struct WAVLTreeSizedContainable {
+public:
+    bool InContainer() const { return wavl_sized_node_state_.InContainer(); }
+
+private:
+    friend DefaultWAVLTreeSizedTraits<PtrType>;
+    WAVLTreeSizedNodeState<PtrType> wavl_sized_node_state_;
+};
+
+namespace internal {
+
+// Detects whether a WAVLTree's node state type carries the subtree_size_
+// bookkeeping needed for the order-statistic operations.
+template <typename NodeStateType>
+struct has_subtree_size {
+private:
+    template <typename C> static true_type  test(decltype(&C::subtree_size_));
+    template <typename C> static false_type test(...);
+
+public:
+    static constexpr bool value = decltype(test<NodeStateType>(nullptr))::value;
+};
+
+}  // namespace internal
+
 template <typename _KeyType,
           typename _PtrType,
           typename _KeyTraits  = DefaultKeyedObjectTraits<
@@ -125,6 +179,9 @@ public:
     using ValueType     = typename PtrTraits::ValueType;
     using ContainerType = WAVLTree<KeyType, PtrType, KeyTraits, NodeTraits, Observer>;
     using CheckerType   = ::mxtl::tests::intrusive_containers::WAVLTreeChecker;
+    using NodeStateType = typename remove_reference<
+                            decltype(NodeTraits::node_state(
+                                *static_cast<RawPtrType>(nullptr)))>::type;
 
     // Declarations of the standard iterator types.
     using iterator       = iterator_impl<iterator_traits>;
@@ -141,6 +198,11 @@ public:
     static constexpr bool IsAssociative = true;
     static constexpr bool IsSequenced = false;
 
+    // Order statistics (select/rank) are available iff the tree's node state
+    // tracks subtree sizes.  See WAVLTreeSizedNodeState.
+    static constexpr bool SupportsOrderStatistics =
+        internal::has_subtree_size<NodeStateType>::value;
+
     // Default construction gives an empty tree.
     constexpr WAVLTree() { }
 
@@ -306,6 +368,69 @@ public:
         return iterator(citer.node_);
     }
 
+    // select (order statistic)
+    //
+    // Find the ndx'th smallest element in the tree (0-based) and return an
+    // iterator to it.  Returns end() if ndx >= size().  Runs in O(log n), but
+    // is only available when the tree's node state tracks subtree sizes (see
+    // WAVLTreeSizedNodeState).
+    const_iterator select(size_t ndx) const {
+        static_assert(SupportsOrderStatistics,
+                      "select() requires a node state which tracks subtree "
+                      "sizes.  See WAVLTreeSizedNodeState<>.");
+        if (ndx >= count_)
+            return end();
+
+        RawPtrType node = PtrTraits::GetRaw(root_);
+        while (true) {
+            MX_DEBUG_ASSERT(PtrTraits::IsValid(node));
+
+            auto& ns = NodeTraits::node_state(*node);
+            size_t left_size = SubtreeSize(PtrTraits::GetRaw(ns.left_));
+
+            if (ndx < left_size) {
+                node = PtrTraits::GetRaw(ns.left_);
+            } else if (ndx == left_size) {
+                return const_iterator(node);
+            } else {
+                ndx -= left_size + 1;
+                node = PtrTraits::GetRaw(ns.right_);
+            }
+        }
+    }
+
+    iterator select(size_t ndx) {
+        const_iterator citer = const_cast<const ContainerType*>(this)->select(ndx);
+        return iterator(citer.node_);
+    }
+
+    // rank (order statistic)
+    //
+    // Return the number of elements in the tree whose keys are strictly less
+    // than the caller provided key; equivalently, the ndx which select() would
+    // need to find the first element which is not less than the key.  Runs in
+    // O(log n), with the same node state requirement as select().
+    size_t rank(const KeyType& key) const {
+        static_assert(SupportsOrderStatistics,
+                      "rank() requires a node state which tracks subtree "
+                      "sizes.  See WAVLTreeSizedNodeState<>.");
+        size_t before = 0;
+        RawPtrType node = PtrTraits::GetRaw(root_);
+
+        while (PtrTraits::IsValid(node)) {
+            auto& ns = NodeTraits::node_state(*node);
+
+            if (KeyTraits::LessThan(KeyTraits::GetKey(*node), key)) {
+                before += SubtreeSize(PtrTraits::GetRaw(ns.left_)) + 1;
+                node = PtrTraits::GetRaw(ns.right_);
+            } else {
+                node = PtrTraits::GetRaw(ns.left_);
+            }
+        }
+
+        return before;
+    }
+
     // erase
     //
     // Remove the first element in the tree whose key matches "key" and return a
@@ -649,8 +774,10 @@ private:
         auto& ns = NodeTraits::node_state(*ptr);
         MX_DEBUG_ASSERT(ns.IsValid() && !ns.InContainer());
 
-        // The rank of an inserted node always starts at 0.
+        // The rank of an inserted node always starts at 0, and a freshly
+        // inserted node is a leaf, so its subtree contains only itself.
         ns.rank_ = 0;
+        SetSubtreeSize(ns, 1, 0);
 
         // If the tree is currently empty, then this is easy.
         if (root_ == nullptr) {
@@ -740,6 +867,7 @@ private:
         *owner = mxtl::move(ptr);
 
         ++count_;
+        AdjustSubtreeSizes(parent, 1);
         Observer::RecordInsert();
 
         // Finally, perform post-insert balance operations.
@@ -878,8 +1006,12 @@ private:
         // indicate that it is not in the container.
         MX_DEBUG_ASSERT(ns.IsValid() && !ns.InContainer());
 
-        // Update the count bookkeeping.
+        // Update the count bookkeeping.  Every ancestor of the point of
+        // removal just lost one descendant.  (Note: this must happen before
+        // the rebalance rotations below, which recompute subtree sizes from
+        // their children.)
         --count_;
+        AdjustSubtreeSizes(PtrTraits::IsSentinel(parent) ? nullptr : parent, ~size_t(0));
         Observer::RecordErase();
 
         // Time to rebalance.  We know that we don't need to rebalance if we
@@ -955,6 +1087,65 @@ private:
         second = tmp;
     }
 
+    // Subtree size bookkeeping used by the order-statistic operations.
+    //
+    // The (..., int) overloads win overload resolution whenever the node
+    // state type has a subtree_size_ member; otherwise the variadic versions
+    // get selected and the bookkeeping compiles away entirely.
+    template <typename NS>
+    static auto GetSubtreeSize(const NS& ns, int) -> decltype(ns.subtree_size_) {
+        return ns.subtree_size_;
+    }
+    template <typename NS>
+    static size_t GetSubtreeSize(const NS&, ...) { return 0; }
+
+    template <typename NS>
+    static auto SetSubtreeSize(NS& ns, size_t size, int)
+        -> decltype(void(ns.subtree_size_)) {
+        ns.subtree_size_ = size;
+    }
+    template <typename NS>
+    static void SetSubtreeSize(NS&, size_t, ...) { }
+
+    template <typename NS>
+    static auto SwapSubtreeSizes(NS& ns1, NS& ns2, int)
+        -> decltype(void(ns1.subtree_size_)) {
+        pod_swap(ns1.subtree_size_, ns2.subtree_size_);
+    }
+    template <typename NS>
+    static void SwapSubtreeSizes(NS&, NS&, ...) { }
+
+    static size_t SubtreeSize(RawPtrType node) {
+        return PtrTraits::IsValid(node)
+             ? GetSubtreeSize(NodeTraits::node_state(*node), 0)
+             : 0;
+    }
+
+    // Recompute a node's subtree size from its children, after a rotation has
+    // changed what hangs below it.
+    static void RecomputeSubtreeSize(RawPtrType node) {
+        if (!SupportsOrderStatistics)
+            return;
+
+        auto& ns = NodeTraits::node_state(*node);
+        SetSubtreeSize(ns, 1 + SubtreeSize(PtrTraits::GetRaw(ns.left_))
+                             + SubtreeSize(PtrTraits::GetRaw(ns.right_)), 0);
+    }
+
+    // Walk from node up to the root, adding delta to every subtree size along
+    // the way.  Called when a descendant of node has been added (delta == 1)
+    // or removed (delta == ~0; sizes rely on unsigned wraparound).
+    static void AdjustSubtreeSizes(RawPtrType node, size_t delta) {
+        if (!SupportsOrderStatistics)
+            return;
+
+        while (PtrTraits::IsValid(node)) {
+            auto& ns = NodeTraits::node_state(*node);
+            SetSubtreeSize(ns, GetSubtreeSize(ns, 0) + delta, 0);
+            node = ns.parent_;
+        }
+    }
+
     // Swaps the positions of two nodes, one of which is guaranteed to be a
     // right-hand descendant of the other.
     //
@@ -1002,6 +1193,10 @@ private:
         PtrTraits::Swap(ns1.right_, ns2.right_);
         pod_swap(ns1.rank_, ns2.rank_);
 
+        // Subtree sizes, like ranks, are positional; they travel with the
+        // children the nodes just exchanged.
+        SwapSubtreeSizes(ns1, ns2, 0);
+
         // At this point, there are two scenarios.
         //
         // Case #1
@@ -1260,6 +1455,11 @@ private:
         Z_ns.parent_ = X;
         if (Y)
             NodeTraits::node_state(*Y).parent_ = Z;
+
+        // The rotation moved Y out from under X and moved Z underneath it.
+        // Rebuild the two affected subtree sizes from the bottom up.
+        RecomputeSubtreeSize(Z);
+        RecomputeSubtreeSize(X);
     }
 
     // PostInsertFixupLR<LRTraits>
@@ -1695,5 +1895,7 @@ template <typename KeyType, typename PtrType, typename KeyTraits, typename NodeT
 constexpr bool WAVLTree<KeyType, PtrType, KeyTraits, NodeTraits, Obs>::IsAssociative;
 template <typename KeyType, typename PtrType, typename KeyTraits, typename NodeTraits, typename Obs>
 constexpr bool WAVLTree<KeyType, PtrType, KeyTraits, NodeTraits, Obs>::IsSequenced;
+template <typename KeyType, typename PtrType, typename KeyTraits, typename NodeTraits, typename Obs>
+constexpr bool WAVLTree<KeyType, PtrType, KeyTraits, NodeTraits, Obs>::SupportsOrderStatistics;
 
 }  // namespace mxtl
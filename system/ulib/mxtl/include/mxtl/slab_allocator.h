@@ -99,6 +99,46 @@ void* operator new(size_t sz, void *ptr);
 //
 // mxtl::SlabAllocator<UnlockedStaticSlabAllocator<mxtl::unique_ptr<MyObject>> allocator;
 //
+// :: Cache Layer (CacheTraits) ::
+//
+// By default, every Allocate/Free operation takes the allocator's lock.  For
+// allocators which see concurrent traffic from many threads or cpus, the
+// CacheTraits parameter of SlabAllocatorTraits<> may be used to interpose a
+// set of independently locked free-list caches in front of the core
+// allocator.  Allocations are served from the caller's current cache whenever
+// possible; a cache miss refills the cache with a batch of objects from the
+// core allocator, and a cache which grows past two batches returns a batch to
+// the core.  With an appropriate notion of "current cache" (such as the
+// caller's cpu number), concurrent callers almost never touch the same lock.
+//
+// A CacheTraits policy must supply...
+// ++ NUM_CACHES  : the number of caches (0 selects no cache layer at all).
+// ++ BATCH_SIZE  : the number of objects moved between a cache and the core
+//                  allocator at a time.
+// ++ CurrentCache() : a static method returning the index (< NUM_CACHES) of
+//                  the cache the calling thread should use.  This is purely a
+//                  contention-avoidance hint; correctness does not depend on
+//                  the caller staying associated with the returned cache.
+//
+// Note that up to (2 * BATCH_SIZE - 1) objects may be parked in each cache at
+// any given time; allocators with small slab quotas or large objects should
+// size BATCH_SIZE (and their quotas) accordingly.
+//
+// ** Example **
+//
+// struct PerCpuCache {
+//     static constexpr size_t NUM_CACHES = SMP_MAX_CPUS;
+//     static constexpr size_t BATCH_SIZE = 16;
+//     static size_t CurrentCache() { return arch_curr_cpu_num(); }
+// };
+//
+// using MyAllocatorTraits =
+//     mxtl::SlabAllocatorTraits<MyObject*,
+//                               mxtl::DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
+//                               mxtl::Mutex,
+//                               mxtl::SlabAllocatorFlavor::INSTANCED,
+//                               PerCpuCache>;
+//
 // :: Object Requirements ::
 //
 // Objects must be small enough that at least 1 can be allocated from a slab
@@ -287,12 +327,22 @@ enum class SlabAllocatorFlavor {
 template <typename T,
           size_t   SLAB_SIZE,
           typename LockType,
-          SlabAllocatorFlavor AllocatorFlavor> struct SlabAllocatorTraits;
+          SlabAllocatorFlavor AllocatorFlavor,
+          typename CacheTraits> struct SlabAllocatorTraits;
 template <typename SATraits, typename = void> class SlabAllocator;
 template <typename SATraits, typename = void> class SlabAllocated;
 
 constexpr size_t DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE = (16 << 10u);
 
+// Default cache policy: no cache layer.  Every Allocate/Free takes the
+// allocator's lock.  See the CacheTraits section of the usage notes for the
+// requirements a custom policy must meet.
+struct NullSlabCache {
+    static constexpr size_t NUM_CACHES = 0;
+    static constexpr size_t BATCH_SIZE = 1;
+    static size_t CurrentCache() { return 0; }
+};
+
 namespace internal {
 
 // internal fwd-decls
@@ -352,12 +402,16 @@ struct SlabOriginSetter<SATraits,
                                  internal::SlabAllocator<SATraits>* origin) { }
 };
 
+// The type used to track unused blocks of object memory, both on the core
+// allocator's free list and in the cache layer (if any).
+struct SlabFreeListEntry : public SinglyLinkedListable<SlabFreeListEntry*> { };
+
 // Non-templated SlabAllocatorBase.  Any code which does not strictly depend on
 // trait/type awareness lives here in order to minimize code size explosion due
 // to template expansion.
 class SlabAllocatorBase {
 protected:
-    struct FreeListEntry : public SinglyLinkedListable<FreeListEntry*> { };
+    using FreeListEntry = SlabFreeListEntry;
 
     struct Slab {
         explicit Slab(size_t initial_bytes_used) : bytes_used_(initial_bytes_used) { }
@@ -488,8 +542,106 @@ private:
     size_t                           slab_count_ = 0;
 };
 
+// The cache layer which sits in front of the core allocator.  The default
+// (NUM_CACHES == 0) version is stateless and all of its operations collapse
+// to nothing, leaving the allocator's behavior unchanged.
+template <typename SATraits, typename = void>
+class SlabAllocatorCache {
+protected:
+    static constexpr size_t CacheBatchSize = 1;
+
+    void* CacheTake() { return nullptr; }
+    bool  CachePut(SlabFreeListEntry*, SinglyLinkedList<SlabFreeListEntry*>*) { return false; }
+
+    void CacheFill(SinglyLinkedList<SlabFreeListEntry*>* entries) {
+        MX_DEBUG_ASSERT(entries->is_empty());
+    }
+
+    void CacheDrain(SinglyLinkedList<SlabFreeListEntry*>*) { }
+};
+
+// The active version of the cache layer.  Each of the NUM_CACHES caches is an
+// independently locked free list; the cache used for an operation is chosen
+// by the CacheTraits policy.  Caches exchange whole batches of objects with
+// the core allocator, and the core allocator's lock is never held at the same
+// time as a cache lock.
+template <typename SATraits>
+class SlabAllocatorCache<SATraits,
+                         typename enable_if<(SATraits::CacheTraits::NUM_CACHES > 0)>::type> {
+protected:
+    using CacheTraits = typename SATraits::CacheTraits;
+    static constexpr size_t CacheBatchSize = CacheTraits::BATCH_SIZE;
+    static_assert(CacheBatchSize > 0, "Slab cache batch size may not be zero");
+
+    void* CacheTake() {
+        Cache& cache = current_cache();
+        AutoLock cache_lock(&cache.lock);
+
+        if (cache.free_list.is_empty())
+            return nullptr;
+
+        --cache.depth;
+        return cache.free_list.pop_front();
+    }
+
+    bool CachePut(SlabFreeListEntry* entry, SinglyLinkedList<SlabFreeListEntry*>* overflow) {
+        Cache& cache = current_cache();
+        AutoLock cache_lock(&cache.lock);
+
+        cache.free_list.push_front(entry);
+        if (++cache.depth < (2 * CacheBatchSize))
+            return true;
+
+        // The cache has grown to two full batches; hand one batch back to the
+        // caller to be returned to the core allocator.
+        for (size_t i = 0; i < CacheBatchSize; ++i) {
+            overflow->push_front(cache.free_list.pop_front());
+            --cache.depth;
+        }
+        return true;
+    }
+
+    void CacheFill(SinglyLinkedList<SlabFreeListEntry*>* entries) {
+        if (entries->is_empty())
+            return;
+
+        Cache& cache = current_cache();
+        AutoLock cache_lock(&cache.lock);
+        while (!entries->is_empty()) {
+            cache.free_list.push_front(entries->pop_front());
+            ++cache.depth;
+        }
+    }
+
+    void CacheDrain(SinglyLinkedList<SlabFreeListEntry*>* out) {
+        for (size_t i = 0; i < CacheTraits::NUM_CACHES; ++i) {
+            AutoLock cache_lock(&caches_[i].lock);
+            while (!caches_[i].free_list.is_empty()) {
+                out->push_front(caches_[i].free_list.pop_front());
+                --caches_[i].depth;
+            }
+        }
+    }
+
+private:
+    struct Cache {
+        typename SATraits::LockType          lock;
+        SinglyLinkedList<SlabFreeListEntry*> free_list;
+        size_t                               depth = 0;
+    };
+
+    Cache& current_cache() {
+        size_t id = CacheTraits::CurrentCache();
+        MX_DEBUG_ASSERT(id < CacheTraits::NUM_CACHES);
+        return caches_[id];
+    }
+
+    Cache caches_[CacheTraits::NUM_CACHES];
+};
+
 template <typename SATraits>
-class SlabAllocator : public SlabAllocatorBase {
+class SlabAllocator : public SlabAllocatorBase,
+                      protected SlabAllocatorCache<SATraits> {
 public:
     using PtrTraits = typename SATraits::PtrTraits;
     using PtrType   = typename SATraits::PtrType;
@@ -533,7 +685,17 @@ public:
                             max_slabs,
                             alloc_initial) { }
 
-    ~SlabAllocator() { }
+    ~SlabAllocator() {
+        // Return any objects still parked in the cache layer to the core free
+        // list so that the base class's leak accounting stays balanced.
+        SinglyLinkedList<SlabFreeListEntry*> drained;
+        CacheLayer::CacheDrain(&drained);
+        if (!drained.is_empty()) {
+            AutoLock alloc_lock(&this->alloc_lock_);
+            while (!drained.is_empty())
+                ReturnToFreeListLocked(drained.pop_front());
+        }
+    }
 
     template <typename... ConstructorSignature>
     PtrType New(ConstructorSignature&&... args) {
@@ -567,14 +729,44 @@ protected:
     friend class ::mxtl::SlabAllocator<SATraits>;
     friend class ::mxtl::SlabAllocated<SATraits>;
 
+    using CacheLayer = SlabAllocatorCache<SATraits>;
+
     void* Allocate() {
-        AutoLock alloc_lock(&this->alloc_lock_);
-        return AllocateLocked();
+        void* mem = CacheLayer::CacheTake();
+        if (mem != nullptr)
+            return mem;
+
+        // Cache miss (or no cache layer at all); allocate from the core
+        // allocator.  While we hold its lock, pull a batch of extra objects
+        // to refill the cache with.
+        SinglyLinkedList<SlabFreeListEntry*> refill;
+        {
+            AutoLock alloc_lock(&this->alloc_lock_);
+            mem = AllocateLocked();
+            for (size_t i = 1; (mem != nullptr) && (i < CacheLayer::CacheBatchSize); ++i) {
+                void* extra = AllocateLocked();
+                if (extra == nullptr)
+                    break;
+                refill.push_front(new (extra) SlabFreeListEntry);
+            }
+        }
+        CacheLayer::CacheFill(&refill);
+
+        return mem;
     }
 
     void ReturnToFreeList(void* ptr) {
         FreeListEntry* free_obj = new (ptr) FreeListEntry;
-        {
+
+        SinglyLinkedList<SlabFreeListEntry*> overflow;
+        if (CacheLayer::CachePut(free_obj, &overflow)) {
+            if (overflow.is_empty())
+                return;
+
+            AutoLock alloc_lock(&alloc_lock_);
+            while (!overflow.is_empty())
+                ReturnToFreeListLocked(overflow.pop_front());
+        } else {
             AutoLock alloc_lock(&alloc_lock_);
             ReturnToFreeListLocked(free_obj);
         }
@@ -622,16 +814,23 @@ protected:
 //     the object to the allocator it came from.  MANUAL_DELETE allocators are
 //     only permitted for unmanaged pointer types.
 //
+// ++ CacheTraits
+//  The policy controlling the cache layer which sits in front of the core
+//  allocator.  Defaults to NullSlabCache (no cache layer).  See the Cache
+//  Layer section of the usage notes.
+//
 ////////////////////////////////////////////////////////////////////////////////
 template <typename T,
           size_t   _SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
           typename _LockType  = ::mxtl::Mutex,
-          SlabAllocatorFlavor _AllocatorFlavor = SlabAllocatorFlavor::INSTANCED>
+          SlabAllocatorFlavor _AllocatorFlavor = SlabAllocatorFlavor::INSTANCED,
+          typename _CacheTraits = NullSlabCache>
 struct SlabAllocatorTraits {
     using PtrTraits     = internal::SlabAllocatorPtrTraits<T>;
     using PtrType       = typename PtrTraits::PtrType;
     using ObjType       = typename PtrTraits::ObjType;
     using LockType      = _LockType;
+    using CacheTraits   = _CacheTraits;
 
     static constexpr size_t SLAB_SIZE = _SLAB_SIZE;
     static constexpr SlabAllocatorFlavor AllocatorFlavor = _AllocatorFlavor;
@@ -741,9 +940,10 @@ protected:
 // superfluous as the default is instanced)
 template <typename T,
           size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
-          typename LockType  = ::mxtl::Mutex>
+          typename LockType  = ::mxtl::Mutex,
+          typename CacheTraits = NullSlabCache>
 using InstancedSlabAllocatorTraits =
-    SlabAllocatorTraits<T, SLAB_SIZE, LockType, SlabAllocatorFlavor::INSTANCED>;
+    SlabAllocatorTraits<T, SLAB_SIZE, LockType, SlabAllocatorFlavor::INSTANCED, CacheTraits>;
 
 template <typename T,
           size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE>
@@ -758,9 +958,10 @@ using UnlockedSlabAllocatorTraits =
 // Shorthand for declaring the properties of a MANUAL_DELETE slab allocator.
 template <typename T,
           size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
-          typename LockType  = ::mxtl::Mutex>
+          typename LockType  = ::mxtl::Mutex,
+          typename CacheTraits = NullSlabCache>
 using ManualDeleteSlabAllocatorTraits =
-    SlabAllocatorTraits<T, SLAB_SIZE, LockType, SlabAllocatorFlavor::MANUAL_DELETE>;
+    SlabAllocatorTraits<T, SLAB_SIZE, LockType, SlabAllocatorFlavor::MANUAL_DELETE, CacheTraits>;
 
 template <typename T,
           size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE>
@@ -829,9 +1030,10 @@ public:
 // Shorthand for declaring the properties of a static allocator
 template <typename T,
           size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
-          typename LockType  = ::mxtl::Mutex>
+          typename LockType  = ::mxtl::Mutex,
+          typename CacheTraits = NullSlabCache>
 using StaticSlabAllocatorTraits =
-    SlabAllocatorTraits<T, SLAB_SIZE, LockType, SlabAllocatorFlavor::STATIC>;
+    SlabAllocatorTraits<T, SLAB_SIZE, LockType, SlabAllocatorFlavor::STATIC, CacheTraits>;
 
 template <typename T,
           size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE>
@@ -5,36 +5,33 @@
 #pragma once
 
 #include <magenta/assert.h>
-#include <mxalloc/new.h>
+#include <mxtl/allocator_traits.h>
 #include <mxtl/macros.h>
+#include <mxtl/type_support.h>
+#include <string.h>
 
 namespace mxtl {
 
-struct DefaultAllocatorTraits {
-    // Allocate receives a request for "size" contiguous bytes.
-    // size will always be greater than zero.
-    // The return value must be "nullptr" on error, or a non-null
-    // pointer on success. This same pointer may later be passed
-    // to deallocate when resizing.
-    static void* Allocate(size_t size) {
-        MX_DEBUG_ASSERT(size > 0);
-        AllocChecker ac;
-        void* object = new (&ac) char[size]();
-        return ac.check() ? object : nullptr;
-    }
-
-    // Deallocate receives a pointer to an object which is
-    // 1) Either a pointer provided by Allocate, or
-    // 2) nullptr.
-    // If the pointer is not null, deallocate must free
-    // the underlying memory used by the object.
-    static void Deallocate(void* object) {
-        if (object != nullptr) {
-            delete reinterpret_cast<char*>(object);
-        }
-    }
+namespace internal {
+
+// Storage for the first |InlineCount| elements of a Vector, kept inside
+// the Vector object itself so small vectors never touch the allocator.
+// The bytes start zeroed to match the state of a fresh allocation made
+// through DefaultAllocatorTraits.
+template <typename T, size_t InlineCount>
+struct VectorInlineStorage {
+    T* inline_storage() { return reinterpret_cast<T*>(storage_); }
+    alignas(T) char storage_[InlineCount * sizeof(T)] = {};
+};
+
+// With no inline elements, the storage collapses to an empty base class.
+template <typename T>
+struct VectorInlineStorage<T, 0> {
+    constexpr T* inline_storage() { return nullptr; }
 };
 
+}  // namespace internal
+
 // Vector<> is an implementation of a dynamic array, implementing
 // a limited set of functionality of std::vector.
 //
@@ -46,8 +43,15 @@ struct DefaultAllocatorTraits {
 // This Vector supports O(1) indexing and O(1) (amortized) insertion and
 // deletion at the end (due to possible reallocations during push_back
 // and pop_back).
-template <typename T, typename AllocatorTraits = DefaultAllocatorTraits>
-class Vector {
+//
+// If |InlineCount| is non-zero, the first |InlineCount| elements are
+// stored inside the Vector object itself and no allocation is made until
+// the vector outgrows them. Moving an inline vector moves its elements
+// one at a time rather than stealing a pointer, so callers which rely on
+// O(1) moves of large vectors should leave |InlineCount| at zero.
+template <typename T, typename AllocatorTraits = DefaultAllocatorTraits,
+          size_t InlineCount = 0>
+class Vector : private internal::VectorInlineStorage<T, InlineCount> {
 public:
     // move semantics only
     DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(Vector);
@@ -55,13 +59,32 @@ public:
     constexpr Vector() : ptr_(nullptr), size_(0U), capacity_(0U) {}
 
     Vector(Vector&& other) : ptr_(nullptr), size_(other.size_), capacity_(other.capacity_) {
-        ptr_ = other.release();
+        if (other.is_inline()) {
+            ptr_ = this->inline_storage();
+            for (size_t i = 0; i < size_; i++) {
+                ptr_[i] = mxtl::move(other.ptr_[i]);
+            }
+            other.reset();
+        } else {
+            ptr_ = other.release();
+        }
     }
 
     Vector& operator=(Vector&& o) {
-        auto size = o.size_;
-        auto capacity = o.capacity_;
-        reset(o.release(), size, capacity);
+        if (o.is_inline()) {
+            reset();
+            ptr_ = this->inline_storage();
+            size_ = o.size_;
+            capacity_ = InlineCount;
+            for (size_t i = 0; i < size_; i++) {
+                ptr_[i] = mxtl::move(o.ptr_[i]);
+            }
+            o.reset();
+        } else {
+            auto size = o.size_;
+            auto capacity = o.capacity_;
+            reset(o.release(), size, capacity);
+        }
         return *this;
     }
 
@@ -91,24 +114,39 @@ public:
     }
 
     void swap(Vector& other) {
-        T* t = ptr_;
-        ptr_ = other.ptr_;
-        other.ptr_ = t;
-        size_t size = size_;
-        size_t capacity = capacity_;
+        if (!is_inline() && !other.is_inline()) {
+            T* t = ptr_;
+            ptr_ = other.ptr_;
+            other.ptr_ = t;
+            size_t size = size_;
+            size_t capacity = capacity_;
 
-        size_ = other.size_;
-        capacity_ = other.capacity_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
 
-        other.size_ = size;
-        other.capacity_ = capacity;
+            other.size_ = size;
+            other.capacity_ = capacity;
+            return;
+        }
+        // At least one side lives in its inline storage, which cannot
+        // change hands; swap element by element through a temporary.
+        Vector temp = mxtl::move(other);
+        other = mxtl::move(*this);
+        *this = mxtl::move(temp);
     }
 
     bool push_back(T&& value) __WARN_UNUSED_RESULT {
         MX_DEBUG_ASSERT(size_ <= capacity_);
         if (size_ == capacity_) {
-            size_t newCapacity = capacity_ < kCapacityMinimum ? kCapacityMinimum :
-                    capacity_ * kCapacityGrowthFactor;
+            size_t newCapacity;
+            if (capacity_ < InlineCount) {
+                // Adopt the inline storage before touching the allocator.
+                newCapacity = InlineCount;
+            } else if (capacity_ < kCapacityMinimum) {
+                newCapacity = kCapacityMinimum;
+            } else {
+                newCapacity = capacity_ * kCapacityGrowthFactor;
+            }
             if (!reallocate(newCapacity)) {
                 return false;
             }
@@ -130,6 +168,22 @@ public:
         }
     }
 
+    // Set size() to exactly |size|, growing the underlying storage if
+    // necessary. Newly exposed elements are not assigned: they hold
+    // whatever the underlying storage holds (zero, for slots which have
+    // never held an element). Only available for plain-old-data element
+    // types; shrinking does not trigger the pop_back shrink heuristic.
+    // Returns true on success, false on allocation failure.
+    bool resize_uninitialized(size_t size) __WARN_UNUSED_RESULT {
+        static_assert(is_pod<T>::value,
+                      "resize_uninitialized requires a plain-old-data element type");
+        if (!reserve(size)) {
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
     T* get() const {
         return ptr_;
     }
@@ -152,20 +206,39 @@ public:
     }
 
 private:
+    // True when the elements live in the inline storage rather than in
+    // memory provided by AllocatorTraits.
+    bool is_inline() {
+        return InlineCount > 0 && ptr_ == this->inline_storage();
+    }
+
     // Forces capacity to become newCapcity.
     // Returns true on success, false on failure.
     // If reallocate fails, the old "ptr_" array is unmodified.
+    // Capacities no larger than InlineCount are served from the inline
+    // storage and cannot fail.
     bool reallocate(size_t newCapacity) {
         MX_DEBUG_ASSERT(newCapacity > 0);
         MX_DEBUG_ASSERT(newCapacity >= size_);
-        auto newPtr = reinterpret_cast<T*>(AllocatorTraits::Allocate(newCapacity * sizeof(T)));
-        if (newPtr == nullptr) {
-            return false;
+        T* newPtr;
+        if (newCapacity <= InlineCount) {
+            if (is_inline()) {
+                return true;
+            }
+            newPtr = this->inline_storage();
+            newCapacity = InlineCount;
+        } else {
+            newPtr = reinterpret_cast<T*>(AllocatorTraits::Allocate(newCapacity * sizeof(T)));
+            if (newPtr == nullptr) {
+                return false;
+            }
         }
         for (size_t i = 0; i < size_; i++) {
             newPtr[i] = mxtl::move(ptr_[i]);
         }
-        AllocatorTraits::Deallocate(ptr_);
+        if (!is_inline()) {
+            AllocatorTraits::Deallocate(ptr_);
+        }
         capacity_ = newCapacity;
         ptr_ = newPtr;
         return true;
@@ -174,7 +247,9 @@ private:
     // Release returns the underlying storage of the vector,
     // while emptying out the vector itself (so it can be destroyed
     // without deleting the release storage).
+    // Only valid when the storage was provided by AllocatorTraits.
     T* release() {
+        MX_DEBUG_ASSERT(!is_inline());
         T* t = ptr_;
         ptr_ = nullptr;
         size_ = 0;
@@ -188,10 +263,17 @@ private:
             ptr_[--size_].~T();
         }
         T* ptr = ptr_;
+        bool was_inline = is_inline();
         ptr_ = t;
         size_ = size;
         capacity_ = capacity;
-        AllocatorTraits::Deallocate(ptr);
+        if (was_inline) {
+            // Re-zero the inline bytes so they once again look like a
+            // fresh allocation to future occupants.
+            memset(static_cast<void*>(ptr), 0, InlineCount * sizeof(T));
+        } else {
+            AllocatorTraits::Deallocate(ptr);
+        }
     }
 
     T* ptr_;
@@ -203,4 +285,10 @@ private:
     static constexpr size_t kCapacityShrinkFactor = 4;
 };
 
+// Shorthand for a Vector which stores its first |InlineCount| elements
+// inside the object itself.
+template <typename T, size_t InlineCount,
+          typename AllocatorTraits = DefaultAllocatorTraits>
+using InlineVector = Vector<T, AllocatorTraits, InlineCount>;
+
 }  // namespace mxtl
@@ -179,6 +179,10 @@ void ralloc_destroy_allocator(ralloc_allocator_t* allocator);
 mx_status_t ralloc_add_region(ralloc_allocator_t* allocator,
                               const ralloc_region_t* region,
                               bool allow_overlap);
+mx_status_t ralloc_add_regions(ralloc_allocator_t* allocator,
+                               const ralloc_region_t* regions,
+                               size_t count,
+                               bool allow_overlap);
 mx_status_t ralloc_sub_region(ralloc_allocator_t* allocator,
                               const ralloc_region_t* region,
                               bool allow_incomplete);
@@ -387,6 +391,16 @@ public:
     //      available regions, and allow_overlap is false.
     mx_status_t AddRegion(const ralloc_region_t& region, bool allow_overlap = false);
 
+    // Add a batch of regions to the set of allocatable regions, holding the
+    // allocator lock once for the whole batch.  Intended for initialization,
+    // where the full set of regions to manage is known up front.
+    //
+    // Regions are added in array order.  On failure, the error for the
+    // offending region is returned and any regions which preceded it remain
+    // in the available set.  Possible return values are those of AddRegion.
+    mx_status_t AddRegions(const ralloc_region_t* regions, size_t count,
+                           bool allow_overlap = false);
+
     // Subtract a region from the set of allocatable regions.
     //
     // If allow_incomplete is false, the subtracted region must exist entirely
@@ -474,6 +488,7 @@ public:
     }
 
 private:
+    mx_status_t AddRegionLocked(const ralloc_region_t& region, bool allow_overlap = false);
     mx_status_t AddSubtractSanityCheckLocked(const ralloc_region_t& region);
     void ReleaseRegion(Region* region);
     void AddRegionToAvailLocked(Region* region, bool allow_overlap = false);
@@ -84,6 +84,17 @@ mx_status_t ralloc_add_region(ralloc_allocator_t* allocator,
     return reinterpret_cast<RegionAllocator*>(allocator)->AddRegion(*region, allow_overlap);
 }
 
+mx_status_t ralloc_add_regions(ralloc_allocator_t* allocator,
+                               const ralloc_region_t* regions,
+                               size_t count,
+                               bool allow_overlap) {
+    if (!allocator || (!regions && count))
+        return MX_ERR_INVALID_ARGS;
+
+    return reinterpret_cast<RegionAllocator*>(allocator)->AddRegions(regions, count,
+                                                                     allow_overlap);
+}
+
 mx_status_t ralloc_sub_region(ralloc_allocator_t* allocator,
                               const ralloc_region_t* region,
                               bool allow_incomplete) {
@@ -62,7 +62,29 @@ mx_status_t RegionAllocator::SetRegionPool(const RegionPool::RefPtr& region_pool
 
 mx_status_t RegionAllocator::AddRegion(const ralloc_region_t& region, bool allow_overlap) {
     mxtl::AutoLock alloc_lock(&alloc_lock_);
+    return AddRegionLocked(region, allow_overlap);
+}
+
+mx_status_t RegionAllocator::AddRegions(const ralloc_region_t* regions,
+                                        size_t count,
+                                        bool allow_overlap) {
+    if ((regions == nullptr) && count)
+        return MX_ERR_INVALID_ARGS;
+
+    // Take the lock once for the whole batch.  Regions are added in order;
+    // if one of them fails to add, the regions which preceded it remain in
+    // the available set and the error is returned.
+    mxtl::AutoLock alloc_lock(&alloc_lock_);
+    for (size_t i = 0; i < count; ++i) {
+        mx_status_t ret = AddRegionLocked(regions[i], allow_overlap);
+        if (ret != MX_OK)
+            return ret;
+    }
+
+    return MX_OK;
+}
 
+mx_status_t RegionAllocator::AddRegionLocked(const ralloc_region_t& region, bool allow_overlap) {
     // Start with sanity checks
     mx_status_t ret = AddSubtractSanityCheckLocked(region);
     if (ret != MX_OK)
@@ -291,34 +313,44 @@ mx_status_t RegionAllocator::GetRegion(uint64_t size,
     uint64_t mask     = alignment - 1;
     uint64_t inv_mask = ~mask;
 
-    // Start by using our size index to look up the first available region which
-    // is large enough to hold this allocation (if any)
+    // Start by using our size index to look up the best-fit candidate; the
+    // smallest available region which is large enough to hold this
+    // allocation (if any).
     auto iter = avail_regions_by_size_.lower_bound({ .base = 0, .size = size });
+    if (!iter.IsValid())
+        return MX_ERR_NOT_FOUND;
+
+    // The candidate is usable if the aligned base address has not wrapped
+    // the address space, and if the overhead required to align the
+    // allocation is not larger than what is leftover in the region after
+    // performing the allocation.
+    uint64_t aligned_base = (iter->base + mask) & inv_mask;
+    uint64_t overhead     = aligned_base - iter->base;
+    uint64_t leftover     = iter->size - size;
+    if ((aligned_base >= iter->base) && (overhead <= leftover))
+        return AllocFromAvailLocked(iter, out_region, aligned_base, size);
+
+    // The best-fit region cannot satisfy the alignment.  Instead of walking
+    // the size index linearly (which degrades to O(n) on a fragmented
+    // allocator), jump straight to the first region which is large enough
+    // to guarantee an aligned fit: any region of at least size + mask bytes
+    // can hold the allocation no matter where its base lies.
+    uint64_t padded_size = size + mask;
+    if (padded_size < size)
+        return MX_ERR_NOT_FOUND;
 
-    // Consider all of the regions which are large enough to hold our
-    // allocation.  Stop as soon as we find one which can satisfy the alignment
-    // restrictions.
-    uint64_t aligned_base;
-    while (iter.IsValid()) {
-        MX_DEBUG_ASSERT(iter->size >= size);
+    for (iter = avail_regions_by_size_.lower_bound({ .base = 0, .size = padded_size });
+         iter.IsValid(); ++iter) {
+        MX_DEBUG_ASSERT(iter->size >= padded_size);
         aligned_base = (iter->base + mask) & inv_mask;
-        uint64_t overhead = aligned_base - iter->base;
-        uint64_t leftover = iter->size - size;
-
-        // We have a usable region if the aligned base address has not wrapped
-        // the address space, and if overhead required to align the allocation
-        // is not larger than what is leftover in the region after performing
-        // the allocation.
-        if ((aligned_base >= iter->base) && (overhead <= leftover))
-            break;
 
-        ++iter;
+        // Guaranteed to fit unless aligning the base wrapped the space,
+        // which can only happen for regions at the very top of it.
+        if (aligned_base >= iter->base)
+            return AllocFromAvailLocked(iter, out_region, aligned_base, size);
     }
 
-    if (!iter.IsValid())
-        return MX_ERR_NOT_FOUND;
-
-    return AllocFromAvailLocked(iter, out_region, aligned_base, size);
+    return MX_ERR_NOT_FOUND;
 }
 
 mx_status_t RegionAllocator::GetRegion(const ralloc_region_t& requested_region,
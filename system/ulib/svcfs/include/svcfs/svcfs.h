@@ -10,7 +10,10 @@
 #include <mx/channel.h>
 #include <mxtl/array.h>
 #include <mxtl/intrusive_double_list.h>
+#include <mxtl/intrusive_hash_table.h>
+#include <mxtl/intrusive_single_list.h>
 #include <mxtl/ref_ptr.h>
+#include <mxtl/string_piece.h>
 
 namespace svcfs {
 
@@ -24,7 +27,8 @@ protected:
 
 using Vnode = fs::Vnode;
 
-class VnodeSvc : public Vnode {
+class VnodeSvc : public Vnode,
+                 public mxtl::SinglyLinkedListable<VnodeSvc*> {
 public:
     DISALLOW_COPY_ASSIGN_AND_MOVE(VnodeSvc);
     using NodeState = mxtl::DoublyLinkedListNodeState<mxtl::RefPtr<VnodeSvc>>;
@@ -49,6 +53,10 @@ public:
     bool NameMatch(const char* name, size_t len) const;
     void ClearProvider();
 
+    // Trait methods for |VnodeDir|'s name index.
+    mxtl::StringPiece GetKey() const { return mxtl::StringPiece(name_.get(), name_.size()); }
+    static size_t GetHash(const mxtl::StringPiece& key);
+
 private:
     NodeState type_child_state_;
 
@@ -83,10 +91,19 @@ public:
 
 private:
     using ServiceList = mxtl::DoublyLinkedList<mxtl::RefPtr<VnodeSvc>, VnodeSvc::TypeChildTraits>;
+    // Sized for /svc namespaces that have grown into the hundreds of entries.
+    using ServiceMap = mxtl::HashTable<mxtl::StringPiece, VnodeSvc*,
+                                       mxtl::SinglyLinkedList<VnodeSvc*>,
+                                       size_t, 127>;
 
     // Starts at 3 because . has ID one and .. has ID two.
     uint64_t next_node_id_;
+
+    // |services_| owns the vnodes and preserves registration order for
+    // Readdir; |services_by_name_| is a non-owning index over the same
+    // vnodes so Lookup does not scan the whole namespace per connect.
     ServiceList services_;
+    ServiceMap services_by_name_;
     fs::WatcherContainer watcher_;
 };
 
@@ -80,6 +80,15 @@ bool VnodeSvc::NameMatch(const char* name, size_t len) const {
     return (name_.size() == len) && (memcmp(name_.get(), name, len) == 0);
 }
 
+// FNV-1a over the service name; the table mods this down to its bucket count.
+size_t VnodeSvc::GetHash(const mxtl::StringPiece& key) {
+    uint64_t n = 14695981039346656037ull;
+    for (size_t i = 0; i < key.length(); ++i) {
+        n = (n ^ static_cast<uint8_t>(key.data()[i])) * 1099511628211ull;
+    }
+    return static_cast<size_t>(n);
+}
+
 void VnodeSvc::ClearProvider() {
     provider_ = nullptr;
 }
@@ -96,15 +105,12 @@ mx_status_t VnodeDir::Open(uint32_t flags) {
 }
 
 mx_status_t VnodeDir::Lookup(mxtl::RefPtr<fs::Vnode>* out, const char* name, size_t len) {
-    mxtl::RefPtr<VnodeSvc> vn = nullptr;
-    for (auto& child : services_) {
-        if (child.NameMatch(name, len)) {
-            *out = mxtl::RefPtr<VnodeSvc>(&child);
-            return MX_OK;
-        }
+    auto it = services_by_name_.find(mxtl::StringPiece(name, len));
+    if (!it.IsValid()) {
+        return MX_ERR_NOT_FOUND;
     }
-
-    return MX_ERR_NOT_FOUND;
+    *out = mxtl::RefPtr<VnodeSvc>(it.CopyPointer());
+    return MX_OK;
 }
 
 mx_status_t VnodeDir::Getattr(vnattr_t* attr) {
@@ -157,23 +163,35 @@ bool VnodeDir::AddService(const char* name, size_t len, ServiceProvider* provide
     mxtl::RefPtr<VnodeSvc> vn = mxtl::AdoptRef(new VnodeSvc(
         next_node_id_++, mxtl::move(array), provider));
 
+    // The first registration under a name owns the index entry; a duplicate
+    // stays reachable only through Readdir, as with the old list scan.
+    services_by_name_.insert_or_find(vn.get());
     services_.push_back(mxtl::move(vn));
     Notify(name, len, VFS_WATCH_EVT_ADDED);
     return true;
 }
 
 bool VnodeDir::RemoveService(const char* name, size_t len) {
+    VnodeSvc* vn = services_by_name_.erase(mxtl::StringPiece(name, len));
+    if (!vn) {
+        return false;
+    }
+    vn->ClearProvider();
+    services_.erase(*vn);
+
+    // If a duplicate registration was shadowed by the removed entry, it now
+    // takes over the index slot.
     for (auto& child : services_) {
         if (child.NameMatch(name, len)) {
-            child.ClearProvider();
-            services_.erase(child);
-            return true;
+            services_by_name_.insert(&child);
+            break;
         }
     }
-    return false;
+    return true;
 }
 
 void VnodeDir::RemoveAllServices() {
+    services_by_name_.clear();
     for (VnodeSvc& vn : services_) {
         vn.ClearProvider();
     }
@@ -0,0 +1,38 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/types.h>
+#include <magenta/compiler.h>
+
+#include <stdatomic.h>
+
+__BEGIN_CDECLS;
+
+// An adaptive mutex for short critical sections: on contention it
+// spins briefly before parking in the kernel, and the spin budget
+// adapts to how often spinning has paid off for this mutex in the
+// past.  Prefer mtx_t for critical sections that may block or run
+// long; parked waiters cost nothing, while spinning waiters burn cpu.
+typedef struct {
+    atomic_int futex;
+    // Spin budget earned by this mutex's contention history.
+    // Zero means "no history yet"; see mutex.c.
+    atomic_int spins;
+} mutex_t;
+
+#define MUTEX_INIT ((mutex_t){})
+
+// Blocks until the lock is obtained.
+void mutex_lock(mutex_t* mutex);
+
+// Attempts to take the lock without blocking. Returns MX_OK if the
+// lock is obtained, and MX_ERR_BAD_STATE if not.
+mx_status_t mutex_trylock(mutex_t* mutex);
+
+// Unlocks the lock, waking one parked waiter if any exist.
+void mutex_unlock(mutex_t* mutex);
+
+__END_CDECLS;
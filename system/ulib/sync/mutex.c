@@ -0,0 +1,149 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <sync/mutex.h>
+
+#include <magenta/syscalls.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// The futex states are the same as those of mxr_mutex (see Ulrich
+// Drepper's "Futexes Are Tricky", "Mutex, Take 2").  What's different
+// is the lock path: before parking in the kernel, a contended locker
+// spins in the hope that the holder is mid critical section on another
+// cpu.  The spin budget adapts per mutex: a spin that acquires the
+// lock grows the budget, a spin that times out shrinks it, so mutexes
+// whose holders actually block stop burning cpu and go straight to
+// mx_futex_wait.
+enum {
+    UNLOCKED = 0,
+    LOCKED_WITHOUT_WAITERS = 1,
+    LOCKED_WITH_WAITERS = 2,
+};
+
+enum {
+    // The budget used the first time a zero-initialized mutex sees
+    // contention.  Stored budgets stay in [SPIN_MIN, SPIN_MAX]; zero
+    // is reserved to mean "no history yet".
+    SPIN_DEFAULT = 100,
+    SPIN_MIN = 1,
+    SPIN_MAX = 1000,
+};
+
+static void spin_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#else
+    __asm__ volatile("yield" ::: "memory");
+#endif
+}
+
+static bool spin_worthwhile(void) {
+    // On a single cpu the holder cannot make progress while we spin.
+    static atomic_uint num_cpus;
+    uint32_t cpus = atomic_load_explicit(&num_cpus, memory_order_relaxed);
+    if (cpus == 0) {
+        cpus = mx_system_get_num_cpus();
+        atomic_store_explicit(&num_cpus, cpus, memory_order_relaxed);
+    }
+    return cpus > 1;
+}
+
+// On success, this will leave the mutex in the LOCKED_WITH_WAITERS state.
+static void lock_slow_path(mutex_t* mutex, int old_state) {
+    for (;;) {
+        // If the state shows there are already waiters, or we can update
+        // it to indicate that there are waiters, then wait.
+        if (old_state == LOCKED_WITH_WAITERS ||
+            (old_state == LOCKED_WITHOUT_WAITERS &&
+             atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                            LOCKED_WITH_WAITERS))) {
+            mx_futex_wait(&mutex->futex, LOCKED_WITH_WAITERS,
+                          MX_TIME_INFINITE);
+        }
+
+        // Try again to claim the mutex.  On this try, we must set the
+        // mutex state to LOCKED_WITH_WAITERS rather than
+        // LOCKED_WITHOUT_WAITERS, since we could have been woken up when
+        // many threads are in the wait queue for the mutex.
+        old_state = UNLOCKED;
+        if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                           LOCKED_WITH_WAITERS)) {
+            return;
+        }
+    }
+}
+
+void mutex_lock(mutex_t* mutex) {
+    int old_state = UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                       LOCKED_WITHOUT_WAITERS)) {
+        return;
+    }
+
+    if (spin_worthwhile()) {
+        int budget = atomic_load_explicit(&mutex->spins,
+                                          memory_order_relaxed);
+        if (budget == 0)
+            budget = SPIN_DEFAULT;
+
+        for (int i = 0; i < budget; ++i) {
+            spin_pause();
+            if (atomic_load_explicit(&mutex->futex,
+                                     memory_order_relaxed) != UNLOCKED) {
+                continue;
+            }
+            old_state = UNLOCKED;
+            if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                               LOCKED_WITHOUT_WAITERS)) {
+                // Spinning paid off; allow a longer spin next time.
+                int grown = (budget * 2 > SPIN_MAX) ? SPIN_MAX : budget * 2;
+                atomic_store_explicit(&mutex->spins, grown,
+                                      memory_order_relaxed);
+                return;
+            }
+        }
+
+        // Spinning did not pay off; shrink the budget and park.
+        int shrunk = (budget / 2 < SPIN_MIN) ? SPIN_MIN : budget / 2;
+        atomic_store_explicit(&mutex->spins, shrunk, memory_order_relaxed);
+    }
+
+    lock_slow_path(mutex, old_state);
+}
+
+mx_status_t mutex_trylock(mutex_t* mutex) {
+    int old_state = UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                       LOCKED_WITHOUT_WAITERS)) {
+        return MX_OK;
+    }
+    return MX_ERR_BAD_STATE;
+}
+
+void mutex_unlock(mutex_t* mutex) {
+    // This atomic swap executes the full memory barrier that unlocking
+    // a mutex is required to execute.
+    int old_state = atomic_exchange(&mutex->futex, UNLOCKED);
+    switch (old_state) {
+        case LOCKED_WITHOUT_WAITERS:
+            // There were no waiters, so there is nothing more to do.
+            break;
+
+        case LOCKED_WITH_WAITERS:
+            // Wake exactly one waiter; it will reset the state to
+            // LOCKED_WITH_WAITERS on acquisition, so none of the others
+            // are lost.  Waking more would only have them contend.
+            if (mx_futex_wake(&mutex->futex, 1) != MX_OK)
+                __builtin_trap();
+            break;
+
+        case UNLOCKED:
+        default:
+            // Either the mutex was unlocked (in which case the unlock
+            // call was invalid), or the mutex was in an invalid state.
+            __builtin_trap();
+            break;
+    }
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <magenta/compiler.h>
+#include <magenta/syscalls/object.h>
 #include <magenta/types.h>
 
 __BEGIN_CDECLS
@@ -48,6 +49,35 @@ mx_status_t walk_root_job_tree(task_callback_t job_callback,
                                task_callback_t thread_callback,
                                void* context);
 
+// Called on each task in a MX_INFO_TASK_TREE snapshot by
+// walk_job_tree_stats().
+//
+// context: The same value passed to walk_[root_]job_tree_stats().
+// depth: The distance from the root job, as for task_callback_t.
+// entry: The snapshot record for the task: koid, parent koid, type,
+//     name, and (for threads) state and accumulated runtime. Only valid
+//     for the duration of the callback.
+//
+// If the callback returns a value other than MX_OK, the walk terminates
+// and the mx_status_t value is returned by walk_job_tree_stats().
+typedef mx_status_t(task_stats_callback_t)(
+    void* context, int depth, const mx_info_task_tree_entry_t* entry);
+
+// Visits every task under root_job in depth-first pre order, like
+// walk_job_tree(), but from a single MX_INFO_TASK_TREE snapshot instead
+// of opening a handle per task: one syscall for the whole tree rather
+// than several per task. The callback gets snapshot records, not
+// handles, so this is the cheap choice for monitors that resample the
+// tree repeatedly and only need names, states, and runtimes.
+mx_status_t walk_job_tree_stats(mx_handle_t root_job,
+                                task_stats_callback_t callback,
+                                void* context);
+
+// Calls walk_job_tree_stats() on the system's root job. Will fail if the
+// calling process does not have the rights to access the root job.
+mx_status_t walk_root_job_tree_stats(task_stats_callback_t callback,
+                                     void* context);
+
 __END_CDECLS
 
 // C++ interface
@@ -323,30 +323,151 @@ mx_status_t walk_job_tree(mx_handle_t root_job,
         &ctx, root_job, root_job_koid, /* depth */ 1);
 }
 
-mx_status_t walk_root_job_tree(task_callback_t job_callback,
-                               task_callback_t process_callback,
-                               task_callback_t thread_callback,
-                               void* context) {
+static mx_status_t get_root_job(mx_handle_t* root_job) {
     int fd = open("/dev/misc/sysinfo", O_RDWR);
     if (fd < 0) {
         fprintf(stderr, "task-utils/walker: cannot open sysinfo: %d\n", errno);
         return MX_ERR_NOT_FOUND;
     }
 
-    mx_handle_t root_job;
-    size_t n = ioctl_sysinfo_get_root_job(fd, &root_job);
+    size_t n = ioctl_sysinfo_get_root_job(fd, root_job);
     close(fd);
-    if (n != sizeof(root_job)) {
+    if (n != sizeof(*root_job)) {
         fprintf(stderr, "task-utils/walker: cannot obtain root job\n");
         return MX_ERR_NOT_FOUND;
     }
+    return MX_OK;
+}
 
-    mx_status_t s = walk_job_tree(
+mx_status_t walk_root_job_tree(task_callback_t job_callback,
+                               task_callback_t process_callback,
+                               task_callback_t thread_callback,
+                               void* context) {
+    mx_handle_t root_job;
+    mx_status_t s = get_root_job(&root_job);
+    if (s != MX_OK) {
+        return s;
+    }
+
+    s = walk_job_tree(
         root_job, job_callback, process_callback, thread_callback, context);
     mx_handle_close(root_job);
     return s;
 }
 
+// Snapshot-based walk.
+
+// deepest ancestor chain (jobs plus one process) we can track while
+// computing depths; matches the assumption ps makes about job depth
+static const int kMaxTreeDepth = 128;
+
+static mx_status_t fetch_task_tree(mx_handle_t root_job,
+                                   mx_info_task_tree_entry_t** out_entries,
+                                   size_t* out_count) {
+    mx_info_task_tree_entry_t* entries = nullptr;
+    size_t capacity = kNumInitialKoids;
+    size_t actual = 0;
+    size_t avail = 0;
+    mx_status_t status = MX_OK;
+
+    // this is inherently racy, but we retry once with a bit of slop to try to
+    // get a complete snapshot
+    for (int pass = 0; pass < 2; ++pass) {
+        if (avail > capacity) {
+            capacity = avail + kNumExtraKoids;
+        }
+        entries = reinterpret_cast<mx_info_task_tree_entry_t*>(
+            realloc(entries, capacity * sizeof(entries[0])));
+        status = mx_object_get_info(root_job, MX_INFO_TASK_TREE,
+                                    entries, capacity * sizeof(entries[0]),
+                                    &actual, &avail);
+        if (status != MX_OK) {
+            fprintf(stderr,
+                    "ERROR: mx_object_get_info(MX_INFO_TASK_TREE, ...) "
+                    "failed: %s (%d)\n",
+                    mx_status_get_string(status), status);
+            free(entries);
+            return status;
+        }
+        if (actual == avail) {
+            break;
+        }
+    }
+
+    // if we're still too small at least warn the user
+    if (actual < avail) {
+        fprintf(stderr,
+                "WARNING: mx_object_get_info(MX_INFO_TASK_TREE, ...) "
+                "truncated %zu/%zu results\n",
+                avail - actual, avail);
+    }
+
+    *out_entries = entries;
+    *out_count = actual;
+    return MX_OK;
+}
+
+mx_status_t walk_job_tree_stats(mx_handle_t root_job,
+                                task_stats_callback_t callback,
+                                void* context) {
+    mx_info_task_tree_entry_t* entries;
+    size_t count;
+    mx_status_t status = fetch_task_tree(root_job, &entries, &count);
+    if (status != MX_OK) {
+        return status;
+    }
+
+    // Records arrive in depth-first pre-order, so a record's parent is
+    // always on the ancestor stack by the time the record is reached;
+    // that is all we need to recover depths from parent koids.
+    struct {
+        mx_koid_t koid;
+        int depth;
+    } stack[kMaxTreeDepth];
+    int top = -1;
+
+    for (size_t i = 0; i < count; i++) {
+        const mx_info_task_tree_entry_t* e = &entries[i];
+
+        int depth = 0;
+        if (i > 0) {
+            while (top >= 0 && stack[top].koid != e->parent_koid) {
+                top--;
+            }
+            depth = (top >= 0) ? stack[top].depth + 1 : 0;
+        }
+
+        status = callback(context, depth, e);
+        if (status != MX_OK) {
+            break;
+        }
+
+        // threads never have children, so only jobs and processes
+        // go on the ancestor stack
+        if (e->type != MX_OBJ_TYPE_THREAD && top + 1 < kMaxTreeDepth) {
+            top++;
+            stack[top].koid = e->koid;
+            stack[top].depth = depth;
+        }
+    }
+
+    free(entries);
+    return status;
+}
+
+mx_status_t walk_root_job_tree_stats(task_stats_callback_t callback,
+                                     void* context) {
+    mx_handle_t root_job;
+    mx_status_t s = get_root_job(&root_job);
+    if (s != MX_OK) {
+        return s;
+    }
+
+    s = walk_job_tree_stats(root_job, callback, context);
+    mx_handle_close(root_job);
+    return s;
+}
+
 // C++ interface
 
 namespace {
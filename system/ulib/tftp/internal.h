@@ -43,6 +43,10 @@ typedef struct tftp_data_msg_t {
 #define DEFAULT_WINDOWSIZE 1
 #define DEFAULT_MODE MODE_OCTET
 
+// Number of consecutive timeouts we allow before terminating the session.
+// The counter is reset whenever any packet arrives from the peer.
+#define MAX_TIMEOUTS 10
+
 typedef struct tftp_options_t {
     // Maximum filename really is 505 including \0
     // max request size (512) - opcode (2) - shortest mode (4) - null (1)
@@ -91,7 +95,11 @@ typedef enum {
     COMPLETED,
 } tftp_state;
 
-// TODO add a state so time out can be handled properly as well as unexpected traffic
+typedef enum {
+    SEND_FILE = 0,
+    RECV_FILE,
+} tftp_file_direction;
+
 struct tftp_session_t {
     tftp_options options;
     tftp_state state;
@@ -100,6 +108,25 @@ struct tftp_session_t {
     uint32_t block_number;
     uint32_t window_index;
 
+    // Whether this session is pushing or receiving the file; determines the
+    // retransmit action when a timeout fires.
+    tftp_file_direction direction;
+
+    // Sender: last block the peer has acknowledged. block_number advances as
+    // blocks are transmitted, so this is where retransmission restarts after
+    // a timeout.
+    uint32_t block_acked;
+
+    // Receiver: number of out-of-order or duplicate blocks received since the
+    // last in-order block. Used to re-ack at most once per window's worth of
+    // strays; acking every stray would trigger a full window retransmit each
+    // time.
+    uint32_t strays;
+
+    // Consecutive timeouts since the last packet from the peer. The session
+    // is abandoned when this reaches MAX_TIMEOUTS.
+    uint32_t timeouts;
+
     // "Negotiated" values
     size_t file_size;
     tftp_mode mode;
@@ -943,6 +943,81 @@ static bool test_tftp_receive_data_windowsize_skipped_block(void) {
     END_TEST;
 }
 
+static bool test_tftp_receive_data_stray_blocks(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 2048, 1500);
+    tftp_file_interface ifc = {NULL,
+            [](const char* filename, size_t size, void* cookie) -> tftp_status {
+                EXPECT_STR_EQ(filename, kFilename, strlen(kFilename), "bad filename");
+                EXPECT_EQ(size, 2048, "bad file size");
+                return 0;
+            }, NULL, NULL, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    uint8_t req_buf[] = {
+        0x00, 0x02,                                   // Opcode (WRQ)
+        'f', 'i', 'l', 'e', 'n', 'a', 'm', 'e', 0x00, // Filename
+        'O', 'C', 'T', 'E', 'T', 0x00,                // Mode
+        'T', 'S', 'I', 'Z', 'E', 0x00,                // Option
+        '2', '0', '4', '8', 0x00,                     // TSIZE value
+        'W', 'I', 'N', 'D', 'O', 'W', 'S', 'I', 'Z', 'E', 0x00,      // Option
+        '3', 0x00,                                              // WINDOWSIZE value
+    };
+    auto status = tftp_process_msg(ts.session, req_buf, sizeof(req_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive write request failed");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_OACK), "bad response");
+
+    uint8_t data_buf[516] = {
+        0x00, 0x03,  // Opcode (DATA)
+        0x01, 0x00,  // Block
+        0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, // Data; compiler will fill out the rest with zeros
+    };
+    data_buf[515] = 0x79;  // set the last byte to make sure it all gets copied
+
+    ifc.write = mock_write;
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    tx_test_data td;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_EQ(1, ts.session->block_number, "tftp session block number mismatch");
+    EXPECT_EQ(1, ts.session->window_index, "tftp session window index mismatch");
+
+    // Block 3 arrives next, meaning block 2 was dropped. The first stray is
+    // acked with the last in-order block so the sender backs up to it.
+    data_buf[2] = 3u;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    ASSERT_GT(ts.outlen, 0, "outlen must not be zero");
+    auto msg = reinterpret_cast<tftp_data_msg*>(ts.out);
+    EXPECT_EQ(msg->opcode, htons(OPCODE_ACK), "bad opcode");
+    EXPECT_EQ(msg->block, 1, "bad block number");
+
+    // The rest of the in-flight window must not generate further acks; each
+    // ack would restart the sender's window.
+    data_buf[2] = 4u;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_EQ(0, ts.outlen, "no response expected");
+    EXPECT_EQ(1, ts.session->block_number, "tftp session block number mismatch");
+
+    // The retransmit of block 2 resumes the transfer.
+    data_buf[2] = 2u;
+    data_buf[4]++;
+    data_buf[515]++;
+    td.expected.block++;
+    td.expected.offset += DEFAULT_BLOCKSIZE;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_TRUE(verify_write_data(data_buf + 4, td), "bad write data");
+    EXPECT_EQ(2, ts.session->block_number, "tftp session block number mismatch");
+    EXPECT_EQ(1, ts.session->window_index, "tftp session window index mismatch");
+
+    END_TEST;
+}
+
 static bool test_tftp_receive_data_block_wrapping(void) {
     BEGIN_TEST;
 
@@ -1361,6 +1436,153 @@ static bool test_tftp_send_data_receive_ack_skip_block_wrap(void) {
     END_TEST;
 }
 
+static bool test_tftp_send_data_timeout(void) {
+    constexpr uint8_t kWindowSize = 2;
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 2048, 1500);
+
+    auto status = tftp_generate_write_request(ts.session, kFilename, MODE_OCTET,
+        ts.msg_size, 0, 0, kWindowSize, ts.out, &ts.outlen, &ts.timeout);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "error generating write request");
+
+    uint8_t oack_buf[] = {
+        0x00, 0x06,                     // Opcode (OACK)
+        'T', 'S', 'I', 'Z', 'E', 0x00,  // Option
+        '2', '0', '4', '8', 0x00,       // TSIZE value
+        'W', 'I', 'N', 'D', 'O', 'W', 'S', 'I', 'Z', 'E', 0x00,      // Option
+        '2', 0x00,                                              // WINDOWSIZE value
+    };
+
+    tftp_file_interface ifc = {NULL, NULL, mock_read, NULL, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    tx_test_data td;
+    status = tftp_process_msg(ts.session, oack_buf, sizeof(oack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    ASSERT_TRUE(verify_read_data(ts, td), "bad test data");
+
+    td.expected.block++;
+    td.expected.offset += DEFAULT_BLOCKSIZE;
+    td.expected.data[0]++;
+    status = tftp_prepare_data(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    ASSERT_TRUE(verify_read_data(ts, td), "bad test data");
+    ASSERT_EQ(2, ts.session->block_number, "tftp session block number mismatch");
+    ASSERT_FALSE(tftp_session_has_pending(ts.session), "expected to wait for ack");
+
+    // No ack ever arrives; a timeout must roll the window back to the last
+    // acked block (none, in this case) and retransmit from there.
+    tx_test_data td2;
+    status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, &td2);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "timeout failed");
+    EXPECT_EQ(ts.outlen, sizeof(tftp_data_msg) + DEFAULT_BLOCKSIZE, "bad outlen");
+    EXPECT_TRUE(verify_read_data(ts, td2), "bad test data");
+    EXPECT_EQ(0, ts.session->block_number, "window should be rolled back");
+    EXPECT_EQ(1, ts.session->window_index, "tftp session window index mismatch");
+    EXPECT_TRUE(tftp_session_has_pending(ts.session), "expected pending data to transmit");
+
+    END_TEST;
+}
+
+static bool test_tftp_receive_data_timeout(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 1024, 1500);
+    tftp_file_interface ifc = {NULL,
+            [](const char* filename, size_t size, void* cookie) -> tftp_status {
+                return 0;
+            }, NULL, mock_write, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    uint8_t req_buf[] = {
+        0x00, 0x02,                                   // Opcode (WRQ)
+        'f', 'i', 'l', 'e', 'n', 'a', 'm', 'e', 0x00, // Filename
+        'O', 'C', 'T', 'E', 'T', 0x00,                // Mode
+        'T', 'S', 'I', 'Z', 'E', 0x00,                // Option
+        '1', '0', '2', '4', 0x00,                     // TSIZE value
+    };
+    auto status = tftp_process_msg(ts.session, req_buf, sizeof(req_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive write request failed");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_OACK), "bad response");
+
+    uint8_t data_buf[516] = {
+        0x00, 0x03,  // Opcode (DATA)
+        0x01, 0x00,  // Block
+        0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, // Data; compiler will fill out the rest with zeros
+    };
+
+    tx_test_data td;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_ACK), "bad response");
+
+    // Our ack may have been lost; a timeout must resend it.
+    status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "timeout failed");
+    EXPECT_EQ(sizeof(tftp_data_msg), ts.outlen, "response size mismatch");
+    auto msg = reinterpret_cast<tftp_data_msg*>(ts.out);
+    EXPECT_EQ(msg->opcode, htons(OPCODE_ACK), "bad opcode");
+    EXPECT_EQ(msg->block, 1, "bad block number");
+
+    END_TEST;
+}
+
+static bool test_tftp_timeout_too_many(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 2048, 1500);
+    tftp_file_interface ifc = {NULL,
+            [](const char* filename, size_t size, void* cookie) -> tftp_status {
+                return 0;
+            }, NULL, mock_write, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    uint8_t req_buf[] = {
+        0x00, 0x02,                                   // Opcode (WRQ)
+        'f', 'i', 'l', 'e', 'n', 'a', 'm', 'e', 0x00, // Filename
+        'O', 'C', 'T', 'E', 'T', 0x00,                // Mode
+        'T', 'S', 'I', 'Z', 'E', 0x00,                // Option
+        '2', '0', '4', '8', 0x00,                     // TSIZE value
+    };
+    auto status = tftp_process_msg(ts.session, req_buf, sizeof(req_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive write request failed");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_OACK), "bad response");
+
+    uint8_t data_buf[516] = {
+        0x00, 0x03,  // Opcode (DATA)
+        0x01, 0x00,  // Block
+        0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, // Data; compiler will fill out the rest with zeros
+    };
+
+    tx_test_data td;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+
+    status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "timeout failed");
+    EXPECT_EQ(1, ts.session->timeouts, "bad timeout count");
+
+    // Receiving a packet from the peer resets the timeout counter.
+    data_buf[2]++;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_EQ(0, ts.session->timeouts, "timeout count should be reset");
+
+    // The session is abandoned once the timeouts become consecutive.
+    for (int i = 0; i < MAX_TIMEOUTS; i++) {
+        status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+        EXPECT_EQ(TFTP_NO_ERROR, status, "timeout failed");
+    }
+    status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_ERR_TIMED_OUT, status, "session should give up");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(tftp_setup)
 RUN_TEST(test_tftp_init)
 RUN_TEST(test_tftp_session_options)
@@ -1397,6 +1619,7 @@ RUN_TEST(test_tftp_receive_data_blocksize)
 RUN_TEST(test_tftp_receive_data_windowsize)
 RUN_TEST(test_tftp_receive_data_skipped_block)
 RUN_TEST(test_tftp_receive_data_windowsize_skipped_block)
+RUN_TEST(test_tftp_receive_data_stray_blocks)
 RUN_TEST(test_tftp_receive_data_block_wrapping)
 END_TEST_CASE(tftp_receive_data)
 
@@ -1409,6 +1632,12 @@ RUN_TEST(test_tftp_send_data_receive_ack_block_wrapping)
 RUN_TEST(test_tftp_send_data_receive_ack_skip_block_wrap)
 END_TEST_CASE(tftp_send_data)
 
+BEGIN_TEST_CASE(tftp_timeout)
+RUN_TEST(test_tftp_send_data_timeout)
+RUN_TEST(test_tftp_receive_data_timeout)
+RUN_TEST(test_tftp_timeout_too_many)
+END_TEST_CASE(tftp_timeout)
+
 int main(int argc, char* argv[]) {
     return unittest_run_all_tests(argc, argv) ? 0 : -1;
 }
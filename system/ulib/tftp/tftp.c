@@ -295,6 +295,7 @@ tftp_status tftp_generate_write_request(tftp_session* session,
     *timeout_ms = 1000 * session->timeout;
 
     session->state = WRITE_REQUESTED;
+    session->direction = SEND_FILE;
     xprintf("Generated write request, len=%zu\n", *outlen);
     return TFTP_NO_ERROR;
 }
@@ -457,6 +458,7 @@ tftp_status tftp_handle_wrq(tftp_session* session,
     }
     *resp_len = *resp_len - left;
     session->state = WRITE_REQUESTED;
+    session->direction = RECV_FILE;
 
     xprintf("Read/Write Request Parsed\n");
     xprintf("Options requested: %08x\n", session->options.requested);
@@ -516,10 +518,21 @@ tftp_status tftp_handle_data(tftp_session* session,
         }
         session->block_number++;
         session->window_index++;
+        session->strays = 0;
     } else {
-        // Force sending a ACK with the last block_number we received
+        // Either a block was dropped (delta > 1) or this is a duplicate of a
+        // block we already have (delta <= 0, e.g. a window retransmit after
+        // our last ACK was lost). Re-ack the last in-order block so the
+        // sender backs up to it, but only once per window's worth of strays;
+        // every ACK restarts the sender's window, so acking each stray would
+        // multiply the retransmitted traffic.
         xprintf("Skipped: got %d, expected %d\n", session->block_number + block_delta,
                 session->block_number + 1);
+        if (session->strays++ % session->window_size) {
+            *resp_len = 0;
+            return TFTP_NO_ERROR;
+        }
+        // Force sending a ACK with the last block_number we received
         session->window_index = session->window_size;
     }
 
@@ -570,6 +583,7 @@ tftp_status tftp_handle_ack(tftp_session* session,
     // signed 16 bit offset to determine the adjustment to the current position.
     int16_t block_offset = ack_data->block - (uint16_t)session->block_number;
     session->block_number += block_offset;
+    session->block_acked = session->block_number;
     session->window_index = 0;
 
     if (((session->block_number + session->window_index) * session->block_size) >=
@@ -737,6 +751,9 @@ tftp_status tftp_process_msg(tftp_session* session,
     uint16_t opcode = ntohs(msg->opcode);
     xprintf("handle_msg opcode=%u\n", opcode);
 
+    // Any packet from the peer is a sign of life; reset the timeout counter
+    session->timeouts = 0;
+
     // Set default timeout
     *timeout_ms = 1000 * session->timeout;
 
@@ -786,8 +803,33 @@ tftp_status tftp_timeout(tftp_session* session,
                          size_t* outlen,
                          uint32_t* timeout_ms,
                          void* cookie) {
-    // TODO: really handle timeouts
-    return TFTP_NO_ERROR;
+    xprintf("Timeout\n");
+    *outlen = 0;
+    if (++session->timeouts > MAX_TIMEOUTS) {
+        return TFTP_ERR_TIMED_OUT;
+    }
+    if (session->state != TRANSMITTING) {
+        // Nothing has been negotiated yet. We don't keep the original request
+        // around to retransmit, so just wait for the peer to retry it (or for
+        // the timeout counter to give up on the session).
+        return TFTP_NO_ERROR;
+    }
+    if (session->direction == SEND_FILE) {
+        // The window (or the ack for it) was lost. Roll back to the last
+        // block the receiver acknowledged and retransmit from there; the
+        // caller streams the rest of the window via tftp_prepare_data().
+        session->block_number = session->block_acked;
+        session->window_index = 0;
+        return tx_data(session, (tftp_data_msg*)outgoing, outlen, cookie);
+    } else {
+        // Our last ack may have been lost; resend it so the sender can move
+        // its window forward.
+        tftp_data_msg* ack_data = (tftp_data_msg*)outgoing;
+        OPCODE(ack_data, OPCODE_ACK);
+        ack_data->block = session->block_number & 0xffff;
+        *outlen = sizeof(*ack_data);
+        return TFTP_NO_ERROR;
+    }
 }
 
 #define REPORT_ERR(opts,...)                                     \
@@ -883,11 +925,12 @@ tftp_status tftp_push_file(tftp_session* session,
                 continue;
             }
             if (n == TFTP_ERR_TIMED_OUT) {
+                out_sz = out_buf_sz;
                 ret = tftp_timeout(session,
                                    outgoing,
                                    &out_sz,
                                    &timeout_ms,
-                                   transport_cookie);
+                                   file_cookie);
                 if (out_sz) {
                     n = session->transport_interface.send(outgoing, out_sz, transport_cookie);
                     if (n < 0) {
@@ -899,6 +942,11 @@ tftp_status tftp_push_file(tftp_session* session,
                     REPORT_ERR(opts, "failed during timeout processing");
                     return ret;
                 }
+                // A timeout retransmits from the last acked block; stream the
+                // rest of the rolled-back window before blocking again.
+                if (tftp_session_has_pending(session)) {
+                    pending = true;
+                }
                 continue;
             }
             REPORT_ERR(opts, "failed during transport recv callback");
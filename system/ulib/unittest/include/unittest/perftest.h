@@ -0,0 +1,106 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+/*
+ * Support for performance regression gates.
+ *
+ * A perf test measures a body with warmup and timed iterations (or collects
+ * its own per-operation samples), reduces them to percentiles, and compares
+ * the median against a baseline checked in next to the test. Baselines are
+ * per-platform: the test includes PERF_BASELINE_FILE, which resolves to
+ * perf-baselines-<platform>.h in the test's own directory, e.g.
+ *
+ *   #include <unittest/perftest.h>
+ *   #include PERF_BASELINE_FILE   // defines kPerfBaselines[]
+ *
+ *   static bool perf_frob(void) {
+ *       BEGIN_TEST;
+ *       RUN_PERF_TEST("frob", frob_once, NULL, 10, 1000,
+ *                     kPerfBaselines, countof(kPerfBaselines));
+ *       END_TEST;
+ *   }
+ *
+ * Comparison results are always reported. They only fail the test when
+ * gating is switched on by setting PERF_GATE=1 in the environment, since
+ * timings from an emulator or a loaded builder are not worth gating on.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <magenta/compiler.h>
+
+#include <unittest/unittest.h>
+
+__BEGIN_CDECLS
+
+// Reduced samples for one metric, in nanoseconds per operation.
+typedef struct perf_results {
+    size_t samples;
+    uint64_t min;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+    uint64_t avg;
+} perf_results_t;
+
+// Expected median for one metric. A measured median above
+// p50_ns * (100 + threshold_pct) / 100 counts as a regression.
+typedef struct perf_baseline {
+    const char* metric;
+    uint64_t p50_ns;
+    uint32_t threshold_pct;
+} perf_baseline_t;
+
+#if defined(__x86_64__)
+#define PERF_BASELINE_FILE "perf-baselines-x86-64.h"
+#elif defined(__aarch64__)
+#define PERF_BASELINE_FILE "perf-baselines-arm64.h"
+#else
+#error "no perf baseline platform for this architecture"
+#endif
+
+// Reduces |samples| (nanoseconds per operation) into |out|, sorting the
+// array in place.
+void unittest_perf_results(uint64_t* samples, size_t count, perf_results_t* out);
+
+// Runs |op| |warmup| times untimed, then |iterations| times with each run
+// timed individually, and reduces the timings into |out|. Returns false if
+// |op| ever returns false. Operations cheaper than a clock read should be
+// batched by the caller instead, which then reduces its own samples with
+// unittest_perf_results().
+bool unittest_perf_measure(bool (*op)(void* cookie), void* cookie,
+                           size_t warmup, size_t iterations,
+                           perf_results_t* out);
+
+// Prints the standard one-line summary for |metric|.
+void unittest_perf_report(const char* metric, const perf_results_t* results);
+
+// Compares |results| against the baseline entry for |metric|, printing the
+// verdict. Returns false only when the median regressed beyond the entry's
+// threshold and PERF_GATE is set in the environment; a missing entry or a
+// disabled gate never fails.
+bool unittest_perf_check(const char* metric, const perf_results_t* results,
+                         const perf_baseline_t* baselines, size_t count);
+
+// Returns true when PERF_GATE is set in the environment.
+bool unittest_perf_gate_enabled(void);
+
+// Measure, report, and gate one metric. Must run inside a
+// BEGIN_TEST/END_TEST body.
+#define RUN_PERF_TEST(metric, op, cookie, warmup, iterations, baselines, num_baselines) \
+    do {                                                                                \
+        perf_results_t _perf_results;                                                   \
+        ASSERT_TRUE(unittest_perf_measure(op, cookie, warmup, iterations,               \
+                                          &_perf_results), metric);                     \
+        unittest_perf_report(metric, &_perf_results);                                   \
+        EXPECT_TRUE(unittest_perf_check(metric, &_perf_results,                         \
+                                        baselines, num_baselines), metric);             \
+    } while (0)
+
+__END_CDECLS
@@ -0,0 +1,114 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <unittest/perftest.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <magenta/syscalls.h>
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t lhs = *(const uint64_t*)a;
+    uint64_t rhs = *(const uint64_t*)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+void unittest_perf_results(uint64_t* samples, size_t count, perf_results_t* out) {
+    memset(out, 0, sizeof(*out));
+    if (count == 0) {
+        return;
+    }
+
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+
+    out->samples = count;
+    out->min = samples[0];
+    out->p50 = samples[count / 2];
+    out->p90 = samples[(count * 90) / 100];
+    out->p99 = samples[(count * 99) / 100];
+    out->max = samples[count - 1];
+    out->avg = sum / count;
+}
+
+bool unittest_perf_measure(bool (*op)(void* cookie), void* cookie,
+                           size_t warmup, size_t iterations,
+                           perf_results_t* out) {
+    memset(out, 0, sizeof(*out));
+    if (iterations == 0) {
+        return false;
+    }
+
+    uint64_t* samples = malloc(iterations * sizeof(uint64_t));
+    if (samples == NULL) {
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; ok && (i < warmup); i++) {
+        ok = op(cookie);
+    }
+    for (size_t i = 0; ok && (i < iterations); i++) {
+        uint64_t start = mx_time_get(MX_CLOCK_MONOTONIC);
+        ok = op(cookie);
+        samples[i] = mx_time_get(MX_CLOCK_MONOTONIC) - start;
+    }
+
+    if (ok) {
+        unittest_perf_results(samples, iterations, out);
+    }
+    free(samples);
+    return ok;
+}
+
+void unittest_perf_report(const char* metric, const perf_results_t* results) {
+    unittest_printf_critical(
+        "PERF  %-32s %8zu samples: min %6" PRIu64 "  p50 %6" PRIu64
+        "  p90 %6" PRIu64 "  p99 %6" PRIu64 "  max %8" PRIu64
+        "  avg %6" PRIu64 "  (ns/op)\n",
+        metric, results->samples, results->min, results->p50,
+        results->p90, results->p99, results->max, results->avg);
+}
+
+bool unittest_perf_gate_enabled(void) {
+    const char* gate = getenv("PERF_GATE");
+    return (gate != NULL) && (strcmp(gate, "0") != 0);
+}
+
+bool unittest_perf_check(const char* metric, const perf_results_t* results,
+                         const perf_baseline_t* baselines, size_t count) {
+    const perf_baseline_t* baseline = NULL;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(baselines[i].metric, metric) == 0) {
+            baseline = &baselines[i];
+            break;
+        }
+    }
+    if (baseline == NULL) {
+        unittest_printf_critical("PERF  %-32s no baseline\n", metric);
+        return true;
+    }
+
+    uint64_t limit = baseline->p50_ns * (100 + baseline->threshold_pct) / 100;
+    if (results->p50 <= limit) {
+        unittest_printf_critical(
+            "PERF  %-32s p50 %" PRIu64 " ns within baseline %" PRIu64
+            " ns +%" PRIu32 "%%\n",
+            metric, results->p50, baseline->p50_ns, baseline->threshold_pct);
+        return true;
+    }
+
+    unittest_printf_critical(
+        "PERF  %-32s REGRESSED: p50 %" PRIu64 " ns exceeds baseline %" PRIu64
+        " ns +%" PRIu32 "%% (limit %" PRIu64 " ns)%s\n",
+        metric, results->p50, baseline->p50_ns, baseline->threshold_pct,
+        limit, unittest_perf_gate_enabled() ? "" : " [gate off, not failing]");
+    return !unittest_perf_gate_enabled();
+}
@@ -12,6 +12,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/all-tests.c \
     $(LOCAL_DIR)/crash-handler.c \
     $(LOCAL_DIR)/crash-list.c \
+    $(LOCAL_DIR)/perftest.c \
     $(LOCAL_DIR)/unittest.c \
 
 MODULE_SO_NAME := unittest
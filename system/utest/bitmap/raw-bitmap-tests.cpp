@@ -154,6 +154,34 @@ static bool SetRange(void) {
     END_TEST;
 }
 
+template <typename RawBitmap>
+static bool ScanSparse(void) {
+    BEGIN_TEST;
+
+    // Make the bitmap large enough that scans cross many whole words,
+    // exercising the word-at-a-time skip path.
+    RawBitmap bitmap;
+    EXPECT_EQ(bitmap.Reset(16384), MX_OK, "");
+
+    EXPECT_EQ(bitmap.Scan(0, 16384, false), 16384U, "scan empty for cleared");
+    EXPECT_EQ(bitmap.Scan(0, 16384, true), 0U, "scan empty for set");
+
+    EXPECT_EQ(bitmap.SetOne(11111), MX_OK, "set one bit");
+    EXPECT_EQ(bitmap.Scan(0, 16384, false), 11111U, "scan to sparse set bit");
+    EXPECT_EQ(bitmap.Scan(11112, 16384, false), 16384U, "scan past sparse set bit");
+
+    EXPECT_EQ(bitmap.Set(0, 11111), MX_OK, "set leading run");
+    EXPECT_EQ(bitmap.Scan(0, 16384, true), 11112U, "scan set run");
+    EXPECT_EQ(bitmap.Scan(64, 11111, true), 11111U, "scan whole-word subrange");
+
+    size_t bitoff_start;
+    EXPECT_EQ(bitmap.Find(false, 0, 16384, 64, &bitoff_start), MX_OK,
+              "find free run after sparse bits");
+    EXPECT_EQ(bitoff_start, 11112U, "check returned arg");
+
+    END_TEST;
+}
+
 template <typename RawBitmap>
 static bool FindSimple(void) {
     BEGIN_TEST;
@@ -343,6 +371,7 @@ static bool SetOutOfOrder(void) {
     RUN_TEMPLATIZED_TEST(ClearTwice, specialization)        \
     RUN_TEMPLATIZED_TEST(GetReturnArg, specialization)      \
     RUN_TEMPLATIZED_TEST(SetRange, specialization)          \
+    RUN_TEMPLATIZED_TEST(ScanSparse, specialization)        \
     RUN_TEMPLATIZED_TEST(FindSimple, specialization)        \
     RUN_TEMPLATIZED_TEST(ClearSubrange, specialization)     \
     RUN_TEMPLATIZED_TEST(BoundaryArguments, specialization) \
@@ -855,6 +855,52 @@ static bool channel_disallow_write_to_self(void) {
     END_TEST;
 }
 
+static bool channel_write_gather(void) {
+    BEGIN_TEST;
+
+    mx_handle_t channel[2];
+    ASSERT_EQ(mx_channel_create(0, &channel[0], &channel[1]), MX_OK, "");
+
+    char seg0[] = "hello ";
+    char seg1[] = "gather ";
+    char seg2[] = "world";
+    mx_iovec_t iov[3] = {
+        {seg0, strlen(seg0)},
+        {seg1, strlen(seg1)},
+        {seg2, strlen(seg2)},
+    };
+
+    // num_bytes is the iovec count in gather mode.
+    ASSERT_EQ(mx_channel_write(channel[0], MX_CHANNEL_WRITE_GATHER, iov, 3, NULL, 0),
+              MX_OK, "");
+
+    char buf[64];
+    uint32_t actual = 0;
+    ASSERT_EQ(mx_channel_read(channel[1], 0, buf, NULL, sizeof(buf), 0, &actual, NULL),
+              MX_OK, "");
+    ASSERT_EQ(actual, (uint32_t)strlen("hello gather world"), "");
+    EXPECT_EQ(memcmp(buf, "hello gather world", actual), 0, "");
+
+    // A zero-capacity segment contributes nothing.
+    iov[1].capacity = 0;
+    ASSERT_EQ(mx_channel_write(channel[0], MX_CHANNEL_WRITE_GATHER, iov, 3, NULL, 0),
+              MX_OK, "");
+    ASSERT_EQ(mx_channel_read(channel[1], 0, buf, NULL, sizeof(buf), 0, &actual, NULL),
+              MX_OK, "");
+    ASSERT_EQ(actual, (uint32_t)strlen("hello world"), "");
+    EXPECT_EQ(memcmp(buf, "hello world", actual), 0, "");
+
+    // The iovec count is bounded.
+    EXPECT_EQ(mx_channel_write(channel[0], MX_CHANNEL_WRITE_GATHER, iov,
+                               MX_IOVEC_MAX + 1, NULL, 0),
+              MX_ERR_INVALID_ARGS, "");
+
+    EXPECT_EQ(mx_handle_close(channel[0]), MX_OK, "");
+    EXPECT_EQ(mx_handle_close(channel[1]), MX_OK, "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(channel_tests)
 RUN_TEST(channel_test)
 RUN_TEST(channel_read_error_test)
@@ -868,6 +914,7 @@ RUN_TEST(channel_call2)
 RUN_TEST(bad_channel_call_finish)
 RUN_TEST(channel_nest)
 RUN_TEST(channel_disallow_write_to_self)
+RUN_TEST(channel_write_gather)
 END_TEST_CASE(channel_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -300,6 +300,50 @@ static bool async_wait_event_test_repeat(void) {
     END_TEST;
 }
 
+// Signal edges that arrive while a repeating packet is still queued are
+// folded into that packet rather than dropped.
+static bool async_wait_event_test_coalesce(void) {
+    BEGIN_TEST;
+    mx_status_t status;
+
+    mx_handle_t port;
+    status = mx_port_create(0, &port);
+    EXPECT_EQ(status, MX_OK, "");
+
+    mx_handle_t ev;
+    status = mx_event_create(0u, &ev);
+    EXPECT_EQ(status, MX_OK, "");
+
+    const uint64_t key0 = 3344ull;
+
+    status = mx_object_wait_async(ev, port, key0,
+        MX_USER_SIGNAL_0 | MX_USER_SIGNAL_1, MX_WAIT_ASYNC_REPEATING);
+    EXPECT_EQ(status, MX_OK, "");
+
+    // Two separate edges without an intervening dequeue.
+    EXPECT_EQ(mx_object_signal(ev, 0u, MX_USER_SIGNAL_0), MX_OK, "");
+    EXPECT_EQ(mx_object_signal(ev, 0u, MX_USER_SIGNAL_1), MX_OK, "");
+
+    mx_port_packet_t out = {};
+    ASSERT_EQ(mx_port_wait(port, 0ull, &out, 0u), MX_OK, "");
+    EXPECT_EQ(out.key, key0, "");
+    EXPECT_EQ(out.type, MX_PKT_TYPE_SIGNAL_REP, "");
+    EXPECT_EQ(out.signal.count, 2u, "");
+    EXPECT_EQ(out.signal.observed & MX_USER_SIGNAL_0, MX_USER_SIGNAL_0, "");
+    EXPECT_EQ(out.signal.observed & MX_USER_SIGNAL_1, MX_USER_SIGNAL_1, "");
+
+    // Both edges were delivered in one packet; nothing else is queued.
+    EXPECT_EQ(mx_port_wait(port, 0ull, &out, 0u), MX_ERR_TIMED_OUT, "");
+
+    status = mx_handle_close(port);
+    EXPECT_EQ(status, MX_OK, "");
+
+    status = mx_handle_close(ev);
+    EXPECT_EQ(status, MX_OK, "");
+
+    END_TEST;
+}
+
 static bool pre_writes_channel_test(uint32_t mode) {
     BEGIN_TEST;
     mx_status_t status;
@@ -549,6 +593,7 @@ RUN_TEST(queue_and_close_test)
 RUN_TEST(async_wait_channel_test)
 RUN_TEST(async_wait_event_test_single)
 RUN_TEST(async_wait_event_test_repeat)
+RUN_TEST(async_wait_event_test_coalesce)
 RUN_TEST(async_wait_close_order_1)
 RUN_TEST(async_wait_close_order_2)
 RUN_TEST(async_wait_close_order_3)
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <assert.h>
+#include <string.h>
 
 #include <magenta/process.h>
 #include <magenta/syscalls.h>
@@ -366,6 +367,56 @@ bool info_reflects_process_state() {
     END_TEST;
 }
 
+bool process_memory_vec() {
+    BEGIN_TEST;
+
+    char src[2][64];
+    char dst[2][64];
+    memset(src[0], 0xaa, sizeof(src[0]));
+    memset(src[1], 0x55, sizeof(src[1]));
+    memset(dst, 0, sizeof(dst));
+
+    mx_handle_t self = mx_process_self();
+
+    mx_process_memory_entry_t entries[2];
+    for (size_t i = 0; i < 2; ++i) {
+        entries[i].vaddr = reinterpret_cast<uintptr_t>(src[i]);
+        entries[i].buffer = reinterpret_cast<uintptr_t>(dst[i]);
+        entries[i].length = sizeof(src[i]);
+    }
+
+    uint32_t actual = 0u;
+    EXPECT_EQ(mx_process_read_memory_vec(self, entries, 2u, &actual), MX_OK, "");
+    EXPECT_EQ(actual, 2u, "");
+    EXPECT_EQ(memcmp(dst[0], src[0], sizeof(src[0])), 0, "");
+    EXPECT_EQ(memcmp(dst[1], src[1], sizeof(src[1])), 0, "");
+
+    // A bad range stops the batch; the entries before it still complete.
+    entries[1].vaddr = 0u;
+    actual = 99u;
+    EXPECT_NEQ(mx_process_read_memory_vec(self, entries, 2u, &actual), MX_OK, "");
+    EXPECT_EQ(actual, 1u, "");
+
+    EXPECT_EQ(mx_process_read_memory_vec(self, entries, 0u, &actual),
+              MX_ERR_OUT_OF_RANGE, "");
+    EXPECT_EQ(mx_process_read_memory_vec(self, entries, MX_PROCESS_MEMORY_VEC_MAX + 1u, &actual),
+              MX_ERR_OUT_OF_RANGE, "");
+
+    // Scatter the sources back out through the write side.
+    memset(dst, 0, sizeof(dst));
+    for (size_t i = 0; i < 2; ++i) {
+        entries[i].vaddr = reinterpret_cast<uintptr_t>(dst[i]);
+        entries[i].buffer = reinterpret_cast<uintptr_t>(src[i]);
+        entries[i].length = sizeof(src[i]);
+    }
+    EXPECT_EQ(mx_process_write_memory_vec(self, entries, 2u, &actual), MX_OK, "");
+    EXPECT_EQ(actual, 2u, "");
+    EXPECT_EQ(memcmp(dst[0], src[0], sizeof(src[0])), 0, "");
+    EXPECT_EQ(memcmp(dst[1], src[1], sizeof(src[1])), 0, "");
+
+    END_TEST;
+}
+
 } // namespace
 
 BEGIN_TEST_CASE(process_tests)
@@ -378,6 +429,7 @@ RUN_TEST(kill_process_via_vmar_destroy);
 RUN_TEST(kill_process_handle_cycle);
 RUN_TEST(kill_channel_handle_cycle);
 RUN_TEST(info_reflects_process_state);
+RUN_TEST(process_memory_vec);
 END_TEST_CASE(process_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -401,6 +401,123 @@ static bool socket_datagram(void) {
     END_TEST;
 }
 
+static bool socket_datagram_batch(void) {
+    BEGIN_TEST;
+
+    size_t count;
+    mx_status_t status;
+    mx_handle_t h0, h1;
+    uint32_t len;
+    unsigned char rbuf[64] = {0};
+
+    status = mx_socket_create(MX_SOCKET_DATAGRAM, &h0, &h1);
+    ASSERT_EQ(status, MX_OK, "");
+
+    status = mx_socket_read(h1, MX_SOCKET_READ_BATCH, rbuf, sizeof(rbuf), &count);
+    ASSERT_EQ(status, MX_ERR_SHOULD_WAIT, "");
+
+    status = mx_socket_write(h0, 0u, "packet1", 8u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+    status = mx_socket_write(h0, 0u, "pkt2", 5u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+    status = mx_socket_write(h0, 0u, "p3", 3u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+
+    // Too small for even the first packet plus its length header.
+    status = mx_socket_read(h1, MX_SOCKET_READ_BATCH, rbuf, 8u, &count);
+    ASSERT_EQ(status, MX_ERR_BUFFER_TOO_SMALL, "");
+
+    // Room for the first two records but not the third.
+    count = 0;
+    status = mx_socket_read(h1, MX_SOCKET_READ_BATCH, rbuf, 4u + 8u + 4u + 5u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+    ASSERT_EQ(count, 4u + 8u + 4u + 5u, "");
+    memcpy(&len, rbuf, 4);
+    ASSERT_EQ(len, 8u, "");
+    ASSERT_EQ(memcmp(rbuf + 4, "packet1", 8), 0, "");
+    memcpy(&len, rbuf + 12, 4);
+    ASSERT_EQ(len, 5u, "");
+    ASSERT_EQ(memcmp(rbuf + 16, "pkt2", 5), 0, "");
+
+    // The third packet was left queued whole, not truncated.
+    count = 0;
+    status = mx_socket_read(h1, MX_SOCKET_READ_BATCH, rbuf, sizeof(rbuf), &count);
+    ASSERT_EQ(status, MX_OK, "");
+    ASSERT_EQ(count, 4u + 3u, "");
+    memcpy(&len, rbuf, 4);
+    ASSERT_EQ(len, 3u, "");
+    ASSERT_EQ(memcmp(rbuf + 4, "p3", 3), 0, "");
+
+    mx_handle_close(h0);
+    mx_handle_close(h1);
+
+    // Batch reads are only for datagram sockets.
+    status = mx_socket_create(MX_SOCKET_STREAM, &h0, &h1);
+    ASSERT_EQ(status, MX_OK, "");
+    status = mx_socket_write(h0, 0u, "x", 1u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+    status = mx_socket_read(h1, MX_SOCKET_READ_BATCH, rbuf, sizeof(rbuf), &count);
+    ASSERT_EQ(status, MX_ERR_NOT_SUPPORTED, "");
+    mx_handle_close(h0);
+    mx_handle_close(h1);
+
+    END_TEST;
+}
+
+static bool socket_write_gather(void) {
+    BEGIN_TEST;
+
+    size_t count;
+    mx_status_t status;
+    mx_handle_t h0, h1;
+    unsigned char rbuf[64] = {0};
+
+    char seg0[] = "scatter";
+    char seg1[] = "-";
+    char seg2[] = "gather";
+    mx_iovec_t iov[3] = {
+        {seg0, strlen(seg0)},
+        {seg1, strlen(seg1)},
+        {seg2, strlen(seg2)},
+    };
+
+    // Stream: the segments arrive as one contiguous byte run.
+    status = mx_socket_create(MX_SOCKET_STREAM, &h0, &h1);
+    ASSERT_EQ(status, MX_OK, "");
+    count = 0;
+    status = mx_socket_write(h0, MX_SOCKET_WRITE_GATHER, iov, 3u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+    ASSERT_EQ(count, strlen("scatter-gather"), "");
+    status = mx_socket_read(h1, 0u, rbuf, sizeof(rbuf), &count);
+    ASSERT_EQ(status, MX_OK, "");
+    ASSERT_EQ(count, strlen("scatter-gather"), "");
+    ASSERT_EQ(memcmp(rbuf, "scatter-gather", count), 0, "");
+    mx_handle_close(h0);
+    mx_handle_close(h1);
+
+    // Datagram: the segments form a single packet.
+    status = mx_socket_create(MX_SOCKET_DATAGRAM, &h0, &h1);
+    ASSERT_EQ(status, MX_OK, "");
+    count = 0;
+    status = mx_socket_write(h0, MX_SOCKET_WRITE_GATHER, iov, 3u, &count);
+    ASSERT_EQ(status, MX_OK, "");
+    ASSERT_EQ(count, strlen("scatter-gather"), "");
+    count = 0;
+    status = mx_socket_read(h1, 0u, rbuf, sizeof(rbuf), &count);
+    ASSERT_EQ(status, MX_OK, "");
+    ASSERT_EQ(count, strlen("scatter-gather"), "");
+    ASSERT_EQ(memcmp(rbuf, "scatter-gather", count), 0, "");
+
+    // The iovec count is bounded.
+    status = mx_socket_write(h0, MX_SOCKET_WRITE_GATHER, iov, MX_IOVEC_MAX + 1u, &count);
+    ASSERT_EQ(status, MX_ERR_INVALID_ARGS, "");
+
+    mx_handle_close(h0);
+    mx_handle_close(h1);
+
+    END_TEST;
+}
+
 static bool socket_datagram_no_short_write(void) {
     BEGIN_TEST;
 
@@ -435,6 +552,8 @@ RUN_TEST(socket_bytes_outstanding)
 RUN_TEST(socket_bytes_outstanding_half_close)
 RUN_TEST(socket_short_write)
 RUN_TEST(socket_datagram)
+RUN_TEST(socket_datagram_batch)
+RUN_TEST(socket_write_gather)
 RUN_TEST(socket_datagram_no_short_write)
 END_TEST_CASE(socket_tests)
 
@@ -0,0 +1,135 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Exercises libc's memcpy/memset/memmove/strlen across the size and
+// alignment boundaries where optimized implementations switch
+// strategies (byte, word, and SIMD paths, and the overlapping
+// head/tail copies used for in-between sizes).
+
+#include <stdint.h>
+#include <string.h>
+#include <unittest/unittest.h>
+
+// Large enough to reach the 64-byte-loop path of the SIMD routines
+// several times over, plus guard space on both sides.
+#define BUF_SIZE 512
+#define MAX_LEN 192
+#define MAX_ALIGN 16
+#define GUARD_BYTE 0xa5
+
+static bool check_guards(const uint8_t* buf, size_t start, size_t end) {
+    BEGIN_HELPER;
+    for (size_t i = 0; i < start; i++) {
+        ASSERT_EQ(buf[i], GUARD_BYTE, "guard byte before region clobbered");
+    }
+    for (size_t i = end; i < BUF_SIZE; i++) {
+        ASSERT_EQ(buf[i], GUARD_BYTE, "guard byte after region clobbered");
+    }
+    END_HELPER;
+}
+
+static bool memcpy_test(void) {
+    BEGIN_TEST;
+
+    static uint8_t src[BUF_SIZE];
+    static uint8_t dst[BUF_SIZE];
+    for (size_t i = 0; i < BUF_SIZE; i++) {
+        src[i] = (uint8_t)(i * 13 + 7);
+    }
+
+    for (size_t align = 0; align < MAX_ALIGN; align++) {
+        for (size_t len = 0; len <= MAX_LEN; len++) {
+            memset(dst, GUARD_BYTE, BUF_SIZE);
+            void* ret = memcpy(dst + align, src + align, len);
+            EXPECT_EQ(ret, (void*)(dst + align), "wrong return value");
+            EXPECT_EQ(memcmp(dst + align, src + align, len), 0,
+                      "copied bytes differ from source");
+            ASSERT_TRUE(check_guards(dst, align, align + len), "");
+        }
+    }
+
+    END_TEST;
+}
+
+static bool memset_test(void) {
+    BEGIN_TEST;
+
+    static uint8_t dst[BUF_SIZE];
+
+    for (size_t align = 0; align < MAX_ALIGN; align++) {
+        for (size_t len = 0; len <= MAX_LEN; len++) {
+            memset(dst, GUARD_BYTE, BUF_SIZE);
+            void* ret = memset(dst + align, 0x5c, len);
+            EXPECT_EQ(ret, (void*)(dst + align), "wrong return value");
+            for (size_t i = 0; i < len; i++) {
+                ASSERT_EQ(dst[align + i], 0x5c, "byte not set");
+            }
+            ASSERT_TRUE(check_guards(dst, align, align + len), "");
+        }
+    }
+
+    END_TEST;
+}
+
+static bool memmove_test(void) {
+    BEGIN_TEST;
+
+    static uint8_t buf[BUF_SIZE];
+    static uint8_t expected[BUF_SIZE];
+
+    // Overlapping moves in both directions, at distances smaller and
+    // larger than the widest vector the implementation may use.
+    static const ptrdiff_t shifts[] = {1, -1, 7, -7, 16, -16, 33, -33};
+
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+        ptrdiff_t shift = shifts[s];
+        for (size_t len = 0; len <= MAX_LEN; len++) {
+            for (size_t i = 0; i < BUF_SIZE; i++) {
+                buf[i] = (uint8_t)(i * 29 + 3);
+            }
+            size_t src_off = 64;
+            size_t dst_off = (size_t)(64 + shift);
+            // Reference result, computed from the untouched buffer so
+            // it doesn't depend on the memmove under test.
+            memcpy(expected, buf, BUF_SIZE);
+            for (size_t i = 0; i < len; i++) {
+                expected[dst_off + i] = buf[src_off + i];
+            }
+
+            void* ret = memmove(buf + dst_off, buf + src_off, len);
+            EXPECT_EQ(ret, (void*)(buf + dst_off), "wrong return value");
+            EXPECT_EQ(memcmp(buf, expected, BUF_SIZE), 0,
+                      "overlapping move produced wrong bytes");
+        }
+    }
+
+    END_TEST;
+}
+
+static bool strlen_test(void) {
+    BEGIN_TEST;
+
+    static char buf[BUF_SIZE];
+
+    for (size_t align = 0; align < MAX_ALIGN; align++) {
+        for (size_t len = 0; len <= MAX_LEN; len++) {
+            memset(buf, 'x', BUF_SIZE);
+            buf[align + len] = '\0';
+            EXPECT_EQ(strlen(buf + align), len, "wrong length");
+        }
+    }
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(cstring_tests)
+RUN_TEST(memcpy_test)
+RUN_TEST(memset_test)
+RUN_TEST(memmove_test)
+RUN_TEST(strlen_test)
+END_TEST_CASE(cstring_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
@@ -68,6 +68,7 @@ const size_t kNumCases = sizeof(kCases) / sizeof(struct Case);
 // test setup.
 uint8_t gData[kUnalignedLarge];
 uint8_t gTree[kNodeSize * 3];
+uint8_t gParallelTree[kNodeSize * 3];
 
 ////////////////
 // Test cases
@@ -300,6 +301,38 @@ bool CreateAll(void) {
     END_TEST;
 }
 
+// Used by CreateParallelAll below.  Checks both the root digest and that the
+// tree bytes match those produced by the sequential Create.
+bool CreateParallel(size_t data_len, const char* digest, uint32_t num_threads) {
+    mx_status_t rc;
+    size_t tree_len = MerkleTree::GetTreeLength(data_len);
+    Digest actual;
+    ASSERT_OK(MerkleTree::CreateParallel(gData, data_len, gParallelTree,
+                                         tree_len, &actual, num_threads));
+    Digest expected;
+    ASSERT_OK(expected.Parse(digest, strlen(digest)));
+    ASSERT_TRUE(actual == expected, "Incorrect root digest");
+    ASSERT_OK(MerkleTree::Create(gData, data_len, gTree, tree_len, &expected));
+    ASSERT_EQ(0, memcmp(gTree, gParallelTree, tree_len), "Trees differ");
+    return true;
+}
+
+bool CreateParallelAll(void) {
+    BEGIN_TEST;
+    for (size_t i = 0; i < kNumCases; ++i) {
+        for (uint32_t threads = 1; threads <= 4; threads *= 2) {
+            if (!CreateParallel(kCases[i].data_len, kCases[i].digest,
+                                threads)) {
+                unittest_printf_critical(
+                    "CreateParallelAll failed with data length of %zu "
+                    "and %u threads\n",
+                    kCases[i].data_len, threads);
+            }
+        }
+    }
+    END_TEST;
+}
+
 // Used by CreateFinalCAll below.
 bool CreateFinalC(size_t data_len, const char* digest) {
     mx_status_t rc;
@@ -716,6 +749,7 @@ RUN_TEST(CreateFinalWithoutTree)
 RUN_TEST(CreateFinalMissingDigest)
 RUN_TEST(CreateFinalIncompleteData)
 RUN_TEST(CreateAll)
+RUN_TEST(CreateParallelAll)
 RUN_TEST(CreateFinalCAll)
 RUN_TEST(CreateCAll)
 RUN_TEST(CreateByteByByte)
@@ -3,7 +3,11 @@
 // found in the LICENSE file.
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
 
+#include <magenta/syscalls.h>
 #include <unittest/unittest.h>
 
 #if ENABLE_ENTROPY_COLLECTOR_TEST
@@ -28,6 +32,65 @@ END_TEST_CASE(entropy_tests)
 
 #endif
 
+// The kernel serves mx_cprng_draw from per-cpu generator states, so hit
+// it from several threads at once: every draw must succeed and, since
+// the states are seeded independently, no two draws anywhere may ever
+// return the same bytes.
+namespace {
+
+constexpr size_t kDrawLen = 32;
+constexpr size_t kDrawsPerThread = 256;
+constexpr size_t kNumThreads = 4;
+
+uint8_t draws[kNumThreads][kDrawsPerThread][kDrawLen];
+
+int draw_thread(void* arg) {
+    uint8_t (*out)[kDrawLen] = static_cast<uint8_t(*)[kDrawLen]>(arg);
+    for (size_t i = 0; i < kDrawsPerThread; i++) {
+        size_t actual = 0;
+        mx_status_t status = mx_cprng_draw(out[i], kDrawLen, &actual);
+        if (status != MX_OK || actual != kDrawLen) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int compare_draws(const void* a, const void* b) {
+    return memcmp(a, b, kDrawLen);
+}
+
+} // namespace
+
+bool cprng_draw_concurrent() {
+    BEGIN_TEST;
+
+    thrd_t threads[kNumThreads];
+    for (size_t i = 0; i < kNumThreads; i++) {
+        ASSERT_EQ(thrd_success, thrd_create(&threads[i], draw_thread, draws[i]),
+                  "could not create thread");
+    }
+    for (size_t i = 0; i < kNumThreads; i++) {
+        int result = -1;
+        ASSERT_EQ(thrd_success, thrd_join(threads[i], &result), "");
+        EXPECT_EQ(0, result, "mx_cprng_draw failed");
+    }
+
+    qsort(draws, kNumThreads * kDrawsPerThread, kDrawLen, compare_draws);
+    const uint8_t* flat = &draws[0][0][0];
+    for (size_t i = 1; i < kNumThreads * kDrawsPerThread; i++) {
+        EXPECT_NEQ(0, memcmp(flat + (i - 1) * kDrawLen, flat + i * kDrawLen,
+                             kDrawLen),
+                   "mx_cprng_draw repeated output");
+    }
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(cprng_tests)
+RUN_TEST(cprng_draw_concurrent);
+END_TEST_CASE(cprng_tests)
+
 int main(int argc, char** argv) {
     return unittest_run_all_tests(argc, argv) ? 0 : -1;
 }
@@ -0,0 +1,300 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include <magenta/syscalls.h>
+#include <mxalloc/new.h>
+#include <mxtl/algorithm.h>
+#include <mxtl/unique_ptr.h>
+#include <unittest/perftest.h>
+#include <unittest/unittest.h>
+
+#include PERF_BASELINE_FILE
+
+#define MOUNT_POINT "/benchmark"
+
+// Metadata-intensive benchmark profiles. Where bench-basic measures
+// streaming bandwidth on one big file, these hit the paths minfs hurts on
+// in practice: small-file create/unlink storms, stat-heavy directory
+// walks, random 4K I/O, and several threads churning the same directory.
+// Each profile reports ops/sec plus p50/p99 per-operation latency, since
+// metadata regressions usually show up in the tail first.
+
+namespace {
+
+constexpr size_t kSmallFileSize = 4096;
+
+uint64_t ticks_to_ns(uint64_t ticks) {
+    return ticks * 1000000000ull / mx_ticks_per_second();
+}
+
+// Converts |samples| (per-op latencies in ticks) to nanoseconds, prints
+// the summary for the profile, and checks the median against the
+// checked-in baseline. Returns false only when the perf gate rejects it.
+bool report(const char* profile, const char* op, uint64_t* samples, size_t count,
+            uint64_t total_ticks) {
+    char metric[64];
+    snprintf(metric, sizeof(metric), "%s/%s", profile, op);
+
+    for (size_t i = 0; i < count; i++)
+        samples[i] = ticks_to_ns(samples[i]);
+
+    perf_results_t results;
+    unittest_perf_results(samples, count, &results);
+
+    double seconds = static_cast<double>(total_ticks) /
+                     static_cast<double>(mx_ticks_per_second());
+    printf("Benchmark %s: %8.0f ops/sec (%zu ops)\n", metric,
+           static_cast<double>(count) / seconds, count);
+    unittest_perf_report(metric, &results);
+    return unittest_perf_check(metric, &results, kPerfBaselines,
+                               countof(kPerfBaselines));
+}
+
+void small_file_path(char* path, size_t len, size_t dir, size_t file) {
+    snprintf(path, len, MOUNT_POINT "/storm-%03zu/f-%04zu", dir, file);
+}
+
+// untar-like create storm: many small files spread over a handful of
+// directories, each written in one 4K chunk, then stat-walked, then
+// unlinked.
+template <size_t NumDirs, size_t FilesPerDir>
+bool benchmark_create_storm(void) {
+    BEGIN_TEST;
+    constexpr size_t kNumFiles = NumDirs * FilesPerDir;
+    printf("\nBenchmarking create storm (%zu files over %zu dirs)\n",
+           kNumFiles, NumDirs);
+
+    AllocChecker ac;
+    mxtl::unique_ptr<uint64_t[]> samples(new (&ac) uint64_t[kNumFiles]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[kSmallFileSize]);
+    ASSERT_EQ(ac.check(), true, "");
+    memset(data.get(), 0xee, kSmallFileSize);
+
+    char path[PATH_MAX];
+    for (size_t d = 0; d < NumDirs; d++) {
+        snprintf(path, sizeof(path), MOUNT_POINT "/storm-%03zu", d);
+        ASSERT_EQ(mkdir(path, 0755), 0, "Could not make storm directory");
+    }
+
+    // create + write
+    uint64_t begin = mx_ticks_get();
+    for (size_t i = 0; i < kNumFiles; i++) {
+        small_file_path(path, sizeof(path), i / FilesPerDir, i % FilesPerDir);
+        uint64_t start = mx_ticks_get();
+        int fd = open(path, O_CREAT | O_RDWR | O_EXCL, 0644);
+        ASSERT_GT(fd, 0, "Could not create small file");
+        ASSERT_EQ(write(fd, data.get(), kSmallFileSize), (ssize_t)kSmallFileSize, "");
+        ASSERT_EQ(close(fd), 0, "");
+        samples[i] = mx_ticks_get() - start;
+    }
+    EXPECT_TRUE(report("create_storm", "create", samples.get(), kNumFiles, mx_ticks_get() - begin), "");
+
+    // stat-heavy walk over everything just created
+    begin = mx_ticks_get();
+    for (size_t i = 0; i < kNumFiles; i++) {
+        small_file_path(path, sizeof(path), i / FilesPerDir, i % FilesPerDir);
+        uint64_t start = mx_ticks_get();
+        struct stat buf;
+        ASSERT_EQ(stat(path, &buf), 0, "Could not stat small file");
+        samples[i] = mx_ticks_get() - start;
+    }
+    EXPECT_TRUE(report("create_storm", "stat", samples.get(), kNumFiles, mx_ticks_get() - begin), "");
+
+    // unlink storm
+    begin = mx_ticks_get();
+    for (size_t i = 0; i < kNumFiles; i++) {
+        small_file_path(path, sizeof(path), i / FilesPerDir, i % FilesPerDir);
+        uint64_t start = mx_ticks_get();
+        ASSERT_EQ(unlink(path), 0, "Could not unlink small file");
+        samples[i] = mx_ticks_get() - start;
+    }
+    EXPECT_TRUE(report("create_storm", "unlink", samples.get(), kNumFiles, mx_ticks_get() - begin), "");
+
+    for (size_t d = 0; d < NumDirs; d++) {
+        snprintf(path, sizeof(path), MOUNT_POINT "/storm-%03zu", d);
+        ASSERT_EQ(rmdir(path), 0, "Could not remove storm directory");
+    }
+    END_TEST;
+}
+
+// random 4K reads and writes against one pre-sized file, issued from
+// |QueueDepth| threads in parallel to model an I/O queue.
+template <size_t FileMB, size_t QueueDepth, size_t OpsPerThread>
+struct RandomIoWorker {
+    int fd;
+    bool do_write;
+    uint64_t seed;
+    uint64_t samples[OpsPerThread];
+    uint64_t total_ticks;
+    bool ok;
+
+    static int run(void* arg) {
+        auto* w = static_cast<RandomIoWorker*>(arg);
+        constexpr size_t kBlocks = (FileMB << 20) / kSmallFileSize;
+        uint8_t buf[kSmallFileSize];
+        memset(buf, 0xab, sizeof(buf));
+
+        w->ok = true;
+        uint64_t begin = mx_ticks_get();
+        for (size_t i = 0; i < OpsPerThread; i++) {
+            w->seed = w->seed * 6364136223846793005ull + 1442695040888963407ull;
+            off_t offset = static_cast<off_t>((w->seed >> 33) % kBlocks) * kSmallFileSize;
+
+            uint64_t start = mx_ticks_get();
+            ssize_t r = w->do_write ? pwrite(w->fd, buf, sizeof(buf), offset)
+                                    : pread(w->fd, buf, sizeof(buf), offset);
+            w->samples[i] = mx_ticks_get() - start;
+            if (r != (ssize_t)sizeof(buf)) {
+                w->ok = false;
+                return -1;
+            }
+        }
+        w->total_ticks = mx_ticks_get() - begin;
+        return 0;
+    }
+};
+
+template <size_t FileMB, size_t QueueDepth, size_t OpsPerThread>
+bool benchmark_random_io(void) {
+    BEGIN_TEST;
+    using Worker = RandomIoWorker<FileMB, QueueDepth, OpsPerThread>;
+    printf("\nBenchmarking random 4K I/O (%zu MB file, queue depth %zu)\n",
+           FileMB, QueueDepth);
+
+    int fd = open(MOUNT_POINT "/randfile", O_CREAT | O_RDWR, 0644);
+    ASSERT_GT(fd, 0, "Cannot create file (FS benchmarks assume mounted FS exists at '/benchmark')");
+
+    // size the file up front so reads always hit allocated blocks
+    AllocChecker ac;
+    mxtl::unique_ptr<uint8_t[]> chunk(new (&ac) uint8_t[1 << 20]);
+    ASSERT_EQ(ac.check(), true, "");
+    memset(chunk.get(), 0xee, 1 << 20);
+    for (size_t i = 0; i < FileMB; i++) {
+        ASSERT_EQ(write(fd, chunk.get(), 1 << 20), 1 << 20, "");
+    }
+
+    mxtl::unique_ptr<Worker[]> workers(new (&ac) Worker[QueueDepth]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint64_t[]> merged(new (&ac) uint64_t[QueueDepth * OpsPerThread]);
+    ASSERT_EQ(ac.check(), true, "");
+
+    for (int write_pass = 0; write_pass < 2; write_pass++) {
+        thrd_t threads[QueueDepth];
+        for (size_t i = 0; i < QueueDepth; i++) {
+            workers[i].fd = fd;
+            workers[i].do_write = (write_pass != 0);
+            workers[i].seed = 0x9e3779b97f4a7c15ull * (i + 1);
+            ASSERT_EQ(thrd_create(&threads[i], Worker::run, &workers[i]),
+                      thrd_success, "");
+        }
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < QueueDepth; i++) {
+            ASSERT_EQ(thrd_join(threads[i], nullptr), 0, "");
+            ASSERT_EQ(workers[i].ok, true, "Worker I/O failed");
+            total = mxtl::max(total, workers[i].total_ticks);
+            memcpy(&merged[i * OpsPerThread], workers[i].samples,
+                   sizeof(workers[i].samples));
+        }
+        EXPECT_TRUE(report("random_io", write_pass ? "pwrite" : "pread",
+                           merged.get(), QueueDepth * OpsPerThread, total), "");
+    }
+
+    ASSERT_EQ(close(fd), 0, "");
+    ASSERT_EQ(unlink(MOUNT_POINT "/randfile"), 0, "");
+    END_TEST;
+}
+
+// several threads creating and unlinking distinct files in the same
+// directory, serializing on its vnode and the dirent block paths.
+template <size_t NumThreads, size_t OpsPerThread>
+struct ChurnWorker {
+    size_t id;
+    uint64_t samples[OpsPerThread];
+    uint64_t total_ticks;
+    bool ok;
+
+    static int run(void* arg) {
+        auto* w = static_cast<ChurnWorker*>(arg);
+        char path[PATH_MAX];
+
+        w->ok = true;
+        uint64_t begin = mx_ticks_get();
+        for (size_t i = 0; i < OpsPerThread; i++) {
+            snprintf(path, sizeof(path), MOUNT_POINT "/churn/t%02zu-%04zu",
+                     w->id, i % 16);
+
+            uint64_t start = mx_ticks_get();
+            int fd = open(path, O_CREAT | O_RDWR | O_EXCL, 0644);
+            if (fd < 0 || close(fd) != 0 || unlink(path) != 0) {
+                w->ok = false;
+                return -1;
+            }
+            w->samples[i] = mx_ticks_get() - start;
+        }
+        w->total_ticks = mx_ticks_get() - begin;
+        return 0;
+    }
+};
+
+template <size_t NumThreads, size_t OpsPerThread>
+bool benchmark_directory_churn(void) {
+    BEGIN_TEST;
+    using Worker = ChurnWorker<NumThreads, OpsPerThread>;
+    printf("\nBenchmarking same-directory churn (%zu threads)\n", NumThreads);
+
+    ASSERT_EQ(mkdir(MOUNT_POINT "/churn", 0755), 0, "Could not make churn directory");
+
+    AllocChecker ac;
+    mxtl::unique_ptr<Worker[]> workers(new (&ac) Worker[NumThreads]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint64_t[]> merged(new (&ac) uint64_t[NumThreads * OpsPerThread]);
+    ASSERT_EQ(ac.check(), true, "");
+
+    thrd_t threads[NumThreads];
+    for (size_t i = 0; i < NumThreads; i++) {
+        workers[i].id = i;
+        ASSERT_EQ(thrd_create(&threads[i], Worker::run, &workers[i]),
+                  thrd_success, "");
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < NumThreads; i++) {
+        ASSERT_EQ(thrd_join(threads[i], nullptr), 0, "");
+        ASSERT_EQ(workers[i].ok, true, "Worker churn failed");
+        total = mxtl::max(total, workers[i].total_ticks);
+        memcpy(&merged[i * OpsPerThread], workers[i].samples,
+               sizeof(workers[i].samples));
+    }
+    EXPECT_TRUE(report("dir_churn", "create+unlink", merged.get(), NumThreads * OpsPerThread, total), "");
+
+    ASSERT_EQ(rmdir(MOUNT_POINT "/churn"), 0, "Could not remove churn directory");
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(metadata_benchmarks)
+RUN_TEST_PERFORMANCE((benchmark_create_storm<16, 256>))
+RUN_TEST_PERFORMANCE((benchmark_create_storm<64, 256>))
+RUN_TEST_PERFORMANCE((benchmark_random_io<64, 1, 2048>))
+RUN_TEST_PERFORMANCE((benchmark_random_io<64, 4, 2048>))
+RUN_TEST_PERFORMANCE((benchmark_random_io<64, 16, 1024>))
+RUN_TEST_PERFORMANCE((benchmark_directory_churn<2, 2048>))
+RUN_TEST_PERFORMANCE((benchmark_directory_churn<8, 1024>))
+END_TEST_CASE(metadata_benchmarks)
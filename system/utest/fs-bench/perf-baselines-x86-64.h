@@ -0,0 +1,19 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <unittest/perftest.h>
+
+// Expected medians (ns/op) for the metadata profiles on the x86-64 perf
+// builder (NUC, minfs on ramdisk). Initial seeds; re-record with PERF_GATE
+// off on the builder after any intentional change.
+static const perf_baseline_t kPerfBaselines[] = {
+    {"create_storm/create",     500000, 50},
+    {"create_storm/stat",        50000, 50},
+    {"create_storm/unlink",     350000, 50},
+    {"random_io/pwrite",        300000, 50},
+    {"random_io/pread",         150000, 50},
+    {"dir_churn/create+unlink", 900000, 50},
+};
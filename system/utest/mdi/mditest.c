@@ -304,12 +304,47 @@ bool expression_tests(void) {
     END_TEST;
 }
 
+bool find_node_tests(void) {
+    BEGIN_TEST;
+
+    mdi_node_ref_t root, list, child, node;
+    int32_t i32;
+
+    EXPECT_EQ(mdi_init(mdi_data, mdi_length, &root), 0, "mdi_init failed");
+
+    // mdigen appends a lookup index after the tree, which mdi_init should find
+    ASSERT_NEQ(root.index, NULL, "node lookup index missing");
+
+    // lookups below the root go through the index as well
+    EXPECT_EQ(mdi_find_node(&root, MDI_TEST_LIST, &list), 0, "MDI_TEST_LIST not found");
+    EXPECT_EQ(mdi_first_child(&list, &child), 0, "mdi_first_child failed");
+    EXPECT_EQ(mdi_find_node(&child, MDI_TEST_LIST_INT, &node), 0,
+              "MDI_TEST_LIST_INT not found");
+    EXPECT_EQ(mdi_node_int32(&node, &i32), 0, "mdi_node_int32 failed");
+    EXPECT_EQ(i32, 1, "mdi_node_int32 returned wrong value");
+
+    // a node found via the index can still be iterated from
+    EXPECT_EQ(mdi_next_child(&node, &node), 0, "mdi_next_child failed");
+    EXPECT_EQ(mdi_node_type(&node), (uint32_t)MDI_STRING, "expected type MDI_STRING");
+    EXPECT_NEQ(mdi_next_child(&node, &node), 0,
+               "mdi_next_child shouldn't have succeeded");
+
+    // ids that exist elsewhere in the tree must not be found in the wrong list
+    EXPECT_NEQ(mdi_find_node(&root, MDI_TEST_LIST_INT, &node), 0,
+               "mdi_find_node found MDI_TEST_LIST_INT in root list");
+    EXPECT_NEQ(mdi_find_node(&list, MDI_TEST_UINT8, &node), 0,
+               "mdi_find_node found MDI_TEST_UINT8 in MDI_TEST_LIST");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(mdi_tests)
 RUN_TEST(load_mdi);
 RUN_TEST(simple_tests);
 RUN_TEST(array_tests);
 RUN_TEST(anonymous_list_tests);
 RUN_TEST(expression_tests);
+RUN_TEST(find_node_tests);
 END_TEST_CASE(mdi_tests)
 
 int main(int argc, char** argv) {
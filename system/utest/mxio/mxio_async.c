@@ -0,0 +1,128 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
+#include <mxio/async.h>
+#include <unittest/unittest.h>
+
+static const char* test_path = "/tmp/mxio-async-test";
+
+// Wait for a completion packet with |key|, then reap one completion.
+static bool await_completion(mx_handle_t port, uint64_t key,
+                             mxio_aio_t* aio, mxio_aio_result_t* result) {
+    mx_status_t r;
+    for (;;) {
+        mx_port_packet_t packet;
+        ASSERT_EQ(mx_port_wait(port, MX_TIME_INFINITE, &packet,
+                               sizeof(packet)), MX_OK, "port wait failed");
+        ASSERT_EQ(packet.key, key, "unexpected packet key");
+        // A repeating wait can queue more packets than completions;
+        // just go back to waiting if nothing is ready yet.
+        if ((r = mxio_aio_complete(aio, result)) != MX_ERR_SHOULD_WAIT) {
+            break;
+        }
+    }
+    ASSERT_EQ(r, MX_OK, "completion failed");
+    return true;
+}
+
+bool async_read_write_test(void) {
+    BEGIN_TEST;
+
+    int fd = open(test_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GT(fd, 0, "could not create test file");
+
+    mx_handle_t port;
+    ASSERT_EQ(mx_port_create(0u, &port), MX_OK, "");
+
+    mxio_aio_t* aio;
+    ASSERT_EQ(mxio_aio_create(fd, port, 1u, &aio), MX_OK, "");
+
+    char wbuf[256];
+    memset(wbuf, 0xab, sizeof(wbuf));
+    ASSERT_EQ(mxio_aio_write_at(aio, 100u, wbuf, sizeof(wbuf), 0), MX_OK, "");
+
+    mxio_aio_result_t result;
+    ASSERT_TRUE(await_completion(port, 1u, aio, &result), "");
+    EXPECT_EQ(result.key, 100u, "");
+    EXPECT_EQ(result.status, MX_OK, "");
+    EXPECT_EQ(result.actual, sizeof(wbuf), "");
+
+    char rbuf[256];
+    memset(rbuf, 0, sizeof(rbuf));
+    ASSERT_EQ(mxio_aio_read_at(aio, 101u, rbuf, sizeof(rbuf), 0), MX_OK, "");
+
+    ASSERT_TRUE(await_completion(port, 1u, aio, &result), "");
+    EXPECT_EQ(result.key, 101u, "");
+    EXPECT_EQ(result.status, MX_OK, "");
+    EXPECT_EQ(result.actual, sizeof(rbuf), "");
+    EXPECT_EQ(memcmp(wbuf, rbuf, sizeof(rbuf)), 0, "read back wrong data");
+
+    // With nothing outstanding there is nothing to complete.
+    EXPECT_EQ(mxio_aio_complete(aio, &result), MX_ERR_SHOULD_WAIT, "");
+
+    mxio_aio_destroy(aio);
+    EXPECT_EQ(mx_handle_close(port), MX_OK, "");
+    close(fd);
+    unlink(test_path);
+
+    END_TEST;
+}
+
+bool async_open_test(void) {
+    BEGIN_TEST;
+
+    int fd = open(test_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GT(fd, 0, "could not create test file");
+    const char data[] = "async open test data";
+    ASSERT_EQ(write(fd, data, sizeof(data)), (ssize_t)sizeof(data), "");
+    close(fd);
+
+    int dirfd = open("/tmp", O_RDONLY | O_DIRECTORY);
+    ASSERT_GT(dirfd, 0, "could not open /tmp");
+
+    mx_handle_t port;
+    ASSERT_EQ(mx_port_create(0u, &port), MX_OK, "");
+
+    mxio_aio_t* aio;
+    ASSERT_EQ(mxio_aio_create(dirfd, port, 2u, &aio), MX_OK, "");
+
+    ASSERT_EQ(mxio_aio_open(aio, 200u, "mxio-async-test", O_RDWR, 0), MX_OK, "");
+
+    mxio_aio_result_t result;
+    ASSERT_TRUE(await_completion(port, 2u, aio, &result), "");
+    EXPECT_EQ(result.key, 200u, "");
+    EXPECT_EQ(result.status, MX_OK, "");
+    ASSERT_GT(result.fd, 0, "open completion returned no fd");
+
+    char rbuf[sizeof(data)];
+    EXPECT_EQ(read(result.fd, rbuf, sizeof(rbuf)), (ssize_t)sizeof(rbuf), "");
+    EXPECT_EQ(memcmp(data, rbuf, sizeof(rbuf)), 0, "read back wrong data");
+    close(result.fd);
+
+    // An open that cannot succeed completes with an error, not a hang.
+    ASSERT_EQ(mxio_aio_open(aio, 201u, "does-not-exist", O_RDONLY, 0), MX_OK, "");
+    ASSERT_TRUE(await_completion(port, 2u, aio, &result), "");
+    EXPECT_EQ(result.key, 201u, "");
+    EXPECT_LT(result.status, MX_OK, "");
+    EXPECT_EQ(result.fd, -1, "");
+
+    mxio_aio_destroy(aio);
+    EXPECT_EQ(mx_handle_close(port), MX_OK, "");
+    close(dirfd);
+    unlink(test_path);
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(mxio_async_test)
+RUN_TEST(async_read_write_test)
+RUN_TEST(async_open_test)
+END_TEST_CASE(mxio_async_test)
@@ -0,0 +1,119 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <mxtl/borrowed.h>
+#include <mxtl/ref_counted.h>
+#include <mxtl/ref_ptr.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+class RefCallCounter {
+public:
+    void AddRef() { add_ref_calls_++; }
+    bool Release() {
+        release_calls_++;
+        return false;
+    }
+    void Adopt() {}
+
+    int add_ref_calls() const { return add_ref_calls_; }
+    int release_calls() const { return release_calls_; }
+
+private:
+    int add_ref_calls_ = 0;
+    int release_calls_ = 0;
+};
+
+static bool borrowed_is_free_test() {
+    BEGIN_TEST;
+
+    RefCallCounter counter;
+    mxtl::RefPtr<RefCallCounter> ptr = mxtl::AdoptRef(&counter);
+
+    // Borrowing, copying the borrow, and dropping it must never touch
+    // the refcount.
+    {
+        mxtl::Borrowed<RefCallCounter> borrowed = ptr;
+        mxtl::Borrowed<RefCallCounter> copy = borrowed;
+        EXPECT_EQ(ptr.get(), borrowed.get(), "");
+        EXPECT_EQ(ptr.get(), copy.get(), "");
+        EXPECT_EQ(0, counter.add_ref_calls(), "");
+        EXPECT_EQ(0, counter.release_calls(), "");
+    }
+    EXPECT_EQ(0, counter.add_ref_calls(), "");
+    EXPECT_EQ(0, counter.release_calls(), "");
+
+    // CopyRef is the explicit escalation to ownership.
+    {
+        mxtl::Borrowed<RefCallCounter> borrowed = ptr;
+        mxtl::RefPtr<RefCallCounter> owned = borrowed.CopyRef();
+        EXPECT_EQ(ptr.get(), owned.get(), "");
+        EXPECT_EQ(1, counter.add_ref_calls(), "");
+    }
+    EXPECT_EQ(1, counter.release_calls(), "");
+
+    // Leak the adopted reference; counter lives on the stack.
+    __UNUSED auto leaked = ptr.leak_ref();
+
+    END_TEST;
+}
+
+static bool borrowed_access_test() {
+    BEGIN_TEST;
+
+    RefCallCounter counter;
+    mxtl::RefPtr<RefCallCounter> ptr = mxtl::AdoptRef(&counter);
+
+    mxtl::Borrowed<RefCallCounter> borrowed = mxtl::Borrow(ptr);
+    EXPECT_TRUE(static_cast<bool>(borrowed), "");
+    EXPECT_EQ(&counter, borrowed.get(), "");
+    EXPECT_EQ(0, borrowed->add_ref_calls(), "");
+    EXPECT_EQ(0, (*borrowed).release_calls(), "");
+    EXPECT_TRUE(borrowed == mxtl::Borrow(ptr), "");
+
+    mxtl::Borrowed<RefCallCounter> null_borrow;
+    EXPECT_FALSE(static_cast<bool>(null_borrow), "");
+    EXPECT_NULL(null_borrow.get(), "");
+    EXPECT_TRUE(borrowed != null_borrow, "");
+
+    __UNUSED auto leaked = ptr.leak_ref();
+
+    END_TEST;
+}
+
+namespace upcasting {
+
+class A : public mxtl::RefCounted<A> {
+public:
+    virtual ~A() {}
+};
+
+class B : public A {};
+
+static bool borrowed_upcast_test() {
+    BEGIN_TEST;
+
+    mxtl::RefPtr<B> derived = mxtl::AdoptRef(new B());
+
+    mxtl::Borrowed<B> borrowed_derived = derived;
+    mxtl::Borrowed<A> borrowed_base = borrowed_derived;
+    EXPECT_EQ(static_cast<A*>(derived.get()), borrowed_base.get(), "");
+
+    // Borrowing a RefPtr<B> as Borrowed<A> directly also works.
+    mxtl::Borrowed<A> also_base = derived;
+    EXPECT_EQ(borrowed_base.get(), also_base.get(), "");
+
+    END_TEST;
+}
+
+} // namespace upcasting
+
+} // namespace
+
+BEGIN_TEST_CASE(borrowed_tests)
+RUN_NAMED_TEST("Borrowed does not touch the refcount", borrowed_is_free_test)
+RUN_NAMED_TEST("Borrowed access", borrowed_access_test)
+RUN_NAMED_TEST("Borrowed upcast", upcasting::borrowed_upcast_test)
+END_TEST_CASE(borrowed_tests);
@@ -0,0 +1,380 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <unittest/unittest.h>
+#include <mxtl/tests/lfsr.h>
+#include <mxtl/flat_hash_map.h>
+#include <mxtl/unique_ptr.h>
+
+namespace mxtl {
+namespace tests {
+namespace {
+
+// Different container classes for the types of values which should be
+// tested within a map (raw types, structs, unique pointers), mirroring
+// the traits used by the Vector tests.
+
+using KeyType = size_t;
+using BaseType = size_t;
+
+struct TestValueBase {
+    DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(TestValueBase);
+    TestValueBase() : alive_(false), val_(0) {}
+    explicit TestValueBase(BaseType val) : alive_(true), val_(val) { ++live_obj_count_; }
+    TestValueBase(TestValueBase&& r) : alive_(r.alive_), val_(r.val_) { r.alive_ = false; }
+    TestValueBase& operator=(TestValueBase&& r) {
+        val_ = r.val_;
+        alive_ = r.alive_;
+        r.alive_ = false;
+        return *this;
+    }
+    ~TestValueBase() {
+        if (alive_) {
+            --live_obj_count_;
+        }
+    }
+
+    BaseType value() const { return val_; }
+    static size_t live_obj_count() { return live_obj_count_; }
+
+    bool alive_;
+    BaseType val_;
+
+    static size_t live_obj_count_;
+};
+
+size_t TestValueBase::live_obj_count_ = 0;
+
+struct BaseValueTraits {
+    using ValueType = BaseType;
+    static ValueType Create(BaseType val) { return val; }
+    static BaseType Base(const ValueType& v) { return v; }
+    // We have no way of managing the "live count" of raw types, so we don't.
+    static bool CheckLiveCount(size_t expected) { return true; }
+};
+
+struct StructValueTraits {
+    using ValueType = TestValueBase;
+    static ValueType Create(BaseType val) { return TestValueBase(val); }
+    static BaseType Base(const ValueType& v) { return v.value(); }
+    static bool CheckLiveCount(size_t expected) {
+        return TestValueBase::live_obj_count() == expected;
+    }
+};
+
+struct UniquePtrValueTraits {
+    using ValueType = mxtl::unique_ptr<TestValueBase>;
+
+    static ValueType Create(BaseType val) {
+        AllocChecker ac;
+        ValueType ptr(new (&ac) TestValueBase(val));
+        MX_ASSERT(ac.check());
+        return ptr;
+    }
+    static BaseType Base(const ValueType& v) { return v->value(); }
+    static bool CheckLiveCount(size_t expected) {
+        return TestValueBase::live_obj_count() == expected;
+    }
+};
+
+// Helper classes
+
+struct KeyGenerator {
+    constexpr static KeyType seed = 0xa2328b73e323fd0f;
+    KeyType NextKey() { return key_lfsr_.GetNext(); }
+    void Reset() { key_lfsr_.SetCore(seed); }
+    Lfsr<KeyType> key_lfsr_ = Lfsr<KeyType>(seed);
+};
+
+struct CountedAllocatorTraits : public DefaultAllocatorTraits {
+    static void* Allocate(size_t size) {
+        allocation_count++;
+        return DefaultAllocatorTraits::Allocate(size);
+    }
+    static size_t allocation_count;
+};
+
+size_t CountedAllocatorTraits::allocation_count = 0;
+
+struct FailingAllocatorTraits {
+    static void* Allocate(size_t size) { return nullptr; }
+    static void Deallocate(void* object) { return; }
+};
+
+// Actual tests
+
+template <typename ValueTraits, size_t size>
+bool flat_hash_map_test_insert_find() {
+    using ValueType = typename ValueTraits::ValueType;
+
+    BEGIN_TEST;
+
+    KeyGenerator gen;
+
+    {
+        mxtl::FlatHashMap<KeyType, ValueType> map;
+        ASSERT_TRUE(map.is_empty(), "");
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_TRUE(ValueTraits::CheckLiveCount(i), "");
+            KeyType key = gen.NextKey();
+            ASSERT_TRUE(map.insert(key, ValueTraits::Create(key + 1)), "");
+        }
+        ASSERT_EQ(map.size(), size, "");
+        ASSERT_TRUE(ValueTraits::CheckLiveCount(size), "");
+
+        // Every key maps to its value; unknown keys are absent.
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ValueType* value = map.find(key);
+            ASSERT_NONNULL(value, "");
+            ASSERT_EQ(ValueTraits::Base(*value), key + 1, "");
+            ASSERT_NULL(map.find(~key), "");
+        }
+
+        // Inserting an existing key replaces its value without growing
+        // the map.
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_TRUE(map.insert(key, ValueTraits::Create(key + 2)), "");
+        }
+        ASSERT_EQ(map.size(), size, "");
+        ASSERT_TRUE(ValueTraits::CheckLiveCount(size), "");
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ValueType* value = map.find(key);
+            ASSERT_NONNULL(value, "");
+            ASSERT_EQ(ValueTraits::Base(*value), key + 2, "");
+        }
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+template <typename ValueTraits, size_t size>
+bool flat_hash_map_test_erase() {
+    using ValueType = typename ValueTraits::ValueType;
+
+    BEGIN_TEST;
+
+    KeyGenerator gen;
+
+    {
+        mxtl::FlatHashMap<KeyType, ValueType> map;
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_TRUE(map.insert(key, ValueTraits::Create(key + 1)), "");
+        }
+
+        // Erase every other entry; erasing again fails.
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            if ((i % 2) == 0) {
+                ASSERT_TRUE(map.erase(key), "");
+                ASSERT_FALSE(map.erase(key), "");
+            }
+        }
+        ASSERT_EQ(map.size(), size - ((size + 1) / 2), "");
+        ASSERT_TRUE(ValueTraits::CheckLiveCount(map.size()), "");
+
+        // The survivors are intact.
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ValueType* value = map.find(key);
+            if ((i % 2) == 0) {
+                ASSERT_NULL(value, "");
+            } else {
+                ASSERT_NONNULL(value, "");
+                ASSERT_EQ(ValueTraits::Base(*value), key + 1, "");
+            }
+        }
+
+        // Drain the rest.
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_EQ(map.erase(key), (i % 2) != 0, "");
+        }
+        ASSERT_TRUE(map.is_empty(), "");
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+template <typename ValueTraits, size_t size>
+bool flat_hash_map_test_iterator() {
+    using ValueType = typename ValueTraits::ValueType;
+
+    BEGIN_TEST;
+
+    KeyGenerator gen;
+
+    {
+        mxtl::FlatHashMap<KeyType, ValueType> map;
+        KeyType key_sum = 0;
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            key_sum += key;
+            ASSERT_TRUE(map.insert(key, ValueTraits::Create(key + 1)), "");
+        }
+
+        // Iteration visits every entry exactly once, in no particular
+        // order.
+        size_t visited = 0;
+        KeyType visited_sum = 0;
+        for (auto& entry : map) {
+            ASSERT_EQ(ValueTraits::Base(entry.value), entry.key + 1, "");
+            visited_sum += entry.key;
+            visited++;
+        }
+        ASSERT_EQ(visited, size, "");
+        ASSERT_EQ(visited_sum, key_sum, "");
+
+        // Same through a const iteration.
+        visited = 0;
+        const auto* cmap = &map;
+        for (const auto& entry : *cmap) {
+            ASSERT_EQ(ValueTraits::Base(entry.value), entry.key + 1, "");
+            visited++;
+        }
+        ASSERT_EQ(visited, size, "");
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+template <typename ValueTraits, size_t size>
+bool flat_hash_map_test_move() {
+    using ValueType = typename ValueTraits::ValueType;
+
+    BEGIN_TEST;
+
+    KeyGenerator gen;
+
+    // Test move constructor
+    {
+        mxtl::FlatHashMap<KeyType, ValueType> mapA;
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_TRUE(mapA.insert(key, ValueTraits::Create(key + 1)), "");
+        }
+
+        mxtl::FlatHashMap<KeyType, ValueType> mapB(mxtl::move(mapA));
+        ASSERT_TRUE(ValueTraits::CheckLiveCount(size), "");
+        ASSERT_TRUE(mapA.is_empty(), "");
+        ASSERT_EQ(mapB.size(), size, "");
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_NULL(mapA.find(key), "");
+            ASSERT_NONNULL(mapB.find(key), "");
+        }
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    // Test move assignment operator
+    {
+        gen.Reset();
+        mxtl::FlatHashMap<KeyType, ValueType> mapA;
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_TRUE(mapA.insert(key, ValueTraits::Create(key + 1)), "");
+        }
+
+        mxtl::FlatHashMap<KeyType, ValueType> mapB;
+        ASSERT_TRUE(mapB.insert(0, ValueTraits::Create(0)), "");
+        mapB = mxtl::move(mapA);
+        ASSERT_TRUE(ValueTraits::CheckLiveCount(size), "");
+        ASSERT_TRUE(mapA.is_empty(), "");
+        ASSERT_EQ(mapB.size(), size, "");
+        ASSERT_NULL(mapB.find(0), "");
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+template <typename ValueTraits, size_t size>
+bool flat_hash_map_test_reserve() {
+    using ValueType = typename ValueTraits::ValueType;
+
+    BEGIN_TEST;
+
+    KeyGenerator gen;
+
+    CountedAllocatorTraits::allocation_count = 0;
+    {
+        // After a reserve, filling to the reserved count performs no
+        // further allocation.
+        mxtl::FlatHashMap<KeyType, ValueType,
+                          DefaultFlatHashTraits<KeyType>,
+                          CountedAllocatorTraits> map;
+        ASSERT_TRUE(map.reserve(size), "");
+        ASSERT_EQ(CountedAllocatorTraits::allocation_count, 1, "");
+        for (size_t i = 0; i < size; i++) {
+            KeyType key = gen.NextKey();
+            ASSERT_TRUE(map.insert(key, ValueTraits::Create(key + 1)), "");
+        }
+        ASSERT_EQ(CountedAllocatorTraits::allocation_count, 1, "");
+        ASSERT_EQ(map.size(), size, "");
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+template <typename ValueTraits, size_t size>
+bool flat_hash_map_test_allocation_failure() {
+    using ValueType = typename ValueTraits::ValueType;
+
+    BEGIN_TEST;
+
+    KeyGenerator gen;
+
+    {
+        mxtl::FlatHashMap<KeyType, ValueType,
+                          DefaultFlatHashTraits<KeyType>,
+                          FailingAllocatorTraits> map;
+        ASSERT_FALSE(map.reserve(size), "");
+        ASSERT_FALSE(map.insert(gen.NextKey(), ValueTraits::Create(1)), "");
+        ASSERT_TRUE(map.is_empty(), "");
+    }
+    ASSERT_TRUE(ValueTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+}  // namespace anonymous
+
+#define RUN_FHM_FOR_ALL_TRAITS(test_base, test_size)              \
+        RUN_TEST((test_base<BaseValueTraits, test_size>))         \
+        RUN_TEST((test_base<StructValueTraits, test_size>))       \
+        RUN_TEST((test_base<UniquePtrValueTraits, test_size>))
+
+#define RUN_FHM_FOR_ALL(test_base)            \
+        RUN_FHM_FOR_ALL_TRAITS(test_base, 1)  \
+        RUN_FHM_FOR_ALL_TRAITS(test_base, 2)  \
+        RUN_FHM_FOR_ALL_TRAITS(test_base, 10) \
+        RUN_FHM_FOR_ALL_TRAITS(test_base, 32) \
+        RUN_FHM_FOR_ALL_TRAITS(test_base, 64) \
+        RUN_FHM_FOR_ALL_TRAITS(test_base, 100)
+
+BEGIN_TEST_CASE(flat_hash_map_tests)
+RUN_FHM_FOR_ALL(flat_hash_map_test_insert_find)
+RUN_FHM_FOR_ALL(flat_hash_map_test_erase)
+RUN_FHM_FOR_ALL(flat_hash_map_test_iterator)
+RUN_FHM_FOR_ALL(flat_hash_map_test_move)
+RUN_FHM_FOR_ALL(flat_hash_map_test_reserve)
+RUN_FHM_FOR_ALL(flat_hash_map_test_allocation_failure)
+END_TEST_CASE(flat_hash_map_tests)
+
+}  // namespace tests
+}  // namespace mxtl
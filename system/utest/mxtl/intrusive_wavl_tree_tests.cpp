@@ -421,6 +421,120 @@ static bool WAVLBalanceTest() {
     END_TEST;
 }
 
+// Objects and tree types for the order statistic test.  Like the balance
+// test, the tree holds unique pointers with a no-op delete so that the
+// objects (allocated as a single block) may outlive the container.
+class OrderStatTestObj;
+using OrderStatKeyType = uint64_t;
+using OrderStatObjPtr  = unique_ptr<OrderStatTestObj>;
+using OrderStatTree    = WAVLTree<OrderStatKeyType,
+                                  OrderStatObjPtr,
+                                  DefaultKeyedObjectTraits<OrderStatKeyType, OrderStatTestObj>,
+                                  DefaultWAVLTreeSizedTraits<OrderStatObjPtr>>;
+
+class OrderStatTestObj {
+public:
+    void Init(OrderStatKeyType val) { key_ = val; }
+    OrderStatKeyType GetKey() const { return key_; }
+    bool InContainer() const { return wavl_sized_node_state_.InContainer(); }
+
+private:
+    friend DefaultWAVLTreeSizedTraits<OrderStatObjPtr>;
+
+    static void operator delete(void* ptr) {
+        // Deliberate no-op
+    }
+    friend class mxtl::unique_ptr<OrderStatTestObj[]>;
+    friend class mxtl::unique_ptr<OrderStatTestObj>;
+
+    OrderStatKeyType key_;
+    WAVLTreeSizedNodeState<OrderStatObjPtr> wavl_sized_node_state_;
+};
+
+static constexpr size_t kOrderStatTestSize = 1024;
+
+// Verify that every element of the tree can be recovered by select(), in
+// order, and that rank() inverts select() as well as properly counting the
+// elements below the keys between and beyond the tree's elements.
+static bool VerifyOrderStatistics(const OrderStatTree& tree) {
+    BEGIN_TEST;
+
+    static_assert(OrderStatTree::SupportsOrderStatistics,
+                  "Tree with sized node state must support order statistics!");
+
+    size_t ndx = 0;
+    for (const auto& obj : tree) {
+        auto iter = tree.select(ndx);
+        ASSERT_TRUE(iter.IsValid(), "");
+        EXPECT_EQ(obj.GetKey(), iter->GetKey(), "select() does not match iteration order!");
+
+        EXPECT_EQ(ndx,     tree.rank(obj.GetKey()),     "");
+        EXPECT_EQ(ndx + 1, tree.rank(obj.GetKey() + 1), "");
+        ++ndx;
+    }
+
+    EXPECT_FALSE(tree.select(tree.size()).IsValid(),
+                 "select(size()) should return end()");
+    EXPECT_EQ(0u, tree.rank(0u), "");
+
+    END_TEST;
+}
+
+static bool WAVLOrderStatTest() {
+    BEGIN_TEST;
+
+    unique_ptr<OrderStatTestObj[]> objects;
+    OrderStatTree tree;
+
+    {
+        AllocChecker ac;
+        objects.reset(new (&ac) OrderStatTestObj[kOrderStatTestSize]);
+        ASSERT_TRUE(ac.check(), "Failed to allocate test objects!");
+    }
+
+    // Give the objects keys with gaps between them (so rank can be probed
+    // between elements) and insert them in a pseudo-random order.
+    Lfsr<OrderStatKeyType> rng;
+    rng.SetCore(0x4c3e2d1b0a594837u);
+
+    for (size_t i = 0; i < kOrderStatTestSize; ++i)
+        objects[i].Init((i * 3) + 1);
+
+    for (size_t i = kOrderStatTestSize - 1; i > 1; --i) {
+        size_t ndx = static_cast<size_t>(rng.GetNext()) % i;
+        if (ndx != i) {
+            OrderStatKeyType tmp = objects[i].GetKey();
+            objects[i].Init(objects[ndx].GetKey());
+            objects[ndx].Init(tmp);
+        }
+    }
+
+    for (size_t i = 0; i < kOrderStatTestSize; ++i) {
+        ASSERT_TRUE(tree.insert_or_find(OrderStatObjPtr(&objects[i])), "");
+        ASSERT_TRUE(WAVLTreeChecker::SanityCheck(tree), "");
+    }
+
+    ASSERT_TRUE(VerifyOrderStatistics(tree), "");
+
+    // Erase every other element (by rank) and make sure that the statistics
+    // hold up across erase operations as well.
+    for (size_t i = 0; i < (kOrderStatTestSize >> 1); ++i) {
+        auto iter = tree.select(i);
+        ASSERT_TRUE(iter.IsValid(), "");
+        ASSERT_NONNULL(tree.erase(iter).release(), "");
+        ASSERT_TRUE(WAVLTreeChecker::SanityCheck(tree), "");
+    }
+
+    ASSERT_EQ(kOrderStatTestSize >> 1, tree.size(), "");
+    ASSERT_TRUE(VerifyOrderStatistics(tree), "");
+
+    // Finally, empty the tree back out.
+    while (!tree.is_empty())
+        ASSERT_NONNULL(tree.pop_front().release(), "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(wavl_tree_tests)
 //////////////////////////////////////////
 // General container specific tests.
@@ -540,6 +654,7 @@ RUN_NAMED_TEST("LowerBound (RefPtr)",            RPTE::LowerBoundTest)
 // WAVLTree specific tests.
 ////////////////////////////
 RUN_NAMED_TEST("BalanceTest", WAVLBalanceTest)
+RUN_NAMED_TEST("OrderStatTest", WAVLOrderStatTest)
 
 END_TEST_CASE(wavl_tree_tests);
 
@@ -189,6 +189,42 @@ struct RefPtrTestTraits {
     static constexpr size_t MaxAllocs(size_t slabs) { return AllocatorType::AllocsPerSlab * slabs; }
 };
 
+// Cache policy used by the cached allocator test flavors.  The "current"
+// cache is under test control so that the single-threaded tests behave
+// deterministically.
+struct TestCacheTraits {
+    static constexpr size_t NUM_CACHES = 4;
+    static constexpr size_t BATCH_SIZE = 4;
+    static size_t CurrentCache() { return current_cache_; }
+    static size_t current_cache_;
+};
+size_t TestCacheTraits::current_cache_;
+
+template <typename LockType>
+struct CachedUnmanagedTestTraits {
+    class ObjType;
+    using PtrType       = ObjType*;
+    using AllocTraits   = mxtl::SlabAllocatorTraits<PtrType, 1024, LockType,
+                                                    mxtl::SlabAllocatorFlavor::INSTANCED,
+                                                    TestCacheTraits>;
+    using AllocatorType = mxtl::SlabAllocator<AllocTraits>;
+    using RefList       = mxtl::DoublyLinkedList<PtrType>;
+
+    class ObjType : public TestBase,
+                    public mxtl::SlabAllocated<AllocTraits>,
+                    public mxtl::DoublyLinkedListable<PtrType> {
+    public:
+        ObjType()                                     : TestBase() { }
+        explicit ObjType(const size_t& val)           : TestBase(val) { }
+        explicit ObjType(size_t&& val)                : TestBase(mxtl::move(val)) { }
+        explicit ObjType(const size_t& a, size_t&& b) : TestBase(a, mxtl::move(b)) { }
+    };
+
+    static constexpr size_t MaxSlabs  = 4;
+    static constexpr bool   IsManaged = false;
+    static constexpr size_t MaxAllocs(size_t slabs) { return AllocatorType::AllocsPerSlab * slabs; }
+};
+
 template <typename Traits>
 bool do_slab_test(typename Traits::AllocatorType& allocator, size_t test_allocs) {
     BEGIN_TEST;
@@ -428,6 +464,64 @@ bool static_slab_test() {
 
     END_TEST;
 }
+
+// Exercise the cache layer across cache boundaries: objects allocated while
+// one cache is current may be freed while another is current, overflowing
+// caches hand batches back to the core allocator, and the allocator's
+// destructor drains whatever is still parked in the caches.
+template <typename Traits>
+bool cached_slab_test() {
+    BEGIN_TEST;
+
+    static constexpr size_t TEST_ALLOCS = 3 * TestCacheTraits::BATCH_SIZE;
+
+    TestBase::Reset();
+    TestCacheTraits::current_cache_ = 0;
+
+    {
+        typename Traits::AllocatorType allocator(Traits::MaxSlabs);
+        typename Traits::RefList ref_list;
+
+        // Allocate a few batches worth of objects while cache 0 is current.
+        for (size_t i = 0; i < TEST_ALLOCS; ++i) {
+            typename Traits::PtrType ptr = allocator.New();
+            ASSERT_NONNULL(ptr, "Allocation failed when it should not have!");
+            ref_list.push_front(mxtl::move(ptr));
+        }
+        EXPECT_EQ(TEST_ALLOCS, TestBase::allocated_obj_count(), "");
+
+        // Free all of them while cache 1 is current, forcing it to overflow
+        // and hand batches back to the core allocator.
+        TestCacheTraits::current_cache_ = 1;
+        while (!ref_list.is_empty())
+            delete ref_list.pop_front();
+        EXPECT_EQ(0u, TestBase::allocated_obj_count(), "");
+
+        // Allocate the same number again, rotating through every cache, then
+        // free them all rotating the other way.
+        for (size_t i = 0; i < TEST_ALLOCS; ++i) {
+            TestCacheTraits::current_cache_ = i % TestCacheTraits::NUM_CACHES;
+            typename Traits::PtrType ptr = allocator.New();
+            ASSERT_NONNULL(ptr, "Allocation failed when it should not have!");
+            ref_list.push_front(mxtl::move(ptr));
+        }
+        EXPECT_EQ(TEST_ALLOCS, TestBase::allocated_obj_count(), "");
+
+        size_t i = 0;
+        while (!ref_list.is_empty()) {
+            TestCacheTraits::current_cache_ =
+                (TestCacheTraits::NUM_CACHES - 1) - (i++ % TestCacheTraits::NUM_CACHES);
+            delete ref_list.pop_front();
+        }
+        EXPECT_EQ(0u, TestBase::allocated_obj_count(), "");
+
+        // Destruction drains the caches; the allocator's internal leak
+        // accounting asserts if anything went missing.
+    }
+
+    TestCacheTraits::current_cache_ = 0;
+    END_TEST;
+}
 }  // anon namespace
 
 using MutexLock = ::mxtl::Mutex;
@@ -456,6 +550,10 @@ RUN_NAMED_TEST("UniquePtr Multi Slab  (unlock)", (slab_test<UniquePtrTestTraits<
 RUN_NAMED_TEST("RefPtr Single Slab    (unlock)", (slab_test<RefPtrTestTraits<NullLock>, 1>))
 RUN_NAMED_TEST("RefPtr Multi Slab     (unlock)", (slab_test<RefPtrTestTraits<NullLock>>))
 
+RUN_NAMED_TEST("Cached Unmanaged Single Slab (mutex)", (slab_test<CachedUnmanagedTestTraits<MutexLock>, 1>))
+RUN_NAMED_TEST("Cached Unmanaged Multi Slab  (mutex)", (slab_test<CachedUnmanagedTestTraits<MutexLock>>))
+RUN_NAMED_TEST("Cached Cross-Cache           (mutex)", (cached_slab_test<CachedUnmanagedTestTraits<MutexLock>>))
+
 RUN_NAMED_TEST("Manual Delete Unmanaged (mutex)",
               (slab_test<UnmanagedTestTraits<MutexLock, mxtl::SlabAllocatorFlavor::MANUAL_DELETE>>))
 RUN_NAMED_TEST("Manual Delete Unmanaged (unlock)",
@@ -467,6 +467,94 @@ bool vector_test_iterator() {
     END_TEST;
 }
 
+template <typename ContainerTraits, size_t size>
+bool vector_test_inline_storage() {
+    using ContainerType = typename ContainerTraits::ContainerType;
+    using VectorType = mxtl::InlineVector<ContainerType, size, CountedAllocatorTraits>;
+
+    BEGIN_TEST;
+
+    Generator<ContainerTraits> gen;
+
+    CountedAllocatorTraits::allocation_count = 0;
+    {
+        // Filling the inline storage should not touch the allocator.
+        VectorType vector;
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_TRUE(ContainerTraits::CheckLiveCount(i), "");
+            ASSERT_TRUE(vector.push_back(gen.NextContainer()), "");
+        }
+        ASSERT_EQ(CountedAllocatorTraits::allocation_count, 0, "");
+        ASSERT_EQ(vector.size(), size, "");
+        ASSERT_EQ(vector.capacity(), size, "");
+
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_EQ(ContainerTraits::Base(vector[i]), gen.NextBase(), "");
+        }
+
+        // Moving an inline vector moves the elements, not the storage.
+        VectorType moved(mxtl::move(vector));
+        ASSERT_EQ(CountedAllocatorTraits::allocation_count, 0, "");
+        ASSERT_EQ(vector.size(), 0, "");
+        ASSERT_EQ(moved.size(), size, "");
+        ASSERT_TRUE(ContainerTraits::CheckLiveCount(size), "");
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_EQ(ContainerTraits::Base(moved[i]), gen.NextBase(), "");
+        }
+
+        // Growing past the inline storage falls back to the allocator.
+        ASSERT_TRUE(moved.push_back(ContainerTraits::Create(size)), "");
+        ASSERT_EQ(CountedAllocatorTraits::allocation_count, 1, "");
+        ASSERT_EQ(moved.size(), size + 1, "");
+        ASSERT_TRUE(ContainerTraits::CheckLiveCount(size + 1), "");
+        gen.Reset();
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_EQ(ContainerTraits::Base(moved[i]), gen.NextBase(), "");
+        }
+        ASSERT_EQ(ContainerTraits::Base(moved[size]), size, "");
+
+        // An emptied vector re-adopts its inline storage.
+        moved.reset();
+        ASSERT_TRUE(ContainerTraits::CheckLiveCount(0), "");
+        ASSERT_TRUE(moved.push_back(ContainerTraits::Create(0)), "");
+        ASSERT_EQ(CountedAllocatorTraits::allocation_count, 1, "");
+        ASSERT_EQ(ContainerTraits::Base(moved[0]), 0u, "");
+        ASSERT_TRUE(ContainerTraits::CheckLiveCount(1), "");
+    }
+    ASSERT_TRUE(ContainerTraits::CheckLiveCount(0), "");
+
+    END_TEST;
+}
+
+template <size_t size>
+bool vector_test_resize_uninitialized() {
+    BEGIN_TEST;
+
+    {
+        mxtl::Vector<BaseType> vector;
+        // Freshly exposed slots read as zero.
+        ASSERT_TRUE(vector.resize_uninitialized(size), "");
+        ASSERT_EQ(vector.size(), size, "");
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_EQ(vector[i], 0u, "");
+            vector[i] = i + 1;
+        }
+
+        // Shrinking and re-growing within capacity performs no
+        // per-element work, so the old contents show through.
+        ASSERT_TRUE(vector.resize_uninitialized(0), "");
+        ASSERT_TRUE(vector.is_empty(), "");
+        ASSERT_TRUE(vector.resize_uninitialized(size), "");
+        for (size_t i = 0; i < size; i++) {
+            ASSERT_EQ(vector[i], i + 1, "");
+        }
+    }
+
+    END_TEST;
+}
+
 }  // namespace anonymous
 
 #define RUN_FOR_ALL_TRAITS(test_base, test_size)              \
@@ -492,6 +580,10 @@ RUN_FOR_ALL(vector_test_allocation_failure)
 RUN_FOR_ALL(vector_test_move)
 RUN_FOR_ALL(vector_test_swap)
 RUN_FOR_ALL(vector_test_iterator)
+RUN_FOR_ALL(vector_test_inline_storage)
+RUN_TEST((vector_test_resize_uninitialized<1>))
+RUN_TEST((vector_test_resize_uninitialized<10>))
+RUN_TEST((vector_test_resize_uninitialized<100>))
 END_TEST_CASE(vector_tests)
 
 }  // namespace tests
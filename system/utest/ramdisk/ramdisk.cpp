@@ -200,6 +200,85 @@ bool ramdisk_test_bad_requests(void) {
     END_TEST;
 }
 
+bool ramdisk_test_trim(void) {
+    uint8_t buf[PAGE_SIZE];
+    uint8_t out[PAGE_SIZE];
+
+    BEGIN_TEST;
+    int fd = get_ramdisk(PAGE_SIZE, 512);
+    memset(buf, 'a', sizeof(buf));
+
+    // Fill the first three pages of the disk
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_EQ(write(fd, buf, sizeof(buf)), (ssize_t) sizeof(buf), "");
+    }
+
+    // Trim the middle page; its backing memory should be released
+    ramdisk_ioctl_trim_t trim;
+    trim.offset = PAGE_SIZE;
+    trim.length = PAGE_SIZE;
+    ASSERT_GE(ioctl_ramdisk_trim(fd, &trim), 0, "Could not trim ramdisk");
+
+    // The trimmed page reads back as zeros; its neighbors are untouched
+    ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0, "");
+    ASSERT_EQ(read(fd, out, sizeof(out)), (ssize_t) sizeof(out), "");
+    ASSERT_EQ(memcmp(out, buf, sizeof(out)), 0, "");
+    ASSERT_EQ(read(fd, out, sizeof(out)), (ssize_t) sizeof(out), "");
+    uint8_t zero[PAGE_SIZE];
+    memset(zero, 0, sizeof(zero));
+    ASSERT_EQ(memcmp(out, zero, sizeof(out)), 0, "Trimmed range not zeroed");
+    ASSERT_EQ(read(fd, out, sizeof(out)), (ssize_t) sizeof(out), "");
+    ASSERT_EQ(memcmp(out, buf, sizeof(out)), 0, "");
+
+    // A trimmed range may be rewritten
+    ASSERT_EQ(lseek(fd, PAGE_SIZE, SEEK_SET), PAGE_SIZE, "");
+    ASSERT_EQ(write(fd, buf, sizeof(buf)), (ssize_t) sizeof(buf), "");
+
+    // Unaligned trims are rejected
+    trim.offset = 1;
+    trim.length = PAGE_SIZE;
+    ASSERT_LT(ioctl_ramdisk_trim(fd, &trim), 0, "Expected error trimming unaligned offset");
+    trim.offset = 0;
+    trim.length = PAGE_SIZE - 1;
+    ASSERT_LT(ioctl_ramdisk_trim(fd, &trim), 0, "Expected error trimming unaligned length");
+
+    ASSERT_GE(ioctl_ramdisk_unlink(fd), 0, "Could not unlink ramdisk device");
+    close(fd);
+    END_TEST;
+}
+
+bool ramdisk_test_get_vmo(void) {
+    uint8_t buf[PAGE_SIZE];
+    uint8_t out[PAGE_SIZE];
+
+    BEGIN_TEST;
+    int fd = get_ramdisk(PAGE_SIZE, 512);
+    memset(buf, 'a', sizeof(buf));
+
+    // Write a page through the block device
+    ASSERT_EQ(write(fd, buf, sizeof(buf)), (ssize_t) sizeof(buf), "");
+
+    // The backing VMO observes the write...
+    mx_handle_t vmo;
+    ssize_t expected = sizeof(vmo);
+    ASSERT_EQ(ioctl_ramdisk_get_vmo(fd, &vmo), expected, "Could not get ramdisk VMO");
+    size_t actual;
+    ASSERT_EQ(mx_vmo_read(vmo, out, 0, sizeof(out), &actual), MX_OK, "");
+    ASSERT_EQ(memcmp(out, buf, sizeof(out)), 0, "VMO does not observe device contents");
+
+    // ... and writes through the VMO are visible to the block device
+    memset(buf, 'b', sizeof(buf));
+    ASSERT_EQ(mx_vmo_write(vmo, buf, 0, sizeof(buf), &actual), MX_OK, "");
+    ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0, "");
+    ASSERT_EQ(read(fd, out, sizeof(out)), (ssize_t) sizeof(out), "");
+    ASSERT_EQ(memcmp(out, buf, sizeof(out)), 0, "Device does not observe VMO contents");
+
+    ASSERT_EQ(mx_handle_close(vmo), MX_OK, "");
+    ASSERT_GE(ioctl_ramdisk_unlink(fd), 0, "Could not unlink ramdisk device");
+    close(fd);
+    END_TEST;
+}
+
 bool ramdisk_test_release_during_access(void) {
     BEGIN_TEST;
     int fd = get_ramdisk(PAGE_SIZE, 512);
@@ -1031,6 +1110,8 @@ RUN_TEST_SMALL(ramdisk_test_simple)
 RUN_TEST_SMALL(ramdisk_test_filesystem)
 RUN_TEST_SMALL(ramdisk_test_rebind)
 RUN_TEST_SMALL(ramdisk_test_bad_requests)
+RUN_TEST_SMALL(ramdisk_test_trim)
+RUN_TEST_SMALL(ramdisk_test_get_vmo)
 RUN_TEST_SMALL(ramdisk_test_release_during_access)
 RUN_TEST_SMALL(ramdisk_test_release_during_fifo_access)
 RUN_TEST_SMALL(ramdisk_test_multiple)
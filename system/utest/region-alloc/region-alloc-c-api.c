@@ -316,9 +316,40 @@ static bool ralloc_subtract_c_api_test(void) {
     END_TEST;
 }
 
+static bool ralloc_bulk_add_c_api_test(void) {
+    BEGIN_TEST;
+
+    // Make a pool and assign it to a new allocator, then add the test
+    // regions in a single batch.
+    ralloc_pool_t* pool;
+    ASSERT_EQ(MX_OK, ralloc_create_pool(REGION_POOL_MAX_SIZE, &pool), "");
+    ASSERT_NONNULL(pool, "");
+
+    ralloc_allocator_t* alloc;
+    ASSERT_EQ(MX_OK, ralloc_create_allocator(&alloc), "");
+    ASSERT_NONNULL(alloc, "");
+    ASSERT_EQ(MX_OK, ralloc_set_region_pool(alloc, pool), "");
+    ralloc_release_pool(pool);
+
+    EXPECT_EQ(MX_OK, ralloc_add_regions(alloc, ALLOC_BY_SIZE_REGIONS,
+                                        countof(ALLOC_BY_SIZE_REGIONS), false), "");
+    EXPECT_EQ(countof(ALLOC_BY_SIZE_REGIONS),
+              ralloc_get_available_region_count(alloc), "");
+
+    // Bad arguments should be rejected.
+    EXPECT_EQ(MX_ERR_INVALID_ARGS, ralloc_add_regions(alloc, NULL, 1, false), "");
+    EXPECT_EQ(MX_ERR_INVALID_ARGS,
+              ralloc_add_regions(NULL, ALLOC_BY_SIZE_REGIONS, 1, false), "");
+
+    ralloc_destroy_allocator(alloc);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(ralloc_c_api_tests)
 RUN_NAMED_TEST("Region Pools (C-API)",   ralloc_pools_c_api_test)
 RUN_NAMED_TEST("Alloc by size (C-API)",  ralloc_by_size_c_api_test)
 RUN_NAMED_TEST("Alloc specific (C-API)", ralloc_specific_c_api_test)
 RUN_NAMED_TEST("Subtract (C-API)",       ralloc_subtract_c_api_test)
+RUN_NAMED_TEST("Bulk add (C-API)",       ralloc_bulk_add_c_api_test)
 END_TEST_CASE(ralloc_c_api_tests)
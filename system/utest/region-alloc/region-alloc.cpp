@@ -235,6 +235,73 @@ static bool ralloc_subtract_test() {
     END_TEST;
 }
 
+static bool ralloc_bulk_add_test() {
+    BEGIN_TEST;
+
+    // Make a pool and attach it to an allocator.  Then add the test regions
+    // to it in a single batch.
+    RegionAllocator alloc(RegionAllocator::RegionPool::Create(REGION_POOL_MAX_SIZE));
+
+    ASSERT_EQ(MX_OK, alloc.AddRegions(ALLOC_BY_SIZE_REGIONS,
+                                      mxtl::count_of(ALLOC_BY_SIZE_REGIONS)), "");
+    EXPECT_EQ(mxtl::count_of(ALLOC_BY_SIZE_REGIONS), alloc.AvailableRegionCount(), "");
+
+    // A batch containing a region which overlaps one of the regions already
+    // added should fail on that region, but keep the regions which preceded
+    // it in the batch.
+    const ralloc_region_t PARTIAL_BATCH[] = {
+        { .base = 0x10000000, .size = 0x1000 },
+        { .base = ALLOC_BY_SIZE_REGIONS[0].base, .size = 0x1000 },  // overlaps
+        { .base = 0x20000000, .size = 0x1000 },
+    };
+    EXPECT_EQ(MX_ERR_INVALID_ARGS,
+              alloc.AddRegions(PARTIAL_BATCH, mxtl::count_of(PARTIAL_BATCH)), "");
+    EXPECT_EQ(mxtl::count_of(ALLOC_BY_SIZE_REGIONS) + 1, alloc.AvailableRegionCount(), "");
+
+    // An empty batch is trivially fine; a null pointer with a non-zero count
+    // is not.
+    EXPECT_EQ(MX_OK, alloc.AddRegions(nullptr, 0), "");
+    EXPECT_EQ(MX_ERR_INVALID_ARGS, alloc.AddRegions(nullptr, 1), "");
+
+    END_TEST;
+}
+
+static bool ralloc_size_index_test() {
+    BEGIN_TEST;
+
+    // Exercise the size-indexed search path for aligned allocations.  Offer a
+    // best-fit region whose base cannot satisfy the alignment, plus a larger
+    // region which can; the allocation must come from the larger one without
+    // disturbing the best-fit region.
+    RegionAllocator alloc(RegionAllocator::RegionPool::Create(REGION_POOL_MAX_SIZE));
+
+    const ralloc_region_t SMALL_MISALIGNED = { .base = 0x1100, .size = 0x1000 };
+    const ralloc_region_t LARGE            = { .base = 0x100100, .size = 0x10000 };
+    ASSERT_EQ(MX_OK, alloc.AddRegion(SMALL_MISALIGNED), "");
+    ASSERT_EQ(MX_OK, alloc.AddRegion(LARGE), "");
+
+    RegionAllocator::Region::UPtr region;
+    ASSERT_EQ(MX_OK, alloc.GetRegion(0x1000, 0x1000, region), "");
+    ASSERT_NONNULL(region, "");
+    EXPECT_TRUE(region_contains_region(&LARGE, region.get()), "");
+    EXPECT_EQ(0u, region->base & 0xFFF, "");
+
+    // The misaligned best-fit region should still be available in one piece
+    // for an unaligned request of the same size.
+    RegionAllocator::Region::UPtr region2;
+    ASSERT_EQ(MX_OK, alloc.GetRegion(0x1000, 1, region2), "");
+    ASSERT_NONNULL(region2, "");
+    EXPECT_TRUE(region_contains_region(&SMALL_MISALIGNED, region2.get()), "");
+
+    // An aligned request which no available region can hold must fail, even
+    // though plenty of unaligned space remains.
+    RegionAllocator::Region::UPtr region3;
+    EXPECT_EQ(MX_ERR_NOT_FOUND, alloc.GetRegion(0x10000, 0x100000, region3), "");
+    EXPECT_NULL(region3, "");
+
+    END_TEST;
+}
+
 } //namespace
 
 BEGIN_TEST_CASE(ralloc_tests)
@@ -243,4 +310,6 @@ RUN_NAMED_TEST("Alloc by size",  ralloc_by_size_test)
 RUN_NAMED_TEST("Alloc specific", ralloc_specific_test)
 RUN_NAMED_TEST("Add/Overlap",    ralloc_add_overlap_test)
 RUN_NAMED_TEST("Subtract",       ralloc_subtract_test)
+RUN_NAMED_TEST("Bulk add",       ralloc_bulk_add_test)
+RUN_NAMED_TEST("Size index",     ralloc_size_index_test)
 END_TEST_CASE(ralloc_tests)
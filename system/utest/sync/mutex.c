@@ -0,0 +1,109 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <threads.h>
+
+#include <magenta/syscalls.h>
+#include <sync/mutex.h>
+#include <unittest/unittest.h>
+
+static bool basic_test(void) {
+    BEGIN_TEST;
+
+    mutex_t mutex = MUTEX_INIT;
+    mutex_lock(&mutex);
+    EXPECT_EQ(mutex_trylock(&mutex), MX_ERR_BAD_STATE,
+              "trylock succeeded on a held mutex");
+    mutex_unlock(&mutex);
+    EXPECT_EQ(mutex_trylock(&mutex), MX_OK,
+              "trylock failed on a free mutex");
+    mutex_unlock(&mutex);
+
+    END_TEST;
+}
+
+#define NUM_THREADS 4
+#define NUM_ITERATIONS 100000
+
+typedef struct {
+    mutex_t mutex;
+    mtx_t mtx;
+    bool use_mtx;
+    int counter;
+} contention_args_t;
+
+static int contention_thread(void* arg) {
+    contention_args_t* args = arg;
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+        if (args->use_mtx) {
+            mtx_lock(&args->mtx);
+            args->counter++;
+            mtx_unlock(&args->mtx);
+        } else {
+            mutex_lock(&args->mutex);
+            args->counter++;
+            mutex_unlock(&args->mutex);
+        }
+    }
+    return 0;
+}
+
+// Hammer a single lock from NUM_THREADS threads with a critical
+// section short enough that spinning should usually win over parking,
+// and report the elapsed time next to mtx_t for comparison.
+static bool run_contention(contention_args_t* args, uint64_t* ticks) {
+    BEGIN_HELPER;
+    thrd_t threads[NUM_THREADS];
+    uint64_t start = mx_ticks_get();
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        int ret = thrd_create(&threads[i], contention_thread, args);
+        ASSERT_EQ(ret, thrd_success, "thrd_create failed");
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        thrd_join(threads[i], NULL);
+    }
+    *ticks = mx_ticks_get() - start;
+    END_HELPER;
+}
+
+static bool contention_test(void) {
+    BEGIN_TEST;
+
+    contention_args_t args = {
+        .mutex = MUTEX_INIT,
+    };
+    mtx_init(&args.mtx, mtx_plain);
+
+    args.use_mtx = false;
+    args.counter = 0;
+    uint64_t mutex_ticks;
+    ASSERT_TRUE(run_contention(&args, &mutex_ticks), "");
+    EXPECT_EQ(args.counter, NUM_THREADS * NUM_ITERATIONS,
+              "increments lost under mutex_t");
+
+    args.use_mtx = true;
+    args.counter = 0;
+    uint64_t mtx_ticks;
+    ASSERT_TRUE(run_contention(&args, &mtx_ticks), "");
+    EXPECT_EQ(args.counter, NUM_THREADS * NUM_ITERATIONS,
+              "increments lost under mtx_t");
+
+    uint64_t ticks_per_msec = mx_ticks_per_second() / 1000;
+    unittest_printf_critical(
+        "\n%d threads x %d iterations: mutex_t [%10lu] msec, mtx_t [%10lu] msec\n",
+        NUM_THREADS, NUM_ITERATIONS,
+        mutex_ticks / ticks_per_msec, mtx_ticks / ticks_per_msec);
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(sync_mutex_tests)
+RUN_TEST(basic_test)
+RUN_TEST(contention_test)
+END_TEST_CASE(sync_mutex_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
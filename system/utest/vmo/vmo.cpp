@@ -91,6 +91,61 @@ bool vmo_read_write_test() {
     END_TEST;
 }
 
+bool vmo_vectored_read_write_test() {
+    BEGIN_TEST;
+
+    mx_status_t status;
+    size_t actual;
+    mx_handle_t vmo;
+
+    const size_t len = PAGE_SIZE * 4;
+    status = mx_vmo_create(len, 0, &vmo);
+    EXPECT_EQ(MX_OK, status, "vm_object_create");
+
+    // scatter two halves of a buffer to non-adjacent pages with one call
+    char buf[128];
+    memset(buf, 0x5a, sizeof(buf));
+    mx_vmo_iovec_t wvec[2] = {
+        {buf, 64, 0},
+        {buf + 64, 64, PAGE_SIZE},
+    };
+    status = mx_vmo_writev(vmo, wvec, 2, &actual);
+    EXPECT_EQ(MX_OK, status, "vm_object_writev");
+    EXPECT_EQ(sizeof(buf), actual, "vm_object_writev");
+
+    // gather them back and make sure the data round-tripped
+    char check[128];
+    memset(check, 0, sizeof(check));
+    mx_vmo_iovec_t rvec[2] = {
+        {check, 64, 0},
+        {check + 64, 64, PAGE_SIZE},
+    };
+    status = mx_vmo_readv(vmo, rvec, 2, &actual);
+    EXPECT_EQ(MX_OK, status, "vm_object_readv");
+    EXPECT_EQ(sizeof(check), actual, "vm_object_readv");
+    EXPECT_BYTES_EQ((uint8_t*)buf, (uint8_t*)check, sizeof(buf), "vectored data");
+
+    // a segment running off the end of the vmo trims the transfer there
+    mx_vmo_iovec_t shortvec[2] = {
+        {check, 64, len - 32},
+        {check + 64, 64, 0},
+    };
+    status = mx_vmo_readv(vmo, shortvec, 2, &actual);
+    EXPECT_EQ(MX_OK, status, "vm_object_readv short");
+    EXPECT_EQ(32u, actual, "vm_object_readv short");
+
+    // oversize and empty vectors are rejected
+    status = mx_vmo_readv(vmo, rvec, MX_VMO_IOVEC_MAX + 1, &actual);
+    EXPECT_EQ(MX_ERR_INVALID_ARGS, status, "oversize vector");
+    status = mx_vmo_readv(vmo, rvec, 0, &actual);
+    EXPECT_EQ(MX_ERR_INVALID_ARGS, status, "empty vector");
+
+    status = mx_handle_close(vmo);
+    EXPECT_EQ(MX_OK, status, "handle_close");
+
+    END_TEST;
+}
+
 bool vmo_map_test() {
     BEGIN_TEST;
 
@@ -1134,6 +1189,7 @@ bool vmo_clone_rights_test() {
 BEGIN_TEST_CASE(vmo_tests)
 RUN_TEST(vmo_create_test);
 RUN_TEST(vmo_read_write_test);
+RUN_TEST(vmo_vectored_read_write_test);
 RUN_TEST(vmo_map_test);
 RUN_TEST(vmo_read_only_map_test);
 RUN_TEST(vmo_resize_test);
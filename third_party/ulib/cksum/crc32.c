@@ -30,11 +30,20 @@
 
 #include "zutil.h"      /* for STDC and FAR definitions */
 
+/* ARMv8 implements this exact polynomial in hardware (the CRC32B/W/X
+   instructions; the CRC32C* forms cover the Castagnoli polynomial,
+   which is not the one used here).  Use it when the compiler is
+   targeting a cpu that has the extension. */
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#  include <arm_acle.h>
+#  include <string.h>
+#  define CRC32_ARMV8
+#endif
+
 #define local static
 
 /* Definitions for doing the crc four data bytes at a time. */
 #if !defined(NOBYFOUR) && defined(Z_U4)
-#error
 #  define BYFOUR
 #endif
 #ifdef BYFOUR
@@ -201,6 +210,37 @@ const z_crc_t FAR * ZEXPORT get_crc_table()
 #define DO1 crc = crc_table[0][((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8)
 #define DO8 DO1; DO1; DO1; DO1; DO1; DO1; DO1; DO1
 
+#ifdef CRC32_ARMV8
+/* ========================================================================= */
+local unsigned long crc32_armv8(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    uInt len;
+{
+    register z_crc_t c;
+    uint64_t word;
+
+    c = (z_crc_t)crc;
+    c = ~c;
+    while (len && ((ptrdiff_t)buf & 7)) {
+        c = __crc32b(c, *buf++);
+        len--;
+    }
+    while (len >= 8) {
+        memcpy(&word, buf, 8);
+        c = __crc32d(c, word);
+        buf += 8;
+        len -= 8;
+    }
+    while (len) {
+        c = __crc32b(c, *buf++);
+        len--;
+    }
+    c = ~c;
+    return (unsigned long)c;
+}
+#endif /* CRC32_ARMV8 */
+
 /* ========================================================================= */
 unsigned long ZEXPORT crc32(crc, buf, len)
     unsigned long crc;
@@ -214,6 +254,10 @@ unsigned long ZEXPORT crc32(crc, buf, len)
         make_crc_table();
 #endif /* DYNAMIC_CRC_TABLE */
 
+#ifdef CRC32_ARMV8
+    return crc32_armv8(crc, buf, len);
+#endif /* CRC32_ARMV8 */
+
 #ifdef BYFOUR
     if (sizeof(void *) == sizeof(ptrdiff_t)) {
         z_crc_t endian;
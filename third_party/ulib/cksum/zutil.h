@@ -12,9 +12,12 @@ typedef uint8_t Byte;
 typedef Byte Bytef;
 typedef off_t z_off_t;
 typedef int64_t z_off64_t;
-typedef unsigned long z_crc_t;
 
-//#define Z_U4 uint32_t
+#define Z_U4 uint32_t
+typedef Z_U4 z_crc_t;
+
+#define ZSWAP32(q) ((((q) >> 24) & 0xff) + (((q) >> 8) & 0xff00) + \
+                    (((q) & 0xff00) << 8) + (((q) & 0xff) << 24))
 
 
 #define Z_NULL NULL
@@ -26,8 +26,13 @@ static void _HASH_update(clHASH_CTX* ctx, const void* data, int len) {
 
   ctx->count += len;
 
-  while (len--) {
-    ctx->buf[i++] = *p++;
+  while (len > 0) {
+    int n = 64 - i;
+    if (n > len) n = len;
+    memcpy(&ctx->buf[i], p, n);
+    p += n;
+    i += n;
+    len -= n;
     if (i == 64) {
       ctx->f->_transform(ctx);
       i = 0;
@@ -108,8 +113,7 @@ int clEqual(const uint8_t* a, int a_len, const uint8_t* b, int b_len) {
 
 // SHA256 code section ==================================================
 
-static void _SHA256_transform(clHASH_CTX* ctx) {
-  static const uint32_t _SHA256_K[64] = {
+static const uint32_t _SHA256_K[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
     0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
     0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
@@ -127,6 +131,7 @@ static void _SHA256_transform(clHASH_CTX* ctx) {
     0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
     0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
 
+static void _SHA256_transform(clHASH_CTX* ctx) {
 #define _ROR(value, bits) (((value) >> (bits)) | ((value) << (32 - (bits))))
 #define _SHR(value, bits) ((value) >> (bits))
 
@@ -189,6 +194,204 @@ static void _SHA256_transform(clHASH_CTX* ctx) {
 #undef _ROR
 }
 
+// Hardware SHA-256 block transforms. The kernel is built without vector
+// registers (-mno-sse / -mgeneral-regs-only), so these are userspace
+// only; the kernel always runs the portable transform above.
+#if !defined(_KERNEL) && defined(__x86_64__)
+
+// x86 SHA extensions; selected at runtime via CPUID.
+#define _SHA256_SHANI 1
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+static int _SHA256_shani_supported(void) {
+  static int supported = -1;
+  if (supported < 0) {
+    if (__get_cpuid_max(0, NULL) >= 7) {
+      unsigned int eax, ebx, ecx, edx;
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      supported = (ebx >> 29) & 1;  // CPUID.7.0:EBX.SHA
+    } else {
+      supported = 0;
+    }
+  }
+  return supported;
+}
+
+__attribute__((target("sha,sse4.1")))
+static void _SHA256_transform_shani(clHASH_CTX* ctx) {
+  const __m128i kShuffle =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  const __m128i* k = (const __m128i*)_SHA256_K;
+  const __m128i* p = (const __m128i*)ctx->buf;
+  __m128i state0, state1, abef_save, cdgh_save;
+  __m128i msg, tmp, msg0, msg1, msg2, msg3;
+
+  // The SHA instructions want the state as ABEF/CDGH vectors.
+  tmp = _mm_loadu_si128((const __m128i*)&ctx->state[0]);    // DCBA
+  state1 = _mm_loadu_si128((const __m128i*)&ctx->state[4]); // HGFE
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);                       // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1B);                 // EFGH
+  state0 = _mm_alignr_epi8(tmp, state1, 8);                 // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);              // CDGH
+
+  abef_save = state0;
+  cdgh_save = state1;
+
+  // Rounds 0-3
+  msg0 = _mm_shuffle_epi8(_mm_loadu_si128(p + 0), kShuffle);
+  msg = _mm_add_epi32(msg0, _mm_loadu_si128(k + 0));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+  // Rounds 4-7
+  msg1 = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), kShuffle);
+  msg = _mm_add_epi32(msg1, _mm_loadu_si128(k + 1));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+  msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+  // Rounds 8-11
+  msg2 = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), kShuffle);
+  msg = _mm_add_epi32(msg2, _mm_loadu_si128(k + 2));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+  msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+  // Rounds 12-15
+  msg3 = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), kShuffle);
+  msg = _mm_add_epi32(msg3, _mm_loadu_si128(k + 3));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  tmp = _mm_alignr_epi8(msg3, msg2, 4);
+  msg0 = _mm_add_epi32(msg0, tmp);
+  msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+  msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+  // Rounds 16-51: four-round groups with message schedule in flight.
+  for (int i = 4; i < 13; i++) {
+    msg = _mm_add_epi32(msg0, _mm_loadu_si128(k + i));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg0, msg3, 4);
+    msg1 = _mm_add_epi32(msg1, tmp);
+    msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+    msg = _mm_shuffle_epi32(msg, 0x0E);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+    tmp = msg0;
+    msg0 = msg1;
+    msg1 = msg2;
+    msg2 = msg3;
+    msg3 = tmp;
+  }
+
+  // Rounds 52-55
+  msg = _mm_add_epi32(msg0, _mm_loadu_si128(k + 13));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  tmp = _mm_alignr_epi8(msg0, msg3, 4);
+  msg1 = _mm_add_epi32(msg1, tmp);
+  msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+  // Rounds 56-59
+  msg = _mm_add_epi32(msg1, _mm_loadu_si128(k + 14));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  tmp = _mm_alignr_epi8(msg1, msg0, 4);
+  msg2 = _mm_add_epi32(msg2, tmp);
+  msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+  // Rounds 60-63
+  msg = _mm_add_epi32(msg2, _mm_loadu_si128(k + 15));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+  state0 = _mm_add_epi32(state0, abef_save);
+  state1 = _mm_add_epi32(state1, cdgh_save);
+
+  // Back to the linear A..H layout.
+  tmp = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);    // HGFE
+
+  _mm_storeu_si128((__m128i*)&ctx->state[0], state0);
+  _mm_storeu_si128((__m128i*)&ctx->state[4], state1);
+}
+
+#elif !defined(_KERNEL) && defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+
+// ARMv8 cryptography extensions. There is no way to probe for them from
+// userspace here, so like the crc32 instructions in ulib/cksum they are
+// used when the target build enables them.
+#define _SHA256_ARMV8 1
+
+#include <arm_neon.h>
+
+static void _SHA256_transform_armv8(clHASH_CTX* ctx) {
+  uint32x4_t state0, state1, abef_save, cdgh_save;
+  uint32x4_t msg0, msg1, msg2, msg3;
+  uint32x4_t tmp0, tmp1, tmp2;
+
+  state0 = vld1q_u32(&ctx->state[0]);
+  state1 = vld1q_u32(&ctx->state[4]);
+  abef_save = state0;
+  cdgh_save = state1;
+
+  msg0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(ctx->buf + 0)));
+  msg1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(ctx->buf + 16)));
+  msg2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(ctx->buf + 32)));
+  msg3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(ctx->buf + 48)));
+
+  tmp0 = vaddq_u32(msg0, vld1q_u32(&_SHA256_K[0]));
+
+  // Rounds 0-47: schedule the next message quad while hashing.
+  for (int i = 0; i < 12; i++) {
+    tmp1 = vaddq_u32(msg1, vld1q_u32(&_SHA256_K[(i + 1) * 4]));
+    tmp2 = state0;
+    msg0 = vsha256su0q_u32(msg0, msg1);
+    state0 = vsha256hq_u32(state0, state1, tmp0);
+    state1 = vsha256h2q_u32(tmp2, state1, tmp0);
+    msg0 = vsha256su1q_u32(msg0, msg2, msg3);
+
+    tmp0 = tmp1;
+    tmp2 = msg0;
+    msg0 = msg1;
+    msg1 = msg2;
+    msg2 = msg3;
+    msg3 = tmp2;
+  }
+
+  // Rounds 48-63: no more scheduling needed.
+  for (int i = 12; i < 16; i++) {
+    tmp2 = state0;
+    state0 = vsha256hq_u32(state0, state1, tmp0);
+    state1 = vsha256h2q_u32(tmp2, state1, tmp0);
+    if (i < 15) {
+      tmp0 = vaddq_u32(msg1, vld1q_u32(&_SHA256_K[(i + 1) * 4]));
+      msg1 = msg2;
+      msg2 = msg3;
+    }
+  }
+
+  state0 = vaddq_u32(state0, abef_save);
+  state1 = vaddq_u32(state1, cdgh_save);
+
+  vst1q_u32(&ctx->state[0], state0);
+  vst1q_u32(&ctx->state[4], state1);
+}
+
+#endif  // !_KERNEL && architecture selection
+
 const uint8_t* clSHA256(const void* data, int len, uint8_t* digest) {
   clSHA256_CTX ctx;
   clSHA256_init(&ctx);
@@ -216,8 +419,34 @@ static const clHASH_vtab _SHA256_vtab = {
   kExpectedPadRsa2kSha256
 };
 
+#if defined(_SHA256_SHANI)
+static const clHASH_vtab _SHA256_vtab_shani = {
+  clSHA256_init,
+  _HASH_update,
+  _HASH_final,
+  _SHA256_transform_shani,
+  clSHA256_DIGEST_SIZE,
+  kExpectedPadRsa2kSha256
+};
+#elif defined(_SHA256_ARMV8)
+static const clHASH_vtab _SHA256_vtab_armv8 = {
+  clSHA256_init,
+  _HASH_update,
+  _HASH_final,
+  _SHA256_transform_armv8,
+  clSHA256_DIGEST_SIZE,
+  kExpectedPadRsa2kSha256
+};
+#endif
+
 void clSHA256_init(clSHA256_CTX* ctx) {
+#if defined(_SHA256_SHANI)
+  ctx->f = _SHA256_shani_supported() ? &_SHA256_vtab_shani : &_SHA256_vtab;
+#elif defined(_SHA256_ARMV8)
+  ctx->f = &_SHA256_vtab_armv8;
+#else
   ctx->f = &_SHA256_vtab;
+#endif
   ctx->state[0] = 0x6a09e667;
   ctx->state[1] = 0xbb67ae85;
   ctx->state[2] = 0x3c6ef372;
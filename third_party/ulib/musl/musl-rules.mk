@@ -682,6 +682,7 @@ LOCAL_SRCS := \
     $(LOCAL_DIR)/src/stat/mkfifoat.c \
     $(LOCAL_DIR)/src/stat/mknodat.c \
     $(LOCAL_DIR)/src/stat/statvfs.c \
+    $(LOCAL_DIR)/src/stdio/__adaptbuf.c \
     $(LOCAL_DIR)/src/stdio/__fclose_ca.c \
     $(LOCAL_DIR)/src/stdio/__fdopen.c \
     $(LOCAL_DIR)/src/stdio/__fmodeflags.c \
@@ -1091,8 +1092,13 @@ endif
 # Include src/string sources
 include $(LOCAL_DIR)/src/string/rules.mk
 
-# Include jemalloc for our malloc implementation
-include $(LOCAL_DIR)/../jemalloc/rules.mk
+# Include jemalloc for our malloc implementation.  Its arena count
+# scales with the cpu count (via sysconf(_SC_NPROCESSORS_ONLN)), so
+# multithreaded allocation doesn't serialize on a single lock.  Builds
+# may point MUSL_MALLOC_RULES at another allocator's rules.mk to swap
+# the implementation out.
+MUSL_MALLOC_RULES ?= $(LOCAL_DIR)/../jemalloc/rules.mk
+include $(MUSL_MALLOC_RULES)
 
 
 # shared library (which is also the dynamic linker)
@@ -19,6 +19,10 @@
 #define F_ERR 32
 #define F_SVB 64
 #define F_APP 128
+#define F_ABUF 256
+
+/* Buffer size adopted by __adaptbuf for non-terminal output streams. */
+#define ABUFSIZ (1 << 16)
 
 struct _IO_FILE {
     unsigned flags;
@@ -60,6 +64,7 @@ size_t __string_read(FILE*, unsigned char*, size_t) ATTR_LIBC_VISIBILITY;
 
 int __toread(FILE*) ATTR_LIBC_VISIBILITY;
 int __towrite(FILE*) ATTR_LIBC_VISIBILITY;
+void __adaptbuf(FILE*) ATTR_LIBC_VISIBILITY;
 
 mx_status_t _mmap_file(size_t offset, size_t len, uint32_t mx_flags, int flags, int fd,
                        off_t fd_off, uintptr_t* out);
@@ -0,0 +1,23 @@
+#include "stdio_impl.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Upgrade a stream from the small built-in buffer to a larger heap
+ * buffer the first time it is activated for buffered writes. Every
+ * flush is a full remote-io round trip, so batching more output per
+ * write() directly cuts wall time for log-heavy tools. Terminals keep
+ * the small buffer (they are line buffered anyway), and any buffer
+ * configured via setvbuf takes precedence. */
+void __adaptbuf(FILE* f) {
+    unsigned char* buf;
+
+    if (f->flags & (F_SVB | F_ABUF))
+        return;
+    if (f->buf_size != BUFSIZ || f->fd < 0 || isatty(f->fd))
+        return;
+    if (!(buf = malloc(ABUFSIZ + UNGET)))
+        return;
+    f->buf = buf + UNGET;
+    f->buf_size = ABUFSIZ;
+    f->flags |= F_ABUF;
+}
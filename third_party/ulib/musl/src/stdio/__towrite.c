@@ -9,6 +9,9 @@ int __towrite(FILE* f) {
     /* Clear read buffer (easier than summoning nasal demons) */
     f->rpos = f->rend = 0;
 
+    /* Grow the buffer for non-terminal streams before first use. */
+    __adaptbuf(f);
+
     /* Activate write through the buffer. */
     f->wpos = f->wbase = f->buf;
     f->wend = f->buf + f->buf_size;
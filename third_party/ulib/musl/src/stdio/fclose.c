@@ -23,6 +23,8 @@ int fclose(FILE* f) {
 
     if (f->getln_buf)
         free(f->getln_buf);
+    if (f->flags & F_ABUF)
+        free(f->buf - UNGET);
     if (!perm)
         free(f);
     else
@@ -69,10 +69,10 @@ LOCAL_SRCS += \
 
 ifeq ($(ARCH),arm64)
 LOCAL_SRCS += \
-    $(GET_LOCAL_DIR)/memcpy.c \
+    $(GET_LOCAL_DIR)/aarch64/memcpy.S \
+    $(GET_LOCAL_DIR)/aarch64/memset.S \
     $(GET_LOCAL_DIR)/memmove.c \
     $(GET_LOCAL_DIR)/mempcpy.c \
-    $(GET_LOCAL_DIR)/memset.c \
 
 else ifeq ($(SUBARCH),x86-64)
 LOCAL_SRCS += \